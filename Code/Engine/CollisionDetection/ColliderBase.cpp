@@ -1,6 +1,7 @@
 ﻿#include "ColliderBase.h"
 #include <cmath>
 #include <cassert>
+#include <cfloat>
 #include "OBBCollider.h"
 #include "RigidBody.h"
 
@@ -8,7 +9,7 @@ namespace EAE_Engine
 {
 	namespace Collider
 	{
-		Collider::Collider(): _pTransform(nullptr), _isTrigger(false)
+		Collider::Collider(): _pTransform(nullptr), _isTrigger(false), _proxyId(Core::DynamicAABBTree::s_invalid)
 		{
 			_hashtype = HashedString("Collider");
 		}
@@ -56,6 +57,8 @@ namespace EAE_Engine
 				SAFE_DELETE(pCollider);
 			}
 			_colliderList.clear();
+			_broadPhase.Clear();
+			_colliderTree.Clear();
 		}
 
 		Collider* ColliderManager::AddToColliderList(Collider* pCollider)
@@ -65,17 +68,21 @@ namespace EAE_Engine
 				return nullptr;
 			}
 			_colliderList.push_back(pCollider);
+			_broadPhase.Add(pCollider);
+			pCollider->_proxyId = _colliderTree.CreateProxy(pCollider->GetSweptAABB(0.0f), pCollider);
 			return pCollider;
 		}
 
 
 		void ColliderManager::Update()
 		{
+			float fElpasedTime = Time::GetSecondsElapsedThisFrame();
+			//Keep the tree up to date, the proxies only move when their bounds leave the fat AABBs.
 			for (std::vector<Collider*>::iterator it = _colliderList.begin(); it != _colliderList.end(); ++it)
 			{
+				_colliderTree.MoveProxy((*it)->_proxyId, (*it)->GetSweptAABB(fElpasedTime));
 			}
 			/*
-			float fElpasedTime = Time::GetSecondsElapsedThisFrame();
 			//Iterate advance all of the Colliders.
 			IterateAdvanceColliders(&_colliderList, fElpasedTime);
 			*/
@@ -84,12 +91,15 @@ namespace EAE_Engine
 		float ColliderManager::IterateAdvanceColliders(std::vector<Collider*>* pTempColliderList, float fElpasedTime)
 		{
 			assert(fElpasedTime > 0.0f);
+			//The swept AABBs of the whole step also bound every part of the step,
+			//so the pairs found here are enough for all of the iterations below.
+			_broadPhase.Update(fElpasedTime);
 			size_t iterate_time = 100;
 			while (fElpasedTime > 0.0f && --iterate_time != 0)
 			{
 				//Get the first Collision time.
 				CollisionInfo firstCollisionInfo;
-				bool collided = GetFirstCollisionInfo(pTempColliderList, fElpasedTime, firstCollisionInfo);
+				bool collided = GetFirstCollisionInfo(_broadPhase.GetPairs(), fElpasedTime, firstCollisionInfo);
 				if (!collided)
 				{
 					// if there is no collision anymore, we should move to the next part after collision detection.
@@ -101,7 +111,8 @@ namespace EAE_Engine
 				if (firstCollisionTime < 0.0f)
 				{
 					// Should use minimumTranslationVector to remove them.
-					// Now I don't care the penetration at all.
+					// Now I don't care the penetration at all,
+					// the RigidBodys with a box have their penetration solved by the ContactSolver instead.
 					break;
 				}
 				else
@@ -124,33 +135,22 @@ namespace EAE_Engine
 			return fElpasedTime;
 		}
 
-		bool ColliderManager::GetFirstCollisionInfo(std::vector<Collider*>* pColliderList, float fElpasedTime, CollisionInfo& o_collisInfo)
+		bool ColliderManager::GetFirstCollisionInfo(const std::vector<ColliderPair>& i_pairs, float fElpasedTime, CollisionInfo& o_collisInfo)
 		{
-			if (!pColliderList)
-			{
-				return false;
-			}
 			o_collisInfo = { nullptr, nullptr, FLT_MAX, Math::Vector3::Zero };
 			bool collision_result = false;
-			for (std::vector<Collider*>::iterator itOut = pColliderList->begin(); itOut != pColliderList->end(); ++itOut)
+			//Only the pairs from the broad phase can collide in this step.
+			for (std::vector<ColliderPair>::const_iterator it = i_pairs.begin(); it != i_pairs.end(); ++it)
 			{
-				for (std::vector<Collider*>::iterator it = itOut; it != pColliderList->end(); ++it)
+				float o_collisionTime = FLT_MAX;
+				Math::Vector3 o_collisionAxis = Math::Vector3::Zero;
+				bool collided = it->_pColliderA->DetectCollision(it->_pColliderB, fElpasedTime, o_collisionTime, o_collisionAxis);
+				//keep the pair which collides first, not the last one.
+				if (collided && o_collisionTime < o_collisInfo._firstCollisionTime)
 				{
-					if (*it == *itOut)
-					{
-						continue;
-					}
-					float o_collisionTime = FLT_MAX;
-					Math::Vector3 o_collisionAxis = Math::Vector3::Zero;
-					bool collided = (*itOut)->DetectCollision(*it, fElpasedTime, o_collisionTime, o_collisionAxis);
-					if (collided)
-					{
-						assert(o_collisionTime >= 0.0f);//When Colliding, the collision should be larger than 0.0f.
-						float firstCollisionTime = fminf(o_collisInfo._firstCollisionTime, o_collisionTime);
-						o_collisInfo = { *itOut, *it, firstCollisionTime, o_collisionAxis };
-						collision_result = true;
-					}
-					
+					assert(o_collisionTime >= 0.0f);//When Colliding, the collision should be larger than 0.0f.
+					o_collisInfo = { it->_pColliderA, it->_pColliderB, o_collisionTime, o_collisionAxis };
+					collision_result = true;
 				}
 			}
 			//	PROFILE_PRINT_RESULTS();
@@ -194,6 +194,8 @@ namespace EAE_Engine
 				{
 					Collider* pCollider = (*it);
 					it = _colliderList.erase(it);
+					_broadPhase.Remove(pCollider);
+					_colliderTree.DestroyProxy(pCollider->_proxyId);
 					SAFE_DELETE(pCollider);
 					break;
 				}
@@ -210,6 +212,8 @@ namespace EAE_Engine
 				if (pCollider && pCollider->GetTransform() == pTrans)
 				{
 					it = _colliderList.erase(it++);
+					_broadPhase.Remove(pCollider);
+					_colliderTree.DestroyProxy(pCollider->_proxyId);
 					SAFE_DELETE(pCollider);
 				}
 				else 
@@ -219,6 +223,33 @@ namespace EAE_Engine
 			}
 		}
 
+		void ColliderManager::QueryColliders(const Math::PackedAABB& i_aabb, std::vector<Collider*>& o_colliders) const
+		{
+			o_colliders.clear();
+			_colliderTree.QueryAABB(i_aabb, [this, &o_colliders](uint32_t proxyId)
+			{
+				o_colliders.push_back(reinterpret_cast<Collider*>(_colliderTree.GetUserData(proxyId)));
+				return true;
+			});
+		}
+
+		void ColliderManager::PrepareForStep()
+		{
+			for (std::vector<Collider*>::iterator it = _colliderList.begin(); it != _colliderList.end(); ++it)
+				(*it)->PrepareForStep();
+		}
+
+		bool ColliderManager::RayCast(const Math::Vector3& i_start, const Math::Vector3& i_end, std::vector<Collider*>& o_colliders) const
+		{
+			o_colliders.clear();
+			_colliderTree.RayCast(i_start, i_end, [this, &o_colliders](uint32_t proxyId, float maxFraction)
+			{
+				o_colliders.push_back(reinterpret_cast<Collider*>(_colliderTree.GetUserData(proxyId)));
+				return maxFraction;
+			});
+			return o_colliders.size() > 0;
+		}
+
 		void ColliderManager::InstallCollsionFeedbackByType(HashedString type, bool OnCollideCallback(Collider* pSelf, CollisionInfo& collisionInfo))
 		{
 			 for (std::vector<Collider*>::iterator it = _colliderList.begin(); it != _colliderList.end(); ++it)
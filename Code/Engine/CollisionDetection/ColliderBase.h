@@ -5,6 +5,9 @@
 #include "Engine/Containers/LinkedList.h"
 #include "Engine/Math/Vector.h"
 #include "Engine/Time/Time.h"
+#include "Engine/SpatialPartition/DynamicAABBTree.h"
+#include "SweepAndPrune.h"
+#include "ContactManifold.h"
 #include <vector>
 
 namespace EAE_Engine
@@ -50,11 +53,21 @@ namespace EAE_Engine
 				Math::Vector3& o_collisionPoint, Math::Vector3& o_collisionNormal) = 0;
 			//only when the return is true, the collision happens, the o_collisionTime and o_collisionAxis have their real means.
 			virtual bool DetectCollision(Collider* i_pOther, float fElpasedTime, float& o_collisionTime, Math::Vector3& o_collisionAxis) = 0;
+			//the world AABB which bounds the Collider during the next fElpasedTime seconds, used by the broad phase.
+			virtual Math::PackedAABB GetSweptAABB(float fElpasedTime) = 0;
+			//append the contact manifolds of the box with this Collider to o_manifolds, they point from the box to this Collider.
+			//used by the ContactSolver, by default the Collider doesn't stop the boxes.
+			virtual void CollideOBB(const Math::OBB&, std::vector<Collision::ContactManifold>&) {}
+			//called on the calling thread before the RigidBodys advance in parallel,
+			//TestCollision runs on the workers after it, so it must not write the Collider.
+			virtual void PrepareForStep() {}
 			inline bool IsSameType(const HashedString& i_type);
 			inline void AdvanceCollider(float fElpasedTime);
 			inline void RegistOnCollideCallback(bool OnCollideCallback(Collider* pSelf, CollisionInfo& collisionInfo));
 			virtual void IterateCallbackLsit(CollisionInfo collisionInfo);
 			inline bool IsTrigger(){ return _isTrigger; }
+			//the proxy of this Collider in the DynamicAABBTree of the ColliderManager.
+			inline uint32_t GetProxyId() const { return _proxyId; }
 		protected:
 			HashedString _hashtype;
 			Container::LinkedList< OnCollideCallback*> _OnCollidecallbackList;
@@ -62,6 +75,9 @@ namespace EAE_Engine
 			//When the Collider is a Trigger, that means we don't care the collision time or some other info.
 			//So sometimes we can use faster algorithms on the Collider.
 			bool _isTrigger;
+		private:
+			uint32_t _proxyId;
+			friend class ColliderManager;
 		};
 
 		/*The Manager of Colliders*/
@@ -83,15 +99,26 @@ namespace EAE_Engine
 			void Remove(Common::ITransform* pTrans);
 			void InstallCollsionFeedbackByType(HashedString type, bool OnCollideCallback(Collider* pSelf, CollisionInfo& collisionInfo));
 			std::vector<Collider*>& GetColliderList() { return _colliderList; }
+			const SweepAndPrune& GetBroadPhase() const { return _broadPhase; }
+			//the Colliders whose bounds overlap i_aabb.
+			void QueryColliders(const Math::PackedAABB& i_aabb, std::vector<Collider*>& o_colliders) const;
+			//PrepareForStep of all of the Colliders.
+			void PrepareForStep();
+			//the Colliders whose bounds are hit by the segment from i_start to i_end, in no particular order.
+			bool RayCast(const Math::Vector3& i_start, const Math::Vector3& i_end, std::vector<Collider*>& o_colliders) const;
 
 		private:
-			bool GetFirstCollisionInfo(std::vector<Collider*>* pColliderList, float fElpasedTime, CollisionInfo& o_collisInfo);
+			bool GetFirstCollisionInfo(const std::vector<ColliderPair>& i_pairs, float fElpasedTime, CollisionInfo& o_collisInfo);
 			float AdvanceToFirstCollisionTime(std::vector<Collider*>* pColliderList, float fAdvanceTime);
 			void DealWithAWhenCollideB(CollisionInfo collisionInfo);
 			float IterateAdvanceColliders(std::vector<Collider*>* pColliderList, float fElpasedTime);
 
 		private:
 			std::vector<Collider*> _colliderList;
+			//the candidate pairs of IterateAdvanceColliders, sorted again from the order of the last step.
+			SweepAndPrune _broadPhase;
+			//the bounds of all of the Colliders for the spatial queries.
+			Core::DynamicAABBTree _colliderTree;
 			size_t _numOfColliders;
 			static ColliderManager* s_pInternalInstance;
 		public:
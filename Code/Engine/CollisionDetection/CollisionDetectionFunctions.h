@@ -37,14 +37,14 @@ namespace EAE_Engine
 			m = m - c; // Segment midpoint relative to box center
 
 			// Try world coordinate axes as separating axes
-			float adx = std::fabsf(d._x);
-			if (std::fabsf(m._x) > e._x + adx) 
+			float adx = std::fabs(d._x);
+			if (std::fabs(m._x) > e._x + adx) 
 				return false;
-			float ady = std::fabsf(d._y);
-			if (std::fabsf(m._y) > e._y + ady) 
+			float ady = std::fabs(d._y);
+			if (std::fabs(m._y) > e._y + ady) 
 				return false;
-			float adz = std::fabsf(d._z);
-			if (std::fabsf(m._z) > e._z + adz) 
+			float adz = std::fabs(d._z);
+			if (std::fabs(m._z) > e._z + adz) 
 				return false;
 
 			// Add in an epsilon term to counteract arithmetic errors when segment is
@@ -54,11 +54,11 @@ namespace EAE_Engine
 			adz += EPSILON;
 
 			// Try cross products of segment direction vector with coordinate axes
-			if (std::fabsf(m._y * d._z - m._z * d._y) > e._y * adz + e._z * ady) 
+			if (std::fabs(m._y * d._z - m._z * d._y) > e._y * adz + e._z * ady) 
 				return false;
-			if (std::fabsf(m._z * d._x - m._x * d._z) > e._x * adz + e._z * adx) 
+			if (std::fabs(m._z * d._x - m._x * d._z) > e._x * adz + e._z * adx) 
 				return false;
-			if (std::fabsf(m._x * d._y - m._y * d._x) > e._x * ady + e._y * adx) 
+			if (std::fabs(m._x * d._y - m._y * d._x) > e._x * ady + e._y * adx) 
 				return false;
 
 			// No separating axis found; sement must be overlapping AABB
@@ -107,6 +107,147 @@ namespace EAE_Engine
 			return 1;
 		}
 		
+		// Returns the point on the triangle abc closest to p
+		inline Math::Vector3 ClosestPtPointTriangle(const Math::Vector3& p, const Math::Vector3& a, const Math::Vector3& b, const Math::Vector3& c)
+		{
+			// Check if P in vertex region outside A
+			Math::Vector3 ab = b - a;
+			Math::Vector3 ac = c - a;
+			Math::Vector3 ap = p - a;
+			float d1 = Math::Vector3::Dot(ab, ap);
+			float d2 = Math::Vector3::Dot(ac, ap);
+			if (d1 <= 0.0f && d2 <= 0.0f) return a; // barycentric coordinates (1,0,0)
+			// Check if P in vertex region outside B
+			Math::Vector3 bp = p - b;
+			float d3 = Math::Vector3::Dot(ab, bp);
+			float d4 = Math::Vector3::Dot(ac, bp);
+			if (d3 >= 0.0f && d4 <= d3) return b; // barycentric coordinates (0,1,0)
+			// Check if P in edge region of AB, if so return projection of P onto AB
+			float vc = d1 * d4 - d3 * d2;
+			if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+			{
+				float v = d1 / (d1 - d3);
+				return a + ab * v; // barycentric coordinates (1-v,v,0)
+			}
+			// Check if P in vertex region outside C
+			Math::Vector3 cp = p - c;
+			float d5 = Math::Vector3::Dot(ab, cp);
+			float d6 = Math::Vector3::Dot(ac, cp);
+			if (d6 >= 0.0f && d5 <= d6) return c; // barycentric coordinates (0,0,1)
+			// Check if P in edge region of AC, if so return projection of P onto AC
+			float vb = d5 * d2 - d1 * d6;
+			if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+			{
+				float w = d2 / (d2 - d6);
+				return a + ac * w; // barycentric coordinates (1-w,0,w)
+			}
+			// Check if P in edge region of BC, if so return projection of P onto BC
+			float va = d3 * d6 - d5 * d4;
+			if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+			{
+				float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+				return b + (c - b) * w; // barycentric coordinates (0,1-w,w)
+			}
+			// P inside face region. Compute Q through its barycentric coordinates (u,v,w)
+			float denom = 1.0f / (va + vb + vc);
+			float v = vb * denom;
+			float w = vc * denom;
+			return a + ab * v + ac * w;
+		}
+
+		// Returns the point on (or in) the OBB b closest to p
+		inline Math::Vector3 ClosestPtPointOBB(const Math::Vector3& p, const Math::OBB& b)
+		{
+			Math::Vector3 d = p - b._pos;
+			// Start result at center of box; make steps from there
+			Math::Vector3 q = b._pos;
+			// For each OBB axis...
+			for (int i = 0; i < 3; ++i)
+			{
+				// ...project d onto that axis to get the distance
+				// along the axis of d from the box center
+				float dist = Math::Vector3::Dot(d, b._axis[i]);
+				// If distance farther than the box extents, clamp to the box
+				if (dist > b._extent._u[i]) dist = b._extent._u[i];
+				if (dist < -b._extent._u[i]) dist = -b._extent._u[i];
+				// Step that distance along the axis to get world coordinate
+				q += b._axis[i] * dist;
+			}
+			return q;
+		}
+
+		// The AABB with center c and extents e moves by d during t in [0, 1],
+		// returns whether it hits the triangle abc and if so, the first time t of contact
+		// and the separating axis n it comes across, pointing from the triangle to the box.
+		// Based on IntersectMovingAABBAABB, with the 13 separating axes of the AABB and the triangle.
+		inline bool IntersectMovingAABBTriangle(const Math::Vector3& c, const Math::Vector3& e, const Math::Vector3& d,
+			const Math::Vector3& a, const Math::Vector3& b, const Math::Vector3& cc, float &t, Math::Vector3& n)
+		{
+			const Math::Vector3 boxAxes[3] = { Math::Vector3(1.0f, 0.0f, 0.0f), Math::Vector3(0.0f, 1.0f, 0.0f), Math::Vector3(0.0f, 0.0f, 1.0f) };
+			const Math::Vector3 f[3] = { b - a, cc - b, a - cc };
+			Math::Vector3 axes[13];
+			axes[0] = boxAxes[0];
+			axes[1] = boxAxes[1];
+			axes[2] = boxAxes[2];
+			axes[3] = Math::Vector3::Cross(f[0], f[1]);
+			for (int i = 0; i < 3; ++i)
+				for (int j = 0; j < 3; ++j)
+					axes[4 + i * 3 + j] = Math::Vector3::Cross(boxAxes[i], f[j]);
+			// Initialize times of first and last contact
+			float tfirst = 0.0f;
+			float tlast = 1.0f;
+			n = Math::Vector3::Zero;
+			for (int i = 0; i < 13; ++i)
+			{
+				const Math::Vector3& axis = axes[i];
+				// Skip the degenerated axes from the parallel edges
+				if (axis.SqMagnitude() < EPSILON * EPSILON)
+					continue;
+				float p0 = Math::Vector3::Dot(a, axis);
+				float p1 = Math::Vector3::Dot(b, axis);
+				float p2 = Math::Vector3::Dot(cc, axis);
+				float triMin = std::fmin(p0, std::fmin(p1, p2));
+				float triMax = std::fmax(p0, std::fmax(p1, p2));
+				float r = e._x * std::fabs(axis._x) + e._y * std::fabs(axis._y) + e._z * std::fabs(axis._z);
+				float s = Math::Vector3::Dot(c, axis);
+				float v = Math::Vector3::Dot(d, axis);
+				// The box is on [s + v * t - r, s + v * t + r] along the axis
+				if (v == 0.0f)
+				{
+					// Not moving along the axis, so it never overlaps when it doesn't overlap now
+					if (s + r < triMin || s - r > triMax)
+						return false;
+					continue;
+				}
+				float tenter = (triMin - r - s) / v;
+				float texit = (triMax + r - s) / v;
+				if (tenter > texit)
+				{
+					float temp = tenter;
+					tenter = texit;
+					texit = temp;
+				}
+				// Determine the times of first and last contact, if any
+				if (tenter > tfirst)
+				{
+					tfirst = tenter;
+					n = v > 0.0f ? axis * -1.0f : axis;
+				}
+				if (texit < tlast)
+					tlast = texit;
+				// Exit with no intersection if the separation is larger than the movement
+				if (tfirst > tlast)
+					return false;
+			}
+			t = tfirst;
+			// Overlapping at the beginning, push it back along the movement
+			if (n.SqMagnitude() == 0.0f)
+				n = d * -1.0f;
+			if (n.SqMagnitude() > 0.0f)
+				n.Normalize();
+			return true;
+		}
+
 		// Test if AABB b intersects plane p
 		inline bool TestAABBPlane(Math::AABBV1 b, Math::Plane p)
 		{
@@ -114,10 +255,10 @@ namespace EAE_Engine
 			Math::Vector3 c = (b._max + b._min) * 0.5f; // Compute AABB center
 			Math::Vector3 e = b._max - c; // Compute positive extents
 			// Compute the projection interval radius of b onto L(t) = b.c + t * p.n
-			float r = e._u[0] * std::fabsf(p._normal._u[0]) + e._u[1] * std::fabsf(p._normal._u[1]) + e._u[2] * std::fabsf(p._normal._u[2]);
+			float r = e._u[0] * std::fabs(p._normal._u[0]) + e._u[1] * std::fabs(p._normal._u[1]) + e._u[2] * std::fabs(p._normal._u[2]);
 			// Compute distance of box center from plane
 			float s = Math::Vector3::Dot(p._normal, c) - p._d;			// Intersection occurs when distance s falls within [-r,+r] interval
-			return std::fabsf(s) <= r;
+			return std::fabs(s) <= r;
 		}
 
 		// Read Real-time collision detection P169
@@ -144,12 +285,12 @@ namespace EAE_Engine
 				for (int j = 0; j < 3; ++j)
 				{
 					Math::Vector3 projectionSATAxis = Math::Vector3::Cross(axis[i], edge[j]);
-					r = std::fabsf(Math::Vector3::Dot(axis[0], projectionSATAxis)) * e0 + std::fabsf(Math::Vector3::Dot(axis[1], projectionSATAxis)) * e1 + std::fabsf(Math::Vector3::Dot(axis[2], projectionSATAxis)) * e2;
+					r = std::fabs(Math::Vector3::Dot(axis[0], projectionSATAxis)) * e0 + std::fabs(Math::Vector3::Dot(axis[1], projectionSATAxis)) * e1 + std::fabs(Math::Vector3::Dot(axis[2], projectionSATAxis)) * e2;
 					p0 = Math::Vector3::Dot(v0, projectionSATAxis);
 					p1 = Math::Vector3::Dot(v1, projectionSATAxis);
 					p2 = Math::Vector3::Dot(v2, projectionSATAxis);
-					float max = std::fmaxf(p0, std::fmaxf(p1, p2));
-					float min = std::fminf(p0, std::fminf(p1, p2));
+					float max = std::fmax(p0, std::fmax(p1, p2));
+					float min = std::fmin(p0, std::fmin(p1, p2));
 					//If the projection intervals [?r, r] and min(p0, p1, p2), max(p0, p1, p2) are disjoint for the given axis, 
 					//the axis is a separating axis and the triangle and the AABB do not overlap.
 					if  (max < -r || min > r)
@@ -159,11 +300,11 @@ namespace EAE_Engine
 			// Test the three axes corresponding to the face normals of AABB b (category 1).
 			// Exit if...
 			// ... [-e0, e0] and [min(v0.x,v1.x,v2.x), max(v0.x,v1.x,v2.x)] do not overlap
-			if (std::fmaxf(v0._x, std::fmaxf(v1._x, v2._x)) < -e0 || std::fminf(v0._x, std::fminf(v1._x, v2._x)) > e0) return 0;
+			if (std::fmax(v0._x, std::fmax(v1._x, v2._x)) < -e0 || std::fmin(v0._x, std::fmin(v1._x, v2._x)) > e0) return 0;
 			// ... [-e1, e1] and [min(v0.y,v1.y,v2.y), max(v0.y,v1.y,v2.y)] do not overlap
-			if (std::fmaxf(v0._y, std::fmaxf(v1._y, v2._y)) < -e1 || std::fminf(v0._y, std::fminf(v1._y, v2._y)) > e1) return 0;
+			if (std::fmax(v0._y, std::fmax(v1._y, v2._y)) < -e1 || std::fmin(v0._y, std::fmin(v1._y, v2._y)) > e1) return 0;
 			// ... [-e2, e2] and [min(v0.z,v1.z,v2.z), max(v0.z,v1.z,v2.z)] do not overlap
-			if (std::fmaxf(v0._z, std::fmaxf(v1._z, v2._z)) < -e2 || std::fminf(v0._z, std::fminf(v1._z, v2._z)) > e2) return 0;
+			if (std::fmax(v0._z, std::fmax(v1._z, v2._z)) < -e2 || std::fmin(v0._z, std::fmin(v1._z, v2._z)) > e2) return 0;
 			// Test separating axis corresponding to triangle face normal (category 2)
 			Math::Plane p;
 			p._normal = Math::Vector3::Cross(edge[0], edge[1]);
@@ -0,0 +1,359 @@
+#include "ContactManifold.h"
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+namespace EAE_Engine
+{
+  namespace Collision
+  {
+    namespace
+    {
+      // the distance between the boxes along the normalized axis, negative when they overlap on it.
+      float SeparationOnAxis(const Math::OBB& i_boxA, const Math::OBB& i_boxB, const Math::Vector3& i_offset, const Math::Vector3& i_axis)
+      {
+        float radiusA = 0.0f;
+        float radiusB = 0.0f;
+        for (size_t k = 0; k < 3; ++k)
+        {
+          radiusA += i_boxA._extent._u[k] * std::fabs(Math::Vector3::Dot(i_boxA._axis[k], i_axis));
+          radiusB += i_boxB._extent._u[k] * std::fabs(Math::Vector3::Dot(i_boxB._axis[k], i_axis));
+        }
+        return std::fabs(Math::Vector3::Dot(i_offset, i_axis)) - radiusA - radiusB;
+      }
+
+      // Sutherland-Hodgman, keep the part of the polygon where Dot(p - i_origin, i_direction) <= i_offset.
+      uint32_t ClipPolygon(const Math::Vector3* i_pPolygon, uint32_t count, const Math::Vector3& i_origin,
+        const Math::Vector3& i_direction, float i_offset, Math::Vector3* o_pPolygon)
+      {
+        uint32_t outCount = 0;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+          const Math::Vector3& p = i_pPolygon[i];
+          const Math::Vector3& q = i_pPolygon[(i + 1) % count];
+          const float distanceP = Math::Vector3::Dot(p - i_origin, i_direction) - i_offset;
+          const float distanceQ = Math::Vector3::Dot(q - i_origin, i_direction) - i_offset;
+          if (distanceP <= 0.0f)
+            o_pPolygon[outCount++] = p;
+          if ((distanceP <= 0.0f) != (distanceQ <= 0.0f))
+            o_pPolygon[outCount++] = p + (q - p) * (distanceP / (distanceP - distanceQ));
+        }
+        return outCount;
+      }
+
+      // twice the signed area of the triangle abc seen from the normal.
+      inline float SignedArea(const Math::Vector3& a, const Math::Vector3& b, const Math::Vector3& c, const Math::Vector3& i_normal)
+      {
+        return Math::Vector3::Dot(Math::Vector3::Cross(b - a, c - a), i_normal);
+      }
+    }
+
+    bool CollideOBBOBB(const Math::OBB& i_boxA, const Math::OBB& i_boxB, ContactManifold& o_manifold)
+    {
+      const float epsilon = 1.0e-6f;
+      const Math::Vector3 offset = i_boxB._pos - i_boxA._pos;
+      float faceSeparationA = -FLT_MAX;
+      float faceSeparationB = -FLT_MAX;
+      float edgeSeparation = -FLT_MAX;
+      uint32_t faceA = 0, faceB = 0, edgeA = 0, edgeB = 0;
+      Math::Vector3 edgeAxis = Math::Vector3::Zero;
+      for (uint32_t i = 0; i < 3; ++i)
+      {
+        float separation = SeparationOnAxis(i_boxA, i_boxB, offset, i_boxA._axis[i]);
+        if (separation > s_contactMargin)
+          return false;
+        if (separation > faceSeparationA)
+        {
+          faceSeparationA = separation;
+          faceA = i;
+        }
+      }
+      for (uint32_t i = 0; i < 3; ++i)
+      {
+        float separation = SeparationOnAxis(i_boxA, i_boxB, offset, i_boxB._axis[i]);
+        if (separation > s_contactMargin)
+          return false;
+        if (separation > faceSeparationB)
+        {
+          faceSeparationB = separation;
+          faceB = i;
+        }
+      }
+      for (uint32_t i = 0; i < 3; ++i)
+      {
+        for (uint32_t j = 0; j < 3; ++j)
+        {
+          Math::Vector3 axis = Math::Vector3::Cross(i_boxA._axis[i], i_boxB._axis[j]);
+          float sqLength = axis.SqMagnitude();
+          // The edges are parallel, the face axes have covered this direction.
+          if (sqLength < epsilon)
+            continue;
+          axis = axis * (1.0f / std::sqrt(sqLength));
+          float separation = SeparationOnAxis(i_boxA, i_boxB, offset, axis);
+          if (separation > s_contactMargin)
+            return false;
+          if (separation > edgeSeparation)
+          {
+            edgeSeparation = separation;
+            edgeA = i;
+            edgeB = j;
+            edgeAxis = axis;
+          }
+        }
+      }
+      // Only switch to the other axis when it is clearly better,
+      // or a box resting on another one flips between the faces and its contacts can't be warm started.
+      const float relativeTolerance = 0.98f;
+      const float absoluteTolerance = 0.001f;
+      const bool referenceIsB = faceSeparationB > relativeTolerance * faceSeparationA + absoluteTolerance;
+      const float faceSeparation = referenceIsB ? faceSeparationB : faceSeparationA;
+      if (edgeSeparation > relativeTolerance * faceSeparation + absoluteTolerance)
+      {
+        Math::Vector3 normal = edgeAxis;
+        if (Math::Vector3::Dot(offset, normal) < 0.0f)
+          normal = normal * -1.0f;
+        // the edge of A farthest along the normal and the edge of B farthest against it.
+        Math::Vector3 pointA = i_boxA._pos;
+        Math::Vector3 pointB = i_boxB._pos;
+        for (uint32_t k = 0; k < 3; ++k)
+        {
+          if (k != edgeA)
+            pointA += i_boxA._axis[k] * (Math::Vector3::Dot(i_boxA._axis[k], normal) > 0.0f ? i_boxA._extent._u[k] : -i_boxA._extent._u[k]);
+          if (k != edgeB)
+            pointB += i_boxB._axis[k] * (Math::Vector3::Dot(i_boxB._axis[k], normal) > 0.0f ? -i_boxB._extent._u[k] : i_boxB._extent._u[k]);
+        }
+        // The closest points of the 2 edges, ClosestPtSegmentSegment with the unit directions.
+        const Math::Vector3& directionA = i_boxA._axis[edgeA];
+        const Math::Vector3& directionB = i_boxB._axis[edgeB];
+        const float extentA = i_boxA._extent._u[edgeA];
+        const float extentB = i_boxB._extent._u[edgeB];
+        const Math::Vector3 r = pointA - pointB;
+        const float b = Math::Vector3::Dot(directionA, directionB);
+        const float c = Math::Vector3::Dot(directionA, r);
+        const float f = Math::Vector3::Dot(directionB, r);
+        const float denom = 1.0f - b * b;
+        float s = denom > epsilon ? (b * f - c) / denom : 0.0f;
+        s = s < -extentA ? -extentA : (s > extentA ? extentA : s);
+        float t = b * s + f;
+        if (t < -extentB || t > extentB)
+        {
+          t = t < -extentB ? -extentB : extentB;
+          s = b * t - c;
+          s = s < -extentA ? -extentA : (s > extentA ? extentA : s);
+        }
+        o_manifold._normal = normal;
+        o_manifold._pointCount = 1;
+        o_manifold._points[0]._position = (pointA + directionA * s + pointB + directionB * t) * 0.5f;
+        o_manifold._points[0]._penetration = -edgeSeparation;
+        return true;
+      }
+
+      const Math::OBB& reference = referenceIsB ? i_boxB : i_boxA;
+      const Math::OBB& incident = referenceIsB ? i_boxA : i_boxB;
+      const uint32_t referenceAxis = referenceIsB ? faceB : faceA;
+      // the reference face is the face of the reference box facing the incident box.
+      Math::Vector3 referenceNormal = reference._axis[referenceAxis];
+      if (Math::Vector3::Dot(incident._pos - reference._pos, referenceNormal) < 0.0f)
+        referenceNormal = referenceNormal * -1.0f;
+      const Math::Vector3 referenceCenter = reference._pos + referenceNormal * reference._extent._u[referenceAxis];
+      // the incident face is the face of the incident box most against the reference normal.
+      uint32_t incidentAxis = 0;
+      float maxDot = -1.0f;
+      for (uint32_t k = 0; k < 3; ++k)
+      {
+        float dot = std::fabs(Math::Vector3::Dot(incident._axis[k], referenceNormal));
+        if (dot > maxDot)
+        {
+          maxDot = dot;
+          incidentAxis = k;
+        }
+      }
+      Math::Vector3 incidentNormal = incident._axis[incidentAxis];
+      if (Math::Vector3::Dot(incidentNormal, referenceNormal) > 0.0f)
+        incidentNormal = incidentNormal * -1.0f;
+      const Math::Vector3 incidentCenter = incident._pos + incidentNormal * incident._extent._u[incidentAxis];
+      const Math::Vector3 incidentU = incident._axis[(incidentAxis + 1) % 3] * incident._extent._u[(incidentAxis + 1) % 3];
+      const Math::Vector3 incidentV = incident._axis[(incidentAxis + 2) % 3] * incident._extent._u[(incidentAxis + 2) % 3];
+      // Each of the 4 clips adds one point at most.
+      Math::Vector3 polygon[8];
+      Math::Vector3 clipped[8];
+      polygon[0] = incidentCenter + incidentU + incidentV;
+      polygon[1] = incidentCenter - incidentU + incidentV;
+      polygon[2] = incidentCenter - incidentU - incidentV;
+      polygon[3] = incidentCenter + incidentU - incidentV;
+      uint32_t count = 4;
+      for (uint32_t side = 1; side < 3 && count > 0; ++side)
+      {
+        const Math::Vector3& direction = reference._axis[(referenceAxis + side) % 3];
+        const float extent = reference._extent._u[(referenceAxis + side) % 3];
+        count = ClipPolygon(polygon, count, referenceCenter, direction, extent, clipped);
+        count = ClipPolygon(clipped, count, referenceCenter, direction * -1.0f, extent, polygon);
+      }
+      ContactPoint points[8];
+      uint32_t pointCount = 0;
+      for (uint32_t i = 0; i < count; ++i)
+      {
+        float separation = Math::Vector3::Dot(polygon[i] - referenceCenter, referenceNormal);
+        if (separation > s_contactMargin)
+          continue;
+        points[pointCount]._position = polygon[i] - referenceNormal * (0.5f * separation);
+        points[pointCount]._penetration = -separation;
+        ++pointCount;
+      }
+      if (pointCount == 0)
+        return false;
+      ReduceContactPoints(points, pointCount, referenceIsB ? referenceNormal * -1.0f : referenceNormal, o_manifold);
+      return true;
+    }
+
+    uint32_t CollideOBBTriangle(const Math::OBB& i_box, const Math::Vector3& a, const Math::Vector3& b, const Math::Vector3& c,
+      ContactPoint* o_pPoints, Math::Vector3& o_normal)
+    {
+      Math::Vector3 normal = Math::Vector3::Cross(b - a, c - a);
+      const float sqLength = normal.SqMagnitude();
+      if (sqLength < 1.0e-12f)
+        return 0;
+      normal = normal * (1.0f / std::sqrt(sqLength));
+      // The box behind the triangle is left to the triangles facing it.
+      const float height = Math::Vector3::Dot(i_box._pos - a, normal);
+      if (height <= 0.0f)
+        return 0;
+      float radius = 0.0f;
+      for (size_t k = 0; k < 3; ++k)
+        radius += i_box._extent._u[k] * std::fabs(Math::Vector3::Dot(i_box._axis[k], normal));
+      if (height - radius > s_contactMargin)
+        return 0;
+      uint32_t count = 0;
+      for (uint32_t corner = 0; corner < 8; ++corner)
+      {
+        Math::Vector3 point = i_box._pos;
+        for (uint32_t k = 0; k < 3; ++k)
+          point += i_box._axis[k] * ((corner & (1u << k)) ? i_box._extent._u[k] : -i_box._extent._u[k]);
+        const float separation = Math::Vector3::Dot(point - a, normal);
+        if (separation > s_contactMargin)
+          continue;
+        // in the prism of the triangle.
+        if (SignedArea(a, b, point, normal) < 0.0f || SignedArea(b, c, point, normal) < 0.0f || SignedArea(c, a, point, normal) < 0.0f)
+          continue;
+        o_pPoints[count]._position = point - normal * (0.5f * separation);
+        o_pPoints[count]._penetration = -separation;
+        ++count;
+      }
+      o_normal = normal * -1.0f;
+      return count;
+    }
+
+    void ReduceContactPoints(const ContactPoint* i_pPoints, uint32_t count, const Math::Vector3& i_normal, ContactManifold& o_manifold)
+    {
+      o_manifold._normal = i_normal;
+      if (count <= s_maxManifoldPoints)
+      {
+        for (uint32_t i = 0; i < count; ++i)
+          o_manifold._points[i] = i_pPoints[i];
+        o_manifold._pointCount = count;
+        return;
+      }
+      uint32_t deepest = 0;
+      for (uint32_t i = 1; i < count; ++i)
+      {
+        if (i_pPoints[i]._penetration > i_pPoints[deepest]._penetration)
+          deepest = i;
+      }
+      const Math::Vector3& p0 = i_pPoints[deepest]._position;
+      uint32_t farthest = deepest;
+      float maxSqDistance = 0.0f;
+      for (uint32_t i = 0; i < count; ++i)
+      {
+        float sqDistance = (i_pPoints[i]._position - p0).SqMagnitude();
+        if (sqDistance > maxSqDistance)
+        {
+          maxSqDistance = sqDistance;
+          farthest = i;
+        }
+      }
+      const Math::Vector3& p1 = i_pPoints[farthest]._position;
+      uint32_t third = deepest;
+      float maxArea = 0.0f;
+      for (uint32_t i = 0; i < count; ++i)
+      {
+        float area = std::fabs(SignedArea(p0, p1, i_pPoints[i]._position, i_normal));
+        if (area > maxArea)
+        {
+          maxArea = area;
+          third = i;
+        }
+      }
+      uint32_t indices[s_maxManifoldPoints] = { deepest, farthest, third, 0 };
+      uint32_t chosen = 3;
+      if (farthest == deepest)
+        chosen = 1;
+      else if (third == deepest)
+        chosen = 2;
+      else
+      {
+        // Make the triangle counterclockwise, then the fourth point is the one farthest outside of its edges.
+        if (SignedArea(p0, p1, i_pPoints[third]._position, i_normal) < 0.0f)
+        {
+          indices[1] = third;
+          indices[2] = farthest;
+        }
+        float maxOutside = 0.0f;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+          for (uint32_t edge = 0; edge < 3; ++edge)
+          {
+            float outside = -SignedArea(i_pPoints[indices[edge]]._position, i_pPoints[indices[(edge + 1) % 3]]._position,
+              i_pPoints[i]._position, i_normal);
+            if (outside > maxOutside)
+            {
+              maxOutside = outside;
+              indices[3] = i;
+              chosen = 4;
+            }
+          }
+        }
+      }
+      for (uint32_t i = 0; i < chosen; ++i)
+        o_manifold._points[i] = i_pPoints[indices[i]];
+      o_manifold._pointCount = chosen;
+    }
+
+    void BuildManifolds(const std::vector<ContactPoint>& i_points, const std::vector<Math::Vector3>& i_normals,
+      std::vector<ContactManifold>& o_manifolds)
+    {
+      assert(i_points.size() == i_normals.size());
+      const float sameNormal = 0.95f;
+      const float sqMergeDistance = 1.0e-3f * 1.0e-3f;
+      std::vector<bool> used(i_points.size(), false);
+      std::vector<ContactPoint> group;
+      for (;;)
+      {
+        // Start each manifold from the deepest point left.
+        size_t deepest = i_points.size();
+        for (size_t i = 0; i < i_points.size(); ++i)
+        {
+          if (!used[i] && (deepest == i_points.size() || i_points[i]._penetration > i_points[deepest]._penetration))
+            deepest = i;
+        }
+        if (deepest == i_points.size())
+          break;
+        const Math::Vector3 normal = i_normals[deepest];
+        group.clear();
+        for (size_t i = 0; i < i_points.size(); ++i)
+        {
+          if (used[i] || Math::Vector3::Dot(i_normals[i], normal) < sameNormal)
+            continue;
+          used[i] = true;
+          bool merged = false;
+          for (std::vector<ContactPoint>::iterator it = group.begin(); it != group.end() && !merged; ++it)
+            merged = (it->_position - i_points[i]._position).SqMagnitude() < sqMergeDistance;
+          if (!merged)
+            group.push_back(i_points[i]);
+        }
+        ContactManifold manifold;
+        ReduceContactPoints(group.data(), (uint32_t)group.size(), normal, manifold);
+        o_manifolds.push_back(manifold);
+      }
+    }
+  }
+}
@@ -0,0 +1,61 @@
+#ifndef EAE_ENGINE_COLLISION_CONTACT_MANIFOLD_H
+#define EAE_ENGINE_COLLISION_CONTACT_MANIFOLD_H
+
+#include "Engine/Math/Vector.h"
+#include "Engine/Math/Geometry.h"
+#include <cstdint>
+#include <vector>
+
+/*
+ * The contact manifolds of the boxes, for the ContactSolver.
+ * A manifold is the patch where 2 shapes touch, up to s_maxManifoldPoints points sharing one normal.
+ * A box resting on a face needs at least 3 points to stay still, a single deepest point makes it rock.
+ * The points closer than s_contactMargin are kept too, so the solver sees a contact one step before it happens
+ * and a resting box doesn't lose its contacts when it bounces up by a tiny distance.
+ */
+namespace EAE_Engine
+{
+  namespace Collision
+  {
+    const uint32_t s_maxManifoldPoints = 4;
+    const float s_contactMargin = 0.02f;
+
+    struct ContactPoint
+    {
+      // in the middle of the 2 surfaces.
+      Math::Vector3 _position;
+      // negative when the shapes are still apart.
+      float _penetration;
+    };
+
+    struct ContactManifold
+    {
+      // normalized, it points from the shape A to the shape B.
+      Math::Vector3 _normal;
+      ContactPoint _points[s_maxManifoldPoints];
+      uint32_t _pointCount;
+    };
+
+    // The axis of the least penetration is found by the 15 axes of the SAT, the face axes are preferred over the edge axes.
+    // For a face axis, the face of the other box most facing it is clipped by the side planes of the reference face,
+    // for an edge axis, the contact is the closest points of the 2 edges.
+    bool CollideOBBOBB(const Math::OBB& i_boxA, const Math::OBB& i_boxB, ContactManifold& o_manifold);
+
+    // The corners of the box in front of the triangle abc and below its face, o_pPoints must have 8 elements.
+    // o_normal points from the box to the triangle, the opposite of the front face normal.
+    // Returns the count of the points, only the faces of the mesh are found, not its edges or corners,
+    // so it works for the boxes resting on a mesh whose triangles are larger than the boxes.
+    uint32_t CollideOBBTriangle(const Math::OBB& i_box, const Math::Vector3& a, const Math::Vector3& b, const Math::Vector3& c,
+      ContactPoint* o_pPoints, Math::Vector3& o_normal);
+
+    // Keep the deepest point and the 3 points spanning the largest area with it.
+    void ReduceContactPoints(const ContactPoint* i_pPoints, uint32_t count, const Math::Vector3& i_normal, ContactManifold& o_manifold);
+
+    // Group the points found on many triangles into the manifolds of the same normal and append them to o_manifolds,
+    // i_normals[i] is the normal of i_points[i]. The points found twice on the shared edges are merged.
+    void BuildManifolds(const std::vector<ContactPoint>& i_points, const std::vector<Math::Vector3>& i_normals,
+      std::vector<ContactManifold>& o_manifolds);
+  }
+}
+
+#endif//EAE_ENGINE_COLLISION_CONTACT_MANIFOLD_H
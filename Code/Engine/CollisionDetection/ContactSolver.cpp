@@ -0,0 +1,323 @@
+#include "ContactSolver.h"
+#include "RigidBody.h"
+#include "OBBCollider.h"
+#include "Math/ColMatrix.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+namespace EAE_Engine
+{
+  namespace Physics
+  {
+    const uint32_t ContactSolver::s_defaultIterationCount = 10;
+    const float ContactSolver::s_baumgarte = 0.2f;
+    const float ContactSolver::s_allowedPenetration = 0.005f;
+    const float ContactSolver::s_restitutionThreshold = 1.0f;
+    const float ContactSolver::s_warmStartDistance = 0.05f;
+
+    ContactSolver::ContactSolver() :
+      _iterationCount(s_defaultIterationCount), _statistics()
+    {
+    }
+
+    void ContactSolver::Step(const std::vector<RigidBody*>& i_rigidBodies, const std::vector<uint32_t>& i_boxBodies, float timeStep)
+    {
+      _statistics = ContactStatistics();
+      const uint32_t boxCount = (uint32_t)i_boxBodies.size();
+      _bodies.resize(1);
+      SolverBody& staticBody = _bodies[0];
+      staticBody._pRigidBody = nullptr;
+      staticBody._velocity = Math::Vector3::Zero;
+      staticBody._angularVelocity = Math::Vector3::Zero;
+      staticBody._center = Math::Vector3::Zero;
+      for (size_t k = 0; k < 3; ++k)
+        staticBody._axis[k] = Math::Vector3::Zero;
+      staticBody._inverseInertia = Math::Vector3::Zero;
+      staticBody._inverseMass = 0.0f;
+      _boxes.resize(boxCount);
+      _boxAABBs.resize(boxCount);
+      _solverIndices.resize(boxCount);
+      _boxColliders.resize(boxCount);
+      for (uint32_t slot = 0; slot < boxCount; ++slot)
+      {
+        RigidBody* pRB = i_rigidBodies[i_boxBodies[slot]];
+        Collider::OBBCollider* pCollider = pRB->_pBoxCollider;
+        // the same box as OBBCollider::GetWorldOBB, at the position of this step.
+        Math::OBB& box = _boxes[slot];
+        Math::ColMatrix44 rotation = Math::Quaternion::CreateColMatrix(pRB->_spin);
+        box._pos = pRB->_currentPos + pCollider->GetOffset();
+        box._extent = pCollider->GetSize() * 0.5f;
+        Math::Vector3 radius(Collision::s_contactMargin, Collision::s_contactMargin, Collision::s_contactMargin);
+        for (size_t k = 0; k < 3; ++k)
+        {
+          box._axis[k] = rotation.GetCol(k);
+          for (size_t axis = 0; axis < 3; ++axis)
+            radius._u[axis] += box._extent._u[k] * std::fabs(box._axis[k]._u[axis]);
+        }
+        _boxAABBs[slot] = Math::PackedAABB(box._pos - radius, box._pos + radius);
+        _boxColliders[slot] = pCollider;
+        _solverIndices[slot] = 0;
+        if (pRB->_sleeping)
+          continue;
+        _solverIndices[slot] = (uint32_t)_bodies.size();
+        SolverBody body;
+        body._pRigidBody = pRB;
+        body._inverseMass = 1.0f / pRB->_mass;
+        body._velocity = pRB->_currentVelocity + pRB->_totalForceWorkingOn * (body._inverseMass * timeStep);
+        body._angularVelocity = pRB->_angularVelocity;
+        body._center = box._pos;
+        // the inertia of a solid box around its center.
+        const Math::Vector3& size = pCollider->GetSize();
+        for (size_t k = 0; k < 3; ++k)
+        {
+          body._axis[k] = box._axis[k];
+          const float side1 = size._u[(k + 1) % 3];
+          const float side2 = size._u[(k + 2) % 3];
+          const float inertia = pRB->_mass * (side1 * side1 + side2 * side2) / 12.0f;
+          body._inverseInertia._u[k] = inertia > 0.0f ? 1.0f / inertia : 0.0f;
+        }
+        _bodies.push_back(body);
+      }
+      _statistics._bodyCount = (uint32_t)_bodies.size() - 1;
+      std::sort(_boxColliders.begin(), _boxColliders.end(), std::less<Collider::Collider*>());
+
+      // A sleeping box only wakes up for the boxes moving faster than the sleep speeds,
+      // or a resting box wakes up the whole pile under it.
+      auto isMoving = [](const RigidBody* i_pRB)
+      {
+        return i_pRB->_currentVelocity.SqMagnitude() > RigidBody::s_sleepLinearSpeed * RigidBody::s_sleepLinearSpeed ||
+          i_pRB->_angularVelocity.SqMagnitude() > RigidBody::s_sleepAngularSpeed * RigidBody::s_sleepAngularSpeed;
+      };
+      _constraints.clear();
+      // The pairs of the boxes are found by the sweep of their min x, like RigidBodyManager::BuildIslands.
+      _sortedBoxes.resize(boxCount);
+      for (uint32_t slot = 0; slot < boxCount; ++slot)
+        _sortedBoxes[slot] = slot;
+      std::sort(_sortedBoxes.begin(), _sortedBoxes.end(), [this](uint32_t i_a, uint32_t i_b)
+      {
+        const float minA = _boxAABBs[i_a]._min[0];
+        const float minB = _boxAABBs[i_b]._min[0];
+        return minA < minB || (minA == minB && i_a < i_b);
+      });
+      for (uint32_t i = 0; i < boxCount; ++i)
+      {
+        const uint32_t slot = _sortedBoxes[i];
+        const float max = _boxAABBs[slot]._max[0];
+        for (uint32_t j = i + 1; j < boxCount && _boxAABBs[_sortedBoxes[j]]._min[0] <= max; ++j)
+        {
+          const uint32_t other = _sortedBoxes[j];
+          if (_solverIndices[slot] == 0 && _solverIndices[other] == 0)
+            continue;
+          if (!Math::TestAABBAABB(_boxAABBs[slot], _boxAABBs[other]))
+            continue;
+          const uint32_t slotA = slot < other ? slot : other;
+          const uint32_t slotB = slot < other ? other : slot;
+          Collision::ContactManifold manifold;
+          if (!Collision::CollideOBBOBB(_boxes[slotA], _boxes[slotB], manifold))
+            continue;
+          RigidBody* pA = i_rigidBodies[i_boxBodies[slotA]];
+          RigidBody* pB = i_rigidBodies[i_boxBodies[slotB]];
+          // The woken box joins the awake ones in the next step, it is static in this step.
+          if (_solverIndices[slotA] == 0 && isMoving(pB))
+            pA->WakeUp();
+          else if (_solverIndices[slotB] == 0 && isMoving(pA))
+            pB->WakeUp();
+          AddManifold(_solverIndices[slotA], _solverIndices[slotB], pA, pB, _boxes[slotA], manifold,
+            std::sqrt(pA->_friction * pB->_friction), std::max(pA->_restitution, pB->_restitution), timeStep);
+        }
+      }
+      // The Colliders are static for the boxes.
+      Collider::ColliderManager* pColliderManager = Collider::ColliderManager::GetInstance();
+      for (uint32_t slot = 0; slot < boxCount; ++slot)
+      {
+        if (_solverIndices[slot] == 0)
+          continue;
+        RigidBody* pRB = i_rigidBodies[i_boxBodies[slot]];
+        pColliderManager->QueryColliders(_boxAABBs[slot], _candidateColliders);
+        for (std::vector<Collider::Collider*>::iterator it = _candidateColliders.begin(); it != _candidateColliders.end(); ++it)
+        {
+          if (std::binary_search(_boxColliders.begin(), _boxColliders.end(), *it, std::less<Collider::Collider*>()))
+            continue;
+          _manifolds.clear();
+          (*it)->CollideOBB(_boxes[slot], _manifolds);
+          for (std::vector<Collision::ContactManifold>::const_iterator itManifold = _manifolds.begin(); itManifold != _manifolds.end(); ++itManifold)
+          {
+            AddManifold(_solverIndices[slot], 0, pRB, *it, _boxes[slot], *itManifold, pRB->_friction, pRB->_restitution, timeStep);
+          }
+        }
+      }
+
+      // Warm start
+      for (std::vector<ContactConstraint>::const_iterator it = _constraints.begin(); it != _constraints.end(); ++it)
+      {
+        ApplyImpulse(*it, it->_normal * it->_normalImpulse + it->_tangents[0] * it->_tangentImpulses[0] +
+          it->_tangents[1] * it->_tangentImpulses[1]);
+      }
+      for (uint32_t iteration = 0; iteration < _iterationCount; ++iteration)
+      {
+        for (std::vector<ContactConstraint>::iterator it = _constraints.begin(); it != _constraints.end(); ++it)
+        {
+          ContactConstraint& constraint = *it;
+          // The friction is limited by the normal impulse of the last iteration.
+          const float maxFriction = constraint._friction * constraint._normalImpulse;
+          for (size_t k = 0; k < 2; ++k)
+          {
+            float speed = Math::Vector3::Dot(GetRelativeVelocity(constraint), constraint._tangents[k]);
+            float oldImpulse = constraint._tangentImpulses[k];
+            float newImpulse = oldImpulse - speed * constraint._tangentMasses[k];
+            newImpulse = newImpulse < -maxFriction ? -maxFriction : (newImpulse > maxFriction ? maxFriction : newImpulse);
+            constraint._tangentImpulses[k] = newImpulse;
+            ApplyImpulse(constraint, constraint._tangents[k] * (newImpulse - oldImpulse));
+          }
+          float speed = Math::Vector3::Dot(GetRelativeVelocity(constraint), constraint._normal);
+          float oldImpulse = constraint._normalImpulse;
+          float newImpulse = oldImpulse + (constraint._bias - speed) * constraint._normalMass;
+          newImpulse = newImpulse > 0.0f ? newImpulse : 0.0f;
+          constraint._normalImpulse = newImpulse;
+          ApplyImpulse(constraint, constraint._normal * (newImpulse - oldImpulse));
+        }
+      }
+
+      for (size_t index = 1; index < _bodies.size(); ++index)
+      {
+        const SolverBody& body = _bodies[index];
+        RigidBody* pRB = body._pRigidBody;
+        pRB->_currentVelocity = body._velocity;
+        pRB->_angularVelocity = body._angularVelocity;
+        pRB->_currentPos += body._velocity * timeStep;
+        pRB->IntegrateSpin(timeStep);
+        pRB->_lastTimeStep = 0.0f;
+        pRB->_outForceWorkingOn = Math::Vector3::Zero;
+      }
+      _cache.resize(_constraints.size());
+      for (size_t index = 0; index < _constraints.size(); ++index)
+      {
+        const ContactConstraint& constraint = _constraints[index];
+        CachedContact& cached = _cache[index];
+        cached._pKeyA = constraint._pKeyA;
+        cached._pKeyB = constraint._pKeyB;
+        cached._localAnchor = constraint._localAnchor;
+        cached._normal = constraint._normal;
+        cached._normalImpulse = constraint._normalImpulse;
+        cached._tangentImpulses[0] = constraint._tangentImpulses[0];
+        cached._tangentImpulses[1] = constraint._tangentImpulses[1];
+      }
+      std::stable_sort(_cache.begin(), _cache.end(), CompareKeys);
+    }
+
+    void ContactSolver::AddManifold(uint32_t bodyA, uint32_t bodyB, const void* pKeyA, const void* pKeyB, const Math::OBB& i_boxA,
+      const Collision::ContactManifold& i_manifold, float friction, float restitution, float timeStep)
+    {
+      ++_statistics._manifoldCount;
+      const SolverBody& a = _bodies[bodyA];
+      const SolverBody& b = _bodies[bodyB];
+      CachedContact key;
+      key._pKeyA = pKeyA;
+      key._pKeyB = pKeyB;
+      std::pair<std::vector<CachedContact>::const_iterator, std::vector<CachedContact>::const_iterator> cachedRange =
+        std::equal_range(_cache.begin(), _cache.end(), key, CompareKeys);
+      const Math::Vector3& normal = i_manifold._normal;
+      // The same tangents for the same normal, so the friction impulses can be warm started.
+      Math::Vector3 tangent = std::fabs(normal._x) >= 0.57735f ?
+        Math::Vector3(normal._y, -normal._x, 0.0f) : Math::Vector3(0.0f, normal._z, -normal._y);
+      tangent.Normalize();
+      for (uint32_t i = 0; i < i_manifold._pointCount; ++i)
+      {
+        const Collision::ContactPoint& point = i_manifold._points[i];
+        ContactConstraint constraint;
+        constraint._bodyA = bodyA;
+        constraint._bodyB = bodyB;
+        constraint._normal = normal;
+        constraint._tangents[0] = tangent;
+        constraint._tangents[1] = Math::Vector3::Cross(normal, tangent);
+        constraint._offsetA = point._position - a._center;
+        constraint._offsetB = point._position - b._center;
+        const Math::Vector3* directions[] = { &constraint._normal, &constraint._tangents[0], &constraint._tangents[1] };
+        float masses[3];
+        for (size_t k = 0; k < 3; ++k)
+        {
+          const Math::Vector3& direction = *directions[k];
+          Math::Vector3 armA = Math::Vector3::Cross(constraint._offsetA, direction);
+          Math::Vector3 armB = Math::Vector3::Cross(constraint._offsetB, direction);
+          float inverseMass = a._inverseMass + b._inverseMass +
+            Math::Vector3::Dot(armA, ApplyInverseInertia(a, armA)) + Math::Vector3::Dot(armB, ApplyInverseInertia(b, armB));
+          masses[k] = inverseMass > 0.0f ? 1.0f / inverseMass : 0.0f;
+        }
+        constraint._normalMass = masses[0];
+        constraint._tangentMasses[0] = masses[1];
+        constraint._tangentMasses[1] = masses[2];
+        constraint._friction = friction;
+        // Push the penetration out gradually, or let the bodies close the gap of a contact found early.
+        float bias = 0.0f;
+        if (point._penetration > 0.0f)
+          bias = s_baumgarte / timeStep * std::max(point._penetration - s_allowedPenetration, 0.0f);
+        else
+          bias = point._penetration / timeStep;
+        float normalSpeed = Math::Vector3::Dot(GetRelativeVelocity(constraint), normal);
+        if (normalSpeed < -s_restitutionThreshold)
+          bias = std::max(bias, -restitution * normalSpeed);
+        constraint._bias = bias;
+        constraint._pKeyA = pKeyA;
+        constraint._pKeyB = pKeyB;
+        const Math::Vector3 offset = point._position - i_boxA._pos;
+        constraint._localAnchor = Math::Vector3(Math::Vector3::Dot(offset, i_boxA._axis[0]),
+          Math::Vector3::Dot(offset, i_boxA._axis[1]), Math::Vector3::Dot(offset, i_boxA._axis[2]));
+        constraint._normalImpulse = 0.0f;
+        constraint._tangentImpulses[0] = 0.0f;
+        constraint._tangentImpulses[1] = 0.0f;
+        for (std::vector<CachedContact>::const_iterator it = cachedRange.first; it != cachedRange.second; ++it)
+        {
+          if (Math::Vector3::Dot(it->_normal, normal) > 0.95f &&
+            (it->_localAnchor - constraint._localAnchor).SqMagnitude() < s_warmStartDistance * s_warmStartDistance)
+          {
+            constraint._normalImpulse = it->_normalImpulse;
+            constraint._tangentImpulses[0] = it->_tangentImpulses[0];
+            constraint._tangentImpulses[1] = it->_tangentImpulses[1];
+            ++_statistics._warmStartedCount;
+            break;
+          }
+        }
+        _constraints.push_back(constraint);
+        ++_statistics._contactCount;
+        _statistics._maxPenetration = std::max(_statistics._maxPenetration, point._penetration);
+      }
+    }
+
+    // The impulse is applied to the body B, and the opposite one to the body A.
+    void ContactSolver::ApplyImpulse(const ContactConstraint& i_constraint, const Math::Vector3& i_impulse)
+    {
+      SolverBody& a = _bodies[i_constraint._bodyA];
+      SolverBody& b = _bodies[i_constraint._bodyB];
+      a._velocity = a._velocity - i_impulse * a._inverseMass;
+      a._angularVelocity = a._angularVelocity - ApplyInverseInertia(a, Math::Vector3::Cross(i_constraint._offsetA, i_impulse));
+      b._velocity = b._velocity + i_impulse * b._inverseMass;
+      b._angularVelocity = b._angularVelocity + ApplyInverseInertia(b, Math::Vector3::Cross(i_constraint._offsetB, i_impulse));
+    }
+
+    // the velocity of the point on B relative to the point on A.
+    Math::Vector3 ContactSolver::GetRelativeVelocity(const ContactConstraint& i_constraint) const
+    {
+      const SolverBody& a = _bodies[i_constraint._bodyA];
+      const SolverBody& b = _bodies[i_constraint._bodyB];
+      return b._velocity + Math::Vector3::Cross(b._angularVelocity, i_constraint._offsetB) -
+        a._velocity - Math::Vector3::Cross(a._angularVelocity, i_constraint._offsetA);
+    }
+
+    Math::Vector3 ContactSolver::ApplyInverseInertia(const SolverBody& i_body, const Math::Vector3& i_vector)
+    {
+      Math::Vector3 result = Math::Vector3::Zero;
+      for (size_t k = 0; k < 3; ++k)
+        result += i_body._axis[k] * (Math::Vector3::Dot(i_body._axis[k], i_vector) * i_body._inverseInertia._u[k]);
+      return result;
+    }
+
+    bool ContactSolver::CompareKeys(const CachedContact& i_a, const CachedContact& i_b)
+    {
+      std::less<const void*> less;
+      if (i_a._pKeyA != i_b._pKeyA)
+        return less(i_a._pKeyA, i_b._pKeyA);
+      return less(i_a._pKeyB, i_b._pKeyB);
+    }
+  }
+}
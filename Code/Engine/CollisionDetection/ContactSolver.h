@@ -0,0 +1,141 @@
+#ifndef EAE_ENGINE_PHYSICS_CONTACT_SOLVER_H
+#define EAE_ENGINE_PHYSICS_CONTACT_SOLVER_H
+
+#include "ContactManifold.h"
+#include "Engine/Math/Geometry.h"
+#include "Engine/Math/SIMDGeometry.h"
+#include <cstdint>
+#include <vector>
+
+/*
+ * The sequential impulse solver of the RigidBodys with a box, see RigidBody::SetBoxCollider.
+ * Each step the velocities take the forces first, then the contacts of the boxes with each other and with the Colliders
+ * are solved one by one for s_defaultIterationCount times, each one changes the velocities of its 2 bodies
+ * so that they stop moving into each other, and the friction stops them sliding as far as the normal impulse allows it.
+ * The impulses are accumulated and clamped, so a contact can take back what it has applied in the earlier iterations.
+ * The impulses of the last step are applied at first (warm starting), so a pile of boxes starts each step
+ * almost solved and doesn't jitter. A contact is the same as the last one when its point is within s_warmStartDistance
+ * in the space of the box A and the normal hasn't turned.
+ * The penetration deeper than s_allowedPenetration is pushed out by s_baumgarte of it in each step.
+ * A box is the same as the semi-implicit Euler, it moves with its velocity after the step.
+ * A sleeping box is static for the awake ones, it wakes up when a box moving faster than the sleep speeds touches it.
+ * Everything runs on the calling thread in the order of the RigidBodys, so the result is the same in each run.
+ * For more: Erin Catto, Iterative Dynamics with Temporal Coherence, GDC 2005.
+ */
+namespace EAE_Engine
+{
+  namespace Collider
+  {
+    class Collider;
+  }
+
+  namespace Physics
+  {
+    class RigidBody;
+
+    struct ContactStatistics
+    {
+      // the awake boxes in the last Step.
+      uint32_t _bodyCount;
+      uint32_t _manifoldCount;
+      uint32_t _contactCount;
+      // the contacts which started from the impulses of the step before.
+      uint32_t _warmStartedCount;
+      // the deepest penetration found by the last Step before solving it, which is the penetration left by the steps before.
+      float _maxPenetration;
+    };
+
+    class ContactSolver
+    {
+    public:
+      static const uint32_t s_defaultIterationCount;
+      static const float s_baumgarte;
+      static const float s_allowedPenetration;
+      // The slower contacts don't bounce, or a resting box keeps bouncing on the speed it gains from the gravity in one step.
+      static const float s_restitutionThreshold;
+      static const float s_warmStartDistance;
+      ContactSolver();
+      void SetIterationCount(uint32_t count) { _iterationCount = count; }
+      uint32_t GetIterationCount() const { return _iterationCount; }
+      // i_boxBodies are the indices of the RigidBodys with a box in i_rigidBodies, the sleeping ones included.
+      // Moves the awake boxes by timeStep, and clears their forces.
+      void Step(const std::vector<RigidBody*>& i_rigidBodies, const std::vector<uint32_t>& i_boxBodies, float timeStep);
+      const ContactStatistics& GetStatistics() const { return _statistics; }
+      // forget the impulses of the last step, call it after the boxes are moved by hand.
+      void ClearWarmStart() { _cache.clear(); }
+
+    private:
+      struct SolverBody
+      {
+        RigidBody* _pRigidBody;
+        Math::Vector3 _velocity;
+        Math::Vector3 _angularVelocity;
+        Math::Vector3 _center;
+        Math::Vector3 _axis[3];
+        // the inverse of the inertia on each of the _axis.
+        Math::Vector3 _inverseInertia;
+        float _inverseMass;
+      };
+
+      struct ContactConstraint
+      {
+        uint32_t _bodyA;
+        uint32_t _bodyB;
+        Math::Vector3 _normal;
+        Math::Vector3 _tangents[2];
+        // from the center of each body to the contact point.
+        Math::Vector3 _offsetA;
+        Math::Vector3 _offsetB;
+        float _normalMass;
+        float _tangentMasses[2];
+        // the relative normal velocity the contact pushes the bodies apart with.
+        float _bias;
+        float _friction;
+        float _normalImpulse;
+        float _tangentImpulses[2];
+        // for the warm starting in the next step.
+        const void* _pKeyA;
+        const void* _pKeyB;
+        Math::Vector3 _localAnchor;
+      };
+
+      struct CachedContact
+      {
+        const void* _pKeyA;
+        const void* _pKeyB;
+        Math::Vector3 _localAnchor;
+        Math::Vector3 _normal;
+        float _normalImpulse;
+        float _tangentImpulses[2];
+      };
+
+      // The box A is always a box of a RigidBody, the key B is the RigidBody or the Collider of the box B.
+      void AddManifold(uint32_t bodyA, uint32_t bodyB, const void* pKeyA, const void* pKeyB, const Math::OBB& i_boxA,
+        const Collision::ContactManifold& i_manifold, float friction, float restitution, float timeStep);
+      void ApplyImpulse(const ContactConstraint& i_constraint, const Math::Vector3& i_impulse);
+      Math::Vector3 GetRelativeVelocity(const ContactConstraint& i_constraint) const;
+      static Math::Vector3 ApplyInverseInertia(const SolverBody& i_body, const Math::Vector3& i_vector);
+      static bool CompareKeys(const CachedContact& i_a, const CachedContact& i_b);
+
+    private:
+      // _bodies[0] is the static body for the Colliders and the sleeping boxes.
+      std::vector<SolverBody> _bodies;
+      // for each box in i_boxBodies, its world box and its index in _bodies.
+      std::vector<Math::OBB> _boxes;
+      std::vector<Math::PackedAABB> _boxAABBs;
+      std::vector<uint32_t> _solverIndices;
+      std::vector<uint32_t> _sortedBoxes;
+      // the Colliders of the boxes, sorted, they are skipped in the Colliders found near a box.
+      std::vector<Collider::Collider*> _boxColliders;
+      std::vector<Collider::Collider*> _candidateColliders;
+      std::vector<Collision::ContactManifold> _manifolds;
+      std::vector<ContactConstraint> _constraints;
+      // the contacts of the last step sorted by their keys, in the order they were found for the same keys.
+      std::vector<CachedContact> _cache;
+      uint32_t _iterationCount;
+      ContactStatistics _statistics;
+    };
+  }
+}
+
+#endif//EAE_ENGINE_PHYSICS_CONTACT_SOLVER_H
@@ -0,0 +1,69 @@
+#include "ContinuousCollision.h"
+#include <cmath>
+
+namespace EAE_Engine
+{
+  namespace Collision
+  {
+    float SphereMotion::TimeToReachPlane(float i_t, const Math::Vector3& i_normal, float i_distance) const
+    {
+      // The height above the plane after tau is i_distance + b * tau + a * tau * tau.
+      const float a = 0.5f * Math::Vector3::Dot(_acceleration, i_normal);
+      const float b = Math::Vector3::Dot(VelocityAt(i_t), i_normal);
+      float tau = FLT_MAX;
+      if (std::fabs(a) < 1.0e-8f)
+      {
+        if (b < 0.0f)
+          tau = -i_distance / b;
+      }
+      else
+      {
+        float discriminant = b * b - 4.0f * a * i_distance;
+        if (discriminant >= 0.0f)
+        {
+          float root = std::sqrt(discriminant);
+          float tau0 = (-b - root) / (2.0f * a);
+          float tau1 = (-b + root) / (2.0f * a);
+          if (tau0 > tau1)
+          {
+            float temp = tau0;
+            tau0 = tau1;
+            tau1 = temp;
+          }
+          if (tau0 > 0.0f)
+            tau = tau0;
+          else if (tau1 > 0.0f)
+            tau = tau1;
+        }
+      }
+      if (tau > _duration - i_t)
+        return FLT_MAX;
+      return i_t + tau;
+    }
+
+    void SphereMotion::GetBounds(Math::Vector3& o_min, Math::Vector3& o_max) const
+    {
+      const Math::Vector3 end = PositionAt(_duration);
+      for (size_t axis = 0; axis < 3; ++axis)
+      {
+        float min = _start._u[axis] < end._u[axis] ? _start._u[axis] : end._u[axis];
+        float max = _start._u[axis] < end._u[axis] ? end._u[axis] : _start._u[axis];
+        // The path may turn around on this axis during the step.
+        if (_acceleration._u[axis] != 0.0f)
+        {
+          float turn = -_velocity._u[axis] / _acceleration._u[axis];
+          if (turn > 0.0f && turn < _duration)
+          {
+            float extreme = _start._u[axis] + 0.5f * _velocity._u[axis] * turn;
+            if (extreme < min)
+              min = extreme;
+            if (extreme > max)
+              max = extreme;
+          }
+        }
+        o_min._u[axis] = min - _radius - s_toiTolerance;
+        o_max._u[axis] = max + _radius + s_toiTolerance;
+      }
+    }
+  }
+}
@@ -0,0 +1,119 @@
+#ifndef EAE_ENGINE_COLLISION_CONTINUOUS_COLLISION_H
+#define EAE_ENGINE_COLLISION_CONTINUOUS_COLLISION_H
+
+#include "Engine/Math/Vector.h"
+#include <cfloat>
+#include <cstdint>
+
+/*
+ * The time of impact by the conservative advancement, for the RigidBodys which move too fast for the segment test.
+ * The RigidBody is a sphere (radius 0 for a point) moving with a constant acceleration during the step,
+ * which is the same motion as RigidBody::PredictPosAfter.
+ * For a convex shape, the plane through its point closest to the sphere separates the sphere from the whole shape,
+ * so the sphere can safely advance until it reaches that plane, the time is a root of a quadratic.
+ * Repeat it from the new position until the sphere is within s_toiTolerance of a shape.
+ * A mesh is the union of its triangles, so the sphere advances by the smallest advancement of them.
+ * Unlike the segment test, it follows the curved path and hits the back faces and the edges too,
+ * so a fast body can't tunnel through a thin wall.
+ */
+namespace EAE_Engine
+{
+  namespace Collision
+  {
+    struct SphereMotion
+    {
+      Math::Vector3 PositionAt(float t) const { return _start + _velocity * t + _acceleration * (0.5f * t * t); }
+      Math::Vector3 VelocityAt(float t) const { return _velocity + _acceleration * t; }
+      // The first time in (i_t, _duration] when the sphere, i_distance above the plane with i_normal at i_t, reaches the plane.
+      // FLT_MAX if it doesn't reach the plane in this step.
+      float TimeToReachPlane(float i_t, const Math::Vector3& i_normal, float i_distance) const;
+      // The box bounding the sphere during the whole step.
+      void GetBounds(Math::Vector3& o_min, Math::Vector3& o_max) const;
+
+      Math::Vector3 _start;
+      Math::Vector3 _velocity;
+      Math::Vector3 _acceleration;
+      float _radius;
+      float _duration;
+    };
+
+    struct TimeOfImpact
+    {
+      // the time of impact in [0, 1] of the duration.
+      float _t;
+      Math::Vector3 _point;
+      // the normal of the shape at _point, it points to the sphere.
+      Math::Vector3 _normal;
+      uint32_t _iterations;
+    };
+
+    // The sphere touches a shape when it is closer than this.
+    const float s_toiTolerance = 0.005f;
+    // The advancement converges in 1 or 2 iterations on a face, but slowly when the sphere passes close to an edge.
+    // Stop there and report a hit, which is safe but may stop the sphere a little early.
+    const uint32_t s_toiMaxIterations = 32;
+
+    // closestPoint(shapeIndex, point) returns the point on the convex shape closest to point.
+    // The shapes the sphere starts inside are ignored, there is no time of impact to find for them.
+    template<typename ClosestPoint>
+    bool ConservativeAdvancement(const SphereMotion& i_motion, uint32_t shapeCount, ClosestPoint closestPoint, TimeOfImpact& o_toi)
+    {
+      const float epsilon = 1.0e-6f;
+      float t = 0.0f;
+      Math::Vector3 limitingPoint = Math::Vector3::Zero;
+      Math::Vector3 limitingNormal = Math::Vector3::Zero;
+      for (uint32_t iteration = 1; iteration <= s_toiMaxIterations; ++iteration)
+      {
+        const Math::Vector3 position = i_motion.PositionAt(t);
+        const Math::Vector3 velocity = i_motion.VelocityAt(t);
+        float nextT = FLT_MAX;
+        float nearest = FLT_MAX;
+        for (uint32_t shape = 0; shape < shapeCount; ++shape)
+        {
+          const Math::Vector3 point = closestPoint(shape, position);
+          const Math::Vector3 offset = position - point;
+          const float length = offset.Magnitude();
+          if (length < epsilon)
+            continue;
+          const Math::Vector3 normal = offset * (1.0f / length);
+          const float distance = length - i_motion._radius;
+          if (distance <= s_toiTolerance)
+          {
+            // Touching, it is only a hit when the sphere moves toward the shape.
+            if (Math::Vector3::Dot(velocity, normal) < 0.0f && distance < nearest)
+            {
+              nearest = distance;
+              o_toi._point = point;
+              o_toi._normal = normal;
+            }
+            continue;
+          }
+          // Stop in the middle of the tolerance, so the next iteration finds it touching a face.
+          float time = i_motion.TimeToReachPlane(t, normal, distance - 0.5f * s_toiTolerance);
+          if (time < nextT)
+          {
+            nextT = time;
+            limitingPoint = point;
+            limitingNormal = normal;
+          }
+        }
+        if (nearest != FLT_MAX)
+        {
+          o_toi._t = i_motion._duration > 0.0f ? t / i_motion._duration : 0.0f;
+          o_toi._iterations = iteration;
+          return true;
+        }
+        if (nextT == FLT_MAX)
+          return false;
+        t = nextT;
+      }
+      o_toi._t = i_motion._duration > 0.0f ? t / i_motion._duration : 0.0f;
+      o_toi._point = limitingPoint;
+      o_toi._normal = limitingNormal;
+      o_toi._iterations = s_toiMaxIterations;
+      return true;
+    }
+  }
+}
+
+#endif//EAE_ENGINE_COLLISION_CONTINUOUS_COLLISION_H
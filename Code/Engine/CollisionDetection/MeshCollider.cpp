@@ -4,13 +4,16 @@
 #include "Math/ColMatrix.h"
 #include "SpatialPartition/Octree.h"
 #include "DebugShape/DebugShape.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
 
 namespace EAE_Engine
 {
 	namespace Collider
 	{
 		MeshCollider::MeshCollider(Common::ITransform* pTransform) : Collider(), 
-			_pAOSMeshData(nullptr)
+			_pAOSMeshData(nullptr), _pOctree(nullptr), _bounds(Math::Vector3::Zero, Math::Vector3::Zero)
 		{
 			_hashtype = HashedString("MeshCollider");
 			_pTransform = pTransform;
@@ -19,6 +22,36 @@ namespace EAE_Engine
 		void MeshCollider::Init(const char* pMeshKey)
 		{
 			_pAOSMeshData = Mesh::AOSMeshDataManager::GetInstance()->GetAOSMeshData(pMeshKey);
+			_pOctree = Core::OctreeManager::GetInstance()->GetOctree();
+			//without a mesh the bound is the point of the Transform, so it never becomes a candidate pair.
+			if (_pAOSMeshData == nullptr || _pAOSMeshData->_vertices.empty())
+			{
+				Math::Vector3 pos = _pTransform->GetPos();
+				_bounds = Math::PackedAABB(pos, pos);
+				return;
+			}
+			const std::vector<Mesh::sVertex>& vertices = _pAOSMeshData->_vertices;
+			__m128 min = _mm_setr_ps(vertices[0].x, vertices[0].y, vertices[0].z, 0.0f);
+			__m128 max = min;
+			for (size_t vertexIndex = 1; vertexIndex < vertices.size(); ++vertexIndex)
+			{
+				const Mesh::sVertex& vertex = vertices[vertexIndex];
+				__m128 pos = _mm_setr_ps(vertex.x, vertex.y, vertex.z, 0.0f);
+				min = _mm_min_ps(min, pos);
+				max = _mm_max_ps(max, pos);
+			}
+			_bounds.Set(min, max);
+		}
+
+		Math::PackedAABB MeshCollider::GetSweptAABB(float)
+		{
+			return _bounds;
+		}
+
+		void MeshCollider::PrepareForStep()
+		{
+			if (_pOctree == nullptr)
+				_pOctree = Core::OctreeManager::GetInstance()->GetOctree();
 		}
 
 		bool MeshCollider::TestCollision(Common::IRigidBody* pTargetRB, float i_follisionTimeStep, float& o_tmin,
@@ -27,45 +60,234 @@ namespace EAE_Engine
 			//o_tmin = FLT_MAX;
 			if (_pAOSMeshData == nullptr)
 				return false;
-			Math::ColMatrix44& transformMat = _pTransform->GetLocalToWorldMatrix();
+			Math::ColMatrix44 transformMat = _pTransform->GetLocalToWorldMatrix();
+			Physics::RigidBody* pRB = static_cast<Physics::RigidBody*>(pTargetRB);
+			if (pRB->UseContinuousCollision())
+			{
+				//move the motion by the same matrix as the segment below.
+				Collision::SphereMotion motion = pRB->GetMotion(i_follisionTimeStep);
+				Math::Vector3 start = transformMat * motion._start;
+				Math::Vector3 velocityEnd = transformMat * (motion._start + motion._velocity);
+				Math::Vector3 accelerationEnd = transformMat * (motion._start + motion._acceleration);
+				motion._velocity = velocityEnd - start;
+				motion._acceleration = accelerationEnd - start;
+				motion._start = start;
+				Collision::TimeOfImpact toi;
+				if (!ComputeTimeOfImpact(motion, toi) || toi._t >= o_tmin)
+					return false;
+				o_tmin = toi._t;
+				o_collisionPoint = toi._point;
+				o_collisionNormal = toi._normal;
+				return true;
+			}
 			Math::Vector3 targetStartPoint = transformMat * pTargetRB->GetPos();
 			Math::Vector3 targetEndPoint = transformMat * pTargetRB->PredictPosAfter(i_follisionTimeStep);
-			Core::CompleteOctree* pOctree = Core::OctreeManager::GetInstance()->GetOctree();
-			if (pOctree == nullptr)
+			float t = FLT_MAX;
+			Math::Vector3 hitPoint, normal;
+			if (!IntersectSegment(targetStartPoint, targetEndPoint, t, hitPoint, normal))
 				return false;
-      std::vector<Mesh::TriangleIndex> triangles;
-      pOctree->GetTrianlgesCollideWithSegment(targetStartPoint, targetEndPoint, triangles);
-			std::vector<uint32_t> triangleIndices;
-			for (uint32_t index = 0; index < triangles.size(); ++index)
-			{
-				triangleIndices.push_back(triangles[index]._index0);
-				triangleIndices.push_back(triangles[index]._index1);
-				triangleIndices.push_back(triangles[index]._index2);
-			}
-			Mesh::AOSMeshData* pData = Mesh::AOSMeshDataManager::GetInstance()->GetAOSMeshData("collisionData");
-			std::vector<Math::Vector3> vertices = pData->GetVertexPoses(triangleIndices);
-			if (vertices.size() < 3)
+			if (t >= o_tmin)
+				return false;
+			o_tmin = t;
+			o_collisionPoint = hitPoint;
+			o_collisionNormal = normal;
+			return true;
+		}
+
+		bool MeshCollider::IntersectSegment(const Math::Vector3& i_start, const Math::Vector3& i_end, float& o_t,
+			Math::Vector3& o_hitPoint, Math::Vector3& o_normal)
+		{
+			if (_pOctree == nullptr || _pAOSMeshData == nullptr)
 				return false;
+			const std::vector<Mesh::sVertex>& vertices = _pAOSMeshData->_vertices;
 			bool collided = false;
-			Math::Vector3& vertex0 = vertices[0];
-			Math::Vector3& vertex1 = vertices[1];
-			Math::Vector3& vertex2 = vertices[2];
-			float u = 0, v = 0, w = 0, t = 0;
-			int result = Collision::IntersectSegmentTriangle(targetStartPoint, targetEndPoint, vertex0, vertex1, vertex2, 
-				u, v, w, t);
-			if (result == 0)
-				collided = false;
-			if (t > 1.0f)
-				collided = false;
-			if (t < o_tmin)
+			o_t = FLT_MAX;
+			//walk down the octree with a small stack instead of collecting the nodes of each level in vectors.
+			//the children of the node i are the nodes from i * 8 + 1 to i * 8 + 8.
+			const uint32_t level = _pOctree->Level();
+			if (level == 0)
+				return false;
+			const uint32_t firstLeaf = ((uint32_t)std::pow(8.0f, (float)(level - 1)) - 1) / (8 - 1);
+			Core::OctreeNode* pNodes = _pOctree->GetNodes();
+			//the nodes in the stack overlap the segment, the 8 children of a node are tested together.
+			const size_t stackSize = 8 * 16;
+			uint32_t stack[stackSize];
+			size_t count = 0;
+			Math::AABBV1 aabb;
+			aabb._min = pNodes[0].GetMin();
+			aabb._max = pNodes[0].GetMax();
+			if (Collision::TestSegmentAABB(i_start, i_end, aabb))
+				stack[count++] = 0;
+			while (count > 0)
 			{
-				collided = true;
-				o_tmin = t;
-				o_collisionPoint = vertex0 * u + vertex1 * v + vertex2 * w;
-				o_collisionNormal = Math::Vector3::Cross((vertex1 - vertex0), (vertex2 - vertex1));
+				uint32_t nodeIndex = stack[--count];
+				Core::OctreeNode& node = pNodes[nodeIndex];
+				if (nodeIndex < firstLeaf)
+				{
+					assert(count + 8 <= stackSize);
+					uint32_t childMask = Core::GetChildrenCollideWithSegment(&pNodes[nodeIndex * 8 + 1], i_start, i_end);
+					for (uint32_t childIndex = 8; childIndex > 0; --childIndex)
+					{
+						if (childMask & (1u << (childIndex - 1)))
+							stack[count++] = nodeIndex * 8 + childIndex;
+					}
+					continue;
+				}
+				for (uint32_t triangleIndex = 0; triangleIndex < node._triangleCount; ++triangleIndex)
+				{
+					const Mesh::TriangleIndex triangle = _pOctree->GetTriangle(node, triangleIndex);
+					const Mesh::sVertex& vertex0 = vertices[triangle._index0];
+					const Mesh::sVertex& vertex1 = vertices[triangle._index1];
+					const Mesh::sVertex& vertex2 = vertices[triangle._index2];
+					Math::Vector3 a(vertex0.x, vertex0.y, vertex0.z);
+					Math::Vector3 b(vertex1.x, vertex1.y, vertex1.z);
+					Math::Vector3 c(vertex2.x, vertex2.y, vertex2.z);
+					float u = 0, v = 0, w = 0, t = 0;
+					//only the front faces are hit, t is already in [0, 1].
+					if (!Collision::IntersectSegmentTriangle(i_start, i_end, a, b, c, u, v, w, t))
+						continue;
+					if (t < o_t)
+					{
+						collided = true;
+						o_t = t;
+						o_hitPoint = a * u + b * v + c * w;
+						o_normal = Math::Vector3::Cross(b - a, c - a);
+					}
+				}
 			}
+			if (collided)
+				o_normal.Normalize();
 			return collided;
 		}
 
+		bool MeshCollider::ComputeTimeOfImpact(const Collision::SphereMotion& i_motion, Collision::TimeOfImpact& o_toi)
+		{
+			if (_pOctree == nullptr || _pAOSMeshData == nullptr)
+				return false;
+			const uint32_t level = _pOctree->Level();
+			if (level == 0)
+				return false;
+			Math::AABBV1 bounds;
+			i_motion.GetBounds(bounds._min, bounds._max);
+			//collect the corners of the triangles near the path, the same walk as IntersectSegment.
+			const std::vector<Mesh::sVertex>& vertices = _pAOSMeshData->_vertices;
+			std::vector<Math::Vector3> corners;
+			const uint32_t firstLeaf = ((uint32_t)std::pow(8.0f, (float)(level - 1)) - 1) / (8 - 1);
+			Core::OctreeNode* pNodes = _pOctree->GetNodes();
+			const size_t stackSize = 8 * 16;
+			uint32_t stack[stackSize];
+			size_t count = 0;
+			stack[count++] = 0;
+			while (count > 0)
+			{
+				uint32_t nodeIndex = stack[--count];
+				Core::OctreeNode& node = pNodes[nodeIndex];
+				Math::Vector3 min = node.GetMin();
+				Math::Vector3 max = node.GetMax();
+				if (min._x > bounds._max._x || max._x < bounds._min._x ||
+					min._y > bounds._max._y || max._y < bounds._min._y ||
+					min._z > bounds._max._z || max._z < bounds._min._z)
+					continue;
+				if (nodeIndex < firstLeaf)
+				{
+					assert(count + 8 <= stackSize);
+					for (uint32_t childIndex = 8; childIndex > 0; --childIndex)
+						stack[count++] = nodeIndex * 8 + childIndex;
+					continue;
+				}
+				for (uint32_t triangleIndex = 0; triangleIndex < node._triangleCount; ++triangleIndex)
+				{
+					const Mesh::TriangleIndex triangle = _pOctree->GetTriangle(node, triangleIndex);
+					const Mesh::sVertex* pVertices[] = { &vertices[triangle._index0], &vertices[triangle._index1], &vertices[triangle._index2] };
+					for (size_t i = 0; i < 3; ++i)
+						corners.push_back(Math::Vector3(pVertices[i]->x, pVertices[i]->y, pVertices[i]->z));
+				}
+			}
+			if (corners.empty())
+				return false;
+			return Collision::ConservativeAdvancement(i_motion, (uint32_t)corners.size() / 3,
+				[&corners](uint32_t triangle, const Math::Vector3& i_point)
+			{
+				return Collision::ClosestPtPointTriangle(i_point, corners[triangle * 3], corners[triangle * 3 + 1], corners[triangle * 3 + 2]);
+			}, o_toi);
+		}
+
+		void MeshCollider::CollideOBB(const Math::OBB& i_box, std::vector<Collision::ContactManifold>& o_manifolds)
+		{
+			if (_pOctree == nullptr || _pAOSMeshData == nullptr)
+				return;
+			const uint32_t level = _pOctree->Level();
+			if (level == 0)
+				return;
+			Math::Vector3 radius = Math::Vector3::Zero;
+			for (size_t axis = 0; axis < 3; ++axis)
+			{
+				for (size_t k = 0; k < 3; ++k)
+					radius._u[axis] += i_box._extent._u[k] * std::fabs(i_box._axis[k]._u[axis]);
+				radius._u[axis] += Collision::s_contactMargin;
+			}
+			const Math::Vector3 boundsMin = i_box._pos - radius;
+			const Math::Vector3 boundsMax = i_box._pos + radius;
+			//collect the triangles near the box, the same walk as ComputeTimeOfImpact.
+			_contactTriangles.clear();
+			const uint32_t firstLeaf = ((uint32_t)std::pow(8.0f, (float)(level - 1)) - 1) / (8 - 1);
+			Core::OctreeNode* pNodes = _pOctree->GetNodes();
+			const size_t stackSize = 8 * 16;
+			uint32_t stack[stackSize];
+			size_t count = 0;
+			stack[count++] = 0;
+			while (count > 0)
+			{
+				uint32_t nodeIndex = stack[--count];
+				Core::OctreeNode& node = pNodes[nodeIndex];
+				Math::Vector3 min = node.GetMin();
+				Math::Vector3 max = node.GetMax();
+				if (min._x > boundsMax._x || max._x < boundsMin._x ||
+					min._y > boundsMax._y || max._y < boundsMin._y ||
+					min._z > boundsMax._z || max._z < boundsMin._z)
+					continue;
+				if (nodeIndex < firstLeaf)
+				{
+					assert(count + 8 <= stackSize);
+					for (uint32_t childIndex = 8; childIndex > 0; --childIndex)
+						stack[count++] = nodeIndex * 8 + childIndex;
+					continue;
+				}
+				for (uint32_t triangleIndex = 0; triangleIndex < node._triangleCount; ++triangleIndex)
+					_contactTriangles.push_back(_pOctree->GetTriangle(node, triangleIndex));
+			}
+			if (_contactTriangles.empty())
+				return;
+			//a triangle crossing the leaves is in each of them.
+			std::sort(_contactTriangles.begin(), _contactTriangles.end(), [](const Mesh::TriangleIndex& i_a, const Mesh::TriangleIndex& i_b)
+			{
+				return std::lexicographical_compare(i_a._indices, i_a._indices + 3, i_b._indices, i_b._indices + 3);
+			});
+			_contactTriangles.erase(std::unique(_contactTriangles.begin(), _contactTriangles.end(), [](const Mesh::TriangleIndex& i_a, const Mesh::TriangleIndex& i_b)
+			{
+				return std::equal(i_a._indices, i_a._indices + 3, i_b._indices);
+			}), _contactTriangles.end());
+			const std::vector<Mesh::sVertex>& vertices = _pAOSMeshData->_vertices;
+			_contactPoints.clear();
+			_contactNormals.clear();
+			for (std::vector<Mesh::TriangleIndex>::const_iterator it = _contactTriangles.begin(); it != _contactTriangles.end(); ++it)
+			{
+				const Mesh::sVertex& vertex0 = vertices[it->_index0];
+				const Mesh::sVertex& vertex1 = vertices[it->_index1];
+				const Mesh::sVertex& vertex2 = vertices[it->_index2];
+				Collision::ContactPoint points[8];
+				Math::Vector3 normal;
+				uint32_t pointCount = Collision::CollideOBBTriangle(i_box, Math::Vector3(vertex0.x, vertex0.y, vertex0.z),
+					Math::Vector3(vertex1.x, vertex1.y, vertex1.z), Math::Vector3(vertex2.x, vertex2.y, vertex2.z), points, normal);
+				for (uint32_t i = 0; i < pointCount; ++i)
+				{
+					_contactPoints.push_back(points[i]);
+					_contactNormals.push_back(normal);
+				}
+			}
+			if (!_contactPoints.empty())
+				Collision::BuildManifolds(_contactPoints, _contactNormals, o_manifolds);
+		}
+
 	}
 }
@@ -1,7 +1,9 @@
 #ifndef EAE_ENGINE_COLLISION_MESHCOLLIDER_H
 #define EAE_ENGINE_COLLISION_MESHCOLLIDER_H
 #include "ColliderBase.h"
+#include "ContinuousCollision.h"
 #include "Engine/Mesh/AOSMeshData.h"
+#include "Engine/SpatialPartition/Octree.h"
 
 
 namespace EAE_Engine
@@ -17,8 +19,29 @@ namespace EAE_Engine
 				Math::Vector3& o_collisionPoint, Math::Vector3& o_collisionNormal);
 			bool DetectCollision(Collider* i_pOther, float fElpasedTime, float& o_collisionTime, Math::Vector3& o_collisionAxis) 
 			{ return false; }
+			//the first hit of the segment from i_start to i_end on the mesh, o_t is in [0, 1] and o_normal is normalized.
+			//every triangle in the octree leaves along the segment is tested in place.
+			bool IntersectSegment(const Math::Vector3& i_start, const Math::Vector3& i_end, float& o_t,
+				Math::Vector3& o_hitPoint, Math::Vector3& o_normal);
+			//the first time the moving sphere touches the mesh, by the conservative advancement.
+			//only the triangles in the octree leaves overlapping the bounds of the motion are tested.
+			bool ComputeTimeOfImpact(const Collision::SphereMotion& i_motion, Collision::TimeOfImpact& o_toi);
+			//the contact manifolds of the box with the mesh, appended to o_manifolds, they point from the box to the mesh.
+			//only the triangles in the octree leaves overlapping the box are tested.
+			virtual void CollideOBB(const Math::OBB& i_box, std::vector<Collision::ContactManifold>& o_manifolds);
+			//the octree may be added after this Collider, so it is found here instead of by the tests on the workers.
+			virtual void PrepareForStep();
+			//the mesh doesn't move, so its bound found by Init is the bound of every step.
+			virtual Math::PackedAABB GetSweptAABB(float);
 		private:
 			Mesh::AOSMeshData* _pAOSMeshData;
+			Core::CompleteOctree* _pOctree;
+			//the bound of the vertices, which are world positions like in CollideOBB.
+			Math::PackedAABB _bounds;
+			//reused by CollideOBB, which is called for each box in each step.
+			std::vector<Mesh::TriangleIndex> _contactTriangles;
+			std::vector<Collision::ContactPoint> _contactPoints;
+			std::vector<Math::Vector3> _contactNormals;
 		};
 	}
 }
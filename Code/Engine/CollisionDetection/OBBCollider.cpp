@@ -1,8 +1,11 @@
 #include "OBBCollider.h"
+#include <algorithm>
+#include <cassert>
 #include <cmath>
 #include "Math/ColMatrix.h"
 #include "Math/Quaternion.h"
 #include "RigidBody.h"
+#include "CollisionDetectionFunctions.h"
 
 namespace EAE_Engine
 {
@@ -35,6 +38,87 @@ namespace EAE_Engine
 			return Contacting;
 		}
 
+		//If the boxes don't overlap on one axle during the whole step, CheckContacting will fail at the end,
+		//because the _sepTime is the min of all of the axles and the _overlapTime is the max of them.
+		//So this axle seperates them in this step.
+		inline bool SeperatedInThisStep(bool overlapOnAxle, const OverlapAndSepTime& resultOnAxle)
+		{
+			return !overlapOnAxle || resultOnAxle._sepTime <= 0.0f || resultOnAxle._overlapTime > 1.0f;
+		}
+
+
+		////////////////////////////////////////SATPairCache/////////////////////////////////////////
+		const uint32_t SATPairCache::s_noSeparatingAxis;
+
+		SATPairCacheEntry& SATPairCache::GetEntry(OBBCollider* pColliderA, OBBCollider* pColliderB)
+		{
+			assert(IsOwnerThread());
+			std::pair<OBBCollider*, OBBCollider*> key = pColliderA < pColliderB ?
+				std::make_pair(pColliderA, pColliderB) : std::make_pair(pColliderB, pColliderA);
+			std::unordered_map<std::pair<OBBCollider*, OBBCollider*>, SATPairCacheEntry, PairHash>::iterator it = _entries.find(key);
+			if (it != _entries.end())
+				return it->second;
+			_partners[key.first].push_back(key.second);
+			_partners[key.second].push_back(key.first);
+			SATPairCacheEntry entry;
+			entry._separatingAxis = s_noSeparatingAxis;
+			return _entries[key] = entry;
+		}
+
+		uint32_t SATPairCache::SwapAxis(uint32_t axis)
+		{
+			//the axes of A, the axes of B, then A[i] x B[j] at 6 + i * 3 + j.
+			if (axis < 3)
+				return axis + 3;
+			if (axis < 6)
+				return axis - 3;
+			if (axis < 15)
+			{
+				uint32_t i = (axis - 6) / 3;
+				uint32_t j = (axis - 6) % 3;
+				return 6 + j * 3 + i;
+			}
+			return axis;
+		}
+
+		void SATPairCache::RemoveCollider(OBBCollider* pCollider)
+		{
+			assert(IsOwnerThread());
+			std::unordered_map<OBBCollider*, std::vector<OBBCollider*>>::iterator it = _partners.find(pCollider);
+			if (it == _partners.end())
+				return;
+			for (std::vector<OBBCollider*>::iterator itPartner = it->second.begin(); itPartner != it->second.end(); ++itPartner)
+			{
+				OBBCollider* pPartner = *itPartner;
+				_entries.erase(pCollider < pPartner ? std::make_pair(pCollider, pPartner) : std::make_pair(pPartner, pCollider));
+				std::vector<OBBCollider*>& partnersOfPartner = _partners[pPartner];
+				std::vector<OBBCollider*>::iterator itSelf = std::find(partnersOfPartner.begin(), partnersOfPartner.end(), pCollider);
+				assert(itSelf != partnersOfPartner.end());
+				*itSelf = partnersOfPartner.back();
+				partnersOfPartner.pop_back();
+				if (partnersOfPartner.empty())
+					_partners.erase(pPartner);
+			}
+			_partners.erase(it);
+		}
+
+		void SATPairCache::Clear()
+		{
+			_entries.clear();
+			_partners.clear();
+			_ownerThread = std::thread::id();
+			ResetStatistics();
+		}
+
+		bool SATPairCache::IsOwnerThread()
+		{
+			if (_ownerThread == std::thread::id())
+				_ownerThread = std::this_thread::get_id();
+			return _ownerThread == std::this_thread::get_id();
+		}
+
+		////////////////////////////////////////OBBCollider/////////////////////////////////////////
+		SATPairCache OBBCollider::s_pairCache;
 
 		OBBCollider::OBBCollider() : Collider(),
 			_center(Math::Vector3::Zero), _size(Math::Vector3(1.f, 1.f, 1.f))
@@ -45,7 +129,9 @@ namespace EAE_Engine
 
 
 		OBBCollider::~OBBCollider()
-		{}
+		{
+			s_pairCache.RemoveCollider(this);
+		}
 
 		OBBCollider* OBBCollider::InitOBBCollider(Common::ITransform* pTrans, const Math::Vector3& size, const Math::Vector3& offset)
 		{
@@ -63,7 +149,8 @@ namespace EAE_Engine
 			o_collisionAxis = Math::Vector3::Zero;
 
 			//Do the collision detection based on the types on the Colliders.
-			if (i_pOther->IsSameType(HashedString("OBBCollider")))
+			static const HashedString s_obbColliderType("OBBCollider");
+			if (i_pOther->IsSameType(s_obbColliderType))
 			{
 				OBBCollider* pOBBCollider = reinterpret_cast<OBBCollider*>(i_pOther);
 				OverlapAndSepTime result;
@@ -76,10 +163,72 @@ namespace EAE_Engine
 			return false;
 		}
 
-		bool OBBCollider::CalculateOverlapSepTimeForSAT(OBBCollider& i_boxA, OBBCollider& i_boxB, Math::Vector3 relative_movementInASpace, const Math::Vector3& axle, OverlapAndSepTime& o_result)
+		bool OBBCollider::TestCollision(Common::IRigidBody* pTargetRB, float i_follisionTimeStep, float& o_tmin,
+			Math::Vector3& o_collisionPoint, Math::Vector3& o_collisionNormal)
 		{
-			float rangeOfBoxA = fabsf(i_boxA._size.x() * axle.x()) + fabsf(i_boxA._size.y()*axle.y()) + fabsf(i_boxA._size.z()*axle.z());
-			float rangeOfBoxB = fabsf(i_boxB._size.x() * axle.x()) + fabsf(i_boxB._size.y()*axle.y()) + fabsf(i_boxB._size.z()*axle.z());
+			Physics::RigidBody* pTargetRigidBody = static_cast<Physics::RigidBody*>(pTargetRB);
+			//the box of the RigidBody itself.
+			if (pTargetRigidBody->GetTransform() == _pTransform || !pTargetRigidBody->UseContinuousCollision())
+				return false;
+			//Continuous only works with the static boxes, ContinuousDynamic works with the moving boxes too.
+			Physics::RigidBody* pRB = static_cast<Physics::RigidBody*>(_pTransform->GetComponent(getTypeID<Physics::RigidBody>()));
+			if (pRB && pTargetRigidBody->GetCollisionDetectionMode() != Common::CollisionDetectionMode::ContinuousDynamic)
+				return false;
+			//advance in the space moving with this box, so the box stays still.
+			//the RigidBody of the box may be advancing in another island, so take its velocity at the start of the step.
+			Math::Vector3 boxVelocity = pRB ? pRB->GetStepVelocity() : Math::Vector3::Zero;
+			Collision::SphereMotion motion = pTargetRigidBody->GetMotion(i_follisionTimeStep);
+			motion._velocity = motion._velocity - boxVelocity;
+			const Math::OBB obb = GetWorldOBB();
+			Collision::TimeOfImpact toi;
+			bool collided = Collision::ConservativeAdvancement(motion, 1,
+				[&obb](uint32_t, const Math::Vector3& i_point) { return Collision::ClosestPtPointOBB(i_point, obb); }, toi);
+			if (!collided || toi._t >= o_tmin)
+				return false;
+			o_tmin = toi._t;
+			o_collisionPoint = toi._point + boxVelocity * (toi._t * i_follisionTimeStep);
+			o_collisionNormal = toi._normal;
+			return true;
+		}
+
+		Math::OBB OBBCollider::GetWorldOBB()
+		{
+			Math::ColMatrix44 rotateMatrix = Math::Quaternion::CreateColMatrix(_pTransform->GetRotation());
+			Math::OBB obb;
+			obb._pos = _pTransform->GetPos() + _center;
+			obb._extent = _size * 0.5f;
+			for (size_t i = 0; i < 3; ++i)
+				obb._axis[i] = rotateMatrix.GetCol(i);
+			return obb;
+		}
+
+		void OBBCollider::CollideOBB(const Math::OBB& i_box, std::vector<Collision::ContactManifold>& o_manifolds)
+		{
+			Collision::ContactManifold manifold;
+			if (Collision::CollideOBBOBB(i_box, GetWorldOBB(), manifold))
+				o_manifolds.push_back(manifold);
+		}
+
+		Math::PackedAABB OBBCollider::GetSweptAABB(float fElpasedTime)
+		{
+			Math::PackedAABB result = Math::ComputeAABB(Math::PackedOBB(GetWorldOBB()));
+			//Extend the box by the movement in this step.
+			Math::Vector3 movement = Math::Vector3::Zero;
+			Physics::RigidBody* pRB = static_cast<Physics::RigidBody*>(_pTransform->GetComponent(getTypeID<Physics::RigidBody>()));
+			if (pRB)
+				movement = pRB->GetVelocity() * fElpasedTime;
+			__m128 movementVec = Math::LoadVector3(movement);
+			__m128 zero = _mm_setzero_ps();
+			result.Set(_mm_add_ps(result.Min(), _mm_min_ps(movementVec, zero)), _mm_add_ps(result.Max(), _mm_max_ps(movementVec, zero)));
+			return result;
+		}
+
+		bool OBBCollider::CalculateOverlapSepTimeForSAT(OBBCollider& i_boxA, const Math::Vector3* i_uofA, OBBCollider& i_boxB, const Math::Vector3* i_uofB,
+			Math::Vector3 relative_movementInASpace, const Math::Vector3& axle, OverlapAndSepTime& o_result)
+		{
+			//project the sizes along the local axes of the boxes, the boxes are rotated.
+			float rangeOfBoxA = fabsf(i_boxA._size.x() * i_uofA[0].Dot(axle)) + fabsf(i_boxA._size.y() * i_uofA[1].Dot(axle)) + fabsf(i_boxA._size.z() * i_uofA[2].Dot(axle));
+			float rangeOfBoxB = fabsf(i_boxB._size.x() * i_uofB[0].Dot(axle)) + fabsf(i_boxB._size.y() * i_uofB[1].Dot(axle)) + fabsf(i_boxB._size.z() * i_uofB[2].Dot(axle));
 			rangeOfBoxA *= .5f;
 			rangeOfBoxB *= .5f;
 			float boxAProjOnAxle = (i_boxA._pTransform->GetPos() + i_boxA._center).Dot(axle);
@@ -124,54 +273,65 @@ namespace EAE_Engine
 
 		bool OBBCollider::DetectCollisionIn2OBBbySAT(OBBCollider& i_boxA, OBBCollider& i_boxB, float fElpasedTime, OverlapAndSepTime& collisionInfo)
 		{
+			SATPairCacheEntry& cacheEntry = s_pairCache.GetEntry(&i_boxA, &i_boxB);
+			//the axis in the cache is stored as if the min Collider were the box A.
+			const bool swapped = &i_boxB < &i_boxA;
 			//Get rotation Matrix, for the axis of the local coordinate
 			Math::Quaternion rorationBoxA = i_boxA._pTransform->GetRotation();
 			Math::Quaternion rorationBoxB = i_boxB._pTransform->GetRotation();
 			Math::ColMatrix44 boxARotateMatrix = Math::Quaternion::CreateColMatrix(rorationBoxA);
 			Math::ColMatrix44 boxBRotateMatrix = Math::Quaternion::CreateColMatrix(rorationBoxB);
-			// Get the Rotate&Transform Matrix
-			Math::ColMatrix44 boxATransMatrix = i_boxA._pTransform->GetRotateTransformMatrix();
-			Math::ColMatrix44 boxBTransMatrix = i_boxB._pTransform->GetRotateTransformMatrix();
-			//Calculate the movement in this frame.
-			Physics::RigidBody* pRBA = reinterpret_cast<Physics::RigidBody*>( i_boxA._pTransform->GetComponent(getTypeID<Physics::RigidBody>()) );
-			Math::Vector4 movementPerFrameA = pRBA->GetVelocity() * fElpasedTime;
-			Physics::RigidBody* pRBB = reinterpret_cast<Physics::RigidBody*>(i_boxB._pTransform->GetComponent(getTypeID<Physics::RigidBody>()) );
-			Math::Vector4 movementPerFrameB = pRBB->GetVelocity()  * fElpasedTime;
+			//Calculate the movement in this frame, the boxes without a RigidBody don't move.
+			Physics::RigidBody* pRigidBodyA = static_cast<Physics::RigidBody*>(i_boxA._pTransform->GetComponent(getTypeID<Physics::RigidBody>()));
+			Physics::RigidBody* pRigidBodyB = static_cast<Physics::RigidBody*>(i_boxB._pTransform->GetComponent(getTypeID<Physics::RigidBody>()));
+			Math::Vector4 movementPerFrameA = (pRigidBodyA ? pRigidBodyA->GetVelocity() : Math::Vector3::Zero) * fElpasedTime;
+			Math::Vector4 movementPerFrameB = (pRigidBodyB ? pRigidBodyB->GetVelocity() : Math::Vector3::Zero) * fElpasedTime;
 			Math::Vector3 relative_movementInA = (movementPerFrameB - movementPerFrameA);
 			//Get the local coordinate axes of the two OBB boxes.
 			Math::Vector3 uofA[3] = { boxARotateMatrix.GetCol(0), boxARotateMatrix.GetCol(1), boxARotateMatrix.GetCol(2) };
 			Math::Vector3 uofB[3] = { boxBRotateMatrix.GetCol(0), boxBRotateMatrix.GetCol(1), boxBRotateMatrix.GetCol(2) };
+			//for the SAT test in 3D, we need to test 15 axles:
+			//the local x-, y-, z- of boxA, the local x-, y-, z- of boxB, and the 9 cross axles of boxA and boxB.
+			Math::Vector3 axles[15];
+			for (size_t i = 0; i < 3; ++i)
+			{
+				axles[i] = uofA[i];
+				axles[i + 3] = uofB[i];
+				for (size_t j = 0; j < 3; ++j)
+					axles[i * 3 + j + 6] = uofA[i].Cross(uofB[j]);
+			}
 			//At first, we suppose that the collision may quit after we find out there is a seperation on one axle.
 			//So we set the collision time to FLT_MAX
 			collisionInfo._overlapTime = FLT_MAX;
 			collisionInfo._sepTime = FLT_MAX;
 			collisionInfo._collisionAxle = Math::Vector3::Zero;
-			OverlapAndSepTime resultOnAxles[15]; //for the SAT test in 3D, we need to test 15 axles.
-			//check the local x-, y-, z- of boxA as Seperating Axle.
-			for (size_t i = 0; i < 3; ++i)
+			OverlapAndSepTime resultOnAxles[15];
+			//the axle which seperated them in the last test usually still seperates them.
+			const uint32_t cachedAxle = swapped ? SATPairCache::SwapAxis(cacheEntry._separatingAxis) : cacheEntry._separatingAxis;
+			if (cachedAxle != SATPairCache::s_noSeparatingAxis)
 			{
-				bool collided = CalculateOverlapSepTimeForSAT(i_boxA, i_boxB, relative_movementInA, uofA[i], resultOnAxles[i]);
-				if (!collided)
+				bool collided = CalculateOverlapSepTimeForSAT(i_boxA, uofA, i_boxB, uofB, relative_movementInA, axles[cachedAxle], resultOnAxles[cachedAxle]);
+				bool seperated = SeperatedInThisStep(collided, resultOnAxles[cachedAxle]);
+				s_pairCache.CountTest(seperated);
+				if (seperated)
 					return false;
 			}
-			//check the local x-, y-, z- of boxB as Seperating Axle.
-			for (size_t i = 0; i < 3; ++i)
+			else
 			{
-				bool collided = CalculateOverlapSepTimeForSAT(i_boxA, i_boxB, relative_movementInA, uofB[i], resultOnAxles[i + 3]);
-				if (!collided)
-					return false;
+				s_pairCache.CountTest(false);
 			}
-			//check the cross axles of boxA and boxB, which has the extra 9 axles.
-			for (size_t i = 0; i < 3; ++i)
+			for (uint32_t index = 0; index < 15; ++index)
 			{
-				for (size_t j = 0; j < 3; ++j)
+				if (index == cachedAxle)
+					continue;
+				bool collided = CalculateOverlapSepTimeForSAT(i_boxA, uofA, i_boxB, uofB, relative_movementInA, axles[index], resultOnAxles[index]);
+				if (SeperatedInThisStep(collided, resultOnAxles[index]))
 				{
-					Math::Vector3 axle = uofA[i].Cross(uofB[j]);
-					bool collided = CalculateOverlapSepTimeForSAT(i_boxA, i_boxB, relative_movementInA, axle, resultOnAxles[i * 3 + j + 6]);
-					if (!collided)
-						return false;
+					cacheEntry._separatingAxis = swapped ? SATPairCache::SwapAxis(index) : index;
+					return false;
 				}
 			}
+			cacheEntry._separatingAxis = SATPairCache::s_noSeparatingAxis;
 			//Now we know that the collision should happened. So we need to get the correct range of the collisionInfo.
 			collisionInfo._overlapTime = -FLT_MAX;
 			collisionInfo._sepTime = FLT_MAX;
@@ -2,6 +2,8 @@
 #define EAEENGINE_OBBCOLLIDER_H
 
 #include "ColliderBase.h"
+#include <thread>
+#include <unordered_map>
 
 namespace EAE_Engine
 {
@@ -16,6 +18,57 @@ namespace EAE_Engine
 		};
 
 
+		class OBBCollider;
+
+		/*
+		 * Two boxes which were separated in the last step are usually still separated on the same axis,
+		 * so the SAT test remembers the separating axis of each pair and tests it first.
+		 * The pair is keyed by (min, max) of the 2 Colliders, so (A, B) and (B, A) share one entry,
+		 * and the axis is stored as if the min Collider were the box A.
+		 */
+		struct SATPairCacheEntry
+		{
+			//the index of the separating axis in the last test, in [0, 15), or s_noSeparatingAxis.
+			uint32_t _separatingAxis;
+		};
+
+		class SATPairCache
+		{
+		public:
+			static const uint32_t s_noSeparatingAxis = 0xffffffff;
+			SATPairCache() : _ownerThread(), _testCount(0), _earlyOutCount(0) {}
+			//the entry of the pair, it is created when the pair is tested at the first time.
+			SATPairCacheEntry& GetEntry(OBBCollider* pColliderA, OBBCollider* pColliderB);
+			//the index of the same axis after swapping the boxes A and B, the cross axes only flip their direction.
+			static uint32_t SwapAxis(uint32_t axis);
+			//forget all of the pairs with this Collider, should be called before the Collider is deleted.
+			void RemoveCollider(OBBCollider* pCollider);
+			void Clear();
+			inline size_t GetPairCount() const { return _entries.size(); }
+			//the statistics, how many tests exit after the test on the cached axis.
+			inline void CountTest(bool earlyOut) { ++_testCount; if (earlyOut) ++_earlyOutCount; }
+			inline uint32_t GetTestCount() const { return _testCount; }
+			inline uint32_t GetEarlyOutCount() const { return _earlyOutCount; }
+			inline void ResetStatistics() { _testCount = 0; _earlyOutCount = 0; }
+
+		private:
+			//the cache has no lock, so only the first thread using it may use it until the next Clear.
+			bool IsOwnerThread();
+			struct PairHash
+			{
+				size_t operator()(const std::pair<OBBCollider*, OBBCollider*>& i_pair) const
+				{
+					return std::hash<OBBCollider*>()(i_pair.first) ^ (std::hash<OBBCollider*>()(i_pair.second) * 31);
+				}
+			};
+			std::unordered_map<std::pair<OBBCollider*, OBBCollider*>, SATPairCacheEntry, PairHash> _entries;
+			//the other Colliders of the pairs of each Collider, so RemoveCollider only visits its own pairs.
+			std::unordered_map<OBBCollider*, std::vector<OBBCollider*>> _partners;
+			std::thread::id _ownerThread;
+			uint32_t _testCount;
+			uint32_t _earlyOutCount;
+		};
+
 		class OBBCollider: public Collider
 		{
 			OBBCollider(const OBBCollider& i_other) = delete;
@@ -25,10 +78,21 @@ namespace EAE_Engine
 			virtual ~OBBCollider();
 			OBBCollider* InitOBBCollider(Common::ITransform* pTrans, const Math::Vector3& size, const Math::Vector3& offset = Math::Vector3::Zero);
 			
+			//only the RigidBodys using the continuous collision detection are tested here, by the conservative advancement.
+			//the SAT test in DetectCollision only runs in ColliderManager::IterateAdvanceColliders, which is switched off,
+			//so the other RigidBodys only stop at this box when their own box meets it in the ContactSolver (CollideOBB).
 			virtual bool TestCollision(Common::IRigidBody* pTargetRB, float i_follisionTimeStep, float& o_firstCollisionTime,
-				Math::Vector3& o_collisionPoint, Math::Vector3& o_collisionNormal) { return false; }
+				Math::Vector3& o_collisionPoint, Math::Vector3& o_collisionNormal);
 			bool DetectCollision(Collider* i_pOther, float fElpasedTime, float& o_collisionTime, Math::Vector3& o_collisionAxis);
+			Math::PackedAABB GetSweptAABB(float fElpasedTime);
+			//the box in the world, the same box as the SAT test: _size is the whole size and the offset is not rotated.
+			Math::OBB GetWorldOBB();
+			//this box is static for the boxes of the ContactSolver, unless it is the box of one of their RigidBodys.
+			virtual void CollideOBB(const Math::OBB& i_box, std::vector<Collision::ContactManifold>& o_manifolds);
+			inline const Math::Vector3& GetSize() const { return _size; }
+			inline const Math::Vector3& GetOffset() const { return _center; }
 			static bool DetectCollisionIn2OBBbySAT(OBBCollider& i_boxA, OBBCollider& i_boxB, float fElpasedTime, OverlapAndSepTime& collisionInfo);
+			static SATPairCache& GetPairCache() { return s_pairCache; }
 		
 		private:
 			//Detect the Collision and Seperation time on the axle.
@@ -36,11 +100,17 @@ namespace EAE_Engine
 			static OverlapAndSepTime CalculateOverlapSepTimeForSAT(Engine::Math::Vector4 boxASize, const Math::Vector4& i_movementPerFrameA, const Math::Matrix44& i_ObjAtoWorld,
 															Engine::Math::Vector4 boxBSize, const Math::Vector4& i_movementPerFrameB, const Math::Matrix44& i_ObjBtoWorld,
 															Engine::Math::Vector3& axle);*/
-			static bool CalculateOverlapSepTimeForSAT(OBBCollider& i_boxA, OBBCollider& i_boxB, Math::Vector3 relative_movementInA, const Math::Vector3& axle, OverlapAndSepTime& o_result);
+			//i_uofA and i_uofB are the 3 local axes of the boxes in the world space.
+			static bool CalculateOverlapSepTimeForSAT(OBBCollider& i_boxA, const Math::Vector3* i_uofA, OBBCollider& i_boxB, const Math::Vector3* i_uofB,
+				Math::Vector3 relative_movementInA, const Math::Vector3& axle, OverlapAndSepTime& o_result);
 
 		private:
 			Math::Vector3 _size;  //the extents of the bounding box
 			Math::Vector3 _center;//center point, it is under the local coordinate
+			//shared by all of the boxes without a lock, it is only used on the calling thread:
+			//by ColliderManager::IterateAdvanceColliders and by the OBBColliders deleted there,
+			//the islands advancing on the WorkerPool only call TestCollision and CollideOBB.
+			static SATPairCache s_pairCache;
 		};
 
 
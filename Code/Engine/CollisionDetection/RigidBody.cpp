@@ -2,6 +2,9 @@
 #include "Time/Time.h"
 #include "General/MemoryOp.h"
 #include "ColliderBase.h"
+#include "OBBCollider.h"
+#include <algorithm>
+#include <thread>
 
 
 namespace EAE_Engine 
@@ -11,23 +14,32 @@ namespace EAE_Engine
 		Physics::Physics() : 
 			_pRigidBodyManager(nullptr), 
 			_gravity(Math::Vector3(0.f, -9.8f, 0.f)),
-			_accumulatTime(0.0f)
+			_accumulatTime(0.0f),
+			_pStaticBVH(nullptr)
 		{
 		}
 
 		Physics::~Physics() 
 		{ 
 			SAFE_DELETE(_pRigidBodyManager);
+			SAFE_DELETE(_pStaticBVH);
 		}
 
 		void Physics::Init() 
 		{
 			_pRigidBodyManager = new RigidBodyManager();
+			_pRigidBodyManager->SetWorkerCount(std::max(1u, std::thread::hardware_concurrency()));
 
       EAE_Engine::Core::CompleteOctree* pCompleteOctree = new EAE_Engine::Core::CompleteOctree();
       const char* const pathCollisionData = "data/Meshes/collisionData.aosmesh";
       pCompleteOctree->InitFromFile("data/Scene/CollisionOctree.octree", pathCollisionData);
-      EAE_Engine::Core::OctreeManager::GetInstance()->AddOctree(pCompleteOctree);
+      EAE_Engine::Core::OctreeManager::GetInstance()->AddOctree("Collision", pCompleteOctree);
+      _triangleCache.Build(pCompleteOctree);
+      _batchQuery.SetTriangleCache(&_triangleCache);
+      // MeshBuilder saves the BVH next to the mesh, build it from the mesh of the octree when the file is missing.
+      _pStaticBVH = new EAE_Engine::Core::BVH();
+      if (!_pStaticBVH->InitFromFile("data/Meshes/collisionData.bvh", pathCollisionData))
+        _pStaticBVH->Build(pCompleteOctree->GetCollisionMesh());
 		}
 
 		void Physics::FixedUpdateBegin()
@@ -45,6 +57,13 @@ namespace EAE_Engine
 			_pRigidBodyManager->FixedUpdateEnd();
 		}
 
+		void Physics::OnTransformMoved(Common::ITransform* pTransform)
+		{
+			RigidBody* pRigidBody = static_cast<RigidBody*>(pTransform->GetComponent(getTypeID<RigidBody>()));
+			if (pRigidBody)
+				pRigidBody->OnTransformMoved();
+		}
+
 		RigidBody* Physics::AddRigidBody(Common::ITransform* pTransform)
 		{ 
 			if (!_pRigidBodyManager)
@@ -52,9 +71,42 @@ namespace EAE_Engine
 			return _pRigidBodyManager->AddRigidBody(pTransform);
 		}
 
+		void Physics::SetWorkerCount(uint32_t workerCount)
+		{
+			if (_pRigidBodyManager)
+				_pRigidBodyManager->SetWorkerCount(workerCount);
+		}
+
+		ContactSolver* Physics::GetContactSolver()
+		{
+			if (!_pRigidBodyManager)
+				return nullptr;
+			return &_pRigidBodyManager->GetContactSolver();
+		}
+
+		void Physics::SetStaticBVH(Core::BVH* pBVH)
+		{
+			if (pBVH == _pStaticBVH)
+				return;
+			SAFE_DELETE(_pStaticBVH);
+			_pStaticBVH = pBVH;
+		}
+
+		uint32_t Physics::GetStateHash() const
+		{
+			if (!_pRigidBodyManager)
+				return 0;
+			return _pRigidBodyManager->GetStateHash();
+		}
+
     bool Physics::RayCast(Math::Vector3 origin, Math::Vector3 end, std::vector<Mesh::TriangleIndex>& o_triangles)
     {
       o_triangles.clear();
+      if (_pStaticBVH && _pStaticBVH->GetCollisionMesh())
+      {
+        _pStaticBVH->GetTrianlgesCollideWithSegment(origin, end, o_triangles);
+        return o_triangles.size() > 0;
+      }
       Core::CompleteOctree* pCompleteOctree = Core::OctreeManager::GetInstance()->GetOctree();
       assert(pCompleteOctree);
       pCompleteOctree->GetTrianlgesCollideWithSegment(origin, end, o_triangles);
@@ -69,22 +121,73 @@ namespace EAE_Engine
       bool result = RayCast(origin, end, o_triangles);
       if (!result)
         return false;
-      Core::CompleteOctree* pCompleteOctree = Core::OctreeManager::GetInstance()->GetOctree();
-      assert(pCompleteOctree);
-      Mesh::AOSMeshData* pCollisionMesh = pCompleteOctree->GetCollisionMesh();
+      Mesh::AOSMeshData* pCollisionMesh = nullptr;
+      if (_pStaticBVH && _pStaticBVH->GetCollisionMesh())
+        pCollisionMesh = _pStaticBVH->GetCollisionMesh();
+      else
+      {
+        Core::CompleteOctree* pCompleteOctree = Core::OctreeManager::GetInstance()->GetOctree();
+        assert(pCompleteOctree);
+        pCollisionMesh = pCompleteOctree->GetCollisionMesh();
+      }
       assert(pCollisionMesh);
       o_normal = pCollisionMesh->GetNormal(o_triangles[0]);
       return true;
     }
 
+    bool Physics::RayCast(Math::Vector3 origin, Math::Vector3 end, std::vector<Collider::Collider*>& o_colliders)
+    {
+      return Collider::ColliderManager::GetInstance()->RayCast(origin, end, o_colliders);
+    }
+
+    uint32_t Physics::RayCast(const Core::RayQuery* i_pQueries, uint32_t count, Core::QueryHit* o_pHits)
+    {
+      _batchQuery.SetOctree(Core::OctreeManager::GetInstance()->GetOctree());
+      assert(_batchQuery.GetOctree());
+      return _batchQuery.RayCast(i_pQueries, count, o_pHits);
+    }
+
+    uint32_t Physics::SphereCast(const Core::SphereCastQuery* i_pQueries, uint32_t count, Core::QueryHit* o_pHits)
+    {
+      _batchQuery.SetOctree(Core::OctreeManager::GetInstance()->GetOctree());
+      assert(_batchQuery.GetOctree());
+      return _batchQuery.SphereCast(i_pQueries, count, o_pHits);
+    }
+
+    uint32_t Physics::BoxCast(const Core::BoxCastQuery* i_pQueries, uint32_t count, Core::QueryHit* o_pHits)
+    {
+      _batchQuery.SetOctree(Core::OctreeManager::GetInstance()->GetOctree());
+      assert(_batchQuery.GetOctree());
+      return _batchQuery.BoxCast(i_pQueries, count, o_pHits);
+    }
+
+    void Physics::QueryRigidBodies(const Math::PackedAABB& i_aabb, std::vector<RigidBody*>& o_rigidBodies) const
+    {
+      o_rigidBodies.clear();
+      if (_pRigidBodyManager)
+        _pRigidBodyManager->QueryRigidBodies(i_aabb, o_rigidBodies);
+    }
+
 
 
 		/////////////////////////////////RigidBody/////////////////////////////////////
+		// 10m/s moves 0.17 in a step of 60Hz.
+		const float RigidBody::s_defaultContinuousSpeedThreshold = 10.0f;
+		// A RigidBody resting on a Collider is pushed out and falls back in each step,
+		// so its speed keeps changing between 0 and 2 * 9.8 * step, which is 0.33m/s at 60Hz.
+		const float RigidBody::s_sleepLinearSpeed = 0.5f;
+		const float RigidBody::s_sleepAngularSpeed = 0.1f;
+		const float RigidBody::s_timeToSleep = 0.5f;
+
 		RigidBody::RigidBody(Common::ITransform* pTransform) :
 			_pTransform(pTransform), _mode(Common::CollisionDetectionMode::Discrete),
+			_integrationMode(Common::IntegrationMode::Euler), _lastAcceleration(Math::Vector3::Zero), _lastTimeStep(0.0f),
+			_continuousSpeedThreshold(s_defaultContinuousSpeedThreshold), _radius(0.0f),
 			_currentVelocity(Math::Vector3::Zero), _angularVelocity(Math::Vector3::Zero),
 			_mass(1.0f), _useGravity(true), _outForceWorkingOn(Math::Vector3::Zero), _totalForceWorkingOn(Math::Vector3::Zero),
-			_lastVelocity(Math::Vector3::Zero)
+			_lastVelocity(Math::Vector3::Zero), _stepVelocity(Math::Vector3::Zero), _proxyId(Core::DynamicAABBTree::s_invalid), _bodyIndex(0),
+			_pManager(nullptr), _sleeping(false), _transformMoved(false), _sleepTime(0.0f),
+			_pBoxCollider(nullptr), _friction(0.5f), _restitution(0.0f)
 		{
 			_currentPos = pTransform->GetPos();
 			_lastPos = _currentPos;
@@ -98,6 +201,8 @@ namespace EAE_Engine
 
 		void RigidBody::AddForce(Math::Vector3& force, Common::ForceMode mode)
 		{
+			if (force.SqMagnitude() > 0.0f)
+				WakeUp();
 			switch (mode)
 			{
 			case Common::ForceMode::Force:
@@ -113,13 +218,81 @@ namespace EAE_Engine
 			
 		}
 
+		void RigidBody::SetBoxCollider(Collider::OBBCollider* pCollider)
+		{
+			assert(pCollider && _pBoxCollider == nullptr);
+			_pBoxCollider = pCollider;
+			// WakeUpTouchedBodies sees the box as the sphere around it.
+			_radius = (pCollider->GetSize() * 0.5f).Magnitude();
+			if (_pManager)
+				_pManager->_boxBodies.push_back(_bodyIndex);
+			WakeUp();
+		}
+
+		void RigidBody::WakeUp()
+		{
+			_sleepTime = 0.0f;
+			if (!_sleeping)
+				return;
+			_sleeping = false;
+			if (_pManager)
+				_pManager->_wokenBodies.push_back(_bodyIndex);
+		}
+
+		void RigidBody::OnTransformMoved()
+		{
+			// The awake RigidBodys read their Transforms in each FixedUpdateBegin anyway.
+			if (!_sleeping || _transformMoved || !_pManager)
+				return;
+			_transformMoved = true;
+			_pManager->_movedSleepers.push_back(_bodyIndex);
+		}
+
+		bool RigidBody::UpdateSleepTime(float timeStep)
+		{
+			if (_currentVelocity.SqMagnitude() > s_sleepLinearSpeed * s_sleepLinearSpeed ||
+				_angularVelocity.SqMagnitude() > s_sleepAngularSpeed * s_sleepAngularSpeed)
+			{
+				_sleepTime = 0.0f;
+				return false;
+			}
+			_sleepTime += timeStep;
+			return _sleepTime >= s_timeToSleep;
+		}
+
+		bool RigidBody::UseContinuousCollision() const
+		{
+			if (_mode == Common::CollisionDetectionMode::Discrete)
+				return false;
+			return _currentVelocity.SqMagnitude() > _continuousSpeedThreshold * _continuousSpeedThreshold;
+		}
+
+		Collision::SphereMotion RigidBody::GetMotion(float timeStep) const
+		{
+			Collision::SphereMotion motion;
+			motion._start = _currentPos;
+			motion._velocity = _currentVelocity;
+			motion._acceleration = _totalForceWorkingOn * (1.0f / _mass);
+			// The semi-implicit Euler moves on a line with the velocity at the end of the step.
+			if (_integrationMode == Common::IntegrationMode::SemiImplicitEuler)
+			{
+				motion._velocity = motion._velocity + motion._acceleration * timeStep;
+				motion._acceleration = Math::Vector3::Zero;
+			}
+			motion._radius = _radius;
+			motion._duration = timeStep;
+			return motion;
+		}
+
 		bool RigidBody::DetectionCollision(std::vector<Collider::Collider*>& colliderList, float timeStep, CollisionInfo& o_collisionInfo)
 		{
 			bool collided = false;
 			for (std::vector<Collider::Collider*>::iterator itCollider = colliderList.begin(); itCollider != colliderList.end(); ++itCollider)
 			{
 				Collider::Collider* pCollider = *itCollider;
-				collided = pCollider->TestCollision(this, timeStep, o_collisionInfo._mint, o_collisionInfo._collisionPoint, o_collisionInfo._collisionNormal);
+				// TestCollision only takes the hit earlier than o_collisionInfo._mint, so keep the result of any hit.
+				if (pCollider->TestCollision(this, timeStep, o_collisionInfo._mint, o_collisionInfo._collisionPoint, o_collisionInfo._collisionNormal))
+					collided = true;
 			}
 			return collided;
 		}
@@ -184,25 +357,65 @@ namespace EAE_Engine
 		Math::Vector3 RigidBody::PredictPosAfter(float timeStep)
 		{
 			Math::Vector3 acceleration = _totalForceWorkingOn * (1.0f / _mass);
+			if (_integrationMode == Common::IntegrationMode::SemiImplicitEuler)
+				return _currentPos + (_currentVelocity + acceleration * timeStep) * timeStep;
 			return _currentPos + _currentVelocity * timeStep + acceleration * (0.5f * timeStep * timeStep);
 		}
 
 		/*
-		 * We are using the Euler Integration at here:
-		 * Be careful that Euler Integration is only 100% accurate
-		 * if the rate of change is constant over the timestep.
-		 * Since we get the _forceWorkingOn during each FixedUpdate, 
-		 * we can assume the acceleration is not changing.
-		 * If the Acceleration is changing during the fixed deltaTime, 
-		 * we need to use other integration like "Runge Kutta order 4".
+		 * The force is only sampled once in each FixedUpdate, so the acceleration is constant during the step.
+		 * The Euler mode moves the RigidBody exactly along that parabola, 
+		 * but when the force depends on the position (like a spring applied by a Controller),
+		 * the velocity always takes the acceleration at the start of the step and the energy keeps growing.
+		 * The semi-implicit Euler moves with the new velocity instead, the energy stays bounded as long as
+		 * the step is shorter than 2 / omega of the fastest oscillation.
+		 * The Verlet mode moves like the Euler mode, but the velocity takes the average of the accelerations at both ends of the step,
+		 * it's the same path as the position Verlet x += (x - lastX) + a * dt * dt, with the velocity kept for the collision response.
+		 * The second half of the kick is added by CompleteVelocityVerlet once the force of the next step is known,
+		 * so between 2 FixedUpdates GetVelocity returns the same velocity as in the Euler mode.
 		 * For more: http://gafferongames.com/game-physics/integration-basics/
 		 */
 		void RigidBody::Response(Math::Vector3 force, float timeStep)
 		{
 			Math::Vector3 acceleration = force * (1.0f / _mass);
-			Math::Vector3 movement = _currentVelocity * timeStep + acceleration * (0.5f * timeStep * timeStep);;
-			_currentPos = _currentPos + movement;
-			_currentVelocity = _currentVelocity + acceleration * timeStep;
+			if (_integrationMode == Common::IntegrationMode::SemiImplicitEuler)
+			{
+				_currentVelocity = _currentVelocity + acceleration * timeStep;
+				_currentPos = _currentPos + _currentVelocity * timeStep;
+			}
+			else
+			{
+				Math::Vector3 movement = _currentVelocity * timeStep + acceleration * (0.5f * timeStep * timeStep);
+				_currentPos = _currentPos + movement;
+				_currentVelocity = _currentVelocity + acceleration * timeStep;
+				// Not the force left after a collision took away its part along the normal,
+				// CompleteVelocityVerlet compares it with the whole force of the next step.
+				_lastAcceleration = _outForceWorkingOn * (1.0f / _mass);
+				_lastTimeStep = timeStep;
+			}
+			IntegrateSpin(timeStep);
+		}
+
+		void RigidBody::CompleteVelocityVerlet()
+		{
+			if (_integrationMode != Common::IntegrationMode::Verlet || _lastTimeStep == 0.0f)
+				return;
+			Math::Vector3 acceleration = _totalForceWorkingOn * (1.0f / _mass);
+			_currentVelocity += (acceleration - _lastAcceleration) * (0.5f * _lastTimeStep);
+			_lastTimeStep = 0.0f;
+		}
+
+		/*
+		 * There is no torque, so the angular velocity is constant 
+		 * and _spin can be rotated by it exactly instead of adding the derivative 0.5 * w * _spin, which drifts.
+		 */
+		void RigidBody::IntegrateSpin(float timeStep)
+		{
+			const float speed = _angularVelocity.Magnitude();
+			if (speed < 1.0e-6f)
+				return;
+			_spin = Math::Quaternion(speed * timeStep, _angularVelocity * (1.0f / speed)) * _spin;
+			_spin.Normalize();
 		}
 
 		/*
@@ -217,10 +430,16 @@ namespace EAE_Engine
 	//		_currentVelocity = _lastVelocity * (1.0f - blendAlpha) + _currentVelocity * blendAlpha;
 	//		_currentPos = _lastPos * (1.0f - blendAlpha) + _currentPos * blendAlpha;
 			_pTransform->SetPos(_currentPos);
+			if (_angularVelocity.SqMagnitude() > 0.0f)
+				_pTransform->SetRotation(_spin);
 		}
 
 		////////////////////////////////////////RigidBodyManager////////////////////////////////////////
 
+		RigidBodyManager::RigidBodyManager() :
+			_candidateColliders(1)
+		{}
+
 		RigidBodyManager::~RigidBodyManager() 
 		{
 			for (std::vector<RigidBody*>::iterator it = _rigidBodys.begin(); it != _rigidBodys.end();)
@@ -234,7 +453,12 @@ namespace EAE_Engine
 		RigidBody* RigidBodyManager::AddRigidBody(Common::ITransform* pTransform)
 		{
 			RigidBody* pRigidBody = new RigidBody(pTransform);
+			pRigidBody->_bodyIndex = (uint32_t)_rigidBodys.size();
+			pRigidBody->_pManager = this;
+			_awakeBodies.push_back(pRigidBody->_bodyIndex);
 			_rigidBodys.push_back(pRigidBody);
+			Math::Vector3 pos = pRigidBody->GetPos();
+			pRigidBody->_proxyId = _rigidBodyTree.CreateProxy(Math::PackedAABB(pos, pos), pRigidBody);
 			return pRigidBody;
 		}
 
@@ -252,36 +476,247 @@ namespace EAE_Engine
 
 		void RigidBodyManager::FixedUpdateBegin()
 		{
-			for (std::vector<RigidBody*>::iterator it = _rigidBodys.begin(); it != _rigidBodys.end(); ++it)
+			// Only the sleepers moved by someone else are looked at, the others keep the positions they fell asleep at.
+			const float epsilon = 1.0e-6f;
+			for (std::vector<uint32_t>::const_iterator it = _movedSleepers.begin(); it != _movedSleepers.end(); ++it)
+			{
+				RigidBody* pRB = _rigidBodys[*it];
+				pRB->_transformMoved = false;
+				if (!pRB->_sleeping)
+					continue;
+				Math::Vector3 pos = pRB->GetTransform()->GetPos();
+				if ((pos - pRB->_currentPos).SqMagnitude() > epsilon * epsilon)
+					pRB->SetPos(pos);
+			}
+			_movedSleepers.clear();
+			AddWokenBodies();
+			for (std::vector<uint32_t>::const_iterator it = _awakeBodies.begin(); it != _awakeBodies.end(); ++it)
 			{
-				RigidBody* pRB = (*it);
-				pRB->SetPos(pRB->GetTransform()->GetPos());
+				RigidBody* pRB = _rigidBodys[*it];
+				Math::Vector3 pos = pRB->GetTransform()->GetPos();
+				pRB->_currentPos = pos;
+				pRB->_lastPos = pos;
+				// The rotation only changes here when the RigidBody spins.
+				if (pRB->_angularVelocity.SqMagnitude() > 0.0f)
+					pRB->_spin = pRB->GetTransform()->GetRotation();
 			}
 		}
 
+		void RigidBodyManager::SetWorkerCount(uint32_t workerCount)
+		{
+			_workerPool.SetWorkerCount(workerCount);
+			_candidateColliders.resize(_workerPool.GetWorkerCount());
+		}
+
 		void RigidBodyManager::FixedUpdate()
 		{
 			float fixedTimeStep = Time::GetFixedTimeStep();
-			std::vector<Collider::Collider*>& colliderList = Collider::ColliderManager::GetInstance()->GetColliderList();
-			for (std::vector<RigidBody*>::iterator itRB = _rigidBodys.begin(); itRB != _rigidBodys.end(); ++itRB)
+			Math::Vector3 gravity = Physics::GetInstance()->GetGravity();
+			AddWokenBodies();
+			const size_t count = _awakeBodies.size();
+			_pathAABBs.resize(count);
+			for (size_t index = 0; index < count; ++index)
 			{
-				RigidBody* pRB = *itRB;
+				RigidBody* pRB = _rigidBodys[_awakeBodies[index]];
 				// Update the previous state
 				pRB->_lastPos = pRB->_currentPos;
 				pRB->_lastVelocity = pRB->_currentVelocity;
 				if (pRB->_useGravity)
-					pRB->_outForceWorkingOn = pRB->_outForceWorkingOn + Physics::GetInstance()->GetGravity() * pRB->_mass;
+					pRB->_outForceWorkingOn = pRB->_outForceWorkingOn + gravity * pRB->_mass;
+				pRB->_totalForceWorkingOn = pRB->_outForceWorkingOn;
+				pRB->CompleteVelocityVerlet();
+				pRB->_stepVelocity = pRB->_currentVelocity;
+				// The swept sphere of the whole step, with the radius and the apex of the parabola.
+				Math::Vector3 pathMin, pathMax;
+				pRB->GetMotion(fixedTimeStep).GetBounds(pathMin, pathMax);
+				_pathAABBs[index] = Math::PackedAABB(pathMin, pathMax);
+			}
+			BuildIslands();
+			Collider::ColliderManager::GetInstance()->PrepareForStep();
+			_workerPool.Run(GetIslandCount(), [this, fixedTimeStep](uint32_t islandIndex, uint32_t workerIndex)
+			{
+				AdvanceIsland(islandIndex, workerIndex, fixedTimeStep);
+			});
+			if (!_boxBodies.empty())
+				_contactSolver.Step(_rigidBodys, _boxBodies, fixedTimeStep);
+			// Put the slow RigidBodys to sleep, and let the moving ones wake up the sleeping RigidBodys they touch.
+			size_t awakeCount = 0;
+			for (size_t index = 0; index < count; ++index)
+			{
+				RigidBody* pRB = _rigidBodys[_awakeBodies[index]];
+				Math::PackedAABB path = Math::Union(Math::PackedAABB(pRB->_lastPos, pRB->_lastPos), pRB->_currentPos);
+				_rigidBodyTree.MoveProxy(pRB->_proxyId, path);
+				if (pRB->UpdateSleepTime(fixedTimeStep))
+				{
+					pRB->_sleeping = true;
+					pRB->_currentVelocity = Math::Vector3::Zero;
+					pRB->_lastVelocity = Math::Vector3::Zero;
+					pRB->_stepVelocity = Math::Vector3::Zero;
+					pRB->_lastTimeStep = 0.0f;
+					// FixedUpdateEnd skips the sleeping RigidBodys.
+					pRB->BlendForTimeGap(1.0f);
+					pRB->_angularVelocity = Math::Vector3::Zero;
+					continue;
+				}
+				// A slow RigidBody doesn't wake up the others, or 2 RigidBodys resting side by side keep waking up each other.
+				if (pRB->_sleepTime == 0.0f)
+					WakeUpTouchedBodies(path, pRB->_radius);
+				_awakeBodies[awakeCount++] = _awakeBodies[index];
+			}
+			if (awakeCount != count)
+			{
+				_awakeBodies.resize(awakeCount);
+				_sortedBodies.clear();
+			}
+		}
+
+		void RigidBodyManager::AddWokenBodies()
+		{
+			if (_wokenBodies.empty())
+				return;
+			std::sort(_wokenBodies.begin(), _wokenBodies.end());
+			const size_t middle = _awakeBodies.size();
+			_awakeBodies.insert(_awakeBodies.end(), _wokenBodies.begin(), _wokenBodies.end());
+			std::inplace_merge(_awakeBodies.begin(), _awakeBodies.begin() + middle, _awakeBodies.end());
+			_wokenBodies.clear();
+			_sortedBodies.clear();
+		}
+
+		void RigidBodyManager::WakeUpTouchedBodies(const Math::PackedAABB& i_path, float i_radius)
+		{
+			const Math::Vector3 radius(i_radius, i_radius, i_radius);
+			const Math::AABBV1 path = i_path.ToAABBV1();
+			const Math::PackedAABB aabb(path._min - radius, path._max + radius);
+			_rigidBodyTree.QueryAABB(aabb, [this, &aabb](uint32_t proxyId)
+			{
+				RigidBody* pOther = reinterpret_cast<RigidBody*>(_rigidBodyTree.GetUserData(proxyId));
+				if (!pOther->_sleeping)
+					return true;
+				// The fat AABB in the tree is larger than the RigidBody.
+				const Math::Vector3 otherRadius(pOther->_radius, pOther->_radius, pOther->_radius);
+				if (Math::TestAABBAABB(aabb, Math::PackedAABB(pOther->_currentPos - otherRadius, pOther->_currentPos + otherRadius)))
+					pOther->WakeUp();
+				return true;
+			});
+		}
+
+		/*
+		 * The RigidBodys only collide with the Colliders now. TestCollision doesn't write the Colliders after PrepareForStep,
+		 * and it only reads the GetStepVelocity of the RigidBodys of the other islands, which doesn't change during the step,
+		 * so the contact graph only links the RigidBodys whose paths of this step overlap.
+		 * The paths are sorted by their min x and swept once (sweep and prune),
+		 * the order of the last step is almost sorted, so the insertion sort is nearly O(n).
+		 * The islands are ordered by their smallest RigidBody index, and the RigidBodys of an island by their index.
+		 */
+		void RigidBodyManager::BuildIslands()
+		{
+			const uint32_t count = (uint32_t)_awakeBodies.size();
+			_islandParents.resize(count);
+			for (uint32_t index = 0; index < count; ++index)
+				_islandParents[index] = index;
+			if (_sortedBodies.size() != count)
+			{
+				// The awake RigidBodys have changed, the last order doesn't help.
+				_sortedBodies.resize(count);
+				for (uint32_t index = 0; index < count; ++index)
+					_sortedBodies[index] = index;
+				std::sort(_sortedBodies.begin(), _sortedBodies.end(), [this](uint32_t i_a, uint32_t i_b)
+				{
+					return _pathAABBs[i_a]._min[0] < _pathAABBs[i_b]._min[0];
+				});
+			}
+			else
+			{
+				for (size_t i = 1; i < count; ++i)
+				{
+					uint32_t index = _sortedBodies[i];
+					float key = _pathAABBs[index]._min[0];
+					size_t j = i;
+					for (; j > 0 && _pathAABBs[_sortedBodies[j - 1]]._min[0] > key; --j)
+						_sortedBodies[j] = _sortedBodies[j - 1];
+					_sortedBodies[j] = index;
+				}
+			}
+			for (size_t i = 0; i < count; ++i)
+			{
+				const uint32_t index = _sortedBodies[i];
+				const float max = _pathAABBs[index]._max[0];
+				for (size_t j = i + 1; j < count && _pathAABBs[_sortedBodies[j]]._min[0] <= max; ++j)
+				{
+					const uint32_t other = _sortedBodies[j];
+					if (!Math::TestAABBAABB(_pathAABBs[index], _pathAABBs[other]))
+						continue;
+					uint32_t root = FindIslandRoot(index);
+					uint32_t otherRoot = FindIslandRoot(other);
+					if (root < otherRoot)
+						_islandParents[otherRoot] = root;
+					else if (otherRoot < root)
+						_islandParents[root] = otherRoot;
+				}
+			}
+			// A parent always has a smaller index, so after this loop the parent of each RigidBody is its root.
+			for (uint32_t index = 0; index < count; ++index)
+				_islandParents[index] = _islandParents[_islandParents[index]];
+			// Number the islands in the order of their roots, from now on the parent is the island of the RigidBody.
+			_islandStarts.clear();
+			_islandStarts.push_back(0);
+			for (uint32_t index = 0; index < count; ++index)
+			{
+				uint32_t root = _islandParents[index];
+				if (root == index)
+				{
+					_islandParents[index] = (uint32_t)_islandStarts.size() - 1;
+					_islandStarts.push_back(0);
+				}
+				else
+				{
+					_islandParents[index] = _islandParents[root];
+				}
+				++_islandStarts[_islandParents[index] + 1];
+			}
+			for (size_t island = 1; island < _islandStarts.size(); ++island)
+				_islandStarts[island] += _islandStarts[island - 1];
+			_islandBodies.resize(count);
+			std::vector<uint32_t> next(_islandStarts.begin(), _islandStarts.end() - 1);
+			for (uint32_t index = 0; index < count; ++index)
+				_islandBodies[next[_islandParents[index]]++] = index;
+		}
+
+		uint32_t RigidBodyManager::FindIslandRoot(uint32_t bodyIndex)
+		{
+			while (_islandParents[bodyIndex] != bodyIndex)
+			{
+				// Path halving
+				_islandParents[bodyIndex] = _islandParents[_islandParents[bodyIndex]];
+				bodyIndex = _islandParents[bodyIndex];
+			}
+			return bodyIndex;
+		}
+
+		void RigidBodyManager::AdvanceIsland(uint32_t islandIndex, uint32_t workerIndex, float fixedTimeStep)
+		{
+			Collider::ColliderManager* pColliderManager = Collider::ColliderManager::GetInstance();
+			std::vector<Collider::Collider*>& candidateColliders = _candidateColliders[workerIndex];
+			for (uint32_t i = _islandStarts[islandIndex]; i < _islandStarts[islandIndex + 1]; ++i)
+			{
+				const uint32_t index = _islandBodies[i];
+				RigidBody* pRB = _rigidBodys[_awakeBodies[index]];
+				// The ContactSolver moves it later.
+				if (pRB->_pBoxCollider)
+					continue;
+				// Only the Colliders near the path of this step can be hit.
+				pColliderManager->QueryColliders(_pathAABBs[index], candidateColliders);
 				// Detection the collision 
 				int io_testDepth = 0;
-				bool hasCollisionSolution = pRB->Advance(colliderList, fixedTimeStep, io_testDepth);
+				bool hasCollisionSolution = pRB->Advance(candidateColliders, fixedTimeStep, io_testDepth);
 				if (!hasCollisionSolution) 
 				{
-					pRB->SetPos(pRB->_lastPos);
+					// not SetPos, which resets the sleep time.
+					pRB->_currentPos = pRB->_lastPos;
 				}
 				// reset the force working on this RigidBody
 				pRB->_outForceWorkingOn = Math::Vector3::Zero;
 			}
-
 		}
 
 		/*
@@ -290,10 +725,39 @@ namespace EAE_Engine
 		void RigidBodyManager::FixedUpdateEnd()
 		{
 			float timeBlendAlpha = Time::GetFixedUpdateBlendAlphaOnThisFrame();
-			for (std::vector<RigidBody*>::iterator it = _rigidBodys.begin(); it != _rigidBodys.end(); ++it)
+			for (std::vector<uint32_t>::iterator it = _awakeBodies.begin(); it != _awakeBodies.end(); ++it)
+			{
+				_rigidBodys[*it]->BlendForTimeGap(timeBlendAlpha);
+			}
+		}
+
+		void RigidBodyManager::QueryRigidBodies(const Math::PackedAABB& i_aabb, std::vector<RigidBody*>& o_rigidBodies) const
+		{
+			_rigidBodyTree.QueryAABB(i_aabb, [this, &o_rigidBodies](uint32_t proxyId)
 			{
-				(*it)->BlendForTimeGap(timeBlendAlpha);
+				o_rigidBodies.push_back(reinterpret_cast<RigidBody*>(_rigidBodyTree.GetUserData(proxyId)));
+				return true;
+			});
+		}
+
+		// FNV-1a of the raw bits, so the hash changes when any bit of the state is different.
+		uint32_t RigidBodyManager::GetStateHash() const
+		{
+			uint32_t hash = 2166136261u;
+			for (std::vector<RigidBody*>::const_iterator it = _rigidBodys.begin(); it != _rigidBodys.end(); ++it)
+			{
+				const Math::Vector3* states[] = { &(*it)->_currentPos, &(*it)->_currentVelocity };
+				for (size_t i = 0; i < sizeof(states) / sizeof(states[0]); ++i)
+				{
+					const uint8_t* pBytes = reinterpret_cast<const uint8_t*>(states[i]->_u);
+					for (size_t byteIndex = 0; byteIndex < sizeof(float) * 3; ++byteIndex)
+					{
+						hash ^= pBytes[byteIndex];
+						hash *= 16777619u;
+					}
+				}
 			}
+			return hash;
 		}
 
 	}
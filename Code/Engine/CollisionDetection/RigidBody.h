@@ -6,7 +6,14 @@
 #include "Engine/Math/Quaternion.h"
 #include "Engine/General/Singleton.hpp"
 #include "Engine/General/EngineObj.h"
+#include "Engine/General/WorkerPool.h"
 #include "Engine/SpatialPartition/Octree.h"
+#include "Engine/SpatialPartition/BVH.h"
+#include "Engine/SpatialPartition/DynamicAABBTree.h"
+#include "Engine/SpatialPartition/OctreeBatchQuery.h"
+#include "Engine/SpatialPartition/CollisionTriangleCache.h"
+#include "ContinuousCollision.h"
+#include "ContactSolver.h"
 #include <vector>
 
 namespace EAE_Engine 
@@ -14,6 +21,7 @@ namespace EAE_Engine
 	namespace Collider
 	{
 		class Collider;
+		class OBBCollider;
 	}
 
 	namespace Physics 
@@ -33,43 +41,121 @@ namespace EAE_Engine
       bool RayCast(Math::Vector3 origin, Math::Vector3 end, std::vector<Mesh::TriangleIndex>& o_triangles, Math::Vector3& o_normal);
    //   bool RayCast(Math::Vector3 origin, Math::Vector3 end, std::vector<Mesh::TriangleIndex>& o_triangles, 
    //     Math::Vector3& o_normal, Math::Vector3& o_hitPoint);
+      // The Colliders whose bounds are hit by the segment, the octree above only has the static collision mesh.
+      bool RayCast(Math::Vector3 origin, Math::Vector3 end, std::vector<Collider::Collider*>& o_colliders);
+      // Batched casts against the collision octree, o_pHits[i] is the first hit of i_pQueries[i].
+      // Returns the count of the queries which hit. Call them from the main thread only, they share a scratch buffer.
+      uint32_t RayCast(const Core::RayQuery* i_pQueries, uint32_t count, Core::QueryHit* o_pHits);
+      uint32_t SphereCast(const Core::SphereCastQuery* i_pQueries, uint32_t count, Core::QueryHit* o_pHits);
+      uint32_t BoxCast(const Core::BoxCastQuery* i_pQueries, uint32_t count, Core::QueryHit* o_pHits);
+      void QueryRigidBodies(const Math::PackedAABB& i_aabb, std::vector<RigidBody*>& o_rigidBodies) const;
+			// The count of threads (the calling thread included) which advance the islands of RigidBodys in FixedUpdate.
+			void SetWorkerCount(uint32_t workerCount);
 			RigidBody* AddRigidBody(Common::ITransform* pTransform);
+			// The Transform has been moved by someone else, a sleeping RigidBody on it follows it at the next FixedUpdateBegin.
+			void OnTransformMoved(Common::ITransform* pTransform);
+			// the solver of the RigidBodys with a box, nullptr before Init.
+			ContactSolver* GetContactSolver();
+      // The triangle RayCasts use the BVH of the collision mesh when there is one, or the octree.
+      // The Physics owns the BVH, SetStaticBVH(nullptr) makes them use the octree again.
+      void SetStaticBVH(Core::BVH* pBVH);
+      Core::BVH* GetStaticBVH() const { return _pStaticBVH; }
 			Math::Vector3 GetGravity() { return _gravity; }
+			// Hash of the position and velocity of all of the rigid bodies,
+			// compare it to check whether a replay gives the same result as the recorded one.
+			uint32_t GetStateHash() const;
 
 		private:
 			RigidBodyManager* _pRigidBodyManager;
 			Math::Vector3 _gravity;
 			float _accumulatTime;
       Core::CompleteOctree* _pCompleteOctreeTree;
+      Core::OctreeBatchQuery _batchQuery;
+      // The packed triangles of the leaves of the collision octree for the batched RayCasts, built once in Init.
+      Core::CollisionTriangleCache _triangleCache;
+      Core::BVH* _pStaticBVH;
 		};
 
 
 		class RigidBody : public Reflection<RigidBody>, public Common::IRigidBody
 		{
 		public:
+			static const float s_defaultContinuousSpeedThreshold;
+			// The RigidBody falls asleep after it stays slower than these speeds for s_timeToSleep.
+			static const float s_sleepLinearSpeed;
+			static const float s_sleepAngularSpeed;
+			static const float s_timeToSleep;
 			RigidBody(Common::ITransform* pTransform);
 			~RigidBody();
 			Common::ICompo* GetComponent(typeid_t type) { return _pTransform->GetComponent(type); }
 			Common::ITransform* GetTransform() { return _pTransform; }
 			Math::Vector3 GetVelocity() const { return _currentVelocity; }
+			// The velocity at the start of this FixedUpdate, it doesn't change while the RigidBodys advance in parallel,
+			// so the Colliders read it instead of GetVelocity of the RigidBodys in the other islands.
+			Math::Vector3 GetStepVelocity() const { return _stepVelocity; }
 			void SetVelocity(const Math::Vector3& velocity) 
 			{
 				_currentVelocity = velocity; 
 				_lastVelocity = velocity;
+				_lastTimeStep = 0.0f;
+				WakeUp();
 			}
 			Math::Vector3 GetPos() const { return _currentPos; }
 			void SetPos(const Math::Vector3& pos) 
 			{ 
 				_currentPos = pos; 
 				_lastPos = pos;
+				WakeUp();
 			}
-			//Math::Quaternion GetRotation();
+			Math::Quaternion GetRotation() const { return _spin; }
 			//void SetRotation(Math::Quaternion& rotation);
+			// in radians per second around the world axes.
+			Math::Vector3 GetAngularVelocity() const { return _angularVelocity; }
+			void SetAngularVelocity(const Math::Vector3& angularVelocity)
+			{
+				_angularVelocity = angularVelocity;
+				WakeUp();
+			}
 			float GetMass() const { return _mass; }
 			void SetMass(float mass) { _mass = mass; }
 			bool useGravity() { return _useGravity; }
+			void SetUseGravity(bool useGravity) { _useGravity = useGravity; }
 			void SetCollisionDetectionMode(Common::CollisionDetectionMode mode) { _mode = mode; }
 			Common::CollisionDetectionMode GetCollisionDetectionMode() const { return _mode; }
+			void SetIntegrationMode(Common::IntegrationMode mode)
+			{
+				_integrationMode = mode;
+				_lastTimeStep = 0.0f;
+			}
+			Common::IntegrationMode GetIntegrationMode() const { return _integrationMode; }
+			// In the continuous modes, the RigidBody faster than this uses the conservative advancement instead of the segment test.
+			void SetContinuousSpeedThreshold(float speed) { _continuousSpeedThreshold = speed; }
+			float GetContinuousSpeedThreshold() const { return _continuousSpeedThreshold; }
+			bool UseContinuousCollision() const;
+			// The RigidBody is a sphere of this radius in the continuous collision detection, 0 for a point.
+			void SetRadius(float radius) { _radius = radius; }
+			float GetRadius() const { return _radius; }
+			// The motion during the next timeStep, the same as PredictPosAfter.
+			Collision::SphereMotion GetMotion(float timeStep) const;
+			// The RigidBody with a box is simulated by the ContactSolver instead of Advance:
+			// it is stopped by the other boxes and the Colliders at up to 4 points of each contact, so it rotates and rests on its faces.
+			// The box should be an OBBCollider on the same Transform, and the RigidBody can't be a point again.
+			void SetBoxCollider(Collider::OBBCollider* pCollider);
+			Collider::OBBCollider* GetBoxCollider() const { return _pBoxCollider; }
+			// The ContactSolver takes the square root of the product of the 2 frictions and the larger restitution.
+			// The Colliders have neither of them, so the RigidBody's own values are used against them.
+			void SetFriction(float friction) { _friction = friction; }
+			float GetFriction() const { return _friction; }
+			void SetRestitution(float restitution) { _restitution = restitution; }
+			float GetRestitution() const { return _restitution; }
+			// A sleeping RigidBody isn't advanced, tested or moved in the DynamicAABBTree until it wakes up.
+			// It wakes up when a force or a velocity is applied, its Transform is moved,
+			// or the path of an awake RigidBody touches it.
+			bool IsSleeping() const { return _sleeping; }
+			void WakeUp();
+			// Tell the sleeping RigidBody that someone else has moved its Transform, it follows the Transform at the next FixedUpdateBegin.
+			// FixedUpdateBegin doesn't look at the Transforms of the other sleepers.
+			void OnTransformMoved();
 			void AddForce(Math::Vector3& force, Common::ForceMode mode = Common::ForceMode::Force);
 			bool Advance(std::vector<Collider::Collider*>& i_colliderList, float i_timeStep, int& io_testDepth);
 			void BlendForTimeGap(float blendAlpha);
@@ -86,7 +172,13 @@ namespace EAE_Engine
 
 			bool DetectionCollision(std::vector<Collider::Collider*>& colliderList, float timeStep, CollisionInfo& o_collisionInfo);
 			void Response(Math::Vector3 force, float timeStep);
+			void IntegrateSpin(float timeStep);
+			// In the Verlet mode, add the second half of the kick of the last step, which needs the acceleration of this step.
+			void CompleteVelocityVerlet();
+			// Returns true when the RigidBody has been slow for s_timeToSleep after this step.
+			bool UpdateSleepTime(float timeStep);
 			friend class RigidBodyManager;
+			friend class ContactSolver;
 		private:
 			Common::ITransform* _pTransform;
 			// for RigidBody's Pos and Rotation, they only have world value.
@@ -97,30 +189,103 @@ namespace EAE_Engine
 
 			Math::Vector3 _lastPos;
 			Math::Vector3 _lastVelocity;
+			Math::Vector3 _stepVelocity;
 
 			float _mass;
 			Common::CollisionDetectionMode _mode;
+			Common::IntegrationMode _integrationMode;
+			// the acceleration of the applied forces and the duration of the last Response, 0 duration when there is no kick to complete.
+			Math::Vector3 _lastAcceleration;
+			float _lastTimeStep;
+			float _continuousSpeedThreshold;
+			float _radius;
 			bool _useGravity;
+			Collider::OBBCollider* _pBoxCollider;
+			float _friction;
+			float _restitution;
 			
 
 			Math::Vector3 _outForceWorkingOn;
 			Math::Vector3 _totalForceWorkingOn;
+			// the proxy in the DynamicAABBTree of the RigidBodyManager.
+			uint32_t _proxyId;
+			// the index in the RigidBodyManager, used to group the RigidBodys into islands.
+			uint32_t _bodyIndex;
+			RigidBodyManager* _pManager;
+			bool _sleeping;
+			// true while the RigidBody is in the list of the moved sleepers of its RigidBodyManager.
+			bool _transformMoved;
+			// how long the RigidBody has been slower than the sleep speeds.
+			float _sleepTime;
 		};
 
 
+		/*
+		 * The RigidBodys whose paths of this step may touch each other are grouped into an island,
+		 * so the islands are independent and FixedUpdate advances them in parallel on the WorkerPool.
+		 * Each RigidBody only writes its own state during the parallel part,
+		 * and the DynamicAABBTree is only updated after it in the order of the RigidBodys,
+		 * so the result is the same with any count of workers.
+		 * Only the awake RigidBodys are advanced, the sleeping ones stay in the DynamicAABBTree
+		 * without being moved, so the awake RigidBodys can find and wake them up.
+		 * The RigidBodys with a box are in the islands too, but they are skipped there
+		 * and solved together by the ContactSolver after the islands, on the calling thread.
+		 */
 		class RigidBodyManager
 		{
 		public:
+			RigidBodyManager();
 			~RigidBodyManager();
 			RigidBody* AddRigidBody(Common::ITransform* pTransform);
 			RigidBody* GetRigidBody(Common::ITransform* pTransform);
 			void FixedUpdateBegin();
 			void FixedUpdate();
 			void FixedUpdateEnd();
+			uint32_t GetStateHash() const;
+			// the RigidBodys whose path in the last FixedUpdate overlaps i_aabb.
+			void QueryRigidBodies(const Math::PackedAABB& i_aabb, std::vector<RigidBody*>& o_rigidBodies) const;
+			void SetWorkerCount(uint32_t workerCount);
+			uint32_t GetWorkerCount() const { return _workerPool.GetWorkerCount(); }
+			// the count of islands found by the last FixedUpdate.
+			uint32_t GetIslandCount() const { return _islandStarts.empty() ? 0 : (uint32_t)_islandStarts.size() - 1; }
+			uint32_t GetAwakeCount() const { return (uint32_t)(_awakeBodies.size() + _wokenBodies.size()); }
+			ContactSolver& GetContactSolver() { return _contactSolver; }
 
+		private:
+			void BuildIslands();
+			uint32_t FindIslandRoot(uint32_t bodyIndex);
+			void AdvanceIsland(uint32_t islandIndex, uint32_t workerIndex, float fixedTimeStep);
+			void AddWokenBodies();
+			// Wake up the sleeping RigidBodys touched by the path of a RigidBody with i_radius.
+			void WakeUpTouchedBodies(const Math::PackedAABB& i_path, float i_radius);
+			friend class RigidBody;
 
 		private:
 			std::vector<RigidBody*> _rigidBodys;
+			// the indices of the awake RigidBodys in increasing order,
+			// and the ones woken up since the last FixedUpdate, which join them in the next FixedUpdate.
+			std::vector<uint32_t> _awakeBodies;
+			std::vector<uint32_t> _wokenBodies;
+			// the indices of the sleeping RigidBodys whose Transforms have been moved since the last FixedUpdateBegin.
+			std::vector<uint32_t> _movedSleepers;
+			// the indices of the RigidBodys with a box, in the order they got their boxes.
+			std::vector<uint32_t> _boxBodies;
+			ContactSolver _contactSolver;
+			Core::DynamicAABBTree _rigidBodyTree;
+			WorkerPool _workerPool;
+			// the Colliders near the RigidBody being advanced, one list for each worker,
+			// reused to avoid the allocation in each FixedUpdate.
+			std::vector<std::vector<Collider::Collider*> > _candidateColliders;
+			// The islands only contain the awake RigidBodys, so the arrays below are indexed by the position in _awakeBodies.
+			// the box bounding the path of each awake RigidBody in this step.
+			std::vector<Math::PackedAABB> _pathAABBs;
+			// the awake RigidBodys sorted by the min x of their paths.
+			std::vector<uint32_t> _sortedBodies;
+			// union-find of the awake RigidBodys, the root of an island is its RigidBody with the smallest index.
+			std::vector<uint32_t> _islandParents;
+			// the awake RigidBodys of the island i are _islandBodies[_islandStarts[i]] ... _islandBodies[_islandStarts[i + 1] - 1].
+			std::vector<uint32_t> _islandBodies;
+			std::vector<uint32_t> _islandStarts;
 		};
 
 	}
@@ -0,0 +1,385 @@
+#ifndef EAE_ENGINE_COLLISION_DETECTION_SIMD_FUNCTIONS_H
+#define EAE_ENGINE_COLLISION_DETECTION_SIMD_FUNCTIONS_H
+
+#include "CollisionDetectionFunctions.h"
+#include "Engine/Math/SIMDGeometry.h"
+#include <cfloat>
+#include <cstdint>
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
+
+/*
+ * 4 and 8 wide versions of TestSegmentAABB and IntersectSegmentTriangle, one segment against several boxes or triangles,
+ * and several segments against one box.
+ * Each lane does the same float operations in the same order as the scalar test, and no early out changes the result,
+ * so the masks and the t, u, v, w of the hit lanes are the same as the scalar functions.
+ * The 8 wide ones use AVX when the build enables it (/arch:AVX defines __AVX__), otherwise two SSE halves.
+ */
+namespace EAE_Engine
+{
+  namespace Collision
+  {
+    // 4 triangles in SoA layout, a and the edges ab and ac, like IntersectSegmentTriangle computes them.
+    struct Triangle4
+    {
+      inline void Set(size_t index, const Math::Vector3& i_a, const Math::Vector3& i_b, const Math::Vector3& i_c);
+      // The unused slots are a degenerated triangle which is never hit.
+      inline void SetEmpty(size_t index);
+
+      float _a[3][4];
+      float _ab[3][4];
+      float _ac[3][4];
+    };
+
+    struct Triangle8
+    {
+      inline void Set(size_t index, const Math::Vector3& i_a, const Math::Vector3& i_b, const Math::Vector3& i_c);
+      inline void SetEmpty(size_t index);
+
+      float _a[3][8];
+      float _ab[3][8];
+      float _ac[3][8];
+    };
+
+    // 4 segments in SoA layout.
+    struct Segment4
+    {
+      inline void Set(size_t index, const Math::Vector3& i_start, const Math::Vector3& i_end);
+      // The unused slots are a point far away which never overlaps a box.
+      inline void SetEmpty(size_t index);
+
+      float _start[3][4];
+      float _end[3][4];
+    };
+
+    struct Segment8
+    {
+      inline void Set(size_t index, const Math::Vector3& i_start, const Math::Vector3& i_end);
+      inline void SetEmpty(size_t index);
+
+      float _start[3][8];
+      float _end[3][8];
+    };
+
+    namespace Implements
+    {
+      template<size_t Width>
+      inline void SetTriangle(float o_a[3][Width], float o_ab[3][Width], float o_ac[3][Width], size_t index,
+        const Math::Vector3& i_a, const Math::Vector3& i_b, const Math::Vector3& i_c)
+      {
+        const Math::Vector3 ab = i_b - i_a;
+        const Math::Vector3 ac = i_c - i_a;
+        for (size_t axis = 0; axis < 3; ++axis)
+        {
+          o_a[axis][index] = i_a._u[axis];
+          o_ab[axis][index] = ab._u[axis];
+          o_ac[axis][index] = ac._u[axis];
+        }
+      }
+
+      template<size_t Width>
+      inline void SetSegment(float o_start[3][Width], float o_end[3][Width], size_t index, const Math::Vector3& i_start, const Math::Vector3& i_end)
+      {
+        for (size_t axis = 0; axis < 3; ++axis)
+        {
+          o_start[axis][index] = i_start._u[axis];
+          o_end[axis][index] = i_end._u[axis];
+        }
+      }
+
+      // The separating axes of TestSegmentAABB for 4 lanes, m is the segment midpoint relative to the box center.
+      // Returns the mask of the lanes without a separating axis.
+      inline uint32_t TestSegmentAABBLanes(const __m128 m[3], const __m128 d[3], const __m128 e[3])
+      {
+        const __m128 signMask = _mm_set1_ps(-0.0f);
+        const __m128 epsilon = _mm_set1_ps(EPSILON);
+        __m128 adx = _mm_andnot_ps(signMask, d[0]);
+        __m128 ady = _mm_andnot_ps(signMask, d[1]);
+        __m128 adz = _mm_andnot_ps(signMask, d[2]);
+        __m128 separated = _mm_cmpgt_ps(_mm_andnot_ps(signMask, m[0]), _mm_add_ps(e[0], adx));
+        separated = _mm_or_ps(separated, _mm_cmpgt_ps(_mm_andnot_ps(signMask, m[1]), _mm_add_ps(e[1], ady)));
+        separated = _mm_or_ps(separated, _mm_cmpgt_ps(_mm_andnot_ps(signMask, m[2]), _mm_add_ps(e[2], adz)));
+        adx = _mm_add_ps(adx, epsilon);
+        ady = _mm_add_ps(ady, epsilon);
+        adz = _mm_add_ps(adz, epsilon);
+        __m128 axis = _mm_sub_ps(_mm_mul_ps(m[1], d[2]), _mm_mul_ps(m[2], d[1]));
+        separated = _mm_or_ps(separated, _mm_cmpgt_ps(_mm_andnot_ps(signMask, axis), _mm_add_ps(_mm_mul_ps(e[1], adz), _mm_mul_ps(e[2], ady))));
+        axis = _mm_sub_ps(_mm_mul_ps(m[2], d[0]), _mm_mul_ps(m[0], d[2]));
+        separated = _mm_or_ps(separated, _mm_cmpgt_ps(_mm_andnot_ps(signMask, axis), _mm_add_ps(_mm_mul_ps(e[0], adz), _mm_mul_ps(e[2], adx))));
+        axis = _mm_sub_ps(_mm_mul_ps(m[0], d[1]), _mm_mul_ps(m[1], d[0]));
+        separated = _mm_or_ps(separated, _mm_cmpgt_ps(_mm_andnot_ps(signMask, axis), _mm_add_ps(_mm_mul_ps(e[0], ady), _mm_mul_ps(e[1], adx))));
+        return (uint32_t)(~_mm_movemask_ps(separated) & 0xf);
+      }
+
+      // One segment against the 4 boxes at pMinX[0..3] and so on.
+      inline uint32_t TestSegmentAABB4(const Math::Vector3& p0, const Math::Vector3& p1, const float* pMinX, const float* pMinY, const float* pMinZ,
+        const float* pMaxX, const float* pMaxY, const float* pMaxZ)
+      {
+        const __m128 half = _mm_set1_ps(0.5f);
+        const Math::Vector3 midpoint = (p0 + p1) * 0.5f;
+        const Math::Vector3 halfLength = p1 - midpoint;
+        const float* pMins[3] = { pMinX, pMinY, pMinZ };
+        const float* pMaxs[3] = { pMaxX, pMaxY, pMaxZ };
+        __m128 m[3], d[3], e[3];
+        for (size_t axis = 0; axis < 3; ++axis)
+        {
+          const __m128 max = _mm_loadu_ps(pMaxs[axis]);
+          const __m128 c = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(pMins[axis]), max), half);
+          e[axis] = _mm_sub_ps(max, c);
+          m[axis] = _mm_sub_ps(_mm_set1_ps(midpoint._u[axis]), c);
+          d[axis] = _mm_set1_ps(halfLength._u[axis]);
+        }
+        return TestSegmentAABBLanes(m, d, e);
+      }
+
+      // The 4 segments at pStart[axis][0..3] against one box, stride is the count of the floats between the axes.
+      inline uint32_t TestSegment4AABB(const float* pStart, const float* pEnd, size_t stride, const Math::AABBV1& b)
+      {
+        const __m128 half = _mm_set1_ps(0.5f);
+        const Math::Vector3 c = (b._min + b._max) * 0.5f;
+        const Math::Vector3 extents = b._max - c;
+        __m128 m[3], d[3], e[3];
+        for (size_t axis = 0; axis < 3; ++axis)
+        {
+          const __m128 end = _mm_loadu_ps(pEnd + axis * stride);
+          const __m128 midpoint = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(pStart + axis * stride), end), half);
+          d[axis] = _mm_sub_ps(end, midpoint);
+          m[axis] = _mm_sub_ps(midpoint, _mm_set1_ps(c._u[axis]));
+          e[axis] = _mm_set1_ps(extents._u[axis]);
+        }
+        return TestSegmentAABBLanes(m, d, e);
+      }
+
+      // IntersectSegmentTriangle against the 4 triangles at pA[axis * stride + 0..3] and so on,
+      // o_pT, o_pU, o_pV and o_pW get 4 values, they are only valid in the returned mask.
+      inline uint32_t IntersectSegmentTriangle4(const Math::Vector3& p, const Math::Vector3& q, const float* pA, const float* pAB, const float* pAC, size_t stride,
+        float* o_pT, float* o_pU, float* o_pV, float* o_pW)
+      {
+        const __m128 zero = _mm_setzero_ps();
+        __m128 ab[3], ac[3], qp[3], ap[3];
+        for (size_t axis = 0; axis < 3; ++axis)
+        {
+          ab[axis] = _mm_loadu_ps(pAB + axis * stride);
+          ac[axis] = _mm_loadu_ps(pAC + axis * stride);
+          qp[axis] = _mm_set1_ps(p._u[axis] - q._u[axis]);
+          ap[axis] = _mm_sub_ps(_mm_set1_ps(p._u[axis]), _mm_loadu_ps(pA + axis * stride));
+        }
+        const __m128 nx = _mm_sub_ps(_mm_mul_ps(ab[1], ac[2]), _mm_mul_ps(ab[2], ac[1]));
+        const __m128 ny = _mm_sub_ps(_mm_mul_ps(ab[2], ac[0]), _mm_mul_ps(ab[0], ac[2]));
+        const __m128 nz = _mm_sub_ps(_mm_mul_ps(ab[0], ac[1]), _mm_mul_ps(ab[1], ac[0]));
+        const __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(qp[0], nx), _mm_mul_ps(qp[1], ny)), _mm_mul_ps(qp[2], nz));
+        __m128 t = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ap[0], nx), _mm_mul_ps(ap[1], ny)), _mm_mul_ps(ap[2], nz));
+        const __m128 ex = _mm_sub_ps(_mm_mul_ps(qp[1], ap[2]), _mm_mul_ps(qp[2], ap[1]));
+        const __m128 ey = _mm_sub_ps(_mm_mul_ps(qp[2], ap[0]), _mm_mul_ps(qp[0], ap[2]));
+        const __m128 ez = _mm_sub_ps(_mm_mul_ps(qp[0], ap[1]), _mm_mul_ps(qp[1], ap[0]));
+        __m128 v = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ac[0], ex), _mm_mul_ps(ac[1], ey)), _mm_mul_ps(ac[2], ez));
+        __m128 w = _mm_xor_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(ab[0], ex), _mm_mul_ps(ab[1], ey)), _mm_mul_ps(ab[2], ez)), _mm_set1_ps(-0.0f));
+        // The negated compares keep the lanes the scalar test doesn't reject, NaN included.
+        __m128 hit = _mm_cmpnle_ps(d, zero);
+        hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpnlt_ps(t, zero), _mm_cmpngt_ps(t, d)));
+        hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpnlt_ps(v, zero), _mm_cmpngt_ps(v, d)));
+        hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpnlt_ps(w, zero), _mm_cmpngt_ps(_mm_add_ps(v, w), d)));
+        const uint32_t mask = (uint32_t)_mm_movemask_ps(hit);
+        if (mask == 0)
+          return 0;
+        const __m128 ood = _mm_div_ps(_mm_set1_ps(1.0f), d);
+        t = _mm_mul_ps(t, ood);
+        v = _mm_mul_ps(v, ood);
+        w = _mm_mul_ps(w, ood);
+        _mm_storeu_ps(o_pT, t);
+        _mm_storeu_ps(o_pU, _mm_sub_ps(_mm_sub_ps(_mm_set1_ps(1.0f), v), w));
+        _mm_storeu_ps(o_pV, v);
+        _mm_storeu_ps(o_pW, w);
+        return mask;
+      }
+
+#ifdef __AVX__
+      inline __m256 AbsLanes(__m256 i_value)
+      {
+        return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), i_value);
+      }
+
+      inline uint32_t TestSegmentAABBLanes(const __m256 m[3], const __m256 d[3], const __m256 e[3])
+      {
+        const __m256 epsilon = _mm256_set1_ps(EPSILON);
+        __m256 adx = AbsLanes(d[0]);
+        __m256 ady = AbsLanes(d[1]);
+        __m256 adz = AbsLanes(d[2]);
+        __m256 separated = _mm256_cmp_ps(AbsLanes(m[0]), _mm256_add_ps(e[0], adx), _CMP_GT_OQ);
+        separated = _mm256_or_ps(separated, _mm256_cmp_ps(AbsLanes(m[1]), _mm256_add_ps(e[1], ady), _CMP_GT_OQ));
+        separated = _mm256_or_ps(separated, _mm256_cmp_ps(AbsLanes(m[2]), _mm256_add_ps(e[2], adz), _CMP_GT_OQ));
+        adx = _mm256_add_ps(adx, epsilon);
+        ady = _mm256_add_ps(ady, epsilon);
+        adz = _mm256_add_ps(adz, epsilon);
+        __m256 axis = _mm256_sub_ps(_mm256_mul_ps(m[1], d[2]), _mm256_mul_ps(m[2], d[1]));
+        separated = _mm256_or_ps(separated, _mm256_cmp_ps(AbsLanes(axis), _mm256_add_ps(_mm256_mul_ps(e[1], adz), _mm256_mul_ps(e[2], ady)), _CMP_GT_OQ));
+        axis = _mm256_sub_ps(_mm256_mul_ps(m[2], d[0]), _mm256_mul_ps(m[0], d[2]));
+        separated = _mm256_or_ps(separated, _mm256_cmp_ps(AbsLanes(axis), _mm256_add_ps(_mm256_mul_ps(e[0], adz), _mm256_mul_ps(e[2], adx)), _CMP_GT_OQ));
+        axis = _mm256_sub_ps(_mm256_mul_ps(m[0], d[1]), _mm256_mul_ps(m[1], d[0]));
+        separated = _mm256_or_ps(separated, _mm256_cmp_ps(AbsLanes(axis), _mm256_add_ps(_mm256_mul_ps(e[0], ady), _mm256_mul_ps(e[1], adx)), _CMP_GT_OQ));
+        return (uint32_t)(~_mm256_movemask_ps(separated) & 0xff);
+      }
+#endif
+    }
+
+    // Returns a 4 bits mask, the ith bit is set when the segment overlaps the ith box, the same as TestSegmentAABB.
+    inline uint32_t TestSegmentAABB4(const Math::Vector3& p0, const Math::Vector3& p1, const Math::AABB4& i_boxes)
+    {
+      return Implements::TestSegmentAABB4(p0, p1, i_boxes._minX, i_boxes._minY, i_boxes._minZ, i_boxes._maxX, i_boxes._maxY, i_boxes._maxZ);
+    }
+
+    // Returns a 8 bits mask, the ith bit is set when the segment overlaps the ith box.
+    inline uint32_t TestSegmentAABB8(const Math::Vector3& p0, const Math::Vector3& p1, const Math::AABB8& i_boxes)
+    {
+#ifdef __AVX__
+      const __m256 half = _mm256_set1_ps(0.5f);
+      const Math::Vector3 midpoint = (p0 + p1) * 0.5f;
+      const Math::Vector3 halfLength = p1 - midpoint;
+      const float* pMins[3] = { i_boxes._minX, i_boxes._minY, i_boxes._minZ };
+      const float* pMaxs[3] = { i_boxes._maxX, i_boxes._maxY, i_boxes._maxZ };
+      __m256 m[3], d[3], e[3];
+      for (size_t axis = 0; axis < 3; ++axis)
+      {
+        const __m256 max = _mm256_loadu_ps(pMaxs[axis]);
+        const __m256 c = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(pMins[axis]), max), half);
+        e[axis] = _mm256_sub_ps(max, c);
+        m[axis] = _mm256_sub_ps(_mm256_set1_ps(midpoint._u[axis]), c);
+        d[axis] = _mm256_set1_ps(halfLength._u[axis]);
+      }
+      return Implements::TestSegmentAABBLanes(m, d, e);
+#else
+      return Implements::TestSegmentAABB4(p0, p1, i_boxes._minX, i_boxes._minY, i_boxes._minZ, i_boxes._maxX, i_boxes._maxY, i_boxes._maxZ) |
+        (Implements::TestSegmentAABB4(p0, p1, i_boxes._minX + 4, i_boxes._minY + 4, i_boxes._minZ + 4, i_boxes._maxX + 4, i_boxes._maxY + 4, i_boxes._maxZ + 4) << 4);
+#endif
+    }
+
+    // Returns a 4 bits mask, the ith bit is set when the ith segment overlaps the box.
+    inline uint32_t TestSegment4AABB(const Segment4& i_segments, const Math::AABBV1& b)
+    {
+      return Implements::TestSegment4AABB(i_segments._start[0], i_segments._end[0], 4, b);
+    }
+
+    inline uint32_t TestSegment8AABB(const Segment8& i_segments, const Math::AABBV1& b)
+    {
+#ifdef __AVX__
+      const __m256 half = _mm256_set1_ps(0.5f);
+      const Math::Vector3 c = (b._min + b._max) * 0.5f;
+      const Math::Vector3 extents = b._max - c;
+      __m256 m[3], d[3], e[3];
+      for (size_t axis = 0; axis < 3; ++axis)
+      {
+        const __m256 end = _mm256_loadu_ps(i_segments._end[axis]);
+        const __m256 midpoint = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(i_segments._start[axis]), end), half);
+        d[axis] = _mm256_sub_ps(end, midpoint);
+        m[axis] = _mm256_sub_ps(midpoint, _mm256_set1_ps(c._u[axis]));
+        e[axis] = _mm256_set1_ps(extents._u[axis]);
+      }
+      return Implements::TestSegmentAABBLanes(m, d, e);
+#else
+      return Implements::TestSegment4AABB(i_segments._start[0], i_segments._end[0], 8, b) |
+        (Implements::TestSegment4AABB(i_segments._start[0] + 4, i_segments._end[0] + 4, 8, b) << 4);
+#endif
+    }
+
+    // IntersectSegmentTriangle against 4 triangles, returns the mask of the hit ones,
+    // o_t, o_u, o_v and o_w of the hit ones are the same as the scalar test, the others are undefined.
+    inline uint32_t IntersectSegmentTriangle4(const Math::Vector3& p, const Math::Vector3& q, const Triangle4& i_triangles,
+      float o_t[4], float o_u[4], float o_v[4], float o_w[4])
+    {
+      return Implements::IntersectSegmentTriangle4(p, q, i_triangles._a[0], i_triangles._ab[0], i_triangles._ac[0], 4, o_t, o_u, o_v, o_w);
+    }
+
+    inline uint32_t IntersectSegmentTriangle8(const Math::Vector3& p, const Math::Vector3& q, const Triangle8& i_triangles,
+      float o_t[8], float o_u[8], float o_v[8], float o_w[8])
+    {
+#ifdef __AVX__
+      const __m256 zero = _mm256_setzero_ps();
+      __m256 ab[3], ac[3], qp[3], ap[3];
+      for (size_t axis = 0; axis < 3; ++axis)
+      {
+        ab[axis] = _mm256_loadu_ps(i_triangles._ab[axis]);
+        ac[axis] = _mm256_loadu_ps(i_triangles._ac[axis]);
+        qp[axis] = _mm256_set1_ps(p._u[axis] - q._u[axis]);
+        ap[axis] = _mm256_sub_ps(_mm256_set1_ps(p._u[axis]), _mm256_loadu_ps(i_triangles._a[axis]));
+      }
+      const __m256 nx = _mm256_sub_ps(_mm256_mul_ps(ab[1], ac[2]), _mm256_mul_ps(ab[2], ac[1]));
+      const __m256 ny = _mm256_sub_ps(_mm256_mul_ps(ab[2], ac[0]), _mm256_mul_ps(ab[0], ac[2]));
+      const __m256 nz = _mm256_sub_ps(_mm256_mul_ps(ab[0], ac[1]), _mm256_mul_ps(ab[1], ac[0]));
+      const __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(qp[0], nx), _mm256_mul_ps(qp[1], ny)), _mm256_mul_ps(qp[2], nz));
+      __m256 t = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ap[0], nx), _mm256_mul_ps(ap[1], ny)), _mm256_mul_ps(ap[2], nz));
+      const __m256 ex = _mm256_sub_ps(_mm256_mul_ps(qp[1], ap[2]), _mm256_mul_ps(qp[2], ap[1]));
+      const __m256 ey = _mm256_sub_ps(_mm256_mul_ps(qp[2], ap[0]), _mm256_mul_ps(qp[0], ap[2]));
+      const __m256 ez = _mm256_sub_ps(_mm256_mul_ps(qp[0], ap[1]), _mm256_mul_ps(qp[1], ap[0]));
+      __m256 v = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ac[0], ex), _mm256_mul_ps(ac[1], ey)), _mm256_mul_ps(ac[2], ez));
+      __m256 w = _mm256_xor_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ab[0], ex), _mm256_mul_ps(ab[1], ey)), _mm256_mul_ps(ab[2], ez)), _mm256_set1_ps(-0.0f));
+      __m256 hit = _mm256_cmp_ps(d, zero, _CMP_NLE_UQ);
+      hit = _mm256_and_ps(hit, _mm256_and_ps(_mm256_cmp_ps(t, zero, _CMP_NLT_UQ), _mm256_cmp_ps(t, d, _CMP_NGT_UQ)));
+      hit = _mm256_and_ps(hit, _mm256_and_ps(_mm256_cmp_ps(v, zero, _CMP_NLT_UQ), _mm256_cmp_ps(v, d, _CMP_NGT_UQ)));
+      hit = _mm256_and_ps(hit, _mm256_and_ps(_mm256_cmp_ps(w, zero, _CMP_NLT_UQ), _mm256_cmp_ps(_mm256_add_ps(v, w), d, _CMP_NGT_UQ)));
+      const uint32_t mask = (uint32_t)_mm256_movemask_ps(hit);
+      if (mask == 0)
+        return 0;
+      const __m256 ood = _mm256_div_ps(_mm256_set1_ps(1.0f), d);
+      t = _mm256_mul_ps(t, ood);
+      v = _mm256_mul_ps(v, ood);
+      w = _mm256_mul_ps(w, ood);
+      _mm256_storeu_ps(o_t, t);
+      _mm256_storeu_ps(o_u, _mm256_sub_ps(_mm256_sub_ps(_mm256_set1_ps(1.0f), v), w));
+      _mm256_storeu_ps(o_v, v);
+      _mm256_storeu_ps(o_w, w);
+      return mask;
+#else
+      return Implements::IntersectSegmentTriangle4(p, q, i_triangles._a[0], i_triangles._ab[0], i_triangles._ac[0], 8, o_t, o_u, o_v, o_w) |
+        (Implements::IntersectSegmentTriangle4(p, q, i_triangles._a[0] + 4, i_triangles._ab[0] + 4, i_triangles._ac[0] + 4, 8, o_t + 4, o_u + 4, o_v + 4, o_w + 4) << 4);
+#endif
+    }
+
+    ///////////////////////////////////////Triangle4 && Segment4//////////////////////////////////////////
+
+    inline void Triangle4::Set(size_t index, const Math::Vector3& i_a, const Math::Vector3& i_b, const Math::Vector3& i_c)
+    {
+      Implements::SetTriangle<4>(_a, _ab, _ac, index, i_a, i_b, i_c);
+    }
+
+    inline void Triangle4::SetEmpty(size_t index)
+    {
+      Implements::SetTriangle<4>(_a, _ab, _ac, index, Math::Vector3::Zero, Math::Vector3::Zero, Math::Vector3::Zero);
+    }
+
+    inline void Triangle8::Set(size_t index, const Math::Vector3& i_a, const Math::Vector3& i_b, const Math::Vector3& i_c)
+    {
+      Implements::SetTriangle<8>(_a, _ab, _ac, index, i_a, i_b, i_c);
+    }
+
+    inline void Triangle8::SetEmpty(size_t index)
+    {
+      Implements::SetTriangle<8>(_a, _ab, _ac, index, Math::Vector3::Zero, Math::Vector3::Zero, Math::Vector3::Zero);
+    }
+
+    inline void Segment4::Set(size_t index, const Math::Vector3& i_start, const Math::Vector3& i_end)
+    {
+      Implements::SetSegment<4>(_start, _end, index, i_start, i_end);
+    }
+
+    inline void Segment4::SetEmpty(size_t index)
+    {
+      // Not FLT_MAX, the midpoint of it would overflow to inf, then the cross axes would be NaN and never separate it.
+      const Math::Vector3 farAway(0.5f * FLT_MAX, 0.5f * FLT_MAX, 0.5f * FLT_MAX);
+      Implements::SetSegment<4>(_start, _end, index, farAway, farAway);
+    }
+
+    inline void Segment8::Set(size_t index, const Math::Vector3& i_start, const Math::Vector3& i_end)
+    {
+      Implements::SetSegment<8>(_start, _end, index, i_start, i_end);
+    }
+
+    inline void Segment8::SetEmpty(size_t index)
+    {
+      const Math::Vector3 farAway(0.5f * FLT_MAX, 0.5f * FLT_MAX, 0.5f * FLT_MAX);
+      Implements::SetSegment<8>(_start, _end, index, farAway, farAway);
+    }
+  }
+}
+
+#endif//EAE_ENGINE_COLLISION_DETECTION_SIMD_FUNCTIONS_H
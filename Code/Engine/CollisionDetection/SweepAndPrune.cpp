@@ -0,0 +1,132 @@
+#include "SweepAndPrune.h"
+#include "ColliderBase.h"
+#include <algorithm>
+
+namespace EAE_Engine
+{
+  namespace Collider
+  {
+    namespace
+    {
+      // Switch the sort axis only when another axis spreads the colliders much wider,
+      // because re-sorting on a new axis can't use the order of the last frame.
+      const float s_switchAxisRatio = 2.0f;
+    }
+
+    SweepAndPrune::SweepAndPrune() :
+      _axis(0)
+    {}
+
+    void SweepAndPrune::Add(Collider* pCollider)
+    {
+      if (!pCollider)
+        return;
+      Proxy proxy;
+      proxy._aabb = pCollider->GetSweptAABB(0.0f);
+      proxy._pCollider = pCollider;
+      _proxies.push_back(proxy);
+    }
+
+    void SweepAndPrune::Remove(Collider* pCollider)
+    {
+      // Keep the order, so the next Update still starts from an almost sorted array.
+      for (std::vector<Proxy>::iterator it = _proxies.begin(); it != _proxies.end(); ++it)
+      {
+        if (it->_pCollider == pCollider)
+        {
+          _proxies.erase(it);
+          break;
+        }
+      }
+      // The pairs may still point to the removed collider.
+      _pairs.erase(std::remove_if(_pairs.begin(), _pairs.end(),
+        [pCollider](const ColliderPair& pair) { return pair._pColliderA == pCollider || pair._pColliderB == pCollider; }),
+        _pairs.end());
+    }
+
+    void SweepAndPrune::Clear()
+    {
+      _proxies.clear();
+      _pairs.clear();
+    }
+
+    void SweepAndPrune::Update(float fElpasedTime)
+    {
+      for (std::vector<Proxy>::iterator it = _proxies.begin(); it != _proxies.end(); ++it)
+        it->_aabb = it->_pCollider->GetSweptAABB(fElpasedTime);
+      ChooseSortAxis();
+      SortProxies();
+      FindPairs();
+    }
+
+    void SweepAndPrune::ChooseSortAxis()
+    {
+      if (_proxies.size() < 2)
+        return;
+      float sum[3] = { 0.0f, 0.0f, 0.0f };
+      float sumSquare[3] = { 0.0f, 0.0f, 0.0f };
+      for (std::vector<Proxy>::const_iterator it = _proxies.begin(); it != _proxies.end(); ++it)
+      {
+        for (size_t axis = 0; axis < 3; ++axis)
+        {
+          float center = (it->_aabb._min[axis] + it->_aabb._max[axis]) * 0.5f;
+          sum[axis] += center;
+          sumSquare[axis] += center * center;
+        }
+      }
+      float count = (float)_proxies.size();
+      float variance[3];
+      for (size_t axis = 0; axis < 3; ++axis)
+        variance[axis] = sumSquare[axis] / count - (sum[axis] / count) * (sum[axis] / count);
+      size_t bestAxis = 0;
+      if (variance[1] > variance[bestAxis])
+        bestAxis = 1;
+      if (variance[2] > variance[bestAxis])
+        bestAxis = 2;
+      if (variance[bestAxis] > variance[_axis] * s_switchAxisRatio)
+      {
+        _axis = bestAxis;
+        const size_t axis = _axis;
+        std::sort(_proxies.begin(), _proxies.end(),
+          [axis](const Proxy& a, const Proxy& b) { return a._aabb._min[axis] < b._aabb._min[axis]; });
+      }
+    }
+
+    void SweepAndPrune::SortProxies()
+    {
+      // Insertion sort, the order of the last frame is almost sorted.
+      const size_t axis = _axis;
+      for (size_t i = 1; i < _proxies.size(); ++i)
+      {
+        Proxy proxy = _proxies[i];
+        float key = proxy._aabb._min[axis];
+        size_t j = i;
+        for (; j > 0 && _proxies[j - 1]._aabb._min[axis] > key; --j)
+          _proxies[j] = _proxies[j - 1];
+        _proxies[j] = proxy;
+      }
+    }
+
+    void SweepAndPrune::FindPairs()
+    {
+      _pairs.clear();
+      const size_t axis = _axis;
+      const size_t count = _proxies.size();
+      for (size_t i = 0; i < count; ++i)
+      {
+        const Proxy& proxy = _proxies[i];
+        const float max = proxy._aabb._max[axis];
+        // The proxies after this one are sorted by their min,
+        // so we can stop at the first one which starts after this one ends.
+        for (size_t j = i + 1; j < count && _proxies[j]._aabb._min[axis] <= max; ++j)
+        {
+          if (Math::TestAABBAABB(proxy._aabb, _proxies[j]._aabb))
+          {
+            ColliderPair pair = { proxy._pCollider, _proxies[j]._pCollider };
+            _pairs.push_back(pair);
+          }
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,60 @@
+#ifndef EAE_ENGINE_COLLISION_SWEEP_AND_PRUNE_H
+#define EAE_ENGINE_COLLISION_SWEEP_AND_PRUNE_H
+
+#include "Engine/Math/SIMDGeometry.h"
+#include <vector>
+
+/*
+ * The broad phase of ColliderManager::IterateAdvanceColliders.
+ * Each Collider is bounded by its swept AABB of this step, the boxes are kept sorted by their min on one axis.
+ * The DynamicAABBTree of the ColliderManager answers the spatial queries with fat boxes instead,
+ * all of the pairs of a step are found faster by one sweep over the sorted exact boxes.
+ * The colliders only move a little in one frame, so the order of the last frame is almost sorted,
+ * and the insertion sort makes it sorted again in nearly O(n).
+ * Then we sweep the sorted boxes once, only the boxes overlapping on all of the 3 axes become candidate pairs,
+ * the narrow phase (Collider::DetectCollision) only needs to run on these pairs.
+ */
+namespace EAE_Engine
+{
+  namespace Collider
+  {
+    class Collider;
+
+    struct ColliderPair
+    {
+      Collider* _pColliderA;
+      Collider* _pColliderB;
+    };
+
+    class SweepAndPrune
+    {
+    public:
+      SweepAndPrune();
+      void Add(Collider* pCollider);
+      void Remove(Collider* pCollider);
+      void Clear();
+      // Refresh the swept AABBs for the step of fElpasedTime seconds, sort them and find the candidate pairs.
+      void Update(float fElpasedTime);
+      const std::vector<ColliderPair>& GetPairs() const { return _pairs; }
+      size_t GetPairCount() const { return _pairs.size(); }
+      size_t GetSortAxis() const { return _axis; }
+
+    private:
+      struct Proxy
+      {
+        Math::PackedAABB _aabb;
+        Collider* _pCollider;
+      };
+      void ChooseSortAxis();
+      void SortProxies();
+      void FindPairs();
+
+    private:
+      std::vector<Proxy> _proxies;
+      std::vector<ColliderPair> _pairs;
+      size_t _axis;
+    };
+  }
+}
+
+#endif//EAE_ENGINE_COLLISION_SWEEP_AND_PRUNE_H
@@ -82,9 +82,9 @@ namespace EAE_Engine
       virtual Math::Vector3 GetEulerAngle() const = 0;
       virtual void SetEulerAngle(Math::Vector3 eulerAngle) = 0;
       // local transform
-      virtual Math::Vector3& GetLocalPos() = 0;
+      virtual Math::Vector3 GetLocalPos() const = 0;
       virtual void SetLocalPos(const Math::Vector3&) = 0;
-      virtual Math::Quaternion& GetLocalRotation() = 0;
+      virtual Math::Quaternion GetLocalRotation() const = 0;
       virtual void SetLocalRotation(const Math::Quaternion&) = 0;
       virtual void SetLocalScale(const Math::Vector3&) = 0;
       virtual Math::Vector3 LocalScale() = 0;
@@ -138,6 +138,13 @@ namespace EAE_Engine
       ContinuousDynamic = 0x2,// Continuous collision detection is on for colliding with static and dynamic geometry.
     };
 
+    enum IntegrationMode
+    {
+      Euler = 0x0, // x += v * dt + a * dt * dt / 2, v += a * dt. Exact for a constant force, but gains energy when the force depends on the position.
+      SemiImplicitEuler = 0x1, // v += a * dt, x += v * dt. Symplectic, so the energy stays bounded, but only first order.
+      Verlet = 0x2, // Position Verlet written in the velocity form. Symplectic and second order.
+    };
+
     class IRigidBody : public ICompo
     {
     public:
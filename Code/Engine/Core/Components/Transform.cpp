@@ -1,4 +1,5 @@
 #include "Transform.h"
+#include "TransformHierarchy.h"
 #include "../Individual/GameObj.h"
 #include "Math/EulerAngle.h"
 #include "Math/MathTool.h"
@@ -8,14 +9,14 @@ namespace EAE_Engine
 {
   namespace Core
   {
-    Transform::Transform(Common::IGameObj* pGamObj) : _pGamObj(pGamObj), _pParent(nullptr), 
-      _localPosition(Math::Vector3::Zero), _localRotation(Math::Quaternion::Identity), 
-      _localScale(Math::Vector3(1.0f, 1.0f, 1.0f))
+    Transform::Transform(Common::IGameObj* pGamObj) : _pGamObj(pGamObj), 
+      _handle(TransformHierarchy::GetInstance()->AddTransform(this))
     {
     }
 
     Transform::~Transform()
     {
+      TransformHierarchy::GetInstance()->RemoveTransform(_handle);
     }
 
     Common::IGameObj* Transform::GetGameObj()
@@ -27,41 +28,64 @@ namespace EAE_Engine
       return _pGamObj ? _pGamObj->GetComponent(type) : nullptr;
     }
 
-    void Transform::RemoveChild(ITransform* pParent)
+    // Children
+    void Transform::AddChild(ITransform* pChild)
     {
-      for (std::vector<Common::ITransform*>::iterator it = _children.begin(); it != _children.end(); ++it)
-      {
-        if (*it == pParent)
-        {
-          _children.erase(it);
-          break;
-        }
-      }
+      if (pChild && pChild->GetParent() != this)
+        pChild->SetParent(this);
+    }
+
+    void Transform::RemoveChild(ITransform* pChild)
+    {
+      if (pChild && pChild->GetParent() == this)
+        pChild->SetParent(nullptr);
+    }
+
+    uint32_t Transform::GetChildCount()
+    {
+      return TransformHierarchy::GetInstance()->GetChildCount(_handle);
+    }
+
+    Common::ITransform* Transform::GetChild(uint32_t index)
+    {
+      TransformHierarchy* pHierarchy = TransformHierarchy::GetInstance();
+      uint32_t childHandle = pHierarchy->GetChild(_handle, index);
+      if (childHandle == TransformHierarchy::s_invalid)
+        return nullptr;
+      return pHierarchy->GetOwner(childHandle);
     }
 
     // Parent
     void Transform::SetParent(ITransform* parent)
     {
-      if (_pParent == parent)
-        return;
-      if (parent == this) {
-        _pParent = nullptr;
+      TransformHierarchy* pHierarchy = TransformHierarchy::GetInstance();
+      uint32_t parentHandle = TransformHierarchy::s_invalid;
+      if (parent && parent != this)
+        parentHandle = static_cast<Transform*>(parent)->_handle;
+      uint32_t currentParentHandle = pHierarchy->GetParent(_handle);
+      if (currentParentHandle == parentHandle)
         return;
-      }
-      if (_pParent && parent == nullptr)
+      if (currentParentHandle != TransformHierarchy::s_invalid && parentHandle == TransformHierarchy::s_invalid)
       {
-        _localPosition = GetPos();
-        _localRotation = GetRotation();
-        _pParent->RemoveChild(this);
-        _pParent = nullptr;
+        Math::Vector3 pos = GetPos();
+        Math::Quaternion rotation = GetRotation();
+        pHierarchy->SetParent(_handle, TransformHierarchy::s_invalid);
+        pHierarchy->SetLocalPos(_handle, pos);
+        pHierarchy->SetLocalRotation(_handle, rotation);
         return;
       }
-      _pParent = parent;
-      if (_pParent)
-      {
-        parent->AddChild(this);
-      }
+      pHierarchy->SetParent(_handle, parentHandle);
+    }
+
+    Common::ITransform* Transform::GetParent()
+    {
+      TransformHierarchy* pHierarchy = TransformHierarchy::GetInstance();
+      uint32_t parentHandle = pHierarchy->GetParent(_handle);
+      if (parentHandle == TransformHierarchy::s_invalid)
+        return nullptr;
+      return pHierarchy->GetOwner(parentHandle);
     }
+
     Common::ITransform* Transform::Root() 
     {
       ITransform* pRoot = this;
@@ -75,80 +99,67 @@ namespace EAE_Engine
     // global transofrm
     Math::Vector3 Transform::GetPos() const
     { 
-      if (_pParent == nullptr)
-        return _localPosition;
-      else
-      {
-        Math::Vector4 localPos(_localPosition._x, _localPosition._y, _localPosition._z, 1.0f);
-        Math::Vector4 result = _pParent->GetLocalToWorldMatrix() * localPos;
-        return result;
-      }
+      return TransformHierarchy::GetInstance()->GetWorldPos(_handle);
     }
 
     void Transform::SetPos(const Math::Vector3& pos) 
     {
-      if (_pParent == nullptr)
-        _localPosition = pos;
+      TransformHierarchy* pHierarchy = TransformHierarchy::GetInstance();
+      uint32_t parentHandle = pHierarchy->GetParent(_handle);
+      if (parentHandle == TransformHierarchy::s_invalid)
+        pHierarchy->SetLocalPos(_handle, pos);
       else
-        _localPosition = pos - _pParent->GetPos();
+        pHierarchy->SetLocalPos(_handle, pos - pHierarchy->GetWorldPos(parentHandle));
     }
 
     Math::Quaternion Transform::GetRotation() const
     { 
-      if (_pParent == nullptr)
-        return _localRotation; 
-      else 
-      {
-        // From 3D Math Primier for Graphics and Game Development, 2nd:
-        // rotating by A and then by B is equivalent to performing a single rotation by the quaternion product b * a;
-        // the quaternion multiplication should be read from right to left.
-        return _pParent->GetRotation() * _localRotation;
-      }
+      // From 3D Math Primier for Graphics and Game Development, 2nd:
+      // rotating by A and then by B is equivalent to performing a single rotation by the quaternion product b * a;
+      // the quaternion multiplication should be read from right to left.
+      return TransformHierarchy::GetInstance()->GetWorldRotation(_handle);
     }
 
     void Transform::SetRotation(const Math::Quaternion& i_other) 
     { 
-      if (_pParent == nullptr)
-        _localRotation = i_other;
+      TransformHierarchy* pHierarchy = TransformHierarchy::GetInstance();
+      uint32_t parentHandle = pHierarchy->GetParent(_handle);
+      if (parentHandle == TransformHierarchy::s_invalid)
+        pHierarchy->SetLocalRotation(_handle, i_other);
       else 
       {
         // Because Parent * Local = Global, 
         // so the new Local = new Global * Parent.Inverse()
-        _localRotation = i_other * _pParent->GetRotation().GetInverse();
+        pHierarchy->SetLocalRotation(_handle, i_other * pHierarchy->GetWorldRotation(parentHandle).GetInverse());
       }
     }
 
     void Transform::SetScale(const Math::Vector3& scale) 
     {
+      TransformHierarchy* pHierarchy = TransformHierarchy::GetInstance();
       if (scale.Magnitude() < FLT_EPSILON) 
       {
-        _localScale = Math::Vector3::Zero;
+        pHierarchy->SetLocalScale(_handle, Math::Vector3::Zero);
         return;
       }
-      if (_pParent == nullptr)
-        _localScale = scale;
+      uint32_t parentHandle = pHierarchy->GetParent(_handle);
+      if (parentHandle == TransformHierarchy::s_invalid)
+        pHierarchy->SetLocalScale(_handle, scale);
       else 
       {
-        Math::Vector3 parentScale = _pParent->GetScale();
+        Math::Vector3 parentScale = pHierarchy->GetWorldScale(parentHandle);
         if (parentScale.Magnitude() < FLT_EPSILON)
         {
-          _localScale = scale;
+          pHierarchy->SetLocalScale(_handle, scale);
           return;
         }
-        _localScale = Math::Vector3(scale.x() / parentScale.x(), scale.y() / parentScale.y(), scale.z() / parentScale.z());
+        pHierarchy->SetLocalScale(_handle, Math::Vector3(scale.x() / parentScale.x(), scale.y() / parentScale.y(), scale.z() / parentScale.z()));
       }
     }
 
     Math::Vector3 Transform::GetScale() const
     {
-      if (_pParent == nullptr)
-        return _localScale;
-      else
-      {
-        Math::Vector3 parentScale = _pParent->GetScale();
-        Math::Vector3 result(parentScale.x()* _localScale.x(), parentScale.y()* _localScale.y(), parentScale.z()* _localScale.z());
-        return result;
-      }
+      return TransformHierarchy::GetInstance()->GetWorldScale(_handle);
     }
 
     Math::Vector3 Transform::GetEulerAngle() const
@@ -163,43 +174,40 @@ namespace EAE_Engine
     }
 
     // local transform
-    Math::Vector3& Transform::GetLocalPos() { return _localPosition; }
-    void Transform::SetLocalPos(const Math::Vector3& pos) { _localPosition = pos; }
-    Math::Quaternion& Transform::GetLocalRotation() { return _localRotation; }
-    void Transform::SetLocalRotation(const Math::Quaternion& i_other) { _localRotation = i_other; }
-    void Transform::SetLocalScale(const Math::Vector3& localScale) { _localScale = localScale; }
-    Math::Vector3 Transform::LocalScale() { return _localScale; }
-    Math::Vector3 Transform::GetLocalEulerAngle() { return Math::Quaternion::CreateEulerAngle(_localRotation); }
+    Math::Vector3 Transform::GetLocalPos() const { return TransformHierarchy::GetInstance()->LocalPos(_handle); }
+    void Transform::SetLocalPos(const Math::Vector3& pos) { TransformHierarchy::GetInstance()->SetLocalPos(_handle, pos); }
+    Math::Quaternion Transform::GetLocalRotation() const { return TransformHierarchy::GetInstance()->LocalRotation(_handle); }
+    void Transform::SetLocalRotation(const Math::Quaternion& i_other) { TransformHierarchy::GetInstance()->SetLocalRotation(_handle, i_other); }
+    void Transform::SetLocalScale(const Math::Vector3& localScale) { TransformHierarchy::GetInstance()->SetLocalScale(_handle, localScale); }
+    Math::Vector3 Transform::LocalScale() { return TransformHierarchy::GetInstance()->LocalScale(_handle); }
+    Math::Vector3 Transform::GetLocalEulerAngle() { return Math::Quaternion::CreateEulerAngle(TransformHierarchy::GetInstance()->LocalRotation(_handle)); }
     void Transform::SetLocalEulerAngle(const Math::Vector3& eulerAngle)
     {
       Math::Quaternion localrotation = Math::EulerAngle::GetQuaternion(eulerAngle);
-      _localRotation = localrotation;
+      TransformHierarchy::GetInstance()->SetLocalRotation(_handle, localrotation);
+    }
+    void Transform::Move(const Math::Vector3& i_movement) 
+    { 
+      TransformHierarchy* pHierarchy = TransformHierarchy::GetInstance();
+      pHierarchy->SetLocalPos(_handle, pHierarchy->LocalPos(_handle) + i_movement);
     }
-    void Transform::Move(const Math::Vector3& i_movement) { _localPosition = _localPosition + i_movement; }
     // Do rotation A, then do rotation B, equals to do rotation (BA)
-    void Transform::Rotate(const Math::Quaternion& i_other) { _localRotation = i_other * _localRotation; }
+    void Transform::Rotate(const Math::Quaternion& i_other) 
+    { 
+      TransformHierarchy* pHierarchy = TransformHierarchy::GetInstance();
+      pHierarchy->SetLocalRotation(_handle, i_other * pHierarchy->LocalRotation(_handle));
+    }
     // Transform Matrices
     Math::ColMatrix44 Transform::GetRotateTransformMatrix() const
     { 
-      Math::ColMatrix44 result;
-      if (_pParent) 
-        result = Math::ColMatrix44(GetRotation(), GetPos());
-      else 
-        result = Math::ColMatrix44(_localRotation, _localPosition);
-      return result;
+      return Math::ColMatrix44(GetRotation(), GetPos());
     }
 
     Math::ColMatrix44 Transform::GetLocalToWorldMatrix() const
     {
-      // When we want to get the transform Matrix of a Transform,
-      // we should use the Global Rotaion and Global Position,
-      // so we don't need to care the local position and how many parents it has.
-      Math::ColMatrix44 rotateTransMat = Math::ColMatrix44(_localRotation, _localPosition);
-      Math::ColMatrix44 localTransformMatrix = rotateTransMat * Math::ColMatrix44::CreateScaleMatrix(_localScale);
-      if (!_pParent)
-        return localTransformMatrix;
-      else
-        return _pParent->GetLocalToWorldMatrix() * localTransformMatrix;
+      // The world matrices are updated once per frame by the TransformHierarchy,
+      // it only recomputes the matrix when this transform or one of its parents has been changed.
+      return TransformHierarchy::GetInstance()->GetWorldMatrix(_handle);
     }
     Math::Vector3 Transform::GetForward() const
     {
@@ -5,7 +5,7 @@
 #include "Math/Vector.h"
 #include "Math/Quaternion.h"
 #include "Math/ColMatrix.h"
-#include <vector>
+#include <cstdint>
 
 namespace EAE_Engine
 {
@@ -34,9 +34,10 @@ namespace EAE_Engine
       Math::Vector3 GetEulerAngle() const override;
       void SetEulerAngle(Math::Vector3 eulerAngle) override;
       // local transform
-      Math::Vector3& GetLocalPos() override;
+      // Copies, write them back by SetLocalPos and SetLocalRotation.
+      Math::Vector3 GetLocalPos() const override;
       void SetLocalPos(const Math::Vector3&) override;
-      Math::Quaternion& GetLocalRotation() override;
+      Math::Quaternion GetLocalRotation() const override;
       void SetLocalRotation(const Math::Quaternion& i_other) override;
       void SetLocalScale(const Math::Vector3& localScale) override;
       Math::Vector3 LocalScale() override;
@@ -55,25 +56,23 @@ namespace EAE_Engine
       void RotateAround(Math::Vector3 point, Math::Vector3 axis, float radians) override;
 
       // Children
-      void AddChild(Common::ITransform* pChild) override { _children.push_back(pChild); }
+      void AddChild(Common::ITransform* pChild) override;
       void RemoveChild(Common::ITransform* pChild) override;
-      uint32_t GetChildCount() override { return (uint32_t)_children.size(); }
-      Common::ITransform* GetChild(uint32_t index = 0) override { return _children[index]; }
+      uint32_t GetChildCount() override;
+      Common::ITransform* GetChild(uint32_t index = 0) override;
       // Parent
       void SetParent(Common::ITransform* pParent) override;
-      Common::ITransform* GetParent() override { return _pParent; }
+      Common::ITransform* GetParent() override;
       Common::ITransform* Root();
+      // The handle of this transform in the TransformHierarchy.
+      uint32_t GetHandle() const { return _handle; }
 
     protected:
       Common::IGameObj* _pGamObj;//The game object this component is attached to. A component is always attached to a game object.
 
     private:
-      std::vector<Common::ITransform*> _children;
-      Common::ITransform* _pParent;
-
-      Math::Vector3 _localScale;
-      Math::Quaternion _localRotation;
-      Math::Vector3 _localPosition;
+      // The local TRS and the parent are kept in the TransformHierarchy.
+      uint32_t _handle;
     };
   }
 }
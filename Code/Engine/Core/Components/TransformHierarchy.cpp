@@ -0,0 +1,443 @@
+#include "TransformHierarchy.h"
+#include <algorithm>
+#include <cassert>
+
+namespace EAE_Engine
+{
+  namespace Core
+  {
+    const uint32_t TransformHierarchy::s_invalid;
+
+    TransformHierarchy::TransformHierarchy() : _orderDirty(false), _updatedCountOnLastPass(0)
+    {
+    }
+
+    TransformHierarchy::~TransformHierarchy()
+    {
+    }
+
+    uint32_t TransformHierarchy::AddTransform(Transform* pOwner)
+    {
+      uint32_t handle = s_invalid;
+      if (_freeHandles.size() > 0)
+      {
+        handle = _freeHandles.back();
+        _freeHandles.pop_back();
+      }
+      else
+      {
+        handle = (uint32_t)_handleToIndex.size();
+        _handleToIndex.push_back(s_invalid);
+        _parentHandles.push_back(s_invalid);
+        _firstChildHandles.push_back(s_invalid);
+        _nextSiblingHandles.push_back(s_invalid);
+        _movedHandles.push_back(0);
+      }
+      // A new transform is a root, so appending it to the end keeps the order valid.
+      uint32_t index = (uint32_t)_owners.size();
+      _handleToIndex[handle] = index;
+      _parentHandles[handle] = s_invalid;
+      _firstChildHandles[handle] = s_invalid;
+      _nextSiblingHandles[handle] = s_invalid;
+      _movedHandles[handle] = 0;
+      _localPositions.push_back(Math::Vector3::Zero);
+      _localRotations.push_back(Math::Quaternion::Identity);
+      _localScales.push_back(Math::Vector3(1.0f, 1.0f, 1.0f));
+      _parents.push_back(s_invalid);
+      _worldMatrices.push_back(Math::ColMatrix44::Identity);
+      _worldRotations.push_back(Math::Quaternion::Identity);
+      _worldScales.push_back(Math::Vector3(1.0f, 1.0f, 1.0f));
+      _dirty.push_back(1);
+      _owners.push_back(pOwner);
+      _indexToHandle.push_back(handle);
+      _rootGroups.clear();
+      _orderDirty = true;
+      return handle;
+    }
+
+    void TransformHierarchy::RemoveTransform(uint32_t handle)
+    {
+      // The children become roots and keep their world position and rotation.
+      while (_firstChildHandles[handle] != s_invalid)
+      {
+        uint32_t childHandle = _firstChildHandles[handle];
+        Math::Vector3 worldPos = GetWorldPos(childHandle);
+        Math::Quaternion worldRotation = GetWorldRotation(childHandle);
+        SetParent(childHandle, s_invalid);
+        SetLocalPos(childHandle, worldPos);
+        SetLocalRotation(childHandle, worldRotation);
+      }
+      Unlink(handle);
+      // Swap the last one into the removed slot.
+      uint32_t index = _handleToIndex[handle];
+      uint32_t lastIndex = (uint32_t)_owners.size() - 1;
+      if (index != lastIndex)
+      {
+        _localPositions[index] = _localPositions[lastIndex];
+        _localRotations[index] = _localRotations[lastIndex];
+        _localScales[index] = _localScales[lastIndex];
+        _parents[index] = _parents[lastIndex];
+        _worldMatrices[index] = _worldMatrices[lastIndex];
+        _worldRotations[index] = _worldRotations[lastIndex];
+        _worldScales[index] = _worldScales[lastIndex];
+        _dirty[index] = _dirty[lastIndex];
+        _owners[index] = _owners[lastIndex];
+        _indexToHandle[index] = _indexToHandle[lastIndex];
+        _handleToIndex[_indexToHandle[index]] = index;
+        // Only the children of the moved transform point at its old index.
+        for (uint32_t child = _firstChildHandles[_indexToHandle[index]]; child != s_invalid; child = _nextSiblingHandles[child])
+          _parents[_handleToIndex[child]] = index;
+      }
+      _localPositions.pop_back();
+      _localRotations.pop_back();
+      _localScales.pop_back();
+      _parents.pop_back();
+      _worldMatrices.pop_back();
+      _worldRotations.pop_back();
+      _worldScales.pop_back();
+      _dirty.pop_back();
+      _owners.pop_back();
+      _indexToHandle.pop_back();
+      _handleToIndex[handle] = s_invalid;
+      _movedHandles[handle] = 0;
+      _freeHandles.push_back(handle);
+      _rootGroups.clear();
+      _orderDirty = true;
+    }
+
+    void TransformHierarchy::Unlink(uint32_t handle)
+    {
+      uint32_t parentHandle = _parentHandles[handle];
+      if (parentHandle == s_invalid)
+        return;
+      uint32_t* pLink = &_firstChildHandles[parentHandle];
+      while (*pLink != s_invalid)
+      {
+        if (*pLink == handle)
+        {
+          *pLink = _nextSiblingHandles[handle];
+          break;
+        }
+        pLink = &_nextSiblingHandles[*pLink];
+      }
+      _nextSiblingHandles[handle] = s_invalid;
+      _parentHandles[handle] = s_invalid;
+      _parents[_handleToIndex[handle]] = s_invalid;
+    }
+
+    void TransformHierarchy::Link(uint32_t handle, uint32_t parentHandle)
+    {
+      if (parentHandle == s_invalid)
+        return;
+      // append to the end so GetChild keeps the order children were added in.
+      uint32_t* pLink = &_firstChildHandles[parentHandle];
+      while (*pLink != s_invalid)
+        pLink = &_nextSiblingHandles[*pLink];
+      *pLink = handle;
+      _parentHandles[handle] = parentHandle;
+      _parents[_handleToIndex[handle]] = _handleToIndex[parentHandle];
+    }
+
+    void TransformHierarchy::SetParent(uint32_t handle, uint32_t parentHandle)
+    {
+      if (_parentHandles[handle] == parentHandle)
+        return;
+      // Don't allow a transform to become a child of itself or its children.
+      for (uint32_t ancestor = parentHandle; ancestor != s_invalid; ancestor = _parentHandles[ancestor])
+      {
+        if (ancestor == handle)
+          return;
+      }
+      Unlink(handle);
+      Link(handle, parentHandle);
+      _dirty[_handleToIndex[handle]] = 1;
+      _rootGroups.clear();
+      _orderDirty = true;
+    }
+
+    uint32_t TransformHierarchy::GetParent(uint32_t handle) const
+    {
+      return _parentHandles[handle];
+    }
+
+    uint32_t TransformHierarchy::GetChildCount(uint32_t handle) const
+    {
+      uint32_t count = 0;
+      for (uint32_t child = _firstChildHandles[handle]; child != s_invalid; child = _nextSiblingHandles[child])
+        ++count;
+      return count;
+    }
+
+    uint32_t TransformHierarchy::GetChild(uint32_t handle, uint32_t childIndex) const
+    {
+      uint32_t child = _firstChildHandles[handle];
+      for (uint32_t i = 0; i < childIndex && child != s_invalid; ++i)
+        child = _nextSiblingHandles[child];
+      return child;
+    }
+
+    ///////////////////////////////////////World Values//////////////////////////////////////////
+
+    // The cached world values can be used only if the transform and all of its parents are clean.
+    bool TransformHierarchy::IsCached(uint32_t index) const
+    {
+      for (; index != s_invalid; index = _parents[index])
+      {
+        if (_dirty[index])
+          return false;
+      }
+      return true;
+    }
+
+    Math::ColMatrix44 TransformHierarchy::GetLocalMatrix(uint32_t index) const
+    {
+      Math::ColMatrix44 rotateTransMat = Math::ColMatrix44(_localRotations[index], _localPositions[index]);
+      return rotateTransMat * Math::ColMatrix44::CreateScaleMatrix(_localScales[index]);
+    }
+
+    Math::ColMatrix44 TransformHierarchy::ComputeWorldMatrix(uint32_t index) const
+    {
+      uint32_t parent = _parents[index];
+      if (parent == s_invalid)
+        return GetLocalMatrix(index);
+      if (IsCached(parent))
+        return _worldMatrices[parent] * GetLocalMatrix(index);
+      return ComputeWorldMatrix(parent) * GetLocalMatrix(index);
+    }
+
+    Math::Quaternion TransformHierarchy::ComputeWorldRotation(uint32_t index) const
+    {
+      uint32_t parent = _parents[index];
+      if (parent == s_invalid)
+        return _localRotations[index];
+      // rotating by A and then by B is equivalent to performing a single rotation by the quaternion product b * a;
+      if (IsCached(parent))
+        return _worldRotations[parent] * _localRotations[index];
+      return ComputeWorldRotation(parent) * _localRotations[index];
+    }
+
+    Math::Vector3 TransformHierarchy::ComputeWorldScale(uint32_t index) const
+    {
+      uint32_t parent = _parents[index];
+      const Math::Vector3& localScale = _localScales[index];
+      if (parent == s_invalid)
+        return localScale;
+      Math::Vector3 parentScale = IsCached(parent) ? _worldScales[parent] : ComputeWorldScale(parent);
+      return Math::Vector3(parentScale._x * localScale._x, parentScale._y * localScale._y, parentScale._z * localScale._z);
+    }
+
+    Math::ColMatrix44 TransformHierarchy::GetWorldMatrix(uint32_t handle) const
+    {
+      uint32_t index = _handleToIndex[handle];
+      if (IsCached(index))
+        return _worldMatrices[index];
+      return ComputeWorldMatrix(index);
+    }
+
+    Math::Quaternion TransformHierarchy::GetWorldRotation(uint32_t handle) const
+    {
+      uint32_t index = _handleToIndex[handle];
+      if (IsCached(index))
+        return _worldRotations[index];
+      return ComputeWorldRotation(index);
+    }
+
+    Math::Vector3 TransformHierarchy::GetWorldScale(uint32_t handle) const
+    {
+      uint32_t index = _handleToIndex[handle];
+      if (IsCached(index))
+        return _worldScales[index];
+      return ComputeWorldScale(index);
+    }
+
+    Math::Vector3 TransformHierarchy::GetWorldPos(uint32_t handle) const
+    {
+      uint32_t index = _handleToIndex[handle];
+      uint32_t parent = _parents[index];
+      if (parent == s_invalid)
+        return _localPositions[index];
+      const Math::Vector3& localPos = _localPositions[index];
+      Math::ColMatrix44 parentMatrix = IsCached(parent) ? _worldMatrices[parent] : ComputeWorldMatrix(parent);
+      return parentMatrix * Math::Vector4(localPos._x, localPos._y, localPos._z, 1.0f);
+    }
+
+    ///////////////////////////////////////Update//////////////////////////////////////////
+
+    // Re-sort the arrays: group by root, then by depth inside each group.
+    void TransformHierarchy::RebuildOrder()
+    {
+      uint32_t count = (uint32_t)_owners.size();
+      struct SortKey
+      {
+        uint32_t _root;
+        uint32_t _depth;
+        uint32_t _index;
+      };
+      std::vector<SortKey> keys(count);
+      for (uint32_t index = 0; index < count; ++index)
+      {
+        uint32_t root = index;
+        uint32_t depth = 0;
+        while (_parents[root] != s_invalid)
+        {
+          root = _parents[root];
+          ++depth;
+        }
+        keys[index] = { root, depth, index };
+      }
+      std::sort(keys.begin(), keys.end(), [](const SortKey& i_a, const SortKey& i_b)
+      {
+        if (i_a._root != i_b._root)
+          return i_a._root < i_b._root;
+        if (i_a._depth != i_b._depth)
+          return i_a._depth < i_b._depth;
+        return i_a._index < i_b._index;
+      });
+      std::vector<uint32_t> oldToNew(count);
+      for (uint32_t newIndex = 0; newIndex < count; ++newIndex)
+        oldToNew[keys[newIndex]._index] = newIndex;
+      // Gather all of the arrays in the new order.
+      {
+        std::vector<Math::Vector3> localPositions(count);
+        std::vector<Math::Quaternion> localRotations(count);
+        std::vector<Math::Vector3> localScales(count);
+        std::vector<uint32_t> parents(count);
+        std::vector<Math::ColMatrix44> worldMatrices(count);
+        std::vector<Math::Quaternion> worldRotations(count);
+        std::vector<Math::Vector3> worldScales(count);
+        std::vector<uint8_t> dirty(count);
+        std::vector<Transform*> owners(count);
+        std::vector<uint32_t> indexToHandle(count);
+        for (uint32_t newIndex = 0; newIndex < count; ++newIndex)
+        {
+          uint32_t oldIndex = keys[newIndex]._index;
+          localPositions[newIndex] = _localPositions[oldIndex];
+          localRotations[newIndex] = _localRotations[oldIndex];
+          localScales[newIndex] = _localScales[oldIndex];
+          parents[newIndex] = _parents[oldIndex] == s_invalid ? s_invalid : oldToNew[_parents[oldIndex]];
+          worldMatrices[newIndex] = _worldMatrices[oldIndex];
+          worldRotations[newIndex] = _worldRotations[oldIndex];
+          worldScales[newIndex] = _worldScales[oldIndex];
+          dirty[newIndex] = _dirty[oldIndex];
+          owners[newIndex] = _owners[oldIndex];
+          indexToHandle[newIndex] = _indexToHandle[oldIndex];
+          _handleToIndex[_indexToHandle[oldIndex]] = newIndex;
+        }
+        _localPositions.swap(localPositions);
+        _localRotations.swap(localRotations);
+        _localScales.swap(localScales);
+        _parents.swap(parents);
+        _worldMatrices.swap(worldMatrices);
+        _worldRotations.swap(worldRotations);
+        _worldScales.swap(worldScales);
+        _dirty.swap(dirty);
+        _owners.swap(owners);
+        _indexToHandle.swap(indexToHandle);
+      }
+      // Record where each root group begins.
+      _rootGroups.clear();
+      for (uint32_t index = 0; index < count; ++index)
+      {
+        if (_parents[index] == s_invalid)
+          _rootGroups.push_back(index);
+      }
+      _rootGroups.push_back(count);
+      _orderDirty = false;
+    }
+
+    // Since the parent is always in front of the child,
+    // the parent has been updated when we reach the child.
+    uint32_t TransformHierarchy::UpdateRange(uint32_t begin, uint32_t end, std::vector<uint32_t>& o_movedHandles)
+    {
+      uint32_t updatedCount = 0;
+      for (uint32_t index = begin; index < end; ++index)
+      {
+        uint32_t parent = _parents[index];
+        if (parent != s_invalid && _dirty[parent])
+          _dirty[index] = 1;
+        if (!_dirty[index])
+          continue;
+        Math::ColMatrix44 localMatrix = GetLocalMatrix(index);
+        const Math::Vector3& localScale = _localScales[index];
+        if (parent == s_invalid)
+        {
+          _worldMatrices[index] = localMatrix;
+          _worldRotations[index] = _localRotations[index];
+          _worldScales[index] = localScale;
+        }
+        else
+        {
+          _worldMatrices[index] = _worldMatrices[parent] * localMatrix;
+          _worldRotations[index] = _worldRotations[parent] * _localRotations[index];
+          const Math::Vector3& parentScale = _worldScales[parent];
+          _worldScales[index] = Math::Vector3(parentScale._x * localScale._x, parentScale._y * localScale._y, parentScale._z * localScale._z);
+        }
+        // Each handle is listed once until it is collected, however often it moves before that.
+        const uint32_t handle = _indexToHandle[index];
+        if (!_movedHandles[handle])
+        {
+          _movedHandles[handle] = 1;
+          o_movedHandles.push_back(handle);
+        }
+        ++updatedCount;
+      }
+      // Clean the flags after the whole range is done, the children need to see the dirty parents.
+      for (uint32_t index = begin; index < end; ++index)
+        _dirty[index] = 0;
+      return updatedCount;
+    }
+
+    void TransformHierarchy::CollectMovedHandles(std::vector<uint32_t>& o_handles)
+    {
+      for (std::vector<uint32_t>::const_iterator it = _movedList.begin(); it != _movedList.end(); ++it)
+      {
+        // The flag is cleared when the transform has been removed since it moved.
+        if (!_movedHandles[*it])
+          continue;
+        o_handles.push_back(*it);
+        _movedHandles[*it] = 0;
+      }
+      _movedList.clear();
+    }
+
+    void TransformHierarchy::UpdateWorldTransforms()
+    {
+      if (_orderDirty)
+        RebuildOrder();
+      const uint32_t count = (uint32_t)_owners.size();
+      const uint32_t workerCount = _workerPool.GetWorkerCount();
+      const uint32_t groupCount = _rootGroups.empty() ? 0 : (uint32_t)_rootGroups.size() - 1;
+      if (workerCount <= 1 || groupCount <= 1)
+      {
+        _updatedCountOnLastPass = UpdateRange(0, count, _movedList);
+        return;
+      }
+      // Split the root groups into ranges with roughly the same count of transforms.
+      _splits.clear();
+      _splits.push_back(0);
+      const uint32_t transformsPerWorker = (count + workerCount - 1) / workerCount;
+      for (uint32_t group = 1; group < groupCount; ++group)
+      {
+        if (_rootGroups[group] - _splits.back() >= transformsPerWorker)
+          _splits.push_back(_rootGroups[group]);
+      }
+      _splits.push_back(count);
+      const uint32_t rangeCount = (uint32_t)_splits.size() - 1;
+      _updatedCounts.assign(rangeCount, 0);
+      _workerMovedLists.resize(workerCount);
+      _workerPool.Run(rangeCount, [this](uint32_t range, uint32_t worker)
+      {
+        _updatedCounts[range] = UpdateRange(_splits[range], _splits[range + 1], _workerMovedLists[worker]);
+      });
+      _updatedCountOnLastPass = 0;
+      for (uint32_t range = 0; range < rangeCount; ++range)
+        _updatedCountOnLastPass += _updatedCounts[range];
+      for (uint32_t worker = 0; worker < workerCount; ++worker)
+      {
+        _movedList.insert(_movedList.end(), _workerMovedLists[worker].begin(), _workerMovedLists[worker].end());
+        _workerMovedLists[worker].clear();
+      }
+    }
+
+  }
+}
@@ -0,0 +1,137 @@
+#ifndef EAE_ENGINE_CORE_TRANSFORM_HIERARCHY_H
+#define EAE_ENGINE_CORE_TRANSFORM_HIERARCHY_H
+#include "Engine/General/Singleton.hpp"
+#include "Engine/General/WorkerPool.h"
+#include "Math/Vector.h"
+#include "Math/Quaternion.h"
+#include "Math/ColMatrix.h"
+#include <cstdint>
+#include <vector>
+
+namespace EAE_Engine
+{
+  namespace Core
+  {
+    class Transform;
+
+    /*
+     * Data oriented storage of all of the Transforms.
+     * The local TRS, the parent and the world values are kept in parallel arrays.
+     * The arrays are grouped by the root of each hierarchy and sorted by depth inside each group,
+     * so a parent is always in front of its children,
+     * and one linear pass can update all of the dirty world matrices.
+     * Each root group is independent from the others, so the pass can be split across threads by subtree.
+     * A Transform only keeps a handle, the handle stays the same when the arrays are re-sorted.
+     */
+    class TransformHierarchy : public Singleton<TransformHierarchy>
+    {
+    public:
+      static const uint32_t s_invalid = 0xffffffff;
+
+      TransformHierarchy();
+      ~TransformHierarchy();
+      uint32_t AddTransform(Transform* pOwner);
+      void RemoveTransform(uint32_t handle);
+      // Hierarchy
+      void SetParent(uint32_t handle, uint32_t parentHandle);
+      uint32_t GetParent(uint32_t handle) const;
+      uint32_t GetChildCount(uint32_t handle) const;
+      uint32_t GetChild(uint32_t handle, uint32_t childIndex) const;
+      Transform* GetOwner(uint32_t handle) const { return _owners[_handleToIndex[handle]]; }
+      // local transform, only the setters write it, so they can mark the transform as dirty.
+      // The arrays are re-sorted and reallocated, copy the values instead of keeping the references.
+      inline const Math::Vector3& LocalPos(uint32_t handle) const { return _localPositions[_handleToIndex[handle]]; }
+      inline const Math::Quaternion& LocalRotation(uint32_t handle) const { return _localRotations[_handleToIndex[handle]]; }
+      inline const Math::Vector3& LocalScale(uint32_t handle) const { return _localScales[_handleToIndex[handle]]; }
+      inline void SetLocalPos(uint32_t handle, const Math::Vector3& pos);
+      inline void SetLocalRotation(uint32_t handle, const Math::Quaternion& rotation);
+      inline void SetLocalScale(uint32_t handle, const Math::Vector3& scale);
+      inline void MarkDirty(uint32_t handle) { _dirty[_handleToIndex[handle]] = 1; }
+      // global transform,
+      // they use the cached values when the transform and all of its parents are clean.
+      Math::ColMatrix44 GetWorldMatrix(uint32_t handle) const;
+      Math::Quaternion GetWorldRotation(uint32_t handle) const;
+      Math::Vector3 GetWorldScale(uint32_t handle) const;
+      Math::Vector3 GetWorldPos(uint32_t handle) const;
+
+      // Update all of the dirty world matrices in one linear pass,
+      // the root groups are split across the workers when there are more than one.
+      void UpdateWorldTransforms();
+      void SetWorkerCount(uint32_t workerCount) { _workerPool.SetWorkerCount(workerCount); }
+      uint32_t GetWorkerCount() const { return _workerPool.GetWorkerCount(); }
+      uint32_t GetCount() const { return (uint32_t)_owners.size(); }
+      uint32_t GetUpdatedCountOnLastPass() const { return _updatedCountOnLastPass; }
+      // Append the handles whose world transform has been updated since the last call,
+      // so the spatial structures only need to update the transforms which have moved.
+      void CollectMovedHandles(std::vector<uint32_t>& o_handles);
+
+    private:
+      void RebuildOrder();
+      // The handles moved for the first time since the last CollectMovedHandles are appended to o_movedHandles.
+      uint32_t UpdateRange(uint32_t begin, uint32_t end, std::vector<uint32_t>& o_movedHandles);
+      bool IsCached(uint32_t index) const;
+      Math::ColMatrix44 GetLocalMatrix(uint32_t index) const;
+      Math::ColMatrix44 ComputeWorldMatrix(uint32_t index) const;
+      Math::Quaternion ComputeWorldRotation(uint32_t index) const;
+      Math::Vector3 ComputeWorldScale(uint32_t index) const;
+      void Unlink(uint32_t handle);
+      void Link(uint32_t handle, uint32_t parentHandle);
+
+    private:
+      // Parallel arrays, indexed by the position in the depth order.
+      std::vector<Math::Vector3> _localPositions;
+      std::vector<Math::Quaternion> _localRotations;
+      std::vector<Math::Vector3> _localScales;
+      std::vector<uint32_t> _parents; // index of the parent in the arrays
+      std::vector<Math::ColMatrix44> _worldMatrices;
+      std::vector<Math::Quaternion> _worldRotations;
+      std::vector<Math::Vector3> _worldScales;
+      std::vector<uint8_t> _dirty;
+      std::vector<Transform*> _owners;
+      std::vector<uint32_t> _indexToHandle;
+      // Indexed by handle.
+      std::vector<uint32_t> _handleToIndex;
+      std::vector<uint32_t> _parentHandles;
+      std::vector<uint32_t> _firstChildHandles;
+      std::vector<uint32_t> _nextSiblingHandles;
+      std::vector<uint32_t> _freeHandles;
+      // 1 when the world transform has been updated since the last CollectMovedHandles.
+      std::vector<uint8_t> _movedHandles;
+      // the handles flagged in _movedHandles, so CollectMovedHandles doesn't scan all of the handles.
+      std::vector<uint32_t> _movedList;
+      // [_rootGroups[i], _rootGroups[i + 1]) is the range of the ith root and all of its children.
+      std::vector<uint32_t> _rootGroups;
+      bool _orderDirty;
+      uint32_t _updatedCountOnLastPass;
+      WorkerPool _workerPool;
+      // the ranges of the root groups for the workers, and the count updated in each range, reused by each pass.
+      std::vector<uint32_t> _splits;
+      std::vector<uint32_t> _updatedCounts;
+      // the handles moved by each worker in a pass, merged into _movedList after it.
+      std::vector<std::vector<uint32_t> > _workerMovedLists;
+    };
+
+    inline void TransformHierarchy::SetLocalPos(uint32_t handle, const Math::Vector3& pos)
+    {
+      uint32_t index = _handleToIndex[handle];
+      _localPositions[index] = pos;
+      _dirty[index] = 1;
+    }
+
+    inline void TransformHierarchy::SetLocalRotation(uint32_t handle, const Math::Quaternion& rotation)
+    {
+      uint32_t index = _handleToIndex[handle];
+      _localRotations[index] = rotation;
+      _dirty[index] = 1;
+    }
+
+    inline void TransformHierarchy::SetLocalScale(uint32_t handle, const Math::Vector3& scale)
+    {
+      uint32_t index = _handleToIndex[handle];
+      _localScales[index] = scale;
+      _dirty[index] = 1;
+    }
+  }
+}
+
+#endif//EAE_ENGINE_CORE_TRANSFORM_HIERARCHY_H
@@ -1,6 +1,7 @@
 #include "World.h"
 #include "../Individual/GameObj.h"
 #include "../Components/Transform.h"
+#include "../Components/TransformHierarchy.h"
 
 namespace EAE_Engine
 {
@@ -17,6 +18,10 @@ namespace EAE_Engine
 			pTrans->SetLocalPos(localpos);
 			pObj->SetTransform(pTrans);
 			_gameObjList.push_back(pObj);
+			uint32_t handle = pTrans->GetHandle();
+			if (handle >= _proximityIds.size())
+				_proximityIds.resize(handle + 1, SpatialHashGrid::s_invalid);
+			_proximityIds[handle] = _proximityGrid.Insert(pTrans->GetPos(), 0.0f, pObj);
 			return pObj;
 		}
 
@@ -48,6 +53,7 @@ namespace EAE_Engine
 			{
 				GameObj* pObj = *it;
 				_gameObjList.erase(it);
+				RemoveFromProximityGrid(pTransform);
 				SAFE_DELETE(pTransform);
 				SAFE_DELETE(pObj);
 			}
@@ -63,6 +69,44 @@ namespace EAE_Engine
 				SAFE_DELETE(pObj);
 			}
 			_gameObjList.clear();
+			_proximityGrid.Clear();
+			_proximityIds.clear();
+		}
+
+		void World::UpdateProximityGrid()
+		{
+			_movedHandles.clear();
+			TransformHierarchy* pHierarchy = TransformHierarchy::GetInstance();
+			pHierarchy->CollectMovedHandles(_movedHandles);
+			for (std::vector<uint32_t>::const_iterator it = _movedHandles.begin(); it != _movedHandles.end(); ++it)
+			{
+				uint32_t handle = *it;
+				// The transforms which don't belong to a GameObj of the World are skipped.
+				if (handle >= _proximityIds.size() || _proximityIds[handle] == SpatialHashGrid::s_invalid)
+					continue;
+				_proximityGrid.Update(_proximityIds[handle], pHierarchy->GetWorldPos(handle), 0.0f);
+			}
+		}
+
+		uint32_t World::GetGameObjsInRadius(const Math::Vector3& i_center, float radius, Common::IGameObj** o_pGameObjs, uint32_t maxCount)
+		{
+			if (_queryIds.size() < maxCount)
+				_queryIds.resize(maxCount);
+			if (maxCount == 0)
+				return 0;
+			uint32_t count = _proximityGrid.QuerySphere(i_center, radius, &_queryIds[0], maxCount);
+			for (uint32_t index = 0; index < count; ++index)
+				o_pGameObjs[index] = static_cast<GameObj*>(_proximityGrid.GetUserData(_queryIds[index]));
+			return count;
+		}
+
+		void World::RemoveFromProximityGrid(Common::ITransform* pTransform)
+		{
+			uint32_t handle = static_cast<Transform*>(pTransform)->GetHandle();
+			if (handle >= _proximityIds.size() || _proximityIds[handle] == SpatialHashGrid::s_invalid)
+				return;
+			_proximityGrid.Remove(_proximityIds[handle]);
+			_proximityIds[handle] = SpatialHashGrid::s_invalid;
 		}
 
 		///////////////////////////////////static_members//////////////////////
@@ -3,6 +3,7 @@
 #include "Engine/General/EngineObj.h"
 #include "Engine/Common/Interfaces.h"
 #include "Engine/Math/Vector.h"
+#include "Engine/SpatialPartition/SpatialHashGrid.h"
 #include <vector>
 
 namespace EAE_Engine 
@@ -19,8 +20,23 @@ namespace EAE_Engine
 			Common::IGameObj* GetGameObj(const char* pName);
 			void Remove(Common::ITransform* pTransform);
 			void Clean();
+			// Move the GameObjs whose transforms have been updated by the last TransformHierarchy pass in the proximity grid.
+			void UpdateProximityGrid();
+			// The handles collected by the last UpdateProximityGrid, the transforms outside of the World included.
+			const std::vector<uint32_t>& GetMovedHandles() const { return _movedHandles; }
+			// Write the GameObjs within radius of i_center into o_pGameObjs, returns the count of them, at most maxCount.
+			uint32_t GetGameObjsInRadius(const Math::Vector3& i_center, float radius, Common::IGameObj** o_pGameObjs, uint32_t maxCount);
 			std::vector<GameObj*> _gameObjList;
 
+		private:
+			void RemoveFromProximityGrid(Common::ITransform* pTransform);
+			// The positions of the GameObjs, for the queries of everything near a point.
+			SpatialHashGrid _proximityGrid;
+			// The id in _proximityGrid of each transform handle.
+			std::vector<uint32_t> _proximityIds;
+			std::vector<uint32_t> _movedHandles;
+			std::vector<uint32_t> _queryIds;
+
 		/////////////////////////////static_members////////////////////////////////
 		private:
 			World() {}
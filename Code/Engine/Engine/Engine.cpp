@@ -1,5 +1,6 @@
 #include "Engine.h"
 #include "Core/Entirety/World.h"
+#include "Core/Components/TransformHierarchy.h"
 #include "Controller/Controller.h"
 #include "Time/Time.h"
 #include "Math/Quaternion.h"
@@ -38,6 +39,17 @@ namespace
 		_pRemoveList->clear();
 	}
 
+	// The sleeping RigidBodys don't look at their Transforms, so tell them about the Transforms moved in this frame.
+	// A Transform moved after UpdateWorldTransforms is noticed in the next frame.
+	void WakeUpMovedRigidBodies()
+	{
+		EAE_Engine::Core::TransformHierarchy* pHierarchy = EAE_Engine::Core::TransformHierarchy::GetInstance();
+		EAE_Engine::Physics::Physics* pPhysics = EAE_Engine::Physics::Physics::GetInstance();
+		const std::vector<uint32_t>& movedHandles = EAE_Engine::Core::World::GetInstance().GetMovedHandles();
+		for (std::vector<uint32_t>::const_iterator it = movedHandles.begin(); it != movedHandles.end(); ++it)
+			pPhysics->OnTransformMoved(pHierarchy->GetOwner(*it));
+	}
+
 }
 
 namespace EAE_Engine
@@ -74,6 +86,9 @@ namespace EAE_Engine
 			Controller::ControllerManager::GetInstance().Update();
 			Collider::ColliderManager::GetInstance()->Update();
 			FixedUpdate();
+			Core::TransformHierarchy::GetInstance()->UpdateWorldTransforms();
+			Core::World::GetInstance().UpdateProximityGrid();
+			WakeUpMovedRigidBodies();
 			Graphics::Render();
 			RemoveAllActorsInList();
 		}
@@ -94,6 +109,7 @@ namespace EAE_Engine
 			Debug::DebugShapes::CleanInstance();
 			Mesh::AOSMeshDataManager::Destroy();
 			Core::World::CleanInstance();
+			Core::TransformHierarchy::Destroy();
 			SAFE_DELETE(_pRemoveList);
 		}
 
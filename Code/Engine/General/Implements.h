@@ -4,6 +4,8 @@
 
 #include <cmath>
 #include <cstdio>
+#include <cstdint>
+#include <cstring>
 #include <float.h>
 #include "Engine/UserOutput/Source/Assert.h"
 
@@ -137,6 +139,32 @@ namespace EAE_Engine
 			return false;
 		}
 
+		// Maps the sign-magnitude bits of a float to a twos-complement int which has the same order as the float.
+		// For the negative numbers, x ^ 0x7fffffff - (-1) == 0x80000000 - x, so we can use the sign mask instead of a branch.
+		inline int32_t FloatToOrderedInt(float A)
+		{
+			int32_t aInt;
+			memcpy(&aInt, &A, sizeof(float));
+			int32_t signMask = aInt >> 31;
+			return (aInt ^ (signMask & 0x7fffffff)) - signMask;
+		}
+
+		// Branch free version of AlmostEqual2sComplement.
+		// The difference is computed in 64 bits, so the huge numbers with different signs can't overflow and wrap around.
+		inline bool AlmostEqualUlps(float A, float B, int maxUlps)
+		{
+			MessagedAssert(maxUlps > 0 && maxUlps < 4 * 1024 * 1024, "maxUlps should be non-negative and small enough");
+			int64_t intDiff = (int64_t)FloatToOrderedInt(A) - (int64_t)FloatToOrderedInt(B);
+			int64_t signMask = intDiff >> 63;
+			return ((intDiff ^ signMask) - signMask) <= (int64_t)maxUlps;
+		}
+
+		// Branch free absolute error test, returns true when |A - B| <= epsilon.
+		inline bool AlmostEqualAbsolute(float A, float B, float epsilon = FLT_EPSILON)
+		{
+			return fabsf(A - B) <= epsilon;
+		}
+
 
 		inline unsigned int GetStringLegth(const char* string)
 		{
@@ -24,7 +24,7 @@ namespace EAE_Engine
 	};
 
 	template<typename T>
-	typename T* Singleton<T>::_instance = 0;
+	T* Singleton<T>::_instance = 0;
 
 	template<typename T>
 	T* Singleton<T>::GetInstance()
@@ -0,0 +1,9 @@
+#ifndef TARGET_LINUX_H
+#define TARGET_LINUX_H
+
+#define CACHE_LINE_ALIGNMENT_BYTES	64
+
+#define DEBUGGER_BREAK __builtin_trap()
+
+
+#endif // TARGET_LINUX_H
\ No newline at end of file
@@ -4,13 +4,15 @@
 
 #if defined(_WIN32) || defined(WIN32)
 #include "Target.Win32.h"
+#elif defined(__linux__)
+#include "Target.Linux.h"
 #else
 #error "Must include platform target file."
 #endif // WIN32
 
 #ifndef CACHE_LINE_ALIGNMENT_BYTES
 #error "Must define CACHE_LINE_ALIGNMENT_BYTES."
-#endif CACHE_LINE_ALIGNMENT_BYTES
+#endif // CACHE_LINE_ALIGNMENT_BYTES
 
 
 #endif // TARGET_H
\ No newline at end of file
@@ -0,0 +1,108 @@
+#include "WorkerPool.h"
+#include <cassert>
+
+namespace EAE_Engine
+{
+  WorkerPool::WorkerPool(uint32_t workerCount) :
+    _pTask(nullptr), _taskCount(0), _nextTask(0), _generation(0), _busyThreads(0), _stop(false)
+  {
+    StartThreads(workerCount > 1 ? workerCount - 1 : 0);
+  }
+
+  WorkerPool::~WorkerPool()
+  {
+    StopThreads();
+  }
+
+  void WorkerPool::SetWorkerCount(uint32_t workerCount)
+  {
+    if (workerCount < 1)
+      workerCount = 1;
+    if (workerCount == GetWorkerCount())
+      return;
+    StopThreads();
+    StartThreads(workerCount - 1);
+  }
+
+  void WorkerPool::Run(uint32_t taskCount, const Task& task)
+  {
+    if (taskCount == 0)
+      return;
+    // Waking up the threads costs more than a single task.
+    if (taskCount == 1 || _threads.empty())
+    {
+      for (uint32_t taskIndex = 0; taskIndex < taskCount; ++taskIndex)
+        task(taskIndex, 0);
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      assert(_busyThreads == 0);
+      _pTask = &task;
+      _taskCount = taskCount;
+      _nextTask.store(0);
+      _busyThreads = (uint32_t)_threads.size();
+      ++_generation;
+    }
+    _wakeUp.notify_all();
+    RunTasks(0);
+    std::unique_lock<std::mutex> lock(_mutex);
+    _finished.wait(lock, [this]() { return _busyThreads == 0; });
+    _pTask = nullptr;
+  }
+
+  void WorkerPool::StartThreads(uint32_t threadCount)
+  {
+    uint64_t generation = 0;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _stop = false;
+      generation = _generation;
+    }
+    // A new thread only wakes up for the Runs after it starts, not for the ones already done.
+    for (uint32_t i = 0; i < threadCount; ++i)
+      _threads.push_back(std::thread(&WorkerPool::WorkerMain, this, i + 1, generation));
+  }
+
+  void WorkerPool::StopThreads()
+  {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _stop = true;
+    }
+    _wakeUp.notify_all();
+    for (std::vector<std::thread>::iterator it = _threads.begin(); it != _threads.end(); ++it)
+      it->join();
+    _threads.clear();
+  }
+
+  void WorkerPool::WorkerMain(uint32_t workerIndex, uint64_t generation)
+  {
+    for (;;)
+    {
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _wakeUp.wait(lock, [this, generation]() { return _stop || _generation != generation; });
+        if (_stop)
+          return;
+        generation = _generation;
+      }
+      RunTasks(workerIndex);
+      bool isLast = false;
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        isLast = --_busyThreads == 0;
+      }
+      if (isLast)
+        _finished.notify_one();
+    }
+  }
+
+  void WorkerPool::RunTasks(uint32_t workerIndex)
+  {
+    const Task& task = *_pTask;
+    const uint32_t taskCount = _taskCount;
+    for (uint32_t taskIndex = _nextTask.fetch_add(1); taskIndex < taskCount; taskIndex = _nextTask.fetch_add(1))
+      task(taskIndex, workerIndex);
+  }
+}
@@ -0,0 +1,59 @@
+#ifndef EAE_ENGINE_GENERAL_WORKER_POOL_H
+#define EAE_ENGINE_GENERAL_WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * A small pool of threads which are created once and reused by each Run,
+ * so a system running every FixedUpdate doesn't pay for creating and joining the threads each time.
+ * Run splits a job into taskCount independent tasks, the threads (the calling thread included)
+ * take the next task by an atomic counter until all of them are done, then Run returns.
+ * The order the tasks run in is not fixed, so each task should only write to its own output.
+ */
+namespace EAE_Engine
+{
+  class WorkerPool
+  {
+  public:
+    // task(taskIndex, workerIndex), workerIndex is in [0, GetWorkerCount()), the calling thread is worker 0.
+    typedef std::function<void(uint32_t, uint32_t)> Task;
+
+    // workerCount includes the calling thread, so 1 means running everything on the calling thread.
+    explicit WorkerPool(uint32_t workerCount = 1);
+    ~WorkerPool();
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    void SetWorkerCount(uint32_t workerCount);
+    uint32_t GetWorkerCount() const { return (uint32_t)_threads.size() + 1; }
+    void Run(uint32_t taskCount, const Task& task);
+
+  private:
+    void StartThreads(uint32_t threadCount);
+    void StopThreads();
+    // generation is the _generation when the thread starts.
+    void WorkerMain(uint32_t workerIndex, uint64_t generation);
+    void RunTasks(uint32_t workerIndex);
+
+  private:
+    std::vector<std::thread> _threads;
+    std::mutex _mutex;
+    std::condition_variable _wakeUp;
+    std::condition_variable _finished;
+    const Task* _pTask;
+    uint32_t _taskCount;
+    std::atomic<uint32_t> _nextTask;
+    // Increased by each Run, so a thread knows there is a new job.
+    uint64_t _generation;
+    uint32_t _busyThreads;
+    bool _stop;
+  };
+}
+
+#endif//EAE_ENGINE_GENERAL_WORKER_POOL_H
@@ -87,6 +87,21 @@ namespace EAE_Engine
       return CreateProjectClipMatrix(_fieldOfView_y, _aspectRatio, _z_nearPlane, _z_farPlane); 
     }
 
+    Math::PackedFrustum Camera::GetFrustum()
+    {
+      Math::ColMatrix44 worldToClip = GetProjClipMatrix() * GetWroldToViewMatrix();
+#if defined( EAEENGINE_PLATFORM_GL )
+      // The clip z of GL is in [-w, w], z' = 0.5 * z + 0.5 * w moves it to [0, w] like D3D for ComputeFrustum.
+      const Math::ColMatrix44 remapZ(
+        1.0f, 0.0f, 0.0f, 0.0f,
+        0.0f, 1.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, 0.5f, 0.0f,
+        0.0f, 0.0f, 0.5f, 1.0f);
+      worldToClip = remapZ * worldToClip;
+#endif
+      return Math::ComputeFrustum(worldToClip);
+    }
+
     Math::Vector3 Camera::ConvertWorldToViewport(const Math::Vector3& i_worldPos)
     {
       Math::Vector4 worldPos(i_worldPos.x(), i_worldPos.y(), i_worldPos.z(), 1.0f);
@@ -2,6 +2,7 @@
 #define EAEENGINE_GRPHICS_CAMERAH
 #include "Engine/Common/Interfaces.h"
 #include "Engine/Math/MathTool.h"
+#include "Engine/Math/SIMDGeometry.h"
 
 namespace EAE_Engine
 {
@@ -18,6 +19,8 @@ namespace EAE_Engine
 			Common::ITransform* GetTransform() { return _pTransform; }
 			Math::ColMatrix44 GetWroldToViewMatrix();
 			Math::ColMatrix44 GetProjClipMatrix();
+			// The planes of the view volume in the world space, for culling like CompleteOctree::VisitLeavesInFrustum.
+			Math::PackedFrustum GetFrustum();
 			Math::Vector3 ConvertWorldToViewport(const Math::Vector3& i_worldPos);
 			Math::Vector3 ConvertViewportToWorld(Math::Vector3& i_portPos);
 		private:
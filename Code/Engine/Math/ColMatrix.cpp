@@ -5,6 +5,8 @@
 #include <cmath>
 #include <cassert>
 #include "Quaternion.h"
+#include "FloatCompare.h"
+#include "MathTool.h"
 #include "General/MemoryOp.h"
 
 // Interface
@@ -56,14 +58,7 @@ namespace EAE_Engine
 
 		bool ColMatrix44::operator==(const ColMatrix44& i_other)
 		{
-			for (size_t index = 0; index < 16; ++index)
-			{
-				if (fabsf(_m[index] - i_other._m[index]) > FLT_EPSILON)
-				{
-					return false;
-				}
-			}
-			return true;
+			return AlmostEqualAbsolute(*this, i_other, FLT_EPSILON);
 		}
 
 		ColMatrix44 ColMatrix44::operator*(float i_other) const
@@ -315,7 +310,7 @@ namespace EAE_Engine
       float trace = i_rotation._m00 + i_rotation._m11 + i_rotation._m22;
       if (trace > 0) 
       {
-        float s = sqrtf(trace + 1.0f) * 2.0f; // S=4*qw 
+        float s = Sqrt(trace + 1.0f) * 2.0f; // S=4*qw 
         result._w = 0.25f * s;
         result._x = (i_rotation._m21 - i_rotation._m12) / s;
         result._y = (i_rotation._m02 - i_rotation._m20) / s;
@@ -323,7 +318,7 @@ namespace EAE_Engine
       }
       else if ((i_rotation._m00 > i_rotation._m11)&&(i_rotation._m00 > i_rotation._m22)) 
       {
-        float s = sqrtf(1.0f + i_rotation._m00 - i_rotation._m11 - i_rotation._m22) * 2.0f; // S=4*qx 
+        float s = Sqrt(1.0f + i_rotation._m00 - i_rotation._m11 - i_rotation._m22) * 2.0f; // S=4*qx 
         result._w = (i_rotation._m21 - i_rotation._m12) / s;
         result._x = 0.25f * s;
         result._y = (i_rotation._m01 + i_rotation._m10) / s;
@@ -331,7 +326,7 @@ namespace EAE_Engine
       }
       else if (i_rotation._m11 > i_rotation._m22) 
       {
-        float s = sqrtf(1.0f + i_rotation._m11 - i_rotation._m00 - i_rotation._m22) * 2.0f; // S=4*qy
+        float s = Sqrt(1.0f + i_rotation._m11 - i_rotation._m00 - i_rotation._m22) * 2.0f; // S=4*qy
         result._w = (i_rotation._m02 - i_rotation._m20) / s;
         result._x = (i_rotation._m01 + i_rotation._m10) / s;
         result._y = 0.25f * s;
@@ -339,7 +334,7 @@ namespace EAE_Engine
       }
       else
       {
-        float s = sqrtf(1.0f + i_rotation._m22 - i_rotation._m00 - i_rotation._m11) * 2.0f; // S=4*qz
+        float s = Sqrt(1.0f + i_rotation._m22 - i_rotation._m00 - i_rotation._m11) * 2.0f; // S=4*qz
         result._w = (i_rotation._m10 - i_rotation._m01) / s;
         result._x = (i_rotation._m02 + i_rotation._m20) / s;
         result._y = (i_rotation._m12 + i_rotation._m21) / s;
@@ -369,7 +364,7 @@ namespace EAE_Engine
         biggestIndex = 3;
       }
       // Perform square root and division
-      float biggestVal = sqrtf(fourBiggestSquaredMinus1 + 1.0f) * 0.5f;
+      float biggestVal = Sqrt(fourBiggestSquaredMinus1 + 1.0f) * 0.5f;
       float mult = 0.25f / biggestVal;
       // Apply table to compute quaternion values
       switch (biggestIndex) 
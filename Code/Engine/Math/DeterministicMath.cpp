@@ -0,0 +1,221 @@
+#include "DeterministicMath.h"
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define EAE_ENGINE_MATH_DETERMINISTIC_SSE2
+#endif
+#if defined(_MSC_VER)
+// Never fuse the multiply and add, the fused result is rounded only once.
+#pragma fp_contract(off)
+#endif
+
+namespace EAE_Engine
+{
+  namespace Math
+  {
+    namespace Deterministic
+    {
+      namespace
+      {
+        const float s_pi = 3.14159265358979f;
+        const float s_halfPi = 1.57079632679490f;
+        const float s_quarterPi = 0.785398163397448f;
+        const float s_fourOverPi = 1.27323954473516f;
+        // pi / 4 split into 3 parts, so y * s_dp1 and y * s_dp2 are exact.
+        const float s_dp1 = 0.78515625f;
+        const float s_dp2 = 2.4187564849853515625e-4f;
+        const float s_dp3 = 3.77489497744594108e-8f;
+        // The float reduction above loses its precision beyond this angle.
+        const float s_largeAngle = 8192.0f;
+        // pi / 4 split into 3 doubles for the large angles, accurate up to s_maxAngle.
+        const double s_fourOverPiLarge = 1.27323954473516268615;
+        const double s_dp1Large = 7.85398125648498535156e-1;
+        const double s_dp2Large = 3.77489470793079817668e-8;
+        const double s_dp3Large = 2.69515142907905952645e-15;
+
+        // sin(x) for x in [-pi/4, pi/4], z = x * x.
+        inline float SinPolynomial(float x, float z)
+        {
+          return ((-1.9515295891e-4f * z + 8.3321608736e-3f) * z - 1.6666654611e-1f) * z * x + x;
+        }
+
+        // cos(x) for x in [-pi/4, pi/4], z = x * x.
+        inline float CosPolynomial(float z)
+        {
+          return ((2.443315711809948e-5f * z - 1.388731625493765e-3f) * z + 4.166664568298827e-2f) * z * z - 0.5f * z + 1.0f;
+        }
+
+        // Reduce |radian| to [-pi/4, pi/4], octant is the index of the octant after merging the odd ones.
+        inline float ReduceAngle(float absRadian, int& o_octant)
+        {
+          if (absRadian > s_largeAngle)
+          {
+            // The same Cody-Waite reduction in double, the basic double operations are deterministic too.
+            assert(absRadian <= s_maxAngle);
+            const double x = absRadian;
+            int64_t octant = (int64_t)(x * s_fourOverPiLarge);
+            double y = (double)octant;
+            if (octant & 1)
+            {
+              octant += 1;
+              y += 1.0;
+            }
+            o_octant = (int)(octant & 7);
+            return (float)(((x - y * s_dp1Large) - y * s_dp2Large) - y * s_dp3Large);
+          }
+          int octant = (int)(absRadian * s_fourOverPi);
+          float y = (float)octant;
+          // map zeros to origin
+          if (octant & 1)
+          {
+            octant += 1;
+            y += 1.0f;
+          }
+          o_octant = octant & 7;
+          return ((absRadian - y * s_dp1) - y * s_dp2) - y * s_dp3;
+        }
+
+        // asin(x) for x in [0, 0.5], z = x * x.
+        inline float AsinPolynomial(float x, float z)
+        {
+          return ((((4.2163199048e-2f * z + 2.4181311049e-2f) * z + 4.5470025998e-2f) * z + 7.4953002686e-2f) * z + 1.6666752422e-1f) * z * x + x;
+        }
+      }
+
+      float Sin(float radian)
+      {
+        float sign = 1.0f;
+        // signbit keeps the sign of -0 like std::sin.
+        if (std::signbit(radian))
+        {
+          sign = -1.0f;
+          radian = -radian;
+        }
+        int octant = 0;
+        float x = ReduceAngle(radian, octant);
+        if (octant > 3)
+        {
+          sign = -sign;
+          octant -= 4;
+        }
+        float z = x * x;
+        float result = (octant == 1 || octant == 2) ? CosPolynomial(z) : SinPolynomial(x, z);
+        return sign * result;
+      }
+
+      float Cos(float radian)
+      {
+        float sign = 1.0f;
+        if (radian < 0.0f)
+          radian = -radian;
+        int octant = 0;
+        float x = ReduceAngle(radian, octant);
+        if (octant > 3)
+        {
+          sign = -sign;
+          octant -= 4;
+        }
+        if (octant > 1)
+          sign = -sign;
+        float z = x * x;
+        float result = (octant == 1 || octant == 2) ? SinPolynomial(x, z) : CosPolynomial(z);
+        return sign * result;
+      }
+
+      float Tan(float radian)
+      {
+        return Sin(radian) / Cos(radian);
+      }
+
+      float Asin(float value)
+      {
+        float sign = 1.0f;
+        if (std::signbit(value))
+        {
+          sign = -1.0f;
+          value = -value;
+        }
+        if (value > 1.0f)
+          return std::numeric_limits<float>::quiet_NaN();
+        float result = 0.0f;
+        if (value > 0.5f)
+        {
+          // asin(x) = pi/2 - 2 * asin(sqrt((1 - x) / 2))
+          float z = 0.5f * (1.0f - value);
+          float x = Sqrt(z);
+          result = AsinPolynomial(x, z);
+          result = s_halfPi - (result + result);
+        }
+        else
+        {
+          result = AsinPolynomial(value, value * value);
+        }
+        return sign * result;
+      }
+
+      float Acos(float value)
+      {
+        if (value < -1.0f || value > 1.0f)
+          return std::numeric_limits<float>::quiet_NaN();
+        if (value < -0.5f)
+          return s_pi - 2.0f * Asin(Sqrt(0.5f * (1.0f + value)));
+        if (value > 0.5f)
+          return 2.0f * Asin(Sqrt(0.5f * (1.0f - value)));
+        return s_halfPi - Asin(value);
+      }
+
+      float Atan(float value)
+      {
+        float sign = 1.0f;
+        if (std::signbit(value))
+        {
+          sign = -1.0f;
+          value = -value;
+        }
+        float offset = 0.0f;
+        // range reduction, tan(pi/8) = 0.414..., tan(3pi/8) = 2.414...
+        if (value > 2.414213562373095f)
+        {
+          offset = s_halfPi;
+          value = -1.0f / value;
+        }
+        else if (value > 0.4142135623730950f)
+        {
+          offset = s_quarterPi;
+          value = (value - 1.0f) / (value + 1.0f);
+        }
+        float z = value * value;
+        float result = (((8.05374449538e-2f * z - 1.38776856032e-1f) * z + 1.99777106478e-1f) * z - 3.33329491539e-1f) * z * value + value;
+        return sign * (offset + result);
+      }
+
+      float Atan2(float y, float x)
+      {
+        // The signs of the zeros pick the result like std::atan2, atan2(-0, -1) is -pi, atan2(+0, -0) is +pi.
+        const bool yNegative = std::signbit(y);
+        if (x == 0.0f)
+        {
+          if (y == 0.0f)
+            return std::signbit(x) ? (yNegative ? -s_pi : s_pi) : y;
+          return yNegative ? -s_halfPi : s_halfPi;
+        }
+        float result = Atan(y / x);
+        if (x < 0.0f)
+          result += yNegative ? -s_pi : s_pi;
+        return result;
+      }
+
+      float Sqrt(float value)
+      {
+#if defined(EAE_ENGINE_MATH_DETERMINISTIC_SSE2)
+        return _mm_cvtss_f32(_mm_sqrt_ss(_mm_set_ss(value)));
+#else
+        return std::sqrt(value);
+#endif
+      }
+    }
+  }
+}
@@ -0,0 +1,56 @@
+#ifndef EAE_ENGINE_MATH_DETERMINISTIC_MATH_H
+#define EAE_ENGINE_MATH_DETERMINISTIC_MATH_H
+
+/*
+ * The trigonometric functions of <cmath> come from the C runtime,
+ * so MSVC and GCC give different results for the same input.
+ * These versions only use +, -, *, / and the float <-> int conversions in a fixed order,
+ * which are the same on all of the IEEE 754 platforms,
+ * so the physics recorded on one platform can be replayed on another one.
+ * The polynomials come from the Cephes library, the error is within a few ulps of the std version.
+ * sqrt is correctly rounded by IEEE 754 on every platform, so Sqrt is just the SSE instruction.
+ *
+ * They only stay deterministic if the compiler doesn't contract a * b + c into an FMA instruction,
+ * doesn't reorder the float math, and rounds every operation to float.
+ * On Windows build with /p:DeterministicMath=true, which makes SolutionMacros.props import DeterministicMath.props
+ * into every project, to define EAE_ENGINE_DETERMINISTIC_MATH and /fp:strict everywhere,
+ * then the Sin, Cos, ... in MathTool.h use these versions.
+ * The Linux server has to build every library with the same settings as GCC or Clang flags:
+ *   -DEAE_ENGINE_DETERMINISTIC_MATH -ffp-contract=off
+ * and without -ffast-math (or -Ofast, -funsafe-math-optimizations, -fassociative-math),
+ * a 32 bit x86 build also needs -msse2 -mfpmath=sse, the x87 registers keep 80 bits between the operations.
+ * The #errors below catch the builds which can't be deterministic, -ffp-contract has no macro to check.
+ * The "deterministicmath" suite of EngineTests checks the hash of a fixed physics scene against the recorded one.
+ * The angles of Sin, Cos and Tan should be within s_maxAngle, beyond it a float can't tell 2 angles pi apart anyway.
+ * Unlike std::sin, ... these don't set errno or raise the floating point exceptions,
+ * the signs of the zeros are the same as the std versions.
+ */
+#if defined(EAE_ENGINE_DETERMINISTIC_MATH)
+#if defined(__FAST_MATH__) || defined(_M_FP_FAST)
+#error EAE_ENGINE_DETERMINISTIC_MATH can't be used with -ffast-math or /fp:fast, the compiler may reorder the float math.
+#endif
+#if (defined(__i386__) && !defined(__SSE2_MATH__)) || (defined(_M_IX86_FP) && _M_IX86_FP < 2)
+#error EAE_ENGINE_DETERMINISTIC_MATH needs the SSE2 float math on 32 bit x86, build with -msse2 -mfpmath=sse or /arch:SSE2.
+#endif
+#endif
+namespace EAE_Engine
+{
+  namespace Math
+  {
+    namespace Deterministic
+    {
+      // 2^30
+      const float s_maxAngle = 1073741824.0f;
+      float Sin(float radian);
+      float Cos(float radian);
+      float Tan(float radian);
+      float Asin(float value);
+      float Acos(float value);
+      float Atan(float value);
+      float Atan2(float y, float x);
+      float Sqrt(float value);
+    }
+  }
+}
+
+#endif//EAE_ENGINE_MATH_DETERMINISTIC_MATH_H
@@ -44,13 +44,13 @@ namespace EAE_Engine
       float pitch = eulerAngle._y;
       float heading = eulerAngle._z;
 
-      float chhalf = std::cosf(heading * 0.5f);
-      float cphalf = std::cosf(pitch * 0.5f);
-      float cbhalf = std::cosf(bank * 0.5f);
+      float chhalf = Cos(heading * 0.5f);
+      float cphalf = Cos(pitch * 0.5f);
+      float cbhalf = Cos(bank * 0.5f);
 
-      float shhalf = std::sinf(heading * 0.5f);
-      float sphalf = std::sinf(pitch * 0.5f);
-      float sbhalf = std::sinf(bank * 0.5f);
+      float shhalf = Sin(heading * 0.5f);
+      float sphalf = Sin(pitch * 0.5f);
+      float sbhalf = Sin(bank * 0.5f);
 
       Quaternion result = Quaternion::Identity;
       result._w = chhalf * cphalf * cbhalf + shhalf * sphalf * sbhalf;
@@ -78,13 +78,13 @@ namespace EAE_Engine
       float bank = eulerAngle._x;
       float pitch = eulerAngle._y;
       float heading = eulerAngle._z;
-      float ch = std::cosf(heading);
-      float cp = std::cosf(pitch);
-      float cb = std::cosf(bank);
+      float ch = Cos(heading);
+      float cp = Cos(pitch);
+      float cb = Cos(bank);
 
-      float sh = std::sinf(heading);
-      float sp = std::sinf(pitch);
-      float sb = std::sinf(bank);
+      float sh = Sin(heading);
+      float sp = Sin(pitch);
+      float sb = Sin(bank);
 
       ColMatrix44 result = ColMatrix44::Identity;
       result._m00 = ch * cb + sh * sp * sb;
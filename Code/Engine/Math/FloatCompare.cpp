@@ -0,0 +1,117 @@
+#include "FloatCompare.h"
+#include "Quaternion.h"
+#include "ColMatrix.h"
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define EAE_ENGINE_MATH_FLOAT_COMPARE_SSE2
+#endif
+
+namespace EAE_Engine
+{
+  namespace Math
+  {
+#if defined(EAE_ENGINE_MATH_FLOAT_COMPARE_SSE2)
+    namespace
+    {
+      // Same as Implements::FloatToOrderedInt.
+      inline __m128i FloatsToOrderedInts(__m128 values)
+      {
+        __m128i bits = _mm_castps_si128(values);
+        __m128i signMask = _mm_srai_epi32(bits, 31);
+        return _mm_sub_epi32(_mm_xor_si128(bits, _mm_and_si128(signMask, _mm_set1_epi32(0x7fffffff))), signMask);
+      }
+
+      // Returns the mask of the lanes which are NOT equal.
+      inline __m128i NotEqualUlps4(__m128 a, __m128 b, __m128i maxUlps)
+      {
+        __m128i aInt = FloatsToOrderedInts(a);
+        __m128i bInt = FloatsToOrderedInts(b);
+        __m128i diff = _mm_sub_epi32(aInt, bInt);
+        // The 32 bits subtraction overflows only when the signs are different and the sign of the result is wrong,
+        // in that case the 2 values are at least 2^31 ulps away.
+        __m128i overflow = _mm_srai_epi32(_mm_and_si128(_mm_xor_si128(aInt, bInt), _mm_xor_si128(aInt, diff)), 31);
+        __m128i diffSign = _mm_srai_epi32(diff, 31);
+        __m128i absDiff = _mm_sub_epi32(_mm_xor_si128(diff, diffSign), diffSign);
+        // abs(INT_MIN) is still negative, so treat the negative results as too far.
+        __m128i tooFar = _mm_or_si128(_mm_cmpgt_epi32(absDiff, maxUlps), _mm_cmplt_epi32(absDiff, _mm_setzero_si128()));
+        return _mm_or_si128(tooFar, overflow);
+      }
+
+      // Returns the mask of the lanes which are NOT equal, NaN is never equal to anything.
+      inline __m128 NotEqualAbsolute4(__m128 a, __m128 b, __m128 epsilon)
+      {
+        __m128 absDiff = _mm_andnot_ps(_mm_set1_ps(-0.0f), _mm_sub_ps(a, b));
+        // !(absDiff <= epsilon), so the NaNs are caught too.
+        return _mm_cmpnle_ps(absDiff, epsilon);
+      }
+    }
+#endif
+
+    bool AlmostEqualUlps(const float* i_pA, const float* i_pB, size_t count, int maxUlps)
+    {
+      MessagedAssert(maxUlps > 0 && maxUlps < 4 * 1024 * 1024, "maxUlps should be non-negative and small enough");
+      size_t index = 0;
+      bool result = true;
+#if defined(EAE_ENGINE_MATH_FLOAT_COMPARE_SSE2)
+      __m128i maxUlps4 = _mm_set1_epi32(maxUlps);
+      __m128i notEqual = _mm_setzero_si128();
+      for (; index + 4 <= count; index += 4)
+        notEqual = _mm_or_si128(notEqual, NotEqualUlps4(_mm_loadu_ps(i_pA + index), _mm_loadu_ps(i_pB + index), maxUlps4));
+      result = _mm_movemask_epi8(notEqual) == 0;
+#endif
+      for (; index < count; ++index)
+        result &= Implements::AlmostEqualUlps(i_pA[index], i_pB[index], maxUlps);
+      return result;
+    }
+
+    bool AlmostEqualAbsolute(const float* i_pA, const float* i_pB, size_t count, float epsilon)
+    {
+      size_t index = 0;
+      bool result = true;
+#if defined(EAE_ENGINE_MATH_FLOAT_COMPARE_SSE2)
+      __m128 epsilon4 = _mm_set1_ps(epsilon);
+      __m128 notEqual = _mm_setzero_ps();
+      for (; index + 4 <= count; index += 4)
+        notEqual = _mm_or_ps(notEqual, NotEqualAbsolute4(_mm_loadu_ps(i_pA + index), _mm_loadu_ps(i_pB + index), epsilon4));
+      result = _mm_movemask_ps(notEqual) == 0;
+#endif
+      for (; index < count; ++index)
+        result &= Implements::AlmostEqualAbsolute(i_pA[index], i_pB[index], epsilon);
+      return result;
+    }
+
+    bool AlmostEqualUlps(const Vector4& i_a, const Vector4& i_b, int maxUlps)
+    {
+      return AlmostEqualUlps(i_a._u, i_b._u, 4, maxUlps);
+    }
+
+    bool AlmostEqualAbsolute(const Vector4& i_a, const Vector4& i_b, float epsilon)
+    {
+      return AlmostEqualAbsolute(i_a._u, i_b._u, 4, epsilon);
+    }
+
+    bool AlmostEqualUlps(const Quaternion& i_a, const Quaternion& i_b, int maxUlps)
+    {
+      const float a[4] = { i_a.w(), i_a.x(), i_a.y(), i_a.z() };
+      const float b[4] = { i_b.w(), i_b.x(), i_b.y(), i_b.z() };
+      return AlmostEqualUlps(a, b, 4, maxUlps);
+    }
+
+    bool AlmostEqualAbsolute(const Quaternion& i_a, const Quaternion& i_b, float epsilon)
+    {
+      const float a[4] = { i_a.w(), i_a.x(), i_a.y(), i_a.z() };
+      const float b[4] = { i_b.w(), i_b.x(), i_b.y(), i_b.z() };
+      return AlmostEqualAbsolute(a, b, 4, epsilon);
+    }
+
+    bool AlmostEqualUlps(const ColMatrix44& i_a, const ColMatrix44& i_b, int maxUlps)
+    {
+      return AlmostEqualUlps(i_a._m, i_b._m, 16, maxUlps);
+    }
+
+    bool AlmostEqualAbsolute(const ColMatrix44& i_a, const ColMatrix44& i_b, float epsilon)
+    {
+      return AlmostEqualAbsolute(i_a._m, i_b._m, 16, epsilon);
+    }
+  }
+}
@@ -0,0 +1,41 @@
+#ifndef EAE_ENGINE_MATH_FLOAT_COMPARE_H
+#define EAE_ENGINE_MATH_FLOAT_COMPARE_H
+#include "Vector.h"
+#include <cstddef>
+
+namespace EAE_Engine
+{
+  namespace Math
+  {
+    class Quaternion;
+    class ColMatrix44;
+
+    // Compare 2 float arrays element by element, all of the elements should be equal.
+    // They use the same rules as Implements::AlmostEqualUlps and Implements::AlmostEqualAbsolute,
+    // but test 4 floats at a time with SSE2 and don't branch on each element.
+    bool AlmostEqualUlps(const float* i_pA, const float* i_pB, size_t count, int maxUlps);
+    bool AlmostEqualAbsolute(const float* i_pA, const float* i_pB, size_t count, float epsilon);
+
+    // Vector3 is too small for SIMD, so it uses the scalar version and combines the results without branches.
+    inline bool AlmostEqualUlps(const Vector3& i_a, const Vector3& i_b, int maxUlps)
+    {
+      return Implements::AlmostEqualUlps(i_a._x, i_b._x, maxUlps) &
+        Implements::AlmostEqualUlps(i_a._y, i_b._y, maxUlps) &
+        Implements::AlmostEqualUlps(i_a._z, i_b._z, maxUlps);
+    }
+    inline bool AlmostEqualAbsolute(const Vector3& i_a, const Vector3& i_b, float epsilon)
+    {
+      return Implements::AlmostEqualAbsolute(i_a._x, i_b._x, epsilon) &
+        Implements::AlmostEqualAbsolute(i_a._y, i_b._y, epsilon) &
+        Implements::AlmostEqualAbsolute(i_a._z, i_b._z, epsilon);
+    }
+    bool AlmostEqualUlps(const Vector4& i_a, const Vector4& i_b, int maxUlps);
+    bool AlmostEqualAbsolute(const Vector4& i_a, const Vector4& i_b, float epsilon);
+    bool AlmostEqualUlps(const Quaternion& i_a, const Quaternion& i_b, int maxUlps);
+    bool AlmostEqualAbsolute(const Quaternion& i_a, const Quaternion& i_b, float epsilon);
+    bool AlmostEqualUlps(const ColMatrix44& i_a, const ColMatrix44& i_b, int maxUlps);
+    bool AlmostEqualAbsolute(const ColMatrix44& i_a, const ColMatrix44& i_b, float epsilon);
+  }
+}
+
+#endif//EAE_ENGINE_MATH_FLOAT_COMPARE_H
@@ -33,16 +33,7 @@ namespace EAE_Engine
 		struct Triangle 
 		{
 			Triangle() = default;
-			union 
-			{
-				Vector3 _vertices[3];
-				struct 
-				{
-					Vector3 _vertex0;
-					Vector3 _vertex1;
-					Vector3 _vertex2;
-				};
-			};
+			Vector3 _vertices[3];
 		};
 
 		struct Sphere
@@ -50,10 +50,10 @@ namespace EAE_Engine
       float dot = Vector3::Dot(from, to);
       float sqmagnitude1 = from.SqMagnitude();
       float sqmagnitude2 = to.SqMagnitude();
-      float cosValue = dot / std::sqrt(sqmagnitude1 * sqmagnitude2);
+      float cosValue = dot / Sqrt(sqmagnitude1 * sqmagnitude2);
       // clamp the cosValue
       cosValue = clamp<float>(cosValue, -1.0f, 1.0f);
-      float radian = std::acosf(cosValue);
+      float radian = Acos(cosValue);
       return radian;
     }
 
@@ -1,6 +1,10 @@
 #ifndef EAE_ENGINE_MATH_TOOL_H
 #define EAE_ENGINE_MATH_TOOL_H
 #include <ctime>
+#include <cmath>
+#if defined(EAE_ENGINE_DETERMINISTIC_MATH)
+#include "DeterministicMath.h"
+#endif
 
 namespace EAE_Engine{
 	namespace Math{
@@ -68,6 +72,28 @@ namespace EAE_Engine{
 
     float Radian(const Vector3& from, const Vector3& to);
     float Degree(const Vector3& from, const Vector3& to);
+
+    // The math code should call these instead of <cmath>.
+    // Define EAE_ENGINE_DETERMINISTIC_MATH to get the same results with every compiler, see DeterministicMath.h.
+#if defined(EAE_ENGINE_DETERMINISTIC_MATH)
+    inline float Sin(float radian) { return Deterministic::Sin(radian); }
+    inline float Cos(float radian) { return Deterministic::Cos(radian); }
+    inline float Tan(float radian) { return Deterministic::Tan(radian); }
+    inline float Asin(float value) { return Deterministic::Asin(value); }
+    inline float Acos(float value) { return Deterministic::Acos(value); }
+    inline float Atan(float value) { return Deterministic::Atan(value); }
+    inline float Atan2(float y, float x) { return Deterministic::Atan2(y, x); }
+    inline float Sqrt(float value) { return Deterministic::Sqrt(value); }
+#else
+    inline float Sin(float radian) { return std::sin(radian); }
+    inline float Cos(float radian) { return std::cos(radian); }
+    inline float Tan(float radian) { return std::tan(radian); }
+    inline float Asin(float value) { return std::asin(value); }
+    inline float Acos(float value) { return std::acos(value); }
+    inline float Atan(float value) { return std::atan(value); }
+    inline float Atan2(float y, float x) { return std::atan2(y, x); }
+    inline float Sqrt(float value) { return std::sqrt(value); }
+#endif
 	}
 }
 
@@ -0,0 +1,361 @@
+#include "Quantization.h"
+#include "MathTool.h"
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define EAE_ENGINE_MATH_QUANTIZATION_SSE2
+#endif
+
+namespace EAE_Engine
+{
+  namespace Math
+  {
+    ///////////////////////////////////////Fixed Point//////////////////////////////////////////
+
+    FixedPointRange::FixedPointRange(float min, float max, uint32_t bitCount) :
+      _min(min), _max(max), _bitCount(bitCount)
+    {
+      assert(bitCount > 0 && bitCount <= 24 && "float can't keep more than 24 bits of precision.");
+      assert(max > min);
+      _maxQuantized = (1u << bitCount) - 1;
+      _step = (max - min) / (float)_maxQuantized;
+      _invStep = (float)_maxQuantized / (max - min);
+    }
+
+    uint32_t FixedPointRange::Quantize(float value) const
+    {
+      float clamped = clamp<float>(value, _min, _max);
+      uint32_t quantized = (uint32_t)((clamped - _min) * _invStep + 0.5f);
+      return quantized > _maxQuantized ? _maxQuantized : quantized;
+    }
+
+    float FixedPointRange::Dequantize(uint32_t quantized) const
+    {
+      if (quantized >= _maxQuantized)
+        return _max;
+      return _min + (float)quantized * _step;
+    }
+
+    FixedPointVector3::FixedPointVector3(const Vector3& min, const Vector3& max, uint32_t bitCount) :
+      _rangeX(min._x, max._x, bitCount), _rangeY(min._y, max._y, bitCount), _rangeZ(min._z, max._z, bitCount)
+    {
+    }
+
+    QuantizedVector3 FixedPointVector3::Quantize(const Vector3& value) const
+    {
+      QuantizedVector3 result;
+      result._x = _rangeX.Quantize(value._x);
+      result._y = _rangeY.Quantize(value._y);
+      result._z = _rangeZ.Quantize(value._z);
+      return result;
+    }
+
+    Vector3 FixedPointVector3::Dequantize(const QuantizedVector3& quantized) const
+    {
+      return Vector3(_rangeX.Dequantize(quantized._x), _rangeY.Dequantize(quantized._y), _rangeZ.Dequantize(quantized._z));
+    }
+
+    uint64_t FixedPointVector3::QuantizePacked(const Vector3& value) const
+    {
+      assert(_rangeX.GetBitCount() <= 21);
+      const uint32_t bitCount = _rangeX.GetBitCount();
+      QuantizedVector3 quantized = Quantize(value);
+      return (uint64_t)quantized._x | ((uint64_t)quantized._y << bitCount) | ((uint64_t)quantized._z << (bitCount * 2));
+    }
+
+    Vector3 FixedPointVector3::DequantizePacked(uint64_t packed) const
+    {
+      const uint32_t bitCount = _rangeX.GetBitCount();
+      const uint64_t mask = (1ull << bitCount) - 1;
+      QuantizedVector3 quantized;
+      quantized._x = (uint32_t)(packed & mask);
+      quantized._y = (uint32_t)((packed >> bitCount) & mask);
+      quantized._z = (uint32_t)((packed >> (bitCount * 2)) & mask);
+      return Dequantize(quantized);
+    }
+
+    Vector3 FixedPointVector3::GetMaxError() const
+    {
+      return Vector3(_rangeX.GetMaxError(), _rangeY.GetMaxError(), _rangeZ.GetMaxError());
+    }
+
+    ///////////////////////////////////////Rotation//////////////////////////////////////////
+
+    namespace
+    {
+      const float s_smallestThreeBound = 0.707106781f; // 1 / sqrt(2)
+      const uint32_t s_smallestThreeBits = 10;
+      const uint32_t s_smallestThreeMax = (1u << s_smallestThreeBits) - 1;
+    }
+    // The stored components are off by half of a step at most,
+    // the rebuilt one collects the error of all 3 others, so give it 2 steps.
+    const float s_quaternionMaxError = 2.0f * (s_smallestThreeBound * 2.0f / (float)s_smallestThreeMax);
+
+    uint32_t QuantizeQuaternion(const Quaternion& rotation)
+    {
+      Quaternion normalized = rotation.CreateNormalized();
+      float components[4] = { normalized.w(), normalized.x(), normalized.y(), normalized.z() };
+      uint32_t largestIndex = 0;
+      for (uint32_t i = 1; i < 4; ++i)
+      {
+        if (Abs(components[i]) > Abs(components[largestIndex]))
+          largestIndex = i;
+      }
+      // q and -q are the same rotation, so make the dropped one positive.
+      float sign = components[largestIndex] < 0.0f ? -1.0f : 1.0f;
+      uint32_t result = largestIndex;
+      uint32_t shift = 2;
+      for (uint32_t i = 0; i < 4; ++i)
+      {
+        if (i == largestIndex)
+          continue;
+        float value = clamp<float>(components[i] * sign, -s_smallestThreeBound, s_smallestThreeBound);
+        float normalizedValue = (value + s_smallestThreeBound) / (2.0f * s_smallestThreeBound);
+        uint32_t quantized = (uint32_t)(normalizedValue * (float)s_smallestThreeMax + 0.5f);
+        result |= quantized << shift;
+        shift += s_smallestThreeBits;
+      }
+      return result;
+    }
+
+    Quaternion DequantizeQuaternion(uint32_t quantized)
+    {
+      uint32_t largestIndex = quantized & 0x3;
+      float components[4];
+      float sqSum = 0.0f;
+      uint32_t shift = 2;
+      for (uint32_t i = 0; i < 4; ++i)
+      {
+        if (i == largestIndex)
+          continue;
+        uint32_t value = (quantized >> shift) & s_smallestThreeMax;
+        components[i] = (float)value / (float)s_smallestThreeMax * (2.0f * s_smallestThreeBound) - s_smallestThreeBound;
+        sqSum += components[i] * components[i];
+        shift += s_smallestThreeBits;
+      }
+      components[largestIndex] = std::sqrt(max<float>(0.0f, 1.0f - sqSum));
+      Quaternion result(components[0], components[1], components[2], components[3]);
+      result.Normalize();
+      return result;
+    }
+
+    ///////////////////////////////////////Normal//////////////////////////////////////////
+
+    namespace
+    {
+      inline float SignNotZero(float value)
+      {
+        return value >= 0.0f ? 1.0f : -1.0f;
+      }
+
+      inline uint32_t ToSnorm16(float value)
+      {
+        float clamped = clamp<float>(value, -1.0f, 1.0f);
+        int32_t snorm = (int32_t)std::floor(clamped * 32767.0f + 0.5f);
+        return (uint32_t)(snorm & 0xffff);
+      }
+
+      inline float FromSnorm16(uint32_t value)
+      {
+        int16_t snorm = (int16_t)(uint16_t)value;
+        return max<float>((float)snorm / 32767.0f, -1.0f);
+      }
+    }
+
+    uint32_t QuantizeNormal(const Vector3& normal)
+    {
+      float l1Norm = Abs(normal._x) + Abs(normal._y) + Abs(normal._z);
+      if (l1Norm < FLT_EPSILON)
+        return ToSnorm16(0.0f) | (ToSnorm16(0.0f) << 16);
+      float u = normal._x / l1Norm;
+      float v = normal._y / l1Norm;
+      // fold the lower half of the octahedron over the upper half.
+      if (normal._z < 0.0f)
+      {
+        float foldedU = (1.0f - Abs(v)) * SignNotZero(u);
+        float foldedV = (1.0f - Abs(u)) * SignNotZero(v);
+        u = foldedU;
+        v = foldedV;
+      }
+      return ToSnorm16(u) | (ToSnorm16(v) << 16);
+    }
+
+    Vector3 DequantizeNormal(uint32_t quantized)
+    {
+      float u = FromSnorm16(quantized & 0xffff);
+      float v = FromSnorm16(quantized >> 16);
+      Vector3 result(u, v, 1.0f - Abs(u) - Abs(v));
+      // unfold the lower half.
+      float t = max<float>(-result._z, 0.0f);
+      result._x += result._x >= 0.0f ? -t : t;
+      result._y += result._y >= 0.0f ? -t : t;
+      return result.GetNormalize();
+    }
+
+    ///////////////////////////////////////Half//////////////////////////////////////////
+
+    namespace
+    {
+      inline uint32_t FloatAsUInt(float value)
+      {
+        uint32_t result;
+        std::memcpy(&result, &value, sizeof(float));
+        return result;
+      }
+
+      inline float UIntAsFloat(uint32_t value)
+      {
+        float result;
+        std::memcpy(&result, &value, sizeof(float));
+        return result;
+      }
+
+      const uint32_t s_f32Infinity = 255u << 23;
+      // The smallest float which is too large for half.
+      const uint32_t s_f16Overflow = (127u + 16u) << 23;
+      // Smaller than this becomes a half denormal.
+      const uint32_t s_f16MinNormal = 113u << 23;
+      // Adding this float shifts the denormal mantissa to the low bits with round to nearest even.
+      const uint32_t s_denormMagic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+      const uint32_t s_halfExponentMask = 0x7c00u << 13;
+    }
+
+    // The idea comes from Fabian Giesen's float_to_half_fast3_rtne and half_to_float_fast5.
+    uint16_t FloatToHalf(float value)
+    {
+      uint32_t bits = FloatAsUInt(value);
+      uint32_t sign = bits & 0x80000000u;
+      bits ^= sign;
+      uint32_t result = 0;
+      if (bits >= s_f16Overflow)
+      {
+        // Inf or NaN, all of the NaNs become the quiet NaN.
+        result = bits > s_f32Infinity ? 0x7e00u : 0x7c00u;
+      }
+      else if (bits < s_f16MinNormal)
+      {
+        // The float add does the rounding for us.
+        result = FloatAsUInt(UIntAsFloat(bits) + UIntAsFloat(s_denormMagic)) - s_denormMagic;
+      }
+      else
+      {
+        uint32_t mantissaOdd = (bits >> 13) & 1;
+        // re-bias the exponent and round.
+        bits += ((uint32_t)(15 - 127) << 23) + 0xfff;
+        bits += mantissaOdd;
+        result = bits >> 13;
+      }
+      return (uint16_t)(result | (sign >> 16));
+    }
+
+    float HalfToFloat(uint16_t half)
+    {
+      uint32_t bits = ((uint32_t)half & 0x7fffu) << 13;
+      uint32_t exponent = bits & s_halfExponentMask;
+      bits += (127u - 15u) << 23;
+      if (exponent == s_halfExponentMask)
+      {
+        // Inf or NaN
+        bits += (128u - 16u) << 23;
+      }
+      else if (exponent == 0)
+      {
+        // Zero or denormal, renormalize it.
+        bits += 1u << 23;
+        bits = FloatAsUInt(UIntAsFloat(bits) - UIntAsFloat(s_f16MinNormal));
+      }
+      bits |= ((uint32_t)half & 0x8000u) << 16;
+      return UIntAsFloat(bits);
+    }
+
+#if defined(EAE_ENGINE_MATH_QUANTIZATION_SSE2)
+    namespace
+    {
+      // mask ? a : b
+      inline __m128i Select(__m128i mask, __m128i a, __m128i b)
+      {
+        return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+      }
+
+      // Same steps as FloatToHalf, the branches are replaced by masks.
+      inline __m128i FloatsToHalves4(__m128 values)
+      {
+        const __m128i signMask = _mm_set1_epi32((int)0x80000000u);
+        __m128i bits = _mm_castps_si128(values);
+        __m128i sign = _mm_and_si128(bits, signMask);
+        bits = _mm_xor_si128(bits, sign);
+        // Inf or NaN
+        __m128i overflowMask = _mm_cmpgt_epi32(bits, _mm_set1_epi32((int)(s_f16Overflow - 1)));
+        __m128i nanMask = _mm_cmpgt_epi32(bits, _mm_set1_epi32((int)s_f32Infinity));
+        __m128i infNan = _mm_or_si128(_mm_set1_epi32(0x7c00), _mm_and_si128(nanMask, _mm_set1_epi32(0x0200)));
+        // Denormal
+        __m128i denormMask = _mm_cmplt_epi32(bits, _mm_set1_epi32((int)s_f16MinNormal));
+        __m128 denormMagic = _mm_castsi128_ps(_mm_set1_epi32((int)s_denormMagic));
+        __m128i denorm = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(bits), denormMagic)), _mm_set1_epi32((int)s_denormMagic));
+        // Normal
+        __m128i mantissaOdd = _mm_and_si128(_mm_srli_epi32(bits, 13), _mm_set1_epi32(1));
+        __m128i normal = _mm_add_epi32(bits, _mm_set1_epi32((int)(((uint32_t)(15 - 127) << 23) + 0xfff)));
+        normal = _mm_srli_epi32(_mm_add_epi32(normal, mantissaOdd), 13);
+        __m128i result = Select(denormMask, denorm, normal);
+        result = Select(overflowMask, infNan, result);
+        return _mm_or_si128(result, _mm_srli_epi32(sign, 16));
+      }
+
+      // Same steps as HalfToFloat.
+      inline __m128 HalvesToFloats4(__m128i halves)
+      {
+        const __m128i exponentMask = _mm_set1_epi32((int)s_halfExponentMask);
+        __m128i bits = _mm_slli_epi32(_mm_and_si128(halves, _mm_set1_epi32(0x7fff)), 13);
+        __m128i exponent = _mm_and_si128(bits, exponentMask);
+        bits = _mm_add_epi32(bits, _mm_set1_epi32((int)((127u - 15u) << 23)));
+        // Inf or NaN
+        __m128i infNanMask = _mm_cmpeq_epi32(exponent, exponentMask);
+        bits = _mm_add_epi32(bits, _mm_and_si128(infNanMask, _mm_set1_epi32((int)((128u - 16u) << 23))));
+        // Zero or denormal
+        __m128i denormMask = _mm_cmpeq_epi32(exponent, _mm_setzero_si128());
+        __m128 denorm = _mm_sub_ps(_mm_castsi128_ps(_mm_add_epi32(bits, _mm_set1_epi32(1 << 23))), _mm_castsi128_ps(_mm_set1_epi32((int)s_f16MinNormal)));
+        bits = Select(denormMask, _mm_castps_si128(denorm), bits);
+        bits = _mm_or_si128(bits, _mm_slli_epi32(_mm_and_si128(halves, _mm_set1_epi32(0x8000)), 16));
+        return _mm_castsi128_ps(bits);
+      }
+    }
+#endif
+
+    void FloatsToHalves(const float* i_pFloats, uint16_t* o_pHalves, size_t count)
+    {
+      size_t i = 0;
+#if defined(EAE_ENGINE_MATH_QUANTIZATION_SSE2)
+      for (; i + 8 <= count; i += 8)
+      {
+        __m128i low = FloatsToHalves4(_mm_loadu_ps(i_pFloats + i));
+        __m128i high = FloatsToHalves4(_mm_loadu_ps(i_pFloats + i + 4));
+        // SSE2 doesn't have the unsigned pack, so sign extend the low 16 bits and use the signed pack.
+        low = _mm_srai_epi32(_mm_slli_epi32(low, 16), 16);
+        high = _mm_srai_epi32(_mm_slli_epi32(high, 16), 16);
+        _mm_storeu_si128((__m128i*)(o_pHalves + i), _mm_packs_epi32(low, high));
+      }
+#endif
+      for (; i < count; ++i)
+        o_pHalves[i] = FloatToHalf(i_pFloats[i]);
+    }
+
+    void HalvesToFloats(const uint16_t* i_pHalves, float* o_pFloats, size_t count)
+    {
+      size_t i = 0;
+#if defined(EAE_ENGINE_MATH_QUANTIZATION_SSE2)
+      for (; i + 8 <= count; i += 8)
+      {
+        __m128i halves = _mm_loadu_si128((const __m128i*)(i_pHalves + i));
+        _mm_storeu_ps(o_pFloats + i, HalvesToFloats4(_mm_unpacklo_epi16(halves, _mm_setzero_si128())));
+        _mm_storeu_ps(o_pFloats + i + 4, HalvesToFloats4(_mm_unpackhi_epi16(halves, _mm_setzero_si128())));
+      }
+#endif
+      for (; i < count; ++i)
+        o_pFloats[i] = HalfToFloat(i_pHalves[i]);
+    }
+
+  }
+}
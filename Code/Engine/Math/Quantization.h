@@ -0,0 +1,98 @@
+#ifndef EAE_ENGINE_MATH_QUANTIZATION_H
+#define EAE_ENGINE_MATH_QUANTIZATION_H
+#include "Vector.h"
+#include "Quaternion.h"
+#include <cstdint>
+#include <cstddef>
+
+/*
+ * Helpers to trade precision for bandwidth and memory.
+ * Each encoding documents its worst case error, so the caller can pick the bit count it can afford.
+ */
+namespace EAE_Engine
+{
+  namespace Math
+  {
+    ///////////////////////////////////////Fixed Point//////////////////////////////////////////
+
+    // Maps [min, max] to the integers [0, 2^bitCount - 1].
+    // Values outside of the range are clamped.
+    // The error after a round trip is at most GetMaxError() = (max - min) / (2^bitCount - 1) / 2.
+    class FixedPointRange
+    {
+    public:
+      FixedPointRange(float min, float max, uint32_t bitCount);
+      uint32_t Quantize(float value) const;
+      float Dequantize(uint32_t quantized) const;
+      float GetMaxError() const { return _step * 0.5f; }
+      uint32_t GetBitCount() const { return _bitCount; }
+
+    private:
+      float _min;
+      float _max;
+      float _step;
+      float _invStep;
+      uint32_t _maxQuantized;
+      uint32_t _bitCount;
+    };
+
+    struct QuantizedVector3
+    {
+      uint32_t _x;
+      uint32_t _y;
+      uint32_t _z;
+    };
+
+    // A range bounded vector, e.g. a position inside of the level bounds.
+    class FixedPointVector3
+    {
+    public:
+      FixedPointVector3(const Vector3& min, const Vector3& max, uint32_t bitCount);
+      QuantizedVector3 Quantize(const Vector3& value) const;
+      Vector3 Dequantize(const QuantizedVector3& quantized) const;
+      // Packs all of the 3 axises in one uint64_t, so the bitCount can't be larger than 21.
+      uint64_t QuantizePacked(const Vector3& value) const;
+      Vector3 DequantizePacked(uint64_t packed) const;
+      Vector3 GetMaxError() const;
+
+    private:
+      FixedPointRange _rangeX;
+      FixedPointRange _rangeY;
+      FixedPointRange _rangeZ;
+    };
+
+    ///////////////////////////////////////Rotation//////////////////////////////////////////
+
+    // Smallest three encoding:
+    // q and -q are the same rotation, so we can drop the largest component and rebuild it from the other three,
+    // the other three are in [-1/sqrt(2), 1/sqrt(2)].
+    // The result uses 2 bits for the index of the dropped component and 10 bits for each of the others.
+    // The error of each component is at most s_quaternionMaxError.
+    uint32_t QuantizeQuaternion(const Quaternion& rotation);
+    Quaternion DequantizeQuaternion(uint32_t quantized);
+    extern const float s_quaternionMaxError;
+
+    ///////////////////////////////////////Normal//////////////////////////////////////////
+
+    // Octahedral encoding:
+    // project the unit vector onto an octahedron, then unfold the octahedron into a square.
+    // The 2 coordinates in the square are stored as 16 bits snorm.
+    // The angle between the input and the decoded normal is less than 0.0001 radian.
+    uint32_t QuantizeNormal(const Vector3& normal);
+    Vector3 DequantizeNormal(uint32_t quantized);
+
+    ///////////////////////////////////////Half//////////////////////////////////////////
+
+    // IEEE 754 binary16, rounds to nearest even.
+    // The values larger than 65504 become infinity, the NaNs stay NaN, the small values become denormals.
+    // The relative error of the normalized values is at most 2^-11.
+    uint16_t FloatToHalf(float value);
+    float HalfToFloat(uint16_t half);
+    // Batch version, they convert 4 values at a time with SSE2 when it is available,
+    // the results are the same as the single value version.
+    void FloatsToHalves(const float* i_pFloats, uint16_t* o_pHalves, size_t count);
+    void HalvesToFloats(const uint16_t* i_pHalves, float* o_pFloats, size_t count);
+  }
+}
+
+#endif//EAE_ENGINE_MATH_QUANTIZATION_H
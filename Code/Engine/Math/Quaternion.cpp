@@ -116,12 +116,12 @@ namespace EAE_Engine
       {
         // cos(theta/2.0f) = _w, 
         // theta is the actually angle this quaternion rotates
-        float half_Theta = std::acosf(_w);
+        float half_Theta = Acos(_w);
         float newHalfTheta = half_Theta * exponent;
         // update w
-        _w = std::cosf(newHalfTheta);
+        _w = Cos(newHalfTheta);
         // update x, y, z
-        float mult = std::sinf(newHalfTheta) / std::sinf(half_Theta);
+        float mult = Sin(newHalfTheta) / Sin(half_Theta);
         _x *= mult;
         _y *= mult;
         _z *= mult;
@@ -140,7 +140,7 @@ namespace EAE_Engine
     // Normalization
     void Quaternion::Normalize()
     {
-      const float length = std::sqrt((_w * _w) + (_x * _x) + (_y * _y) + (_z * _z));
+      const float length = Sqrt((_w * _w) + (_x * _x) + (_y * _y) + (_z * _z));
       assert(length > s_epsilon);
       const float length_reciprocal = 1.0f / length;
       _w *= length_reciprocal;
@@ -151,7 +151,7 @@ namespace EAE_Engine
 
     Quaternion Quaternion::CreateNormalized() const
     {
-      const float length = std::sqrt((_w * _w) + (_x * _x) + (_y * _y) + (_z * _z));
+      const float length = Sqrt((_w * _w) + (_x * _x) + (_y * _y) + (_z * _z));
       assert(length > s_epsilon);
       const float length_reciprocal = 1.0f / length;
       return Quaternion(_w * length_reciprocal, _x * length_reciprocal, _y * length_reciprocal, _z * length_reciprocal);
@@ -162,7 +162,7 @@ namespace EAE_Engine
     // which = 1.
     float Quaternion::GetMagnitude() const
     {
-      return std::sqrtf(_w * _w + _x * _x + _y * _y + _z * _z);
+      return Sqrt(_w * _w + _x * _x + _y * _y + _z * _z);
     }
 
     float Quaternion::GetSqMagnitude() const
@@ -199,8 +199,8 @@ namespace EAE_Engine
       // [w, v] = [cos(?/2), sin(?/2)n]
       // [w, (x, y, z)] = [cos(?/2), (sin(?/2)nx, sin(?/2)ny, sin(?/2)nz)]
       const float theta_half = i_angleInRadians * 0.5f;
-      _w = std::cosf(theta_half);
-      const float sin_theta_half = std::sinf(theta_half);
+      _w = Cos(theta_half);
+      const float sin_theta_half = Sin(theta_half);
       _x = i_axisOfRotation_normalized._x * sin_theta_half;
       _y = i_axisOfRotation_normalized._y * sin_theta_half;
       _z = i_axisOfRotation_normalized._z * sin_theta_half;
@@ -283,14 +283,14 @@ namespace EAE_Engine
         // the pitch is looking for stright up or down
         // We just calculate the heading and make bank to 0.0f
         pitch = Math::Pi * 0.5f; // pitch
-        heading = std::atan2f(-x * z - w * y, 0.5f - y * y - z * z); //heading
+        heading = Atan2(-x * z - w * y, 0.5f - y * y - z * z); //heading
         bank = 0.0f; // bank       
       }
       else 
       {
-        pitch = std::asinf(sp); // pitch 
-        heading = std::atan2f(x * z - w * y, 0.5f - x * x - y * y);// heading 
-        bank = std::atan2f(x * y - w * z, 0.5f - x * x - z * z);// bank
+        pitch = Asin(sp); // pitch 
+        heading = Atan2(x * z - w * y, 0.5f - x * x - y * y);// heading 
+        bank = Atan2(x * y - w * z, 0.5f - x * x - z * z);// bank
       }
       // result is radians
       Vector3 result(bank, pitch, heading);
@@ -326,12 +326,12 @@ namespace EAE_Engine
       float k1 = t;
       if (cosOmega < 0.9999f)
       {
-        float sinOmega = std::sqrtf(1.0f - cosOmega * cosOmega);
-        float omega = std::atan2f(sinOmega, cosOmega);
+        float sinOmega = Sqrt(1.0f - cosOmega * cosOmega);
+        float omega = Atan2(sinOmega, cosOmega);
         float oneOverSinOmega = 1.0f / sinOmega;
 
-        k0 = std::sinf(k0 * omega) * oneOverSinOmega;
-        k1 = std::sinf(k1 * omega) * oneOverSinOmega;
+        k0 = Sin(k0 * omega) * oneOverSinOmega;
+        k1 = Sin(k1 * omega) * oneOverSinOmega;
       }
       result = q0 * k0 + target * k1;
       return result;
@@ -372,8 +372,8 @@ namespace EAE_Engine
       // _w = std::cos(theta/2), 
       // cos(theta) = 2 * cos(theta/2)^2 - 1.
       // cos(theta) = 1 - 2 * sin(theta/2)^2.
-      float w = std::sqrtf((cosTheta + 1.0f) * 0.5f);
-      float sinTheta_half = std::sqrtf((1.0f - cosTheta) * 0.5f);
+      float w = Sqrt((cosTheta + 1.0f) * 0.5f);
+      float sinTheta_half = Sqrt((1.0f - cosTheta) * 0.5f);
 
       return Quaternion(
         w,
@@ -441,7 +441,7 @@ namespace EAE_Engine
       Quaternion quaternion = Quaternion::Identity;
       if (num8 > 0.0f)
       {
-        float num = sqrtf(num8 + 1.0f);
+        float num = Sqrt(num8 + 1.0f);
         quaternion._w = num * 0.5f;
         num = 0.5f / num;
         quaternion._x = (m12 - m21) * num;
@@ -451,7 +451,7 @@ namespace EAE_Engine
       }
       if ((m00 >= m11) && (m00 >= m22))
       {
-        float num7 = sqrtf(((1.0f + m00) - m11) - m22);
+        float num7 = Sqrt(((1.0f + m00) - m11) - m22);
         float num4 = 0.5f / num7;
         quaternion._x = 0.5f * num7;
         quaternion._y = (m01 + m10) * num4;
@@ -461,7 +461,7 @@ namespace EAE_Engine
       }
       if (m11 > m22)
       {
-        float num6 = sqrtf(((1.0f + m11) - m00) - m22);
+        float num6 = Sqrt(((1.0f + m11) - m00) - m22);
         float num3 = 0.5f / num6;
         quaternion._x = (m10 + m01) * num3;
         quaternion._y = 0.5f * num6;
@@ -469,7 +469,7 @@ namespace EAE_Engine
         quaternion._w = (m20 - m02) * num3;
         return quaternion;
       }
-      float num5 = sqrtf(((1.0f + m22) - m00) - m11);
+      float num5 = Sqrt(((1.0f + m22) - m00) - m11);
       float num2 = 0.5f / num5;
       quaternion._x = (m20 + m02) * num2;
       quaternion._y = (m21 + m12) * num2;
@@ -42,6 +42,10 @@ namespace EAE_Engine
     float GetMagnitude() const;
     float GetSqMagnitude() const;
     Vector3 GetVec() const;
+    inline float w() const { return _w; }
+    inline float x() const { return _x; }
+    inline float y() const { return _y; }
+    inline float z() const { return _z; }
         
 		// Initialization / Shut Down
 		//---------------------------
@@ -13,13 +13,13 @@ namespace EAE_Engine
 			~Rectangle();
 			Rectangle(float x, float y, float width, float height);
 			Rectangle(const Rectangle& rect);
-			inline Vector3 GetLeftTop();
-			inline Vector3 GetLeftBottom();
-			inline Vector3 GetRightTop();
-			inline Vector3 GetRightBottom();
-			inline Vector3 GetCenter();
-			inline float GetWidth();
-			inline float GetHeight();
+			inline Vector3 GetLeftTop() const;
+			inline Vector3 GetLeftBottom() const;
+			inline Vector3 GetRightTop() const;
+			inline Vector3 GetRightBottom() const;
+			inline Vector3 GetCenter() const;
+			inline float GetWidth() const;
+			inline float GetHeight() const;
 			inline void SetWidth(float width);
 			inline void SetHeight(float height);
 			inline void Move(float x, float y);
@@ -4,37 +4,37 @@ namespace EAE_Engine
 	namespace Math
 	{
 		
-		inline Vector3 Rectangle::GetLeftTop()
+		inline Vector3 Rectangle::GetLeftTop() const
 		{
 			return _leftTop;
 		}
 
-		inline Vector3 Rectangle::GetRightBottom()
+		inline Vector3 Rectangle::GetRightBottom() const
 		{
 			return _rightBottom;
 		}
 
-		inline Vector3 Rectangle::GetLeftBottom()
+		inline Vector3 Rectangle::GetLeftBottom() const
 		{
 			return Vector3(_leftTopX, _leftTopY + _height, 0.f);
 		}
 
-		inline Vector3 Rectangle::GetRightTop()
+		inline Vector3 Rectangle::GetRightTop() const
 		{
 			return Vector3(_leftTopX + _width, _leftTopY, 0.f);
 		}
 
-		inline Vector3 Rectangle::GetCenter()
+		inline Vector3 Rectangle::GetCenter() const
 		{
 			return Vector3(_leftTopX + _width / 2.0f, _leftTopY + _height / 2.0f, 0.f);
 		}
 
-		inline float Rectangle::GetWidth()
+		inline float Rectangle::GetWidth() const
 		{
 			return _width;
 		}
 
-		inline float Rectangle::GetHeight()
+		inline float Rectangle::GetHeight() const
 		{
 			return _height;
 		}
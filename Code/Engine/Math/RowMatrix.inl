@@ -141,8 +141,8 @@ namespace EAE_Engine
 
 		inline RowMatrix44 RowMatrix44::GetRotateAroundXLH(float degree)
 		{
-			float sinTheta = sinf(degree);
-			float cosTheta = cosf(degree);
+			float sinTheta = Sin(degree);
+			float cosTheta = Cos(degree);
 			RowMatrix44 result = RowMatrix44::Identity;
 			//1, 0, 0
 			//0,cos,sin
@@ -156,8 +156,8 @@ namespace EAE_Engine
 
 		inline RowMatrix44 RowMatrix44::GetRotateAroundYLH(float degree)
 		{
-			float sinTheta = sinf(degree);
-			float cosTheta = cosf(degree);
+			float sinTheta = Sin(degree);
+			float cosTheta = Cos(degree);
 			RowMatrix44 result = RowMatrix44::Identity;
 			//cos, 0, -sin
 			//0, 1, 0
@@ -171,8 +171,8 @@ namespace EAE_Engine
 
 		inline RowMatrix44 RowMatrix44::GetRotateAroundZLH(float degree)
 		{
-			float sinTheta = sinf(degree);
-			float cosTheta = cosf(degree);
+			float sinTheta = Sin(degree);
+			float cosTheta = Cos(degree);
 			RowMatrix44 result = RowMatrix44::Identity;
 			//cos, sin, 0
 			//-sin,cos, 0
@@ -186,8 +186,8 @@ namespace EAE_Engine
 
 		inline RowMatrix44 RowMatrix44::GetRotateAroundAxisLH(Vector3 axis, float degree)
 		{
-			float sinTheta = sinf(degree);
-			float cosTheta = cosf(degree);
+			float sinTheta = Sin(degree);
+			float cosTheta = Cos(degree);
 			float oneSubCosTheta = 1.0f - cosTheta;
 			RowMatrix44 result = RowMatrix44::Identity;
 			axis.Normalize();
@@ -0,0 +1,261 @@
+#include "SIMDGeometry.h"
+#include "ColMatrix.h"
+#include "Rectangle.h"
+#include <cfloat>
+#include <cmath>
+
+namespace EAE_Engine
+{
+  namespace Math
+  {
+    namespace
+    {
+      // ColMatrix44 is column-major, so each column is 4 continuous floats.
+      inline __m128 LoadColumn(const ColMatrix44& i_matrix, size_t index)
+      {
+        return _mm_loadu_ps(&i_matrix._m[index * 4]);
+      }
+
+      inline __m128 Splat(__m128 i_vec, int lane)
+      {
+        switch (lane)
+        {
+        case 0: return _mm_shuffle_ps(i_vec, i_vec, _MM_SHUFFLE(0, 0, 0, 0));
+        case 1: return _mm_shuffle_ps(i_vec, i_vec, _MM_SHUFFLE(1, 1, 1, 1));
+        default: return _mm_shuffle_ps(i_vec, i_vec, _MM_SHUFFLE(2, 2, 2, 2));
+        }
+      }
+
+      // i_x * i_columnX + i_y * i_columnY + i_z * i_columnZ, the matrix is given by its columns.
+      inline __m128 MultiplyColumns(__m128 i_vec, __m128 i_columnX, __m128 i_columnY, __m128 i_columnZ)
+      {
+        __m128 result = _mm_mul_ps(Splat(i_vec, 0), i_columnX);
+        result = _mm_add_ps(result, _mm_mul_ps(Splat(i_vec, 1), i_columnY));
+        return _mm_add_ps(result, _mm_mul_ps(Splat(i_vec, 2), i_columnZ));
+      }
+
+      inline float Dot3(__m128 i_a, __m128 i_b)
+      {
+        float product[4];
+        _mm_storeu_ps(product, _mm_mul_ps(i_a, i_b));
+        return product[0] + product[1] + product[2];
+      }
+
+      // Transpose the 3 axes, so the ith lane of the result is the dot of i_vec and the ith axis.
+      inline void TransposeAxes(const PackedOBB& i_obb, __m128& o_x, __m128& o_y, __m128& o_z)
+      {
+        o_x = _mm_setr_ps(i_obb._axis[0][0], i_obb._axis[1][0], i_obb._axis[2][0], 0.0f);
+        o_y = _mm_setr_ps(i_obb._axis[0][1], i_obb._axis[1][1], i_obb._axis[2][1], 0.0f);
+        o_z = _mm_setr_ps(i_obb._axis[0][2], i_obb._axis[1][2], i_obb._axis[2][2], 0.0f);
+      }
+    }
+
+    ///////////////////////////////////////AABB//////////////////////////////////////////
+
+    PackedAABB TransformAABB(const PackedAABB& i_aabb, const ColMatrix44& i_matrix)
+    {
+      __m128 columnX = LoadColumn(i_matrix, 0);
+      __m128 columnY = LoadColumn(i_matrix, 1);
+      __m128 columnZ = LoadColumn(i_matrix, 2);
+      __m128 center = _mm_add_ps(MultiplyColumns(i_aabb.Center(), columnX, columnY, columnZ), LoadColumn(i_matrix, 3));
+      __m128 extents = MultiplyColumns(i_aabb.Extents(), AbsVector(columnX), AbsVector(columnY), AbsVector(columnZ));
+      // clear the w lane
+      const __m128 xyz = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+      center = _mm_and_ps(center, xyz);
+      extents = _mm_and_ps(extents, xyz);
+      PackedAABB result;
+      result.Set(_mm_sub_ps(center, extents), _mm_add_ps(center, extents));
+      return result;
+    }
+
+    void AABB4::Set(size_t index, const PackedAABB& i_aabb)
+    {
+      _minX[index] = i_aabb._min[0];
+      _minY[index] = i_aabb._min[1];
+      _minZ[index] = i_aabb._min[2];
+      _maxX[index] = i_aabb._max[0];
+      _maxY[index] = i_aabb._max[1];
+      _maxZ[index] = i_aabb._max[2];
+    }
+
+    void AABB4::SetEmpty(size_t index)
+    {
+      _minX[index] = _minY[index] = _minZ[index] = FLT_MAX;
+      _maxX[index] = _maxY[index] = _maxZ[index] = -FLT_MAX;
+    }
+
+    void AABB8::Set(size_t index, const PackedAABB& i_aabb)
+    {
+      _minX[index] = i_aabb._min[0];
+      _minY[index] = i_aabb._min[1];
+      _minZ[index] = i_aabb._min[2];
+      _maxX[index] = i_aabb._max[0];
+      _maxY[index] = i_aabb._max[1];
+      _maxZ[index] = i_aabb._max[2];
+    }
+
+    void AABB8::SetEmpty(size_t index)
+    {
+      _minX[index] = _minY[index] = _minZ[index] = FLT_MAX;
+      _maxX[index] = _maxY[index] = _maxZ[index] = -FLT_MAX;
+    }
+
+    ///////////////////////////////////////OBB//////////////////////////////////////////
+
+    PackedOBB::PackedOBB(const OBB& i_obb)
+    {
+      _mm_storeu_ps(_center, LoadVector3(i_obb._pos));
+      _mm_storeu_ps(_extent, LoadVector3(i_obb._extent));
+      for (size_t i = 0; i < 3; ++i)
+        _mm_storeu_ps(_axis[i], LoadVector3(i_obb._axis[i]));
+    }
+
+    OBB PackedOBB::ToOBB() const
+    {
+      OBB result;
+      result._pos = StoreVector3(Center());
+      result._extent = StoreVector3(Extent());
+      for (size_t i = 0; i < 3; ++i)
+        result._axis[i] = StoreVector3(Axis(i));
+      return result;
+    }
+
+    PackedAABB ComputeAABB(const PackedOBB& i_obb)
+    {
+      __m128 extents = MultiplyColumns(i_obb.Extent(), AbsVector(i_obb.Axis(0)), AbsVector(i_obb.Axis(1)), AbsVector(i_obb.Axis(2)));
+      __m128 center = i_obb.Center();
+      PackedAABB result;
+      result.Set(_mm_sub_ps(center, extents), _mm_add_ps(center, extents));
+      return result;
+    }
+
+    bool ContainsPoint(const PackedOBB& i_obb, const Vector3& i_point)
+    {
+      __m128 axisX, axisY, axisZ;
+      TransposeAxes(i_obb, axisX, axisY, axisZ);
+      // the point in the local space of the OBB.
+      __m128 local = MultiplyColumns(_mm_sub_ps(LoadVector3(i_point), i_obb.Center()), axisX, axisY, axisZ);
+      return (_mm_movemask_ps(_mm_cmpgt_ps(AbsVector(local), i_obb.Extent())) & s_xyzMask) == 0;
+    }
+
+    bool TestOBBOBB(const PackedOBB& i_a, const PackedOBB& i_b)
+    {
+      // R[i][j] = Dot(a.axis[i], b.axis[j]), one row for each axis of a.
+      __m128 bAxisX, bAxisY, bAxisZ;
+      TransposeAxes(i_b, bAxisX, bAxisY, bAxisZ);
+      float R[3][4];
+      float AbsR[3][4];
+      // Add in an epsilon term to counteract arithmetic errors when two edges are parallel and
+      // their cross product is (near) null.
+      const __m128 epsilon = _mm_set1_ps(FLT_EPSILON);
+      for (size_t i = 0; i < 3; ++i)
+      {
+        __m128 row = MultiplyColumns(i_a.Axis(i), bAxisX, bAxisY, bAxisZ);
+        _mm_storeu_ps(R[i], row);
+        _mm_storeu_ps(AbsR[i], _mm_add_ps(AbsVector(row), epsilon));
+      }
+      // The translation vector t in a's frame.
+      __m128 aAxisX, aAxisY, aAxisZ;
+      TransposeAxes(i_a, aAxisX, aAxisY, aAxisZ);
+      float t[4];
+      _mm_storeu_ps(t, MultiplyColumns(_mm_sub_ps(i_b.Center(), i_a.Center()), aAxisX, aAxisY, aAxisZ));
+      const float* ea = i_a._extent;
+      const float* eb = i_b._extent;
+      float ra, rb;
+      // Test axes L = A0, L = A1, L = A2
+      for (int i = 0; i < 3; ++i)
+      {
+        ra = ea[i];
+        rb = eb[0] * AbsR[i][0] + eb[1] * AbsR[i][1] + eb[2] * AbsR[i][2];
+        if (std::fabs(t[i]) > ra + rb)
+          return false;
+      }
+      // Test axes L = B0, L = B1, L = B2
+      for (int i = 0; i < 3; ++i)
+      {
+        ra = ea[0] * AbsR[0][i] + ea[1] * AbsR[1][i] + ea[2] * AbsR[2][i];
+        rb = eb[i];
+        if (std::fabs(t[0] * R[0][i] + t[1] * R[1][i] + t[2] * R[2][i]) > ra + rb)
+          return false;
+      }
+      // Test the 9 axes L = Ai x Bj
+      for (int i = 0; i < 3; ++i)
+      {
+        int i1 = (i + 1) % 3;
+        int i2 = (i + 2) % 3;
+        for (int j = 0; j < 3; ++j)
+        {
+          int j1 = (j + 1) % 3;
+          int j2 = (j + 2) % 3;
+          ra = ea[i1] * AbsR[i2][j] + ea[i2] * AbsR[i1][j];
+          rb = eb[j1] * AbsR[i][j2] + eb[j2] * AbsR[i][j1];
+          if (std::fabs(t[i2] * R[i1][j] - t[i1] * R[i2][j]) > ra + rb)
+            return false;
+        }
+      }
+      // Since no separating axis is found, the OBBs must be intersecting
+      return true;
+    }
+
+    PackedOBB TransformOBB(const PackedOBB& i_obb, const ColMatrix44& i_matrix)
+    {
+      __m128 columnX = LoadColumn(i_matrix, 0);
+      __m128 columnY = LoadColumn(i_matrix, 1);
+      __m128 columnZ = LoadColumn(i_matrix, 2);
+      const __m128 xyz = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+      PackedOBB result;
+      __m128 center = _mm_add_ps(MultiplyColumns(i_obb.Center(), columnX, columnY, columnZ), LoadColumn(i_matrix, 3));
+      _mm_storeu_ps(result._center, _mm_and_ps(center, xyz));
+      // The scale of the matrix goes into the extent, so the axes stay normalized.
+      for (size_t i = 0; i < 3; ++i)
+      {
+        __m128 axis = _mm_and_ps(MultiplyColumns(i_obb.Axis(i), columnX, columnY, columnZ), xyz);
+        float length = std::sqrt(Dot3(axis, axis));
+        float invLength = length > FLT_EPSILON ? 1.0f / length : 0.0f;
+        _mm_storeu_ps(result._axis[i], _mm_mul_ps(axis, _mm_set1_ps(invLength)));
+        result._extent[i] = i_obb._extent[i] * length;
+      }
+      result._extent[3] = 0.0f;
+      return result;
+    }
+
+    ///////////////////////////////////////Frustum//////////////////////////////////////////
+
+    const uint32_t PackedFrustum::s_allPlanes;
+
+    PackedFrustum ComputeFrustum(const ColMatrix44& i_worldToClip)
+    {
+      // The clip position of p is (dot(row0, p), dot(row1, p), dot(row2, p), dot(row3, p)),
+      // so -w <= x <= w, -w <= y <= w and 0 <= z <= w are the planes, by Gribb and Hartmann.
+      __m128 rows[4];
+      for (size_t i = 0; i < 4; ++i)
+        rows[i] = _mm_setr_ps(i_worldToClip._m[i], i_worldToClip._m[i + 4], i_worldToClip._m[i + 8], i_worldToClip._m[i + 12]);
+      __m128 planes[6] =
+      {
+        _mm_add_ps(rows[3], rows[0]), _mm_sub_ps(rows[3], rows[0]),
+        _mm_add_ps(rows[3], rows[1]), _mm_sub_ps(rows[3], rows[1]),
+        rows[2], _mm_sub_ps(rows[3], rows[2]),
+      };
+      PackedFrustum result;
+      for (size_t i = 0; i < 6; ++i)
+      {
+        float length = std::sqrt(Dot3(planes[i], planes[i]));
+        float invLength = length > FLT_EPSILON ? 1.0f / length : 0.0f;
+        _mm_storeu_ps(result._planes[i], _mm_mul_ps(planes[i], _mm_set1_ps(invLength)));
+      }
+      return result;
+    }
+
+    ///////////////////////////////////////Rectangle//////////////////////////////////////////
+
+    PackedRect::PackedRect(const Rectangle& i_rect)
+    {
+      Vector3 leftTop = i_rect.GetLeftTop();
+      Vector3 rightBottom = i_rect.GetRightBottom();
+      __m128 a = _mm_setr_ps(leftTop._x, leftTop._y, 0.0f, 0.0f);
+      __m128 b = _mm_setr_ps(rightBottom._x, rightBottom._y, 0.0f, 0.0f);
+      // (min, min, max, max), so a rectangle with a negative size is still valid.
+      _mm_storeu_ps(_bounds, _mm_movelh_ps(_mm_min_ps(a, b), _mm_max_ps(a, b)));
+    }
+  }
+}
@@ -0,0 +1,299 @@
+#ifndef EAE_ENGINE_MATH_SIMD_GEOMETRY_H
+#define EAE_ENGINE_MATH_SIMD_GEOMETRY_H
+
+#include "Geometry.h"
+#include <cstdint>
+#include <emmintrin.h>
+
+/*
+ * Packed versions of the AABB, OBB and Rectangle for the SSE2 registers,
+ * so the octree nodes, the colliders and the frustum culling can share one geometry kernel.
+ * The vectors are kept as 4 floats (x, y, z, 0) and loaded with unaligned loads,
+ * so these types are safe to be stored in std::vector without any aligned allocator.
+ */
+namespace EAE_Engine
+{
+  namespace Math
+  {
+    class ColMatrix44;
+    class Rectangle;
+
+    ///////////////////////////////////////Load && Store//////////////////////////////////////////
+
+    inline __m128 LoadVector3(const Vector3& i_vec)
+    {
+      return _mm_setr_ps(i_vec._x, i_vec._y, i_vec._z, 0.0f);
+    }
+
+    inline Vector3 StoreVector3(__m128 i_vec)
+    {
+      float result[4];
+      _mm_storeu_ps(result, i_vec);
+      return Vector3(result[0], result[1], result[2]);
+    }
+
+    inline __m128 AbsVector(__m128 i_vec)
+    {
+      return _mm_andnot_ps(_mm_set1_ps(-0.0f), i_vec);
+    }
+
+    // The mask of x, y and z, the w lane is always ignored.
+    const int s_xyzMask = 0x7;
+
+    ///////////////////////////////////////AABB//////////////////////////////////////////
+
+    struct PackedAABB
+    {
+      PackedAABB() = default;
+      PackedAABB(const Vector3& i_min, const Vector3& i_max) { Set(LoadVector3(i_min), LoadVector3(i_max)); }
+      explicit PackedAABB(const AABBV1& i_aabb) { Set(LoadVector3(i_aabb._min), LoadVector3(i_aabb._max)); }
+      explicit PackedAABB(const AABBV2& i_aabb)
+      {
+        __m128 pos = LoadVector3(i_aabb._pos);
+        __m128 extents = LoadVector3(i_aabb._extents);
+        Set(_mm_sub_ps(pos, extents), _mm_add_ps(pos, extents));
+      }
+      inline void Set(__m128 i_min, __m128 i_max) { _mm_storeu_ps(_min, i_min); _mm_storeu_ps(_max, i_max); }
+      inline __m128 Min() const { return _mm_loadu_ps(_min); }
+      inline __m128 Max() const { return _mm_loadu_ps(_max); }
+      inline __m128 Center() const { return _mm_mul_ps(_mm_add_ps(Min(), Max()), _mm_set1_ps(0.5f)); }
+      inline __m128 Extents() const { return _mm_mul_ps(_mm_sub_ps(Max(), Min()), _mm_set1_ps(0.5f)); }
+      inline AABBV1 ToAABBV1() const
+      {
+        AABBV1 result;
+        result._min = StoreVector3(Min());
+        result._max = StoreVector3(Max());
+        return result;
+      }
+      inline AABBV2 ToAABBV2() const
+      {
+        AABBV2 result;
+        result._pos = StoreVector3(Center());
+        result._extents = StoreVector3(Extents());
+        return result;
+      }
+
+      float _min[4];
+      float _max[4];
+    };
+
+    inline PackedAABB Union(const PackedAABB& i_a, const PackedAABB& i_b)
+    {
+      PackedAABB result;
+      result.Set(_mm_min_ps(i_a.Min(), i_b.Min()), _mm_max_ps(i_a.Max(), i_b.Max()));
+      return result;
+    }
+
+    inline PackedAABB Union(const PackedAABB& i_a, const Vector3& i_point)
+    {
+      __m128 point = LoadVector3(i_point);
+      PackedAABB result;
+      result.Set(_mm_min_ps(i_a.Min(), point), _mm_max_ps(i_a.Max(), point));
+      return result;
+    }
+
+    // The boxes touching each other are overlapping.
+    inline bool TestAABBAABB(const PackedAABB& i_a, const PackedAABB& i_b)
+    {
+      __m128 separated = _mm_or_ps(_mm_cmpgt_ps(i_a.Min(), i_b.Max()), _mm_cmpgt_ps(i_b.Min(), i_a.Max()));
+      return (_mm_movemask_ps(separated) & s_xyzMask) == 0;
+    }
+
+    // Returns false when they don't overlap, otherwise o_intersection is the overlapping box.
+    inline bool Intersection(const PackedAABB& i_a, const PackedAABB& i_b, PackedAABB& o_intersection)
+    {
+      __m128 min = _mm_max_ps(i_a.Min(), i_b.Min());
+      __m128 max = _mm_min_ps(i_a.Max(), i_b.Max());
+      o_intersection.Set(min, max);
+      return (_mm_movemask_ps(_mm_cmpgt_ps(min, max)) & s_xyzMask) == 0;
+    }
+
+    // The points on the faces are inside.
+    inline bool ContainsPoint(const PackedAABB& i_aabb, const Vector3& i_point)
+    {
+      __m128 point = LoadVector3(i_point);
+      __m128 outside = _mm_or_ps(_mm_cmplt_ps(point, i_aabb.Min()), _mm_cmpgt_ps(point, i_aabb.Max()));
+      return (_mm_movemask_ps(outside) & s_xyzMask) == 0;
+    }
+
+    inline bool ContainsAABB(const PackedAABB& i_outer, const PackedAABB& i_inner)
+    {
+      __m128 outside = _mm_or_ps(_mm_cmplt_ps(i_inner.Min(), i_outer.Min()), _mm_cmpgt_ps(i_inner.Max(), i_outer.Max()));
+      return (_mm_movemask_ps(outside) & s_xyzMask) == 0;
+    }
+
+    inline float SurfaceArea(const PackedAABB& i_aabb)
+    {
+      float size[4];
+      _mm_storeu_ps(size, _mm_sub_ps(i_aabb.Max(), i_aabb.Min()));
+      return 2.0f * (size[0] * size[1] + size[1] * size[2] + size[2] * size[0]);
+    }
+
+    // The sphere touching the box is overlapping, the closest point of the box is compared with the radius.
+    inline bool TestAABBSphere(const PackedAABB& i_aabb, const Vector3& i_center, float radius)
+    {
+      __m128 center = LoadVector3(i_center);
+      __m128 offset = _mm_sub_ps(center, _mm_min_ps(_mm_max_ps(center, i_aabb.Min()), i_aabb.Max()));
+      float distance[4];
+      _mm_storeu_ps(distance, _mm_mul_ps(offset, offset));
+      return distance[0] + distance[1] + distance[2] <= radius * radius;
+    }
+
+    // The AABB which bounds the transformed box, by Arvo's method:
+    // the new extents are the old extents multiplied by the absolute values of the matrix.
+    PackedAABB TransformAABB(const PackedAABB& i_aabb, const ColMatrix44& i_matrix);
+
+    // 4 AABBs in SoA layout, so one AABB can be tested against all of them with one SIMD test on each axis.
+    struct AABB4
+    {
+      void Set(size_t index, const PackedAABB& i_aabb);
+      // The unused slots are filled with an inverted box at +-FLT_MAX, which never overlaps a box or a segment
+      // strictly within +-FLT_MAX. Not infinities, the center of (inf, -inf) would be a NaN and pass the segment tests.
+      void SetEmpty(size_t index);
+
+      float _minX[4];
+      float _minY[4];
+      float _minZ[4];
+      float _maxX[4];
+      float _maxY[4];
+      float _maxZ[4];
+    };
+
+    // Returns a 4 bits mask, the ith bit is set when i_aabb overlaps the ith box.
+    inline uint32_t TestAABBAABB4(const PackedAABB& i_aabb, const AABB4& i_boxes)
+    {
+      __m128 separated = _mm_or_ps(_mm_cmpgt_ps(_mm_set1_ps(i_aabb._min[0]), _mm_loadu_ps(i_boxes._maxX)),
+        _mm_cmpgt_ps(_mm_loadu_ps(i_boxes._minX), _mm_set1_ps(i_aabb._max[0])));
+      separated = _mm_or_ps(separated, _mm_cmpgt_ps(_mm_set1_ps(i_aabb._min[1]), _mm_loadu_ps(i_boxes._maxY)));
+      separated = _mm_or_ps(separated, _mm_cmpgt_ps(_mm_loadu_ps(i_boxes._minY), _mm_set1_ps(i_aabb._max[1])));
+      separated = _mm_or_ps(separated, _mm_cmpgt_ps(_mm_set1_ps(i_aabb._min[2]), _mm_loadu_ps(i_boxes._maxZ)));
+      separated = _mm_or_ps(separated, _mm_cmpgt_ps(_mm_loadu_ps(i_boxes._minZ), _mm_set1_ps(i_aabb._max[2])));
+      return (uint32_t)(~_mm_movemask_ps(separated) & 0xf);
+    }
+
+    // 8 AABBs in SoA layout, like AABB4, for the 8 children of an octree node.
+    struct AABB8
+    {
+      void Set(size_t index, const PackedAABB& i_aabb);
+      // The unused slots are filled with an inverted box at +-FLT_MAX, which never overlaps a box or a segment
+      // strictly within +-FLT_MAX. Not infinities, the center of (inf, -inf) would be a NaN and pass the segment tests.
+      void SetEmpty(size_t index);
+
+      float _minX[8];
+      float _minY[8];
+      float _minZ[8];
+      float _maxX[8];
+      float _maxY[8];
+      float _maxZ[8];
+    };
+
+    ///////////////////////////////////////OBB//////////////////////////////////////////
+
+    struct PackedOBB
+    {
+      PackedOBB() = default;
+      explicit PackedOBB(const OBB& i_obb);
+      inline __m128 Center() const { return _mm_loadu_ps(_center); }
+      inline __m128 Extent() const { return _mm_loadu_ps(_extent); }
+      inline __m128 Axis(size_t index) const { return _mm_loadu_ps(_axis[index]); }
+      OBB ToOBB() const;
+
+      float _center[4];
+      float _extent[4];
+      float _axis[3][4];// Local x-, y-, and z-axes, they should be normalized.
+    };
+
+    // The AABB which bounds the OBB.
+    PackedAABB ComputeAABB(const PackedOBB& i_obb);
+    bool ContainsPoint(const PackedOBB& i_obb, const Vector3& i_point);
+    // The static separating axis test with the 15 axes, from Real Time Collision Detection 4.4.1.
+    bool TestOBBOBB(const PackedOBB& i_a, const PackedOBB& i_b);
+    // i_matrix should be a rigid transform with a uniform scale.
+    PackedOBB TransformOBB(const PackedOBB& i_obb, const ColMatrix44& i_matrix);
+
+    ///////////////////////////////////////Frustum//////////////////////////////////////////
+
+    // The left, right, bottom, top, near and far planes, the normals point inside.
+    // Each plane is (nx, ny, nz, w), the point p is inside of it when dot(n, p) + w >= 0.
+    struct PackedFrustum
+    {
+      static const uint32_t s_allPlanes = 0x3f;
+      inline __m128 Plane(size_t index) const { return _mm_loadu_ps(_planes[index]); }
+
+      float _planes[6][4];
+    };
+
+    // The frustum of the clip volume of i_worldToClip, x and y in [-1, 1] and z in [0, 1] like the Camera.
+    PackedFrustum ComputeFrustum(const ColMatrix44& i_worldToClip);
+
+    // Only the planes in io_planeMask are tested, and the planes which have the whole box inside are removed from it,
+    // so the children of the box don't need to test them again.
+    // Returns false when the box is outside of one plane, it may return true for a box which is outside near a corner.
+    inline bool TestAABBFrustum(const PackedAABB& i_aabb, const PackedFrustum& i_frustum, uint32_t& io_planeMask)
+    {
+      __m128 center = i_aabb.Center();
+      __m128 extents = i_aabb.Extents();
+      for (uint32_t planeIndex = 0; planeIndex < 6; ++planeIndex)
+      {
+        uint32_t planeBit = 1u << planeIndex;
+        if ((io_planeMask & planeBit) == 0)
+          continue;
+        __m128 plane = i_frustum.Plane(planeIndex);
+        float distance[4], radius[4];
+        _mm_storeu_ps(distance, _mm_mul_ps(center, plane));
+        _mm_storeu_ps(radius, _mm_mul_ps(extents, AbsVector(plane)));
+        float centerDistance = distance[0] + distance[1] + distance[2] + i_frustum._planes[planeIndex][3];
+        float projectedRadius = radius[0] + radius[1] + radius[2];
+        if (centerDistance + projectedRadius < 0.0f)
+          return false;
+        if (centerDistance - projectedRadius >= 0.0f)
+          io_planeMask &= ~planeBit;
+      }
+      return true;
+    }
+
+    ///////////////////////////////////////Rectangle//////////////////////////////////////////
+
+    // 2D box as (minX, minY, maxX, maxY), so one compare tests both of the axes.
+    struct PackedRect
+    {
+      PackedRect() = default;
+      PackedRect(float minX, float minY, float maxX, float maxY) { _mm_storeu_ps(_bounds, _mm_setr_ps(minX, minY, maxX, maxY)); }
+      explicit PackedRect(const Rectangle& i_rect);
+      inline __m128 Bounds() const { return _mm_loadu_ps(_bounds); }
+
+      float _bounds[4];
+    };
+
+    inline bool TestRectRect(const PackedRect& i_a, const PackedRect& i_b)
+    {
+      __m128 a = i_a.Bounds();
+      // (b.maxX, b.maxY, -b.minX, -b.minY) >= (a.minX, a.minY, -a.maxX, -a.maxY)
+      const __m128 signFlip = _mm_setr_ps(0.0f, 0.0f, -0.0f, -0.0f);
+      __m128 lhs = _mm_xor_ps(_mm_shuffle_ps(i_b.Bounds(), i_b.Bounds(), _MM_SHUFFLE(1, 0, 3, 2)), signFlip);
+      __m128 rhs = _mm_xor_ps(a, signFlip);
+      return _mm_movemask_ps(_mm_cmplt_ps(lhs, rhs)) == 0;
+    }
+
+    inline bool ContainsPoint(const PackedRect& i_rect, float x, float y)
+    {
+      // (x, y, -x, -y) >= (minX, minY, -maxX, -maxY)
+      const __m128 signFlip = _mm_setr_ps(0.0f, 0.0f, -0.0f, -0.0f);
+      __m128 point = _mm_xor_ps(_mm_setr_ps(x, y, x, y), signFlip);
+      __m128 bounds = _mm_xor_ps(i_rect.Bounds(), signFlip);
+      return _mm_movemask_ps(_mm_cmplt_ps(point, bounds)) == 0;
+    }
+
+    inline PackedRect Union(const PackedRect& i_a, const PackedRect& i_b)
+    {
+      // min on the first 2 lanes, max on the last 2 lanes.
+      const __m128 signFlip = _mm_setr_ps(0.0f, 0.0f, -0.0f, -0.0f);
+      __m128 result = _mm_xor_ps(_mm_min_ps(_mm_xor_ps(i_a.Bounds(), signFlip), _mm_xor_ps(i_b.Bounds(), signFlip)), signFlip);
+      PackedRect rect;
+      _mm_storeu_ps(rect._bounds, result);
+      return rect;
+    }
+  }
+}
+
+#endif//EAE_ENGINE_MATH_SIMD_GEOMETRY_H
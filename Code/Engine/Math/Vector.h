@@ -1,8 +1,10 @@
 #ifndef TVECTOR3_H
 #define TVECTOR3_H
 #include <math.h>
+#include <climits>
 #include "Engine/General/Implements.h"
 #include "Engine/UserOutput/Source/EngineDebuger.h"
+#include "MathTool.h"
 
 namespace EAE_Engine
 {
@@ -161,11 +163,11 @@ namespace EAE_Engine
       float k1 = t;
       if (cosOmega < 0.9999f)
       {
-        float sinOmega = std::sqrt(1.0f - cosOmega * cosOmega);
-        float omega = std::atan2f(sinOmega, cosOmega);
+        float sinOmega = Sqrt(1.0f - cosOmega * cosOmega);
+        float omega = Atan2(sinOmega, cosOmega);
         float oneOverSinOmega = 1.0f / sinOmega;
-        k0 = std::sinf(k0 * omega) * oneOverSinOmega;
-        k1 = std::sinf(k1 * omega) * oneOverSinOmega;
+        k0 = Sin(k0 * omega) * oneOverSinOmega;
+        k1 = Sin(k1 * omega) * oneOverSinOmega;
       }
       return from * k0 + to * k1;
     }
@@ -194,6 +196,7 @@ namespace EAE_Engine
     template <typename T>
     const TVector3<T> TVector3<T>::Forward(T(0), T(0), T(-1));
 
+    template<>
     inline float TVector3<float>::Magnitude() const
     {
         float length = sqrt(_x * _x + _y*_y + _z*_z);
@@ -218,11 +221,12 @@ namespace EAE_Engine
       return *this;
     }
     //normalize function for float
+    template<>
     inline TVector3<float> TVector3<float>::Normalize()
     {
       float length = Magnitude();
       //MessagedAssert(!Engine::Implements::AlmostEqual2sComplement(length, 0.0f, 5), "opps, length should not be 0.0f!");
-      if (Implements::AlmostEqual2sComplement(length, 0.0f, 5))
+      if (Implements::AlmostEqualUlps(length, 0.0f, 5))
       {
           this->_x = FLT_MAX - 1.0f;
           this->_y = FLT_MAX - 1.0f;
@@ -242,22 +246,23 @@ namespace EAE_Engine
         T length = Magnitude();
         if (length == 0)
         {
-            result->_x = (T)INT_MAX;
-            result->_y = (T)INT_MAX;
-            result->_z = (T)INT_MAX;
+            result._x = (T)INT_MAX;
+            result._y = (T)INT_MAX;
+            result._z = (T)INT_MAX;
             return result;
         }
-        result->_x = result->_x / length;
-        result->_y = result->_y / length;
-        result->_z = result->_z / length;
+        result._x = result._x / length;
+        result._y = result._y / length;
+        result._z = result._z / length;
         return result;
     }
+    template<>
     inline TVector3<float> TVector3<float>::GetNormalize() const
     {
         TVector3<float> result = *this;
         float length = Magnitude();
         //MessagedAssert(!Engine::Implements::AlmostEqual2sComplement(length, 0.0f, 5), "opps, length should not be 0.0f!");
-        if (Implements::AlmostEqual2sComplement(length, 0.0f, 5))
+        if (Implements::AlmostEqualUlps(length, 0.0f, 5))
         {
             result._x = FLT_MAX - 1.0f;
             result._y = FLT_MAX - 1.0f;
@@ -377,10 +382,10 @@ namespace EAE_Engine
     //the float version of the operator==
     inline bool operator== (const TVector3<float>& left, const TVector3<float>& right)
     {
-        bool bx = EAE_Engine::Implements::AlmostEqual2sComplement(left.x(), right.x(), 4);
-        bool by = EAE_Engine::Implements::AlmostEqual2sComplement(left.y(), right.y(), 4);
-        bool bz = EAE_Engine::Implements::AlmostEqual2sComplement(left.z(), right.z(), 4);
-        return bx&&by&&bz;
+        bool bx = EAE_Engine::Implements::AlmostEqualUlps(left.x(), right.x(), 4);
+        bool by = EAE_Engine::Implements::AlmostEqualUlps(left.y(), right.y(), 4);
+        bool bz = EAE_Engine::Implements::AlmostEqualUlps(left.z(), right.z(), 4);
+        return bx & by & bz;
     }
 
     typedef TVector3<float> Vector3;
@@ -489,6 +494,7 @@ namespace EAE_Engine
         return *this;
     }
 
+    template<>
     inline float TVector4<float>::Magnitude() const
     {
         float length = sqrt(_x * _x + _y*_y + _z*_z + _w * _w);
@@ -515,11 +521,12 @@ namespace EAE_Engine
         return *this;
     }
     //normalize function for float
+    template<>
     inline TVector4<float> TVector4<float>::Normalize()
     {
         float length = Magnitude();
         //MessagedAssert(!Engine::Implements::AlmostEqual2sComplement(length, 0.0f, 5), "opps, length should not be 0.0f!");
-        if (Implements::AlmostEqual2sComplement(length, 0.0f, 5))
+        if (Implements::AlmostEqualUlps(length, 0.0f, 5))
         {
             this->_x = FLT_MAX - 1.0f;
             this->_y = FLT_MAX - 1.0f;
@@ -560,11 +567,11 @@ namespace EAE_Engine
     //the float version of the operator==
     inline bool operator== (const TVector4<float>& left, const TVector4<float>& right)
     {
-        bool bx = EAE_Engine::Implements::AlmostEqual2sComplement(left.x(), right.x(), 4);
-        bool by = EAE_Engine::Implements::AlmostEqual2sComplement(left.y(), right.y(), 4);
-        bool bz = EAE_Engine::Implements::AlmostEqual2sComplement(left.z(), right.z(), 4);
-        bool bw = EAE_Engine::Implements::AlmostEqual2sComplement(left.w(), right.w(), 4);
-        return bx&&by&&bz&&bw;
+        bool bx = EAE_Engine::Implements::AlmostEqualUlps(left.x(), right.x(), 4);
+        bool by = EAE_Engine::Implements::AlmostEqualUlps(left.y(), right.y(), 4);
+        bool bz = EAE_Engine::Implements::AlmostEqualUlps(left.z(), right.z(), 4);
+        bool bw = EAE_Engine::Implements::AlmostEqualUlps(left.w(), right.w(), 4);
+        return bx & by & bz & bw;
     }
 
     typedef TVector4<float> Vector4;
@@ -12,6 +12,40 @@
 //=============================
 namespace EAE_Engine
 {
+	void ReadMeshInfo(const uint8_t* i_pBuffer,
+		uint32_t& o_vertexElementCount, const Mesh::VertexElement*& o_pVertexElements,
+		uint32_t& o_vertexOffset, uint32_t& o_vertexCount,
+		uint32_t& o_indexOffset, uint32_t& o_indexCount,
+		uint32_t& o_subMeshOffset, uint32_t& o_subMeshCount)
+	{
+		uint32_t offset = 0;
+		o_vertexElementCount = *reinterpret_cast<const uint32_t*>(i_pBuffer + offset);
+		offset += sizeof(uint32_t);
+		o_pVertexElements = reinterpret_cast<const EAE_Engine::Mesh::VertexElement*>(i_pBuffer + offset);
+		offset += sizeof(EAE_Engine::Mesh::VertexElement) * o_vertexElementCount;
+		// Get VertexCount
+		uint32_t vertexCount = *reinterpret_cast<const uint32_t*>(i_pBuffer + offset);
+		o_vertexCount = vertexCount;
+		offset += sizeof(uint32_t);
+		// Get IndexCount
+		uint32_t indexCount = *reinterpret_cast<const uint32_t*>(i_pBuffer + offset);
+		o_indexCount = indexCount;
+		offset += sizeof(uint32_t);
+		// Get SubMeshCount
+		uint32_t subMeshCount = *reinterpret_cast<const uint32_t*>(i_pBuffer + offset);
+		o_subMeshCount = subMeshCount;
+		offset += sizeof(uint32_t);
+		// Set vertexOffset
+		o_vertexOffset = offset;
+		offset += sizeof(Mesh::sVertex) * vertexCount;
+		// Set indexOffset
+		o_indexOffset = offset;
+		offset += sizeof(uint32_t) * indexCount;
+		// Set subMeshOffset
+		o_subMeshOffset = offset;
+		offset += sizeof(Mesh::sSubMesh) * subMeshCount;
+	}
+
 	uint8_t* LoadMeshInfo(const char* i_pFile,
 		uint32_t& o_vertexElementCount, Mesh::VertexElement*& o_pVertexElements, 
 		uint32_t& o_vertexOffset, uint32_t& o_vertexCount,
@@ -45,34 +79,10 @@ namespace EAE_Engine
 			delete[] pBuffer;
 			return nullptr;
 		}
-		uint32_t offset = 0;
-		{
-			o_vertexElementCount = *reinterpret_cast<uint32_t*>(pBuffer + offset);
-			offset += sizeof(uint32_t);
-			o_pVertexElements = reinterpret_cast<EAE_Engine::Mesh::VertexElement*>(pBuffer + offset);
-			offset += sizeof(EAE_Engine::Mesh::VertexElement) * o_vertexElementCount;
-			// Get VertexCount
-			uint32_t vertexCount = *reinterpret_cast<uint32_t*>(pBuffer + offset);
-			o_vertexCount = vertexCount;
-			offset += sizeof(uint32_t);
-			// Get IndexCount
-			uint32_t indexCount = *reinterpret_cast<uint32_t*>(pBuffer + offset);
-			o_indexCount = indexCount;
-			offset += sizeof(uint32_t);
-			// Get SubMeshCount
-			uint32_t subMeshCount = *reinterpret_cast<uint32_t*>(pBuffer + offset);
-			o_subMeshCount = subMeshCount;
-			offset += sizeof(uint32_t);
-			// Set vertexOffset
-			o_vertexOffset = offset;
-			offset += sizeof(Mesh::sVertex) * vertexCount;
-			// Set indexOffset
-			o_indexOffset = offset;
-			offset += sizeof(uint32_t) * indexCount;
-			// Set subMeshOffset
-			o_subMeshOffset = offset;
-			offset += sizeof(Mesh::sSubMesh) * subMeshCount;
-		}
+		const Mesh::VertexElement* pVertexElements = nullptr;
+		ReadMeshInfo(reinterpret_cast<const uint8_t*>(pBuffer), o_vertexElementCount, pVertexElements,
+			o_vertexOffset, o_vertexCount, o_indexOffset, o_indexCount, o_subMeshOffset, o_subMeshCount);
+		o_pVertexElements = const_cast<Mesh::VertexElement*>(pVertexElements);
 		infile.close();
 		return reinterpret_cast<uint8_t*>(pBuffer);
 	}
@@ -83,31 +93,31 @@ namespace EAE_Engine
 {
 	namespace Mesh
 	{
-		bool LoadMeshData(const char* i_binaryMeshFile)
+		AOSMeshData* CreateAOSMeshData(const uint8_t* i_pBuffer)
 		{
 			uint32_t vertexElementCount = 0;
-			VertexElement* pVertexElement = nullptr;
+			const VertexElement* pVertexElement = nullptr;
 			uint32_t vertexOffset = 0;
 			uint32_t vertexCount = 0;
 			uint32_t indexOffset = 0;
 			uint32_t indexCount = 0;
 			uint32_t subMeshOffset = 0;
 			uint32_t subMeshCount = 0;
-			uint8_t* pBuffer = LoadMeshInfo(i_binaryMeshFile, vertexElementCount, pVertexElement,
+			ReadMeshInfo(i_pBuffer, vertexElementCount, pVertexElement,
 				vertexOffset, vertexCount, indexOffset, indexCount, subMeshOffset, subMeshCount);
 			AOSMeshData* pAOSMeshData = new AOSMeshData();
-			sVertex* pVertices = (sVertex*)(pBuffer + vertexOffset);
+			const sVertex* pVertices = (const sVertex*)(i_pBuffer + vertexOffset);
 			for (uint32_t vertexIndex = 0; vertexIndex < vertexCount; ++vertexIndex)
 			{
-				sVertex& vertex = pVertices[vertexIndex];
+				const sVertex& vertex = pVertices[vertexIndex];
 				pAOSMeshData->_vertices.push_back(vertex);
 			}
-			uint32_t* pIndices = (uint32_t*)(pBuffer + indexOffset);
+			const uint32_t* pIndices = (const uint32_t*)(i_pBuffer + indexOffset);
 			for (uint32_t index = 0; index < indexCount; index += 3)
 			{
-				uint32_t& indexValue0 = pIndices[index + 0];
-				uint32_t& indexValue1 = pIndices[index + 1];
-				uint32_t& indexValue2 = pIndices[index + 2];
+				const uint32_t& indexValue0 = pIndices[index + 0];
+				const uint32_t& indexValue1 = pIndices[index + 1];
+				const uint32_t& indexValue2 = pIndices[index + 2];
 				pAOSMeshData->_indices.push_back(indexValue0);
 #if defined( EAEENGINE_PLATFORM_D3D9 )
 				pAOSMeshData->_indices.push_back(indexValue2);
@@ -117,12 +127,28 @@ namespace EAE_Engine
 				pAOSMeshData->_indices.push_back(indexValue2);
 #endif
 			}
-			sSubMesh* pSubMeshes = (sSubMesh*)(pBuffer + subMeshOffset);
+			const sSubMesh* pSubMeshes = (const sSubMesh*)(i_pBuffer + subMeshOffset);
 			for (uint32_t subMeshIndex = 0; subMeshIndex < subMeshCount; ++subMeshIndex)
 			{
-				sSubMesh* pSubMesh = pSubMeshes + subMeshIndex;
+				const sSubMesh* pSubMesh = pSubMeshes + subMeshIndex;
 				pAOSMeshData->_subMeshes.push_back(*pSubMesh);
 			}
+			return pAOSMeshData;
+		}
+
+		bool LoadMeshData(const char* i_binaryMeshFile)
+		{
+			uint32_t vertexElementCount = 0;
+			VertexElement* pVertexElement = nullptr;
+			uint32_t vertexOffset = 0;
+			uint32_t vertexCount = 0;
+			uint32_t indexOffset = 0;
+			uint32_t indexCount = 0;
+			uint32_t subMeshOffset = 0;
+			uint32_t subMeshCount = 0;
+			uint8_t* pBuffer = LoadMeshInfo(i_binaryMeshFile, vertexElementCount, pVertexElement,
+				vertexOffset, vertexCount, indexOffset, indexCount, subMeshOffset, subMeshCount);
+			AOSMeshData* pAOSMeshData = CreateAOSMeshData(pBuffer);
 			std::string mesh_path(i_binaryMeshFile);
 			std::string key = GetFileNameWithoutExtension(mesh_path.c_str());
 			SAFE_DELETE_ARRAY(pBuffer);
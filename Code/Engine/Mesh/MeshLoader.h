@@ -94,6 +94,9 @@ namespace EAE_Engine
 			uint32_t _vertexCount;
 		};
 
+		struct AOSMeshData;
+		// Convert the content of a binary mesh file, the triangles are in the winding order of the platform.
+		AOSMeshData* CreateAOSMeshData(const uint8_t* i_pBuffer);
 		bool LoadMeshData(const char* i_binaryMeshFile);
 	}
 }
@@ -0,0 +1,401 @@
+#include "BVH.h"
+#include "Engine/CollisionDetection/CollisionDetectionFunctions.h"
+#include "Engine/General/MemoryOp.h"
+#include "Windows/WindowsFunctions.h"
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <fstream>
+
+namespace EAE_Engine
+{
+  namespace Core
+  {
+    namespace
+    {
+      inline float HalfSurfaceArea(const Math::Vector3& i_min, const Math::Vector3& i_max)
+      {
+        Math::Vector3 size = i_max - i_min;
+        return size._x * size._y + size._y * size._z + size._z * size._x;
+      }
+
+      inline void GrowBounds(Math::Vector3& io_min, Math::Vector3& io_max, const Math::Vector3& i_min, const Math::Vector3& i_max)
+      {
+        for (size_t axis = 0; axis < 3; ++axis)
+        {
+          io_min._u[axis] = std::min(io_min._u[axis], i_min._u[axis]);
+          io_max._u[axis] = std::max(io_max._u[axis], i_max._u[axis]);
+        }
+      }
+
+      // the slab test of the segment start + t * direction for t in [0, maxT], i_inverse is 1 / direction.
+      inline bool IntersectNode(const BVHNode& i_node, const Math::Vector3& i_start, const Math::Vector3& i_inverse, float maxT, float& o_tEnter)
+      {
+        float tMin = 0.0f;
+        float tMax = maxT;
+        for (size_t axis = 0; axis < 3; ++axis)
+        {
+          float t0 = (i_node._min._u[axis] - i_start._u[axis]) * i_inverse._u[axis];
+          float t1 = (i_node._max._u[axis] - i_start._u[axis]) * i_inverse._u[axis];
+          if (t0 > t1)
+            std::swap(t0, t1);
+          tMin = t0 > tMin ? t0 : tMin;
+          tMax = t1 < tMax ? t1 : tMax;
+          if (tMin > tMax)
+            return false;
+        }
+        o_tEnter = tMin;
+        return true;
+      }
+    }
+
+    const float BVH::s_traversalCost = 1.0f;
+
+    BVH::BVH() :
+      _depth(0), _pMeshData(nullptr)
+    {}
+
+    BVH::~BVH()
+    {}
+
+    void BVH::Build(Mesh::AOSMeshData* pMeshData)
+    {
+      _pMeshData = pMeshData;
+      _nodes.clear();
+      _triangles.clear();
+      _depth = 0;
+      if (_pMeshData == nullptr)
+        return;
+      const std::vector<Mesh::sVertex>& vertices = _pMeshData->_vertices;
+      const std::vector<uint32_t>& indices = _pMeshData->_indices;
+      const uint32_t triangleCount = (uint32_t)indices.size() / 3;
+      if (triangleCount == 0)
+        return;
+      _buildTriangles.resize(triangleCount);
+      for (uint32_t triangleIndex = 0; triangleIndex < triangleCount; ++triangleIndex)
+      {
+        BuildTriangle& triangle = _buildTriangles[triangleIndex];
+        triangle._triangle._index0 = indices[triangleIndex * 3];
+        triangle._triangle._index1 = indices[triangleIndex * 3 + 1];
+        triangle._triangle._index2 = indices[triangleIndex * 3 + 2];
+        triangle._min = Math::Vector3(FLT_MAX, FLT_MAX, FLT_MAX);
+        triangle._max = Math::Vector3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+        for (size_t corner = 0; corner < 3; ++corner)
+        {
+          const Mesh::sVertex& vertex = vertices[triangle._triangle._indices[corner]];
+          Math::Vector3 point(vertex.x, vertex.y, vertex.z);
+          GrowBounds(triangle._min, triangle._max, point, point);
+        }
+        triangle._center = (triangle._min + triangle._max) * 0.5f;
+      }
+      // A binary tree with a triangle in each leaf has 2n - 1 nodes, so the nodes never move during the build.
+      _nodes.reserve(triangleCount * 2 - 1);
+      _nodes.resize(1);
+      _depth = BuildNode(0, 0, triangleCount);
+      _nodes.shrink_to_fit();
+      _triangles.resize(triangleCount);
+      for (uint32_t triangleIndex = 0; triangleIndex < triangleCount; ++triangleIndex)
+        _triangles[triangleIndex] = _buildTriangles[triangleIndex]._triangle;
+      std::vector<BuildTriangle>().swap(_buildTriangles);
+    }
+
+    uint32_t BVH::BuildNode(uint32_t nodeIndex, uint32_t begin, uint32_t end)
+    {
+      Math::Vector3 min(FLT_MAX, FLT_MAX, FLT_MAX), max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+      Math::Vector3 centerMin(FLT_MAX, FLT_MAX, FLT_MAX), centerMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+      for (uint32_t i = begin; i < end; ++i)
+      {
+        GrowBounds(min, max, _buildTriangles[i]._min, _buildTriangles[i]._max);
+        GrowBounds(centerMin, centerMax, _buildTriangles[i]._center, _buildTriangles[i]._center);
+      }
+      _nodes[nodeIndex]._min = min;
+      _nodes[nodeIndex]._max = max;
+      _nodes[nodeIndex]._offset = begin;
+      const uint32_t count = end - begin;
+      _nodes[nodeIndex]._count = count;
+      if (count == 1)
+        return 1;
+
+      // Find the cheapest split over the bins of each axis.
+      struct Bin
+      {
+        Math::Vector3 _min;
+        Math::Vector3 _max;
+        uint32_t _count;
+      };
+      const float area = HalfSurfaceArea(min, max);
+      float bestCost = (float)count;
+      int bestAxis = -1;
+      uint32_t bestSplit = 0;
+      for (int axis = 0; axis < 3; ++axis)
+      {
+        const float extent = centerMax._u[axis] - centerMin._u[axis];
+        if (extent <= 0.0f)
+          continue;
+        const float scale = s_binCount / extent;
+        Bin bins[s_binCount];
+        for (uint32_t bin = 0; bin < s_binCount; ++bin)
+        {
+          bins[bin]._min = Math::Vector3(FLT_MAX, FLT_MAX, FLT_MAX);
+          bins[bin]._max = Math::Vector3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+          bins[bin]._count = 0;
+        }
+        for (uint32_t i = begin; i < end; ++i)
+        {
+          uint32_t bin = std::min((uint32_t)((_buildTriangles[i]._center._u[axis] - centerMin._u[axis]) * scale), s_binCount - 1);
+          GrowBounds(bins[bin]._min, bins[bin]._max, _buildTriangles[i]._min, _buildTriangles[i]._max);
+          ++bins[bin]._count;
+        }
+        // the cost of the left side of each split from the left, then add the right side from the right.
+        float leftCosts[s_binCount - 1];
+        Math::Vector3 sideMin(FLT_MAX, FLT_MAX, FLT_MAX), sideMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+        uint32_t sideCount = 0;
+        for (uint32_t split = 0; split < s_binCount - 1; ++split)
+        {
+          sideCount += bins[split]._count;
+          if (bins[split]._count > 0)
+            GrowBounds(sideMin, sideMax, bins[split]._min, bins[split]._max);
+          leftCosts[split] = sideCount > 0 ? HalfSurfaceArea(sideMin, sideMax) * sideCount : 0.0f;
+        }
+        sideMin = Math::Vector3(FLT_MAX, FLT_MAX, FLT_MAX);
+        sideMax = Math::Vector3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+        sideCount = 0;
+        for (uint32_t split = s_binCount - 1; split > 0; --split)
+        {
+          sideCount += bins[split]._count;
+          if (bins[split]._count > 0)
+            GrowBounds(sideMin, sideMax, bins[split]._min, bins[split]._max);
+          if (sideCount == 0 || sideCount == count)
+            continue;
+          float cost = s_traversalCost + (leftCosts[split - 1] + HalfSurfaceArea(sideMin, sideMax) * sideCount) / area;
+          if (cost < bestCost)
+          {
+            bestCost = cost;
+            bestAxis = axis;
+            bestSplit = split;
+          }
+        }
+      }
+      // A large leaf is split even when the SAH prefers it, to bound the work of a query in a leaf.
+      if (bestAxis < 0 || (bestCost >= (float)count && count <= s_maxLeafSize))
+        return 1;
+      const float extent = centerMax._u[bestAxis] - centerMin._u[bestAxis];
+      const float scale = s_binCount / extent;
+      const float splitMin = centerMin._u[bestAxis];
+      BuildTriangle* pMiddle = std::partition(&_buildTriangles[begin], &_buildTriangles[0] + end,
+        [bestAxis, bestSplit, scale, splitMin](const BuildTriangle& i_triangle)
+      {
+        return std::min((uint32_t)((i_triangle._center._u[bestAxis] - splitMin) * scale), s_binCount - 1) < bestSplit;
+      });
+      const uint32_t middle = (uint32_t)(pMiddle - &_buildTriangles[0]);
+      assert(middle > begin && middle < end);
+      _nodes[nodeIndex]._count = 0;
+      _nodes.push_back(BVHNode());
+      uint32_t leftDepth = BuildNode(nodeIndex + 1, begin, middle);
+      const uint32_t rightIndex = (uint32_t)_nodes.size();
+      _nodes[nodeIndex]._offset = rightIndex;
+      _nodes.push_back(BVHNode());
+      uint32_t rightDepth = BuildNode(rightIndex, middle, end);
+      return 1 + std::max(leftDepth, rightDepth);
+    }
+
+    bool BVH::InitFromFile(const char* pBVHFile, const char* pCollisionMesh)
+    {
+      std::ifstream infile(pBVHFile, std::ifstream::binary);
+      if (!infile)
+        return false;
+      infile.seekg(0, infile.end);
+      std::streamoff size = infile.tellg();
+      infile.seekg(0);
+      const uint32_t headerSize = sizeof(uint32_t) * 3;
+      if (size < headerSize)
+        return false;
+      char* pBuffer = new char[(uint32_t)size];
+      infile.read(pBuffer, size);
+      infile.close();
+      uint32_t offset = 0;
+      uint32_t nodeCount = 0;
+      uint32_t triangleCount = 0;
+      CopyMem((uint8_t*)(pBuffer + offset), (uint8_t*)&nodeCount, sizeof(uint32_t));
+      offset += sizeof(uint32_t);
+      CopyMem((uint8_t*)(pBuffer + offset), (uint8_t*)&triangleCount, sizeof(uint32_t));
+      offset += sizeof(uint32_t);
+      CopyMem((uint8_t*)(pBuffer + offset), (uint8_t*)&_depth, sizeof(uint32_t));
+      offset += sizeof(uint32_t);
+      if (size != headerSize + nodeCount * sizeof(BVHNode) + triangleCount * sizeof(Mesh::TriangleIndex))
+      {
+        delete[] pBuffer;
+        return false;
+      }
+      _nodes.resize(nodeCount);
+      _triangles.resize(triangleCount);
+      if (nodeCount > 0)
+        CopyMem((uint8_t*)(pBuffer + offset), (uint8_t*)&_nodes[0], nodeCount * sizeof(BVHNode));
+      offset += nodeCount * sizeof(BVHNode);
+      if (triangleCount > 0)
+        CopyMem((uint8_t*)(pBuffer + offset), (uint8_t*)&_triangles[0], triangleCount * sizeof(Mesh::TriangleIndex));
+      delete[] pBuffer;
+
+      // The octree has usually loaded the mesh already, loading it again would leak the copy AddAOSMeshData refuses.
+      std::string mesh_path(pCollisionMesh);
+      std::string key = GetFileNameWithoutExtension(mesh_path.c_str());
+      _pMeshData = Mesh::AOSMeshDataManager::GetInstance()->GetAOSMeshData(key.c_str());
+      if (_pMeshData == nullptr)
+      {
+        Mesh::LoadMeshData(pCollisionMesh);
+        _pMeshData = Mesh::AOSMeshDataManager::GetInstance()->GetAOSMeshData(key.c_str());
+      }
+      // The file must be built from this mesh.
+      bool matched = _pMeshData != nullptr && _pMeshData->_indices.size() == triangleCount * 3;
+      for (std::vector<Mesh::TriangleIndex>::const_iterator it = _triangles.begin(); matched && it != _triangles.end(); ++it)
+      {
+        for (size_t corner = 0; corner < 3; ++corner)
+          matched = matched && it->_indices[corner] < _pMeshData->_vertices.size();
+      }
+      if (!matched)
+      {
+        _nodes.clear();
+        _triangles.clear();
+        _depth = 0;
+        return false;
+      }
+      return true;
+    }
+
+    bool BVH::SaveToFile(const char* pBVHFile) const
+    {
+      std::ofstream outfile(pBVHFile, std::ofstream::binary);
+      if (!outfile)
+        return false;
+      const uint32_t header[] = { (uint32_t)_nodes.size(), (uint32_t)_triangles.size(), _depth };
+      outfile.write(reinterpret_cast<const char*>(header), sizeof(header));
+      if (!_nodes.empty())
+        outfile.write(reinterpret_cast<const char*>(&_nodes[0]), _nodes.size() * sizeof(BVHNode));
+      if (!_triangles.empty())
+        outfile.write(reinterpret_cast<const char*>(&_triangles[0]), _triangles.size() * sizeof(Mesh::TriangleIndex));
+      return outfile.good();
+    }
+
+    template<typename LeafTest>
+    void BVH::Traverse(const Math::Vector3& start, const Math::Vector3& end, LeafTest testLeaf) const
+    {
+      if (_nodes.empty())
+        return;
+      const Math::Vector3 direction = end - start;
+      Math::Vector3 inverse;
+      for (size_t axis = 0; axis < 3; ++axis)
+        inverse._u[axis] = direction._u[axis] != 0.0f ? 1.0f / direction._u[axis] : FLT_MAX;
+      float closest = 1.0f;
+      float tEnter = 0.0f;
+      if (!IntersectNode(_nodes[0], start, inverse, closest, tEnter))
+        return;
+      struct Entry
+      {
+        uint32_t _nodeIndex;
+        float _tEnter;
+      };
+      // The far child is pushed first, so the stack holds at most one node for each level.
+      const size_t stackSize = 64;
+      assert(_depth <= stackSize);
+      Entry stack[stackSize];
+      size_t count = 0;
+      stack[count++] = { 0, tEnter };
+      while (count > 0)
+      {
+        const Entry entry = stack[--count];
+        if (entry._tEnter > closest)
+          continue;
+        const BVHNode& node = _nodes[entry._nodeIndex];
+        if (node.IsLeaf())
+        {
+          closest = testLeaf(node, closest);
+          continue;
+        }
+        const uint32_t left = entry._nodeIndex + 1;
+        const uint32_t right = node._offset;
+        float tLeft = 0.0f, tRight = 0.0f;
+        const bool hitLeft = IntersectNode(_nodes[left], start, inverse, closest, tLeft);
+        const bool hitRight = IntersectNode(_nodes[right], start, inverse, closest, tRight);
+        if (hitLeft && hitRight)
+        {
+          if (tLeft <= tRight)
+          {
+            stack[count++] = { right, tRight };
+            stack[count++] = { left, tLeft };
+          }
+          else
+          {
+            stack[count++] = { left, tLeft };
+            stack[count++] = { right, tRight };
+          }
+        }
+        else if (hitLeft)
+          stack[count++] = { left, tLeft };
+        else if (hitRight)
+          stack[count++] = { right, tRight };
+      }
+    }
+
+    void BVH::GetTrianlgesCollideWithSegment(Math::Vector3 start, Math::Vector3 end, std::vector<Mesh::TriangleIndex>& o_triangles) const
+    {
+      if (_pMeshData == nullptr)
+        return;
+      const std::vector<Mesh::sVertex>& vertices = _pMeshData->_vertices;
+      std::vector<std::pair<float, uint32_t> > hits;
+      Traverse(start, end, [this, &vertices, &start, &end, &hits](const BVHNode& i_leaf, float closest)
+      {
+        for (uint32_t i = i_leaf._offset; i < i_leaf._offset + i_leaf._count; ++i)
+        {
+          const Mesh::TriangleIndex& triangle = _triangles[i];
+          const Mesh::sVertex& vertex0 = vertices[triangle._index0];
+          const Mesh::sVertex& vertex1 = vertices[triangle._index1];
+          const Mesh::sVertex& vertex2 = vertices[triangle._index2];
+          float u = 0, v = 0, w = 0, t = 0;
+          if (Collision::IntersectSegmentTriangle(start, end, Math::Vector3(vertex0.x, vertex0.y, vertex0.z),
+            Math::Vector3(vertex1.x, vertex1.y, vertex1.z), Math::Vector3(vertex2.x, vertex2.y, vertex2.z), u, v, w, t))
+            hits.push_back(std::make_pair(t, i));
+        }
+        // All of the hits are needed, don't skip the farther nodes.
+        return closest;
+      });
+      std::sort(hits.begin(), hits.end());
+      for (std::vector<std::pair<float, uint32_t> >::const_iterator it = hits.begin(); it != hits.end(); ++it)
+        o_triangles.push_back(_triangles[it->second]);
+    }
+
+    bool BVH::IntersectSegment(const Math::Vector3& start, const Math::Vector3& end, float& o_t,
+      Mesh::TriangleIndex& o_triangle, Math::Vector3& o_normal) const
+    {
+      if (_pMeshData == nullptr)
+        return false;
+      const std::vector<Mesh::sVertex>& vertices = _pMeshData->_vertices;
+      bool collided = false;
+      o_t = FLT_MAX;
+      Traverse(start, end, [this, &vertices, &start, &end, &collided, &o_t, &o_triangle, &o_normal](const BVHNode& i_leaf, float closest)
+      {
+        for (uint32_t i = i_leaf._offset; i < i_leaf._offset + i_leaf._count; ++i)
+        {
+          const Mesh::TriangleIndex& triangle = _triangles[i];
+          const Mesh::sVertex& vertex0 = vertices[triangle._index0];
+          const Mesh::sVertex& vertex1 = vertices[triangle._index1];
+          const Mesh::sVertex& vertex2 = vertices[triangle._index2];
+          Math::Vector3 a(vertex0.x, vertex0.y, vertex0.z);
+          Math::Vector3 b(vertex1.x, vertex1.y, vertex1.z);
+          Math::Vector3 c(vertex2.x, vertex2.y, vertex2.z);
+          float u = 0, v = 0, w = 0, t = 0;
+          if (!Collision::IntersectSegmentTriangle(start, end, a, b, c, u, v, w, t) || t >= closest)
+            continue;
+          collided = true;
+          closest = t;
+          o_t = t;
+          o_triangle = triangle;
+          o_normal = Math::Vector3::Cross(b - a, c - a);
+        }
+        return closest;
+      });
+      if (collided)
+        o_normal.Normalize();
+      return collided;
+    }
+  }
+}
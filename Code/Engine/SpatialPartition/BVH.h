@@ -0,0 +1,94 @@
+#ifndef EAE_ENGINE_SPATIAL_PARTITION_BVH_H
+#define EAE_ENGINE_SPATIAL_PARTITION_BVH_H
+
+#include "Engine/Math/Vector.h"
+#include "Engine/Mesh/AOSMeshData.h"
+#include <cstdint>
+#include <vector>
+
+/*
+ * A bounding volume hierarchy over the static collision mesh, the alternative of the CompleteOctree.
+ * It is a binary tree whose nodes bound their triangles tightly, so the empty space costs nothing,
+ * and each triangle is in exactly one leaf, so a query never finds the same triangle twice.
+ * The split of each node is the one with the lowest cost by the surface area heuristic (SAH):
+ * a ray hits a box with the probability of its surface area, so the cost of a split is
+ * s_traversalCost + (area(L) * count(L) + area(R) * count(R)) / area(node) triangle tests,
+ * and the node stays a leaf when it is cheaper to test all of its triangles.
+ * The splits are searched over s_binCount bins of the triangle centers on each axis.
+ * The nodes are in one array in the depth first order, the left child of a node is right after it,
+ * and the triangles are reordered so that each leaf owns a range of them.
+ */
+namespace EAE_Engine
+{
+  namespace Core
+  {
+    // 32 bytes, 2 of them in a cache line.
+    struct BVHNode
+    {
+      Math::Vector3 _min;
+      // a leaf: the first of its triangles. An inner node: its right child, the left child is the next node.
+      uint32_t _offset;
+      Math::Vector3 _max;
+      // the count of the triangles of a leaf, 0 for an inner node.
+      uint32_t _count;
+      inline bool IsLeaf() const { return _count > 0; }
+    };
+
+    class BVH
+    {
+    public:
+      static const uint32_t s_binCount = 16;
+      static const uint32_t s_maxLeafSize = 8;
+      // the cost of testing a node relative to testing a triangle.
+      static const float s_traversalCost;
+      BVH();
+      ~BVH();
+      // Build the tree over all of the triangles of the mesh.
+      void Build(Mesh::AOSMeshData* pMeshData);
+      // Load the tree saved by SaveToFile (MeshBuilder with the "bvh" argument),
+      // the mesh is taken from the AOSMeshDataManager and only loaded when it isn't there yet.
+      // Returns false when the file can't be read or it is for another mesh.
+      bool InitFromFile(const char* pBVHFile, const char* pCollisionMesh);
+      bool SaveToFile(const char* pBVHFile) const;
+      // All of the triangles whose front faces are hit by the segment, sorted by the distance from start,
+      // the same result as CompleteOctree::GetTrianlgesCollideWithSegment.
+      void GetTrianlgesCollideWithSegment(Math::Vector3 start, Math::Vector3 end, std::vector<Mesh::TriangleIndex>& o_triangles) const;
+      // The first hit of the segment, o_t is in [0, 1] and o_normal is normalized.
+      // The children are visited from near to far and the nodes behind the closest hit are skipped.
+      bool IntersectSegment(const Math::Vector3& start, const Math::Vector3& end, float& o_t,
+        Mesh::TriangleIndex& o_triangle, Math::Vector3& o_normal) const;
+      inline Mesh::AOSMeshData* GetCollisionMesh() const { return _pMeshData; }
+      inline const BVHNode* GetNodes() const { return _nodes.empty() ? nullptr : &_nodes[0]; }
+      inline uint32_t GetNodeCount() const { return (uint32_t)_nodes.size(); }
+      inline uint32_t GetTriangleCount() const { return (uint32_t)_triangles.size(); }
+      inline uint32_t GetDepth() const { return _depth; }
+      // the bytes of the nodes and the triangles.
+      inline size_t GetMemorySize() const { return _nodes.size() * sizeof(BVHNode) + _triangles.size() * sizeof(Mesh::TriangleIndex); }
+
+    private:
+      struct BuildTriangle
+      {
+        Math::Vector3 _min;
+        Math::Vector3 _max;
+        Math::Vector3 _center;
+        Mesh::TriangleIndex _triangle;
+      };
+      // Build the node for _buildTriangles[begin, end) and its children, returns the depth of the subtree.
+      uint32_t BuildNode(uint32_t nodeIndex, uint32_t begin, uint32_t end);
+      // walk the nodes hit by the segment, testLeaf(node) tests its triangles and returns the closest t to keep,
+      // the nodes entered after it are skipped.
+      template<typename LeafTest>
+      void Traverse(const Math::Vector3& start, const Math::Vector3& end, LeafTest testLeaf) const;
+
+    private:
+      std::vector<BVHNode> _nodes;
+      std::vector<Mesh::TriangleIndex> _triangles;
+      uint32_t _depth;
+      Mesh::AOSMeshData* _pMeshData;
+      // only used during Build.
+      std::vector<BuildTriangle> _buildTriangles;
+    };
+  }
+}
+
+#endif//EAE_ENGINE_SPATIAL_PARTITION_BVH_H
@@ -0,0 +1,84 @@
+#include "CollisionTriangleCache.h"
+#include <cmath>
+
+namespace EAE_Engine
+{
+  namespace Core
+  {
+    CollisionTriangleCache::CollisionTriangleCache() :
+      _pOctree(nullptr), _pLeaves(nullptr)
+    {}
+
+    void CollisionTriangleCache::Build(CompleteOctree* pOctree)
+    {
+      Clear();
+      if (pOctree == nullptr || pOctree->GetCollisionMesh() == nullptr || pOctree->Level() == 0)
+        return;
+      _pOctree = pOctree;
+      const uint32_t firstLeaf = ((uint32_t)std::pow(8.0f, (float)(pOctree->Level() - 1)) - 1) / (8 - 1);
+      const uint32_t leafCount = pOctree->GetNodeCount() - firstLeaf;
+      _pLeaves = pOctree->GetNodes() + firstLeaf;
+      const std::vector<Mesh::sVertex>& vertices = pOctree->GetCollisionMesh()->_vertices;
+      _firstPackets.resize(leafCount + 1);
+      _firstPackets[0] = 0;
+      for (uint32_t leafIndex = 0; leafIndex < leafCount; ++leafIndex)
+        _firstPackets[leafIndex + 1] = _firstPackets[leafIndex] + (_pLeaves[leafIndex]._triangleCount + 3) / 4;
+      _packets.resize(_firstPackets[leafCount]);
+      for (uint32_t leafIndex = 0; leafIndex < leafCount; ++leafIndex)
+      {
+        const OctreeNode& leaf = _pLeaves[leafIndex];
+        Collision::Triangle4* pPackets = &_packets[0] + _firstPackets[leafIndex];
+        const uint32_t laneCount = (_firstPackets[leafIndex + 1] - _firstPackets[leafIndex]) * 4;
+        for (uint32_t triangleIndex = 0; triangleIndex < laneCount; ++triangleIndex)
+        {
+          Collision::Triangle4& packet = pPackets[triangleIndex / 4];
+          if (triangleIndex >= leaf._triangleCount)
+          {
+            packet.SetEmpty(triangleIndex % 4);
+            continue;
+          }
+          const Mesh::TriangleIndex triangle = pOctree->GetTriangle(leaf, triangleIndex);
+          const Mesh::sVertex& vertex0 = vertices[triangle._index0];
+          const Mesh::sVertex& vertex1 = vertices[triangle._index1];
+          const Mesh::sVertex& vertex2 = vertices[triangle._index2];
+          packet.Set(triangleIndex % 4, Math::Vector3(vertex0.x, vertex0.y, vertex0.z),
+            Math::Vector3(vertex1.x, vertex1.y, vertex1.z), Math::Vector3(vertex2.x, vertex2.y, vertex2.z));
+        }
+      }
+    }
+
+    void CollisionTriangleCache::Clear()
+    {
+      _pOctree = nullptr;
+      _pLeaves = nullptr;
+      _firstPackets.clear();
+      _packets.clear();
+    }
+
+    uint32_t CollisionTriangleCache::GetTrianlgesCollideWithSegment(const Math::Vector3& start, const Math::Vector3& end, SegmentHit* o_pHits, uint32_t maxHits) const
+    {
+      if (_pOctree == nullptr || maxHits == 0)
+        return 0;
+      uint32_t hitCount = 0;
+      _pOctree->VisitNodesAlongSegment(start, end, _pOctree->Level() - 1, [&](const OctreeNode& i_leaf, float, float tExit)
+      {
+        uint32_t packetCount = 0;
+        const Collision::Triangle4* pPackets = GetPackets(i_leaf, packetCount);
+        for (uint32_t packetIndex = 0; packetIndex < packetCount; ++packetIndex)
+        {
+          float t[4], u[4], v[4], w[4];
+          uint32_t hitMask = Collision::IntersectSegmentTriangle4(start, end, pPackets[packetIndex], t, u, v, w);
+          // the lanes in the order of the triangles of the leaf, so the ties are kept like the octree.
+          for (uint32_t lane = 0; hitMask != 0; ++lane, hitMask >>= 1)
+          {
+            if ((hitMask & 1) != 0)
+              InsertSegmentHit(o_pHits, hitCount, maxHits, t[lane], _pOctree->GetTriangle(i_leaf, packetIndex * 4 + lane));
+          }
+        }
+        // The hits before tExit are confirmed, the later leaves can only have farther ones.
+        return hitCount < maxHits || o_pHits[hitCount - 1]._t > tExit;
+      });
+      return hitCount;
+    }
+  }
+}
@@ -0,0 +1,55 @@
+#ifndef EAE_ENGINE_SPATIAL_PARTITION_COLLISION_TRIANGLE_CACHE_H
+#define EAE_ENGINE_SPATIAL_PARTITION_COLLISION_TRIANGLE_CACHE_H
+
+#include "Octree.h"
+#include "Engine/CollisionDetection/SIMDCollisionFunctions.h"
+#include <cstdint>
+#include <vector>
+
+/*
+ * The positions of the triangles of each leaf of a CompleteOctree, ready for IntersectSegmentTriangle4.
+ * The octree only keeps the indices of the triangles, so each test reads the 3 sVertex of the mesh,
+ * which are 36 bytes each with the normal, the uv and the color, to use 12 bytes of them.
+ * Here the triangles of each leaf are copied into Triangle4 packets, a and the edges ab and ac in SoA layout,
+ * and the packets of a leaf are next to each other, so the triangles of a leaf are read from a few continuous cache lines.
+ * The triangle in more than one leaf is copied into each of them.
+ * The cache is built once from the octree and its collision mesh, Build it again when the mesh changes.
+ * The hits are the same as the ones of CompleteOctree::GetTrianlgesCollideWithSegment, bit by bit.
+ */
+namespace EAE_Engine
+{
+  namespace Core
+  {
+    class CollisionTriangleCache
+    {
+    public:
+      CollisionTriangleCache();
+      void Build(CompleteOctree* pOctree);
+      void Clear();
+      CompleteOctree* GetOctree() const { return _pOctree; }
+      // The packets of the leaf, the triangle i of the leaf is the lane i % 4 of the packet i / 4,
+      // the lanes after the last triangle are empty.
+      inline const Collision::Triangle4* GetPackets(const OctreeNode& i_leaf, uint32_t& o_packetCount) const;
+      // The same as CompleteOctree::GetTrianlgesCollideWithSegment with maxHits, with the packets of the leaves.
+      uint32_t GetTrianlgesCollideWithSegment(const Math::Vector3& start, const Math::Vector3& end, SegmentHit* o_pHits, uint32_t maxHits) const;
+      // the bytes of the packets.
+      inline size_t GetMemorySize() const { return _packets.size() * sizeof(Collision::Triangle4) + _firstPackets.size() * sizeof(uint32_t); }
+
+    private:
+      CompleteOctree* _pOctree;
+      const OctreeNode* _pLeaves;
+      // the packets of the leaf i are from _firstPackets[i] to _firstPackets[i + 1].
+      std::vector<uint32_t> _firstPackets;
+      std::vector<Collision::Triangle4> _packets;
+    };
+
+    inline const Collision::Triangle4* CollisionTriangleCache::GetPackets(const OctreeNode& i_leaf, uint32_t& o_packetCount) const
+    {
+      const size_t leafIndex = &i_leaf - _pLeaves;
+      o_packetCount = _firstPackets[leafIndex + 1] - _firstPackets[leafIndex];
+      return _packets.empty() ? nullptr : &_packets[_firstPackets[leafIndex]];
+    }
+  }
+}
+
+#endif//EAE_ENGINE_SPATIAL_PARTITION_COLLISION_TRIANGLE_CACHE_H
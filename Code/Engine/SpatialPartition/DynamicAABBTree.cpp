@@ -0,0 +1,339 @@
+#include "DynamicAABBTree.h"
+#include <algorithm>
+
+namespace EAE_Engine
+{
+  namespace Core
+  {
+    const uint32_t DynamicAABBTree::s_invalid;
+    const size_t DynamicAABBTree::s_stackSize;
+
+    DynamicAABBTree::DynamicAABBTree(float fatMargin) :
+      _root(s_invalid), _freeList(s_invalid), _proxyCount(0), _fatMargin(fatMargin)
+    {}
+
+    void DynamicAABBTree::Clear()
+    {
+      _nodes.clear();
+      _moveBuffer.clear();
+      _root = s_invalid;
+      _freeList = s_invalid;
+      _proxyCount = 0;
+    }
+
+    uint32_t DynamicAABBTree::CreateProxy(const Math::PackedAABB& i_aabb, void* pUserData)
+    {
+      uint32_t proxyId = AllocateNode();
+      Node& node = _nodes[proxyId];
+      __m128 margin = _mm_set1_ps(_fatMargin);
+      node._aabb.Set(_mm_sub_ps(i_aabb.Min(), margin), _mm_add_ps(i_aabb.Max(), margin));
+      node._pUserData = pUserData;
+      node._height = 0;
+      node._moved = true;
+      InsertLeaf(proxyId);
+      _moveBuffer.push_back(proxyId);
+      ++_proxyCount;
+      return proxyId;
+    }
+
+    void DynamicAABBTree::DestroyProxy(uint32_t proxyId)
+    {
+      assert(proxyId < _nodes.size() && _nodes[proxyId].IsLeaf());
+      if (_nodes[proxyId]._moved)
+        std::replace(_moveBuffer.begin(), _moveBuffer.end(), proxyId, s_invalid);
+      RemoveLeaf(proxyId);
+      FreeNode(proxyId);
+      --_proxyCount;
+    }
+
+    bool DynamicAABBTree::MoveProxy(uint32_t proxyId, const Math::PackedAABB& i_aabb)
+    {
+      assert(proxyId < _nodes.size() && _nodes[proxyId].IsLeaf());
+      Node& node = _nodes[proxyId];
+      if (Math::ContainsAABB(node._aabb, i_aabb))
+        return false;
+      RemoveLeaf(proxyId);
+      __m128 margin = _mm_set1_ps(_fatMargin);
+      _nodes[proxyId]._aabb.Set(_mm_sub_ps(i_aabb.Min(), margin), _mm_add_ps(i_aabb.Max(), margin));
+      InsertLeaf(proxyId);
+      if (!_nodes[proxyId]._moved)
+      {
+        _nodes[proxyId]._moved = true;
+        _moveBuffer.push_back(proxyId);
+      }
+      return true;
+    }
+
+    void DynamicAABBTree::UpdatePairs(std::vector<ProxyPair>& o_pairs)
+    {
+      o_pairs.clear();
+      for (std::vector<uint32_t>::const_iterator it = _moveBuffer.begin(); it != _moveBuffer.end(); ++it)
+      {
+        const uint32_t proxyId = *it;
+        if (proxyId == s_invalid)
+          continue;
+        QueryAABB(_nodes[proxyId]._aabb, [this, proxyId, &o_pairs](uint32_t otherId)
+        {
+          if (otherId == proxyId)
+            return true;
+          // When both of them moved, only the one with the smaller id reports the pair.
+          if (_nodes[otherId]._moved && otherId < proxyId)
+            return true;
+          ProxyPair pair = { std::min(proxyId, otherId), std::max(proxyId, otherId) };
+          o_pairs.push_back(pair);
+          return true;
+        });
+      }
+      for (std::vector<uint32_t>::const_iterator it = _moveBuffer.begin(); it != _moveBuffer.end(); ++it)
+      {
+        if (*it != s_invalid)
+          _nodes[*it]._moved = false;
+      }
+      _moveBuffer.clear();
+    }
+
+    float DynamicAABBTree::GetAreaRatio() const
+    {
+      if (_root == s_invalid)
+        return 0.0f;
+      float rootArea = Math::SurfaceArea(_nodes[_root]._aabb);
+      float totalArea = 0.0f;
+      for (std::vector<Node>::const_iterator it = _nodes.begin(); it != _nodes.end(); ++it)
+      {
+        if (it->_height > 0)
+          totalArea += Math::SurfaceArea(it->_aabb);
+      }
+      return rootArea > 0.0f ? totalArea / rootArea : 0.0f;
+    }
+
+    void DynamicAABBTree::Validate() const
+    {
+      if (_root != s_invalid)
+      {
+        assert(_nodes[_root]._parent == s_invalid);
+        ValidateNode(_root);
+      }
+      uint32_t freeCount = 0;
+      for (uint32_t freeId = _freeList; freeId != s_invalid; freeId = _nodes[freeId]._parent)
+        ++freeCount;
+      // Each proxy has 1 leaf, and there is 1 internal node less than the leaves.
+      assert(_proxyCount == 0 || freeCount + 2 * _proxyCount - 1 == _nodes.size());
+      (void)freeCount;
+    }
+
+    int32_t DynamicAABBTree::ValidateNode(uint32_t nodeId) const
+    {
+      const Node& node = _nodes[nodeId];
+      if (node.IsLeaf())
+      {
+        assert(node._height == 0);
+        return 0;
+      }
+      assert(_nodes[node._child1]._parent == nodeId && _nodes[node._child2]._parent == nodeId);
+      int32_t height1 = ValidateNode(node._child1);
+      int32_t height2 = ValidateNode(node._child2);
+      assert(node._height == 1 + std::max(height1, height2));
+      assert(Math::ContainsAABB(node._aabb, _nodes[node._child1]._aabb) && Math::ContainsAABB(node._aabb, _nodes[node._child2]._aabb));
+      return node._height;
+    }
+
+    ///////////////////////////////////////Nodes//////////////////////////////////////////
+
+    uint32_t DynamicAABBTree::AllocateNode()
+    {
+      uint32_t nodeId = _freeList;
+      if (nodeId != s_invalid)
+      {
+        _freeList = _nodes[nodeId]._parent;
+      }
+      else
+      {
+        nodeId = (uint32_t)_nodes.size();
+        _nodes.push_back(Node());
+      }
+      Node& node = _nodes[nodeId];
+      node._pUserData = nullptr;
+      node._parent = s_invalid;
+      node._child1 = s_invalid;
+      node._child2 = s_invalid;
+      node._height = 0;
+      node._moved = false;
+      return nodeId;
+    }
+
+    void DynamicAABBTree::FreeNode(uint32_t nodeId)
+    {
+      Node& node = _nodes[nodeId];
+      node._parent = _freeList;
+      node._height = -1;
+      node._moved = false;
+      _freeList = nodeId;
+    }
+
+    ///////////////////////////////////////Insert && Remove//////////////////////////////////////////
+
+    void DynamicAABBTree::InsertLeaf(uint32_t leafId)
+    {
+      if (_root == s_invalid)
+      {
+        _root = leafId;
+        _nodes[leafId]._parent = s_invalid;
+        return;
+      }
+      // Find the best sibling by the surface area heuristic.
+      // Going down to a child costs the area added to this node, which is paid by all of its ancestors too.
+      const Math::PackedAABB leafAABB = _nodes[leafId]._aabb;
+      uint32_t index = _root;
+      while (!_nodes[index].IsLeaf())
+      {
+        const Node& node = _nodes[index];
+        float area = Math::SurfaceArea(node._aabb);
+        float combinedArea = Math::SurfaceArea(Math::Union(node._aabb, leafAABB));
+        // Cost of creating a new parent for this node and the new leaf.
+        float cost = 2.0f * combinedArea;
+        // Minimum cost of pushing the leaf further down the tree.
+        float inheritanceCost = 2.0f * (combinedArea - area);
+        float childCost[2];
+        const uint32_t children[2] = { node._child1, node._child2 };
+        for (size_t i = 0; i < 2; ++i)
+        {
+          const Node& child = _nodes[children[i]];
+          float unionArea = Math::SurfaceArea(Math::Union(child._aabb, leafAABB));
+          if (child.IsLeaf())
+            childCost[i] = unionArea + inheritanceCost;
+          else
+            childCost[i] = (unionArea - Math::SurfaceArea(child._aabb)) + inheritanceCost;
+        }
+        // Descend according to the minimum cost.
+        if (cost < childCost[0] && cost < childCost[1])
+          break;
+        index = childCost[0] < childCost[1] ? children[0] : children[1];
+      }
+      const uint32_t sibling = index;
+      // Create a new parent for the sibling and the leaf.
+      const uint32_t oldParent = _nodes[sibling]._parent;
+      const uint32_t newParent = AllocateNode();
+      Node& parentNode = _nodes[newParent];
+      parentNode._parent = oldParent;
+      parentNode._aabb = Math::Union(leafAABB, _nodes[sibling]._aabb);
+      parentNode._height = _nodes[sibling]._height + 1;
+      parentNode._child1 = sibling;
+      parentNode._child2 = leafId;
+      if (oldParent != s_invalid)
+      {
+        if (_nodes[oldParent]._child1 == sibling)
+          _nodes[oldParent]._child1 = newParent;
+        else
+          _nodes[oldParent]._child2 = newParent;
+      }
+      else
+      {
+        _root = newParent;
+      }
+      _nodes[sibling]._parent = newParent;
+      _nodes[leafId]._parent = newParent;
+      RefitAncestors(_nodes[leafId]._parent);
+    }
+
+    void DynamicAABBTree::RemoveLeaf(uint32_t leafId)
+    {
+      if (leafId == _root)
+      {
+        _root = s_invalid;
+        return;
+      }
+      const uint32_t parent = _nodes[leafId]._parent;
+      const uint32_t grandParent = _nodes[parent]._parent;
+      const uint32_t sibling = _nodes[parent]._child1 == leafId ? _nodes[parent]._child2 : _nodes[parent]._child1;
+      // The sibling takes the place of the parent.
+      if (grandParent != s_invalid)
+      {
+        if (_nodes[grandParent]._child1 == parent)
+          _nodes[grandParent]._child1 = sibling;
+        else
+          _nodes[grandParent]._child2 = sibling;
+        _nodes[sibling]._parent = grandParent;
+        FreeNode(parent);
+        RefitAncestors(grandParent);
+      }
+      else
+      {
+        _root = sibling;
+        _nodes[sibling]._parent = s_invalid;
+        FreeNode(parent);
+      }
+      _nodes[leafId]._parent = s_invalid;
+    }
+
+    void DynamicAABBTree::RefitAncestors(uint32_t nodeId)
+    {
+      uint32_t index = nodeId;
+      while (index != s_invalid)
+      {
+        index = Balance(index);
+        Node& node = _nodes[index];
+        const Node& child1 = _nodes[node._child1];
+        const Node& child2 = _nodes[node._child2];
+        node._height = 1 + std::max(child1._height, child2._height);
+        node._aabb = Math::Union(child1._aabb, child2._aabb);
+        index = node._parent;
+      }
+    }
+
+    // If the node A is imbalanced, rotate its higher child up, returns the new root of this subtree.
+    // B and C are the children of A, F and G are the children of C.
+    //        A
+    //     B     C
+    //         F   G
+    uint32_t DynamicAABBTree::Balance(uint32_t iA)
+    {
+      Node& A = _nodes[iA];
+      if (A.IsLeaf() || A._height < 2)
+        return iA;
+      uint32_t iB = A._child1;
+      uint32_t iC = A._child2;
+      int32_t balance = _nodes[iC]._height - _nodes[iB]._height;
+      if (balance == 0 || balance == 1 || balance == -1)
+        return iA;
+      // Rotate the higher child up, so call it C.
+      bool rotateChild2 = balance > 1;
+      if (!rotateChild2)
+        std::swap(iB, iC);
+      Node& C = _nodes[iC];
+      uint32_t iF = C._child1;
+      uint32_t iG = C._child2;
+      // Swap A and C
+      C._child1 = iA;
+      C._parent = A._parent;
+      A._parent = iC;
+      // A's old parent should point to C
+      if (C._parent != s_invalid)
+      {
+        if (_nodes[C._parent]._child1 == iA)
+          _nodes[C._parent]._child1 = iC;
+        else
+          _nodes[C._parent]._child2 = iC;
+      }
+      else
+      {
+        _root = iC;
+      }
+      // The higher grandchild stays under C, the lower one goes to A.
+      if (_nodes[iF]._height < _nodes[iG]._height)
+        std::swap(iF, iG);
+      C._child2 = iF;
+      if (rotateChild2)
+        A._child2 = iG;
+      else
+        A._child1 = iG;
+      _nodes[iG]._parent = iA;
+      const Node& B = _nodes[iB];
+      const Node& G = _nodes[iG];
+      A._aabb = Math::Union(B._aabb, G._aabb);
+      A._height = 1 + std::max(B._height, G._height);
+      C._aabb = Math::Union(A._aabb, _nodes[iF]._aabb);
+      C._height = 1 + std::max(A._height, _nodes[iF]._height);
+      return iC;
+    }
+  }
+}
@@ -0,0 +1,192 @@
+#ifndef EAE_ENGINE_SPATIAL_PARTITION_DYNAMIC_AABB_TREE_H
+#define EAE_ENGINE_SPATIAL_PARTITION_DYNAMIC_AABB_TREE_H
+
+#include "Engine/Math/SIMDGeometry.h"
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+/*
+ * The CompleteOctree is built offline for the static collision mesh,
+ * the DynamicAABBTree is for the objects which move every frame.
+ * Each object is a proxy in the tree, the leaves store a fat AABB which is a little larger than the object,
+ * so the proxy only needs to be re-inserted when the object moves out of its fat AABB.
+ * The leaves are inserted next to the sibling which increases the surface area least,
+ * and the tree is kept balanced by the AVL rotations, like the b2DynamicTree of Box2D.
+ * The proxy id is the index of the leaf node, it stays the same until the proxy is destroyed.
+ */
+namespace EAE_Engine
+{
+  namespace Core
+  {
+    struct ProxyPair
+    {
+      uint32_t _proxyA;
+      uint32_t _proxyB;
+    };
+
+    class DynamicAABBTree
+    {
+    public:
+      static const uint32_t s_invalid = 0xffffffff;
+
+      explicit DynamicAABBTree(float fatMargin = 0.1f);
+      uint32_t CreateProxy(const Math::PackedAABB& i_aabb, void* pUserData);
+      void DestroyProxy(uint32_t proxyId);
+      // Returns true when the proxy left its fat AABB and has been re-inserted.
+      bool MoveProxy(uint32_t proxyId, const Math::PackedAABB& i_aabb);
+      void Clear();
+
+      inline void* GetUserData(uint32_t proxyId) const;
+      inline const Math::PackedAABB& GetFatAABB(uint32_t proxyId) const;
+      inline uint32_t GetProxyCount() const { return _proxyCount; }
+      inline uint32_t GetHeight() const { return _root == s_invalid ? 0 : _nodes[_root]._height; }
+      // The sum of the surface area of the internal nodes over the area of the root, the smaller the better.
+      float GetAreaRatio() const;
+      // Check the links, the heights and the boxes of the whole tree, only for the debugging.
+      void Validate() const;
+
+      // callback(proxyId) is called for each proxy whose fat AABB overlaps i_aabb, return false to stop the query.
+      template<typename Callback>
+      void QueryAABB(const Math::PackedAABB& i_aabb, Callback callback) const;
+      // callback(proxyId, maxFraction) is called for each proxy whose fat AABB is hit by the segment from start to end,
+      // maxFraction is the current end of the segment in [0, 1].
+      // Return 0 to stop, the fraction of the hit to clip the segment, or maxFraction to keep going.
+      template<typename Callback>
+      void RayCast(const Math::Vector3& i_start, const Math::Vector3& i_end, Callback callback) const;
+      // The overlapping pairs which have at least one proxy created or moved since the last call.
+      // Each pair is reported once, the smaller proxy id comes first.
+      void UpdatePairs(std::vector<ProxyPair>& o_pairs);
+
+    private:
+      struct Node
+      {
+        bool IsLeaf() const { return _child1 == s_invalid; }
+        Math::PackedAABB _aabb;
+        void* _pUserData;
+        // The parent, or the next free node when the node is in the free list.
+        uint32_t _parent;
+        uint32_t _child1;
+        uint32_t _child2;
+        // leaf = 0, free node = -1
+        int32_t _height;
+        bool _moved;
+      };
+
+      uint32_t AllocateNode();
+      void FreeNode(uint32_t nodeId);
+      void InsertLeaf(uint32_t leafId);
+      void RemoveLeaf(uint32_t leafId);
+      uint32_t Balance(uint32_t nodeId);
+      // Refit the boxes and heights from nodeId to the root, balancing on the way up.
+      void RefitAncestors(uint32_t nodeId);
+      int32_t ValidateNode(uint32_t nodeId) const;
+
+    private:
+      std::vector<Node> _nodes;
+      uint32_t _root;
+      uint32_t _freeList;
+      uint32_t _proxyCount;
+      float _fatMargin;
+      std::vector<uint32_t> _moveBuffer;
+      // The deepest traversal a query needs, it is enough for a balanced tree of billions of proxies.
+      static const size_t s_stackSize = 256;
+    };
+
+    inline void* DynamicAABBTree::GetUserData(uint32_t proxyId) const
+    {
+      assert(proxyId < _nodes.size() && _nodes[proxyId].IsLeaf());
+      return _nodes[proxyId]._pUserData;
+    }
+
+    inline const Math::PackedAABB& DynamicAABBTree::GetFatAABB(uint32_t proxyId) const
+    {
+      assert(proxyId < _nodes.size() && _nodes[proxyId].IsLeaf());
+      return _nodes[proxyId]._aabb;
+    }
+
+    template<typename Callback>
+    void DynamicAABBTree::QueryAABB(const Math::PackedAABB& i_aabb, Callback callback) const
+    {
+      uint32_t stack[s_stackSize];
+      size_t count = 0;
+      if (_root != s_invalid)
+        stack[count++] = _root;
+      while (count > 0)
+      {
+        const Node& node = _nodes[stack[--count]];
+        if (!Math::TestAABBAABB(node._aabb, i_aabb))
+          continue;
+        if (node.IsLeaf())
+        {
+          if (!callback((uint32_t)(&node - &_nodes[0])))
+            return;
+        }
+        else
+        {
+          assert(count + 2 <= s_stackSize);
+          stack[count++] = node._child1;
+          stack[count++] = node._child2;
+        }
+      }
+    }
+
+    template<typename Callback>
+    void DynamicAABBTree::RayCast(const Math::Vector3& i_start, const Math::Vector3& i_end, Callback callback) const
+    {
+      __m128 start = Math::LoadVector3(i_start);
+      __m128 direction = _mm_sub_ps(Math::LoadVector3(i_end), start);
+      // 1 / 0 is inf, and the slab test below still works with it.
+      __m128 invDirection = _mm_div_ps(_mm_set1_ps(1.0f), direction);
+      float maxFraction = 1.0f;
+      uint32_t stack[s_stackSize];
+      size_t count = 0;
+      if (_root != s_invalid)
+        stack[count++] = _root;
+      while (count > 0)
+      {
+        uint32_t nodeId = stack[--count];
+        const Node& node = _nodes[nodeId];
+        // The slab test, the segment is inside the box during [tEnter, tExit].
+        __m128 t1 = _mm_mul_ps(_mm_sub_ps(node._aabb.Min(), start), invDirection);
+        __m128 t2 = _mm_mul_ps(_mm_sub_ps(node._aabb.Max(), start), invDirection);
+        float tNear[4], tFar[4];
+        _mm_storeu_ps(tNear, t1);
+        _mm_storeu_ps(tFar, t2);
+        float tEnter = 0.0f;
+        float tExit = maxFraction;
+        for (size_t axis = 0; axis < 3; ++axis)
+        {
+          // 0 * inf is NaN when the segment is parallel to the slab and starts on its face,
+          // then the segment stays on the face, so this axis doesn't clip it.
+          if (tNear[axis] != tNear[axis] || tFar[axis] != tFar[axis])
+            continue;
+          float tMin = tNear[axis] < tFar[axis] ? tNear[axis] : tFar[axis];
+          float tMax = tNear[axis] < tFar[axis] ? tFar[axis] : tNear[axis];
+          if (tMin > tEnter)
+            tEnter = tMin;
+          if (tMax < tExit)
+            tExit = tMax;
+        }
+        if (tEnter > tExit)
+          continue;
+        if (node.IsLeaf())
+        {
+          float fraction = callback(nodeId, maxFraction);
+          if (fraction == 0.0f)
+            return;
+          if (fraction > 0.0f && fraction < maxFraction)
+            maxFraction = fraction;
+        }
+        else
+        {
+          assert(count + 2 <= s_stackSize);
+          stack[count++] = node._child1;
+          stack[count++] = node._child2;
+        }
+      }
+    }
+  }
+}
+
+#endif//EAE_ENGINE_SPATIAL_PARTITION_DYNAMIC_AABB_TREE_H
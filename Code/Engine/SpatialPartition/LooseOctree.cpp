@@ -0,0 +1,193 @@
+#include "LooseOctree.h"
+#include <algorithm>
+
+namespace EAE_Engine
+{
+  namespace Core
+  {
+    const uint32_t LooseOctree::s_invalid;
+    const uint32_t LooseOctree::s_maxDepth;
+
+    LooseOctree::LooseOctree(const Math::Vector3& i_min, const Math::Vector3& i_max, uint32_t maxDepth) :
+      _maxDepth(std::min(maxDepth, s_maxDepth)), _freeList(s_invalid), _objectCount(0)
+    {
+      Math::Vector3 size = i_max - i_min;
+      _rootSize = std::max(std::max(size._x, size._y), std::max(size._z, 0.0f));
+      _rootMin = (i_min + i_max) * 0.5f - Math::Vector3(_rootSize, _rootSize, _rootSize) * 0.5f;
+      _levelStart[0] = 0;
+      for (uint32_t depth = 0; depth <= _maxDepth; ++depth)
+        _levelStart[depth + 1] = _levelStart[depth] * 8 + 1;
+      Node emptyNode = { s_invalid, 0, 0 };
+      _nodes.assign(_levelStart[_maxDepth + 1], emptyNode);
+    }
+
+    void LooseOctree::Clear()
+    {
+      Node emptyNode = { s_invalid, 0, 0 };
+      std::fill(_nodes.begin(), _nodes.end(), emptyNode);
+      _objects.clear();
+      _freeList = s_invalid;
+      _objectCount = 0;
+    }
+
+    uint32_t LooseOctree::Insert(const Math::PackedAABB& i_aabb, void* pUserData)
+    {
+      uint32_t objectId = _freeList;
+      if (objectId != s_invalid)
+      {
+        _freeList = _objects[objectId]._next;
+      }
+      else
+      {
+        objectId = (uint32_t)_objects.size();
+        _objects.push_back(Object());
+      }
+      Object& object = _objects[objectId];
+      object._aabb = i_aabb;
+      object._pUserData = pUserData;
+      Link(objectId, FindNode(i_aabb));
+      ++_objectCount;
+      return objectId;
+    }
+
+    void LooseOctree::Remove(uint32_t objectId)
+    {
+      assert(objectId < _objects.size() && _objects[objectId]._node != s_invalid);
+      Unlink(objectId);
+      Object& object = _objects[objectId];
+      object._pUserData = nullptr;
+      object._next = _freeList;
+      _freeList = objectId;
+      --_objectCount;
+    }
+
+    bool LooseOctree::Update(uint32_t objectId, const Math::PackedAABB& i_aabb)
+    {
+      assert(objectId < _objects.size() && _objects[objectId]._node != s_invalid);
+      _objects[objectId]._aabb = i_aabb;
+      uint32_t nodeId = FindNode(i_aabb);
+      if (nodeId == _objects[objectId]._node)
+        return false;
+      Unlink(objectId);
+      Link(objectId, nodeId);
+      return true;
+    }
+
+    uint32_t LooseOctree::FindNode(const Math::PackedAABB& i_aabb) const
+    {
+      Math::Vector3 center = Math::StoreVector3(i_aabb.Center());
+      Math::Vector3 extents = Math::StoreVector3(i_aabb.Extents());
+      float maxExtent = std::max(std::max(extents._x, extents._y), extents._z);
+      float cellCoord[3] = { center._x - _rootMin._x, center._y - _rootMin._y, center._z - _rootMin._z };
+      for (size_t axis = 0; axis < 3; ++axis)
+      {
+        // NaN fails this test too.
+        if (!(cellCoord[axis] >= 0.0f && cellCoord[axis] <= _rootSize))
+          return 0;
+      }
+      // The node is twice as large as the cell, so the object fits when its extents are at most half of the cell.
+      uint32_t depth = 0;
+      float halfCellSize = _rootSize * 0.5f;
+      while (depth < _maxDepth && maxExtent <= halfCellSize * 0.5f)
+      {
+        ++depth;
+        halfCellSize *= 0.5f;
+      }
+      const uint32_t cellCount = 1u << depth;
+      uint32_t cell[3];
+      for (size_t axis = 0; axis < 3; ++axis)
+      {
+        float coord = _rootSize > 0.0f ? cellCoord[axis] / _rootSize * cellCount : 0.0f;
+        cell[axis] = std::min((uint32_t)coord, cellCount - 1);
+      }
+      // The bits of x, y and z are interleaved, so the children of a node are next to each other.
+      uint32_t mortonCode = 0;
+      for (uint32_t bit = depth; bit-- > 0; )
+        mortonCode = (mortonCode << 3) | (((cell[0] >> bit) & 1) << 2) | (((cell[1] >> bit) & 1) << 1) | ((cell[2] >> bit) & 1);
+      return _levelStart[depth] + mortonCode;
+    }
+
+    void LooseOctree::Link(uint32_t objectId, uint32_t nodeId)
+    {
+      Object& object = _objects[objectId];
+      Node& node = _nodes[nodeId];
+      object._node = nodeId;
+      object._prev = s_invalid;
+      object._next = node._firstObject;
+      if (node._firstObject != s_invalid)
+        _objects[node._firstObject]._prev = objectId;
+      node._firstObject = objectId;
+      ++node._objectCount;
+      for (uint32_t ancestor = nodeId; ; ancestor = (ancestor - 1) / 8)
+      {
+        ++_nodes[ancestor]._subtreeCount;
+        if (ancestor == 0)
+          break;
+      }
+    }
+
+    void LooseOctree::Unlink(uint32_t objectId)
+    {
+      Object& object = _objects[objectId];
+      Node& node = _nodes[object._node];
+      if (object._prev != s_invalid)
+        _objects[object._prev]._next = object._next;
+      else
+        node._firstObject = object._next;
+      if (object._next != s_invalid)
+        _objects[object._next]._prev = object._prev;
+      --node._objectCount;
+      for (uint32_t ancestor = object._node; ; ancestor = (ancestor - 1) / 8)
+      {
+        --_nodes[ancestor]._subtreeCount;
+        if (ancestor == 0)
+          break;
+      }
+      object._node = s_invalid;
+      object._prev = s_invalid;
+      object._next = s_invalid;
+    }
+
+    Math::PackedAABB LooseOctree::GetLooseAABB(const NodeCell& i_cell) const
+    {
+      float cellSize = _rootSize / (float)(1u << i_cell._depth);
+      __m128 cellMin = _mm_add_ps(Math::LoadVector3(_rootMin),
+        _mm_mul_ps(_mm_setr_ps((float)i_cell._x, (float)i_cell._y, (float)i_cell._z, 0.0f), _mm_set1_ps(cellSize)));
+      __m128 halfCellSize = _mm_set1_ps(cellSize * 0.5f);
+      Math::PackedAABB result;
+      result.Set(_mm_sub_ps(cellMin, halfCellSize), _mm_add_ps(_mm_add_ps(cellMin, _mm_set1_ps(cellSize)), halfCellSize));
+      return result;
+    }
+
+    void LooseOctree::Validate() const
+    {
+      std::vector<uint32_t> subtreeCounts(_nodes.size(), 0);
+      uint32_t objectCount = 0;
+      for (uint32_t nodeId = 0; nodeId < _nodes.size(); ++nodeId)
+      {
+        const Node& node = _nodes[nodeId];
+        uint32_t countInNode = 0;
+        uint32_t prev = s_invalid;
+        for (uint32_t objectId = node._firstObject; objectId != s_invalid; objectId = _objects[objectId]._next)
+        {
+          assert(_objects[objectId]._node == nodeId);
+          assert(_objects[objectId]._prev == prev);
+          prev = objectId;
+          ++countInNode;
+        }
+        assert(countInNode == node._objectCount);
+        objectCount += countInNode;
+        for (uint32_t ancestor = nodeId; ; ancestor = (ancestor - 1) / 8)
+        {
+          subtreeCounts[ancestor] += countInNode;
+          if (ancestor == 0)
+            break;
+        }
+      }
+      assert(objectCount == _objectCount);
+      for (uint32_t nodeId = 0; nodeId < _nodes.size(); ++nodeId)
+        assert(subtreeCounts[nodeId] == _nodes[nodeId]._subtreeCount);
+      (void)objectCount;
+    }
+  }
+}
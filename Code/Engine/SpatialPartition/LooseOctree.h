@@ -0,0 +1,188 @@
+#ifndef EAE_ENGINE_SPATIAL_PARTITION_LOOSE_OCTREE_H
+#define EAE_ENGINE_SPATIAL_PARTITION_LOOSE_OCTREE_H
+
+#include "Engine/Math/SIMDGeometry.h"
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+/*
+ * The LooseOctree is for the GameObjs which move every frame, the CompleteOctree is for the static collision mesh.
+ * Each node is twice as large as its cell, so an object always fits in the node of the cell which has its center
+ * at the depth where the cell is not smaller than the object, from Game Programming Gems 1, 4.11.
+ * So the node of an object is found without any traversal, and moving an object only relinks it from one list to another.
+ * The nodes are a complete tree like the CompleteOctree, the children of node i are 8i + 1 to 8i + 8,
+ * the nodes are kept for all of the levels so nothing is allocated when the objects move.
+ * Each node counts the objects of its subtree, so the queries skip the empty subtrees.
+ * The objects whose center is out of the bounds stay in the root, which is tested for all of the queries.
+ */
+namespace EAE_Engine
+{
+  namespace Core
+  {
+    class LooseOctree
+    {
+    public:
+      static const uint32_t s_invalid = 0xffffffff;
+      static const uint32_t s_maxDepth = 8;
+
+      // The root is the cube around i_min and i_max, maxDepth is the count of the levels below the root.
+      LooseOctree(const Math::Vector3& i_min, const Math::Vector3& i_max, uint32_t maxDepth = 4);
+      uint32_t Insert(const Math::PackedAABB& i_aabb, void* pUserData);
+      void Remove(uint32_t objectId);
+      // Returns true when the object has moved to another node.
+      bool Update(uint32_t objectId, const Math::PackedAABB& i_aabb);
+      void Clear();
+
+      inline void* GetUserData(uint32_t objectId) const;
+      inline const Math::PackedAABB& GetAABB(uint32_t objectId) const;
+      inline uint32_t GetObjectCount() const { return _objectCount; }
+      inline uint32_t GetNodeCount() const { return (uint32_t)_nodes.size(); }
+      inline uint32_t GetMaxDepth() const { return _maxDepth; }
+      // Check the lists and the counts of all of the nodes, only for the debugging.
+      void Validate() const;
+
+      // callback(objectId) is called for each object whose AABB overlaps i_aabb, return false to stop the query.
+      template<typename Callback>
+      void QueryAABB(const Math::PackedAABB& i_aabb, Callback callback) const;
+      // callback(objectId) is called for each object whose AABB overlaps the sphere, return false to stop the query.
+      template<typename Callback>
+      void QuerySphere(const Math::Vector3& i_center, float radius, Callback callback) const;
+      // callback(objectId) is called for each object whose AABB may be in the frustum, return false to stop the query.
+      // The planes which contain a whole node are not tested again for its children and objects.
+      template<typename Callback>
+      void QueryFrustum(const Math::PackedFrustum& i_frustum, Callback callback) const;
+
+    private:
+      struct Object
+      {
+        Math::PackedAABB _aabb;
+        void* _pUserData;
+        // s_invalid when the object is in the free list.
+        uint32_t _node;
+        uint32_t _prev;
+        // The next object in the node, or the next free object.
+        uint32_t _next;
+      };
+
+      struct Node
+      {
+        uint32_t _firstObject;
+        uint32_t _objectCount;
+        // The objects in the node and all of its descendants.
+        uint32_t _subtreeCount;
+      };
+
+      // The node is at depth, its cell is the xth, yth and zth one in the grid of the depth.
+      struct NodeCell
+      {
+        uint32_t _node;
+        uint32_t _depth;
+        uint32_t _x, _y, _z;
+        // Only used by QueryFrustum.
+        uint32_t _planeMask;
+      };
+
+      uint32_t FindNode(const Math::PackedAABB& i_aabb) const;
+      void Link(uint32_t objectId, uint32_t nodeId);
+      void Unlink(uint32_t objectId);
+      Math::PackedAABB GetLooseAABB(const NodeCell& i_cell) const;
+      // nodeTest(aabb, cell) returns false when the node can be skipped, it may change the _planeMask of the cell.
+      // objectTest(aabb, cell) returns false when the object can be skipped.
+      template<typename NodeTest, typename ObjectTest, typename Callback>
+      void Query(uint32_t planeMask, NodeTest nodeTest, ObjectTest objectTest, Callback callback) const;
+
+    private:
+      std::vector<Node> _nodes;
+      std::vector<Object> _objects;
+      // The first node of each level.
+      uint32_t _levelStart[s_maxDepth + 2];
+      Math::Vector3 _rootMin;
+      float _rootSize;
+      uint32_t _maxDepth;
+      uint32_t _freeList;
+      uint32_t _objectCount;
+    };
+
+    inline void* LooseOctree::GetUserData(uint32_t objectId) const
+    {
+      assert(objectId < _objects.size() && _objects[objectId]._node != s_invalid);
+      return _objects[objectId]._pUserData;
+    }
+
+    inline const Math::PackedAABB& LooseOctree::GetAABB(uint32_t objectId) const
+    {
+      assert(objectId < _objects.size() && _objects[objectId]._node != s_invalid);
+      return _objects[objectId]._aabb;
+    }
+
+    template<typename Callback>
+    void LooseOctree::QueryAABB(const Math::PackedAABB& i_aabb, Callback callback) const
+    {
+      auto test = [&i_aabb](const Math::PackedAABB& i_bounds, NodeCell&) { return Math::TestAABBAABB(i_bounds, i_aabb); };
+      Query(0, test, test, callback);
+    }
+
+    template<typename Callback>
+    void LooseOctree::QuerySphere(const Math::Vector3& i_center, float radius, Callback callback) const
+    {
+      auto test = [&i_center, radius](const Math::PackedAABB& i_bounds, NodeCell&) { return Math::TestAABBSphere(i_bounds, i_center, radius); };
+      Query(0, test, test, callback);
+    }
+
+    template<typename Callback>
+    void LooseOctree::QueryFrustum(const Math::PackedFrustum& i_frustum, Callback callback) const
+    {
+      auto nodeTest = [&i_frustum](const Math::PackedAABB& i_bounds, NodeCell& io_cell)
+      {
+        return Math::TestAABBFrustum(i_bounds, i_frustum, io_cell._planeMask);
+      };
+      // The objects of a node inside all of the planes are inside too.
+      auto objectTest = [&i_frustum](const Math::PackedAABB& i_bounds, NodeCell& i_cell)
+      {
+        uint32_t planeMask = i_cell._planeMask;
+        return planeMask == 0 || Math::TestAABBFrustum(i_bounds, i_frustum, planeMask);
+      };
+      Query(Math::PackedFrustum::s_allPlanes, nodeTest, objectTest, callback);
+    }
+
+    template<typename NodeTest, typename ObjectTest, typename Callback>
+    void LooseOctree::Query(uint32_t planeMask, NodeTest nodeTest, ObjectTest objectTest, Callback callback) const
+    {
+      // The depth first traversal keeps at most 7 siblings of each level in the stack.
+      NodeCell stack[7 * s_maxDepth + 1];
+      size_t count = 0;
+      NodeCell root = { 0, 0, 0, 0, 0, planeMask };
+      if (_nodes[0]._subtreeCount > 0)
+        stack[count++] = root;
+      while (count > 0)
+      {
+        NodeCell cell = stack[--count];
+        // The root is never skipped, it also holds the objects out of the bounds.
+        if (cell._depth > 0 && !nodeTest(GetLooseAABB(cell), cell))
+          continue;
+        const Node& node = _nodes[cell._node];
+        for (uint32_t objectId = node._firstObject; objectId != s_invalid; objectId = _objects[objectId]._next)
+        {
+          if (objectTest(_objects[objectId]._aabb, cell) && !callback(objectId))
+            return;
+        }
+        if (cell._depth == _maxDepth || node._subtreeCount == node._objectCount)
+          continue;
+        uint32_t firstChild = cell._node * 8 + 1;
+        for (uint32_t childIndex = 0; childIndex < 8; ++childIndex)
+        {
+          if (_nodes[firstChild + childIndex]._subtreeCount == 0)
+            continue;
+          NodeCell child = { firstChild + childIndex, cell._depth + 1,
+            cell._x * 2 + ((childIndex >> 2) & 1), cell._y * 2 + ((childIndex >> 1) & 1), cell._z * 2 + (childIndex & 1),
+            cell._planeMask };
+          assert(count < sizeof(stack) / sizeof(stack[0]));
+          stack[count++] = child;
+        }
+      }
+    }
+  }
+}
+
+#endif//EAE_ENGINE_SPATIAL_PARTITION_LOOSE_OCTREE_H
@@ -1,5 +1,6 @@
 #include "Octree.h"
 #include "Engine/CollisionDetection/CollisionDetectionFunctions.h"
+#include "Engine/CollisionDetection/SIMDCollisionFunctions.h"
 #include <algorithm>
 #include "General/Implements.h"
 #include "Windows/WindowsFunctions.h"
@@ -12,7 +13,8 @@ namespace EAE_Engine
     ///////////////////////////////CompleteOctree///////////////////////////////////////
     CompleteOctree::CompleteOctree() :
       _min(Math::Vector3::Zero), _max(Math::Vector3::Zero),
-      _level(0), _countOfNode(0), _pNodes(nullptr), _pMeshData(nullptr) 
+      _level(0), _countOfNode(0), _pNodes(nullptr), _pMeshData(nullptr),
+      _pTriangles(nullptr), _pReferences16(nullptr), _pReferences32(nullptr), _dataSize(0)
     {}
 
     CompleteOctree::~CompleteOctree()
@@ -27,46 +29,20 @@ namespace EAE_Engine
       infile.seekg(0, infile.end);
       std::streamoff size = infile.tellg();
       infile.seekg(0);
-      // allocate memory for file content
-      char* pBuffer = new char[(uint32_t)size];
-      // read content of infile
-      infile.read(pBuffer, size);
+      // read the whole file into the block used by the octree, so there is one allocation for all of the leaves.
+      std::vector<uint8_t> data(size > 0 ? (size_t)size : 0);
+      if (size > 0)
+        infile.read((char*)&data[0], size);
+      infile.close();
+      // the legacy file is converted, run the OctreeBuilder on it to load it without the conversion.
+      if (!IsCompactOctree(data.empty() ? nullptr : &data[0], data.size()))
       {
-        uint32_t offset = 0;
-        EAE_Engine::CopyMem((uint8_t*)(pBuffer + offset), (uint8_t*)&_level, sizeof(uint32_t));
-        offset += sizeof(uint32_t);
-        EAE_Engine::CopyMem((uint8_t*)(pBuffer + offset), (uint8_t*)&_countOfNode, sizeof(uint32_t));
-        offset += sizeof(uint32_t);
-        EAE_Engine::CopyMem((uint8_t*)(pBuffer + offset), (uint8_t*)&_min, sizeof(EAE_Engine::Math::Vector3));
-        offset += sizeof(EAE_Engine::Math::Vector3);
-        EAE_Engine::CopyMem((uint8_t*)(pBuffer + offset), (uint8_t*)&_max, sizeof(EAE_Engine::Math::Vector3));
-        offset += sizeof(EAE_Engine::Math::Vector3);
-        // Build the Octree Architecture
-        InitFromRange(_level, _min, _max);
-        // Now let's fill in the trianlges information
-        OctreeNode* pLeaves = GetNodesInLevel(_level - 1);
-        uint32_t countOfLeaves = GetCountOfNodesInLevel(_level - 1);
-        for (uint32_t leafIndex = 0; leafIndex < countOfLeaves; ++leafIndex)
-        {
-          // record count of trianlges in this node
-          uint32_t triangleCountInLeaf = 0;
-          CopyMem((uint8_t*)pBuffer + offset, (uint8_t*)&triangleCountInLeaf, sizeof(uint32_t));
-          offset += sizeof(uint32_t);
-          if (triangleCountInLeaf > 0)
-          {
-            for (uint32_t trianlgeIndex = 0; trianlgeIndex < triangleCountInLeaf; ++trianlgeIndex)
-            {
-              Mesh::TriangleIndex tempTraiangle;
-              CopyMem((uint8_t*)pBuffer + offset, (uint8_t*)&tempTraiangle, sizeof(Mesh::TriangleIndex));
-              pLeaves[leafIndex]._triangles.push_back(tempTraiangle);
-              offset += sizeof(Mesh::TriangleIndex);
-            }
-          }
-        }
+        std::vector<uint8_t> compactData;
+        if (ConvertToCompactOctree(data.empty() ? nullptr : &data[0], data.size(), compactData))
+          data.swap(compactData);
       }
-      // release dynamically-allocated memory
-      delete[] pBuffer;
-      infile.close();
+      if (!data.empty() && InitFromMemory(&data[0], data.size()))
+        _data.swap(data);
 
       Mesh::LoadMeshData(pCollisionMesh);
       std::string mesh_path(pCollisionMesh);
@@ -74,106 +50,97 @@ namespace EAE_Engine
       _pMeshData = Mesh::AOSMeshDataManager::GetInstance()->GetAOSMeshData(key.c_str());
     }
 
+    bool CompleteOctree::InitFromMemory(const void* pData, size_t size)
+    {
+      if (!IsValidCompactOctree(pData, size))
+        return false;
+      CompactOctreeHeader header;
+      CopyMem((const uint8_t*)pData, (uint8_t*)&header, sizeof(CompactOctreeHeader));
+      const size_t dataSize = GetCompactOctreeSize(header);
+      // Build the Octree Architecture
+      InitFromRange(header._level, header._min, header._max);
+      const uint8_t* pBuffer = (const uint8_t*)pData + sizeof(CompactOctreeHeader);
+      const uint32_t* pFirstReferences = reinterpret_cast<const uint32_t*>(pBuffer);
+      pBuffer += (header._leafCount + 1) * sizeof(uint32_t);
+      _pTriangles = reinterpret_cast<const Mesh::TriangleIndex*>(pBuffer);
+      pBuffer += header._triangleCount * sizeof(Mesh::TriangleIndex);
+      _pReferences16 = header._referenceSize == sizeof(uint16_t) ? reinterpret_cast<const uint16_t*>(pBuffer) : nullptr;
+      _pReferences32 = header._referenceSize == sizeof(uint32_t) ? reinterpret_cast<const uint32_t*>(pBuffer) : nullptr;
+      _dataSize = dataSize;
+      _data.clear();
+      // Now let's point the leaves to their triangles
+      OctreeNode* pLeaves = GetNodesInLevel(_level - 1);
+      for (uint32_t leafIndex = 0; leafIndex < header._leafCount; ++leafIndex)
+      {
+        pLeaves[leafIndex]._firstTriangle = pFirstReferences[leafIndex];
+        pLeaves[leafIndex]._triangleCount = pFirstReferences[leafIndex + 1] - pFirstReferences[leafIndex];
+      }
+      return true;
+    }
+
+    void CompleteOctree::InitFromTriangles(uint32_t level, const Math::Vector3& i_min, const Math::Vector3& i_max,
+      const std::vector<std::vector<Mesh::TriangleIndex> >& i_leafTriangles)
+    {
+      std::vector<uint8_t> data;
+      WriteCompactOctree(level, i_min, i_max, i_leafTriangles, data);
+      if (InitFromMemory(&data[0], data.size()))
+        _data.swap(data);
+    }
+
+
+    uint32_t GetChildrenCollideWithSegment(const OctreeNode* pChildren, const Math::Vector3& start, const Math::Vector3& end)
+    {
+      Math::AABB8 boxes;
+      for (uint32_t i = 0; i < 8; ++i)
+        boxes.Set(i, Math::PackedAABB(pChildren[i]._pos - pChildren[i]._extent, pChildren[i]._pos + pChildren[i]._extent));
+      return Collision::TestSegmentAABB8(start, end, boxes);
+    }
 
     std::vector<OctreeNode*> CompleteOctree::GetNodesCollideWithSegment(Math::Vector3 start, Math::Vector3 end, uint32_t levelIndex)
     {
       std::vector<OctreeNode*> nodesCollided;
       if (levelIndex > _level - 1)
         return nodesCollided;
+      Math::AABBV1 aabb;
+      aabb._min = _pNodes[0].GetMin();
+      aabb._max = _pNodes[0].GetMax();
+      if (!Collision::TestSegmentAABB(start, end, aabb))
+        return nodesCollided;
       nodesCollided.push_back(&_pNodes[0]);
-      for (; nodesCollided.size() > 0; )
+      // only the nodes overlapping the segment are kept, their 8 children are tested together.
+      while (!IsInLevel(nodesCollided[0], levelIndex))
       {
         std::vector<OctreeNode*> newNodesCollided;
-        if (IsInLevel(nodesCollided[0], levelIndex))
-        {
-          for (std::vector<OctreeNode*>::iterator it = nodesCollided.begin(); it < nodesCollided.end(); ++it)
-          {
-            OctreeNode* pNode = *it;
-            Math::AABBV1 aabb;
-            aabb._min = pNode->GetMin();
-            aabb._max = pNode->GetMax();
-            if (Collision::TestSegmentAABB(start, end, aabb))
-            {
-              newNodesCollided.push_back(pNode);
-            }
-          }
-          nodesCollided.clear();
-          nodesCollided = newNodesCollided;
-          // sort the nodes based on the distance from the Node
-          // we're using lambad at here.
-          std::sort(nodesCollided.begin(), nodesCollided.end(), 
-            [&](OctreeNode* i_pObjA, OctreeNode* i_pObjB) { return (i_pObjA->_pos - start).Magnitude() < (i_pObjB->_pos - start).Magnitude(); });
-          break;
-        }
         for (std::vector<OctreeNode*>::iterator it = nodesCollided.begin(); it < nodesCollided.end(); ++it)
         {
-          OctreeNode* pNode = *it;
-          Math::AABBV1 aabb;
-          aabb._min = pNode->GetMin();
-          aabb._max = pNode->GetMax();
-          if (Collision::TestSegmentAABB(start, end, aabb))
+          OctreeNode* pChild = GetChildOfNode(*it);
+          uint32_t childMask = GetChildrenCollideWithSegment(pChild, start, end);
+          for (uint32_t i = 0; i < 8; ++i)
           {
-            OctreeNode* pChild = GetChildOfNode(pNode);
-            for (uint32_t i = 0; i < 8; ++i)
+            if (childMask & (1u << i))
               newNodesCollided.push_back(&pChild[i]);
           }
         }
-        nodesCollided.clear();
-        nodesCollided = newNodesCollided;
+        nodesCollided.swap(newNodesCollided);
+        if (nodesCollided.empty())
+          return nodesCollided;
       }
+      // sort the nodes based on the distance from the Node
+      // we're using lambad at here.
+      std::sort(nodesCollided.begin(), nodesCollided.end(), 
+        [&](OctreeNode* i_pObjA, OctreeNode* i_pObjB) { return (i_pObjA->_pos - start).Magnitude() < (i_pObjB->_pos - start).Magnitude(); });
       return nodesCollided;
     }
 
     std::vector<OctreeNode*> CompleteOctree::GetLeavesCollideWithSegment(Math::Vector3 start, Math::Vector3 end)
     {
-      std::vector<OctreeNode*> nodesCollided;
-      nodesCollided.push_back(&_pNodes[0]);
-      for (; nodesCollided.size() > 0; )
-      {
-        std::vector<OctreeNode*> newNodesCollided;
-        if (IsLeaf(nodesCollided[0]))
-        {
-          for (std::vector<OctreeNode*>::iterator it = nodesCollided.begin(); it < nodesCollided.end(); ++it)
-          {
-            OctreeNode* pNode = *it;
-            Math::AABBV1 aabb;
-            aabb._min = pNode->GetMin();
-            aabb._max = pNode->GetMax();
-            if (Collision::TestSegmentAABB(start, end, aabb))
-            {
-              newNodesCollided.push_back(pNode);
-            }
-          }
-          nodesCollided.clear();
-          nodesCollided = newNodesCollided;
-          // sort the nodes based on the distance from the Node
-          std::sort(nodesCollided.begin(), nodesCollided.end(), 
-            [&](OctreeNode* i_pObjA, OctreeNode* i_pObjB) { return (i_pObjA->_pos - start).Magnitude() < (i_pObjB->_pos - start).Magnitude(); });
-          break;
-        }
-        for (std::vector<OctreeNode*>::iterator it = nodesCollided.begin(); it < nodesCollided.end(); ++it)
-        {
-          OctreeNode* pNode = *it;
-          Math::AABBV1 aabb;
-          aabb._min = pNode->GetMin();
-          aabb._max = pNode->GetMax();
-          if (Collision::TestSegmentAABB(start, end, aabb))
-          {
-            OctreeNode* pChild = GetChildOfNode(pNode);
-            for (uint32_t i = 0; i < 8; ++i)
-              newNodesCollided.push_back(&pChild[i]);
-          }
-        }
-        nodesCollided.clear();
-        nodesCollided = newNodesCollided;
-      }
-      return nodesCollided;
+      return GetNodesCollideWithSegment(start, end, _level - 1);
     }
     
     struct TriangleCollisionInfo 
     {
       float _t;
-      Mesh::TriangleIndex* _pTriangle;
+      Mesh::TriangleIndex _triangle;
     };
 
     void CompleteOctree::GetTrianlgesCollideWithSegment(Math::Vector3 start, Math::Vector3 end, std::vector<Mesh::TriangleIndex>& o_triangles)
@@ -183,11 +150,12 @@ namespace EAE_Engine
       for (std::vector<OctreeNode*>::iterator it = leavesCollided.begin(); it != leavesCollided.end(); ++it)
       {
         OctreeNode* pLeaf = *it;
-        for (std::vector<Mesh::TriangleIndex>::iterator itTrianlge = pLeaf->_triangles.begin(); itTrianlge != pLeaf->_triangles.end(); ++itTrianlge)
+        for (uint32_t trianlgeIndex = 0; trianlgeIndex < pLeaf->_triangleCount; ++trianlgeIndex)
         {
-          uint32_t index0 = itTrianlge->_index0;
-          uint32_t index1 = itTrianlge->_index1;
-          uint32_t index2 = itTrianlge->_index2;
+          Mesh::TriangleIndex triangle = GetTriangle(*pLeaf, trianlgeIndex);
+          uint32_t index0 = triangle._index0;
+          uint32_t index1 = triangle._index1;
+          uint32_t index2 = triangle._index2;
           Mesh::sVertex& svertex0 = _pMeshData->_vertices[index0];
           Mesh::sVertex& svertex1 = _pMeshData->_vertices[index1];
           Mesh::sVertex& svertex2 = _pMeshData->_vertices[index2];
@@ -206,7 +174,7 @@ namespace EAE_Engine
           int collided = Collision::IntersectSegmentTriangle(start, end, vertex0, vertex1, vertex2, u, v, w, t);
           if (collided)
           {
-            needToSort.push_back({t, &*itTrianlge});
+            needToSort.push_back({t, triangle});
           }
         }
       }
@@ -218,18 +186,72 @@ namespace EAE_Engine
       std::vector<TriangleCollisionInfo>::iterator previousTriangle = itTrianlge;
       for (; itTrianlge != needToSort.end(); ++itTrianlge)
       {
-        if (Implements::AlmostEqual2sComplement(previousTriangle->_t, itTrianlge->_t, 4) && o_triangles.size() > 0)
+        if (Implements::AlmostEqualUlps(previousTriangle->_t, itTrianlge->_t, 4) && o_triangles.size() > 0)
         {
-          if (*(previousTriangle->_pTriangle) == *(itTrianlge->_pTriangle))
+          if (previousTriangle->_triangle == itTrianlge->_triangle)
           {
             continue;
           }
         }
         previousTriangle = itTrianlge;
-        o_triangles.push_back(*itTrianlge->_pTriangle);
+        o_triangles.push_back(itTrianlge->_triangle);
       }
     }
 
+    uint32_t CompleteOctree::GetTrianlgesCollideWithSegment(const Math::Vector3& start, const Math::Vector3& end, SegmentHit* o_pHits, uint32_t maxHits) const
+    {
+      if (_pMeshData == nullptr || maxHits == 0)
+        return 0;
+      const std::vector<Mesh::sVertex>& vertices = _pMeshData->_vertices;
+      uint32_t hitCount = 0;
+      VisitNodesAlongSegment(start, end, _level - 1, [&](const OctreeNode& i_leaf, float tEnter, float tExit)
+      {
+        for (uint32_t triangleIndex = 0; triangleIndex < i_leaf._triangleCount; ++triangleIndex)
+        {
+          Mesh::TriangleIndex triangle = GetTriangle(i_leaf, triangleIndex);
+          const Mesh::sVertex& svertex0 = vertices[triangle._index0];
+          const Mesh::sVertex& svertex1 = vertices[triangle._index1];
+          const Mesh::sVertex& svertex2 = vertices[triangle._index2];
+          float u = 0, v = 0, w = 0, t = 0;
+          if (!Collision::IntersectSegmentTriangle(start, end, Math::Vector3(svertex0.x, svertex0.y, svertex0.z),
+            Math::Vector3(svertex1.x, svertex1.y, svertex1.z), Math::Vector3(svertex2.x, svertex2.y, svertex2.z), u, v, w, t))
+            continue;
+          InsertSegmentHit(o_pHits, hitCount, maxHits, t, triangle);
+        }
+        // The hits before tExit are confirmed, the later leaves can only have farther ones.
+        return hitCount < maxHits || o_pHits[hitCount - 1]._t > tExit;
+      });
+      return hitCount;
+    }
+
+    void CompleteOctree::GetLeavesInFrustum(const Math::PackedFrustum& i_frustum, std::vector<OctreeNode*>& o_leaves)
+    {
+      o_leaves.clear();
+      VisitLeavesInFrustum(i_frustum, [&o_leaves](const OctreeNode* pLeaves, uint32_t leafCount)
+      {
+        for (uint32_t leafIndex = 0; leafIndex < leafCount; ++leafIndex)
+        {
+          if (pLeaves[leafIndex]._triangleCount > 0)
+            o_leaves.push_back(const_cast<OctreeNode*>(&pLeaves[leafIndex]));
+        }
+        return true;
+      });
+    }
+
+    void CompleteOctree::GetLeavesInAABB(const Math::PackedAABB& i_aabb, std::vector<OctreeNode*>& o_leaves)
+    {
+      o_leaves.clear();
+      VisitLeavesInAABB(i_aabb, [&o_leaves](const OctreeNode* pLeaves, uint32_t leafCount)
+      {
+        for (uint32_t leafIndex = 0; leafIndex < leafCount; ++leafIndex)
+        {
+          if (pLeaves[leafIndex]._triangleCount > 0)
+            o_leaves.push_back(const_cast<OctreeNode*>(&pLeaves[leafIndex]));
+        }
+        return true;
+      });
+    }
+
     OctreeNode* CompleteOctree::GetChildOfNode(OctreeNode* pNode)
     {
       size_t member = reinterpret_cast<size_t>(pNode) - reinterpret_cast<size_t>(_pNodes);
@@ -274,11 +296,26 @@ namespace EAE_Engine
         SAFE_DELETE(pOctree);
       }
       _octrees.clear();
+      _octreeNames.clear();
+      for (std::vector<LooseOctree*>::iterator octreeIt = _looseOctrees.begin(); octreeIt != _looseOctrees.end(); )
+      {
+        LooseOctree* pOctree = *octreeIt++;
+        SAFE_DELETE(pOctree);
+      }
+      _looseOctrees.clear();
+      _looseOctreeNames.clear();
     }
 
     void OctreeManager::AddOctree(CompleteOctree* pCompleteOctree) 
     {
+      AddOctree("", pCompleteOctree);
+    }
+
+    void OctreeManager::AddOctree(const char* pName, CompleteOctree* pCompleteOctree)
+    {
+      assert(GetOctree(pName) == nullptr || *pName == '\0');
       _octrees.push_back(pCompleteOctree);
+      _octreeNames.push_back(pName);
     }
 
     CompleteOctree* OctreeManager::GetOctree()
@@ -288,5 +325,32 @@ namespace EAE_Engine
       return _octrees[0];
     }
 
+    CompleteOctree* OctreeManager::GetOctree(const char* pName)
+    {
+      for (size_t index = 0; index < _octreeNames.size(); ++index)
+      {
+        if (_octreeNames[index] == pName)
+          return _octrees[index];
+      }
+      return nullptr;
+    }
+
+    void OctreeManager::AddLooseOctree(const char* pName, LooseOctree* pLooseOctree)
+    {
+      assert(GetLooseOctree(pName) == nullptr);
+      _looseOctrees.push_back(pLooseOctree);
+      _looseOctreeNames.push_back(pName);
+    }
+
+    LooseOctree* OctreeManager::GetLooseOctree(const char* pName)
+    {
+      for (size_t index = 0; index < _looseOctreeNames.size(); ++index)
+      {
+        if (_looseOctreeNames[index] == pName)
+          return _looseOctrees[index];
+      }
+      return nullptr;
+    }
+
   }
 }
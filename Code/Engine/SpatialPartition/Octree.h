@@ -5,8 +5,17 @@
 #include "Engine/Mesh/AOSMeshData.h"
 #include "Engine/General/MemoryOp.h"
 #include "Engine/General/Singleton.hpp"
+#include "OctreeFile.h"
+#include "OctreeLeafBuilder.h"
+#include "LooseOctree.h"
+#include "Engine/Math/SIMDGeometry.h"
+#include <algorithm>
+#include <cassert>
 #include <vector>
+#include <string>
 #include <fstream>
+#include <cfloat>
+#include <cmath>
 
 
 namespace EAE_Engine 
@@ -18,11 +27,46 @@ namespace EAE_Engine
 		{
 			Math::Vector3 _pos;
 			Math::Vector3 _extent;
-			std::vector<Mesh::TriangleIndex> _triangles;
+			// the triangles of a leaf are CompleteOctree::GetTriangle(leaf, i) for i in [0, _triangleCount).
+			uint32_t _firstTriangle;
+			uint32_t _triangleCount;
 			Math::Vector3 GetMin() { return _pos - _extent; }
 			Math::Vector3 GetMax() { return _pos + _extent; }
 		};
 
+		struct SegmentHit
+		{
+			// in [0, 1] from the start to the end of the segment.
+			float _t;
+			Mesh::TriangleIndex _triangle;
+		};
+
+		// Insert the hit into o_pHits[0, io_hitCount) sorted by _t, which keeps the closest maxHits of them.
+		// A triangle already in the list is skipped, the triangle in more than one leaf is found again in each of them.
+		inline void InsertSegmentHit(SegmentHit* o_pHits, uint32_t& io_hitCount, uint32_t maxHits, float t, const Mesh::TriangleIndex& triangle)
+		{
+			if (io_hitCount == maxHits && t >= o_pHits[io_hitCount - 1]._t)
+				return;
+			for (uint32_t i = 0; i < io_hitCount; ++i)
+			{
+				if (o_pHits[i]._triangle == triangle)
+					return;
+			}
+			uint32_t insert = io_hitCount;
+			if (io_hitCount < maxHits)
+				++io_hitCount;
+			else
+				--insert;
+			for (; insert > 0 && o_pHits[insert - 1]._t > t; --insert)
+				o_pHits[insert] = o_pHits[insert - 1];
+			o_pHits[insert]._t = t;
+			o_pHits[insert]._triangle = triangle;
+		}
+
+		// The mask of the 8 children at pChildren which the segment overlaps, the ith bit is the ith child,
+		// the same as TestSegmentAABB on each of them but with one TestSegmentAABB8.
+		uint32_t GetChildrenCollideWithSegment(const OctreeNode* pChildren, const Math::Vector3& start, const Math::Vector3& end);
+
 		class CompleteOctree
 		{
 		public: 
@@ -30,6 +74,17 @@ namespace EAE_Engine
 			~CompleteOctree();
 			inline void InitFromRange(uint32_t level, Math::Vector3 min, Math::Vector3 max);
 			void InitFromFile(const char* pOctreeFile, const char* pMeshKey);
+			// Use the compact file in pData in place, the memory must stay until the octree is destroyed, like a mapped file.
+			// Returns false when it isn't a valid compact file, see OctreeFile.h.
+			bool InitFromMemory(const void* pData, size_t size);
+			// Build the octree with the triangles of each leaf, see WriteCompactOctree.
+			void InitFromTriangles(uint32_t level, const Math::Vector3& i_min, const Math::Vector3& i_max,
+				const std::vector<std::vector<Mesh::TriangleIndex> >& i_leafTriangles);
+			inline void SetCollisionMesh(Mesh::AOSMeshData* pMeshData) { _pMeshData = pMeshData; }
+			// The triangle i of the leaf, i < i_leaf._triangleCount.
+			inline Mesh::TriangleIndex GetTriangle(const OctreeNode& i_leaf, uint32_t i) const;
+			// the bytes of the nodes and the triangles of the leaves.
+			inline size_t GetMemorySize() const { return _countOfNode * sizeof(OctreeNode) + _dataSize; }
 			inline OctreeNode* GetNodesInLevel(uint32_t levelIndex);
 			inline uint32_t GetCountOfNodesInLevel(uint32_t levelIndex) { return (uint32_t)std::pow(8.0f, levelIndex); }
 			inline uint32_t GetNodeCount() { return _countOfNode; }
@@ -40,12 +95,40 @@ namespace EAE_Engine
 			std::vector<OctreeNode*> GetNodesCollideWithSegment(Math::Vector3 start, Math::Vector3 end, uint32_t levelIndex);
 			std::vector<OctreeNode*> GetLeavesCollideWithSegment(Math::Vector3 start, Math::Vector3 end);
       void GetTrianlgesCollideWithSegment(Math::Vector3 start, Math::Vector3 end, std::vector<Mesh::TriangleIndex>& o_triangles);
+      // The closest maxHits triangles whose front faces are hit by the segment, sorted by _t, returns the count of them.
+      // The leaves are tested one by one from near to far, and it stops at the first leaf
+      // which ends after the farthest of the maxHits hits, so maxHits == 1 stops at the first confirmed hit.
+      // Each triangle is in o_pHits once. It allocates nothing, o_pHits must have maxHits elements.
+      uint32_t GetTrianlgesCollideWithSegment(const Math::Vector3& start, const Math::Vector3& end, SegmentHit* o_pHits, uint32_t maxHits) const;
+      // Visit the nodes in levelIndex crossed by the segment from near to far without a stack:
+      // the nodes in a level of the complete octree are a uniform grid, so it steps through its cells like a 3D DDA.
+      // visitor(node, tEnter, tExit) gets the part of the segment in the node as t in [0, 1], and returns false to stop.
+      template<typename Visitor>
+      void VisitNodesAlongSegment(const Math::Vector3& start, const Math::Vector3& end, uint32_t levelIndex, Visitor visitor) const;
+      // visitor(pLeaves, leafCount) gets leafCount leaves next to each other from pLeaves, which may be in the frustum,
+      // and returns false to stop. A node inside all of the planes gives all of its leaves at once without testing them,
+      // the references of the triangles of those leaves are next to each other too.
+      // The planes which contain a whole node are not tested again for its children. Returns the count of the nodes tested.
+      template<typename Visitor>
+      uint32_t VisitLeavesInFrustum(const Math::PackedFrustum& i_frustum, Visitor visitor) const;
+      // The same for the leaves overlapping the box, a node inside the box gives all of its leaves at once.
+      template<typename Visitor>
+      uint32_t VisitLeavesInAABB(const Math::PackedAABB& i_aabb, Visitor visitor) const;
+      // The leaves with triangles which may be in the frustum, or overlap the box, in the order of the visitors.
+      void GetLeavesInFrustum(const Math::PackedFrustum& i_frustum, std::vector<OctreeNode*>& o_leaves);
+      void GetLeavesInAABB(const Math::PackedAABB& i_aabb, std::vector<OctreeNode*>& o_leaves);
       inline Mesh::AOSMeshData* GetCollisionMesh() { return _pMeshData; }
       bool IsLeaf(OctreeNode* pNode);
 			bool IsInLevel(OctreeNode* pNode, uint32_t levelIndex);
 
 		private:
 			OctreeNode* GetChildOfNode(OctreeNode* pNode);
+      // Walk down from the root with the planeMask of each node, nodeTest(aabb, io_planeMask) returns false to skip the node,
+      // and clears io_planeMask when the whole node is inside, then all of its leaves go to the visitor at once.
+      template<typename NodeTest, typename Visitor>
+      uint32_t VisitLeaves(uint32_t planeMask, NodeTest nodeTest, Visitor visitor) const;
+			// the index of the node in the cell (x, y, z) of the grid of levelIndex.
+			inline uint32_t GetNodeIndexInGrid(uint32_t levelIndex, uint32_t x, uint32_t y, uint32_t z) const;
 
 		private:
 			uint32_t _level;
@@ -54,8 +137,21 @@ namespace EAE_Engine
 			Math::Vector3 _min;
 			Math::Vector3 _max;
 			Mesh::AOSMeshData* _pMeshData;
+			const Mesh::TriangleIndex* _pTriangles;
+			// one of them is used, by the reference size of the file.
+			const uint16_t* _pReferences16;
+			const uint32_t* _pReferences32;
+			size_t _dataSize;
+			// the file read by InitFromFile or built by InitFromTriangles, empty after InitFromMemory.
+			std::vector<uint8_t> _data;
 		};
 
+		inline Mesh::TriangleIndex CompleteOctree::GetTriangle(const OctreeNode& i_leaf, uint32_t i) const
+		{
+			uint32_t reference = _pReferences16 ? _pReferences16[i_leaf._firstTriangle + i] : _pReferences32[i_leaf._firstTriangle + i];
+			return _pTriangles[reference];
+		}
+
 
 		inline OctreeNode* CompleteOctree::GetNodesInLevel(uint32_t levelIndex)
 		{
@@ -66,9 +162,15 @@ namespace EAE_Engine
 
 		inline void CompleteOctree::InitFromRange(uint32_t level, Math::Vector3 min, Math::Vector3 max)
 		{
+			SAFE_DELETE_ARRAY(_pNodes);
 			_level = level;
 			_countOfNode = (uint32_t)((std::pow(8.0f, _level) - 1) / (8 - 1));
 			_pNodes = new OctreeNode[_countOfNode];
+			for (uint32_t nodeIndex = 0; nodeIndex < _countOfNode; ++nodeIndex)
+			{
+				_pNodes[nodeIndex]._firstTriangle = 0;
+				_pNodes[nodeIndex]._triangleCount = 0;
+			}
 			_min = min;
 			_max = max;
 			_pNodes[0]._pos = (_min + _max) * 0.5f;
@@ -83,16 +185,11 @@ namespace EAE_Engine
 					uint32_t indexOfNode = baseOfNodesInLevel + nodeIndex;
 					Math::Vector3 centerPos = _pNodes[indexOfNode]._pos;
 					OctreeNode* pChildren = &_pNodes[indexOfNode * 8 + 1];
-					pChildren[0]._pos = centerPos + Math::Vector3(-extentInNextLevel._x, -extentInNextLevel._y, -extentInNextLevel._z);
-					pChildren[1]._pos = centerPos + Math::Vector3(-extentInNextLevel._x, -extentInNextLevel._y, +extentInNextLevel._z);
-					pChildren[2]._pos = centerPos + Math::Vector3(+extentInNextLevel._x, -extentInNextLevel._y, +extentInNextLevel._z);
-					pChildren[3]._pos = centerPos + Math::Vector3(+extentInNextLevel._x, -extentInNextLevel._y, -extentInNextLevel._z);
-					pChildren[4]._pos = centerPos + Math::Vector3(-extentInNextLevel._x, +extentInNextLevel._y, -extentInNextLevel._z);
-					pChildren[5]._pos = centerPos + Math::Vector3(-extentInNextLevel._x, +extentInNextLevel._y, +extentInNextLevel._z);
-					pChildren[6]._pos = centerPos + Math::Vector3(+extentInNextLevel._x, +extentInNextLevel._y, +extentInNextLevel._z);
-					pChildren[7]._pos = centerPos + Math::Vector3(+extentInNextLevel._x, +extentInNextLevel._y, -extentInNextLevel._z);
+					Math::Vector3 childCenters[8];
+					GetChildCenters(centerPos, extentInNextLevel, childCenters);
 					for (uint32_t childIndex = 0; childIndex < 8; ++childIndex)
 					{
+						pChildren[childIndex]._pos = childCenters[childIndex];
 						pChildren[childIndex]._extent = extentInNextLevel;
 					}
 				}
@@ -100,16 +197,180 @@ namespace EAE_Engine
 		}
 
 
+		inline uint32_t CompleteOctree::GetNodeIndexInGrid(uint32_t levelIndex, uint32_t x, uint32_t y, uint32_t z) const
+		{
+			// the order of the children in InitFromRange, by the x and z halves of the parent, the upper y half adds 4.
+			static const uint32_t s_childOfXZ[2][2] = { { 0, 1 }, { 3, 2 } };
+			uint32_t nodeIndex = 0;
+			for (uint32_t bit = levelIndex; bit-- > 0; )
+			{
+				uint32_t childIndex = (((y >> bit) & 1) << 2) + s_childOfXZ[(x >> bit) & 1][(z >> bit) & 1];
+				nodeIndex = nodeIndex * 8 + 1 + childIndex;
+			}
+			return nodeIndex;
+		}
+
+		template<typename Visitor>
+		void CompleteOctree::VisitNodesAlongSegment(const Math::Vector3& start, const Math::Vector3& end, uint32_t levelIndex, Visitor visitor) const
+		{
+			if (_pNodes == nullptr || levelIndex >= _level)
+				return;
+			const int cellCount = 1 << levelIndex;
+			const Math::Vector3 delta = end - start;
+			const Math::Vector3 cellSize = (_max - _min) * (1.0f / cellCount);
+			// clip the segment by the root.
+			float tEnter = 0.0f;
+			float tExit = 1.0f;
+			for (size_t axis = 0; axis < 3; ++axis)
+			{
+				if (delta._u[axis] == 0.0f)
+				{
+					if (start._u[axis] < _min._u[axis] || start._u[axis] > _max._u[axis])
+						return;
+					continue;
+				}
+				float t0 = (_min._u[axis] - start._u[axis]) / delta._u[axis];
+				float t1 = (_max._u[axis] - start._u[axis]) / delta._u[axis];
+				if (t0 > t1)
+					std::swap(t0, t1);
+				tEnter = t0 > tEnter ? t0 : tEnter;
+				tExit = t1 < tExit ? t1 : tExit;
+				if (tEnter > tExit)
+					return;
+			}
+			// the cell of the point entering the root, the t of the next cell boundary on each axis, and the t across a cell.
+			int cell[3];
+			int step[3];
+			float tNext[3];
+			float tDelta[3];
+			for (size_t axis = 0; axis < 3; ++axis)
+			{
+				float position = start._u[axis] + delta._u[axis] * tEnter;
+				int index = cellSize._u[axis] > 0.0f ? (int)std::floor((position - _min._u[axis]) / cellSize._u[axis]) : 0;
+				cell[axis] = index < 0 ? 0 : (index >= cellCount ? cellCount - 1 : index);
+				if (delta._u[axis] > 0.0f)
+				{
+					step[axis] = 1;
+					tNext[axis] = (_min._u[axis] + (cell[axis] + 1) * cellSize._u[axis] - start._u[axis]) / delta._u[axis];
+					tDelta[axis] = cellSize._u[axis] / delta._u[axis];
+				}
+				else if (delta._u[axis] < 0.0f)
+				{
+					step[axis] = -1;
+					tNext[axis] = (_min._u[axis] + cell[axis] * cellSize._u[axis] - start._u[axis]) / delta._u[axis];
+					tDelta[axis] = -cellSize._u[axis] / delta._u[axis];
+				}
+				else
+				{
+					step[axis] = 0;
+					tNext[axis] = FLT_MAX;
+					tDelta[axis] = FLT_MAX;
+				}
+			}
+			for (;;)
+			{
+				size_t nextAxis = tNext[0] < tNext[1] ? (tNext[0] < tNext[2] ? 0 : 2) : (tNext[1] < tNext[2] ? 1 : 2);
+				const float tCellExit = tNext[nextAxis] < tExit ? tNext[nextAxis] : tExit;
+				const uint32_t nodeIndex = GetNodeIndexInGrid(levelIndex, cell[0], cell[1], cell[2]);
+				if (!visitor(_pNodes[nodeIndex], tEnter, tCellExit) || tCellExit >= tExit)
+					return;
+				cell[nextAxis] += step[nextAxis];
+				if (cell[nextAxis] < 0 || cell[nextAxis] >= cellCount)
+					return;
+				tEnter = tCellExit;
+				tNext[nextAxis] += tDelta[nextAxis];
+			}
+		}
+
+		template<typename Visitor>
+		uint32_t CompleteOctree::VisitLeavesInFrustum(const Math::PackedFrustum& i_frustum, Visitor visitor) const
+		{
+			auto nodeTest = [&i_frustum](const Math::PackedAABB& i_bounds, uint32_t& io_planeMask)
+			{
+				return Math::TestAABBFrustum(i_bounds, i_frustum, io_planeMask);
+			};
+			return VisitLeaves(Math::PackedFrustum::s_allPlanes, nodeTest, visitor);
+		}
+
+		template<typename Visitor>
+		uint32_t CompleteOctree::VisitLeavesInAABB(const Math::PackedAABB& i_aabb, Visitor visitor) const
+		{
+			// The only "plane" is the box itself.
+			auto nodeTest = [&i_aabb](const Math::PackedAABB& i_bounds, uint32_t& io_planeMask)
+			{
+				if (!Math::TestAABBAABB(i_bounds, i_aabb))
+					return false;
+				if (Math::ContainsAABB(i_aabb, i_bounds))
+					io_planeMask = 0;
+				return true;
+			};
+			return VisitLeaves(1, nodeTest, visitor);
+		}
+
+		template<typename NodeTest, typename Visitor>
+		uint32_t CompleteOctree::VisitLeaves(uint32_t planeMask, NodeTest nodeTest, Visitor visitor) const
+		{
+			if (_pNodes == nullptr || _level == 0)
+				return 0;
+			struct NodeMask
+			{
+				uint32_t _node;
+				uint32_t _levelIndex;
+				uint32_t _planeMask;
+			};
+			// The depth first traversal keeps at most 7 siblings of each level in the stack.
+			const size_t stackSize = 8 * 16;
+			NodeMask stack[stackSize];
+			size_t count = 0;
+			NodeMask root = { 0, 0, planeMask };
+			stack[count++] = root;
+			uint32_t testCount = 0;
+			while (count > 0)
+			{
+				NodeMask entry = stack[--count];
+				const OctreeNode& node = _pNodes[entry._node];
+				++testCount;
+				if (!nodeTest(Math::PackedAABB(node._pos - node._extent, node._pos + node._extent), entry._planeMask))
+					continue;
+				if (entry._planeMask == 0 || entry._levelIndex == _level - 1)
+				{
+					// The leaves below the node i at depth d are the 8^d nodes from i * 8^d + (8^d - 1) / 7.
+					uint32_t leafCount = 1;
+					for (uint32_t levelIndex = entry._levelIndex; levelIndex < _level - 1; ++levelIndex)
+						leafCount *= 8;
+					if (!visitor(&_pNodes[entry._node * leafCount + (leafCount - 1) / 7], leafCount))
+						return testCount;
+					continue;
+				}
+				assert(count + 8 <= stackSize);
+				// Push the children from the last one, so they are visited in their order.
+				for (uint32_t childIndex = 8; childIndex > 0; --childIndex)
+				{
+					NodeMask child = { entry._node * 8 + childIndex, entry._levelIndex + 1, entry._planeMask };
+					stack[count++] = child;
+				}
+			}
+			return testCount;
+		}
 
+		// The trees are owned by the manager and found by their names,
+		// the first CompleteOctree is the static collision mesh which GetOctree() returns.
 		class OctreeManager : public Singleton<OctreeManager>
 		{
 		public:
 			~OctreeManager();
 			void AddOctree(CompleteOctree* pCompleteOctree);
+			void AddOctree(const char* pName, CompleteOctree* pCompleteOctree);
 			CompleteOctree* GetOctree();
+			CompleteOctree* GetOctree(const char* pName);
+			void AddLooseOctree(const char* pName, LooseOctree* pLooseOctree);
+			LooseOctree* GetLooseOctree(const char* pName);
 
 		private:
 			std::vector<CompleteOctree*> _octrees;
+			std::vector<std::string> _octreeNames;
+			std::vector<LooseOctree*> _looseOctrees;
+			std::vector<std::string> _looseOctreeNames;
 		};
 
 	}
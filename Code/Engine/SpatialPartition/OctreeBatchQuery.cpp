@@ -0,0 +1,323 @@
+#include "OctreeBatchQuery.h"
+#include "Engine/CollisionDetection/CollisionDetectionFunctions.h"
+#include "Engine/CollisionDetection/ContinuousCollision.h"
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+namespace EAE_Engine
+{
+  namespace Core
+  {
+    namespace
+    {
+      const size_t s_stackSize = 8 * 16;
+
+      // Insert 2 zero bits between each of the lower 10 bits.
+      inline uint32_t SpreadBits(uint32_t x)
+      {
+        x &= 0x3ff;
+        x = (x | (x << 16)) & 0x030000ff;
+        x = (x | (x << 8)) & 0x0300f00f;
+        x = (x | (x << 4)) & 0x030c30c3;
+        x = (x | (x << 2)) & 0x09249249;
+        return x;
+      }
+
+      // A huge value instead of inf for 1 / 0, so 0 * it is still 0 when the segment starts on the face of a box.
+      inline float SafeInverse(float x)
+      {
+        return x != 0.0f ? 1.0f / x : FLT_MAX;
+      }
+
+      // Whether the segment start + t * delta is in the box during some t in [0, i_tMax], and the t it enters the box.
+      inline bool EnterBox(const Math::Vector3& i_start, const Math::Vector3& i_invDelta,
+        const Math::Vector3& i_min, const Math::Vector3& i_max, float i_tMax, float& o_tEnter)
+      {
+        float tEnter = 0.0f;
+        float tExit = i_tMax;
+        for (size_t axis = 0; axis < 3; ++axis)
+        {
+          float t1 = (i_min._u[axis] - i_start._u[axis]) * i_invDelta._u[axis];
+          float t2 = (i_max._u[axis] - i_start._u[axis]) * i_invDelta._u[axis];
+          if (t1 > t2)
+            std::swap(t1, t2);
+          tEnter = std::max(tEnter, t1);
+          tExit = std::min(tExit, t2);
+          if (tEnter > tExit)
+            return false;
+        }
+        o_tEnter = tEnter;
+        return true;
+      }
+
+      inline Math::Vector3 GetPos(const std::vector<Mesh::sVertex>& i_vertices, uint32_t index)
+      {
+        const Mesh::sVertex& vertex = i_vertices[index];
+        return Math::Vector3(vertex.x, vertex.y, vertex.z);
+      }
+
+      inline void GetTriangleBounds(const Math::Vector3& a, const Math::Vector3& b, const Math::Vector3& c,
+        const Math::Vector3& i_inflate, Math::Vector3& o_min, Math::Vector3& o_max)
+      {
+        for (size_t axis = 0; axis < 3; ++axis)
+        {
+          o_min._u[axis] = std::min(a._u[axis], std::min(b._u[axis], c._u[axis])) - i_inflate._u[axis];
+          o_max._u[axis] = std::max(a._u[axis], std::max(b._u[axis], c._u[axis])) + i_inflate._u[axis];
+        }
+      }
+    }
+
+    OctreeBatchQuery::OctreeBatchQuery(CompleteOctree* pOctree) :
+      _pOctree(pOctree), _pTriangleCache(nullptr), _firstLeaf(0)
+    {}
+
+    uint32_t OctreeBatchQuery::RayCast(const RayQuery* i_pQueries, uint32_t count, QueryHit* o_pHits)
+    {
+      return RunBatch(i_pQueries, count, o_pHits, [this](const RayQuery& i_query, QueryHit& io_hit)
+      {
+        const std::vector<Mesh::sVertex>& vertices = _pOctree->GetCollisionMesh()->_vertices;
+        const Math::Vector3 start = i_query._start;
+        const Math::Vector3 end = i_query._end;
+        if (_pTriangleCache != nullptr && _pTriangleCache->GetOctree() == _pOctree)
+        {
+          Traverse(start, end, Math::Vector3::Zero, [this, &vertices, &start, &end](const OctreeNode& i_leaf, QueryHit& io_hit)
+          {
+            uint32_t packetCount = 0;
+            const Collision::Triangle4* pPackets = _pTriangleCache->GetPackets(i_leaf, packetCount);
+            for (uint32_t packetIndex = 0; packetIndex < packetCount; ++packetIndex)
+            {
+              float t[4], u[4], v[4], w[4];
+              uint32_t hitMask = Collision::IntersectSegmentTriangle4(start, end, pPackets[packetIndex], t, u, v, w);
+              for (uint32_t lane = 0; hitMask != 0; ++lane, hitMask >>= 1)
+              {
+                if ((hitMask & 1) == 0 || (io_hit._hit && t[lane] >= io_hit._t))
+                  continue;
+                // Only the closer hits read the mesh, for the point and the normal.
+                const Mesh::TriangleIndex triangle = _pOctree->GetTriangle(i_leaf, packetIndex * 4 + lane);
+                Math::Vector3 a = GetPos(vertices, triangle._index0);
+                Math::Vector3 b = GetPos(vertices, triangle._index1);
+                Math::Vector3 c = GetPos(vertices, triangle._index2);
+                io_hit._hit = true;
+                io_hit._t = t[lane];
+                io_hit._point = a * u[lane] + b * v[lane] + c * w[lane];
+                io_hit._normal = Math::Vector3::Cross(b - a, c - a);
+                io_hit._triangle = triangle;
+              }
+            }
+          }, io_hit);
+          return;
+        }
+        Traverse(start, end, Math::Vector3::Zero, [this, &vertices, &start, &end](const OctreeNode& i_leaf, QueryHit& io_hit)
+        {
+          for (uint32_t triangleIndex = 0; triangleIndex < i_leaf._triangleCount; ++triangleIndex)
+          {
+            const Mesh::TriangleIndex triangle = _pOctree->GetTriangle(i_leaf, triangleIndex);
+            Math::Vector3 a = GetPos(vertices, triangle._index0);
+            Math::Vector3 b = GetPos(vertices, triangle._index1);
+            Math::Vector3 c = GetPos(vertices, triangle._index2);
+            float u = 0, v = 0, w = 0, t = 0;
+            if (!Collision::IntersectSegmentTriangle(start, end, a, b, c, u, v, w, t))
+              continue;
+            if (io_hit._hit && t >= io_hit._t)
+              continue;
+            io_hit._hit = true;
+            io_hit._t = t;
+            io_hit._point = a * u + b * v + c * w;
+            io_hit._normal = Math::Vector3::Cross(b - a, c - a);
+            io_hit._triangle = triangle;
+          }
+        }, io_hit);
+      });
+    }
+
+    uint32_t OctreeBatchQuery::SphereCast(const SphereCastQuery* i_pQueries, uint32_t count, QueryHit* o_pHits)
+    {
+      return RunBatch(i_pQueries, count, o_pHits, [this](const SphereCastQuery& i_query, QueryHit& io_hit)
+      {
+        const std::vector<Mesh::sVertex>& vertices = _pOctree->GetCollisionMesh()->_vertices;
+        const Math::Vector3 start = i_query._start;
+        const Math::Vector3 delta = i_query._end - i_query._start;
+        const Math::Vector3 invDelta(SafeInverse(delta._x), SafeInverse(delta._y), SafeInverse(delta._z));
+        const float radius = i_query._radius;
+        const Math::Vector3 inflate(radius + Collision::s_toiTolerance, radius + Collision::s_toiTolerance, radius + Collision::s_toiTolerance);
+        Traverse(i_query._start, i_query._end, inflate, [&](const OctreeNode& i_leaf, QueryHit& io_hit)
+        {
+          for (uint32_t triangleIndex = 0; triangleIndex < i_leaf._triangleCount; ++triangleIndex)
+          {
+            const Mesh::TriangleIndex triangle = _pOctree->GetTriangle(i_leaf, triangleIndex);
+            Math::Vector3 a = GetPos(vertices, triangle._index0);
+            Math::Vector3 b = GetPos(vertices, triangle._index1);
+            Math::Vector3 c = GetPos(vertices, triangle._index2);
+            const float tMax = io_hit._hit ? io_hit._t : 1.0f;
+            Math::Vector3 min, max;
+            float tEnter = 0.0f;
+            GetTriangleBounds(a, b, c, inflate, min, max);
+            if (!EnterBox(start, invDelta, min, max, tMax, tEnter))
+              continue;
+            // Only look for the hits before the closest one so far.
+            Collision::SphereMotion motion;
+            motion._start = start;
+            motion._velocity = delta;
+            motion._acceleration = Math::Vector3::Zero;
+            motion._radius = radius;
+            motion._duration = tMax;
+            Collision::TimeOfImpact toi;
+            bool collided = Collision::ConservativeAdvancement(motion, 1, [&a, &b, &c](uint32_t, const Math::Vector3& i_point)
+            {
+              return Collision::ClosestPtPointTriangle(i_point, a, b, c);
+            }, toi);
+            const float t = toi._t * tMax;
+            if (!collided || (io_hit._hit && t >= io_hit._t))
+              continue;
+            io_hit._hit = true;
+            io_hit._t = t;
+            io_hit._point = toi._point;
+            io_hit._normal = toi._normal;
+            io_hit._triangle = triangle;
+          }
+        }, io_hit);
+      });
+    }
+
+    uint32_t OctreeBatchQuery::BoxCast(const BoxCastQuery* i_pQueries, uint32_t count, QueryHit* o_pHits)
+    {
+      return RunBatch(i_pQueries, count, o_pHits, [this](const BoxCastQuery& i_query, QueryHit& io_hit)
+      {
+        const std::vector<Mesh::sVertex>& vertices = _pOctree->GetCollisionMesh()->_vertices;
+        const Math::Vector3 start = i_query._start;
+        const Math::Vector3 delta = i_query._end - i_query._start;
+        const Math::Vector3 invDelta(SafeInverse(delta._x), SafeInverse(delta._y), SafeInverse(delta._z));
+        const Math::Vector3 extent = i_query._extent;
+        Traverse(i_query._start, i_query._end, extent, [&](const OctreeNode& i_leaf, QueryHit& io_hit)
+        {
+          for (uint32_t triangleIndex = 0; triangleIndex < i_leaf._triangleCount; ++triangleIndex)
+          {
+            const Mesh::TriangleIndex triangle = _pOctree->GetTriangle(i_leaf, triangleIndex);
+            Math::Vector3 a = GetPos(vertices, triangle._index0);
+            Math::Vector3 b = GetPos(vertices, triangle._index1);
+            Math::Vector3 c = GetPos(vertices, triangle._index2);
+            Math::Vector3 min, max;
+            float tEnter = 0.0f;
+            GetTriangleBounds(a, b, c, extent, min, max);
+            if (!EnterBox(start, invDelta, min, max, io_hit._hit ? io_hit._t : 1.0f, tEnter))
+              continue;
+            float t = 0.0f;
+            Math::Vector3 normal;
+            if (!Collision::IntersectMovingAABBTriangle(start, extent, delta, a, b, c, t, normal))
+              continue;
+            if (io_hit._hit && t >= io_hit._t)
+              continue;
+            io_hit._hit = true;
+            io_hit._t = t;
+            io_hit._point = Collision::ClosestPtPointTriangle(start + delta * t, a, b, c);
+            io_hit._normal = normal;
+            io_hit._triangle = triangle;
+          }
+        }, io_hit);
+      });
+    }
+
+    template<typename Query, typename Cast>
+    uint32_t OctreeBatchQuery::RunBatch(const Query* i_pQueries, uint32_t count, QueryHit* o_pHits, Cast cast)
+    {
+      for (uint32_t index = 0; index < count; ++index)
+      {
+        o_pHits[index]._hit = false;
+        o_pHits[index]._t = 1.0f;
+        o_pHits[index]._point = i_pQueries[index]._end;
+        o_pHits[index]._normal = Math::Vector3::Zero;
+      }
+      if (_pOctree == nullptr || _pOctree->Level() == 0 || _pOctree->GetCollisionMesh() == nullptr)
+        return 0;
+      _firstLeaf = ((uint32_t)std::pow(8.0f, (float)(_pOctree->Level() - 1)) - 1) / (8 - 1);
+      // Sort the queries by the Morton code of their start points in the octree.
+      const Math::Vector3 min = _pOctree->GetMin();
+      const Math::Vector3 size = _pOctree->GetMax() - min;
+      _order.resize(count);
+      for (uint32_t index = 0; index < count; ++index)
+      {
+        uint32_t code = 0;
+        for (size_t axis = 0; axis < 3; ++axis)
+        {
+          float ratio = size._u[axis] > 0.0f ? (i_pQueries[index]._start._u[axis] - min._u[axis]) / size._u[axis] : 0.0f;
+          uint32_t cell = (uint32_t)(std::min(std::max(ratio, 0.0f), 1.0f) * 1023.0f);
+          code |= SpreadBits(cell) << axis;
+        }
+        _order[index] = ((uint64_t)code << 32) | index;
+      }
+      std::sort(_order.begin(), _order.end());
+      uint32_t hitCount = 0;
+      for (std::vector<uint64_t>::const_iterator it = _order.begin(); it != _order.end(); ++it)
+      {
+        const uint32_t index = (uint32_t)(*it & 0xffffffff);
+        QueryHit& hit = o_pHits[index];
+        cast(i_pQueries[index], hit);
+        if (hit._hit)
+        {
+          if (hit._normal.SqMagnitude() > 0.0f)
+            hit._normal.Normalize();
+          ++hitCount;
+        }
+      }
+      return hitCount;
+    }
+
+    template<typename LeafTest>
+    void OctreeBatchQuery::Traverse(const Math::Vector3& i_start, const Math::Vector3& i_end, const Math::Vector3& i_inflate,
+      LeafTest testLeaf, QueryHit& io_hit) const
+    {
+      const Math::Vector3 delta = i_end - i_start;
+      const Math::Vector3 invDelta(SafeInverse(delta._x), SafeInverse(delta._y), SafeInverse(delta._z));
+      OctreeNode* pNodes = _pOctree->GetNodes();
+      uint32_t stack[s_stackSize];
+      float stackEnter[s_stackSize];
+      size_t count = 0;
+      float tEnter = 0.0f;
+      if (!EnterBox(i_start, invDelta, pNodes[0].GetMin() - i_inflate, pNodes[0].GetMax() + i_inflate, 1.0f, tEnter))
+        return;
+      stack[count] = 0;
+      stackEnter[count++] = tEnter;
+      while (count > 0)
+      {
+        --count;
+        const uint32_t nodeIndex = stack[count];
+        // A closer hit has been found after this node was pushed.
+        if (io_hit._hit && stackEnter[count] > io_hit._t)
+          continue;
+        OctreeNode& node = pNodes[nodeIndex];
+        if (nodeIndex >= _firstLeaf)
+        {
+          testLeaf(node, io_hit);
+          continue;
+        }
+        // Push the children from far to near, so the nearest one is popped first.
+        const float tMax = io_hit._hit ? io_hit._t : 1.0f;
+        uint32_t children[8];
+        float enters[8];
+        size_t childCount = 0;
+        for (uint32_t childIndex = 1; childIndex <= 8; ++childIndex)
+        {
+          OctreeNode& child = pNodes[nodeIndex * 8 + childIndex];
+          if (!EnterBox(i_start, invDelta, child.GetMin() - i_inflate, child.GetMax() + i_inflate, tMax, tEnter))
+            continue;
+          size_t insert = childCount++;
+          for (; insert > 0 && enters[insert - 1] < tEnter; --insert)
+          {
+            children[insert] = children[insert - 1];
+            enters[insert] = enters[insert - 1];
+          }
+          children[insert] = nodeIndex * 8 + childIndex;
+          enters[insert] = tEnter;
+        }
+        assert(count + childCount <= s_stackSize);
+        for (size_t i = 0; i < childCount; ++i)
+        {
+          stack[count] = children[i];
+          stackEnter[count++] = enters[i];
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,90 @@
+#ifndef EAE_ENGINE_SPATIAL_PARTITION_OCTREE_BATCH_QUERY_H
+#define EAE_ENGINE_SPATIAL_PARTITION_OCTREE_BATCH_QUERY_H
+
+#include "Octree.h"
+#include "CollisionTriangleCache.h"
+#include <cstdint>
+#include <vector>
+
+/*
+ * Batched ray, sphere and box casts against the collision mesh of a CompleteOctree.
+ * The caller owns both the queries and the hits, so a query doesn't allocate.
+ * The queries of a batch run in the Morton order of their start points, so the queries close to each other
+ * visit the same nodes and triangles one after another while they are still in the cache.
+ * Each query walks down the octree with a small stack, the children are visited from near to far,
+ * and a node is skipped when the cast enters it after the closest hit found so far.
+ * The rays only hit the front faces like Physics::RayCast, the sphere and box casts hit both sides.
+ * An OctreeBatchQuery keeps its own scratch buffer, so use one for each thread.
+ */
+namespace EAE_Engine
+{
+  namespace Core
+  {
+    struct RayQuery
+    {
+      Math::Vector3 _start;
+      Math::Vector3 _end;
+    };
+
+    struct SphereCastQuery
+    {
+      Math::Vector3 _start;
+      Math::Vector3 _end;
+      float _radius;
+    };
+
+    // The box is axis aligned and doesn't rotate during the cast.
+    struct BoxCastQuery
+    {
+      Math::Vector3 _start;
+      Math::Vector3 _end;
+      Math::Vector3 _extent;
+    };
+
+    struct QueryHit
+    {
+      bool _hit;
+      // in [0, 1] from _start to _end.
+      float _t;
+      Math::Vector3 _point;
+      // normalized, it points from the triangle to the cast.
+      Math::Vector3 _normal;
+      Mesh::TriangleIndex _triangle;
+    };
+
+    class OctreeBatchQuery
+    {
+    public:
+      explicit OctreeBatchQuery(CompleteOctree* pOctree = nullptr);
+      void SetOctree(CompleteOctree* pOctree) { _pOctree = pOctree; }
+      CompleteOctree* GetOctree() const { return _pOctree; }
+      // The RayCast tests the packets of the cache instead of the triangles of the mesh when the cache is built from the octree.
+      void SetTriangleCache(const CollisionTriangleCache* pCache) { _pTriangleCache = pCache; }
+      // o_pHits[i] is the first hit of i_pQueries[i], o_pHits must have count elements.
+      // Returns the count of the queries which hit.
+      uint32_t RayCast(const RayQuery* i_pQueries, uint32_t count, QueryHit* o_pHits);
+      uint32_t SphereCast(const SphereCastQuery* i_pQueries, uint32_t count, QueryHit* o_pHits);
+      uint32_t BoxCast(const BoxCastQuery* i_pQueries, uint32_t count, QueryHit* o_pHits);
+
+    private:
+      // Clear the hits, sort the queries by the Morton code of their start points,
+      // then cast(query, io_hit) each of them in that order.
+      template<typename Query, typename Cast>
+      uint32_t RunBatch(const Query* i_pQueries, uint32_t count, QueryHit* o_pHits, Cast cast);
+      // Walk down the octree for the cast from i_start to i_end, whose nodes are inflated by i_inflate,
+      // testLeaf(leaf, io_hit) tests the triangles of the leaf and updates io_hit when it finds a closer hit.
+      template<typename LeafTest>
+      void Traverse(const Math::Vector3& i_start, const Math::Vector3& i_end, const Math::Vector3& i_inflate,
+        LeafTest testLeaf, QueryHit& io_hit) const;
+
+    private:
+      CompleteOctree* _pOctree;
+      const CollisionTriangleCache* _pTriangleCache;
+      uint32_t _firstLeaf;
+      // (Morton code << 32) | query index
+      std::vector<uint64_t> _order;
+    };
+  }
+}
+
+#endif//EAE_ENGINE_SPATIAL_PARTITION_OCTREE_BATCH_QUERY_H
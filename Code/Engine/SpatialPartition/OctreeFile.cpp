@@ -0,0 +1,206 @@
+#include "OctreeFile.h"
+#include "Engine/General/MemoryOp.h"
+#include <algorithm>
+#include <cmath>
+
+namespace EAE_Engine
+{
+  namespace Core
+  {
+    namespace
+    {
+      inline bool LessTriangle(const Mesh::TriangleIndex& i_a, const Mesh::TriangleIndex& i_b)
+      {
+        if (i_a._index0 != i_b._index0)
+          return i_a._index0 < i_b._index0;
+        if (i_a._index1 != i_b._index1)
+          return i_a._index1 < i_b._index1;
+        return i_a._index2 < i_b._index2;
+      }
+
+      // 8^10 nodes don't fit in the uint32_t counts.
+      const uint32_t s_maxLevel = 10;
+
+      inline uint32_t GetLeafCount(uint32_t level)
+      {
+        return level == 0 ? 0 : (uint32_t)std::pow(8.0f, (float)(level - 1));
+      }
+
+      inline uint32_t GetNodeCount(uint32_t level)
+      {
+        return (uint32_t)((std::pow(8.0f, (float)level) - 1) / (8 - 1));
+      }
+    }
+
+    bool IsCompactOctree(const void* pData, size_t size)
+    {
+      if (pData == nullptr || size < sizeof(CompactOctreeHeader))
+        return false;
+      uint32_t magic = 0;
+      CopyMem((const uint8_t*)pData, (uint8_t*)&magic, sizeof(uint32_t));
+      return magic == s_compactOctreeMagic;
+    }
+
+    size_t GetCompactOctreeSize(const CompactOctreeHeader& i_header)
+    {
+      if (i_header._magic != s_compactOctreeMagic || i_header._version != s_compactOctreeVersion ||
+        i_header._level == 0 || i_header._level > s_maxLevel ||
+        i_header._leafCount != GetLeafCount(i_header._level) || i_header._countOfNode != GetNodeCount(i_header._level) ||
+        (i_header._referenceSize != sizeof(uint16_t) && i_header._referenceSize != sizeof(uint32_t)))
+        return 0;
+      size_t referencesSize = (size_t)i_header._referenceCount * i_header._referenceSize;
+      referencesSize = (referencesSize + 3) & ~(size_t)3;
+      return sizeof(CompactOctreeHeader) + ((size_t)i_header._leafCount + 1) * sizeof(uint32_t) +
+        (size_t)i_header._triangleCount * sizeof(Mesh::TriangleIndex) + referencesSize;
+    }
+
+    bool IsValidCompactOctree(const void* pData, size_t size)
+    {
+      if (!IsCompactOctree(pData, size))
+        return false;
+      CompactOctreeHeader header;
+      CopyMem((const uint8_t*)pData, (uint8_t*)&header, sizeof(CompactOctreeHeader));
+      const size_t dataSize = GetCompactOctreeSize(header);
+      if (dataSize == 0 || dataSize > size)
+        return false;
+      // The references of the leaves follow each other from 0 to the count of them.
+      const uint8_t* pBuffer = (const uint8_t*)pData + sizeof(CompactOctreeHeader);
+      const uint32_t* pFirstReferences = reinterpret_cast<const uint32_t*>(pBuffer);
+      if (pFirstReferences[0] != 0 || pFirstReferences[header._leafCount] != header._referenceCount)
+        return false;
+      for (uint32_t leafIndex = 0; leafIndex < header._leafCount; ++leafIndex)
+      {
+        if (pFirstReferences[leafIndex + 1] < pFirstReferences[leafIndex])
+          return false;
+      }
+      // Each reference is a triangle of the file.
+      pBuffer += ((size_t)header._leafCount + 1) * sizeof(uint32_t) + (size_t)header._triangleCount * sizeof(Mesh::TriangleIndex);
+      for (uint32_t referenceIndex = 0; referenceIndex < header._referenceCount; ++referenceIndex)
+      {
+        uint32_t reference = header._referenceSize == sizeof(uint16_t) ?
+          reinterpret_cast<const uint16_t*>(pBuffer)[referenceIndex] : reinterpret_cast<const uint32_t*>(pBuffer)[referenceIndex];
+        if (reference >= header._triangleCount)
+          return false;
+      }
+      return true;
+    }
+
+    void WriteCompactOctree(uint32_t level, const Math::Vector3& i_min, const Math::Vector3& i_max,
+      const std::vector<std::vector<Mesh::TriangleIndex> >& i_leafTriangles, std::vector<uint8_t>& o_data)
+    {
+      // each triangle once, sorted so that the references are found by a binary search.
+      std::vector<Mesh::TriangleIndex> triangles;
+      for (std::vector<std::vector<Mesh::TriangleIndex> >::const_iterator it = i_leafTriangles.begin(); it != i_leafTriangles.end(); ++it)
+        triangles.insert(triangles.end(), it->begin(), it->end());
+      std::sort(triangles.begin(), triangles.end(), LessTriangle);
+      triangles.erase(std::unique(triangles.begin(), triangles.end(), [](const Mesh::TriangleIndex& i_a, const Mesh::TriangleIndex& i_b)
+      {
+        return !LessTriangle(i_a, i_b) && !LessTriangle(i_b, i_a);
+      }), triangles.end());
+
+      CompactOctreeHeader header;
+      header._magic = s_compactOctreeMagic;
+      header._version = s_compactOctreeVersion;
+      header._level = level;
+      header._countOfNode = GetNodeCount(level);
+      header._min = i_min;
+      header._max = i_max;
+      header._leafCount = GetLeafCount(level);
+      header._triangleCount = (uint32_t)triangles.size();
+      header._referenceCount = 0;
+      for (uint32_t leafIndex = 0; leafIndex < header._leafCount && leafIndex < i_leafTriangles.size(); ++leafIndex)
+        header._referenceCount += (uint32_t)i_leafTriangles[leafIndex].size();
+      header._referenceSize = triangles.size() <= 0x10000 ? sizeof(uint16_t) : sizeof(uint32_t);
+      o_data.assign(GetCompactOctreeSize(header), 0);
+
+      uint8_t* pData = &o_data[0];
+      size_t offset = 0;
+      CopyMem((const uint8_t*)&header, pData + offset, sizeof(CompactOctreeHeader));
+      offset += sizeof(CompactOctreeHeader);
+      uint32_t* pFirstReferences = reinterpret_cast<uint32_t*>(pData + offset);
+      offset += (header._leafCount + 1) * sizeof(uint32_t);
+      if (!triangles.empty())
+        CopyMem((const uint8_t*)&triangles[0], pData + offset, triangles.size() * sizeof(Mesh::TriangleIndex));
+      offset += triangles.size() * sizeof(Mesh::TriangleIndex);
+      uint8_t* pReferences = pData + offset;
+      uint32_t referenceIndex = 0;
+      for (uint32_t leafIndex = 0; leafIndex < header._leafCount; ++leafIndex)
+      {
+        pFirstReferences[leafIndex] = referenceIndex;
+        if (leafIndex >= i_leafTriangles.size())
+          continue;
+        const std::vector<Mesh::TriangleIndex>& leafTriangles = i_leafTriangles[leafIndex];
+        for (std::vector<Mesh::TriangleIndex>::const_iterator it = leafTriangles.begin(); it != leafTriangles.end(); ++it, ++referenceIndex)
+        {
+          uint32_t reference = (uint32_t)(std::lower_bound(triangles.begin(), triangles.end(), *it, LessTriangle) - triangles.begin());
+          if (header._referenceSize == sizeof(uint16_t))
+            reinterpret_cast<uint16_t*>(pReferences)[referenceIndex] = (uint16_t)reference;
+          else
+            reinterpret_cast<uint32_t*>(pReferences)[referenceIndex] = reference;
+        }
+      }
+      pFirstReferences[header._leafCount] = referenceIndex;
+    }
+
+    bool ReadLegacyOctree(const void* pData, size_t size, uint32_t& o_level, Math::Vector3& o_min, Math::Vector3& o_max,
+      std::vector<std::vector<Mesh::TriangleIndex> >& o_leafTriangles)
+    {
+      const uint8_t* pBuffer = (const uint8_t*)pData;
+      size_t offset = 0;
+      uint32_t countOfNode = 0;
+      const size_t headerSize = sizeof(uint32_t) * 2 + sizeof(Math::Vector3) * 2;
+      if (pData == nullptr || size < headerSize)
+        return false;
+      CopyMem(pBuffer + offset, (uint8_t*)&o_level, sizeof(uint32_t));
+      offset += sizeof(uint32_t);
+      CopyMem(pBuffer + offset, (uint8_t*)&countOfNode, sizeof(uint32_t));
+      offset += sizeof(uint32_t);
+      CopyMem(pBuffer + offset, (uint8_t*)&o_min, sizeof(Math::Vector3));
+      offset += sizeof(Math::Vector3);
+      CopyMem(pBuffer + offset, (uint8_t*)&o_max, sizeof(Math::Vector3));
+      offset += sizeof(Math::Vector3);
+      if (o_level == 0 || o_level > s_maxLevel)
+        return false;
+      const uint32_t countOfLeaves = GetLeafCount(o_level);
+      o_leafTriangles.clear();
+      o_leafTriangles.resize(countOfLeaves);
+      for (uint32_t leafIndex = 0; leafIndex < countOfLeaves; ++leafIndex)
+      {
+        uint32_t triangleCountInLeaf = 0;
+        if (offset + sizeof(uint32_t) > size)
+          return false;
+        CopyMem(pBuffer + offset, (uint8_t*)&triangleCountInLeaf, sizeof(uint32_t));
+        offset += sizeof(uint32_t);
+        if (triangleCountInLeaf > (size - offset) / sizeof(Mesh::TriangleIndex))
+          return false;
+        o_leafTriangles[leafIndex].resize(triangleCountInLeaf);
+        if (triangleCountInLeaf > 0)
+          CopyMem(pBuffer + offset, (uint8_t*)&o_leafTriangles[leafIndex][0], triangleCountInLeaf * sizeof(Mesh::TriangleIndex));
+        offset += triangleCountInLeaf * sizeof(Mesh::TriangleIndex);
+      }
+      // The old exporter wrote a few more bytes than it used, they are ignored.
+      return true;
+    }
+
+    bool ConvertToCompactOctree(const void* pData, size_t size, std::vector<uint8_t>& o_data)
+    {
+      if (IsCompactOctree(pData, size))
+      {
+        if (!IsValidCompactOctree(pData, size))
+          return false;
+        CompactOctreeHeader header;
+        CopyMem((const uint8_t*)pData, (uint8_t*)&header, sizeof(CompactOctreeHeader));
+        size_t compactSize = GetCompactOctreeSize(header);
+        o_data.assign((const uint8_t*)pData, (const uint8_t*)pData + compactSize);
+        return true;
+      }
+      uint32_t level = 0;
+      Math::Vector3 min, max;
+      std::vector<std::vector<Mesh::TriangleIndex> > leafTriangles;
+      if (!ReadLegacyOctree(pData, size, level, min, max, leafTriangles))
+        return false;
+      WriteCompactOctree(level, min, max, leafTriangles, o_data);
+      return true;
+    }
+  }
+}
@@ -0,0 +1,64 @@
+#ifndef EAE_ENGINE_SPATIAL_PARTITION_OCTREE_FILE_H
+#define EAE_ENGINE_SPATIAL_PARTITION_OCTREE_FILE_H
+
+#include "Engine/Math/Vector.h"
+#include "Engine/Mesh/AOSMeshData.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * The .octree file of a CompleteOctree.
+ * The compact format is one block which is used in place after it is read or mapped, nothing is allocated for the nodes:
+ *   CompactOctreeHeader
+ *   uint32_t firstReferences[leafCount + 1]   the references of leaf i are [firstReferences[i], firstReferences[i + 1])
+ *   Mesh::TriangleIndex triangles[triangleCount]   each triangle of the leaves once
+ *   uint16_t or uint32_t references[referenceCount]   the index of a triangle in triangles, 16 bits when there are
+ *                                                      at most 65536 triangles, padded to 4 bytes
+ * So a triangle in many leaves costs 2 bytes in each of them instead of 12.
+ * The legacy format is the level, the count of the nodes, the min and the max of the root,
+ * then the count of the triangles and the triangles of each leaf, it is converted to the compact format when it is read.
+ */
+namespace EAE_Engine
+{
+  namespace Core
+  {
+    // "OCTC"
+    const uint32_t s_compactOctreeMagic = 0x4354434f;
+    const uint32_t s_compactOctreeVersion = 1;
+
+    struct CompactOctreeHeader
+    {
+      uint32_t _magic;
+      uint32_t _version;
+      uint32_t _level;
+      uint32_t _countOfNode;
+      Math::Vector3 _min;
+      Math::Vector3 _max;
+      uint32_t _leafCount;
+      uint32_t _triangleCount;
+      uint32_t _referenceCount;
+      // 2 or 4
+      uint32_t _referenceSize;
+    };
+
+    // Whether the data starts with the header of the compact format, of any version.
+    bool IsCompactOctree(const void* pData, size_t size);
+    // The size of the compact file described by the header, 0 when the header isn't valid.
+    size_t GetCompactOctreeSize(const CompactOctreeHeader& i_header);
+    // Whether the data is a whole compact file of this version whose leaves and references stay inside of it,
+    // so a truncated or corrupted file is rejected before it is used in place.
+    bool IsValidCompactOctree(const void* pData, size_t size);
+    // Write the compact file of the octree from min to max with the triangles of each leaf,
+    // i_leafTriangles has a list for each of the 8^(level - 1) leaves in the order of CompleteOctree::GetNodesInLevel.
+    void WriteCompactOctree(uint32_t level, const Math::Vector3& i_min, const Math::Vector3& i_max,
+      const std::vector<std::vector<Mesh::TriangleIndex> >& i_leafTriangles, std::vector<uint8_t>& o_data);
+    // Read the legacy file, returns false when the data is too short for the leaves it declares.
+    bool ReadLegacyOctree(const void* pData, size_t size, uint32_t& o_level, Math::Vector3& o_min, Math::Vector3& o_max,
+      std::vector<std::vector<Mesh::TriangleIndex> >& o_leafTriangles);
+    // Convert the legacy file to the compact one, a compact file is copied as it is.
+    bool ConvertToCompactOctree(const void* pData, size_t size, std::vector<uint8_t>& o_data);
+  }
+}
+
+#endif//EAE_ENGINE_SPATIAL_PARTITION_OCTREE_FILE_H
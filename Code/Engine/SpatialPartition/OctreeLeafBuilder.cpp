@@ -0,0 +1,186 @@
+#include "OctreeLeafBuilder.h"
+#include "Engine/CollisionDetection/CollisionDetectionFunctions.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+namespace EAE_Engine
+{
+  namespace Core
+  {
+    namespace
+    {
+      // The subtrees at this level are the tasks of the workers, 64 of them are enough to balance 8 to 16 threads.
+      const uint32_t s_taskLevelIndex = 2;
+      // The boxes of the inner nodes are a little larger, so the rounding of TestTriangleAABB
+      // never drops a triangle which the exact test of a leaf would keep.
+      // The margin is this much of the largest coordinate of the bounds, far above the rounding of any of the tests.
+      const float s_marginScale = 1.0f / 4096.0f;
+
+      class LeafBuilder
+      {
+      public:
+        struct Task
+        {
+          uint32_t _node;
+          uint32_t _levelIndex;
+          Math::Vector3 _center;
+          std::vector<uint32_t> _triangles;
+        };
+
+        LeafBuilder(uint32_t level, const Math::Vector3& i_min, const Math::Vector3& i_max,
+          const std::vector<Math::Vector3>& i_positions, const std::vector<Mesh::TriangleIndex>& i_triangles,
+          std::vector<std::vector<Mesh::TriangleIndex> >& o_leafTriangles) :
+          _leafLevelIndex(level - 1), _positions(i_positions), _triangles(i_triangles), _leafTriangles(o_leafTriangles), _pTasks(nullptr)
+        {
+          // The same extents as CompleteOctree::InitFromRange.
+          _extents.push_back((i_max - i_min) * 0.5f);
+          for (uint32_t levelIndex = 1; levelIndex <= _leafLevelIndex; ++levelIndex)
+            _extents.push_back(_extents[levelIndex - 1] * 0.5f);
+          float margin = 0.0f;
+          const Math::Vector3 bounds[3] = { i_min, i_max, _extents[0] };
+          for (size_t boundIndex = 0; boundIndex < 3; ++boundIndex)
+            margin = std::max(margin, std::max(std::max(std::fabs(bounds[boundIndex]._x), std::fabs(bounds[boundIndex]._y)), std::fabs(bounds[boundIndex]._z)));
+          margin *= s_marginScale;
+          _margin = Math::Vector3(margin, margin, margin);
+          // The bounds of each triangle reject most of the triangles before the full TestTriangleAABB.
+          _triangleBounds.resize(i_triangles.size() * 2);
+          for (size_t triangle = 0; triangle < i_triangles.size(); ++triangle)
+          {
+            const Math::Vector3& v0 = i_positions[i_triangles[triangle]._index0];
+            const Math::Vector3& v1 = i_positions[i_triangles[triangle]._index1];
+            const Math::Vector3& v2 = i_positions[i_triangles[triangle]._index2];
+            _triangleBounds[triangle * 2] = Math::Vector3(std::min(v0._x, std::min(v1._x, v2._x)), std::min(v0._y, std::min(v1._y, v2._y)), std::min(v0._z, std::min(v1._z, v2._z)));
+            _triangleBounds[triangle * 2 + 1] = Math::Vector3(std::max(v0._x, std::max(v1._x, v2._x)), std::max(v0._y, std::max(v1._y, v2._y)), std::max(v0._z, std::max(v1._z, v2._z)));
+          }
+          _leafStart = 0;
+          for (uint32_t levelIndex = 0; levelIndex < _leafLevelIndex; ++levelIndex)
+            _leafStart = _leafStart * 8 + 1;
+        }
+
+        // Visit the subtree of the node with the triangles which may overlap it,
+        // when pTasks isn't null the subtrees at s_taskLevelIndex are only collected into it.
+        void Visit(uint32_t node, uint32_t levelIndex, const Math::Vector3& i_center, const std::vector<uint32_t>& i_candidates)
+        {
+          if (_pTasks != nullptr && levelIndex == std::min(s_taskLevelIndex, _leafLevelIndex))
+          {
+            Task task = { node, levelIndex, i_center, i_candidates };
+            _pTasks->push_back(task);
+            return;
+          }
+          if (levelIndex == _leafLevelIndex)
+          {
+            // The exact test of the old exporter, the candidates are in the order of the mesh.
+            Math::AABBV1 aabb;
+            aabb._min = i_center - _extents[levelIndex];
+            aabb._max = i_center + _extents[levelIndex];
+            std::vector<Mesh::TriangleIndex>& leafTriangles = _leafTriangles[node - _leafStart];
+            for (std::vector<uint32_t>::const_iterator it = i_candidates.begin(); it != i_candidates.end(); ++it)
+            {
+              if (TestTriangle(*it, aabb))
+                leafTriangles.push_back(_triangles[*it]);
+            }
+            return;
+          }
+          const uint32_t childLevelIndex = levelIndex + 1;
+          const Math::Vector3& childExtent = _extents[childLevelIndex];
+          Math::Vector3 childCenters[8];
+          GetChildCenters(i_center, childExtent, childCenters);
+          std::vector<uint32_t> childCandidates;
+          for (uint32_t childIndex = 0; childIndex < 8; ++childIndex)
+          {
+            uint32_t child = node * 8 + 1 + childIndex;
+            // A leaf tests its candidates itself.
+            if (childLevelIndex == _leafLevelIndex)
+            {
+              Visit(child, childLevelIndex, childCenters[childIndex], i_candidates);
+              continue;
+            }
+            Math::AABBV1 aabb;
+            aabb._min = childCenters[childIndex] - childExtent - _margin;
+            aabb._max = childCenters[childIndex] + childExtent + _margin;
+            childCandidates.clear();
+            for (std::vector<uint32_t>::const_iterator it = i_candidates.begin(); it != i_candidates.end(); ++it)
+            {
+              if (TestTriangle(*it, aabb))
+                childCandidates.push_back(*it);
+            }
+            if (!childCandidates.empty())
+              Visit(child, childLevelIndex, childCenters[childIndex], childCandidates);
+          }
+        }
+
+        void SetTasks(std::vector<Task>* pTasks) { _pTasks = pTasks; }
+
+      private:
+        inline bool TestTriangle(uint32_t triangle, const Math::AABBV1& i_aabb) const
+        {
+          // The bounds are tested against the box with the margin, so they never reject a triangle which TestTriangleAABB keeps.
+          const Math::Vector3& triangleMin = _triangleBounds[triangle * 2];
+          const Math::Vector3& triangleMax = _triangleBounds[triangle * 2 + 1];
+          if (triangleMax._x < i_aabb._min._x - _margin._x || triangleMin._x > i_aabb._max._x + _margin._x ||
+            triangleMax._y < i_aabb._min._y - _margin._y || triangleMin._y > i_aabb._max._y + _margin._y ||
+            triangleMax._z < i_aabb._min._z - _margin._z || triangleMin._z > i_aabb._max._z + _margin._z)
+            return false;
+          const Mesh::TriangleIndex& indices = _triangles[triangle];
+          return Collision::TestTriangleAABB(_positions[indices._index0], _positions[indices._index1], _positions[indices._index2], i_aabb);
+        }
+
+      private:
+        uint32_t _leafLevelIndex;
+        uint32_t _leafStart;
+        std::vector<Math::Vector3> _extents;
+        Math::Vector3 _margin;
+        // The min and the max of each triangle.
+        std::vector<Math::Vector3> _triangleBounds;
+        const std::vector<Math::Vector3>& _positions;
+        const std::vector<Mesh::TriangleIndex>& _triangles;
+        std::vector<std::vector<Mesh::TriangleIndex> >& _leafTriangles;
+        std::vector<Task>* _pTasks;
+      };
+    }
+
+    void BuildLeafTriangles(uint32_t level, const Math::Vector3& i_min, const Math::Vector3& i_max,
+      const std::vector<Math::Vector3>& i_positions, const std::vector<Mesh::TriangleIndex>& i_triangles, uint32_t workerCount,
+      std::vector<std::vector<Mesh::TriangleIndex> >& o_leafTriangles)
+    {
+      o_leafTriangles.clear();
+      if (level == 0)
+        return;
+      uint32_t leafCount = 1;
+      for (uint32_t levelIndex = 0; levelIndex + 1 < level; ++levelIndex)
+        leafCount *= 8;
+      o_leafTriangles.resize(leafCount);
+      LeafBuilder builder(level, i_min, i_max, i_positions, i_triangles, o_leafTriangles);
+      std::vector<uint32_t> allTriangles(i_triangles.size());
+      for (uint32_t triangle = 0; triangle < (uint32_t)i_triangles.size(); ++triangle)
+        allTriangles[triangle] = triangle;
+      // Split the top of the tree into the tasks on this thread,
+      // each task writes a different range of the leaves, so they need no lock.
+      std::vector<LeafBuilder::Task> tasks;
+      builder.SetTasks(&tasks);
+      builder.Visit(0, 0, (i_min + i_max) * 0.5f, allTriangles);
+      builder.SetTasks(nullptr);
+      if (workerCount == 0)
+        workerCount = std::max(1u, std::thread::hardware_concurrency());
+      workerCount = std::min(workerCount, (uint32_t)tasks.size());
+      std::atomic<uint32_t> nextTask(0);
+      auto work = [&builder, &tasks, &nextTask]()
+      {
+        for (uint32_t taskIndex = nextTask++; taskIndex < (uint32_t)tasks.size(); taskIndex = nextTask++)
+        {
+          const LeafBuilder::Task& task = tasks[taskIndex];
+          builder.Visit(task._node, task._levelIndex, task._center, task._triangles);
+        }
+      };
+      std::vector<std::thread> workers;
+      for (uint32_t worker = 1; worker < workerCount; ++worker)
+        workers.push_back(std::thread(work));
+      // The calling thread is one of the workers.
+      work();
+      for (std::vector<std::thread>::iterator it = workers.begin(); it != workers.end(); ++it)
+        it->join();
+    }
+  }
+}
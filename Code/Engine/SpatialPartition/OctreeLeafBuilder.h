@@ -0,0 +1,46 @@
+#ifndef EAE_ENGINE_SPATIAL_PARTITION_OCTREE_LEAF_BUILDER_H
+#define EAE_ENGINE_SPATIAL_PARTITION_OCTREE_LEAF_BUILDER_H
+
+#include "Engine/Math/Vector.h"
+#include "Engine/Mesh/AOSMeshData.h"
+#include <cstdint>
+#include <vector>
+
+/*
+ * Find the triangles of each leaf of a CompleteOctree for the .octree file, offline in the exporters and the tools.
+ * The old way tests every triangle against every leaf, which is 8^(level - 1) tests for each triangle.
+ * Here the tree is walked from the root, and a node only tests the triangles which overlap its parent,
+ * so a triangle is only tested against the children of the nodes it overlaps.
+ * The subtrees are independent, so they are split across the worker threads.
+ * The leaves still do the same TestTriangleAABB with the same boxes as the old way,
+ * and the triangles of each leaf keep the order of the mesh, so the file is byte-identical for a given level.
+ * It only uses the Math and the Mesh headers, so it builds without the rest of the engine.
+ */
+namespace EAE_Engine
+{
+  namespace Core
+  {
+    // The centers of the 8 children in the order of the CompleteOctree, 0(-,-,-), 1(-,-,+), 2(+,-,+), 3(+,-,-),
+    // then the same 4 with +y, i_childExtent is half of the extent of the parent.
+    inline void GetChildCenters(const Math::Vector3& i_center, const Math::Vector3& i_childExtent, Math::Vector3 o_centers[8])
+    {
+      o_centers[0] = i_center + Math::Vector3(-i_childExtent._x, -i_childExtent._y, -i_childExtent._z);
+      o_centers[1] = i_center + Math::Vector3(-i_childExtent._x, -i_childExtent._y, +i_childExtent._z);
+      o_centers[2] = i_center + Math::Vector3(+i_childExtent._x, -i_childExtent._y, +i_childExtent._z);
+      o_centers[3] = i_center + Math::Vector3(+i_childExtent._x, -i_childExtent._y, -i_childExtent._z);
+      o_centers[4] = i_center + Math::Vector3(-i_childExtent._x, +i_childExtent._y, -i_childExtent._z);
+      o_centers[5] = i_center + Math::Vector3(-i_childExtent._x, +i_childExtent._y, +i_childExtent._z);
+      o_centers[6] = i_center + Math::Vector3(+i_childExtent._x, +i_childExtent._y, +i_childExtent._z);
+      o_centers[7] = i_center + Math::Vector3(+i_childExtent._x, +i_childExtent._y, -i_childExtent._z);
+    }
+
+    // Fill o_leafTriangles with the triangles of each of the 8^(level - 1) leaves of the CompleteOctree
+    // from i_min to i_max, in the order of CompleteOctree::GetNodesInLevel, ready for WriteCompactOctree.
+    // i_triangles index into i_positions. workerCount 0 uses all of the hardware threads.
+    void BuildLeafTriangles(uint32_t level, const Math::Vector3& i_min, const Math::Vector3& i_max,
+      const std::vector<Math::Vector3>& i_positions, const std::vector<Mesh::TriangleIndex>& i_triangles, uint32_t workerCount,
+      std::vector<std::vector<Mesh::TriangleIndex> >& o_leafTriangles);
+  }
+}
+
+#endif//EAE_ENGINE_SPATIAL_PARTITION_OCTREE_LEAF_BUILDER_H
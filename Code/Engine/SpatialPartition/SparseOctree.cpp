@@ -0,0 +1,244 @@
+#include "SparseOctree.h"
+#include "Engine/CollisionDetection/CollisionDetectionFunctions.h"
+#include "General/Implements.h"
+#include <cassert>
+
+namespace EAE_Engine
+{
+  namespace Core
+  {
+    SparseOctree::SparseOctree() :
+      _level(0), _maxTrianglesPerLeaf(0), _min(Math::Vector3::Zero), _max(Math::Vector3::Zero), _pMeshData(nullptr)
+    {}
+
+    void SparseOctree::InitFromTriangles(uint32_t level, uint32_t maxTrianglesPerLeaf, const Math::Vector3& i_min, const Math::Vector3& i_max,
+      const std::vector<Math::Vector3>& i_positions, const std::vector<Mesh::TriangleIndex>& i_triangles)
+    {
+      assert(level > 0 && level <= s_maxLevel);
+      _level = level;
+      _maxTrianglesPerLeaf = maxTrianglesPerLeaf;
+      _min = i_min;
+      _max = i_max;
+      _nodes.clear();
+      _children.clear();
+      _triangles = i_triangles;
+      _references16.clear();
+      _references32.clear();
+      // The same boxes as CompleteOctree::InitFromRange.
+      _extents.assign(1, (i_max - i_min) * 0.5f);
+      for (uint32_t levelIndex = 1; levelIndex < level; ++levelIndex)
+        _extents.push_back(_extents[levelIndex - 1] * 0.5f);
+      OctreeNode root;
+      root._pos = (i_min + i_max) * 0.5f;
+      root._extent = _extents[0];
+      root._firstTriangle = 0;
+      root._triangleCount = 0;
+      _nodes.push_back(root);
+      _children.push_back(0);
+      std::vector<uint32_t> allTriangles(i_triangles.size());
+      for (uint32_t triangle = 0; triangle < (uint32_t)i_triangles.size(); ++triangle)
+        allTriangles[triangle] = triangle;
+      Split(0, 0, allTriangles, i_positions, i_triangles);
+      // 16 bits are enough for most of the meshes.
+      if (_triangles.size() <= 0x10000)
+      {
+        _references16.assign(_references32.begin(), _references32.end());
+        std::vector<uint32_t>().swap(_references32);
+      }
+    }
+
+    void SparseOctree::InitFromMesh(Mesh::AOSMeshData* pMeshData, uint32_t level, uint32_t maxTrianglesPerLeaf)
+    {
+      _pMeshData = pMeshData;
+      std::vector<Math::Vector3> positions;
+      positions.reserve(pMeshData->_vertices.size());
+      Math::Vector3 min(FLT_MAX, FLT_MAX, FLT_MAX);
+      Math::Vector3 max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+      for (std::vector<Mesh::sVertex>::const_iterator it = pMeshData->_vertices.begin(); it != pMeshData->_vertices.end(); ++it)
+      {
+        Math::Vector3 position(it->x, it->y, it->z);
+        for (size_t axis = 0; axis < 3; ++axis)
+        {
+          min._u[axis] = std::min(min._u[axis], position._u[axis]);
+          max._u[axis] = std::max(max._u[axis], position._u[axis]);
+        }
+        positions.push_back(position);
+      }
+      std::vector<Mesh::TriangleIndex> triangles(pMeshData->_indices.size() / 3);
+      for (size_t triangleIndex = 0; triangleIndex < triangles.size(); ++triangleIndex)
+      {
+        Mesh::TriangleIndex& triangle = triangles[triangleIndex];
+        triangle._index0 = pMeshData->_indices[triangleIndex * 3 + 0];
+        // Keep the winding of the mesh file like the .octree file, LoadMeshData swaps the last 2 indices for Direct3D.
+#if defined( EAEENGINE_PLATFORM_D3D9 )
+        triangle._index1 = pMeshData->_indices[triangleIndex * 3 + 2];
+        triangle._index2 = pMeshData->_indices[triangleIndex * 3 + 1];
+#else
+        triangle._index1 = pMeshData->_indices[triangleIndex * 3 + 1];
+        triangle._index2 = pMeshData->_indices[triangleIndex * 3 + 2];
+#endif
+      }
+      InitFromTriangles(level, maxTrianglesPerLeaf, min, max, positions, triangles);
+    }
+
+    void SparseOctree::Split(uint32_t nodeIndex, uint32_t levelIndex, const std::vector<uint32_t>& i_candidates,
+      const std::vector<Math::Vector3>& i_positions, const std::vector<Mesh::TriangleIndex>& i_triangles)
+    {
+      if (i_candidates.size() <= _maxTrianglesPerLeaf || levelIndex + 1 == _level)
+      {
+        MakeLeaf(nodeIndex, i_candidates);
+        return;
+      }
+      const Math::Vector3 center = _nodes[nodeIndex]._pos;
+      const Math::Vector3& childExtent = _extents[levelIndex + 1];
+      Math::Vector3 childCenters[8];
+      GetChildCenters(center, childExtent, childCenters);
+      // The triangles of each child, only the children with triangles are kept.
+      std::vector<uint32_t> childCandidates[8];
+      uint32_t childMask = 0;
+      for (uint32_t childIndex = 0; childIndex < 8; ++childIndex)
+      {
+        Math::AABBV1 aabb;
+        aabb._min = childCenters[childIndex] - childExtent;
+        aabb._max = childCenters[childIndex] + childExtent;
+        for (std::vector<uint32_t>::const_iterator it = i_candidates.begin(); it != i_candidates.end(); ++it)
+        {
+          const Mesh::TriangleIndex& triangle = i_triangles[*it];
+          if (Collision::TestTriangleAABB(i_positions[triangle._index0], i_positions[triangle._index1], i_positions[triangle._index2], aabb))
+            childCandidates[childIndex].push_back(*it);
+        }
+        if (!childCandidates[childIndex].empty())
+          childMask |= 1u << childIndex;
+      }
+      // The rounding of the smaller boxes may drop all of the triangles, keep them in this node then.
+      if (childMask == 0)
+      {
+        MakeLeaf(nodeIndex, i_candidates);
+        return;
+      }
+      // The children are next to each other, so they are added before any of them is split.
+      const uint32_t firstChild = (uint32_t)_nodes.size();
+      assert(firstChild < (1u << 24));
+      _children[nodeIndex] = (firstChild << 8) | childMask;
+      for (uint32_t childIndex = 0; childIndex < 8; ++childIndex)
+      {
+        if ((childMask & (1u << childIndex)) == 0)
+          continue;
+        OctreeNode child;
+        child._pos = childCenters[childIndex];
+        child._extent = childExtent;
+        child._firstTriangle = 0;
+        child._triangleCount = 0;
+        _nodes.push_back(child);
+        _children.push_back(0);
+      }
+      uint32_t child = firstChild;
+      for (uint32_t childIndex = 0; childIndex < 8; ++childIndex)
+      {
+        if ((childMask & (1u << childIndex)) == 0)
+          continue;
+        std::vector<uint32_t> candidates;
+        candidates.swap(childCandidates[childIndex]);
+        Split(child++, levelIndex + 1, candidates, i_positions, i_triangles);
+      }
+    }
+
+    void SparseOctree::MakeLeaf(uint32_t nodeIndex, const std::vector<uint32_t>& i_triangles)
+    {
+      OctreeNode& leaf = _nodes[nodeIndex];
+      leaf._firstTriangle = (uint32_t)_references32.size();
+      leaf._triangleCount = (uint32_t)i_triangles.size();
+      _references32.insert(_references32.end(), i_triangles.begin(), i_triangles.end());
+    }
+
+    size_t SparseOctree::GetMemorySize() const
+    {
+      return _nodes.size() * sizeof(OctreeNode) + _children.size() * sizeof(uint32_t) + _triangles.size() * sizeof(Mesh::TriangleIndex) +
+        _references16.size() * sizeof(uint16_t) + _references32.size() * sizeof(uint32_t);
+    }
+
+    std::vector<OctreeNode*> SparseOctree::GetLeavesCollideWithSegment(Math::Vector3 start, Math::Vector3 end)
+    {
+      std::vector<OctreeNode*> leavesCollided;
+      VisitLeavesAlongSegment(start, end, [this, &leavesCollided](const OctreeNode& i_leaf, float, float)
+      {
+        leavesCollided.push_back(&_nodes[&i_leaf - &_nodes[0]]);
+        return true;
+      });
+      // sort the nodes based on the distance from the Node like CompleteOctree.
+      std::sort(leavesCollided.begin(), leavesCollided.end(),
+        [&](OctreeNode* i_pObjA, OctreeNode* i_pObjB) { return (i_pObjA->_pos - start).Magnitude() < (i_pObjB->_pos - start).Magnitude(); });
+      return leavesCollided;
+    }
+
+    void SparseOctree::GetTrianlgesCollideWithSegment(Math::Vector3 start, Math::Vector3 end, std::vector<Mesh::TriangleIndex>& o_triangles)
+    {
+      std::vector<SegmentHit> needToSort;
+      const std::vector<Mesh::sVertex>& vertices = _pMeshData->_vertices;
+      VisitLeavesAlongSegment(start, end, [&](const OctreeNode& i_leaf, float, float)
+      {
+        for (uint32_t triangleIndex = 0; triangleIndex < i_leaf._triangleCount; ++triangleIndex)
+        {
+          Mesh::TriangleIndex triangle = GetTriangle(i_leaf, triangleIndex);
+          const Mesh::sVertex& svertex0 = vertices[triangle._index0];
+          const Mesh::sVertex& svertex1 = vertices[triangle._index1];
+          const Mesh::sVertex& svertex2 = vertices[triangle._index2];
+          float u = 0, v = 0, w = 0, t = 0;
+          if (Collision::IntersectSegmentTriangle(start, end, Math::Vector3(svertex0.x, svertex0.y, svertex0.z),
+            Math::Vector3(svertex1.x, svertex1.y, svertex1.z), Math::Vector3(svertex2.x, svertex2.y, svertex2.z), u, v, w, t))
+          {
+            SegmentHit hit = { t, triangle };
+            needToSort.push_back(hit);
+          }
+        }
+        return true;
+      });
+      // sort all of the triangles by t, then get rid of the duplicated triangles like CompleteOctree.
+      std::sort(needToSort.begin(), needToSort.end(), [](const SegmentHit& i_objA, const SegmentHit& i_objB) { return i_objA._t < i_objB._t; });
+      std::vector<SegmentHit>::iterator previousTriangle = needToSort.begin();
+      for (std::vector<SegmentHit>::iterator itTrianlge = needToSort.begin(); itTrianlge != needToSort.end(); ++itTrianlge)
+      {
+        if (Implements::AlmostEqualUlps(previousTriangle->_t, itTrianlge->_t, 4) && o_triangles.size() > 0)
+        {
+          if (previousTriangle->_triangle == itTrianlge->_triangle)
+            continue;
+        }
+        previousTriangle = itTrianlge;
+        o_triangles.push_back(itTrianlge->_triangle);
+      }
+    }
+
+    uint32_t SparseOctree::GetTrianlgesCollideWithSegment(const Math::Vector3& start, const Math::Vector3& end, SegmentHit* o_pHits, uint32_t maxHits) const
+    {
+      if (_pMeshData == nullptr || maxHits == 0)
+        return 0;
+      const std::vector<Mesh::sVertex>& vertices = _pMeshData->_vertices;
+      uint32_t hitCount = 0;
+      VisitLeavesAlongSegment(start, end, [&](const OctreeNode& i_leaf, float, float tExit)
+      {
+        for (uint32_t triangleIndex = 0; triangleIndex < i_leaf._triangleCount; ++triangleIndex)
+        {
+          Mesh::TriangleIndex triangle = GetTriangle(i_leaf, triangleIndex);
+          const Mesh::sVertex& svertex0 = vertices[triangle._index0];
+          const Mesh::sVertex& svertex1 = vertices[triangle._index1];
+          const Mesh::sVertex& svertex2 = vertices[triangle._index2];
+          float u = 0, v = 0, w = 0, t = 0;
+          if (!Collision::IntersectSegmentTriangle(start, end, Math::Vector3(svertex0.x, svertex0.y, svertex0.z),
+            Math::Vector3(svertex1.x, svertex1.y, svertex1.z), Math::Vector3(svertex2.x, svertex2.y, svertex2.z), u, v, w, t))
+            continue;
+          InsertSegmentHit(o_pHits, hitCount, maxHits, t, triangle);
+        }
+        // The hits before tExit are confirmed, the later leaves can only have farther ones.
+        return hitCount < maxHits || o_pHits[hitCount - 1]._t > tExit;
+      });
+      return hitCount;
+    }
+
+    bool SparseOctree::IsLeaf(OctreeNode* pNode)
+    {
+      if (_nodes.empty() || pNode < &_nodes[0] || pNode >= &_nodes[0] + _nodes.size())
+        return false;
+      return _children[pNode - &_nodes[0]] == 0;
+    }
+  }
+}
@@ -0,0 +1,216 @@
+#ifndef EAE_ENGINE_SPATIAL_PARTITION_SPARSE_OCTREE_H
+#define EAE_ENGINE_SPATIAL_PARTITION_SPARSE_OCTREE_H
+
+#include "Octree.h"
+#include <algorithm>
+#include <cfloat>
+#include <cstdint>
+#include <vector>
+
+/*
+ * The SparseOctree has the same nodes and queries as the CompleteOctree for the static collision mesh,
+ * but a node is only split when it has more than maxTrianglesPerLeaf triangles, down to the leaves of the level,
+ * so the empty and the simple parts of the mesh don't take any nodes below them.
+ * The boxes are the ones of the CompleteOctree, so a leaf at the last level is the same box as a leaf of the CompleteOctree.
+ * The children of a node are only the non-empty ones, they are next to each other in the nodes,
+ * so each node only keeps the index of its first child and the mask of which of the 8 children it has.
+ * The leaves reference the triangles with 16 bits when there are at most 65536 of them, like the compact file.
+ */
+namespace EAE_Engine
+{
+  namespace Core
+  {
+    class SparseOctree
+    {
+    public:
+      static const uint32_t s_maxLevel = 16;
+
+      SparseOctree();
+      // Split the box from i_min to i_max like CompleteOctree::InitFromRange, level is the most levels of the tree,
+      // i_triangles index into i_positions.
+      void InitFromTriangles(uint32_t level, uint32_t maxTrianglesPerLeaf, const Math::Vector3& i_min, const Math::Vector3& i_max,
+        const std::vector<Math::Vector3>& i_positions, const std::vector<Mesh::TriangleIndex>& i_triangles);
+      // Build the tree around all of the triangles of the mesh, and use it as the collision mesh.
+      void InitFromMesh(Mesh::AOSMeshData* pMeshData, uint32_t level, uint32_t maxTrianglesPerLeaf);
+      inline void SetCollisionMesh(Mesh::AOSMeshData* pMeshData) { _pMeshData = pMeshData; }
+      inline Mesh::AOSMeshData* GetCollisionMesh() { return _pMeshData; }
+      // The triangle i of the leaf, i < i_leaf._triangleCount.
+      inline Mesh::TriangleIndex GetTriangle(const OctreeNode& i_leaf, uint32_t i) const;
+      // the bytes of the nodes, their children and the triangles of the leaves.
+      size_t GetMemorySize() const;
+      inline uint32_t GetNodeCount() { return (uint32_t)_nodes.size(); }
+      inline OctreeNode* GetNodes() { return _nodes.empty() ? nullptr : &_nodes[0]; }
+      inline Math::Vector3 GetMin() { return _min; }
+      inline Math::Vector3 GetMax() { return _max; }
+      inline uint32_t Level() { return _level; }
+      // The leaves crossed by the segment, sorted by the distance of their centers to the start.
+      std::vector<OctreeNode*> GetLeavesCollideWithSegment(Math::Vector3 start, Math::Vector3 end);
+      void GetTrianlgesCollideWithSegment(Math::Vector3 start, Math::Vector3 end, std::vector<Mesh::TriangleIndex>& o_triangles);
+      // The closest maxHits triangles whose front faces are hit by the segment, sorted by _t, returns the count of them.
+      // Like CompleteOctree, it stops at the first leaf which ends after the farthest of the maxHits hits.
+      // Each triangle is in o_pHits once. It allocates nothing, o_pHits must have maxHits elements.
+      uint32_t GetTrianlgesCollideWithSegment(const Math::Vector3& start, const Math::Vector3& end, SegmentHit* o_pHits, uint32_t maxHits) const;
+      // Visit the leaves crossed by the segment from near to far, the children of each node are sorted by when the segment enters them.
+      // visitor(leaf, tEnter, tExit) gets the part of the segment in the leaf as t in [0, 1], and returns false to stop.
+      template<typename Visitor>
+      void VisitLeavesAlongSegment(const Math::Vector3& start, const Math::Vector3& end, Visitor visitor) const;
+      bool IsLeaf(OctreeNode* pNode);
+
+    private:
+      // The part [o_tEnter, o_tExit] of [0, 1] of the segment in the box, returns false when it misses the box.
+      static inline bool ClipSegment(const Math::Vector3& i_start, const Math::Vector3& i_invDelta,
+        const Math::Vector3& i_min, const Math::Vector3& i_max, float& o_tEnter, float& o_tExit);
+      // The index of the child in the order of GetChildCenters, by the bits (x << 2) | (y << 1) | z of the upper halves.
+      static inline uint32_t GetChildIndex(uint32_t octant);
+      // The count of the bits in the lower 8 bits.
+      static inline uint32_t CountBits(uint32_t bits);
+      void Split(uint32_t nodeIndex, uint32_t levelIndex, const std::vector<uint32_t>& i_candidates,
+        const std::vector<Math::Vector3>& i_positions, const std::vector<Mesh::TriangleIndex>& i_triangles);
+      // i_triangles index into _triangles.
+      void MakeLeaf(uint32_t nodeIndex, const std::vector<uint32_t>& i_triangles);
+
+    private:
+      uint32_t _level;
+      uint32_t _maxTrianglesPerLeaf;
+      std::vector<OctreeNode> _nodes;
+      // (the index of the first child << 8) | the mask of the children in the order of GetChildCenters, 0 for a leaf.
+      std::vector<uint32_t> _children;
+      // The extent of the nodes in each level.
+      std::vector<Math::Vector3> _extents;
+      Math::Vector3 _min;
+      Math::Vector3 _max;
+      Mesh::AOSMeshData* _pMeshData;
+      std::vector<Mesh::TriangleIndex> _triangles;
+      // one of them is used, by the count of the triangles.
+      std::vector<uint16_t> _references16;
+      std::vector<uint32_t> _references32;
+    };
+
+    inline Mesh::TriangleIndex SparseOctree::GetTriangle(const OctreeNode& i_leaf, uint32_t i) const
+    {
+      uint32_t reference = _references32.empty() ? _references16[i_leaf._firstTriangle + i] : _references32[i_leaf._firstTriangle + i];
+      return _triangles[reference];
+    }
+
+    inline bool SparseOctree::ClipSegment(const Math::Vector3& i_start, const Math::Vector3& i_invDelta,
+      const Math::Vector3& i_min, const Math::Vector3& i_max, float& o_tEnter, float& o_tExit)
+    {
+      float tEnter = 0.0f;
+      float tExit = 1.0f;
+      for (size_t axis = 0; axis < 3; ++axis)
+      {
+        float t1 = (i_min._u[axis] - i_start._u[axis]) * i_invDelta._u[axis];
+        float t2 = (i_max._u[axis] - i_start._u[axis]) * i_invDelta._u[axis];
+        if (t1 > t2)
+          std::swap(t1, t2);
+        tEnter = std::max(tEnter, t1);
+        tExit = std::min(tExit, t2);
+        if (tEnter > tExit)
+          return false;
+      }
+      o_tEnter = tEnter;
+      o_tExit = tExit;
+      return true;
+    }
+
+    inline uint32_t SparseOctree::GetChildIndex(uint32_t octant)
+    {
+      // the x and z halves of the parent, the upper y half adds 4.
+      static const uint32_t s_childOfXZ[4] = { 0, 1, 3, 2 };
+      return (octant & 2) * 2 + s_childOfXZ[((octant >> 1) & 2) | (octant & 1)];
+    }
+
+    inline uint32_t SparseOctree::CountBits(uint32_t bits)
+    {
+      bits = (bits & 0x55) + ((bits >> 1) & 0x55);
+      bits = (bits & 0x33) + ((bits >> 2) & 0x33);
+      return (bits & 0x0f) + ((bits >> 4) & 0x0f);
+    }
+
+    template<typename Visitor>
+    void SparseOctree::VisitLeavesAlongSegment(const Math::Vector3& start, const Math::Vector3& end, Visitor visitor) const
+    {
+      if (_nodes.empty())
+        return;
+      struct NodeSpan
+      {
+        uint32_t _node;
+        float _tEnter;
+        float _tExit;
+      };
+      const Math::Vector3 delta = end - start;
+      // A huge value instead of inf for 1 / 0, so 0 * it is still 0 when the segment starts on the face of a box.
+      const Math::Vector3 invDelta(delta._x != 0.0f ? 1.0f / delta._x : FLT_MAX,
+        delta._y != 0.0f ? 1.0f / delta._y : FLT_MAX, delta._z != 0.0f ? 1.0f / delta._z : FLT_MAX);
+      // At most 4 children of each level are in the stack.
+      NodeSpan stack[4 * s_maxLevel];
+      size_t count = 0;
+      NodeSpan root = { 0, 0.0f, 1.0f };
+      if (!ClipSegment(start, invDelta, _min, _max, root._tEnter, root._tExit))
+        return;
+      stack[count++] = root;
+      while (count > 0)
+      {
+        const NodeSpan span = stack[--count];
+        const uint32_t children = _children[span._node];
+        if (children == 0)
+        {
+          if (!visitor(_nodes[span._node], span._tEnter, span._tExit))
+            return;
+          continue;
+        }
+        // The segment crosses the 3 planes through the center of the node at most once each,
+        // so it goes through at most 4 of the children, it enters the first one with span and flips one bit of it at each crossing.
+        const Math::Vector3& center = _nodes[span._node]._pos;
+        uint32_t octant = 0;
+        float tCrossings[3];
+        uint32_t crossingBits[3];
+        uint32_t crossingCount = 0;
+        for (size_t axis = 0; axis < 3; ++axis)
+        {
+          const uint32_t bit = 4u >> axis;
+          if (delta._u[axis] == 0.0f)
+          {
+            octant |= start._u[axis] >= center._u[axis] ? bit : 0;
+            continue;
+          }
+          const float tCrossing = (center._u[axis] - start._u[axis]) * invDelta._u[axis];
+          // The side of the center at span._tEnter.
+          if ((tCrossing <= span._tEnter) == (delta._u[axis] > 0.0f))
+            octant |= bit;
+          if (tCrossing <= span._tEnter || tCrossing >= span._tExit)
+            continue;
+          uint32_t insert = crossingCount++;
+          for (; insert > 0 && tCrossings[insert - 1] > tCrossing; --insert)
+          {
+            tCrossings[insert] = tCrossings[insert - 1];
+            crossingBits[insert] = crossingBits[insert - 1];
+          }
+          tCrossings[insert] = tCrossing;
+          crossingBits[insert] = bit;
+        }
+        NodeSpan childSpans[4];
+        uint32_t childCount = 0;
+        float tEnter = span._tEnter;
+        for (uint32_t crossing = 0; crossing <= crossingCount; ++crossing)
+        {
+          const float tExit = crossing < crossingCount ? tCrossings[crossing] : span._tExit;
+          const uint32_t childIndex = GetChildIndex(octant);
+          if (children & (1u << childIndex))
+          {
+            NodeSpan childSpan = { (children >> 8) + CountBits(children & ((1u << childIndex) - 1)), tEnter, tExit };
+            childSpans[childCount++] = childSpan;
+          }
+          if (crossing < crossingCount)
+            octant ^= crossingBits[crossing];
+          tEnter = tExit;
+        }
+        // Push the children from far to near, so the nearest one is visited first.
+        while (childCount > 0)
+          stack[count++] = childSpans[--childCount];
+      }
+    }
+  }
+}
+
+#endif//EAE_ENGINE_SPATIAL_PARTITION_SPARSE_OCTREE_H
@@ -0,0 +1,228 @@
+#include "SpatialHashGrid.h"
+#include <algorithm>
+#include <cmath>
+
+namespace EAE_Engine
+{
+  namespace Core
+  {
+    namespace
+    {
+      // The cells far away from the origin are clamped, they share the cells on the border.
+      const float s_maxCellCoord = 1073741823.0f;
+
+      inline int32_t ToCellCoord(float value)
+      {
+        float coord = std::floor(value);
+        // NaN fails both tests and goes to 0.
+        if (!(coord > -s_maxCellCoord))
+          coord = coord < 0.0f ? -s_maxCellCoord : 0.0f;
+        if (coord > s_maxCellCoord)
+          coord = s_maxCellCoord;
+        return (int32_t)coord;
+      }
+    }
+
+    const uint32_t SpatialHashGrid::s_invalid;
+    const uint32_t SpatialHashGrid::s_largeBucket;
+
+    SpatialHashGrid::SpatialHashGrid(float cellSize, uint32_t bucketCount) :
+      _largeItems(s_invalid), _cellSize(cellSize), _invCellSize(1.0f / cellSize), _freeList(s_invalid), _itemCount(0)
+    {
+      assert(cellSize > 0.0f);
+      uint32_t powerOfTwo = 1;
+      while (powerOfTwo < bucketCount && powerOfTwo < 0x80000000)
+        powerOfTwo <<= 1;
+      _buckets.assign(powerOfTwo, s_invalid);
+    }
+
+    void SpatialHashGrid::Clear()
+    {
+      std::fill(_buckets.begin(), _buckets.end(), s_invalid);
+      _items.clear();
+      _largeItems = s_invalid;
+      _freeList = s_invalid;
+      _itemCount = 0;
+    }
+
+    uint32_t SpatialHashGrid::Insert(const Math::Vector3& i_center, float radius, void* pUserData)
+    {
+      uint32_t itemId = _freeList;
+      if (itemId != s_invalid)
+      {
+        _freeList = _items[itemId]._next;
+      }
+      else
+      {
+        itemId = (uint32_t)_items.size();
+        _items.push_back(Item());
+      }
+      Item& item = _items[itemId];
+      item._center = i_center;
+      item._radius = radius;
+      item._pUserData = pUserData;
+      GetCell(i_center, item._cell);
+      Link(itemId);
+      // Keep about one item in each bucket.
+      if (++_itemCount > _buckets.size() && _buckets.size() < 0x80000000)
+        Rehash((uint32_t)_buckets.size() * 2);
+      return itemId;
+    }
+
+    void SpatialHashGrid::Remove(uint32_t itemId)
+    {
+      assert(itemId < _items.size() && _items[itemId]._bucket != s_invalid);
+      Unlink(itemId);
+      Item& item = _items[itemId];
+      item._pUserData = nullptr;
+      item._next = _freeList;
+      _freeList = itemId;
+      --_itemCount;
+    }
+
+    bool SpatialHashGrid::Update(uint32_t itemId, const Math::Vector3& i_center, float radius)
+    {
+      assert(itemId < _items.size() && _items[itemId]._bucket != s_invalid);
+      Item& item = _items[itemId];
+      int32_t cell[3];
+      GetCell(i_center, cell);
+      bool wasLarge = item._bucket == s_largeBucket;
+      bool isLarge = radius > _cellSize * 0.5f;
+      item._center = i_center;
+      item._radius = radius;
+      if (wasLarge == isLarge && (isLarge || (cell[0] == item._cell[0] && cell[1] == item._cell[1] && cell[2] == item._cell[2])))
+      {
+        item._cell[0] = cell[0];
+        item._cell[1] = cell[1];
+        item._cell[2] = cell[2];
+        return false;
+      }
+      Unlink(itemId);
+      item._cell[0] = cell[0];
+      item._cell[1] = cell[1];
+      item._cell[2] = cell[2];
+      Link(itemId);
+      return true;
+    }
+
+    uint32_t SpatialHashGrid::QuerySphere(const Math::Vector3& i_center, float radius, uint32_t* o_itemIds, uint32_t maxCount) const
+    {
+      Math::Vector3 extents(radius, radius, radius);
+      return Query(i_center - extents, i_center + extents, [&i_center, radius](const Item& i_item)
+      {
+        float distance = radius + i_item._radius;
+        return (i_item._center - i_center).SqMagnitude() <= distance * distance;
+      }, o_itemIds, maxCount);
+    }
+
+    uint32_t SpatialHashGrid::QueryAABB(const Math::PackedAABB& i_aabb, uint32_t* o_itemIds, uint32_t maxCount) const
+    {
+      return Query(Math::StoreVector3(i_aabb.Min()), Math::StoreVector3(i_aabb.Max()), [&i_aabb](const Item& i_item)
+      {
+        return Math::TestAABBSphere(i_aabb, i_item._center, i_item._radius);
+      }, o_itemIds, maxCount);
+    }
+
+    template<typename Test>
+    uint32_t SpatialHashGrid::Query(const Math::Vector3& i_min, const Math::Vector3& i_max, Test test, uint32_t* o_itemIds, uint32_t maxCount) const
+    {
+      uint32_t count = 0;
+      for (uint32_t itemId = _largeItems; itemId != s_invalid && count < maxCount; itemId = _items[itemId]._next)
+      {
+        if (test(_items[itemId]))
+          o_itemIds[count++] = itemId;
+      }
+      // The small items are in the cell of their center, and they reach half a cell out of it.
+      Math::Vector3 halfCell(_cellSize * 0.5f, _cellSize * 0.5f, _cellSize * 0.5f);
+      int32_t minCell[3], maxCell[3];
+      GetCell(i_min - halfCell, minCell);
+      GetCell(i_max + halfCell, maxCell);
+      double cellCount = 1.0;
+      for (size_t axis = 0; axis < 3; ++axis)
+        cellCount *= (double)maxCell[axis] - (double)minCell[axis] + 1.0;
+      // A bucket lookup costs about as much as testing 4 items, so scan the items directly when that is cheaper.
+      if (cellCount * 4.0 > (double)_items.size())
+      {
+        for (uint32_t itemId = 0; itemId < (uint32_t)_items.size() && count < maxCount; ++itemId)
+        {
+          const Item& item = _items[itemId];
+          if (item._bucket != s_invalid && item._bucket != s_largeBucket && test(item))
+            o_itemIds[count++] = itemId;
+        }
+        return count;
+      }
+      int32_t cell[3];
+      for (cell[0] = minCell[0]; cell[0] <= maxCell[0]; ++cell[0])
+      {
+        for (cell[1] = minCell[1]; cell[1] <= maxCell[1]; ++cell[1])
+        {
+          for (cell[2] = minCell[2]; cell[2] <= maxCell[2]; ++cell[2])
+          {
+            for (uint32_t itemId = _buckets[GetBucket(cell)]; itemId != s_invalid; itemId = _items[itemId]._next)
+            {
+              const Item& item = _items[itemId];
+              if (item._cell[0] != cell[0] || item._cell[1] != cell[1] || item._cell[2] != cell[2] || !test(item))
+                continue;
+              if (count == maxCount)
+                return count;
+              o_itemIds[count++] = itemId;
+            }
+          }
+        }
+      }
+      return count;
+    }
+
+    void SpatialHashGrid::GetCell(const Math::Vector3& i_pos, int32_t o_cell[3]) const
+    {
+      o_cell[0] = ToCellCoord(i_pos._x * _invCellSize);
+      o_cell[1] = ToCellCoord(i_pos._y * _invCellSize);
+      o_cell[2] = ToCellCoord(i_pos._z * _invCellSize);
+    }
+
+    uint32_t SpatialHashGrid::GetBucket(const int32_t i_cell[3]) const
+    {
+      // The primes of Teschner et al.
+      uint32_t hash = ((uint32_t)i_cell[0] * 73856093u) ^ ((uint32_t)i_cell[1] * 19349663u) ^ ((uint32_t)i_cell[2] * 83492791u);
+      return hash & ((uint32_t)_buckets.size() - 1);
+    }
+
+    void SpatialHashGrid::Link(uint32_t itemId)
+    {
+      Item& item = _items[itemId];
+      item._bucket = item._radius > _cellSize * 0.5f ? s_largeBucket : GetBucket(item._cell);
+      uint32_t& head = item._bucket == s_largeBucket ? _largeItems : _buckets[item._bucket];
+      item._prev = s_invalid;
+      item._next = head;
+      if (head != s_invalid)
+        _items[head]._prev = itemId;
+      head = itemId;
+    }
+
+    void SpatialHashGrid::Unlink(uint32_t itemId)
+    {
+      Item& item = _items[itemId];
+      uint32_t& head = item._bucket == s_largeBucket ? _largeItems : _buckets[item._bucket];
+      if (item._prev != s_invalid)
+        _items[item._prev]._next = item._next;
+      else
+        head = item._next;
+      if (item._next != s_invalid)
+        _items[item._next]._prev = item._prev;
+      item._bucket = s_invalid;
+      item._prev = s_invalid;
+      item._next = s_invalid;
+    }
+
+    void SpatialHashGrid::Rehash(uint32_t bucketCount)
+    {
+      _buckets.assign(bucketCount, s_invalid);
+      for (uint32_t itemId = 0; itemId < (uint32_t)_items.size(); ++itemId)
+      {
+        Item& item = _items[itemId];
+        if (item._bucket != s_invalid && item._bucket != s_largeBucket)
+          Link(itemId);
+      }
+    }
+  }
+}
@@ -0,0 +1,95 @@
+#ifndef EAE_ENGINE_SPATIAL_PARTITION_SPATIAL_HASH_GRID_H
+#define EAE_ENGINE_SPATIAL_PARTITION_SPATIAL_HASH_GRID_H
+
+#include "Engine/Math/SIMDGeometry.h"
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+/*
+ * A uniform grid over the whole space for the "everything within radius R" queries of the gameplay code.
+ * Only the cells which have items take any memory, the cells are hashed into a table of buckets
+ * like Optimized Spatial Hashing for Collision Detection of Deformable Objects, Teschner et al. 2003.
+ * Each item is a sphere, a small item is only in the cell of its center, so a query looks half a cell further,
+ * the items larger than half of a cell are kept in one list which every query tests.
+ * Each item keeps its cell, so moving an item inside its cell doesn't touch the buckets,
+ * and the items of the other cells which share the bucket are skipped without being tested.
+ */
+namespace EAE_Engine
+{
+  namespace Core
+  {
+    class SpatialHashGrid
+    {
+    public:
+      static const uint32_t s_invalid = 0xffffffff;
+
+      explicit SpatialHashGrid(float cellSize = 8.0f, uint32_t bucketCount = 1024);
+      uint32_t Insert(const Math::Vector3& i_center, float radius, void* pUserData);
+      void Remove(uint32_t itemId);
+      // Returns true when the item has moved to another cell.
+      bool Update(uint32_t itemId, const Math::Vector3& i_center, float radius);
+      void Clear();
+
+      inline void* GetUserData(uint32_t itemId) const;
+      inline const Math::Vector3& GetCenter(uint32_t itemId) const;
+      inline uint32_t GetItemCount() const { return _itemCount; }
+      inline uint32_t GetBucketCount() const { return (uint32_t)_buckets.size(); }
+      inline float GetCellSize() const { return _cellSize; }
+
+      // Write the ids of the items overlapping the sphere into o_itemIds,
+      // returns the count of them, which is never more than maxCount.
+      uint32_t QuerySphere(const Math::Vector3& i_center, float radius, uint32_t* o_itemIds, uint32_t maxCount) const;
+      // Write the ids of the items overlapping the box into o_itemIds,
+      // returns the count of them, which is never more than maxCount.
+      uint32_t QueryAABB(const Math::PackedAABB& i_aabb, uint32_t* o_itemIds, uint32_t maxCount) const;
+
+    private:
+      struct Item
+      {
+        Math::Vector3 _center;
+        float _radius;
+        int32_t _cell[3];
+        void* _pUserData;
+        // s_invalid when the item is in the free list, s_largeBucket when the item is in the large list.
+        uint32_t _bucket;
+        uint32_t _prev;
+        // The next item in the bucket, or the next free item.
+        uint32_t _next;
+      };
+      static const uint32_t s_largeBucket = 0xfffffffe;
+
+      void GetCell(const Math::Vector3& i_pos, int32_t o_cell[3]) const;
+      uint32_t GetBucket(const int32_t i_cell[3]) const;
+      void Link(uint32_t itemId);
+      void Unlink(uint32_t itemId);
+      void Rehash(uint32_t bucketCount);
+      // test(item) returns true when the item overlaps the query which is inside of [i_min, i_max].
+      template<typename Test>
+      uint32_t Query(const Math::Vector3& i_min, const Math::Vector3& i_max, Test test, uint32_t* o_itemIds, uint32_t maxCount) const;
+
+    private:
+      std::vector<uint32_t> _buckets;
+      std::vector<Item> _items;
+      uint32_t _largeItems;
+      float _cellSize;
+      float _invCellSize;
+      uint32_t _freeList;
+      uint32_t _itemCount;
+    };
+
+    inline void* SpatialHashGrid::GetUserData(uint32_t itemId) const
+    {
+      assert(itemId < _items.size() && _items[itemId]._bucket != s_invalid);
+      return _items[itemId]._pUserData;
+    }
+
+    inline const Math::Vector3& SpatialHashGrid::GetCenter(uint32_t itemId) const
+    {
+      assert(itemId < _items.size() && _items[itemId]._bucket != s_invalid);
+      return _items[itemId]._center;
+    }
+  }
+}
+
+#endif//EAE_ENGINE_SPATIAL_PARTITION_SPATIAL_HASH_GRID_H
@@ -46,6 +46,12 @@ float EAE_Engine::Time::GetFixedTimeStep()
 	return 1.0f / physicsFrameRate;
 }
 
+void EAE_Engine::Time::SetFixedTimeStep(float i_fixedTimeStep)
+{
+	assert(i_fixedTimeStep > 0.0f);
+	physicsFrameRate = 1.0f / i_fixedTimeStep;
+}
+
 int EAE_Engine::Time::GetFixedUpdateRunTimesOnThisFrame()
 {
 	return s_fixedUpdateRunTimesOnThisFrame;
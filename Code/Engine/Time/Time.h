@@ -21,6 +21,7 @@ namespace EAE_Engine
 		//-----
 
 		float GetFixedTimeStep();
+		void SetFixedTimeStep(float i_fixedTimeStep);
 		int GetFixedUpdateRunTimesOnThisFrame();
 		float GetFixedUpdateBlendAlphaOnThisFrame();
 
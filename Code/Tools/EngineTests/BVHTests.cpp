@@ -0,0 +1,215 @@
+/*
+	The BVH of a height field against the CompleteOctree of the same mesh:
+	each segment must find the same triangles and the same first hit with both of them,
+	and the tree saved by SaveToFile must come back from InitFromFile without loading the mesh again.
+	It also prints the time of the build and of the 10k segments with each of them, and the memory of each.
+*/
+
+// Header Files
+//=============
+
+#include "EngineTests.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+#include "Engine/Mesh/AOSMeshData.h"
+#include "Engine/SpatialPartition/BVH.h"
+#include "Engine/SpatialPartition/Octree.h"
+
+// Helper Definitions
+//===================
+
+namespace
+{
+	const uint32_t s_gridSize = 64;
+	const float s_cellSize = 2.0f;
+	const uint32_t s_queryCount = 10000;
+	const float s_tolerance = 1.0e-4f;
+	const char* const s_meshKey = "BVHHeightField";
+	// InitFromFile takes the key of the mesh from the name of the file.
+	const char* const s_meshPath = "data/Meshes/BVHHeightField.aosmesh";
+	const char* const s_bvhPath = "BVHHeightField.bvh";
+
+	// The rolling hills under the segments, the triangles face +y.
+	void CreateHeightField( std::vector<EAE_Engine::Math::Vector3>& o_positions, std::vector<uint32_t>& o_indices )
+	{
+		const float half = s_gridSize * s_cellSize * 0.5f;
+		for ( uint32_t z = 0; z <= s_gridSize; ++z )
+		{
+			for ( uint32_t x = 0; x <= s_gridSize; ++x )
+			{
+				const float posX = x * s_cellSize - half;
+				const float posZ = z * s_cellSize - half;
+				o_positions.push_back( EAE_Engine::Math::Vector3( posX, 3.0f * std::sin( posX * 0.2f ) * std::cos( posZ * 0.15f ), posZ ) );
+			}
+		}
+		for ( uint32_t z = 0; z < s_gridSize; ++z )
+		{
+			for ( uint32_t x = 0; x < s_gridSize; ++x )
+			{
+				const uint32_t v00 = z * ( s_gridSize + 1 ) + x;
+				const uint32_t v10 = v00 + 1;
+				const uint32_t v01 = v00 + s_gridSize + 1;
+				const uint32_t v11 = v01 + 1;
+				const uint32_t quad[] = { v00, v01, v11, v00, v11, v10 };
+				o_indices.insert( o_indices.end(), quad, quad + 6 );
+			}
+		}
+	}
+
+	double GetMilliseconds( std::chrono::high_resolution_clock::time_point i_start )
+	{
+		return std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - i_start ).count();
+	}
+
+	bool IsLess( const EAE_Engine::Mesh::TriangleIndex& i_lhs, const EAE_Engine::Mesh::TriangleIndex& i_rhs )
+	{
+		return std::lexicographical_compare( i_lhs._indices, i_lhs._indices + 3, i_rhs._indices, i_rhs._indices + 3 );
+	}
+
+	bool IsSame( const EAE_Engine::Mesh::TriangleIndex& i_lhs, const EAE_Engine::Mesh::TriangleIndex& i_rhs )
+	{
+		return std::equal( i_lhs._indices, i_lhs._indices + 3, i_rhs._indices );
+	}
+
+	// The two lists hold the same triangles, the ones at the same distance may be in either order.
+	bool AreSameTriangles( std::vector<EAE_Engine::Mesh::TriangleIndex> i_lhs, std::vector<EAE_Engine::Mesh::TriangleIndex> i_rhs )
+	{
+		if ( i_lhs.size() != i_rhs.size() )
+			return false;
+		std::sort( i_lhs.begin(), i_lhs.end(), IsLess );
+		std::sort( i_rhs.begin(), i_rhs.end(), IsLess );
+		return std::equal( i_lhs.begin(), i_lhs.end(), i_rhs.begin(), IsSame );
+	}
+
+	bool AreSameTrees( const EAE_Engine::Core::BVH& i_lhs, const EAE_Engine::Core::BVH& i_rhs )
+	{
+		if ( i_lhs.GetNodeCount() != i_rhs.GetNodeCount() || i_lhs.GetTriangleCount() != i_rhs.GetTriangleCount() || i_lhs.GetDepth() != i_rhs.GetDepth() )
+			return false;
+		for ( uint32_t nodeIndex = 0; nodeIndex < i_lhs.GetNodeCount(); ++nodeIndex )
+		{
+			const EAE_Engine::Core::BVHNode& lhs = i_lhs.GetNodes()[nodeIndex];
+			const EAE_Engine::Core::BVHNode& rhs = i_rhs.GetNodes()[nodeIndex];
+			if ( lhs._offset != rhs._offset || lhs._count != rhs._count || ( lhs._min - rhs._min ).SqMagnitude() != 0.0f || ( lhs._max - rhs._max ).SqMagnitude() != 0.0f )
+				return false;
+		}
+		return true;
+	}
+}
+
+// Interface
+//==========
+
+int EngineTests::RunBVHTests()
+{
+	const int failureCountBefore = GetFailureCount();
+	std::vector<EAE_Engine::Math::Vector3> positions;
+	std::vector<uint32_t> indices;
+	CreateHeightField( positions, indices );
+	CreateCollisionMesh( s_meshKey, positions, indices, 5 );
+	EAE_Engine::Core::CompleteOctree* pOctree = EAE_Engine::Core::OctreeManager::GetInstance()->GetOctree( s_meshKey );
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	EAE_Engine::Core::BVH bvh;
+	bvh.Build( pOctree->GetCollisionMesh() );
+	const double buildMilliseconds = GetMilliseconds( start );
+	ENGINE_TEST_CHECK( bvh.GetTriangleCount() == indices.size() / 3 );
+	ENGINE_TEST_CHECK( bvh.GetDepth() > 0 );
+
+	// Most of the segments come down on the hills, the rest go anywhere in the box around them.
+	std::mt19937 random( 41 );
+	std::uniform_real_distribution<float> inside( -60.0f, 60.0f );
+	std::uniform_real_distribution<float> offset( -20.0f, 20.0f );
+	std::uniform_real_distribution<float> height( 10.0f, 30.0f );
+	std::vector<EAE_Engine::Math::Vector3> starts( s_queryCount );
+	std::vector<EAE_Engine::Math::Vector3> ends( s_queryCount );
+	for ( uint32_t queryIndex = 0; queryIndex < s_queryCount; ++queryIndex )
+	{
+		starts[queryIndex] = EAE_Engine::Math::Vector3( inside( random ), height( random ), inside( random ) );
+		if ( queryIndex % 4 != 0 )
+			ends[queryIndex] = EAE_Engine::Math::Vector3( starts[queryIndex]._x + offset( random ), -10.0f, starts[queryIndex]._z + offset( random ) );
+		else
+			ends[queryIndex] = EAE_Engine::Math::Vector3( inside( random ), offset( random ), inside( random ) );
+	}
+
+	// The first hits.
+	start = std::chrono::high_resolution_clock::now();
+	std::vector<EAE_Engine::Core::SegmentHit> octreeHits( s_queryCount );
+	std::vector<bool> octreeHit( s_queryCount );
+	for ( uint32_t queryIndex = 0; queryIndex < s_queryCount; ++queryIndex )
+		octreeHit[queryIndex] = pOctree->GetTrianlgesCollideWithSegment( starts[queryIndex], ends[queryIndex], &octreeHits[queryIndex], 1 ) > 0;
+	const double octreeMilliseconds = GetMilliseconds( start );
+	start = std::chrono::high_resolution_clock::now();
+	std::vector<float> bvhTs( s_queryCount );
+	std::vector<bool> bvhHit( s_queryCount );
+	for ( uint32_t queryIndex = 0; queryIndex < s_queryCount; ++queryIndex )
+	{
+		EAE_Engine::Mesh::TriangleIndex triangle;
+		EAE_Engine::Math::Vector3 normal;
+		bvhHit[queryIndex] = bvh.IntersectSegment( starts[queryIndex], ends[queryIndex], bvhTs[queryIndex], triangle, normal );
+	}
+	const double bvhMilliseconds = GetMilliseconds( start );
+	uint32_t hitCount = 0;
+	uint32_t firstHitMismatchCount = 0;
+	for ( uint32_t queryIndex = 0; queryIndex < s_queryCount; ++queryIndex )
+	{
+		hitCount += octreeHit[queryIndex] ? 1 : 0;
+		if ( bvhHit[queryIndex] != octreeHit[queryIndex] || ( bvhHit[queryIndex] && std::fabs( bvhTs[queryIndex] - octreeHits[queryIndex]._t ) > s_tolerance ) )
+			++firstHitMismatchCount;
+	}
+	ENGINE_TEST_CHECK( firstHitMismatchCount == 0 );
+	ENGINE_TEST_CHECK( hitCount > s_queryCount / 2 );
+
+	// All of the hits.
+	uint32_t allHitsMismatchCount = 0;
+	std::vector<EAE_Engine::Mesh::TriangleIndex> octreeTriangles;
+	std::vector<EAE_Engine::Mesh::TriangleIndex> bvhTriangles;
+	for ( uint32_t queryIndex = 0; queryIndex < s_queryCount; ++queryIndex )
+	{
+		octreeTriangles.clear();
+		bvhTriangles.clear();
+		pOctree->GetTrianlgesCollideWithSegment( starts[queryIndex], ends[queryIndex], octreeTriangles );
+		bvh.GetTrianlgesCollideWithSegment( starts[queryIndex], ends[queryIndex], bvhTriangles );
+		if ( !AreSameTriangles( octreeTriangles, bvhTriangles ) )
+			++allHitsMismatchCount;
+	}
+	ENGINE_TEST_CHECK( allHitsMismatchCount == 0 );
+
+	// The saved tree comes back as it was and uses the mesh which is already in the AOSMeshDataManager.
+	ENGINE_TEST_CHECK( bvh.SaveToFile( s_bvhPath ) );
+	EAE_Engine::Core::BVH loadedBVH;
+	ENGINE_TEST_CHECK( loadedBVH.InitFromFile( s_bvhPath, s_meshPath ) );
+	ENGINE_TEST_CHECK( loadedBVH.GetCollisionMesh() == EAE_Engine::Mesh::AOSMeshDataManager::GetInstance()->GetAOSMeshData( s_meshKey ) );
+	ENGINE_TEST_CHECK( AreSameTrees( bvh, loadedBVH ) );
+	uint32_t loadedMismatchCount = 0;
+	for ( uint32_t queryIndex = 0; queryIndex < s_queryCount; ++queryIndex )
+	{
+		float t;
+		EAE_Engine::Mesh::TriangleIndex triangle;
+		EAE_Engine::Math::Vector3 normal;
+		const bool hit = loadedBVH.IntersectSegment( starts[queryIndex], ends[queryIndex], t, triangle, normal );
+		if ( hit != bvhHit[queryIndex] || ( hit && t != bvhTs[queryIndex] ) )
+			++loadedMismatchCount;
+	}
+	ENGINE_TEST_CHECK( loadedMismatchCount == 0 );
+	// A tree saved for another mesh is refused.
+	EAE_Engine::Core::BVH otherBVH;
+	const uint32_t otherIndices[] = { 0, 1, 2 };
+	CreateCollisionMesh( "BVHOtherMesh", positions, std::vector<uint32_t>( otherIndices, otherIndices + 3 ), 1 );
+	ENGINE_TEST_CHECK( !otherBVH.InitFromFile( s_bvhPath, "data/Meshes/BVHOtherMesh.aosmesh" ) );
+	ENGINE_TEST_CHECK( otherBVH.GetNodeCount() == 0 );
+	std::remove( s_bvhPath );
+
+	printf( "BVH of %u triangles: %u nodes, depth %u, %u bytes, built in %.2f ms\n",
+		bvh.GetTriangleCount(), bvh.GetNodeCount(), bvh.GetDepth(), (uint32_t)bvh.GetMemorySize(), buildMilliseconds );
+	printf( "the octree of the same mesh: %u nodes, %u bytes\n", pOctree->GetNodeCount(), (uint32_t)pOctree->GetMemorySize() );
+	printf( "%u segments, %u hits: %.2f ms with the octree, %.2f ms with the BVH\n",
+		s_queryCount, hitCount, octreeMilliseconds, bvhMilliseconds );
+
+	CleanScene();
+	return GetFailureCount() - failureCountBefore;
+}
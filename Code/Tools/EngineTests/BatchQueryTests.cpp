@@ -0,0 +1,170 @@
+/*
+	The batched casts of OctreeBatchQuery against a height field:
+	each ray must find the same first hit as CompleteOctree::GetTrianlgesCollideWithSegment,
+	and the sphere and the box casts must hit no later than the ray along the same path.
+	It also prints the time of the 10k rays one by one and in a batch, with and without the triangle cache.
+*/
+
+// Header Files
+//=============
+
+#include "EngineTests.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+#include "Engine/SpatialPartition/Octree.h"
+#include "Engine/SpatialPartition/OctreeBatchQuery.h"
+
+// Helper Definitions
+//===================
+
+namespace
+{
+	const uint32_t s_gridSize = 64;
+	const float s_cellSize = 2.0f;
+	const uint32_t s_queryCount = 10000;
+	const float s_tolerance = 1.0e-4f;
+
+	// The rolling hills under the rays, the triangles face +y.
+	void CreateHeightField( std::vector<EAE_Engine::Math::Vector3>& o_positions, std::vector<uint32_t>& o_indices )
+	{
+		const float half = s_gridSize * s_cellSize * 0.5f;
+		for ( uint32_t z = 0; z <= s_gridSize; ++z )
+		{
+			for ( uint32_t x = 0; x <= s_gridSize; ++x )
+			{
+				const float posX = x * s_cellSize - half;
+				const float posZ = z * s_cellSize - half;
+				o_positions.push_back( EAE_Engine::Math::Vector3( posX, 3.0f * std::sin( posX * 0.2f ) * std::cos( posZ * 0.15f ), posZ ) );
+			}
+		}
+		for ( uint32_t z = 0; z < s_gridSize; ++z )
+		{
+			for ( uint32_t x = 0; x < s_gridSize; ++x )
+			{
+				const uint32_t v00 = z * ( s_gridSize + 1 ) + x;
+				const uint32_t v10 = v00 + 1;
+				const uint32_t v01 = v00 + s_gridSize + 1;
+				const uint32_t v11 = v01 + 1;
+				const uint32_t quad[] = { v00, v01, v11, v00, v11, v10 };
+				o_indices.insert( o_indices.end(), quad, quad + 6 );
+			}
+		}
+	}
+
+	double GetMilliseconds( std::chrono::high_resolution_clock::time_point i_start )
+	{
+		return std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - i_start ).count();
+	}
+}
+
+// Interface
+//==========
+
+int EngineTests::RunBatchQueryTests()
+{
+	const int failureCountBefore = GetFailureCount();
+	std::vector<EAE_Engine::Math::Vector3> positions;
+	std::vector<uint32_t> indices;
+	CreateHeightField( positions, indices );
+	CreateCollisionMesh( "BatchQueryHeightField", positions, indices, 5 );
+	EAE_Engine::Core::CompleteOctree* pOctree = EAE_Engine::Core::OctreeManager::GetInstance()->GetOctree( "BatchQueryHeightField" );
+
+	// Most of the rays come down on the hills, the rest go anywhere in the box around them.
+	std::mt19937 random( 37 );
+	std::uniform_real_distribution<float> inside( -60.0f, 60.0f );
+	std::uniform_real_distribution<float> offset( -20.0f, 20.0f );
+	std::uniform_real_distribution<float> height( 10.0f, 30.0f );
+	std::vector<EAE_Engine::Core::RayQuery> rays( s_queryCount );
+	for ( uint32_t queryIndex = 0; queryIndex < s_queryCount; ++queryIndex )
+	{
+		EAE_Engine::Core::RayQuery& ray = rays[queryIndex];
+		ray._start = EAE_Engine::Math::Vector3( inside( random ), height( random ), inside( random ) );
+		if ( queryIndex % 4 != 0 )
+			ray._end = EAE_Engine::Math::Vector3( ray._start._x + offset( random ), -10.0f, ray._start._z + offset( random ) );
+		else
+			ray._end = EAE_Engine::Math::Vector3( inside( random ), offset( random ), inside( random ) );
+	}
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	std::vector<EAE_Engine::Core::SegmentHit> singleHits( s_queryCount );
+	std::vector<bool> singleHit( s_queryCount );
+	for ( uint32_t queryIndex = 0; queryIndex < s_queryCount; ++queryIndex )
+		singleHit[queryIndex] = pOctree->GetTrianlgesCollideWithSegment( rays[queryIndex]._start, rays[queryIndex]._end, &singleHits[queryIndex], 1 ) > 0;
+	const double singleMilliseconds = GetMilliseconds( start );
+
+	EAE_Engine::Core::OctreeBatchQuery batchQuery( pOctree );
+	std::vector<EAE_Engine::Core::QueryHit> hits( s_queryCount );
+	start = std::chrono::high_resolution_clock::now();
+	const uint32_t hitCount = batchQuery.RayCast( &rays[0], s_queryCount, &hits[0] );
+	const double batchMilliseconds = GetMilliseconds( start );
+
+	uint32_t mismatchCount = 0;
+	for ( uint32_t queryIndex = 0; queryIndex < s_queryCount; ++queryIndex )
+	{
+		const EAE_Engine::Core::QueryHit& hit = hits[queryIndex];
+		if ( hit._hit != singleHit[queryIndex] || ( hit._hit && std::fabs( hit._t - singleHits[queryIndex]._t ) > s_tolerance ) )
+			++mismatchCount;
+	}
+	ENGINE_TEST_CHECK( mismatchCount == 0 );
+	ENGINE_TEST_CHECK( hitCount > s_queryCount / 2 );
+
+	// Physics casts the rays with the packets of the triangle cache.
+	EAE_Engine::Core::CollisionTriangleCache triangleCache;
+	triangleCache.Build( pOctree );
+	batchQuery.SetTriangleCache( &triangleCache );
+	std::vector<EAE_Engine::Core::QueryHit> cachedHits( s_queryCount );
+	start = std::chrono::high_resolution_clock::now();
+	batchQuery.RayCast( &rays[0], s_queryCount, &cachedHits[0] );
+	const double cachedMilliseconds = GetMilliseconds( start );
+	batchQuery.SetTriangleCache( nullptr );
+	uint32_t cachedMismatchCount = 0;
+	for ( uint32_t queryIndex = 0; queryIndex < s_queryCount; ++queryIndex )
+	{
+		if ( cachedHits[queryIndex]._hit != hits[queryIndex]._hit || cachedHits[queryIndex]._t != hits[queryIndex]._t )
+			++cachedMismatchCount;
+	}
+	ENGINE_TEST_CHECK( cachedMismatchCount == 0 );
+	printf( "%u rays, %u hits: %.2f ms one by one, %.2f ms in a batch, %.2f ms in a batch with the triangle cache\n",
+		s_queryCount, hitCount, singleMilliseconds, batchMilliseconds, cachedMilliseconds );
+
+	// A cast of a shape around the ray touches the hills no later than the ray.
+	std::vector<EAE_Engine::Core::SphereCastQuery> spheres( s_queryCount );
+	std::vector<EAE_Engine::Core::BoxCastQuery> boxes( s_queryCount );
+	for ( uint32_t queryIndex = 0; queryIndex < s_queryCount; ++queryIndex )
+	{
+		spheres[queryIndex]._start = boxes[queryIndex]._start = rays[queryIndex]._start;
+		spheres[queryIndex]._end = boxes[queryIndex]._end = rays[queryIndex]._end;
+		spheres[queryIndex]._radius = 0.5f;
+		boxes[queryIndex]._extent = EAE_Engine::Math::Vector3( 0.5f, 0.5f, 0.5f );
+	}
+	std::vector<EAE_Engine::Core::QueryHit> sphereHits( s_queryCount );
+	std::vector<EAE_Engine::Core::QueryHit> boxHits( s_queryCount );
+	start = std::chrono::high_resolution_clock::now();
+	const uint32_t sphereHitCount = batchQuery.SphereCast( &spheres[0], s_queryCount, &sphereHits[0] );
+	const double sphereMilliseconds = GetMilliseconds( start );
+	start = std::chrono::high_resolution_clock::now();
+	const uint32_t boxHitCount = batchQuery.BoxCast( &boxes[0], s_queryCount, &boxHits[0] );
+	const double boxMilliseconds = GetMilliseconds( start );
+	uint32_t lateSphereCount = 0;
+	uint32_t lateBoxCount = 0;
+	for ( uint32_t queryIndex = 0; queryIndex < s_queryCount; ++queryIndex )
+	{
+		if ( !hits[queryIndex]._hit )
+			continue;
+		if ( !sphereHits[queryIndex]._hit || sphereHits[queryIndex]._t > hits[queryIndex]._t + s_tolerance )
+			++lateSphereCount;
+		if ( !boxHits[queryIndex]._hit || boxHits[queryIndex]._t > hits[queryIndex]._t + s_tolerance )
+			++lateBoxCount;
+	}
+	ENGINE_TEST_CHECK( lateSphereCount == 0 );
+	ENGINE_TEST_CHECK( lateBoxCount == 0 );
+	printf( "%u sphere casts, %u hits: %.2f ms\n", s_queryCount, sphereHitCount, sphereMilliseconds );
+	printf( "%u box casts, %u hits: %.2f ms\n", s_queryCount, boxHitCount, boxMilliseconds );
+
+	CleanScene();
+	return GetFailureCount() - failureCountBefore;
+}
@@ -0,0 +1,224 @@
+/*
+	The SweepAndPrune of the ColliderManager with 2000 rotated OBBColliders moving and bouncing in a room at 60 Hz:
+	after each step the candidate pairs must be exactly the pairs whose swept AABBs overlap, found by testing all of the pairs,
+	and the narrow phase on the candidate pairs must find the same collisions as the narrow phase on all of the pairs.
+	It prints the candidate pairs, the collisions and the ms per step of the broad phase and the narrow phase,
+	and of the all pairs path which ran DetectCollision on every pair.
+*/
+
+// Header Files
+//=============
+
+#include "EngineTests.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <unordered_map>
+#include <utility>
+
+#include "Engine/CollisionDetection/ColliderBase.h"
+#include "Engine/CollisionDetection/OBBCollider.h"
+#include "Engine/CollisionDetection/RigidBody.h"
+#include "Engine/CollisionDetection/SweepAndPrune.h"
+
+// Helper Definitions
+//===================
+
+namespace
+{
+	const uint32_t s_colliderCount = 2000;
+	const uint32_t s_stepCount = 60;
+	// The all pairs path is 2 million DetectCollision calls for each step, a few steps are enough to time it.
+	const uint32_t s_allPairsStepCount = 2;
+	const float s_timeStep = 1.0f / 60.0f;
+	const float s_maxSpeed = 5.0f;
+	// The half size of the room, it is flat like a level, so the sort axis matters.
+	const EAE_Engine::Math::Vector3 s_roomExtent( 60.0f, 5.0f, 60.0f );
+
+	typedef std::pair<uint32_t, uint32_t> tIndexPair;
+
+	double GetMilliseconds( std::chrono::high_resolution_clock::time_point i_start )
+	{
+		return std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - i_start ).count();
+	}
+
+	struct sRoom
+	{
+		std::vector<EngineTests::TestTransform> transforms;
+		EAE_Engine::Physics::RigidBodyManager rigidBodyManager;
+		std::vector<EAE_Engine::Physics::RigidBody*> rigidBodies;
+		std::vector<EAE_Engine::Collider::Collider*> colliders;
+		std::unordered_map<EAE_Engine::Collider::Collider*, uint32_t> colliderIndices;
+
+		sRoom()
+		{
+			std::mt19937 generator( 31 );
+			std::uniform_real_distribution<float> unit( -1.0f, 1.0f );
+			// The RigidBodys and the OBBColliders keep the addresses of their Transforms.
+			transforms.reserve( s_colliderCount );
+			for ( uint32_t colliderIndex = 0; colliderIndex < s_colliderCount; ++colliderIndex )
+			{
+				const EAE_Engine::Math::Vector3 pos( unit( generator ) * s_roomExtent._x, unit( generator ) * s_roomExtent._y, unit( generator ) * s_roomExtent._z );
+				transforms.push_back( EngineTests::TestTransform( pos ) );
+				EngineTests::TestTransform& transform = transforms.back();
+				EAE_Engine::Math::Vector3 axis( unit( generator ), unit( generator ), unit( generator ) );
+				if ( axis.SqMagnitude() < 1.0e-4f )
+					axis = EAE_Engine::Math::Vector3( 0.0f, 1.0f, 0.0f );
+				transform.SetRotation( EAE_Engine::Math::Quaternion( unit( generator ) * 3.14159265f, axis.GetNormalize() ) );
+				EAE_Engine::Physics::RigidBody* pRigidBody = rigidBodyManager.AddRigidBody( &transform );
+				transform.AddComponent( { pRigidBody, pRigidBody->GetTypeID() } );
+				pRigidBody->SetPos( pos );
+				pRigidBody->SetVelocity( EAE_Engine::Math::Vector3( unit( generator ), unit( generator ) * 0.2f, unit( generator ) ) * s_maxSpeed );
+				const EAE_Engine::Math::Vector3 size( 0.5f + 0.5f * ( unit( generator ) + 1.0f ), 0.5f + 0.5f * ( unit( generator ) + 1.0f ), 0.5f + 0.5f * ( unit( generator ) + 1.0f ) );
+				EAE_Engine::Collider::Collider* pCollider = EAE_Engine::Collider::CreateOBBCollider( &transform, size );
+				rigidBodies.push_back( pRigidBody );
+				colliders.push_back( pCollider );
+				colliderIndices[pCollider] = colliderIndex;
+			}
+		}
+
+		~sRoom()
+		{
+			// The next suite starts without these boxes.
+			EAE_Engine::Collider::ColliderManager* pColliderManager = EAE_Engine::Collider::ColliderManager::GetInstance();
+			for ( size_t transformIndex = 0; transformIndex < transforms.size(); ++transformIndex )
+				pColliderManager->Remove( &transforms[transformIndex] );
+		}
+
+		// Move each box by its velocity, and turn it back at the walls.
+		void Move()
+		{
+			for ( uint32_t colliderIndex = 0; colliderIndex < s_colliderCount; ++colliderIndex )
+			{
+				EAE_Engine::Physics::RigidBody* pRigidBody = rigidBodies[colliderIndex];
+				EAE_Engine::Math::Vector3 velocity = pRigidBody->GetVelocity();
+				EAE_Engine::Math::Vector3 pos = transforms[colliderIndex].GetPos() + velocity * s_timeStep;
+				for ( size_t axis = 0; axis < 3; ++axis )
+				{
+					if ( std::fabs( pos._u[axis] ) > s_roomExtent._u[axis] )
+						velocity._u[axis] = pos._u[axis] > 0.0f ? -std::fabs( velocity._u[axis] ) : std::fabs( velocity._u[axis] );
+				}
+				transforms[colliderIndex].SetPos( pos );
+				pRigidBody->SetPos( pos );
+				pRigidBody->SetVelocity( velocity );
+			}
+		}
+
+		tIndexPair GetIndexPair( EAE_Engine::Collider::Collider* i_pA, EAE_Engine::Collider::Collider* i_pB ) const
+		{
+			const uint32_t a = colliderIndices.find( i_pA )->second;
+			const uint32_t b = colliderIndices.find( i_pB )->second;
+			return a < b ? tIndexPair( a, b ) : tIndexPair( b, a );
+		}
+
+		bool DetectCollision( EAE_Engine::Collider::Collider* i_pA, EAE_Engine::Collider::Collider* i_pB ) const
+		{
+			float collisionTime = 0.0f;
+			EAE_Engine::Math::Vector3 collisionAxis;
+			return i_pA->DetectCollision( i_pB, s_timeStep, collisionTime, collisionAxis ) && collisionTime <= 1.0f;
+		}
+	};
+}
+
+// Interface
+//==========
+
+int EngineTests::RunBroadPhaseTests()
+{
+	const int failureCountBefore = GetFailureCount();
+	sRoom room;
+	EAE_Engine::Collider::SweepAndPrune broadPhase;
+	for ( uint32_t colliderIndex = 0; colliderIndex < s_colliderCount; ++colliderIndex )
+		broadPhase.Add( room.colliders[colliderIndex] );
+
+	double broadPhaseMilliseconds = 0.0;
+	double narrowPhaseMilliseconds = 0.0;
+	double allPairsMilliseconds = 0.0;
+	size_t candidatePairCount = 0;
+	size_t collisionCount = 0;
+	uint32_t missedPairStepCount = 0;
+	uint32_t missedCollisionStepCount = 0;
+	std::vector<EAE_Engine::Math::PackedAABB> sweptAABBs( s_colliderCount );
+	for ( uint32_t step = 0; step < s_stepCount; ++step )
+	{
+		room.Move();
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		broadPhase.Update( s_timeStep );
+		broadPhaseMilliseconds += GetMilliseconds( start );
+		const std::vector<EAE_Engine::Collider::ColliderPair>& pairs = broadPhase.GetPairs();
+		candidatePairCount += pairs.size();
+
+		std::vector<tIndexPair> collisions;
+		start = std::chrono::high_resolution_clock::now();
+		for ( size_t pairIndex = 0; pairIndex < pairs.size(); ++pairIndex )
+		{
+			if ( room.DetectCollision( pairs[pairIndex]._pColliderA, pairs[pairIndex]._pColliderB ) )
+				collisions.push_back( room.GetIndexPair( pairs[pairIndex]._pColliderA, pairs[pairIndex]._pColliderB ) );
+		}
+		narrowPhaseMilliseconds += GetMilliseconds( start );
+		collisionCount += collisions.size();
+		std::sort( collisions.begin(), collisions.end() );
+
+		// The candidate pairs are exactly the overlapping swept AABBs, each pair once.
+		std::vector<tIndexPair> candidates;
+		for ( size_t pairIndex = 0; pairIndex < pairs.size(); ++pairIndex )
+			candidates.push_back( room.GetIndexPair( pairs[pairIndex]._pColliderA, pairs[pairIndex]._pColliderB ) );
+		std::sort( candidates.begin(), candidates.end() );
+		for ( uint32_t colliderIndex = 0; colliderIndex < s_colliderCount; ++colliderIndex )
+			sweptAABBs[colliderIndex] = room.colliders[colliderIndex]->GetSweptAABB( s_timeStep );
+		std::vector<tIndexPair> overlaps;
+		for ( uint32_t a = 0; a < s_colliderCount; ++a )
+		{
+			for ( uint32_t b = a + 1; b < s_colliderCount; ++b )
+			{
+				if ( EAE_Engine::Math::TestAABBAABB( sweptAABBs[a], sweptAABBs[b] ) )
+					overlaps.push_back( tIndexPair( a, b ) );
+			}
+		}
+		missedPairStepCount += candidates == overlaps ? 0 : 1;
+
+		// The old path ran the narrow phase on every pair.
+		if ( step < s_allPairsStepCount )
+		{
+			std::vector<tIndexPair> allPairsCollisions;
+			start = std::chrono::high_resolution_clock::now();
+			for ( uint32_t a = 0; a < s_colliderCount; ++a )
+			{
+				for ( uint32_t b = a + 1; b < s_colliderCount; ++b )
+				{
+					if ( room.DetectCollision( room.colliders[a], room.colliders[b] ) )
+						allPairsCollisions.push_back( tIndexPair( a, b ) );
+				}
+			}
+			allPairsMilliseconds += GetMilliseconds( start );
+			missedCollisionStepCount += allPairsCollisions == collisions ? 0 : 1;
+			// The cache of the separating axes now has all of the 2 million pairs, drop them.
+			EAE_Engine::Collider::OBBCollider::GetPairCache().Clear();
+		}
+	}
+	ENGINE_TEST_CHECK( missedPairStepCount == 0 );
+	ENGINE_TEST_CHECK( missedCollisionStepCount == 0 );
+	// The broad phase must prune nearly all of the 2 million pairs, but still find some collisions in the room.
+	ENGINE_TEST_CHECK( candidatePairCount / s_stepCount < s_colliderCount * 2 );
+	ENGINE_TEST_CHECK( collisionCount > 0 );
+
+	// Removing a Collider removes its pairs, and the order of the others is kept.
+	broadPhase.Remove( room.colliders[0] );
+	const std::vector<EAE_Engine::Collider::ColliderPair>& pairs = broadPhase.GetPairs();
+	uint32_t removedPairCount = 0;
+	for ( size_t pairIndex = 0; pairIndex < pairs.size(); ++pairIndex )
+		removedPairCount += pairs[pairIndex]._pColliderA == room.colliders[0] || pairs[pairIndex]._pColliderB == room.colliders[0] ? 1 : 0;
+	ENGINE_TEST_CHECK( removedPairCount == 0 );
+
+	const uint32_t allPairCount = s_colliderCount * ( s_colliderCount - 1 ) / 2;
+	printf( "%u OBBColliders, %u steps of %.1f ms, sorted on axis %u\n", s_colliderCount, s_stepCount, s_timeStep * 1000.0f, (uint32_t)broadPhase.GetSortAxis() );
+	printf( "%-12s %-16s %-12s %-12s\n", "path", "pairs per step", "collisions", "ms per step" );
+	printf( "%-12s %-16u %-12.1f %.3f (broad %.3f + narrow %.3f)\n", "sweep+prune", (uint32_t)( candidatePairCount / s_stepCount ),
+		(double)collisionCount / s_stepCount, ( broadPhaseMilliseconds + narrowPhaseMilliseconds ) / s_stepCount,
+		broadPhaseMilliseconds / s_stepCount, narrowPhaseMilliseconds / s_stepCount );
+	printf( "%-12s %-16u %-12s %.3f\n", "all pairs", allPairCount, "same", allPairsMilliseconds / s_allPairsStepCount );
+	EAE_Engine::Collider::OBBCollider::GetPairCache().Clear();
+	return GetFailureCount() - failureCountBefore;
+}
@@ -0,0 +1,331 @@
+/*
+	The functions of DeterministicMath against <cmath>:
+	the error of each one in ulps against the double std version, on the small and the large angles,
+	and the signs of the zeros of Atan2 against std::atan2.
+	A fixed scene of spinning boxes thrown at a pile of boxes and of bouncing spheres runs for 4 seconds,
+	its GetStateHash must be the same on every run and with every worker count,
+	and with EAE_ENGINE_DETERMINISTIC_MATH the same as the one recorded on another compiler.
+	It prints the ns per call of each function and the std version of it, and the hash of the scene.
+*/
+
+// Header Files
+//=============
+
+#include "EngineTests.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+#include "Engine/CollisionDetection/ColliderBase.h"
+#include "Engine/CollisionDetection/MeshCollider.h"
+#include "Engine/CollisionDetection/OBBCollider.h"
+#include "Engine/CollisionDetection/RigidBody.h"
+#include "Engine/Math/DeterministicMath.h"
+#include "Engine/Time/Time.h"
+
+// Helper Definitions
+//===================
+
+namespace
+{
+	const uint32_t s_sampleCount = 200000;
+	const uint32_t s_benchmarkInputCount = 4096;
+	const uint32_t s_benchmarkRepeatCount = 100;
+	// The results smaller than this count in its ulps,
+	// the reduction of the angle and the 1 - x of Acos have an absolute error, not a relative one.
+	const float s_ulpFloor = 1.0f / 16.0f;
+	const float s_scenarioDuration = 4.0f;
+	// The GetStateHash of the scene below, recorded with -DEAE_ENGINE_DETERMINISTIC_MATH -ffp-contract=off on GCC x64.
+	// Any change of the physics changes it, record the new one from the output of this suite then.
+	const uint32_t s_expectedStateHash = 0xd198b82fu;
+
+	struct sFunction
+	{
+		const char* name;
+		float ( *deterministic )( float );
+		double ( *reference )( double );
+		float ( *standard )( float );
+		float minInput;
+		float maxInput;
+		// The largest error in ulps of the reference, Sqrt is correctly rounded.
+		float maxUlps;
+	};
+
+	double StdSin( double i_value ) { return std::sin( i_value ); }
+	double StdCos( double i_value ) { return std::cos( i_value ); }
+	double StdTan( double i_value ) { return std::tan( i_value ); }
+	double StdAsin( double i_value ) { return std::asin( i_value ); }
+	double StdAcos( double i_value ) { return std::acos( i_value ); }
+	double StdAtan( double i_value ) { return std::atan( i_value ); }
+	double StdSqrt( double i_value ) { return std::sqrt( i_value ); }
+	float StdSinf( float i_value ) { return std::sin( i_value ); }
+	float StdCosf( float i_value ) { return std::cos( i_value ); }
+	float StdTanf( float i_value ) { return std::tan( i_value ); }
+	float StdAsinf( float i_value ) { return std::asin( i_value ); }
+	float StdAcosf( float i_value ) { return std::acos( i_value ); }
+	float StdAtanf( float i_value ) { return std::atan( i_value ); }
+	float StdSqrtf( float i_value ) { return std::sqrt( i_value ); }
+
+	const sFunction s_functions[] =
+	{
+		{ "Sin", EAE_Engine::Math::Deterministic::Sin, StdSin, StdSinf, -8192.0f, 8192.0f, 2.0f },
+		{ "Sin large", EAE_Engine::Math::Deterministic::Sin, StdSin, StdSinf, 8192.0f, 1.0e6f, 2.0f },
+		{ "Cos", EAE_Engine::Math::Deterministic::Cos, StdCos, StdCosf, -8192.0f, 8192.0f, 2.0f },
+		{ "Cos large", EAE_Engine::Math::Deterministic::Cos, StdCos, StdCosf, 8192.0f, 1.0e6f, 2.0f },
+		{ "Tan", EAE_Engine::Math::Deterministic::Tan, StdTan, StdTanf, -1.5f, 1.5f, 4.0f },
+		{ "Asin", EAE_Engine::Math::Deterministic::Asin, StdAsin, StdAsinf, -1.0f, 1.0f, 3.0f },
+		{ "Acos", EAE_Engine::Math::Deterministic::Acos, StdAcos, StdAcosf, -1.0f, 1.0f, 2.0f },
+		{ "Atan", EAE_Engine::Math::Deterministic::Atan, StdAtan, StdAtanf, -100.0f, 100.0f, 2.0f },
+		{ "Sqrt", EAE_Engine::Math::Deterministic::Sqrt, StdSqrt, StdSqrtf, 0.0f, 1.0e6f, 0.5f },
+	};
+	const size_t s_functionCount = sizeof( s_functions ) / sizeof( s_functions[0] );
+
+	// The error of i_result in ulps of i_reference, rounded to float.
+	float GetUlpError( float i_result, double i_reference )
+	{
+		const float reference = (float)i_reference;
+		const float scale = std::fabs( reference ) > s_ulpFloor ? std::fabs( reference ) : s_ulpFloor;
+		int exponent;
+		std::frexp( scale, &exponent );
+		// A float in [2^(e-1), 2^e) has its ulp at 2^(e-24).
+		return (float)( std::fabs( (double)i_result - i_reference ) / std::ldexp( 1.0, exponent - 24 ) );
+	}
+
+	double GetNanoseconds( std::chrono::high_resolution_clock::time_point i_start, uint32_t i_callCount )
+	{
+		return std::chrono::duration<double, std::nano>( std::chrono::high_resolution_clock::now() - i_start ).count() / i_callCount;
+	}
+
+	template<typename tFunction>
+	double TimeCalls( tFunction i_function, const std::vector<float>& i_inputs, volatile float& io_sink )
+	{
+		const std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		float sum = 0.0f;
+		for ( uint32_t repeat = 0; repeat < s_benchmarkRepeatCount; ++repeat )
+		{
+			for ( size_t inputIndex = 0; inputIndex < i_inputs.size(); ++inputIndex )
+				sum += i_function( i_inputs[inputIndex] );
+		}
+		io_sink = sum;
+		return GetNanoseconds( start, (uint32_t)i_inputs.size() * s_benchmarkRepeatCount );
+	}
+
+	void TestFunctions()
+	{
+		std::mt19937 generator( 29 );
+		volatile float sink = 0.0f;
+		printf( "%-10s %-10s %-14s %-10s\n", "function", "max ulps", "ns per call", "std ns per call" );
+		for ( size_t functionIndex = 0; functionIndex < s_functionCount; ++functionIndex )
+		{
+			const sFunction& function = s_functions[functionIndex];
+			std::uniform_real_distribution<float> distribution( function.minInput, function.maxInput );
+			float maxUlps = 0.0f;
+			for ( uint32_t sample = 0; sample < s_sampleCount; ++sample )
+			{
+				const float input = distribution( generator );
+				const float ulps = GetUlpError( function.deterministic( input ), function.reference( input ) );
+				maxUlps = ulps > maxUlps ? ulps : maxUlps;
+			}
+			ENGINE_TEST_CHECK( maxUlps <= function.maxUlps );
+
+			std::vector<float> inputs( s_benchmarkInputCount );
+			for ( uint32_t inputIndex = 0; inputIndex < s_benchmarkInputCount; ++inputIndex )
+				inputs[inputIndex] = distribution( generator );
+			const double nanoseconds = TimeCalls( function.deterministic, inputs, sink );
+			const double stdNanoseconds = TimeCalls( function.standard, inputs, sink );
+			printf( "%-10s %-10.2f %-14.2f %.2f\n", function.name, maxUlps, nanoseconds, stdNanoseconds );
+		}
+
+		// Atan2 on the 4 quadrants, the axes and the zeros.
+		std::uniform_real_distribution<float> distribution( -100.0f, 100.0f );
+		float maxUlps = 0.0f;
+		std::vector<float> ys( s_benchmarkInputCount );
+		std::vector<float> xs( s_benchmarkInputCount );
+		for ( uint32_t sample = 0; sample < s_sampleCount; ++sample )
+		{
+			const float y = distribution( generator );
+			const float x = distribution( generator );
+			const float ulps = GetUlpError( EAE_Engine::Math::Deterministic::Atan2( y, x ), std::atan2( (double)y, (double)x ) );
+			maxUlps = ulps > maxUlps ? ulps : maxUlps;
+			if ( sample < s_benchmarkInputCount )
+			{
+				ys[sample] = y;
+				xs[sample] = x;
+			}
+		}
+		ENGINE_TEST_CHECK( maxUlps <= 4.0f );
+		const float specials[] = { 0.0f, -0.0f, 1.0f, -1.0f, INFINITY, -INFINITY };
+		const size_t specialCount = sizeof( specials ) / sizeof( specials[0] );
+		for ( size_t yIndex = 0; yIndex < specialCount; ++yIndex )
+		{
+			for ( size_t xIndex = 0; xIndex < specialCount; ++xIndex )
+			{
+				const float y = specials[yIndex];
+				const float x = specials[xIndex];
+				// The infinities only matter for the signs, a float ratio of 2 infinities has no angle.
+				if ( std::isinf( y ) && std::isinf( x ) )
+					continue;
+				const float result = EAE_Engine::Math::Deterministic::Atan2( y, x );
+				const float expected = (float)std::atan2( (double)y, (double)x );
+				ENGINE_TEST_CHECK( std::signbit( result ) == std::signbit( expected ) );
+				ENGINE_TEST_CHECK( GetUlpError( result, std::atan2( (double)y, (double)x ) ) <= 4.0f );
+			}
+		}
+		const std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		float sum = 0.0f;
+		for ( uint32_t repeat = 0; repeat < s_benchmarkRepeatCount; ++repeat )
+		{
+			for ( uint32_t inputIndex = 0; inputIndex < s_benchmarkInputCount; ++inputIndex )
+				sum += EAE_Engine::Math::Deterministic::Atan2( ys[inputIndex], xs[inputIndex] );
+		}
+		sink = sum;
+		const double nanoseconds = GetNanoseconds( start, s_benchmarkInputCount * s_benchmarkRepeatCount );
+		const std::chrono::high_resolution_clock::time_point stdStart = std::chrono::high_resolution_clock::now();
+		sum = 0.0f;
+		for ( uint32_t repeat = 0; repeat < s_benchmarkRepeatCount; ++repeat )
+		{
+			for ( uint32_t inputIndex = 0; inputIndex < s_benchmarkInputCount; ++inputIndex )
+				sum += std::atan2( ys[inputIndex], xs[inputIndex] );
+		}
+		sink = sum;
+		printf( "%-10s %-10.2f %-14.2f %.2f\n", "Atan2", maxUlps, nanoseconds, GetNanoseconds( stdStart, s_benchmarkInputCount * s_benchmarkRepeatCount ) );
+
+		// The signs of the zeros follow the std versions.
+		ENGINE_TEST_CHECK( std::signbit( EAE_Engine::Math::Deterministic::Sin( -0.0f ) ) );
+		ENGINE_TEST_CHECK( std::signbit( EAE_Engine::Math::Deterministic::Tan( -0.0f ) ) );
+		ENGINE_TEST_CHECK( std::signbit( EAE_Engine::Math::Deterministic::Asin( -0.0f ) ) );
+		ENGINE_TEST_CHECK( std::signbit( EAE_Engine::Math::Deterministic::Atan( -0.0f ) ) );
+		ENGINE_TEST_CHECK( EAE_Engine::Math::Deterministic::Cos( -0.0f ) == 1.0f );
+		ENGINE_TEST_CHECK( std::isnan( EAE_Engine::Math::Deterministic::Asin( 1.5f ) ) );
+		ENGINE_TEST_CHECK( std::isnan( EAE_Engine::Math::Deterministic::Acos( -1.5f ) ) );
+	}
+
+	// 27 boxes in a pile, 8 spinning boxes thrown at it, and 16 spinning spheres bouncing on the ground around it.
+	struct sScenario
+	{
+		std::vector<EngineTests::TestTransform> transforms;
+		EAE_Engine::Physics::RigidBodyManager rigidBodyManager;
+
+		explicit sScenario( uint32_t i_workerCount )
+		{
+			const uint32_t pileSide = 3;
+			const uint32_t thrownBoxCount = 8;
+			const uint32_t sphereCount = 16;
+			// The RigidBodys and the OBBColliders keep the addresses of their Transforms.
+			transforms.reserve( pileSide * pileSide * pileSide + thrownBoxCount + sphereCount );
+			rigidBodyManager.SetWorkerCount( i_workerCount );
+			for ( uint32_t boxIndex = 0; boxIndex < pileSide * pileSide * pileSide; ++boxIndex )
+			{
+				const uint32_t x = boxIndex % pileSide;
+				const uint32_t y = boxIndex / ( pileSide * pileSide );
+				const uint32_t z = ( boxIndex / pileSide ) % pileSide;
+				AddBox( EAE_Engine::Math::Vector3( x * 1.05f, y * 1.05f + 0.501f, z * 1.05f ), EAE_Engine::Math::Vector3::Zero, EAE_Engine::Math::Vector3::Zero );
+			}
+			for ( uint32_t boxIndex = 0; boxIndex < thrownBoxCount; ++boxIndex )
+			{
+				const float offset = (float)boxIndex;
+				AddBox( EAE_Engine::Math::Vector3( -8.0f - offset, 2.0f + offset * 0.25f, 1.0f ),
+					EAE_Engine::Math::Vector3( 6.0f + offset * 0.5f, 1.5f, 0.1f * offset - 0.35f ),
+					EAE_Engine::Math::Vector3( 1.0f + offset, 2.0f, 0.5f * offset - 2.0f ) );
+			}
+			for ( uint32_t sphereIndex = 0; sphereIndex < sphereCount; ++sphereIndex )
+			{
+				const float angle = sphereIndex * 0.4f;
+				transforms.push_back( EngineTests::TestTransform( EAE_Engine::Math::Vector3( 10.0f + sphereIndex * 1.5f, 3.0f + ( sphereIndex % 4 ), 10.0f ) ) );
+				EngineTests::TestTransform& transform = transforms.back();
+				EAE_Engine::Physics::RigidBody* pRigidBody = rigidBodyManager.AddRigidBody( &transform );
+				transform.AddComponent( { pRigidBody, pRigidBody->GetTypeID() } );
+				pRigidBody->SetPos( transform.GetPos() );
+				pRigidBody->SetVelocity( EAE_Engine::Math::Vector3( EAE_Engine::Math::Deterministic::Cos( angle ), 2.0f, EAE_Engine::Math::Deterministic::Sin( angle ) ) );
+				pRigidBody->SetAngularVelocity( EAE_Engine::Math::Vector3( angle, 1.0f, -angle ) );
+				pRigidBody->SetRadius( 0.5f );
+				pRigidBody->SetRestitution( 0.5f );
+				pRigidBody->SetCollisionDetectionMode( EAE_Engine::Common::CollisionDetectionMode::Continuous );
+			}
+		}
+
+		~sScenario()
+		{
+			// The next scene starts without these boxes.
+			EAE_Engine::Collider::ColliderManager* pColliderManager = EAE_Engine::Collider::ColliderManager::GetInstance();
+			for ( size_t transformIndex = 0; transformIndex < transforms.size(); ++transformIndex )
+				pColliderManager->Remove( &transforms[transformIndex] );
+		}
+
+		void AddBox( const EAE_Engine::Math::Vector3& i_pos, const EAE_Engine::Math::Vector3& i_velocity, const EAE_Engine::Math::Vector3& i_angularVelocity )
+		{
+			transforms.push_back( EngineTests::TestTransform( i_pos ) );
+			EngineTests::TestTransform& transform = transforms.back();
+			EAE_Engine::Physics::RigidBody* pRigidBody = rigidBodyManager.AddRigidBody( &transform );
+			transform.AddComponent( { pRigidBody, pRigidBody->GetTypeID() } );
+			pRigidBody->SetPos( i_pos );
+			pRigidBody->SetVelocity( i_velocity );
+			pRigidBody->SetAngularVelocity( i_angularVelocity );
+			EAE_Engine::Collider::OBBCollider* pCollider = static_cast<EAE_Engine::Collider::OBBCollider*>(
+				EAE_Engine::Collider::CreateOBBCollider( &transform, EAE_Engine::Math::Vector3( 1.0f, 1.0f, 1.0f ) ) );
+			pRigidBody->SetBoxCollider( pCollider );
+		}
+
+		uint32_t Run()
+		{
+			const uint32_t stepCount = (uint32_t)( s_scenarioDuration / EAE_Engine::Time::GetFixedTimeStep() );
+			for ( uint32_t step = 0; step < stepCount; ++step )
+			{
+				rigidBodyManager.FixedUpdateBegin();
+				rigidBodyManager.FixedUpdate();
+				rigidBodyManager.FixedUpdateEnd();
+			}
+			return rigidBodyManager.GetStateHash();
+		}
+	};
+
+	void TestScenario()
+	{
+		std::vector<EAE_Engine::Math::Vector3> positions;
+		positions.push_back( EAE_Engine::Math::Vector3( -50.0f, 0.0f, -50.0f ) );
+		positions.push_back( EAE_Engine::Math::Vector3( -50.0f, 0.0f, 50.0f ) );
+		positions.push_back( EAE_Engine::Math::Vector3( 50.0f, 0.0f, 50.0f ) );
+		positions.push_back( EAE_Engine::Math::Vector3( 50.0f, 0.0f, -50.0f ) );
+		const uint32_t indices[] = { 0, 1, 2, 0, 2, 3 };
+		EngineTests::CreateCollisionMesh( "DeterministicGround", positions, std::vector<uint32_t>( indices, indices + sizeof( indices ) / sizeof( indices[0] ) ), 3 );
+		EngineTests::TestTransform groundTransform;
+		EAE_Engine::Collider::MeshCollider* pGroundCollider = new EAE_Engine::Collider::MeshCollider( &groundTransform );
+		pGroundCollider->Init( "DeterministicGround" );
+		EAE_Engine::Collider::ColliderManager::GetInstance()->AddToColliderList( pGroundCollider );
+
+		uint32_t stateHash = 0;
+		{
+			sScenario scenario( 1 );
+			stateHash = scenario.Run();
+		}
+		{
+			sScenario scenario( 1 );
+			ENGINE_TEST_CHECK( scenario.Run() == stateHash );
+		}
+		{
+			sScenario scenario( 4 );
+			ENGINE_TEST_CHECK( scenario.Run() == stateHash );
+		}
+#if defined(EAE_ENGINE_DETERMINISTIC_MATH)
+		ENGINE_TEST_CHECK( stateHash == s_expectedStateHash );
+		printf( "state hash of the scene: 0x%08x, recorded 0x%08x\n", stateHash, s_expectedStateHash );
+#else
+		printf( "state hash of the scene: 0x%08x, without EAE_ENGINE_DETERMINISTIC_MATH it depends on the compiler\n", stateHash );
+#endif
+	}
+}
+
+// Interface
+//==========
+
+int EngineTests::RunDeterministicMathTests()
+{
+	const int failureCountBefore = GetFailureCount();
+	TestFunctions();
+	TestScenario();
+	CleanScene();
+	return GetFailureCount() - failureCountBefore;
+}
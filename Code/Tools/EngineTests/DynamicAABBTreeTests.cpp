@@ -0,0 +1,292 @@
+/*
+	The DynamicAABBTree with 4096 boxes which move, teleport, and are destroyed and created again for 50 rounds:
+	after each round the AABB queries and the ray casts must find exactly the proxies which a test of all of the fat AABBs finds,
+	UpdatePairs must report exactly the overlapping pairs with a moved proxy, each fat AABB must still contain its box,
+	and the AVL rotations must keep the tree as shallow as a balanced tree.
+	It prints the time of the moves with their re-insertions and rotations, the ns per query against testing every box,
+	and the height and the area ratio of the tree after the moves against a tree built from the same boxes.
+*/
+
+// Header Files
+//=============
+
+#include "EngineTests.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+#include "Engine/SpatialPartition/DynamicAABBTree.h"
+
+// Helper Definitions
+//===================
+
+namespace
+{
+	const uint32_t s_boxCount = 4096;
+	const uint32_t s_roundCount = 50;
+	// The pairs of all of the boxes are 8 million tests, so they are compared every few rounds.
+	const uint32_t s_pairCheckInterval = 5;
+	const uint32_t s_queryCount = 64;
+	const uint32_t s_recreateCount = 16;
+	const float s_worldExtent = 40.0f;
+	// A few m/s at 60 Hz, larger than the fat margin now and then.
+	const float s_maxStep = 0.08f;
+	const float s_queryExtent = 4.0f;
+	const float s_moveChance = 0.3f;
+	const float s_teleportChance = 0.01f;
+
+	typedef std::pair<uint32_t, uint32_t> tProxyPair;
+
+	double GetMilliseconds( std::chrono::high_resolution_clock::time_point i_start )
+	{
+		return std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - i_start ).count();
+	}
+
+	EAE_Engine::Math::PackedAABB CreateBox( std::mt19937& io_generator, const EAE_Engine::Math::Vector3& i_center )
+	{
+		std::uniform_real_distribution<float> size( 0.5f, 3.0f );
+		const EAE_Engine::Math::Vector3 extent( size( io_generator ) * 0.5f, size( io_generator ) * 0.5f, size( io_generator ) * 0.5f );
+		return EAE_Engine::Math::PackedAABB( i_center - extent, i_center + extent );
+	}
+
+	EAE_Engine::Math::PackedAABB CreateQueryBox( const EAE_Engine::Math::Vector3& i_center )
+	{
+		const EAE_Engine::Math::Vector3 extent( s_queryExtent, s_queryExtent, s_queryExtent );
+		return EAE_Engine::Math::PackedAABB( i_center - extent, i_center + extent );
+	}
+
+	EAE_Engine::Math::Vector3 GetRandomPoint( std::mt19937& io_generator )
+	{
+		std::uniform_real_distribution<float> unit( -1.0f, 1.0f );
+		return EAE_Engine::Math::Vector3( unit( io_generator ), unit( io_generator ), unit( io_generator ) ) * s_worldExtent;
+	}
+
+	// The same slab test as DynamicAABBTree::RayCast, o_enter is where the segment enters the box.
+	bool TestSegmentBox( const EAE_Engine::Math::Vector3& i_start, const EAE_Engine::Math::Vector3& i_end, const EAE_Engine::Math::PackedAABB& i_box,
+		float i_maxFraction, float& o_enter )
+	{
+		const float start[] = { i_start._x, i_start._y, i_start._z };
+		const float direction[] = { i_end._x - i_start._x, i_end._y - i_start._y, i_end._z - i_start._z };
+		float tEnter = 0.0f;
+		float tExit = i_maxFraction;
+		for ( size_t axis = 0; axis < 3; ++axis )
+		{
+			const float invDirection = 1.0f / direction[axis];
+			const float tNear = ( i_box._min[axis] - start[axis] ) * invDirection;
+			const float tFar = ( i_box._max[axis] - start[axis] ) * invDirection;
+			if ( tNear != tNear || tFar != tFar )
+				continue;
+			tEnter = std::max( tEnter, std::min( tNear, tFar ) );
+			tExit = std::min( tExit, std::max( tNear, tFar ) );
+		}
+		o_enter = tEnter;
+		return tEnter <= tExit;
+	}
+
+	struct sScene
+	{
+		EAE_Engine::Core::DynamicAABBTree tree;
+		std::vector<EAE_Engine::Math::PackedAABB> boxes;
+		std::vector<uint32_t> proxyIds;
+
+		void Create( std::mt19937& io_generator )
+		{
+			for ( uint32_t boxIndex = 0; boxIndex < s_boxCount; ++boxIndex )
+			{
+				boxes.push_back( CreateBox( io_generator, GetRandomPoint( io_generator ) ) );
+				proxyIds.push_back( tree.CreateProxy( boxes.back(), nullptr ) );
+			}
+		}
+
+		// The proxy ids overlapping i_box, found by testing the fat AABB of every proxy.
+		std::vector<uint32_t> QueryAll( const EAE_Engine::Math::PackedAABB& i_box ) const
+		{
+			std::vector<uint32_t> result;
+			for ( uint32_t boxIndex = 0; boxIndex < s_boxCount; ++boxIndex )
+			{
+				if ( EAE_Engine::Math::TestAABBAABB( tree.GetFatAABB( proxyIds[boxIndex] ), i_box ) )
+					result.push_back( proxyIds[boxIndex] );
+			}
+			std::sort( result.begin(), result.end() );
+			return result;
+		}
+
+		std::vector<uint32_t> QueryTree( const EAE_Engine::Math::PackedAABB& i_box ) const
+		{
+			std::vector<uint32_t> result;
+			tree.QueryAABB( i_box, [&result]( uint32_t i_proxyId ) { result.push_back( i_proxyId ); return true; } );
+			std::sort( result.begin(), result.end() );
+			return result;
+		}
+	};
+}
+
+// Interface
+//==========
+
+int EngineTests::RunDynamicAABBTreeTests()
+{
+	const int failureCountBefore = GetFailureCount();
+	std::mt19937 generator( 32 );
+	std::uniform_real_distribution<float> chance( 0.0f, 1.0f );
+	std::uniform_real_distribution<float> step( -s_maxStep, s_maxStep );
+	sScene scene;
+	scene.Create( generator );
+
+	uint32_t queryMismatchCount = 0;
+	uint32_t rayMismatchCount = 0;
+	uint32_t pairMismatchCount = 0;
+	uint32_t escapedBoxCount = 0;
+	uint32_t maxHeight = 0;
+	size_t moveCount = 0;
+	size_t reinsertCount = 0;
+	double moveMilliseconds = 0.0;
+	std::vector<bool> moved( s_boxCount );
+	// The pairs of the created proxies, the rounds only count their own moves.
+	std::vector<EAE_Engine::Core::ProxyPair> pairs;
+	scene.tree.UpdatePairs( pairs );
+	std::vector<tProxyPair> reportedPairs;
+	for ( uint32_t round = 0; round < s_roundCount; ++round )
+	{
+		std::fill( moved.begin(), moved.end(), false );
+		// Most of the moves stay in the fat AABB, a few leave it and a few teleport across the world.
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		for ( uint32_t boxIndex = 0; boxIndex < s_boxCount; ++boxIndex )
+		{
+			if ( chance( generator ) > s_moveChance )
+				continue;
+			EAE_Engine::Math::PackedAABB& box = scene.boxes[boxIndex];
+			const EAE_Engine::Math::Vector3 offset = chance( generator ) < s_teleportChance ?
+				GetRandomPoint( generator ) - EAE_Engine::Math::StoreVector3( box.Center() ) :
+				EAE_Engine::Math::Vector3( step( generator ), step( generator ), step( generator ) );
+			const __m128 offsetVec = EAE_Engine::Math::LoadVector3( offset );
+			box.Set( _mm_add_ps( box.Min(), offsetVec ), _mm_add_ps( box.Max(), offsetVec ) );
+			++moveCount;
+			if ( scene.tree.MoveProxy( scene.proxyIds[boxIndex], box ) )
+			{
+				moved[boxIndex] = true;
+				++reinsertCount;
+			}
+		}
+		moveMilliseconds += GetMilliseconds( start );
+		// The destroyed proxies go to the free list, and the new ones reuse their nodes.
+		for ( uint32_t recreateIndex = 0; recreateIndex < s_recreateCount; ++recreateIndex )
+		{
+			const uint32_t boxIndex = generator() % s_boxCount;
+			scene.tree.DestroyProxy( scene.proxyIds[boxIndex] );
+			scene.boxes[boxIndex] = CreateBox( generator, GetRandomPoint( generator ) );
+			scene.proxyIds[boxIndex] = scene.tree.CreateProxy( scene.boxes[boxIndex], nullptr );
+			moved[boxIndex] = true;
+		}
+		scene.tree.Validate();
+		ENGINE_TEST_CHECK( scene.tree.GetProxyCount() == s_boxCount );
+		maxHeight = std::max( maxHeight, scene.tree.GetHeight() );
+		for ( uint32_t boxIndex = 0; boxIndex < s_boxCount; ++boxIndex )
+			escapedBoxCount += EAE_Engine::Math::ContainsAABB( scene.tree.GetFatAABB( scene.proxyIds[boxIndex] ), scene.boxes[boxIndex] ) ? 0 : 1;
+
+		scene.tree.UpdatePairs( pairs );
+		if ( round % s_pairCheckInterval == 0 )
+		{
+			reportedPairs.clear();
+			for ( size_t pairIndex = 0; pairIndex < pairs.size(); ++pairIndex )
+				reportedPairs.push_back( tProxyPair( pairs[pairIndex]._proxyA, pairs[pairIndex]._proxyB ) );
+			std::sort( reportedPairs.begin(), reportedPairs.end() );
+			std::vector<tProxyPair> expectedPairs;
+			for ( uint32_t a = 0; a < s_boxCount; ++a )
+			{
+				for ( uint32_t b = a + 1; b < s_boxCount; ++b )
+				{
+					if ( !moved[a] && !moved[b] )
+						continue;
+					const uint32_t proxyA = scene.proxyIds[a];
+					const uint32_t proxyB = scene.proxyIds[b];
+					if ( EAE_Engine::Math::TestAABBAABB( scene.tree.GetFatAABB( proxyA ), scene.tree.GetFatAABB( proxyB ) ) )
+						expectedPairs.push_back( tProxyPair( std::min( proxyA, proxyB ), std::max( proxyA, proxyB ) ) );
+				}
+			}
+			std::sort( expectedPairs.begin(), expectedPairs.end() );
+			pairMismatchCount += reportedPairs == expectedPairs ? 0 : 1;
+		}
+
+		for ( uint32_t queryIndex = 0; queryIndex < s_queryCount; ++queryIndex )
+		{
+			const EAE_Engine::Math::PackedAABB queryBox = CreateQueryBox( GetRandomPoint( generator ) );
+			queryMismatchCount += scene.QueryTree( queryBox ) == scene.QueryAll( queryBox ) ? 0 : 1;
+
+			// Keep going at each hit, so every hit box is visited.
+			const EAE_Engine::Math::Vector3 rayStart = GetRandomPoint( generator );
+			const EAE_Engine::Math::Vector3 rayEnd = GetRandomPoint( generator );
+			std::vector<uint32_t> treeHits;
+			scene.tree.RayCast( rayStart, rayEnd, [&treeHits]( uint32_t i_proxyId, float i_maxFraction ) { treeHits.push_back( i_proxyId ); return i_maxFraction; } );
+			std::sort( treeHits.begin(), treeHits.end() );
+			std::vector<uint32_t> allHits;
+			float closestEnter = 1.0f;
+			for ( uint32_t boxIndex = 0; boxIndex < s_boxCount; ++boxIndex )
+			{
+				float enter = 0.0f;
+				if ( TestSegmentBox( rayStart, rayEnd, scene.tree.GetFatAABB( scene.proxyIds[boxIndex] ), 1.0f, enter ) )
+				{
+					allHits.push_back( scene.proxyIds[boxIndex] );
+					closestEnter = std::min( closestEnter, enter );
+				}
+			}
+			std::sort( allHits.begin(), allHits.end() );
+			// Clip the segment at each hit, so the tree ends at the closest box.
+			float treeClosestEnter = 1.0f;
+			scene.tree.RayCast( rayStart, rayEnd, [&scene, &rayStart, &rayEnd, &treeClosestEnter]( uint32_t i_proxyId, float i_maxFraction )
+			{
+				float enter = 0.0f;
+				if ( !TestSegmentBox( rayStart, rayEnd, scene.tree.GetFatAABB( i_proxyId ), i_maxFraction, enter ) )
+					return i_maxFraction;
+				treeClosestEnter = std::min( treeClosestEnter, enter );
+				// 0 would stop the query, the segments starting in a box have nothing closer anyway.
+				return enter > 0.0f ? enter : -1.0f;
+			} );
+			rayMismatchCount += treeHits == allHits && ( allHits.empty() || treeClosestEnter == closestEnter ) ? 0 : 1;
+		}
+	}
+	ENGINE_TEST_CHECK( queryMismatchCount == 0 );
+	ENGINE_TEST_CHECK( rayMismatchCount == 0 );
+	ENGINE_TEST_CHECK( pairMismatchCount == 0 );
+	ENGINE_TEST_CHECK( escapedBoxCount == 0 );
+	// An AVL tree of n leaves is at most 1.44 log2(n) high.
+	const float heightBound = 1.44f * std::log2( (float)s_boxCount ) + 2.0f;
+	ENGINE_TEST_CHECK( maxHeight <= heightBound );
+	// The fat margin hides most of the small moves.
+	ENGINE_TEST_CHECK( reinsertCount < moveCount );
+
+	// The tree after all of the moves against a tree of the same boxes inserted once.
+	EAE_Engine::Core::DynamicAABBTree builtTree;
+	for ( uint32_t boxIndex = 0; boxIndex < s_boxCount; ++boxIndex )
+		builtTree.CreateProxy( scene.boxes[boxIndex], nullptr );
+
+	std::vector<EAE_Engine::Math::PackedAABB> queryBoxes;
+	for ( uint32_t queryIndex = 0; queryIndex < 1024; ++queryIndex )
+		queryBoxes.push_back( CreateQueryBox( GetRandomPoint( generator ) ) );
+	size_t treeFoundCount = 0;
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	for ( size_t queryIndex = 0; queryIndex < queryBoxes.size(); ++queryIndex )
+		scene.tree.QueryAABB( queryBoxes[queryIndex], [&treeFoundCount]( uint32_t ) { ++treeFoundCount; return true; } );
+	const double treeNanoseconds = GetMilliseconds( start ) * 1.0e6 / queryBoxes.size();
+	size_t allFoundCount = 0;
+	start = std::chrono::high_resolution_clock::now();
+	for ( size_t queryIndex = 0; queryIndex < queryBoxes.size(); ++queryIndex )
+	{
+		for ( uint32_t boxIndex = 0; boxIndex < s_boxCount; ++boxIndex )
+			allFoundCount += EAE_Engine::Math::TestAABBAABB( scene.tree.GetFatAABB( scene.proxyIds[boxIndex] ), queryBoxes[queryIndex] ) ? 1 : 0;
+	}
+	const double allNanoseconds = GetMilliseconds( start ) * 1.0e6 / queryBoxes.size();
+	ENGINE_TEST_CHECK( treeFoundCount == allFoundCount );
+
+	printf( "%u boxes, %u rounds: %u moves, %u re-inserted, %.3f ms of moves per round (%.0f ns per move)\n", s_boxCount, s_roundCount,
+		(uint32_t)moveCount, (uint32_t)reinsertCount, moveMilliseconds / s_roundCount, moveMilliseconds * 1.0e6 / moveCount );
+	printf( "%-14s %-8s %-10s\n", "tree", "height", "area ratio" );
+	printf( "%-14s %-8u %-10.1f (highest %u, bound %.1f)\n", "after moves", scene.tree.GetHeight(), scene.tree.GetAreaRatio(), maxHeight, heightBound );
+	printf( "%-14s %-8u %-10.1f\n", "inserted once", builtTree.GetHeight(), builtTree.GetAreaRatio() );
+	printf( "AABB query, %.1f proxies found: %.0f ns with the tree, %.0f ns testing every box\n",
+		(double)treeFoundCount / queryBoxes.size(), treeNanoseconds, allNanoseconds );
+	return GetFailureCount() - failureCountBefore;
+}
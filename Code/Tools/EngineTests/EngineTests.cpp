@@ -0,0 +1,96 @@
+// Header Files
+//=============
+
+#include "EngineTests.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include "Engine/CollisionDetection/ColliderBase.h"
+#include "Engine/Mesh/AOSMeshData.h"
+#include "Engine/SpatialPartition/Octree.h"
+#include "Engine/SpatialPartition/OctreeLeafBuilder.h"
+
+// Static Data Initialization
+//===========================
+
+namespace
+{
+	int s_failureCount = 0;
+}
+
+// Interface
+//==========
+
+bool EngineTests::Check( bool i_condition, const char* i_expression, const char* i_file, int i_line )
+{
+	if ( !i_condition )
+	{
+		++s_failureCount;
+		printf( "%s(%d): FAILED %s\n", i_file, i_line, i_expression );
+	}
+	return i_condition;
+}
+
+int EngineTests::GetFailureCount()
+{
+	return s_failureCount;
+}
+
+EAE_Engine::Common::ICompo* EngineTests::TestTransform::GetComponent( typeid_t i_type )
+{
+	for ( std::vector<EAE_Engine::Common::Compo>::iterator it = _components.begin(); it != _components.end(); ++it )
+	{
+		if ( it->_typeId == i_type )
+			return it->_pCompo;
+	}
+	return nullptr;
+}
+
+void EngineTests::CreateCollisionMesh( const char* i_meshKey, const std::vector<EAE_Engine::Math::Vector3>& i_positions,
+	const std::vector<uint32_t>& i_indices, uint32_t i_level )
+{
+	EAE_Engine::Mesh::AOSMeshData* pMeshData = new EAE_Engine::Mesh::AOSMeshData();
+	pMeshData->_vertices.resize( i_positions.size() );
+	memset( &pMeshData->_vertices[0], 0, sizeof( EAE_Engine::Mesh::sVertex ) * pMeshData->_vertices.size() );
+	EAE_Engine::Math::Vector3 minPos = i_positions[0];
+	EAE_Engine::Math::Vector3 maxPos = i_positions[0];
+	for ( size_t vertexIndex = 0; vertexIndex < i_positions.size(); ++vertexIndex )
+	{
+		const EAE_Engine::Math::Vector3& position = i_positions[vertexIndex];
+		pMeshData->_vertices[vertexIndex].x = position._x;
+		pMeshData->_vertices[vertexIndex].y = position._y;
+		pMeshData->_vertices[vertexIndex].z = position._z;
+		minPos = EAE_Engine::Math::Vector3( position._x < minPos._x ? position._x : minPos._x,
+			position._y < minPos._y ? position._y : minPos._y, position._z < minPos._z ? position._z : minPos._z );
+		maxPos = EAE_Engine::Math::Vector3( position._x > maxPos._x ? position._x : maxPos._x,
+			position._y > maxPos._y ? position._y : maxPos._y, position._z > maxPos._z ? position._z : maxPos._z );
+	}
+	pMeshData->_indices = i_indices;
+	EAE_Engine::Mesh::AOSMeshDataManager::GetInstance()->AddAOSMeshData( i_meshKey, pMeshData );
+
+	std::vector<EAE_Engine::Mesh::TriangleIndex> triangles( i_indices.size() / 3 );
+	for ( size_t triangleIndex = 0; triangleIndex < triangles.size(); ++triangleIndex )
+	{
+		triangles[triangleIndex]._index0 = i_indices[triangleIndex * 3 + 0];
+		triangles[triangleIndex]._index1 = i_indices[triangleIndex * 3 + 1];
+		triangles[triangleIndex]._index2 = i_indices[triangleIndex * 3 + 2];
+	}
+	// The flat meshes still need a volume for the octree.
+	const EAE_Engine::Math::Vector3 margin( 1.0f, 1.0f, 1.0f );
+	minPos = minPos - margin;
+	maxPos = maxPos + margin;
+	std::vector<std::vector<EAE_Engine::Mesh::TriangleIndex> > leafTriangles;
+	EAE_Engine::Core::BuildLeafTriangles( i_level, minPos, maxPos, i_positions, triangles, 1, leafTriangles );
+	EAE_Engine::Core::CompleteOctree* pOctree = new EAE_Engine::Core::CompleteOctree();
+	pOctree->InitFromTriangles( i_level, minPos, maxPos, leafTriangles );
+	pOctree->SetCollisionMesh( pMeshData );
+	EAE_Engine::Core::OctreeManager::GetInstance()->AddOctree( i_meshKey, pOctree );
+}
+
+void EngineTests::CleanScene()
+{
+	EAE_Engine::Collider::ColliderManager::CleanInstance();
+	EAE_Engine::Core::OctreeManager::Destroy();
+	EAE_Engine::Mesh::AOSMeshDataManager::Destroy();
+}
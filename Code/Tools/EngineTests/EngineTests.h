@@ -0,0 +1,117 @@
+/*
+	The shared helpers of the suites of EngineTests
+*/
+
+#ifndef EAE_ENGINE_TOOLS_ENGINETESTS_H
+#define EAE_ENGINE_TOOLS_ENGINETESTS_H
+
+// Header Files
+//=============
+
+#include <cstdint>
+#include <vector>
+
+#include "Engine/Common/Interfaces.h"
+#include "Engine/Math/ColMatrix.h"
+#include "Engine/Math/Quaternion.h"
+#include "Engine/Math/Vector.h"
+
+// Interface
+//==========
+
+namespace EngineTests
+{
+	// Count a failure and print the expression when i_condition is false, returns i_condition.
+	bool Check( bool i_condition, const char* i_expression, const char* i_file, int i_line );
+	// The failures of all of the suites which have run.
+	int GetFailureCount();
+
+	// A Transform without a GameObj or the TransformHierarchy, for the RigidBodys and the Colliders of the suites.
+	// GetComponent finds the components added by AddComponent, like GameObj::GetComponent.
+	class TestTransform : public EAE_Engine::Common::ITransform
+	{
+	public:
+		TestTransform( const EAE_Engine::Math::Vector3& i_pos = EAE_Engine::Math::Vector3::Zero ) : _pos( i_pos ), _rotation( EAE_Engine::Math::Quaternion::Identity ) {}
+		void AddComponent( EAE_Engine::Common::Compo i_compo ) { _components.push_back( i_compo ); }
+
+		EAE_Engine::Common::ICompo* GetComponent( typeid_t i_type );
+		EAE_Engine::Common::ITransform* GetTransform() { return this; }
+		EAE_Engine::Common::IGameObj* GetGameObj() { return nullptr; }
+		EAE_Engine::Math::Vector3 GetPos() const { return _pos; }
+		void SetPos( const EAE_Engine::Math::Vector3& i_pos ) { _pos = i_pos; }
+		void SetRotation( const EAE_Engine::Math::Quaternion& i_rotation ) { _rotation = i_rotation; }
+		EAE_Engine::Math::Quaternion GetRotation() const { return _rotation; }
+		void SetScale( const EAE_Engine::Math::Vector3& ) {}
+		EAE_Engine::Math::Vector3 GetScale() const { return EAE_Engine::Math::Vector3( 1.0f, 1.0f, 1.0f ); }
+		EAE_Engine::Math::Vector3 GetEulerAngle() const { return EAE_Engine::Math::Vector3::Zero; }
+		void SetEulerAngle( EAE_Engine::Math::Vector3 ) {}
+		// There is no parent, so the local transform is the global one.
+		EAE_Engine::Math::Vector3 GetLocalPos() const { return _pos; }
+		void SetLocalPos( const EAE_Engine::Math::Vector3& i_pos ) { _pos = i_pos; }
+		EAE_Engine::Math::Quaternion GetLocalRotation() const { return _rotation; }
+		void SetLocalRotation( const EAE_Engine::Math::Quaternion& i_rotation ) { _rotation = i_rotation; }
+		void SetLocalScale( const EAE_Engine::Math::Vector3& ) {}
+		EAE_Engine::Math::Vector3 LocalScale() { return EAE_Engine::Math::Vector3( 1.0f, 1.0f, 1.0f ); }
+		EAE_Engine::Math::Vector3 GetLocalEulerAngle() { return EAE_Engine::Math::Vector3::Zero; }
+		void SetLocalEulerAngle( const EAE_Engine::Math::Vector3& ) {}
+		void Move( const EAE_Engine::Math::Vector3& i_offset ) { _pos = _pos + i_offset; }
+		void Rotate( const EAE_Engine::Math::Quaternion& i_rotation ) { _rotation = i_rotation * _rotation; }
+		EAE_Engine::Math::ColMatrix44 GetRotateTransformMatrix() const { return EAE_Engine::Math::Quaternion::CreateColMatrix( _rotation ); }
+		EAE_Engine::Math::ColMatrix44 GetLocalToWorldMatrix() const { return EAE_Engine::Math::ColMatrix44( _rotation, _pos ); }
+		EAE_Engine::Math::Vector3 GetForward() const { return EAE_Engine::Math::Vector3::Zero; }
+		void SetForward( EAE_Engine::Math::Vector3 ) {}
+		EAE_Engine::Math::Vector3 GetRight() const { return EAE_Engine::Math::Vector3::Zero; }
+		EAE_Engine::Math::Vector3 GetUp() const { return EAE_Engine::Math::Vector3::Zero; }
+		void LookAt( EAE_Engine::Math::Vector3 ) {}
+		void RotateAround( EAE_Engine::Math::Vector3, EAE_Engine::Math::Vector3, float ) {}
+		uint32_t GetChildCount() { return 0; }
+		EAE_Engine::Common::ITransform* GetChild( uint32_t ) { return nullptr; }
+		void AddChild( EAE_Engine::Common::ITransform* ) {}
+		void RemoveChild( EAE_Engine::Common::ITransform* ) {}
+		void SetParent( EAE_Engine::Common::ITransform* ) {}
+		EAE_Engine::Common::ITransform* GetParent() { return nullptr; }
+
+	private:
+		EAE_Engine::Math::Vector3 _pos;
+		EAE_Engine::Math::Quaternion _rotation;
+		std::vector<EAE_Engine::Common::Compo> _components;
+	};
+
+	// Add the mesh as i_meshKey to the AOSMeshDataManager and build the collision octree of it with i_level levels,
+	// so the MeshColliders and the RigidBodys use it like the collision mesh loaded by Physics::Init.
+	void CreateCollisionMesh( const char* i_meshKey, const std::vector<EAE_Engine::Math::Vector3>& i_positions,
+		const std::vector<uint32_t>& i_indices, uint32_t i_level );
+	// Delete the Colliders, the octrees and the meshes, so the next suite starts from an empty world.
+	void CleanScene();
+
+	// The suites, each returns its count of failures.
+	int RunTransformTests();
+	int RunQuantizationTests();
+	int RunFloatCompareTests();
+	int RunDeterministicMathTests();
+	int RunSIMDGeometryTests();
+	int RunBroadPhaseTests();
+	int RunDynamicAABBTreeTests();
+	int RunMeshColliderTests();
+	int RunSATPairCacheTests();
+	int RunIslandTests();
+	int RunTunnelingTests();
+	int RunBatchQueryTests();
+	int RunSleepTests();
+	int RunIntegrationTests();
+	int RunStackingTests();
+	int RunBVHTests();
+	int RunOctreeSegmentTests();
+	int RunOctreeFileTests();
+	int RunLooseOctreeTests();
+	int RunSpatialHashGridTests();
+	int RunOctreeLeafBuilderTests();
+	int RunSparseOctreeTests();
+	int RunSIMDTests();
+	int RunTriangleCacheTests();
+	int RunFrustumTests();
+}
+
+#define ENGINE_TEST_CHECK( i_condition ) EngineTests::Check( ( i_condition ), #i_condition, __FILE__, __LINE__ )
+
+#endif	// EAE_ENGINE_TOOLS_ENGINETESTS_H
@@ -0,0 +1,103 @@
+/*
+	The main() function is where the program starts execution
+
+	EngineTests runs the headless tests and benchmarks of the physics and the spatial partition:
+		EngineTests [suite name ...]
+	Without a name all of the suites run. The exit code is the count of the failed checks.
+*/
+
+// Header Files
+//=============
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "EngineTests.h"
+#include "Engine/Time/Time.h"
+
+// Helper Definitions
+//===================
+
+namespace
+{
+	struct sSuite
+	{
+		const char* name;
+		int ( *run )();
+	};
+
+	const sSuite s_suites[] =
+	{
+		{ "transforms", EngineTests::RunTransformTests },
+		{ "quantization", EngineTests::RunQuantizationTests },
+		{ "floatcompare", EngineTests::RunFloatCompareTests },
+		{ "deterministicmath", EngineTests::RunDeterministicMathTests },
+		{ "simdgeometry", EngineTests::RunSIMDGeometryTests },
+		{ "broadphase", EngineTests::RunBroadPhaseTests },
+		{ "aabbtree", EngineTests::RunDynamicAABBTreeTests },
+		{ "meshcollider", EngineTests::RunMeshColliderTests },
+		{ "satcache", EngineTests::RunSATPairCacheTests },
+		{ "islands", EngineTests::RunIslandTests },
+		{ "tunneling", EngineTests::RunTunnelingTests },
+		{ "batchquery", EngineTests::RunBatchQueryTests },
+		{ "sleep", EngineTests::RunSleepTests },
+		{ "integration", EngineTests::RunIntegrationTests },
+		{ "stacking", EngineTests::RunStackingTests },
+		{ "bvh", EngineTests::RunBVHTests },
+		{ "octreesegment", EngineTests::RunOctreeSegmentTests },
+		{ "octreefile", EngineTests::RunOctreeFileTests },
+		{ "looseoctree", EngineTests::RunLooseOctreeTests },
+		{ "spatialhash", EngineTests::RunSpatialHashGridTests },
+		{ "octreeleafbuilder", EngineTests::RunOctreeLeafBuilderTests },
+		{ "sparseoctree", EngineTests::RunSparseOctreeTests },
+		{ "simd", EngineTests::RunSIMDTests },
+		{ "trianglecache", EngineTests::RunTriangleCacheTests },
+		{ "frustum", EngineTests::RunFrustumTests },
+	};
+	const size_t s_suiteCount = sizeof( s_suites ) / sizeof( s_suites[0] );
+
+	bool ShouldRun( const char* i_name, int i_argumentCount, char** i_arguments )
+	{
+		if ( i_argumentCount < 2 )
+			return true;
+		for ( int argumentIndex = 1; argumentIndex < i_argumentCount; ++argumentIndex )
+		{
+			if ( strcmp( i_arguments[argumentIndex], i_name ) == 0 )
+				return true;
+		}
+		return false;
+	}
+}
+
+// Entry Point
+//============
+
+int main( int i_argumentCount, char** i_arguments )
+{
+	// The suites step the physics themselves, one FixedUpdate is always 1/60 second.
+	EAE_Engine::Time::SetFixedTimeStep( 1.0f / 60.0f );
+	for ( int argumentIndex = 1; argumentIndex < i_argumentCount; ++argumentIndex )
+	{
+		bool found = false;
+		for ( size_t suiteIndex = 0; suiteIndex < s_suiteCount; ++suiteIndex )
+			found = found || strcmp( i_arguments[argumentIndex], s_suites[suiteIndex].name ) == 0;
+		if ( !found )
+		{
+			fprintf( stderr, "There is no suite \"%s\"\n", i_arguments[argumentIndex] );
+			return EXIT_FAILURE;
+		}
+	}
+	for ( size_t suiteIndex = 0; suiteIndex < s_suiteCount; ++suiteIndex )
+	{
+		const sSuite& suite = s_suites[suiteIndex];
+		if ( !ShouldRun( suite.name, i_argumentCount, i_arguments ) )
+			continue;
+		printf( "== %s\n", suite.name );
+		const int failureCount = suite.run();
+		printf( "== %s: %s\n\n", suite.name, failureCount == 0 ? "passed" : "FAILED" );
+	}
+	const int failureCount = EngineTests::GetFailureCount();
+	printf( "%d failed checks\n", failureCount );
+	return failureCount;
+}
@@ -0,0 +1,311 @@
+/*
+	The branch free comparisons of Implements and FloatCompare against the old AlmostEqual2sComplement:
+	random bit patterns, near neighbours, +-0, denormals on both sides of 0, infinities, NaNs and opposite signs
+	must give the same answer, and the SSE2 array versions the same answer as the scalar ones.
+	It also prints the time of the zero speed tests of the 15 axes of the OBB SAT with the branchy and the branch free versions.
+*/
+
+// Header Files
+//=============
+
+#include "EngineTests.h"
+
+#include <chrono>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+
+#include "Engine/General/Implements.h"
+#include "Engine/Math/FloatCompare.h"
+
+// Helper Definitions
+//===================
+
+namespace
+{
+	const uint32_t s_fuzzCount = 1000000;
+	const int s_maxUlpsList[] = { 1, 2, 4, 16, 1000, 4 * 1024 * 1024 - 1 };
+	const size_t s_maxUlpsCount = sizeof( s_maxUlpsList ) / sizeof( s_maxUlpsList[0] );
+	const uint32_t s_pairCount = 4096;
+	const uint32_t s_benchmarkRepeatCount = 100;
+
+	float UIntAsFloat( uint32_t i_value )
+	{
+		float result;
+		memcpy( &result, &i_value, sizeof( float ) );
+		return result;
+	}
+
+	uint32_t FloatAsUInt( float i_value )
+	{
+		uint32_t result;
+		memcpy( &result, &i_value, sizeof( float ) );
+		return result;
+	}
+
+	struct sRandom
+	{
+		std::mt19937 engine;
+
+		sRandom() : engine( 28 ) {}
+
+		uint32_t Bits() { return engine(); }
+		uint32_t Index( uint32_t i_count ) { return engine() % i_count; }
+
+		// Either any bit pattern, a float around 0, a denormal, or one of the edges.
+		float Float()
+		{
+			switch ( Index( 6 ) )
+			{
+			case 0:
+				return UIntAsFloat( Bits() );
+			case 1:
+				return UIntAsFloat( ( Bits() & 0x80000000u ) | ( Bits() & 0x007fffffu ) );
+			case 2:
+				return UIntAsFloat( ( Bits() & 0x80000000u ) | Index( 64 ) );
+			case 3:
+			{
+				const float edges[] = { 0.0f, -0.0f, FLT_MAX, -FLT_MAX, FLT_MIN, -FLT_MIN, std::numeric_limits<float>::infinity(),
+					-std::numeric_limits<float>::infinity(), std::numeric_limits<float>::quiet_NaN(), -std::numeric_limits<float>::quiet_NaN(), 1.0f, -1.0f };
+				return edges[Index( sizeof( edges ) / sizeof( edges[0] ) )];
+			}
+			default:
+				return std::ldexp( (float)Index( 1 << 20 ) / ( 1 << 20 ) - 0.5f, (int)Index( 60 ) - 30 );
+			}
+		}
+
+		// Mostly a near neighbour of i_value, sometimes on the other side of 0, sometimes anything.
+		float Other( float i_value, int i_maxUlps )
+		{
+			switch ( Index( 4 ) )
+			{
+			case 0:
+				return Float();
+			case 1:
+				return -i_value;
+			default:
+			{
+				const int64_t offset = (int64_t)Index( 2 * (uint32_t)i_maxUlps + 3 ) - i_maxUlps - 1;
+				const int64_t ordered = (int64_t)EAE_Engine::Implements::FloatToOrderedInt( i_value ) + offset;
+				if ( ordered < INT32_MIN || ordered > INT32_MAX )
+					return i_value;
+				// Back from the ordered int to the bits, the negative side is the mirror of the positive one.
+				const int32_t orderedInt = (int32_t)ordered;
+				return orderedInt >= 0 ? UIntAsFloat( (uint32_t)orderedInt ) : UIntAsFloat( 0x80000000u | (uint32_t)( -(int64_t)orderedInt ) );
+			}
+			}
+		}
+	};
+
+	// The answer of the old AlmostEqual2sComplement, whose 32 bits difference wraps around for the values far apart.
+	// Those are more than 2^31 ulps apart, so they are never equal.
+	bool AlmostEqualOld( float i_a, float i_b, int i_maxUlps )
+	{
+		const int64_t distance = (int64_t)EAE_Engine::Implements::FloatToOrderedInt( i_a ) - (int64_t)EAE_Engine::Implements::FloatToOrderedInt( i_b );
+		if ( distance > INT32_MAX || distance < -(int64_t)INT32_MAX )
+			return false;
+		return EAE_Engine::Implements::AlmostEqual2sComplement( i_a, i_b, i_maxUlps );
+	}
+
+	void FuzzScalars()
+	{
+		sRandom random;
+		uint32_t mismatchCount = 0;
+		uint32_t equalCount = 0;
+		uint32_t wrappedCount = 0;
+		for ( uint32_t pairIndex = 0; pairIndex < s_fuzzCount; ++pairIndex )
+		{
+			const int maxUlps = s_maxUlpsList[random.Index( (uint32_t)s_maxUlpsCount )];
+			const float a = random.Float();
+			const float b = random.Other( a, maxUlps );
+			const bool expected = AlmostEqualOld( a, b, maxUlps );
+			mismatchCount += EAE_Engine::Implements::AlmostEqualUlps( a, b, maxUlps ) != expected ? 1 : 0;
+			// The order of the 2 doesn't matter.
+			mismatchCount += EAE_Engine::Implements::AlmostEqualUlps( b, a, maxUlps ) != expected ? 1 : 0;
+			equalCount += expected ? 1 : 0;
+			const int64_t distance = (int64_t)EAE_Engine::Implements::FloatToOrderedInt( a ) - (int64_t)EAE_Engine::Implements::FloatToOrderedInt( b );
+			wrappedCount += distance > INT32_MAX || distance < -(int64_t)INT32_MAX ? 1 : 0;
+			// The ordered ints keep the order of the floats.
+			if ( !std::isnan( a ) && !std::isnan( b ) && ( a < b ) != ( EAE_Engine::Implements::FloatToOrderedInt( a ) < EAE_Engine::Implements::FloatToOrderedInt( b ) ) )
+				++mismatchCount;
+			const float epsilon = std::ldexp( 1.0f, (int)random.Index( 40 ) - 30 );
+			mismatchCount += EAE_Engine::Implements::AlmostEqualAbsolute( a, b, epsilon ) != ( std::fabs( a - b ) <= epsilon ) ? 1 : 0;
+		}
+		ENGINE_TEST_CHECK( mismatchCount == 0 );
+		// Both of the answers and the far apart pairs must have been tested often.
+		ENGINE_TEST_CHECK( equalCount > s_fuzzCount / 10 && equalCount < s_fuzzCount - s_fuzzCount / 10 );
+		ENGINE_TEST_CHECK( wrappedCount > s_fuzzCount / 100 );
+		printf( "%u random pairs, %u equal, %u more than 2^31 ulps apart: %u disagreements with AlmostEqual2sComplement\n",
+			s_fuzzCount, equalCount, wrappedCount, mismatchCount );
+
+		// The edges, by hand.
+		const float nan = std::numeric_limits<float>::quiet_NaN();
+		const float infinity = std::numeric_limits<float>::infinity();
+		const float denormal = UIntAsFloat( 1 );
+		ENGINE_TEST_CHECK( EAE_Engine::Implements::AlmostEqualUlps( 0.0f, -0.0f, 1 ) );
+		ENGINE_TEST_CHECK( EAE_Engine::Implements::AlmostEqualUlps( denormal, -denormal, 2 ) );
+		ENGINE_TEST_CHECK( !EAE_Engine::Implements::AlmostEqualUlps( denormal, -denormal, 1 ) );
+		ENGINE_TEST_CHECK( !EAE_Engine::Implements::AlmostEqualUlps( nan, 1.0f, 4 * 1024 * 1024 - 1 ) );
+		ENGINE_TEST_CHECK( !EAE_Engine::Implements::AlmostEqualUlps( nan, infinity, 16 ) );
+		ENGINE_TEST_CHECK( !EAE_Engine::Implements::AlmostEqualUlps( FLT_MAX, -FLT_MAX, 4 * 1024 * 1024 - 1 ) );
+		ENGINE_TEST_CHECK( !EAE_Engine::Implements::AlmostEqualUlps( infinity, -infinity, 1 ) );
+		ENGINE_TEST_CHECK( EAE_Engine::Implements::AlmostEqualUlps( FLT_MAX, infinity, 1 ) );
+		ENGINE_TEST_CHECK( !EAE_Engine::Implements::AlmostEqualUlps( 1.0f, -1.0f, 4 * 1024 * 1024 - 1 ) );
+		ENGINE_TEST_CHECK( !EAE_Engine::Implements::AlmostEqualAbsolute( nan, nan, FLT_MAX ) );
+		ENGINE_TEST_CHECK( EAE_Engine::Implements::AlmostEqualAbsolute( 0.0f, -0.0f, 0.0f ) );
+	}
+
+	// The SSE2 array versions and the overloads give the AND of the scalar answers.
+	void FuzzArrays()
+	{
+		sRandom random;
+		uint32_t mismatchCount = 0;
+		uint32_t equalCount = 0;
+		for ( uint32_t arrayIndex = 0; arrayIndex < s_fuzzCount / 10; ++arrayIndex )
+		{
+			const int maxUlps = s_maxUlpsList[random.Index( (uint32_t)s_maxUlpsCount )];
+			const float epsilon = std::ldexp( 1.0f, (int)random.Index( 40 ) - 30 );
+			// 1 to 19 floats, so the tails after the groups of 4 are tested too.
+			const size_t count = 1 + random.Index( 19 );
+			float a[19], b[19];
+			bool expectedUlps = true;
+			bool expectedAbsolute = true;
+			for ( size_t index = 0; index < count; ++index )
+			{
+				a[index] = random.Float();
+				// Most of the floats are equal, so the one which isn't decides the answer.
+				b[index] = random.Index( 8 ) == 0 ? random.Other( a[index], maxUlps ) : a[index];
+				expectedUlps &= EAE_Engine::Implements::AlmostEqualUlps( a[index], b[index], maxUlps );
+				expectedAbsolute &= EAE_Engine::Implements::AlmostEqualAbsolute( a[index], b[index], epsilon );
+			}
+			mismatchCount += EAE_Engine::Math::AlmostEqualUlps( a, b, count, maxUlps ) != expectedUlps ? 1 : 0;
+			mismatchCount += EAE_Engine::Math::AlmostEqualAbsolute( a, b, count, epsilon ) != expectedAbsolute ? 1 : 0;
+			equalCount += expectedUlps ? 1 : 0;
+			if ( count >= 4 )
+			{
+				bool expectedVector3 = true;
+				bool expectedVector4 = true;
+				for ( size_t index = 0; index < 4; ++index )
+				{
+					expectedVector3 &= index == 3 || EAE_Engine::Implements::AlmostEqualUlps( a[index], b[index], maxUlps );
+					expectedVector4 &= EAE_Engine::Implements::AlmostEqualUlps( a[index], b[index], maxUlps );
+				}
+				const EAE_Engine::Math::Vector3 a3( a[0], a[1], a[2] ), b3( b[0], b[1], b[2] );
+				const EAE_Engine::Math::Vector4 a4( a[0], a[1], a[2], a[3] ), b4( b[0], b[1], b[2], b[3] );
+				const EAE_Engine::Math::Quaternion aQuaternion( a[0], a[1], a[2], a[3] ), bQuaternion( b[0], b[1], b[2], b[3] );
+				mismatchCount += EAE_Engine::Math::AlmostEqualUlps( a3, b3, maxUlps ) != expectedVector3 ? 1 : 0;
+				mismatchCount += EAE_Engine::Math::AlmostEqualUlps( a4, b4, maxUlps ) != expectedVector4 ? 1 : 0;
+				mismatchCount += EAE_Engine::Math::AlmostEqualUlps( aQuaternion, bQuaternion, maxUlps ) != expectedVector4 ? 1 : 0;
+			}
+			if ( count == 16 )
+			{
+				EAE_Engine::Math::ColMatrix44 aMatrix, bMatrix;
+				memcpy( aMatrix._m, a, sizeof( aMatrix._m ) );
+				memcpy( bMatrix._m, b, sizeof( bMatrix._m ) );
+				mismatchCount += EAE_Engine::Math::AlmostEqualUlps( aMatrix, bMatrix, maxUlps ) != expectedUlps ? 1 : 0;
+				mismatchCount += EAE_Engine::Math::AlmostEqualAbsolute( aMatrix, bMatrix, epsilon ) != expectedAbsolute ? 1 : 0;
+			}
+		}
+		ENGINE_TEST_CHECK( mismatchCount == 0 );
+		ENGINE_TEST_CHECK( equalCount > s_fuzzCount / 100 && equalCount < s_fuzzCount / 10 - s_fuzzCount / 100 );
+	}
+
+	// The relative speed of the 2 boxes on the 15 axes of the SAT: the axes of A, of B, and the crosses of them.
+	// A quarter of the pairs move together and a quarter of the boxes are turned the same, so many axes are static.
+	void ComputeAxisSpeeds( sRandom& io_random, float o_speeds[16] )
+	{
+		std::uniform_real_distribution<float> unit( -1.0f, 1.0f );
+		const EAE_Engine::Math::Quaternion rotationA( unit( io_random.engine ) * 3.0f, EAE_Engine::Math::Vector3( 0.0f, 1.0f, 0.0f ) );
+		const EAE_Engine::Math::Quaternion rotationB = io_random.Index( 4 ) == 0 ? rotationA :
+			EAE_Engine::Math::Quaternion( unit( io_random.engine ) * 3.0f, EAE_Engine::Math::Vector3( unit( io_random.engine ), 1.0f, unit( io_random.engine ) ).GetNormalize() );
+		const EAE_Engine::Math::Vector3 relativeMovement = io_random.Index( 4 ) == 0 ? EAE_Engine::Math::Vector3::Zero :
+			EAE_Engine::Math::Vector3( unit( io_random.engine ), 0.0f, unit( io_random.engine ) ) * ( 1.0f / 60.0f );
+		EAE_Engine::Math::Vector3 axesOfA[3], axesOfB[3];
+		const EAE_Engine::Math::Vector3 units[3] = { EAE_Engine::Math::Vector3( 1.0f, 0.0f, 0.0f ), EAE_Engine::Math::Vector3( 0.0f, 1.0f, 0.0f ), EAE_Engine::Math::Vector3( 0.0f, 0.0f, 1.0f ) };
+		for ( uint32_t axis = 0; axis < 3; ++axis )
+		{
+			axesOfA[axis] = EAE_Engine::Math::Quaternion::MultiVector( rotationA, units[axis] );
+			axesOfB[axis] = EAE_Engine::Math::Quaternion::MultiVector( rotationB, units[axis] );
+			o_speeds[axis] = relativeMovement.Dot( axesOfA[axis] );
+			o_speeds[axis + 3] = relativeMovement.Dot( axesOfB[axis] );
+		}
+		for ( uint32_t i = 0; i < 3; ++i )
+		{
+			for ( uint32_t j = 0; j < 3; ++j )
+				o_speeds[6 + i * 3 + j] = relativeMovement.Dot( axesOfA[i].Cross( axesOfB[j] ) );
+		}
+		// The 16th lane only pads the group of 4, it is never static.
+		o_speeds[15] = 1.0f;
+	}
+
+	double GetNanoseconds( std::chrono::high_resolution_clock::time_point i_start, uint32_t i_count )
+	{
+		return std::chrono::duration<double, std::nano>( std::chrono::high_resolution_clock::now() - i_start ).count() / i_count;
+	}
+
+	void PrintSATComparisons()
+	{
+		sRandom random;
+		std::vector<float> speeds( s_pairCount * 16 );
+		for ( uint32_t pairIndex = 0; pairIndex < s_pairCount; ++pairIndex )
+			ComputeAxisSpeeds( random, &speeds[pairIndex * 16] );
+		const float zeros[16] = {};
+
+		// Before: the branchy IsFloatAbsoluteEqual on each axis, like the fabsf test in CalculateOverlapSepTimeForSAT.
+		uint32_t branchyStaticCount = 0;
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		for ( uint32_t repeat = 0; repeat < s_benchmarkRepeatCount; ++repeat )
+		{
+			for ( uint32_t pairIndex = 0; pairIndex < s_pairCount; ++pairIndex )
+			{
+				for ( uint32_t axis = 0; axis < 15; ++axis )
+				{
+					if ( EAE_Engine::Implements::IsFloatAbsoluteEqual( speeds[pairIndex * 16 + axis], 0.0f, FLT_EPSILON ) )
+						++branchyStaticCount;
+				}
+			}
+		}
+		const double branchyNanoseconds = GetNanoseconds( start, s_pairCount * s_benchmarkRepeatCount );
+		// After: the branch free AlmostEqualAbsolute adds the answers up.
+		uint32_t branchFreeStaticCount = 0;
+		start = std::chrono::high_resolution_clock::now();
+		for ( uint32_t repeat = 0; repeat < s_benchmarkRepeatCount; ++repeat )
+		{
+			for ( uint32_t pairIndex = 0; pairIndex < s_pairCount; ++pairIndex )
+			{
+				for ( uint32_t axis = 0; axis < 15; ++axis )
+					branchFreeStaticCount += EAE_Engine::Implements::AlmostEqualAbsolute( speeds[pairIndex * 16 + axis], 0.0f, FLT_EPSILON ) ? 1 : 0;
+			}
+		}
+		const double branchFreeNanoseconds = GetNanoseconds( start, s_pairCount * s_benchmarkRepeatCount );
+		// The SSE2 array version answers whether a pair doesn't move on any axis at all.
+		uint32_t allStaticCount = 0;
+		start = std::chrono::high_resolution_clock::now();
+		for ( uint32_t repeat = 0; repeat < s_benchmarkRepeatCount; ++repeat )
+		{
+			for ( uint32_t pairIndex = 0; pairIndex < s_pairCount; ++pairIndex )
+				allStaticCount += EAE_Engine::Math::AlmostEqualAbsolute( &speeds[pairIndex * 16], zeros, 15, FLT_EPSILON ) ? 1 : 0;
+		}
+		const double arrayNanoseconds = GetNanoseconds( start, s_pairCount * s_benchmarkRepeatCount );
+		// |speed| is never exactly FLT_EPSILON here, so < and <= agree.
+		ENGINE_TEST_CHECK( branchyStaticCount == branchFreeStaticCount );
+		ENGINE_TEST_CHECK( branchFreeStaticCount > 0 && allStaticCount > 0 );
+		printf( "the zero speed tests of the 15 SAT axes of %u box pairs, %.1f%% static: ns per pair branchy %.2f, branch free %.2f, SSE2 array %.2f\n",
+			s_pairCount, 100.0 * branchFreeStaticCount / ( 15.0 * s_pairCount * s_benchmarkRepeatCount ), branchyNanoseconds, branchFreeNanoseconds, arrayNanoseconds );
+	}
+}
+
+// Interface
+//==========
+
+int EngineTests::RunFloatCompareTests()
+{
+	const int failureCountBefore = GetFailureCount();
+	FuzzScalars();
+	FuzzArrays();
+	PrintSATComparisons();
+	return GetFailureCount() - failureCountBefore;
+}
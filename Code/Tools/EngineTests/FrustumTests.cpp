@@ -0,0 +1,258 @@
+/*
+	The frustum and the box queries of the CompleteOctree against testing each leaf on its own:
+	a camera sweeping a circle over a height field and random boxes must find the same leaves with both.
+	It also prints, for the octrees of 4, 5 and 6 levels, the nodes tested, the leaves found
+	and the time of a frame of the sweep with the octree and with the test of each leaf.
+*/
+
+// Header Files
+//=============
+
+#include "EngineTests.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+#include "Engine/Math/SIMDGeometry.h"
+#include "Engine/SpatialPartition/Octree.h"
+
+// Helper Definitions
+//===================
+
+namespace
+{
+	const uint32_t s_gridSize = 64;
+	const float s_cellSize = 4.0f;
+	const uint32_t s_frameCount = 720;
+	const uint32_t s_boxCount = 5000;
+	const float s_pi = 3.14159265f;
+
+	// The hills under the camera, the triangles face +y.
+	void CreateHeightField( std::vector<EAE_Engine::Math::Vector3>& o_positions, std::vector<uint32_t>& o_indices )
+	{
+		const float half = s_gridSize * s_cellSize * 0.5f;
+		for ( uint32_t z = 0; z <= s_gridSize; ++z )
+		{
+			for ( uint32_t x = 0; x <= s_gridSize; ++x )
+			{
+				const float posX = x * s_cellSize - half;
+				const float posZ = z * s_cellSize - half;
+				o_positions.push_back( EAE_Engine::Math::Vector3( posX, 20.0f * std::sin( posX * 0.05f ) * std::cos( posZ * 0.04f ), posZ ) );
+			}
+		}
+		for ( uint32_t z = 0; z < s_gridSize; ++z )
+		{
+			for ( uint32_t x = 0; x < s_gridSize; ++x )
+			{
+				const uint32_t v00 = z * ( s_gridSize + 1 ) + x;
+				const uint32_t v10 = v00 + 1;
+				const uint32_t v01 = v00 + s_gridSize + 1;
+				const uint32_t v11 = v01 + 1;
+				const uint32_t quad[] = { v00, v01, v11, v00, v11, v10 };
+				o_indices.insert( o_indices.end(), quad, quad + 6 );
+			}
+		}
+	}
+
+	// The world to clip matrix of Camera on D3D, whose clip z is in [0, w] like ComputeFrustum wants.
+	// The camera looks along its -z.
+	EAE_Engine::Math::ColMatrix44 CreateWorldToClip( const EAE_Engine::Math::Quaternion& i_rotation, const EAE_Engine::Math::Vector3& i_position,
+		float i_fieldOfViewY, float i_aspectRatio, float i_nearPlane, float i_farPlane )
+	{
+		const EAE_Engine::Math::ColMatrix44 viewToWorld( i_rotation, i_position );
+		const EAE_Engine::Math::ColMatrix44 worldToView(
+			viewToWorld._m00, viewToWorld._m01, viewToWorld._m02, 0.0f,
+			viewToWorld._m10, viewToWorld._m11, viewToWorld._m12, 0.0f,
+			viewToWorld._m20, viewToWorld._m21, viewToWorld._m22, 0.0f,
+			-( viewToWorld._m00 * viewToWorld._m03 + viewToWorld._m10 * viewToWorld._m13 + viewToWorld._m20 * viewToWorld._m23 ),
+			-( viewToWorld._m01 * viewToWorld._m03 + viewToWorld._m11 * viewToWorld._m13 + viewToWorld._m21 * viewToWorld._m23 ),
+			-( viewToWorld._m02 * viewToWorld._m03 + viewToWorld._m12 * viewToWorld._m13 + viewToWorld._m22 * viewToWorld._m23 ),
+			1.0f );
+		const float yZoom = 1.0f / std::tan( i_fieldOfViewY * 0.5f );
+		const float xZoom = yZoom / i_aspectRatio;
+		const float zDistanceScale = i_farPlane / ( i_nearPlane - i_farPlane );
+		const EAE_Engine::Math::ColMatrix44 viewToClip(
+			xZoom, 0.0f, 0.0f, 0.0f,
+			0.0f, yZoom, 0.0f, 0.0f,
+			0.0f, 0.0f, zDistanceScale, -1.0f,
+			0.0f, 0.0f, i_nearPlane * zDistanceScale, 0.0f );
+		return viewToClip * worldToView;
+	}
+
+	float GetPlaneDistance( const EAE_Engine::Math::PackedFrustum& i_frustum, uint32_t i_planeIndex, const EAE_Engine::Math::Vector3& i_point )
+	{
+		const float* plane = i_frustum._planes[i_planeIndex];
+		return plane[0] * i_point._x + plane[1] * i_point._y + plane[2] * i_point._z + plane[3];
+	}
+
+	bool IsInside( const EAE_Engine::Math::PackedFrustum& i_frustum, const EAE_Engine::Math::Vector3& i_point )
+	{
+		for ( uint32_t planeIndex = 0; planeIndex < 6; ++planeIndex )
+		{
+			if ( GetPlaneDistance( i_frustum, planeIndex, i_point ) < 0.0f )
+				return false;
+		}
+		return true;
+	}
+
+	struct sCamera
+	{
+		EAE_Engine::Math::Vector3 position;
+		EAE_Engine::Math::Vector3 forward;
+		EAE_Engine::Math::PackedFrustum frustum;
+	};
+
+	// The camera flies around the center at 30 m over the hills and looks down into the middle a little.
+	sCamera GetSweepCamera( uint32_t i_frame )
+	{
+		const float angle = 2.0f * s_pi * i_frame / s_frameCount;
+		sCamera camera;
+		camera.position = EAE_Engine::Math::Vector3( 90.0f * std::sin( angle ), 30.0f, 90.0f * std::cos( angle ) );
+		// At angle 0 the camera is on +z, so its -z already looks at the center.
+		const EAE_Engine::Math::Quaternion yaw( angle, EAE_Engine::Math::Vector3( 0.0f, 1.0f, 0.0f ) );
+		const EAE_Engine::Math::Quaternion pitch( -0.25f, EAE_Engine::Math::Vector3( 1.0f, 0.0f, 0.0f ) );
+		const EAE_Engine::Math::Quaternion rotation = yaw * pitch;
+		camera.forward = EAE_Engine::Math::Quaternion::MultiVector( rotation, EAE_Engine::Math::Vector3( 0.0f, 0.0f, -1.0f ) );
+		camera.frustum = EAE_Engine::Math::ComputeFrustum( CreateWorldToClip( rotation, camera.position, s_pi / 3.0f, 16.0f / 9.0f, 0.1f, 100.0f ) );
+		return camera;
+	}
+
+	// The leaves with triangles which may be in the frustum, each of them tested on its own with all of the planes.
+	void GetLeavesInFrustumOneByOne( EAE_Engine::Core::CompleteOctree* i_pOctree, const EAE_Engine::Math::PackedFrustum& i_frustum,
+		std::vector<EAE_Engine::Core::OctreeNode*>& o_leaves )
+	{
+		o_leaves.clear();
+		EAE_Engine::Core::OctreeNode* pLeaves = i_pOctree->GetNodesInLevel( i_pOctree->Level() - 1 );
+		const uint32_t leafCount = (uint32_t)std::pow( 8.0f, (float)( i_pOctree->Level() - 1 ) );
+		for ( uint32_t leafIndex = 0; leafIndex < leafCount; ++leafIndex )
+		{
+			EAE_Engine::Core::OctreeNode& leaf = pLeaves[leafIndex];
+			uint32_t planeMask = EAE_Engine::Math::PackedFrustum::s_allPlanes;
+			if ( leaf._triangleCount > 0 && EAE_Engine::Math::TestAABBFrustum( EAE_Engine::Math::PackedAABB( leaf.GetMin(), leaf.GetMax() ), i_frustum, planeMask ) )
+				o_leaves.push_back( &leaf );
+		}
+	}
+
+	void GetLeavesInAABBOneByOne( EAE_Engine::Core::CompleteOctree* i_pOctree, const EAE_Engine::Math::PackedAABB& i_aabb,
+		std::vector<EAE_Engine::Core::OctreeNode*>& o_leaves )
+	{
+		o_leaves.clear();
+		EAE_Engine::Core::OctreeNode* pLeaves = i_pOctree->GetNodesInLevel( i_pOctree->Level() - 1 );
+		const uint32_t leafCount = (uint32_t)std::pow( 8.0f, (float)( i_pOctree->Level() - 1 ) );
+		for ( uint32_t leafIndex = 0; leafIndex < leafCount; ++leafIndex )
+		{
+			EAE_Engine::Core::OctreeNode& leaf = pLeaves[leafIndex];
+			if ( leaf._triangleCount > 0 && EAE_Engine::Math::TestAABBAABB( EAE_Engine::Math::PackedAABB( leaf.GetMin(), leaf.GetMax() ), i_aabb ) )
+				o_leaves.push_back( &leaf );
+		}
+	}
+
+	// The queries give the leaves in the order of the tree, the same set is enough.
+	bool AreSameLeaves( std::vector<EAE_Engine::Core::OctreeNode*> i_lhs, std::vector<EAE_Engine::Core::OctreeNode*> i_rhs )
+	{
+		std::sort( i_lhs.begin(), i_lhs.end() );
+		std::sort( i_rhs.begin(), i_rhs.end() );
+		return i_lhs == i_rhs;
+	}
+
+	double GetMicroseconds( std::chrono::high_resolution_clock::time_point i_start )
+	{
+		return std::chrono::duration<double, std::micro>( std::chrono::high_resolution_clock::now() - i_start ).count();
+	}
+}
+
+// Interface
+//==========
+
+int EngineTests::RunFrustumTests()
+{
+	const int failureCountBefore = GetFailureCount();
+	std::vector<EAE_Engine::Math::Vector3> positions;
+	std::vector<uint32_t> indices;
+	CreateHeightField( positions, indices );
+
+	// The frustum has the point in front of the camera inside and the point behind it outside.
+	{
+		const sCamera camera = GetSweepCamera( 0 );
+		ENGINE_TEST_CHECK( IsInside( camera.frustum, camera.position + camera.forward * 10.0f ) );
+		ENGINE_TEST_CHECK( !IsInside( camera.frustum, camera.position - camera.forward * 10.0f ) );
+		ENGINE_TEST_CHECK( !IsInside( camera.frustum, camera.position + camera.forward * 150.0f ) );
+	}
+
+	printf( "%-6s %-13s %-8s %-10s %-10s %-10s %-10s\n", "level", "nodes tested", "leaves", "tree us", "leaves us", "box us", "leaves us" );
+	const uint32_t levels[] = { 4, 5, 6 };
+	const char* const meshKeys[] = { "FrustumHeightField4", "FrustumHeightField5", "FrustumHeightField6" };
+	for ( size_t levelIndex = 0; levelIndex < sizeof( levels ) / sizeof( levels[0] ); ++levelIndex )
+	{
+		CreateCollisionMesh( meshKeys[levelIndex], positions, indices, levels[levelIndex] );
+		EAE_Engine::Core::CompleteOctree* pOctree = EAE_Engine::Core::OctreeManager::GetInstance()->GetOctree( meshKeys[levelIndex] );
+
+		// The sweep, first checked against the leaves one by one, then timed.
+		std::vector<EAE_Engine::Core::OctreeNode*> leaves;
+		std::vector<EAE_Engine::Core::OctreeNode*> expectedLeaves;
+		uint32_t frustumMismatchCount = 0;
+		uint64_t nodeTestCount = 0;
+		uint64_t leafCount = 0;
+		std::vector<sCamera> cameras( s_frameCount );
+		for ( uint32_t frame = 0; frame < s_frameCount; ++frame )
+		{
+			cameras[frame] = GetSweepCamera( frame );
+			pOctree->GetLeavesInFrustum( cameras[frame].frustum, leaves );
+			GetLeavesInFrustumOneByOne( pOctree, cameras[frame].frustum, expectedLeaves );
+			frustumMismatchCount += AreSameLeaves( leaves, expectedLeaves ) ? 0 : 1;
+			nodeTestCount += pOctree->VisitLeavesInFrustum( cameras[frame].frustum, []( const EAE_Engine::Core::OctreeNode*, uint32_t ) { return true; } );
+			leafCount += leaves.size();
+		}
+		ENGINE_TEST_CHECK( frustumMismatchCount == 0 );
+		// The camera sees some of the hills but not all of them.
+		ENGINE_TEST_CHECK( leafCount > 0 && leafCount < (uint64_t)s_frameCount * std::pow( 8.0f, (float)( levels[levelIndex] - 1 ) ) );
+
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		for ( uint32_t frame = 0; frame < s_frameCount; ++frame )
+			pOctree->GetLeavesInFrustum( cameras[frame].frustum, leaves );
+		const double treeMicroseconds = GetMicroseconds( start ) / s_frameCount;
+		start = std::chrono::high_resolution_clock::now();
+		for ( uint32_t frame = 0; frame < s_frameCount; ++frame )
+			GetLeavesInFrustumOneByOne( pOctree, cameras[frame].frustum, expectedLeaves );
+		const double oneByOneMicroseconds = GetMicroseconds( start ) / s_frameCount;
+
+		// The random boxes, from small ones to ones over a quarter of the hills.
+		std::mt19937 random( 50 );
+		std::uniform_real_distribution<float> center( -140.0f, 140.0f );
+		std::uniform_real_distribution<float> extent( 0.5f, 60.0f );
+		std::vector<EAE_Engine::Math::PackedAABB> boxes( s_boxCount );
+		for ( uint32_t boxIndex = 0; boxIndex < s_boxCount; ++boxIndex )
+		{
+			const EAE_Engine::Math::Vector3 boxCenter( center( random ), center( random ) * 0.2f, center( random ) );
+			const EAE_Engine::Math::Vector3 boxExtent( extent( random ), extent( random ) * 0.5f, extent( random ) );
+			boxes[boxIndex] = EAE_Engine::Math::PackedAABB( boxCenter - boxExtent, boxCenter + boxExtent );
+		}
+		uint32_t boxMismatchCount = 0;
+		for ( uint32_t boxIndex = 0; boxIndex < s_boxCount; ++boxIndex )
+		{
+			pOctree->GetLeavesInAABB( boxes[boxIndex], leaves );
+			GetLeavesInAABBOneByOne( pOctree, boxes[boxIndex], expectedLeaves );
+			boxMismatchCount += AreSameLeaves( leaves, expectedLeaves ) ? 0 : 1;
+		}
+		ENGINE_TEST_CHECK( boxMismatchCount == 0 );
+		start = std::chrono::high_resolution_clock::now();
+		for ( uint32_t boxIndex = 0; boxIndex < s_boxCount; ++boxIndex )
+			pOctree->GetLeavesInAABB( boxes[boxIndex], leaves );
+		const double boxMicroseconds = GetMicroseconds( start ) / s_boxCount;
+		start = std::chrono::high_resolution_clock::now();
+		for ( uint32_t boxIndex = 0; boxIndex < s_boxCount; ++boxIndex )
+			GetLeavesInAABBOneByOne( pOctree, boxes[boxIndex], expectedLeaves );
+		const double boxOneByOneMicroseconds = GetMicroseconds( start ) / s_boxCount;
+
+		// Most of the leaves of the flat hills are empty, the test of each leaf skips those without testing a plane,
+		// the octree still tests the empty nodes above the hills.
+		printf( "%-6u %-13.0f %-8.0f %-10.2f %-10.2f %-10.2f %-10.2f\n", levels[levelIndex], (double)nodeTestCount / s_frameCount,
+			(double)leafCount / s_frameCount, treeMicroseconds, oneByOneMicroseconds, boxMicroseconds, boxOneByOneMicroseconds );
+	}
+
+	CleanScene();
+	return GetFailureCount() - failureCountBefore;
+}
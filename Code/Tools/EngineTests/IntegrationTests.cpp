@@ -0,0 +1,239 @@
+/*
+	The integrators of RigidBody on the standard scenes, at fixed steps from 1/480 to 1/4 second:
+		the spring, a force depending on the position, where the energy must not drift,
+		the resting contact, a RigidBody dropped on the ground must come to rest on it,
+		the sliding contact, a RigidBody sliding on the ground must keep its speed, and move the same in the Verlet and the Euler mode,
+		and the spin, the rotation must follow the angular velocity exactly.
+	It prints the largest stable step of each integrator in each scene.
+*/
+
+// Header Files
+//=============
+
+#include "EngineTests.h"
+
+#include <cmath>
+#include <cstdio>
+
+#include "Engine/CollisionDetection/ColliderBase.h"
+#include "Engine/CollisionDetection/MeshCollider.h"
+#include "Engine/CollisionDetection/RigidBody.h"
+#include "Engine/Time/Time.h"
+
+// Helper Definitions
+//===================
+
+namespace
+{
+	const float s_pi = 3.14159265f;
+	// The spring of 1 Hz on a RigidBody of 1 kg, pulled 1 m away from its rest.
+	const float s_springStiffness = 4.0f * s_pi * s_pi;
+	const float s_springDuration = 20.0f;
+	// The spring is stable while its energy stays within 10% of the start.
+	const float s_maxEnergyError = 0.1f;
+	const float s_restDuration = 3.0f;
+	// The RigidBody rests when it is this close to the ground and this slow over the last second.
+	const float s_maxRestDistance = 0.05f;
+	const float s_maxRestSpeed = 0.1f;
+	const float s_slideDuration = 3.0f;
+	const float s_slideSpeed = 3.0f;
+	const float s_spinDuration = 20.0f;
+
+	const float s_steps[] = { 1.0f / 480.0f, 1.0f / 240.0f, 1.0f / 120.0f, 1.0f / 60.0f, 1.0f / 30.0f,
+		1.0f / 20.0f, 1.0f / 15.0f, 1.0f / 10.0f, 1.0f / 8.0f, 1.0f / 6.0f, 1.0f / 5.0f, 1.0f / 4.0f };
+	const size_t s_stepCount = sizeof( s_steps ) / sizeof( s_steps[0] );
+
+	struct sIntegrator
+	{
+		const char* name;
+		EAE_Engine::Common::IntegrationMode mode;
+	};
+
+	const sIntegrator s_integrators[] =
+	{
+		{ "Euler", EAE_Engine::Common::IntegrationMode::Euler },
+		{ "SemiImplicitEuler", EAE_Engine::Common::IntegrationMode::SemiImplicitEuler },
+		{ "Verlet", EAE_Engine::Common::IntegrationMode::Verlet },
+	};
+	const size_t s_integratorCount = sizeof( s_integrators ) / sizeof( s_integrators[0] );
+
+	struct sScene
+	{
+		EngineTests::TestTransform transform;
+		EAE_Engine::Physics::RigidBodyManager rigidBodyManager;
+		EAE_Engine::Physics::RigidBody* pRigidBody;
+
+		sScene( const EAE_Engine::Math::Vector3& i_pos, EAE_Engine::Common::IntegrationMode i_mode, bool i_useGravity ) :
+			transform( i_pos )
+		{
+			pRigidBody = rigidBodyManager.AddRigidBody( &transform );
+			transform.AddComponent( { pRigidBody, pRigidBody->GetTypeID() } );
+			pRigidBody->SetPos( i_pos );
+			pRigidBody->SetUseGravity( i_useGravity );
+			pRigidBody->SetIntegrationMode( i_mode );
+		}
+
+		void Step()
+		{
+			rigidBodyManager.FixedUpdateBegin();
+			rigidBodyManager.FixedUpdate();
+			rigidBodyManager.FixedUpdateEnd();
+		}
+	};
+
+	// Returns the largest error of the energy relative to the start.
+	float RunSpring( EAE_Engine::Common::IntegrationMode i_mode, float i_fixedTimeStep )
+	{
+		sScene scene( EAE_Engine::Math::Vector3( 1.0f, 0.0f, 0.0f ), i_mode, false );
+		const float startEnergy = 0.5f * s_springStiffness;
+		float maxError = 0.0f;
+		const uint32_t stepCount = (uint32_t)( s_springDuration / i_fixedTimeStep );
+		for ( uint32_t step = 0; step < stepCount; ++step )
+		{
+			EAE_Engine::Math::Vector3 force = scene.pRigidBody->GetPos() * -s_springStiffness;
+			scene.pRigidBody->AddForce( force );
+			scene.Step();
+			const EAE_Engine::Math::Vector3 pos = scene.pRigidBody->GetPos();
+			const EAE_Engine::Math::Vector3 velocity = scene.pRigidBody->GetVelocity();
+			const float energy = 0.5f * velocity.SqMagnitude() + 0.5f * s_springStiffness * pos.SqMagnitude();
+			const float error = std::fabs( energy / startEnergy - 1.0f );
+			maxError = error > maxError ? error : maxError;
+			// Blown up, no need to go on.
+			if ( maxError > 1000.0f )
+				break;
+		}
+		return maxError;
+	}
+
+	// Returns true when the RigidBody dropped from 1 m rests on the ground y = 0 during the last second.
+	bool RunRest( EAE_Engine::Common::IntegrationMode i_mode, float i_fixedTimeStep, float& o_maxSpeed )
+	{
+		sScene scene( EAE_Engine::Math::Vector3( 0.0f, 1.0f, 0.0f ), i_mode, true );
+		const uint32_t stepCount = (uint32_t)( s_restDuration / i_fixedTimeStep );
+		const uint32_t lastSecondStart = stepCount - (uint32_t)( 1.0f / i_fixedTimeStep );
+		bool rests = true;
+		o_maxSpeed = 0.0f;
+		for ( uint32_t step = 0; step < stepCount; ++step )
+		{
+			scene.Step();
+			if ( step < lastSecondStart )
+				continue;
+			const float speed = std::sqrt( scene.pRigidBody->GetVelocity().SqMagnitude() );
+			o_maxSpeed = speed > o_maxSpeed ? speed : o_maxSpeed;
+			rests = rests && std::fabs( scene.pRigidBody->GetPos()._y ) < s_maxRestDistance && speed < s_maxRestSpeed;
+		}
+		return rests;
+	}
+
+	// Returns how far the RigidBody sliding on the ground ends from where it would slide without friction,
+	// and the largest distance between it in i_mode and in the Euler mode.
+	float RunSlide( EAE_Engine::Common::IntegrationMode i_mode, float i_fixedTimeStep, float& o_maxEulerDistance )
+	{
+		const EAE_Engine::Math::Vector3 start( -8.0f, 0.0f, 0.0f );
+		sScene scene( start, i_mode, true );
+		sScene eulerScene( start, EAE_Engine::Common::IntegrationMode::Euler, true );
+		scene.pRigidBody->SetVelocity( EAE_Engine::Math::Vector3( s_slideSpeed, 0.0f, 0.0f ) );
+		eulerScene.pRigidBody->SetVelocity( EAE_Engine::Math::Vector3( s_slideSpeed, 0.0f, 0.0f ) );
+		const uint32_t stepCount = (uint32_t)( s_slideDuration / i_fixedTimeStep );
+		o_maxEulerDistance = 0.0f;
+		for ( uint32_t step = 0; step < stepCount; ++step )
+		{
+			scene.Step();
+			eulerScene.Step();
+			const float distance = std::sqrt( ( scene.pRigidBody->GetPos() - eulerScene.pRigidBody->GetPos() ).SqMagnitude() );
+			o_maxEulerDistance = distance > o_maxEulerDistance ? distance : o_maxEulerDistance;
+		}
+		return std::fabs( scene.pRigidBody->GetPos()._x - ( start._x + s_slideSpeed * i_fixedTimeStep * stepCount ) );
+	}
+
+	// Returns the angle between the rotation of the RigidBody and the exact one.
+	float RunSpin( EAE_Engine::Common::IntegrationMode i_mode, float i_fixedTimeStep )
+	{
+		sScene scene( EAE_Engine::Math::Vector3::Zero, i_mode, false );
+		const EAE_Engine::Math::Vector3 axis = EAE_Engine::Math::Vector3( 1.0f, 2.0f, 2.0f ) * ( 1.0f / 3.0f );
+		const float angularSpeed = 3.0f;
+		scene.pRigidBody->SetAngularVelocity( axis * angularSpeed );
+		const uint32_t stepCount = (uint32_t)( s_spinDuration / i_fixedTimeStep );
+		for ( uint32_t step = 0; step < stepCount; ++step )
+			scene.Step();
+		// The angle in double, the float one is off by more than the error of the spin after many turns.
+		const double angle = std::fmod( (double)angularSpeed * (double)i_fixedTimeStep * stepCount, 2.0 * 3.14159265358979323846 );
+		const EAE_Engine::Math::Quaternion exact( (float)angle, axis );
+		const float dot = std::fabs( EAE_Engine::Math::Dot( exact, scene.pRigidBody->GetRotation() ) );
+		return 2.0f * std::acos( dot < 1.0f ? dot : 1.0f );
+	}
+}
+
+// Interface
+//==========
+
+int EngineTests::RunIntegrationTests()
+{
+	const int failureCountBefore = GetFailureCount();
+	const float defaultFixedTimeStep = EAE_Engine::Time::GetFixedTimeStep();
+	std::vector<EAE_Engine::Math::Vector3> positions;
+	positions.push_back( EAE_Engine::Math::Vector3( -10.0f, 0.0f, -10.0f ) );
+	positions.push_back( EAE_Engine::Math::Vector3( -10.0f, 0.0f, 10.0f ) );
+	positions.push_back( EAE_Engine::Math::Vector3( 10.0f, 0.0f, 10.0f ) );
+	positions.push_back( EAE_Engine::Math::Vector3( 10.0f, 0.0f, -10.0f ) );
+	const uint32_t indices[] = { 0, 1, 2, 0, 2, 3 };
+	CreateCollisionMesh( "IntegrationGround", positions, std::vector<uint32_t>( indices, indices + sizeof( indices ) / sizeof( indices[0] ) ), 2 );
+	TestTransform groundTransform;
+	EAE_Engine::Collider::MeshCollider* pGroundCollider = new EAE_Engine::Collider::MeshCollider( &groundTransform );
+	pGroundCollider->Init( "IntegrationGround" );
+	EAE_Engine::Collider::ColliderManager::GetInstance()->AddToColliderList( pGroundCollider );
+
+	float largestSpringSteps[s_integratorCount];
+	float largestRestSteps[s_integratorCount];
+	printf( "%-18s %-10s %-14s %-14s %-14s %-12s\n", "integrator", "step", "spring error", "rest speed", "slide error", "spin error" );
+	for ( size_t integratorIndex = 0; integratorIndex < s_integratorCount; ++integratorIndex )
+	{
+		const sIntegrator& integrator = s_integrators[integratorIndex];
+		largestSpringSteps[integratorIndex] = 0.0f;
+		largestRestSteps[integratorIndex] = 0.0f;
+		// A larger step than an unstable one doesn't count, so stop at the first failure.
+		bool springStable = true;
+		bool restStable = true;
+		for ( size_t stepIndex = 0; stepIndex < s_stepCount; ++stepIndex )
+		{
+			const float fixedTimeStep = s_steps[stepIndex];
+			EAE_Engine::Time::SetFixedTimeStep( fixedTimeStep );
+			const float springError = RunSpring( integrator.mode, fixedTimeStep );
+			float restSpeed;
+			const bool rests = RunRest( integrator.mode, fixedTimeStep, restSpeed );
+			float maxEulerDistance;
+			const float slideError = RunSlide( integrator.mode, fixedTimeStep, maxEulerDistance );
+			const float spinError = RunSpin( integrator.mode, fixedTimeStep );
+			springStable = springStable && springError < s_maxEnergyError;
+			restStable = restStable && rests;
+			if ( springStable )
+				largestSpringSteps[integratorIndex] = fixedTimeStep;
+			if ( restStable )
+				largestRestSteps[integratorIndex] = fixedTimeStep;
+			// The ground takes away the whole gravity, so nothing slows down the slide.
+			ENGINE_TEST_CHECK( slideError < 0.01f );
+			// Under a constant force the Verlet mode moves exactly like the Euler mode, the ground must not change that.
+			if ( integrator.mode == EAE_Engine::Common::IntegrationMode::Verlet )
+				ENGINE_TEST_CHECK( maxEulerDistance < 1.0e-4f );
+			// The spin doesn't depend on the forces, so it is exact at any step.
+			ENGINE_TEST_CHECK( spinError < 1.0e-3f );
+			printf( "%-18s 1/%-8.0f %-14g %-14g %-14g %-12g\n", integrator.name, 1.0f / fixedTimeStep, springError, restSpeed, slideError, spinError );
+		}
+	}
+	EAE_Engine::Time::SetFixedTimeStep( defaultFixedTimeStep );
+	for ( size_t integratorIndex = 0; integratorIndex < s_integratorCount; ++integratorIndex )
+	{
+		// 0 when even the smallest step isn't stable.
+		printf( "%-18s largest stable step: spring %.4f s, rest %.4f s\n", s_integrators[integratorIndex].name,
+			largestSpringSteps[integratorIndex], largestRestSteps[integratorIndex] );
+	}
+	// The symplectic integrators must hold the spring at the default step, and do better than the Euler mode.
+	ENGINE_TEST_CHECK( largestSpringSteps[1] >= defaultFixedTimeStep && largestSpringSteps[2] >= defaultFixedTimeStep );
+	ENGINE_TEST_CHECK( largestSpringSteps[1] > largestSpringSteps[0] && largestSpringSteps[2] > largestSpringSteps[0] );
+	// All of them must rest on the ground at the default step.
+	for ( size_t integratorIndex = 0; integratorIndex < s_integratorCount; ++integratorIndex )
+		ENGINE_TEST_CHECK( largestRestSteps[integratorIndex] >= defaultFixedTimeStep );
+
+	CleanScene();
+	return GetFailureCount() - failureCountBefore;
+}
@@ -0,0 +1,242 @@
+/*
+	The WorkerPool and the islands of the RigidBodyManager advancing on it:
+	each Run must call every task exactly once with a worker index in range, with any count of tasks and workers,
+	and 1024 spheres falling in 64 clusters on the ground and on the static boxes, with a few boxes tumbling among them,
+	must end in the same state, bit for bit, and find the same islands in each step with any count of workers.
+	It prints the islands, the awake RigidBodys and the ms per step with each count of workers.
+*/
+
+// Header Files
+//=============
+
+#include "EngineTests.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <thread>
+
+#include "Engine/CollisionDetection/ColliderBase.h"
+#include "Engine/CollisionDetection/MeshCollider.h"
+#include "Engine/CollisionDetection/OBBCollider.h"
+#include "Engine/CollisionDetection/RigidBody.h"
+#include "Engine/General/WorkerPool.h"
+
+// Helper Definitions
+//===================
+
+namespace
+{
+	const uint32_t s_clusterSide = 8;
+	const uint32_t s_spheresPerCluster = 16;
+	const uint32_t s_tumblingBoxCount = 8;
+	const uint32_t s_obstacleCount = 16;
+	const float s_clusterSpacing = 12.0f;
+	const uint32_t s_stepCount = 150;
+
+	std::vector<uint32_t> GetWorkerCounts()
+	{
+		// Up to 4 workers at least, so the split is tested on a machine with fewer cores too.
+		const uint32_t hardwareCount = std::max( 1u, std::thread::hardware_concurrency() );
+		std::vector<uint32_t> workerCounts;
+		for ( uint32_t workerCount = 1; workerCount < std::max( 4u, hardwareCount ); workerCount *= 2 )
+			workerCounts.push_back( workerCount );
+		workerCounts.push_back( std::max( 4u, hardwareCount ) );
+		return workerCounts;
+	}
+
+	double GetMilliseconds( std::chrono::high_resolution_clock::time_point i_start )
+	{
+		return std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - i_start ).count();
+	}
+
+	void TestWorkerPool()
+	{
+		const uint32_t taskCounts[] = { 0, 1, 3, 64, 1000 };
+		const std::vector<uint32_t> workerCounts = GetWorkerCounts();
+		EAE_Engine::WorkerPool workerPool;
+		for ( size_t countIndex = 0; countIndex < workerCounts.size(); ++countIndex )
+		{
+			workerPool.SetWorkerCount( workerCounts[countIndex] );
+			ENGINE_TEST_CHECK( workerPool.GetWorkerCount() == workerCounts[countIndex] );
+			for ( size_t taskCountIndex = 0; taskCountIndex < sizeof( taskCounts ) / sizeof( taskCounts[0] ); ++taskCountIndex )
+			{
+				const uint32_t taskCount = taskCounts[taskCountIndex];
+				// The same pool runs many jobs in a row, each of them waits for all of its tasks.
+				for ( uint32_t repeat = 0; repeat < 20; ++repeat )
+				{
+					std::unique_ptr<std::atomic<uint32_t>[]> calls( new std::atomic<uint32_t>[taskCount + 1] );
+					for ( uint32_t taskIndex = 0; taskIndex <= taskCount; ++taskIndex )
+						calls[taskIndex].store( 0 );
+					std::atomic<uint32_t> badWorkerCount( 0 );
+					const uint32_t workerCount = workerPool.GetWorkerCount();
+					workerPool.Run( taskCount, [&calls, &badWorkerCount, workerCount]( uint32_t i_taskIndex, uint32_t i_workerIndex )
+					{
+						calls[i_taskIndex].fetch_add( 1 );
+						if ( i_workerIndex >= workerCount )
+							badWorkerCount.fetch_add( 1 );
+					} );
+					uint32_t wrongCallCount = 0;
+					for ( uint32_t taskIndex = 0; taskIndex < taskCount; ++taskIndex )
+						wrongCallCount += calls[taskIndex].load() == 1 ? 0 : 1;
+					ENGINE_TEST_CHECK( wrongCallCount == 0 );
+					ENGINE_TEST_CHECK( badWorkerCount.load() == 0 );
+				}
+			}
+		}
+		workerPool.SetWorkerCount( 0 );
+		ENGINE_TEST_CHECK( workerPool.GetWorkerCount() == 1 );
+	}
+
+	struct sScene
+	{
+		std::vector<EngineTests::TestTransform> transforms;
+		EAE_Engine::Physics::RigidBodyManager rigidBodyManager;
+
+		explicit sScene( uint32_t i_workerCount )
+		{
+			const uint32_t sphereCount = s_clusterSide * s_clusterSide * s_spheresPerCluster;
+			// The RigidBodys and the OBBColliders keep the addresses of their Transforms.
+			transforms.reserve( sphereCount + s_tumblingBoxCount );
+			rigidBodyManager.SetWorkerCount( i_workerCount );
+			std::mt19937 generator( 35 );
+			std::uniform_real_distribution<float> unit( -1.0f, 1.0f );
+			const float half = ( s_clusterSide - 1 ) * s_clusterSpacing * 0.5f;
+			for ( uint32_t sphereIndex = 0; sphereIndex < sphereCount; ++sphereIndex )
+			{
+				const uint32_t clusterIndex = sphereIndex / s_spheresPerCluster;
+				const EAE_Engine::Math::Vector3 clusterCenter( ( clusterIndex % s_clusterSide ) * s_clusterSpacing - half, 4.0f, ( clusterIndex / s_clusterSide ) * s_clusterSpacing - half );
+				transforms.push_back( EngineTests::TestTransform( clusterCenter + EAE_Engine::Math::Vector3( unit( generator ) * 2.0f, unit( generator ) * 2.0f, unit( generator ) * 2.0f ) ) );
+				EngineTests::TestTransform& transform = transforms.back();
+				EAE_Engine::Physics::RigidBody* pRigidBody = rigidBodyManager.AddRigidBody( &transform );
+				transform.AddComponent( { pRigidBody, pRigidBody->GetTypeID() } );
+				pRigidBody->SetPos( transform.GetPos() );
+				pRigidBody->SetVelocity( EAE_Engine::Math::Vector3( unit( generator ) * 3.0f, unit( generator ) * 3.0f, unit( generator ) * 3.0f ) );
+				pRigidBody->SetAngularVelocity( EAE_Engine::Math::Vector3( unit( generator ), unit( generator ), unit( generator ) ) );
+				pRigidBody->SetRadius( 0.3f );
+				pRigidBody->SetRestitution( 0.5f );
+				pRigidBody->SetCollisionDetectionMode( EAE_Engine::Common::CollisionDetectionMode::Continuous );
+			}
+			// The boxes are solved by the ContactSolver on the calling thread, after the islands.
+			for ( uint32_t boxIndex = 0; boxIndex < s_tumblingBoxCount; ++boxIndex )
+			{
+				const EAE_Engine::Math::Vector3 pos( unit( generator ) * half, 3.0f, unit( generator ) * half );
+				transforms.push_back( EngineTests::TestTransform( pos ) );
+				EngineTests::TestTransform& transform = transforms.back();
+				EAE_Engine::Physics::RigidBody* pRigidBody = rigidBodyManager.AddRigidBody( &transform );
+				transform.AddComponent( { pRigidBody, pRigidBody->GetTypeID() } );
+				pRigidBody->SetPos( pos );
+				pRigidBody->SetVelocity( EAE_Engine::Math::Vector3( unit( generator ) * 2.0f, 0.0f, unit( generator ) * 2.0f ) );
+				pRigidBody->SetAngularVelocity( EAE_Engine::Math::Vector3( unit( generator ) * 3.0f, unit( generator ) * 3.0f, unit( generator ) * 3.0f ) );
+				EAE_Engine::Collider::OBBCollider* pCollider = static_cast<EAE_Engine::Collider::OBBCollider*>(
+					EAE_Engine::Collider::CreateOBBCollider( &transform, EAE_Engine::Math::Vector3( 1.0f, 1.0f, 1.0f ) ) );
+				pRigidBody->SetBoxCollider( pCollider );
+			}
+		}
+
+		~sScene()
+		{
+			// The next scene starts without these boxes.
+			EAE_Engine::Collider::ColliderManager* pColliderManager = EAE_Engine::Collider::ColliderManager::GetInstance();
+			for ( size_t transformIndex = 0; transformIndex < transforms.size(); ++transformIndex )
+				pColliderManager->Remove( &transforms[transformIndex] );
+		}
+	};
+
+	struct sRunResult
+	{
+		uint32_t stateHash;
+		std::vector<EAE_Engine::Math::Vector3> positions;
+		std::vector<uint32_t> islandCounts;
+		uint32_t awakeCount;
+		double milliseconds;
+	};
+
+	sRunResult Run( uint32_t i_workerCount )
+	{
+		sRunResult result;
+		sScene scene( i_workerCount );
+		const std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		for ( uint32_t step = 0; step < s_stepCount; ++step )
+		{
+			scene.rigidBodyManager.FixedUpdateBegin();
+			scene.rigidBodyManager.FixedUpdate();
+			scene.rigidBodyManager.FixedUpdateEnd();
+			result.islandCounts.push_back( scene.rigidBodyManager.GetIslandCount() );
+		}
+		result.milliseconds = GetMilliseconds( start );
+		result.stateHash = scene.rigidBodyManager.GetStateHash();
+		result.awakeCount = scene.rigidBodyManager.GetAwakeCount();
+		for ( size_t transformIndex = 0; transformIndex < scene.transforms.size(); ++transformIndex )
+			result.positions.push_back( scene.transforms[transformIndex].GetPos() );
+		return result;
+	}
+
+	bool AreSamePositions( const std::vector<EAE_Engine::Math::Vector3>& i_lhs, const std::vector<EAE_Engine::Math::Vector3>& i_rhs )
+	{
+		// Vector3 == allows a few ulps, the positions must be the same bits.
+		return i_lhs.size() == i_rhs.size() && ( i_lhs.empty() || memcmp( &i_lhs[0], &i_rhs[0], sizeof( i_lhs[0] ) * i_lhs.size() ) == 0 );
+	}
+}
+
+// Interface
+//==========
+
+int EngineTests::RunIslandTests()
+{
+	const int failureCountBefore = GetFailureCount();
+	TestWorkerPool();
+
+	// The ground, and the static boxes the spheres bounce off on their way down.
+	std::vector<EAE_Engine::Math::Vector3> positions;
+	positions.push_back( EAE_Engine::Math::Vector3( -60.0f, 0.0f, -60.0f ) );
+	positions.push_back( EAE_Engine::Math::Vector3( -60.0f, 0.0f, 60.0f ) );
+	positions.push_back( EAE_Engine::Math::Vector3( 60.0f, 0.0f, 60.0f ) );
+	positions.push_back( EAE_Engine::Math::Vector3( 60.0f, 0.0f, -60.0f ) );
+	const uint32_t indices[] = { 0, 1, 2, 0, 2, 3 };
+	CreateCollisionMesh( "IslandGround", positions, std::vector<uint32_t>( indices, indices + sizeof( indices ) / sizeof( indices[0] ) ), 3 );
+	TestTransform groundTransform;
+	EAE_Engine::Collider::MeshCollider* pGroundCollider = new EAE_Engine::Collider::MeshCollider( &groundTransform );
+	pGroundCollider->Init( "IslandGround" );
+	EAE_Engine::Collider::ColliderManager::GetInstance()->AddToColliderList( pGroundCollider );
+	std::vector<TestTransform> obstacleTransforms;
+	obstacleTransforms.reserve( s_obstacleCount );
+	const float half = ( s_clusterSide - 1 ) * s_clusterSpacing * 0.5f;
+	for ( uint32_t obstacleIndex = 0; obstacleIndex < s_obstacleCount; ++obstacleIndex )
+	{
+		const uint32_t clusterIndex = obstacleIndex * 4 + 1;
+		obstacleTransforms.push_back( TestTransform( EAE_Engine::Math::Vector3( ( clusterIndex % s_clusterSide ) * s_clusterSpacing - half, 1.0f,
+			( clusterIndex / s_clusterSide ) * s_clusterSpacing - half ) ) );
+		EAE_Engine::Collider::CreateOBBCollider( &obstacleTransforms.back(), EAE_Engine::Math::Vector3( 3.0f, 0.5f, 3.0f ) );
+	}
+
+	const std::vector<uint32_t> workerCounts = GetWorkerCounts();
+	std::vector<sRunResult> results;
+	for ( size_t countIndex = 0; countIndex < workerCounts.size(); ++countIndex )
+		results.push_back( Run( workerCounts[countIndex] ) );
+	// Again on 1 worker, the scene doesn't depend on anything left by the last run.
+	const sRunResult rerun = Run( 1 );
+	ENGINE_TEST_CHECK( rerun.stateHash == results[0].stateHash );
+	ENGINE_TEST_CHECK( AreSamePositions( rerun.positions, results[0].positions ) );
+	// The clusters fall apart into many islands, so there is work to split.
+	ENGINE_TEST_CHECK( *std::max_element( results[0].islandCounts.begin(), results[0].islandCounts.end() ) >= s_clusterSide * s_clusterSide );
+
+	printf( "%u spheres in %u clusters, %u boxes, %u steps, %u hardware threads\n", s_clusterSide * s_clusterSide * s_spheresPerCluster,
+		s_clusterSide * s_clusterSide, s_tumblingBoxCount, s_stepCount, std::thread::hardware_concurrency() );
+	printf( "%-8s %-14s %-10s %-12s %-10s %s\n", "workers", "max islands", "awake", "ms per step", "speed up", "state hash" );
+	for ( size_t countIndex = 0; countIndex < results.size(); ++countIndex )
+	{
+		const sRunResult& result = results[countIndex];
+		ENGINE_TEST_CHECK( result.stateHash == results[0].stateHash );
+		ENGINE_TEST_CHECK( AreSamePositions( result.positions, results[0].positions ) );
+		ENGINE_TEST_CHECK( result.islandCounts == results[0].islandCounts );
+		printf( "%-8u %-14u %-10u %-12.3f %-10.2f 0x%08x\n", workerCounts[countIndex], *std::max_element( result.islandCounts.begin(), result.islandCounts.end() ),
+			result.awakeCount, result.milliseconds / s_stepCount, results[0].milliseconds / result.milliseconds, result.stateHash );
+	}
+	CleanScene();
+	return GetFailureCount() - failureCountBefore;
+}
@@ -0,0 +1,419 @@
+/*
+	The LooseOctree of the moving objects and the named trees of the OctreeManager:
+	20k boxes of many sizes move, teleport, leave the bounds and come back, and some of them are removed and inserted again,
+	and after every round the lists and counts must be valid and the box, sphere and frustum queries
+	must find the same objects as testing every box.
+	The OctreeManager must find each of its LooseOctrees and CompleteOctrees by its name.
+	It prints the time to insert, to move all of the objects in a frame and of each query, next to testing every box.
+*/
+
+// Header Files
+//=============
+
+#include "EngineTests.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+#include "Engine/Math/ColMatrix.h"
+#include "Engine/Math/Quaternion.h"
+#include "Engine/Math/SIMDGeometry.h"
+#include "Engine/SpatialPartition/LooseOctree.h"
+#include "Engine/SpatialPartition/Octree.h"
+
+// Helper Definitions
+//===================
+
+namespace
+{
+	const uint32_t s_objectCount = 20000;
+	const float s_worldExtent = 100.0f;
+	const uint32_t s_maxDepth = 4;
+	const uint32_t s_roundCount = 30;
+	const uint32_t s_churnCount = 50;
+	const uint32_t s_queryCount = 1000;
+	const float s_pi = 3.14159265f;
+
+	double GetMilliseconds( std::chrono::high_resolution_clock::time_point i_start )
+	{
+		return std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - i_start ).count();
+	}
+
+	// The world to clip matrix of Camera on D3D, whose clip z is in [0, w] like ComputeFrustum wants.
+	// The camera looks along its -z.
+	EAE_Engine::Math::ColMatrix44 CreateWorldToClip( const EAE_Engine::Math::Quaternion& i_rotation, const EAE_Engine::Math::Vector3& i_position,
+		float i_fieldOfViewY, float i_aspectRatio, float i_nearPlane, float i_farPlane )
+	{
+		const EAE_Engine::Math::ColMatrix44 viewToWorld( i_rotation, i_position );
+		const EAE_Engine::Math::ColMatrix44 worldToView(
+			viewToWorld._m00, viewToWorld._m01, viewToWorld._m02, 0.0f,
+			viewToWorld._m10, viewToWorld._m11, viewToWorld._m12, 0.0f,
+			viewToWorld._m20, viewToWorld._m21, viewToWorld._m22, 0.0f,
+			-( viewToWorld._m00 * viewToWorld._m03 + viewToWorld._m10 * viewToWorld._m13 + viewToWorld._m20 * viewToWorld._m23 ),
+			-( viewToWorld._m01 * viewToWorld._m03 + viewToWorld._m11 * viewToWorld._m13 + viewToWorld._m21 * viewToWorld._m23 ),
+			-( viewToWorld._m02 * viewToWorld._m03 + viewToWorld._m12 * viewToWorld._m13 + viewToWorld._m22 * viewToWorld._m23 ),
+			1.0f );
+		const float yZoom = 1.0f / std::tan( i_fieldOfViewY * 0.5f );
+		const float xZoom = yZoom / i_aspectRatio;
+		const float zDistanceScale = i_farPlane / ( i_nearPlane - i_farPlane );
+		const EAE_Engine::Math::ColMatrix44 viewToClip(
+			xZoom, 0.0f, 0.0f, 0.0f,
+			0.0f, yZoom, 0.0f, 0.0f,
+			0.0f, 0.0f, zDistanceScale, -1.0f,
+			0.0f, 0.0f, i_nearPlane * zDistanceScale, 0.0f );
+		return viewToClip * worldToView;
+	}
+
+	struct sObject
+	{
+		EAE_Engine::Math::Vector3 position;
+		EAE_Engine::Math::Vector3 velocity;
+		EAE_Engine::Math::Vector3 extents;
+		// LooseOctree::s_invalid when the object has been removed.
+		uint32_t id;
+	};
+
+	class cWorld
+	{
+	public:
+		explicit cWorld( EAE_Engine::Core::LooseOctree& io_octree ) : _octree( io_octree ), _generator( 44 ) {}
+
+		EAE_Engine::Math::Vector3 GetRandomPosition( float i_extent )
+		{
+			std::uniform_real_distribution<float> across( -i_extent, i_extent );
+			return EAE_Engine::Math::Vector3( across( _generator ), across( _generator ), across( _generator ) );
+		}
+
+		// Most of the objects are small, a few are as large as the nodes near the root.
+		EAE_Engine::Math::Vector3 GetRandomExtents()
+		{
+			std::uniform_real_distribution<float> unit( 0.0f, 1.0f );
+			const float scale = unit( _generator ) < 0.02f ? 30.0f : ( unit( _generator ) < 0.2f ? 4.0f : 0.8f );
+			return EAE_Engine::Math::Vector3( 0.1f + unit( _generator ) * scale, 0.1f + unit( _generator ) * scale, 0.1f + unit( _generator ) * scale );
+		}
+
+		void Insert( size_t i_index )
+		{
+			sObject& object = objects[i_index];
+			object.id = _octree.Insert( GetAABB( object ), &object );
+			if ( ids.size() <= object.id )
+				ids.resize( object.id + 1, 0xffffffff );
+			ids[object.id] = (uint32_t)i_index;
+		}
+
+		void AddObjects( uint32_t i_count )
+		{
+			objects.resize( i_count );
+			for ( uint32_t index = 0; index < i_count; ++index )
+			{
+				sObject& object = objects[index];
+				object.position = GetRandomPosition( s_worldExtent );
+				object.velocity = GetRandomPosition( 0.3f );
+				object.extents = GetRandomExtents();
+				Insert( index );
+			}
+		}
+
+		// Move every object, they bounce a little out of the bounds, so some of them are in the root for a while.
+		// Returns the count of the objects which have moved to another node.
+		uint32_t Move()
+		{
+			uint32_t relinkCount = 0;
+			for ( size_t index = 0; index < objects.size(); ++index )
+			{
+				sObject& object = objects[index];
+				if ( object.id == EAE_Engine::Core::LooseOctree::s_invalid )
+					continue;
+				object.position = object.position + object.velocity;
+				for ( size_t axis = 0; axis < 3; ++axis )
+				{
+					if ( std::fabs( object.position._u[axis] ) > s_worldExtent * 1.1f )
+						object.velocity._u[axis] = -object.velocity._u[axis];
+				}
+				relinkCount += _octree.Update( object.id, GetAABB( object ) ) ? 1 : 0;
+			}
+			return relinkCount;
+		}
+
+		// Teleport, remove and insert a few of them, the removed ids are reused.
+		void Churn()
+		{
+			std::uniform_int_distribution<size_t> pick( 0, objects.size() - 1 );
+			for ( uint32_t count = 0; count < s_churnCount; ++count )
+			{
+				sObject& teleported = objects[pick( _generator )];
+				if ( teleported.id == EAE_Engine::Core::LooseOctree::s_invalid )
+					continue;
+				teleported.position = GetRandomPosition( s_worldExtent );
+				_octree.Update( teleported.id, GetAABB( teleported ) );
+			}
+			std::vector<size_t> removed;
+			for ( uint32_t count = 0; count < s_churnCount; ++count )
+			{
+				const size_t index = pick( _generator );
+				if ( objects[index].id == EAE_Engine::Core::LooseOctree::s_invalid )
+					continue;
+				_octree.Remove( objects[index].id );
+				ids[objects[index].id] = 0xffffffff;
+				objects[index].id = EAE_Engine::Core::LooseOctree::s_invalid;
+				removed.push_back( index );
+			}
+			// Half of them come back somewhere else with another size.
+			for ( size_t removedIndex = 0; removedIndex < removed.size(); removedIndex += 2 )
+			{
+				sObject& object = objects[removed[removedIndex]];
+				object.position = GetRandomPosition( s_worldExtent );
+				object.extents = GetRandomExtents();
+				Insert( removed[removedIndex] );
+			}
+		}
+
+		uint32_t GetLiveCount() const
+		{
+			uint32_t count = 0;
+			for ( size_t index = 0; index < objects.size(); ++index )
+				count += objects[index].id == EAE_Engine::Core::LooseOctree::s_invalid ? 0 : 1;
+			return count;
+		}
+
+		// The ids of the objects which pass i_test, testing every one of them.
+		template<typename Test>
+		void BruteForce( Test i_test, std::vector<uint32_t>& o_ids ) const
+		{
+			o_ids.clear();
+			for ( size_t index = 0; index < objects.size(); ++index )
+			{
+				const sObject& object = objects[index];
+				if ( object.id != EAE_Engine::Core::LooseOctree::s_invalid && i_test( GetAABB( object ) ) )
+					o_ids.push_back( object.id );
+			}
+		}
+
+		static EAE_Engine::Math::PackedAABB GetAABB( const sObject& i_object )
+		{
+			return EAE_Engine::Math::PackedAABB( i_object.position - i_object.extents, i_object.position + i_object.extents );
+		}
+
+		std::vector<sObject> objects;
+		// The index in objects of each id of the LooseOctree.
+		std::vector<uint32_t> ids;
+
+	private:
+		EAE_Engine::Core::LooseOctree& _octree;
+		std::mt19937 _generator;
+	};
+
+	bool IsSameIds( std::vector<uint32_t>& io_found, std::vector<uint32_t>& io_expected )
+	{
+		std::sort( io_found.begin(), io_found.end() );
+		std::sort( io_expected.begin(), io_expected.end() );
+		return io_found == io_expected;
+	}
+
+	EAE_Engine::Math::PackedFrustum GetRandomFrustum( std::mt19937& io_generator )
+	{
+		std::uniform_real_distribution<float> unit( 0.0f, 1.0f );
+		const float yaw = unit( io_generator ) * 2.0f * s_pi;
+		const float pitch = ( unit( io_generator ) - 0.5f ) * s_pi * 0.5f;
+		const EAE_Engine::Math::Quaternion rotation = EAE_Engine::Math::Quaternion( yaw, EAE_Engine::Math::Vector3( 0.0f, 1.0f, 0.0f ) ) *
+			EAE_Engine::Math::Quaternion( pitch, EAE_Engine::Math::Vector3( 1.0f, 0.0f, 0.0f ) );
+		const EAE_Engine::Math::Vector3 position( ( unit( io_generator ) - 0.5f ) * s_worldExtent, ( unit( io_generator ) - 0.5f ) * s_worldExtent,
+			( unit( io_generator ) - 0.5f ) * s_worldExtent );
+		return EAE_Engine::Math::ComputeFrustum( CreateWorldToClip( rotation, position, s_pi / 3.0f, 16.0f / 9.0f, 0.1f, 80.0f ) );
+	}
+
+	// The box, sphere and frustum queries against testing every object, returns the count of the queries which differ.
+	uint32_t CompareQueries( const EAE_Engine::Core::LooseOctree& i_octree, cWorld& io_world, std::mt19937& io_generator,
+		uint32_t i_queryCount, uint32_t& io_foundCount )
+	{
+		std::uniform_real_distribution<float> across( -s_worldExtent * 1.2f, s_worldExtent * 1.2f );
+		std::uniform_real_distribution<float> size( 0.5f, 25.0f );
+		uint32_t mismatchCount = 0;
+		std::vector<uint32_t> found;
+		std::vector<uint32_t> expected;
+		for ( uint32_t queryIndex = 0; queryIndex < i_queryCount; ++queryIndex )
+		{
+			const EAE_Engine::Math::Vector3 center( across( io_generator ), across( io_generator ), across( io_generator ) );
+			const EAE_Engine::Math::Vector3 extents( size( io_generator ), size( io_generator ), size( io_generator ) );
+			const EAE_Engine::Math::PackedAABB box( center - extents, center + extents );
+			found.clear();
+			i_octree.QueryAABB( box, [&found]( uint32_t i_id ) { found.push_back( i_id ); return true; } );
+			io_world.BruteForce( [&box]( const EAE_Engine::Math::PackedAABB& i_aabb ) { return EAE_Engine::Math::TestAABBAABB( i_aabb, box ); }, expected );
+			io_foundCount += (uint32_t)found.size();
+			mismatchCount += IsSameIds( found, expected ) ? 0 : 1;
+
+			const float radius = extents._x;
+			found.clear();
+			i_octree.QuerySphere( center, radius, [&found]( uint32_t i_id ) { found.push_back( i_id ); return true; } );
+			io_world.BruteForce( [&center, radius]( const EAE_Engine::Math::PackedAABB& i_aabb ) { return EAE_Engine::Math::TestAABBSphere( i_aabb, center, radius ); }, expected );
+			io_foundCount += (uint32_t)found.size();
+			mismatchCount += IsSameIds( found, expected ) ? 0 : 1;
+
+			if ( queryIndex % 10 != 0 )
+				continue;
+			const EAE_Engine::Math::PackedFrustum frustum = GetRandomFrustum( io_generator );
+			found.clear();
+			i_octree.QueryFrustum( frustum, [&found]( uint32_t i_id ) { found.push_back( i_id ); return true; } );
+			io_world.BruteForce( [&frustum]( const EAE_Engine::Math::PackedAABB& i_aabb )
+			{
+				uint32_t planeMask = EAE_Engine::Math::PackedFrustum::s_allPlanes;
+				return EAE_Engine::Math::TestAABBFrustum( i_aabb, frustum, planeMask );
+			}, expected );
+			io_foundCount += (uint32_t)found.size();
+			mismatchCount += IsSameIds( found, expected ) ? 0 : 1;
+		}
+		return mismatchCount;
+	}
+
+	void TestOctreeManager()
+	{
+		std::vector<EAE_Engine::Math::Vector3> positions;
+		positions.push_back( EAE_Engine::Math::Vector3( -10.0f, 0.0f, -10.0f ) );
+		positions.push_back( EAE_Engine::Math::Vector3( -10.0f, 0.0f, 10.0f ) );
+		positions.push_back( EAE_Engine::Math::Vector3( 10.0f, 0.0f, 10.0f ) );
+		std::vector<uint32_t> indices;
+		indices.push_back( 0 );
+		indices.push_back( 1 );
+		indices.push_back( 2 );
+		EngineTests::CreateCollisionMesh( "LooseOctreeGround", positions, indices, 2 );
+		EngineTests::CreateCollisionMesh( "LooseOctreeWalls", positions, indices, 3 );
+		EAE_Engine::Core::OctreeManager* pManager = EAE_Engine::Core::OctreeManager::GetInstance();
+		EAE_Engine::Core::LooseOctree* pDynamic = new EAE_Engine::Core::LooseOctree( EAE_Engine::Math::Vector3( -1.0f, -1.0f, -1.0f ), EAE_Engine::Math::Vector3( 1.0f, 1.0f, 1.0f ) );
+		EAE_Engine::Core::LooseOctree* pTriggers = new EAE_Engine::Core::LooseOctree( EAE_Engine::Math::Vector3( -1.0f, -1.0f, -1.0f ), EAE_Engine::Math::Vector3( 1.0f, 1.0f, 1.0f ), 2 );
+		pManager->AddLooseOctree( "Dynamic", pDynamic );
+		pManager->AddLooseOctree( "Triggers", pTriggers );
+		ENGINE_TEST_CHECK( pManager->GetLooseOctree( "Dynamic" ) == pDynamic );
+		ENGINE_TEST_CHECK( pManager->GetLooseOctree( "Triggers" ) == pTriggers && pTriggers->GetMaxDepth() == 2 );
+		ENGINE_TEST_CHECK( pManager->GetLooseOctree( "Missing" ) == nullptr );
+		// The first CompleteOctree is still the collision mesh.
+		EAE_Engine::Core::CompleteOctree* pGround = pManager->GetOctree( "LooseOctreeGround" );
+		EAE_Engine::Core::CompleteOctree* pWalls = pManager->GetOctree( "LooseOctreeWalls" );
+		ENGINE_TEST_CHECK( pGround != nullptr && pWalls != nullptr && pGround != pWalls );
+		ENGINE_TEST_CHECK( pManager->GetOctree() == pGround && pGround->Level() == 2 && pWalls->Level() == 3 );
+		ENGINE_TEST_CHECK( pManager->GetOctree( "Dynamic" ) == nullptr );
+		EngineTests::CleanScene();
+	}
+}
+
+// Interface
+//==========
+
+int EngineTests::RunLooseOctreeTests()
+{
+	const int failureCountBefore = GetFailureCount();
+	TestOctreeManager();
+
+	const EAE_Engine::Math::Vector3 worldMin( -s_worldExtent, -s_worldExtent, -s_worldExtent );
+	const EAE_Engine::Math::Vector3 worldMax( s_worldExtent, s_worldExtent, s_worldExtent );
+	EAE_Engine::Core::LooseOctree* pOctree = new EAE_Engine::Core::LooseOctree( worldMin, worldMax, s_maxDepth );
+	EAE_Engine::Core::OctreeManager::GetInstance()->AddLooseOctree( "Dynamic", pOctree );
+	EAE_Engine::Core::LooseOctree& octree = *EAE_Engine::Core::OctreeManager::GetInstance()->GetLooseOctree( "Dynamic" );
+	cWorld world( octree );
+
+	std::chrono::high_resolution_clock::time_point timer = std::chrono::high_resolution_clock::now();
+	world.AddObjects( s_objectCount );
+	const double insertMilliseconds = GetMilliseconds( timer );
+	ENGINE_TEST_CHECK( octree.GetObjectCount() == s_objectCount );
+	octree.Validate();
+
+	std::mt19937 generator( 144 );
+	uint32_t mismatchCount = 0;
+	uint32_t countMismatchCount = 0;
+	uint32_t userDataMismatchCount = 0;
+	uint32_t foundCount = 0;
+	uint32_t relinkCount = 0;
+	uint32_t moveCount = 0;
+	double moveMilliseconds = 0.0;
+	for ( uint32_t round = 0; round < s_roundCount; ++round )
+	{
+		timer = std::chrono::high_resolution_clock::now();
+		relinkCount += world.Move();
+		moveMilliseconds += GetMilliseconds( timer );
+		moveCount += world.GetLiveCount();
+		world.Churn();
+		octree.Validate();
+		countMismatchCount += octree.GetObjectCount() == world.GetLiveCount() ? 0 : 1;
+		for ( size_t index = 0; index < world.objects.size(); ++index )
+		{
+			const sObject& object = world.objects[index];
+			if ( object.id != EAE_Engine::Core::LooseOctree::s_invalid )
+				userDataMismatchCount += octree.GetUserData( object.id ) == &object ? 0 : 1;
+		}
+		if ( round % 3 == 0 )
+			mismatchCount += CompareQueries( octree, world, generator, 40, foundCount );
+	}
+	ENGINE_TEST_CHECK( countMismatchCount == 0 );
+	ENGINE_TEST_CHECK( userDataMismatchCount == 0 );
+	ENGINE_TEST_CHECK( mismatchCount == 0 );
+	ENGINE_TEST_CHECK( foundCount > 0 );
+	// Most of the moves stay in the same node, which only writes the box.
+	ENGINE_TEST_CHECK( relinkCount > 0 && relinkCount < moveCount / 4 );
+
+	// A query stops at the first object whose callback returns false.
+	{
+		uint32_t callCount = 0;
+		octree.QueryAABB( EAE_Engine::Math::PackedAABB( worldMin, worldMax ), [&callCount]( uint32_t ) { ++callCount; return false; } );
+		ENGINE_TEST_CHECK( callCount == 1 );
+	}
+
+	// The time of each query against testing all of the boxes.
+	std::vector<EAE_Engine::Math::Vector3> centers( s_queryCount );
+	for ( uint32_t queryIndex = 0; queryIndex < s_queryCount; ++queryIndex )
+		centers[queryIndex] = world.GetRandomPosition( s_worldExtent );
+	const float radius = 10.0f;
+	uint32_t octreeSphereCount = 0;
+	timer = std::chrono::high_resolution_clock::now();
+	for ( uint32_t queryIndex = 0; queryIndex < s_queryCount; ++queryIndex )
+		octree.QuerySphere( centers[queryIndex], radius, [&octreeSphereCount]( uint32_t ) { ++octreeSphereCount; return true; } );
+	const double octreeSphereMilliseconds = GetMilliseconds( timer );
+	uint32_t bruteSphereCount = 0;
+	timer = std::chrono::high_resolution_clock::now();
+	for ( uint32_t queryIndex = 0; queryIndex < s_queryCount; ++queryIndex )
+	{
+		for ( size_t index = 0; index < world.objects.size(); ++index )
+		{
+			const sObject& object = world.objects[index];
+			if ( object.id != EAE_Engine::Core::LooseOctree::s_invalid && EAE_Engine::Math::TestAABBSphere( cWorld::GetAABB( object ), centers[queryIndex], radius ) )
+				++bruteSphereCount;
+		}
+	}
+	const double bruteSphereMilliseconds = GetMilliseconds( timer );
+	ENGINE_TEST_CHECK( octreeSphereCount == bruteSphereCount );
+	const uint32_t frustumCount = s_queryCount / 10;
+	std::vector<EAE_Engine::Math::PackedFrustum> frustums( frustumCount );
+	for ( uint32_t queryIndex = 0; queryIndex < frustumCount; ++queryIndex )
+		frustums[queryIndex] = GetRandomFrustum( generator );
+	uint32_t octreeFrustumCount = 0;
+	timer = std::chrono::high_resolution_clock::now();
+	for ( uint32_t queryIndex = 0; queryIndex < frustumCount; ++queryIndex )
+		octree.QueryFrustum( frustums[queryIndex], [&octreeFrustumCount]( uint32_t ) { ++octreeFrustumCount; return true; } );
+	const double octreeFrustumMilliseconds = GetMilliseconds( timer );
+	uint32_t bruteFrustumCount = 0;
+	timer = std::chrono::high_resolution_clock::now();
+	for ( uint32_t queryIndex = 0; queryIndex < frustumCount; ++queryIndex )
+	{
+		for ( size_t index = 0; index < world.objects.size(); ++index )
+		{
+			const sObject& object = world.objects[index];
+			uint32_t planeMask = EAE_Engine::Math::PackedFrustum::s_allPlanes;
+			if ( object.id != EAE_Engine::Core::LooseOctree::s_invalid && EAE_Engine::Math::TestAABBFrustum( cWorld::GetAABB( object ), frustums[queryIndex], planeMask ) )
+				++bruteFrustumCount;
+		}
+	}
+	const double bruteFrustumMilliseconds = GetMilliseconds( timer );
+	ENGINE_TEST_CHECK( octreeFrustumCount == bruteFrustumCount );
+
+	printf( "%u moving objects, depth %u, %u nodes, %.1f%% of the moves change the node\n",
+		s_objectCount, s_maxDepth, octree.GetNodeCount(), 100.0 * relinkCount / moveCount );
+	printf( "insert all %.3f ms, move all %.3f ms per frame\n", insertMilliseconds, moveMilliseconds / s_roundCount );
+	printf( "%-24s %-14s %-14s %-10s\n", "query", "octree us", "all boxes us", "found" );
+	printf( "%-24s %-14.2f %-14.2f %.1f\n", "sphere r = 10", octreeSphereMilliseconds * 1000.0 / s_queryCount,
+		bruteSphereMilliseconds * 1000.0 / s_queryCount, (double)octreeSphereCount / s_queryCount );
+	printf( "%-24s %-14.2f %-14.2f %.1f\n", "frustum, 80 m far", octreeFrustumMilliseconds * 1000.0 / frustumCount,
+		bruteFrustumMilliseconds * 1000.0 / frustumCount, (double)octreeFrustumCount / frustumCount );
+	CleanScene();
+	return GetFailureCount() - failureCountBefore;
+}
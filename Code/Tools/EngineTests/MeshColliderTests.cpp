@@ -0,0 +1,243 @@
+/*
+	MeshCollider::IntersectSegment against testing every triangle of the mesh:
+	in an octree of one leaf the segment must find the triangle which is later in the leaf, and the closest of two of them,
+	and on a height field each of the 10k segments must find the same first hit, point and normal as the test of all of the triangles.
+	It prints the queries per second of IntersectSegment, of the old TestCollision which looked the mesh up by its name,
+	gathered the hit triangles of the leaves sorted by their t into vectors and copied their positions, and of the test of all of the triangles.
+*/
+
+// Header Files
+//=============
+
+#include "EngineTests.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+#include "Engine/CollisionDetection/CollisionDetectionFunctions.h"
+#include "Engine/CollisionDetection/MeshCollider.h"
+#include "Engine/Mesh/AOSMeshData.h"
+#include "Engine/SpatialPartition/Octree.h"
+
+// Helper Definitions
+//===================
+
+namespace
+{
+	const uint32_t s_gridSize = 64;
+	const float s_cellSize = 2.0f;
+	const uint32_t s_octreeLevel = 4;
+	const uint32_t s_queryCount = 10000;
+	const float s_tolerance = 1.0e-4f;
+	// The old TestCollision looked the mesh up by this name.
+	const char* const s_meshKey = "collisionData";
+
+	double GetMilliseconds( std::chrono::high_resolution_clock::time_point i_start )
+	{
+		return std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - i_start ).count();
+	}
+
+	// The quad of 2 triangles on y = i_height, facing +y.
+	void AddQuad( float i_minX, float i_minZ, float i_size, float i_height, std::vector<EAE_Engine::Math::Vector3>& io_positions, std::vector<uint32_t>& io_indices )
+	{
+		const uint32_t first = (uint32_t)io_positions.size();
+		io_positions.push_back( EAE_Engine::Math::Vector3( i_minX, i_height, i_minZ ) );
+		io_positions.push_back( EAE_Engine::Math::Vector3( i_minX, i_height, i_minZ + i_size ) );
+		io_positions.push_back( EAE_Engine::Math::Vector3( i_minX + i_size, i_height, i_minZ + i_size ) );
+		io_positions.push_back( EAE_Engine::Math::Vector3( i_minX + i_size, i_height, i_minZ ) );
+		const uint32_t quad[] = { first, first + 1, first + 2, first, first + 2, first + 3 };
+		io_indices.insert( io_indices.end(), quad, quad + 6 );
+	}
+
+	// The rolling hills, the triangles face +y.
+	void CreateHeightField( std::vector<EAE_Engine::Math::Vector3>& o_positions, std::vector<uint32_t>& o_indices )
+	{
+		const float half = s_gridSize * s_cellSize * 0.5f;
+		for ( uint32_t z = 0; z <= s_gridSize; ++z )
+		{
+			for ( uint32_t x = 0; x <= s_gridSize; ++x )
+			{
+				const float posX = x * s_cellSize - half;
+				const float posZ = z * s_cellSize - half;
+				o_positions.push_back( EAE_Engine::Math::Vector3( posX, 3.0f * std::sin( posX * 0.2f ) * std::cos( posZ * 0.15f ), posZ ) );
+			}
+		}
+		for ( uint32_t z = 0; z < s_gridSize; ++z )
+		{
+			for ( uint32_t x = 0; x < s_gridSize; ++x )
+			{
+				const uint32_t v00 = z * ( s_gridSize + 1 ) + x;
+				const uint32_t v10 = v00 + 1;
+				const uint32_t v01 = v00 + s_gridSize + 1;
+				const uint32_t v11 = v01 + 1;
+				const uint32_t quad[] = { v00, v01, v11, v00, v11, v10 };
+				o_indices.insert( o_indices.end(), quad, quad + 6 );
+			}
+		}
+	}
+
+	struct sHit
+	{
+		bool collided;
+		float t;
+		EAE_Engine::Math::Vector3 point;
+		EAE_Engine::Math::Vector3 normal;
+	};
+
+	// The first front face hit of the segment, testing every triangle of the mesh.
+	sHit IntersectAllTriangles( const std::vector<EAE_Engine::Math::Vector3>& i_positions, const std::vector<uint32_t>& i_indices,
+		const EAE_Engine::Math::Vector3& i_start, const EAE_Engine::Math::Vector3& i_end )
+	{
+		sHit hit = { false, FLT_MAX, EAE_Engine::Math::Vector3::Zero, EAE_Engine::Math::Vector3::Zero };
+		for ( size_t index = 0; index + 2 < i_indices.size(); index += 3 )
+		{
+			const EAE_Engine::Math::Vector3& a = i_positions[i_indices[index]];
+			const EAE_Engine::Math::Vector3& b = i_positions[i_indices[index + 1]];
+			const EAE_Engine::Math::Vector3& c = i_positions[i_indices[index + 2]];
+			float u = 0.0f, v = 0.0f, w = 0.0f, t = 0.0f;
+			if ( !EAE_Engine::Collision::IntersectSegmentTriangle( i_start, i_end, a, b, c, u, v, w, t ) || t >= hit.t )
+				continue;
+			hit.collided = true;
+			hit.t = t;
+			hit.point = a * u + b * v + c * w;
+			hit.normal = EAE_Engine::Math::Vector3::Cross( b - a, c - a ).GetNormalize();
+		}
+		return hit;
+	}
+
+	sHit IntersectMeshCollider( EAE_Engine::Collider::MeshCollider& i_collider, const EAE_Engine::Math::Vector3& i_start, const EAE_Engine::Math::Vector3& i_end )
+	{
+		sHit hit = { false, FLT_MAX, EAE_Engine::Math::Vector3::Zero, EAE_Engine::Math::Vector3::Zero };
+		hit.collided = i_collider.IntersectSegment( i_start, i_end, hit.t, hit.point, hit.normal );
+		return hit;
+	}
+
+	// The old TestCollision: look the mesh up, gather the hit triangles sorted by t, copy their positions and test the closest one again.
+	bool IntersectGathered( const EAE_Engine::Math::Vector3& i_start, const EAE_Engine::Math::Vector3& i_end, float& o_t )
+	{
+		EAE_Engine::Core::CompleteOctree* pOctree = EAE_Engine::Core::OctreeManager::GetInstance()->GetOctree();
+		std::vector<EAE_Engine::Mesh::TriangleIndex> triangles;
+		pOctree->GetTrianlgesCollideWithSegment( i_start, i_end, triangles );
+		std::vector<uint32_t> triangleIndices;
+		for ( size_t index = 0; index < triangles.size(); ++index )
+		{
+			triangleIndices.push_back( triangles[index]._index0 );
+			triangleIndices.push_back( triangles[index]._index1 );
+			triangleIndices.push_back( triangles[index]._index2 );
+		}
+		EAE_Engine::Mesh::AOSMeshData* pData = EAE_Engine::Mesh::AOSMeshDataManager::GetInstance()->GetAOSMeshData( s_meshKey );
+		std::vector<EAE_Engine::Math::Vector3> vertices = pData->GetVertexPoses( triangleIndices );
+		if ( vertices.size() < 3 )
+			return false;
+		float u = 0.0f, v = 0.0f, w = 0.0f;
+		return EAE_Engine::Collision::IntersectSegmentTriangle( i_start, i_end, vertices[0], vertices[1], vertices[2], u, v, w, o_t ) != 0;
+	}
+
+	bool IsSameHit( const sHit& i_lhs, const sHit& i_rhs )
+	{
+		if ( i_lhs.collided != i_rhs.collided )
+			return false;
+		if ( !i_lhs.collided )
+			return true;
+		return std::fabs( i_lhs.t - i_rhs.t ) <= s_tolerance && ( i_lhs.point - i_rhs.point ).Magnitude() <= s_tolerance &&
+			( i_lhs.normal - i_rhs.normal ).Magnitude() <= s_tolerance;
+	}
+}
+
+// Interface
+//==========
+
+int EngineTests::RunMeshColliderTests()
+{
+	const int failureCountBefore = GetFailureCount();
+	TestTransform meshTransform;
+	// The octree of level 1 is a single leaf, so all of the triangles are the candidates of every segment.
+	{
+		std::vector<EAE_Engine::Math::Vector3> positions;
+		std::vector<uint32_t> indices;
+		AddQuad( -10.0f, -10.0f, 2.0f, 0.0f, positions, indices );
+		AddQuad( 2.0f, 2.0f, 4.0f, 1.0f, positions, indices );
+		AddQuad( 2.0f, 2.0f, 4.0f, 2.0f, positions, indices );
+		CreateCollisionMesh( s_meshKey, positions, indices, 1 );
+		EAE_Engine::Collider::MeshCollider meshCollider( &meshTransform );
+		meshCollider.Init( s_meshKey );
+		meshCollider.PrepareForStep();
+
+		// Only the last triangle of the leaf is under the segment.
+		sHit hit = IntersectMeshCollider( meshCollider, EAE_Engine::Math::Vector3( 5.0f, 5.0f, 3.0f ), EAE_Engine::Math::Vector3( 5.0f, 1.5f, 3.0f ) );
+		ENGINE_TEST_CHECK( hit.collided );
+		ENGINE_TEST_CHECK( std::fabs( hit.t - 3.0f / 3.5f ) <= s_tolerance );
+		ENGINE_TEST_CHECK( ( hit.point - EAE_Engine::Math::Vector3( 5.0f, 2.0f, 3.0f ) ).Magnitude() <= s_tolerance );
+		ENGINE_TEST_CHECK( ( hit.normal - EAE_Engine::Math::Vector3( 0.0f, 1.0f, 0.0f ) ).Magnitude() <= s_tolerance );
+		// Two of them are under it, the later one in the leaf is closer.
+		hit = IntersectMeshCollider( meshCollider, EAE_Engine::Math::Vector3( 3.0f, 5.0f, 5.0f ), EAE_Engine::Math::Vector3( 3.0f, -1.0f, 5.0f ) );
+		ENGINE_TEST_CHECK( hit.collided );
+		ENGINE_TEST_CHECK( std::fabs( hit.t - 0.5f ) <= s_tolerance );
+		// The back faces are not hit.
+		hit = IntersectMeshCollider( meshCollider, EAE_Engine::Math::Vector3( 5.0f, 0.5f, 3.0f ), EAE_Engine::Math::Vector3( 5.0f, 5.0f, 3.0f ) );
+		ENGINE_TEST_CHECK( !hit.collided );
+		CleanScene();
+	}
+
+	std::vector<EAE_Engine::Math::Vector3> positions;
+	std::vector<uint32_t> indices;
+	CreateHeightField( positions, indices );
+	CreateCollisionMesh( s_meshKey, positions, indices, s_octreeLevel );
+	EAE_Engine::Collider::MeshCollider meshCollider( &meshTransform );
+	meshCollider.Init( s_meshKey );
+	meshCollider.PrepareForStep();
+
+	// Falling and oblique segments over the field, some of them stop above the hills.
+	std::mt19937 generator( 33 );
+	const float half = s_gridSize * s_cellSize * 0.5f;
+	std::uniform_real_distribution<float> across( -half, half );
+	std::uniform_real_distribution<float> height( -6.0f, 10.0f );
+	std::vector<EAE_Engine::Math::Vector3> starts( s_queryCount );
+	std::vector<EAE_Engine::Math::Vector3> ends( s_queryCount );
+	for ( uint32_t queryIndex = 0; queryIndex < s_queryCount; ++queryIndex )
+	{
+		starts[queryIndex] = EAE_Engine::Math::Vector3( across( generator ), 10.0f, across( generator ) );
+		ends[queryIndex] = starts[queryIndex] + EAE_Engine::Math::Vector3( across( generator ) * 0.1f, height( generator ) - 10.0f, across( generator ) * 0.1f );
+	}
+	uint32_t mismatchCount = 0;
+	uint32_t hitCount = 0;
+	for ( uint32_t queryIndex = 0; queryIndex < s_queryCount; ++queryIndex )
+	{
+		const sHit expected = IntersectAllTriangles( positions, indices, starts[queryIndex], ends[queryIndex] );
+		const sHit hit = IntersectMeshCollider( meshCollider, starts[queryIndex], ends[queryIndex] );
+		mismatchCount += IsSameHit( expected, hit ) ? 0 : 1;
+		hitCount += expected.collided ? 1 : 0;
+	}
+	ENGINE_TEST_CHECK( mismatchCount == 0 );
+	ENGINE_TEST_CHECK( hitCount > 0 && hitCount < s_queryCount );
+
+	uint32_t foundCount = 0;
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	for ( uint32_t queryIndex = 0; queryIndex < s_queryCount; ++queryIndex )
+		foundCount += IntersectMeshCollider( meshCollider, starts[queryIndex], ends[queryIndex] ).collided ? 1 : 0;
+	const double newMilliseconds = GetMilliseconds( start );
+	uint32_t oldFoundCount = 0;
+	start = std::chrono::high_resolution_clock::now();
+	for ( uint32_t queryIndex = 0; queryIndex < s_queryCount; ++queryIndex )
+	{
+		float t = 0.0f;
+		oldFoundCount += IntersectGathered( starts[queryIndex], ends[queryIndex], t ) ? 1 : 0;
+	}
+	const double oldMilliseconds = GetMilliseconds( start );
+	uint32_t allFoundCount = 0;
+	start = std::chrono::high_resolution_clock::now();
+	for ( uint32_t queryIndex = 0; queryIndex < s_queryCount; ++queryIndex )
+		allFoundCount += IntersectAllTriangles( positions, indices, starts[queryIndex], ends[queryIndex] ).collided ? 1 : 0;
+	const double allMilliseconds = GetMilliseconds( start );
+	ENGINE_TEST_CHECK( foundCount == allFoundCount && oldFoundCount == allFoundCount );
+
+	printf( "%u triangles, octree level %u, %u segments, %u hits\n", (uint32_t)indices.size() / 3, s_octreeLevel, s_queryCount, hitCount );
+	printf( "%-30s %-14s %-10s\n", "path", "queries/s", "hits" );
+	printf( "%-30s %-14.0f %u\n", "IntersectSegment", s_queryCount * 1000.0 / newMilliseconds, foundCount );
+	printf( "%-30s %-14.0f %u\n", "gather, sort and copy", s_queryCount * 1000.0 / oldMilliseconds, oldFoundCount );
+	printf( "%-30s %-14.0f %u\n", "all triangles", s_queryCount * 1000.0 / allMilliseconds, allFoundCount );
+	CleanScene();
+	return GetFailureCount() - failureCountBefore;
+}
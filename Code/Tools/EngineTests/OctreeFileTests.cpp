@@ -0,0 +1,381 @@
+/*
+	The compact .octree file: the file written for a height field, saved, read back and used in place by InitFromMemory
+	must give the same leaves, triangles, segment hits and box queries as the octree it was written from,
+	the legacy file of the same leaves must convert to the same bytes, and the 32 bit references must work past 65536 triangles.
+	Every truncation of a file and each corrupted field must be rejected, and a rejected file must leave the octree as it was.
+	It prints the size of both formats and the time to load each of them.
+*/
+
+// Header Files
+//=============
+
+#include "EngineTests.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+
+#include "Engine/Mesh/AOSMeshData.h"
+#include "Engine/SpatialPartition/Octree.h"
+#include "Engine/SpatialPartition/OctreeFile.h"
+#include "Engine/SpatialPartition/OctreeLeafBuilder.h"
+
+// Helper Definitions
+//===================
+
+namespace
+{
+	const uint32_t s_gridSize = 64;
+	const float s_cellSize = 2.0f;
+	const uint32_t s_octreeLevel = 5;
+	const uint32_t s_segmentCount = 2000;
+	const uint32_t s_boxCount = 200;
+	const uint32_t s_maxHits = 8;
+	const uint32_t s_loadCount = 20;
+	const char* const s_meshKey = "OctreeFileField";
+	const char* const s_filePath = "EngineTests.octree";
+
+	double GetMilliseconds( std::chrono::high_resolution_clock::time_point i_start )
+	{
+		return std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - i_start ).count();
+	}
+
+	void CreateHeightField( std::vector<EAE_Engine::Math::Vector3>& o_positions, std::vector<uint32_t>& o_indices )
+	{
+		const float half = s_gridSize * s_cellSize * 0.5f;
+		for ( uint32_t z = 0; z <= s_gridSize; ++z )
+		{
+			for ( uint32_t x = 0; x <= s_gridSize; ++x )
+			{
+				const float posX = x * s_cellSize - half;
+				const float posZ = z * s_cellSize - half;
+				o_positions.push_back( EAE_Engine::Math::Vector3( posX, 3.0f * std::sin( posX * 0.2f ) * std::cos( posZ * 0.15f ), posZ ) );
+			}
+		}
+		for ( uint32_t z = 0; z < s_gridSize; ++z )
+		{
+			for ( uint32_t x = 0; x < s_gridSize; ++x )
+			{
+				const uint32_t v00 = z * ( s_gridSize + 1 ) + x;
+				const uint32_t v10 = v00 + 1;
+				const uint32_t v01 = v00 + s_gridSize + 1;
+				const uint32_t v11 = v01 + 1;
+				const uint32_t quad[] = { v00, v01, v11, v00, v11, v10 };
+				o_indices.insert( o_indices.end(), quad, quad + 6 );
+			}
+		}
+	}
+
+	// The file the old exporter wrote: the level, the count of the nodes, the min and the max,
+	// then the count and the triangles of each leaf.
+	void WriteLegacyOctree( uint32_t i_level, const EAE_Engine::Math::Vector3& i_min, const EAE_Engine::Math::Vector3& i_max,
+		const std::vector<std::vector<EAE_Engine::Mesh::TriangleIndex> >& i_leafTriangles, std::vector<uint8_t>& o_data )
+	{
+		const uint32_t countOfNode = (uint32_t)( ( std::pow( 8.0f, (float)i_level ) - 1 ) / 7 );
+		o_data.clear();
+		o_data.insert( o_data.end(), (const uint8_t*)&i_level, (const uint8_t*)&i_level + sizeof( uint32_t ) );
+		o_data.insert( o_data.end(), (const uint8_t*)&countOfNode, (const uint8_t*)&countOfNode + sizeof( uint32_t ) );
+		o_data.insert( o_data.end(), (const uint8_t*)&i_min, (const uint8_t*)&i_min + sizeof( EAE_Engine::Math::Vector3 ) );
+		o_data.insert( o_data.end(), (const uint8_t*)&i_max, (const uint8_t*)&i_max + sizeof( EAE_Engine::Math::Vector3 ) );
+		for ( size_t leafIndex = 0; leafIndex < i_leafTriangles.size(); ++leafIndex )
+		{
+			const uint32_t triangleCount = (uint32_t)i_leafTriangles[leafIndex].size();
+			o_data.insert( o_data.end(), (const uint8_t*)&triangleCount, (const uint8_t*)&triangleCount + sizeof( uint32_t ) );
+			if ( triangleCount > 0 )
+			{
+				const uint8_t* pTriangles = (const uint8_t*)&i_leafTriangles[leafIndex][0];
+				o_data.insert( o_data.end(), pTriangles, pTriangles + triangleCount * sizeof( EAE_Engine::Mesh::TriangleIndex ) );
+			}
+		}
+	}
+
+	bool WriteFile( const char* i_path, const std::vector<uint8_t>& i_data )
+	{
+		std::ofstream outfile( i_path, std::ofstream::binary );
+		outfile.write( (const char*)&i_data[0], i_data.size() );
+		return outfile.good();
+	}
+
+	bool ReadFile( const char* i_path, std::vector<uint8_t>& o_data )
+	{
+		std::ifstream infile( i_path, std::ifstream::binary );
+		infile.seekg( 0, infile.end );
+		const std::streamoff size = infile.tellg();
+		infile.seekg( 0 );
+		o_data.resize( size > 0 ? (size_t)size : 0 );
+		if ( size > 0 )
+			infile.read( (char*)&o_data[0], size );
+		return infile.good() && size > 0;
+	}
+
+	// The same leaves with the same triangles, in the same order.
+	bool IsSameLeaves( EAE_Engine::Core::CompleteOctree& i_lhs, EAE_Engine::Core::CompleteOctree& i_rhs )
+	{
+		if ( i_lhs.Level() != i_rhs.Level() || i_lhs.GetNodeCount() != i_rhs.GetNodeCount() ||
+			i_lhs.GetMemorySize() != i_rhs.GetMemorySize() )
+			return false;
+		const uint32_t leafLevel = i_lhs.Level() - 1;
+		const EAE_Engine::Core::OctreeNode* pLhsLeaves = i_lhs.GetNodesInLevel( leafLevel );
+		const EAE_Engine::Core::OctreeNode* pRhsLeaves = i_rhs.GetNodesInLevel( leafLevel );
+		for ( uint32_t leafIndex = 0; leafIndex < i_lhs.GetCountOfNodesInLevel( leafLevel ); ++leafIndex )
+		{
+			const EAE_Engine::Core::OctreeNode& lhs = pLhsLeaves[leafIndex];
+			const EAE_Engine::Core::OctreeNode& rhs = pRhsLeaves[leafIndex];
+			if ( lhs._triangleCount != rhs._triangleCount || ( lhs._pos - rhs._pos ).SqMagnitude() != 0.0f ||
+				( lhs._extent - rhs._extent ).SqMagnitude() != 0.0f )
+				return false;
+			for ( uint32_t triangleIndex = 0; triangleIndex < lhs._triangleCount; ++triangleIndex )
+			{
+				if ( !( i_lhs.GetTriangle( lhs, triangleIndex ) == i_rhs.GetTriangle( rhs, triangleIndex ) ) )
+					return false;
+			}
+		}
+		return true;
+	}
+
+	// The copy of i_data with the uint32_t at i_offset replaced.
+	std::vector<uint8_t> WithUint32( const std::vector<uint8_t>& i_data, size_t i_offset, uint32_t i_value )
+	{
+		std::vector<uint8_t> data( i_data );
+		memcpy( &data[i_offset], &i_value, sizeof( uint32_t ) );
+		return data;
+	}
+
+	// Neither the check nor the octree accept it, and the octree still has the leaves it had.
+	bool IsRejected( const std::vector<uint8_t>& i_data, size_t i_size, EAE_Engine::Core::CompleteOctree& io_octree, uint32_t i_expectedLevel )
+	{
+		const void* pData = i_size > 0 ? &i_data[0] : nullptr;
+		std::vector<uint8_t> converted;
+		return !EAE_Engine::Core::IsValidCompactOctree( pData, i_size ) && !io_octree.InitFromMemory( pData, i_size ) &&
+			!EAE_Engine::Core::ConvertToCompactOctree( pData, i_size, converted ) && io_octree.Level() == i_expectedLevel;
+	}
+
+	void TestCorruptFiles( const std::vector<uint8_t>& i_compact, const std::vector<uint8_t>& i_legacy, EAE_Engine::Core::CompleteOctree& io_octree )
+	{
+		const uint32_t level = io_octree.Level();
+		EAE_Engine::Core::CompactOctreeHeader header;
+		memcpy( &header, &i_compact[0], sizeof( header ) );
+		// Every truncation of the compact file.
+		uint32_t acceptedCount = 0;
+		for ( size_t size = 0; size < i_compact.size(); ++size )
+			acceptedCount += IsRejected( i_compact, size, io_octree, level ) ? 0 : 1;
+		ENGINE_TEST_CHECK( acceptedCount == 0 );
+		// Every truncation of the legacy file.
+		acceptedCount = 0;
+		for ( size_t size = 0; size < i_legacy.size(); ++size )
+		{
+			std::vector<uint8_t> converted;
+			acceptedCount += EAE_Engine::Core::ConvertToCompactOctree( size > 0 ? &i_legacy[0] : nullptr, size, converted ) ? 1 : 0;
+		}
+		ENGINE_TEST_CHECK( acceptedCount == 0 );
+
+		// The fields of the header.
+		typedef EAE_Engine::Core::CompactOctreeHeader Header;
+		ENGINE_TEST_CHECK( IsRejected( WithUint32( i_compact, offsetof( Header, _magic ), 0x4354434e ), i_compact.size(), io_octree, level ) );
+		ENGINE_TEST_CHECK( IsRejected( WithUint32( i_compact, offsetof( Header, _version ), EAE_Engine::Core::s_compactOctreeVersion + 1 ), i_compact.size(), io_octree, level ) );
+		ENGINE_TEST_CHECK( IsRejected( WithUint32( i_compact, offsetof( Header, _level ), 0 ), i_compact.size(), io_octree, level ) );
+		ENGINE_TEST_CHECK( IsRejected( WithUint32( i_compact, offsetof( Header, _level ), 11 ), i_compact.size(), io_octree, level ) );
+		ENGINE_TEST_CHECK( IsRejected( WithUint32( i_compact, offsetof( Header, _level ), header._level + 1 ), i_compact.size(), io_octree, level ) );
+		ENGINE_TEST_CHECK( IsRejected( WithUint32( i_compact, offsetof( Header, _countOfNode ), header._countOfNode + 1 ), i_compact.size(), io_octree, level ) );
+		ENGINE_TEST_CHECK( IsRejected( WithUint32( i_compact, offsetof( Header, _leafCount ), header._leafCount - 1 ), i_compact.size(), io_octree, level ) );
+		ENGINE_TEST_CHECK( IsRejected( WithUint32( i_compact, offsetof( Header, _triangleCount ), header._triangleCount + 1000 ), i_compact.size(), io_octree, level ) );
+		ENGINE_TEST_CHECK( IsRejected( WithUint32( i_compact, offsetof( Header, _referenceCount ), header._referenceCount + 1000 ), i_compact.size(), io_octree, level ) );
+		ENGINE_TEST_CHECK( IsRejected( WithUint32( i_compact, offsetof( Header, _referenceSize ), 3 ), i_compact.size(), io_octree, level ) );
+		ENGINE_TEST_CHECK( IsRejected( WithUint32( i_compact, offsetof( Header, _referenceSize ), 4 ), i_compact.size(), io_octree, level ) );
+
+		// The ranges of the leaves: not from 0, going back, and not ending at the count of the references.
+		const size_t firstReferencesOffset = sizeof( Header );
+		const size_t lastFirstReferenceOffset = firstReferencesOffset + header._leafCount * sizeof( uint32_t );
+		ENGINE_TEST_CHECK( IsRejected( WithUint32( i_compact, firstReferencesOffset, 1 ), i_compact.size(), io_octree, level ) );
+		ENGINE_TEST_CHECK( IsRejected( WithUint32( i_compact, lastFirstReferenceOffset, header._referenceCount - 1 ), i_compact.size(), io_octree, level ) );
+		const uint32_t middleLeaf = header._leafCount / 2;
+		ENGINE_TEST_CHECK( IsRejected( WithUint32( i_compact, firstReferencesOffset + middleLeaf * sizeof( uint32_t ), header._referenceCount + 1 ),
+			i_compact.size(), io_octree, level ) );
+		// A reference past the triangles.
+		const size_t referencesOffset = lastFirstReferenceOffset + sizeof( uint32_t ) + header._triangleCount * sizeof( EAE_Engine::Mesh::TriangleIndex );
+		std::vector<uint8_t> badReference( i_compact );
+		const uint16_t pastTriangles = (uint16_t)header._triangleCount;
+		memcpy( &badReference[referencesOffset + ( header._referenceCount / 2 ) * header._referenceSize], &pastTriangles, sizeof( uint16_t ) );
+		ENGINE_TEST_CHECK( header._referenceSize == sizeof( uint16_t ) && IsRejected( badReference, badReference.size(), io_octree, level ) );
+
+		// A legacy file of a level which doesn't fit, and the trailing bytes of the old exporter, which are ignored.
+		std::vector<uint8_t> converted;
+		ENGINE_TEST_CHECK( !EAE_Engine::Core::ConvertToCompactOctree( &WithUint32( i_legacy, 0, 11 )[0], i_legacy.size(), converted ) );
+		std::vector<uint8_t> padded( i_legacy );
+		padded.resize( padded.size() + 8, 0xcd );
+		ENGINE_TEST_CHECK( EAE_Engine::Core::ConvertToCompactOctree( &padded[0], padded.size(), converted ) && converted == i_compact );
+	}
+
+	// More than 65536 triangles, so the references take 32 bits.
+	void TestWideReferences()
+	{
+		const uint32_t level = 2;
+		const uint32_t triangleCount = 70000;
+		std::vector<std::vector<EAE_Engine::Mesh::TriangleIndex> > leafTriangles( 8 );
+		for ( uint32_t triangleIndex = 0; triangleIndex < triangleCount; ++triangleIndex )
+		{
+			EAE_Engine::Mesh::TriangleIndex triangle;
+			triangle._index0 = triangleIndex * 3;
+			triangle._index1 = triangleIndex * 3 + 1;
+			triangle._index2 = triangleIndex * 3 + 2;
+			// Some of them are in 2 leaves.
+			leafTriangles[triangleIndex % 8].push_back( triangle );
+			if ( triangleIndex % 5 == 0 )
+				leafTriangles[( triangleIndex + 3 ) % 8].push_back( triangle );
+		}
+		const EAE_Engine::Math::Vector3 min( -1.0f, -1.0f, -1.0f );
+		const EAE_Engine::Math::Vector3 max( 1.0f, 1.0f, 1.0f );
+		std::vector<uint8_t> data;
+		EAE_Engine::Core::WriteCompactOctree( level, min, max, leafTriangles, data );
+		EAE_Engine::Core::CompactOctreeHeader header;
+		memcpy( &header, &data[0], sizeof( header ) );
+		ENGINE_TEST_CHECK( header._referenceSize == sizeof( uint32_t ) && header._triangleCount == triangleCount );
+		EAE_Engine::Core::CompleteOctree octree;
+		ENGINE_TEST_CHECK( octree.InitFromMemory( &data[0], data.size() ) );
+		uint32_t wrongCount = 0;
+		EAE_Engine::Core::OctreeNode* pLeaves = octree.GetNodesInLevel( level - 1 );
+		for ( uint32_t leafIndex = 0; leafIndex < 8; ++leafIndex )
+		{
+			if ( pLeaves[leafIndex]._triangleCount != leafTriangles[leafIndex].size() )
+			{
+				++wrongCount;
+				continue;
+			}
+			for ( uint32_t triangleIndex = 0; triangleIndex < pLeaves[leafIndex]._triangleCount; ++triangleIndex )
+				wrongCount += octree.GetTriangle( pLeaves[leafIndex], triangleIndex ) == leafTriangles[leafIndex][triangleIndex] ? 0 : 1;
+		}
+		ENGINE_TEST_CHECK( wrongCount == 0 );
+		// A 32 bit reference past the triangles.
+		const size_t referencesOffset = sizeof( header ) + ( header._leafCount + 1 ) * sizeof( uint32_t ) + triangleCount * sizeof( EAE_Engine::Mesh::TriangleIndex );
+		ENGINE_TEST_CHECK( IsRejected( WithUint32( data, referencesOffset + 100 * sizeof( uint32_t ), triangleCount ), data.size(), octree, level ) );
+	}
+}
+
+// Interface
+//==========
+
+int EngineTests::RunOctreeFileTests()
+{
+	const int failureCountBefore = GetFailureCount();
+	std::vector<EAE_Engine::Math::Vector3> positions;
+	std::vector<uint32_t> indices;
+	CreateHeightField( positions, indices );
+	CreateCollisionMesh( s_meshKey, positions, indices, s_octreeLevel );
+	EAE_Engine::Core::CompleteOctree& built = *EAE_Engine::Core::OctreeManager::GetInstance()->GetOctree( s_meshKey );
+
+	// The leaves of the octree built from the triangles.
+	std::vector<EAE_Engine::Mesh::TriangleIndex> triangles( indices.size() / 3 );
+	for ( size_t triangleIndex = 0; triangleIndex < triangles.size(); ++triangleIndex )
+	{
+		triangles[triangleIndex]._index0 = indices[triangleIndex * 3 + 0];
+		triangles[triangleIndex]._index1 = indices[triangleIndex * 3 + 1];
+		triangles[triangleIndex]._index2 = indices[triangleIndex * 3 + 2];
+	}
+	std::vector<std::vector<EAE_Engine::Mesh::TriangleIndex> > leafTriangles;
+	EAE_Engine::Core::BuildLeafTriangles( s_octreeLevel, built.GetMin(), built.GetMax(), positions, triangles, 1, leafTriangles );
+	std::vector<uint8_t> written;
+	EAE_Engine::Core::WriteCompactOctree( s_octreeLevel, built.GetMin(), built.GetMax(), leafTriangles, written );
+	ENGINE_TEST_CHECK( EAE_Engine::Core::IsValidCompactOctree( &written[0], written.size() ) );
+
+	// Save it, read it back and use it in place.
+	std::vector<uint8_t> compact;
+	ENGINE_TEST_CHECK( WriteFile( s_filePath, written ) && ReadFile( s_filePath, compact ) && compact == written );
+	std::remove( s_filePath );
+	EAE_Engine::Core::CompleteOctree loaded;
+	ENGINE_TEST_CHECK( loaded.InitFromMemory( &compact[0], compact.size() ) );
+	loaded.SetCollisionMesh( built.GetCollisionMesh() );
+	ENGINE_TEST_CHECK( IsSameLeaves( built, loaded ) );
+	// Nothing but the nodes is allocated, the triangles are read from the file.
+	ENGINE_TEST_CHECK( loaded.GetMemorySize() == loaded.GetNodeCount() * sizeof( EAE_Engine::Core::OctreeNode ) + compact.size() );
+
+	std::mt19937 generator( 43 );
+	const float half = s_gridSize * s_cellSize * 0.5f;
+	std::uniform_real_distribution<float> across( -half, half );
+	std::uniform_real_distribution<float> height( -6.0f, 10.0f );
+	uint32_t segmentMismatchCount = 0;
+	uint32_t segmentHitCount = 0;
+	for ( uint32_t segmentIndex = 0; segmentIndex < s_segmentCount; ++segmentIndex )
+	{
+		const EAE_Engine::Math::Vector3 start( across( generator ), 10.0f, across( generator ) );
+		const EAE_Engine::Math::Vector3 end( across( generator ), height( generator ), across( generator ) );
+		EAE_Engine::Core::SegmentHit builtHits[s_maxHits];
+		EAE_Engine::Core::SegmentHit loadedHits[s_maxHits];
+		const uint32_t builtCount = built.GetTrianlgesCollideWithSegment( start, end, builtHits, s_maxHits );
+		const uint32_t loadedCount = loaded.GetTrianlgesCollideWithSegment( start, end, loadedHits, s_maxHits );
+		bool same = builtCount == loadedCount;
+		for ( uint32_t hitIndex = 0; same && hitIndex < builtCount; ++hitIndex )
+			same = builtHits[hitIndex]._t == loadedHits[hitIndex]._t && builtHits[hitIndex]._triangle == loadedHits[hitIndex]._triangle;
+		segmentMismatchCount += same ? 0 : 1;
+		segmentHitCount += builtCount;
+	}
+	ENGINE_TEST_CHECK( segmentMismatchCount == 0 && segmentHitCount > 0 );
+	uint32_t boxMismatchCount = 0;
+	std::uniform_real_distribution<float> extent( 1.0f, 20.0f );
+	for ( uint32_t boxIndex = 0; boxIndex < s_boxCount; ++boxIndex )
+	{
+		const EAE_Engine::Math::Vector3 center( across( generator ), height( generator ), across( generator ) );
+		const EAE_Engine::Math::Vector3 boxExtent( extent( generator ), extent( generator ), extent( generator ) );
+		const EAE_Engine::Math::PackedAABB box( center - boxExtent, center + boxExtent );
+		std::vector<EAE_Engine::Core::OctreeNode*> builtLeaves;
+		std::vector<EAE_Engine::Core::OctreeNode*> loadedLeaves;
+		built.GetLeavesInAABB( box, builtLeaves );
+		loaded.GetLeavesInAABB( box, loadedLeaves );
+		bool same = builtLeaves.size() == loadedLeaves.size();
+		for ( size_t leafIndex = 0; same && leafIndex < builtLeaves.size(); ++leafIndex )
+			same = builtLeaves[leafIndex] - built.GetNodes() == loadedLeaves[leafIndex] - loaded.GetNodes();
+		boxMismatchCount += same ? 0 : 1;
+	}
+	ENGINE_TEST_CHECK( boxMismatchCount == 0 );
+
+	// The legacy file of the same leaves converts to the same bytes.
+	std::vector<uint8_t> legacy;
+	WriteLegacyOctree( s_octreeLevel, built.GetMin(), built.GetMax(), leafTriangles, legacy );
+	std::vector<uint8_t> converted;
+	ENGINE_TEST_CHECK( EAE_Engine::Core::ConvertToCompactOctree( &legacy[0], legacy.size(), converted ) && converted == compact );
+	// A compact file is copied as it is.
+	ENGINE_TEST_CHECK( EAE_Engine::Core::ConvertToCompactOctree( &compact[0], compact.size(), converted ) && converted == compact );
+
+	// The rejected files, tried on the loaded octree, which must still answer as before.
+	{
+		std::vector<uint8_t> smallCompact;
+		std::vector<uint8_t> smallLegacy;
+		std::vector<std::vector<EAE_Engine::Mesh::TriangleIndex> > smallLeaves;
+		EAE_Engine::Core::BuildLeafTriangles( 2, built.GetMin(), built.GetMax(), positions, std::vector<EAE_Engine::Mesh::TriangleIndex>( triangles.begin(), triangles.begin() + 64 ), 1, smallLeaves );
+		EAE_Engine::Core::WriteCompactOctree( 2, built.GetMin(), built.GetMax(), smallLeaves, smallCompact );
+		WriteLegacyOctree( 2, built.GetMin(), built.GetMax(), smallLeaves, smallLegacy );
+		TestCorruptFiles( smallCompact, smallLegacy, loaded );
+		// A truncation of the big file.
+		ENGINE_TEST_CHECK( IsRejected( compact, compact.size() - 1, loaded, s_octreeLevel ) );
+		ENGINE_TEST_CHECK( IsSameLeaves( built, loaded ) );
+	}
+	TestWideReferences();
+
+	// Loading: the compact file in place against converting the legacy one first.
+	std::chrono::high_resolution_clock::time_point timer = std::chrono::high_resolution_clock::now();
+	for ( uint32_t loadIndex = 0; loadIndex < s_loadCount; ++loadIndex )
+	{
+		EAE_Engine::Core::CompleteOctree octree;
+		octree.InitFromMemory( &compact[0], compact.size() );
+	}
+	const double compactMilliseconds = GetMilliseconds( timer ) / s_loadCount;
+	timer = std::chrono::high_resolution_clock::now();
+	for ( uint32_t loadIndex = 0; loadIndex < s_loadCount; ++loadIndex )
+	{
+		std::vector<uint8_t> data;
+		EAE_Engine::Core::ConvertToCompactOctree( &legacy[0], legacy.size(), data );
+		EAE_Engine::Core::CompleteOctree octree;
+		octree.InitFromMemory( &data[0], data.size() );
+	}
+	const double legacyMilliseconds = GetMilliseconds( timer ) / s_loadCount;
+
+	printf( "%u triangles, octree level %u, %u leaves\n", (uint32_t)triangles.size(), s_octreeLevel, built.GetCountOfNodesInLevel( s_octreeLevel - 1 ) );
+	printf( "%-26s %-12s %-10s\n", "format", "bytes", "load ms" );
+	printf( "%-26s %-12u %-10.3f\n", "compact, in place", (uint32_t)compact.size(), compactMilliseconds );
+	printf( "%-26s %-12u %-10.3f\n", "legacy, converted", (uint32_t)legacy.size(), legacyMilliseconds );
+	CleanScene();
+	return GetFailureCount() - failureCountBefore;
+}
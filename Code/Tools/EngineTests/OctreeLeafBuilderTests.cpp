@@ -0,0 +1,297 @@
+/*
+	The top-down BuildLeafTriangles of the exporters and the OctreeCompiler:
+	for a height field, a soup of triangles of many sizes with some of them lying on the planes between the leaves,
+	and the same soup moved far from the origin and scaled, the leaves must have the same triangles in the same order
+	as the old loop which tested every triangle against every leaf, at each level,
+	and the build split across 2, 3, 8 and all of the hardware threads must give the same leaves as the serial build.
+	It prints the time of the old loop, the serial build and the build with 4 workers at each level.
+*/
+
+// Header Files
+//=============
+
+#include "EngineTests.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <thread>
+
+#include "Engine/CollisionDetection/CollisionDetectionFunctions.h"
+#include "Engine/SpatialPartition/Octree.h"
+#include "Engine/SpatialPartition/OctreeLeafBuilder.h"
+
+// Helper Definitions
+//===================
+
+namespace
+{
+	const uint32_t s_gridSize = 48;
+	const float s_cellSize = 2.0f;
+	const uint32_t s_soupCount = 3000;
+	const float s_soupExtent = 50.0f;
+	// The old loop is 8 times slower at each level, so it is only run up to this level on every mesh.
+	const uint32_t s_maxReferenceLevel = 4;
+	const uint32_t s_maxLevel = 6;
+
+	double GetMilliseconds( std::chrono::high_resolution_clock::time_point i_start )
+	{
+		return std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - i_start ).count();
+	}
+
+	typedef std::vector<std::vector<EAE_Engine::Mesh::TriangleIndex> > LeafTriangles;
+
+	struct sMesh
+	{
+		const char* name;
+		std::vector<EAE_Engine::Math::Vector3> positions;
+		std::vector<EAE_Engine::Mesh::TriangleIndex> triangles;
+		EAE_Engine::Math::Vector3 min;
+		EAE_Engine::Math::Vector3 max;
+
+		void AddTriangle( const EAE_Engine::Math::Vector3& i_v0, const EAE_Engine::Math::Vector3& i_v1, const EAE_Engine::Math::Vector3& i_v2 )
+		{
+			const uint32_t first = (uint32_t)positions.size();
+			positions.push_back( i_v0 );
+			positions.push_back( i_v1 );
+			positions.push_back( i_v2 );
+			EAE_Engine::Mesh::TriangleIndex triangle = { first, first + 1, first + 2 };
+			triangles.push_back( triangle );
+		}
+
+		// The bounds with the margin of the exporter, so the flat meshes still have a volume.
+		void ComputeBounds()
+		{
+			min = positions[0];
+			max = positions[0];
+			for ( size_t index = 0; index < positions.size(); ++index )
+			{
+				const EAE_Engine::Math::Vector3& position = positions[index];
+				min = EAE_Engine::Math::Vector3( position._x < min._x ? position._x : min._x,
+					position._y < min._y ? position._y : min._y, position._z < min._z ? position._z : min._z );
+				max = EAE_Engine::Math::Vector3( position._x > max._x ? position._x : max._x,
+					position._y > max._y ? position._y : max._y, position._z > max._z ? position._z : max._z );
+			}
+			const EAE_Engine::Math::Vector3 margin( 1.0f, 1.0f, 1.0f );
+			min = min - margin;
+			max = max + margin;
+		}
+	};
+
+	void CreateHeightField( sMesh& o_mesh )
+	{
+		o_mesh.name = "height field";
+		const float half = s_gridSize * s_cellSize * 0.5f;
+		for ( uint32_t z = 0; z <= s_gridSize; ++z )
+		{
+			for ( uint32_t x = 0; x <= s_gridSize; ++x )
+			{
+				const float posX = x * s_cellSize - half;
+				const float posZ = z * s_cellSize - half;
+				o_mesh.positions.push_back( EAE_Engine::Math::Vector3( posX, 3.0f * std::sin( posX * 0.2f ) * std::cos( posZ * 0.15f ), posZ ) );
+			}
+		}
+		for ( uint32_t z = 0; z < s_gridSize; ++z )
+		{
+			for ( uint32_t x = 0; x < s_gridSize; ++x )
+			{
+				const uint32_t v00 = z * ( s_gridSize + 1 ) + x;
+				const uint32_t v10 = v00 + 1;
+				const uint32_t v01 = v00 + s_gridSize + 1;
+				const uint32_t v11 = v01 + 1;
+				const EAE_Engine::Mesh::TriangleIndex triangles[] = { { v00, v01, v11 }, { v00, v11, v10 } };
+				o_mesh.triangles.insert( o_mesh.triangles.end(), triangles, triangles + 2 );
+			}
+		}
+		o_mesh.ComputeBounds();
+	}
+
+	// Mostly small triangles, some slivers and a few which cross most of the leaves,
+	// and some lying on the center and the quarter planes of the bounds, which are between two leaves at every level past 2.
+	void CreateSoup( sMesh& o_mesh )
+	{
+		o_mesh.name = "soup";
+		std::mt19937 generator( 46 );
+		std::uniform_real_distribution<float> across( -s_soupExtent, s_soupExtent );
+		std::uniform_real_distribution<float> unit( 0.0f, 1.0f );
+		for ( uint32_t triangleIndex = 0; triangleIndex < s_soupCount; ++triangleIndex )
+		{
+			const EAE_Engine::Math::Vector3 center( across( generator ), across( generator ), across( generator ) );
+			const float kind = unit( generator );
+			const float size = kind < 0.05f ? 40.0f : ( kind < 0.3f ? 6.0f : 1.5f );
+			EAE_Engine::Math::Vector3 vertices[3];
+			for ( size_t vertexIndex = 0; vertexIndex < 3; ++vertexIndex )
+			{
+				vertices[vertexIndex] = center + EAE_Engine::Math::Vector3( unit( generator ) - 0.5f, unit( generator ) - 0.5f, unit( generator ) - 0.5f ) * size;
+				for ( size_t axis = 0; axis < 3; ++axis )
+					vertices[vertexIndex]._u[axis] = std::max( -s_soupExtent, std::min( s_soupExtent, vertices[vertexIndex]._u[axis] ) );
+			}
+			if ( triangleIndex % 20 == 0 )
+			{
+				// A sliver.
+				vertices[2] = vertices[1] + EAE_Engine::Math::Vector3( 1.0e-4f, 0.0f, 0.0f );
+			}
+			else if ( triangleIndex % 20 == 1 )
+			{
+				// The bounds are the extent of the soup and the margin of 1, so the quarter planes are at half of that.
+				const size_t axis = triangleIndex % 3;
+				const float planes[] = { 0.0f, ( s_soupExtent + 1.0f ) * 0.5f, -( s_soupExtent + 1.0f ) * 0.5f };
+				for ( size_t vertexIndex = 0; vertexIndex < 3; ++vertexIndex )
+					vertices[vertexIndex]._u[axis] = planes[( triangleIndex / 20 ) % 3];
+			}
+			o_mesh.AddTriangle( vertices[0], vertices[1], vertices[2] );
+		}
+		// The corners, so the bounds are always the extent of the soup.
+		const float extent = s_soupExtent;
+		o_mesh.AddTriangle( EAE_Engine::Math::Vector3( -extent, -extent, -extent ), EAE_Engine::Math::Vector3( -extent, -extent, -extent + 1.0f ),
+			EAE_Engine::Math::Vector3( -extent + 1.0f, -extent, -extent ) );
+		o_mesh.AddTriangle( EAE_Engine::Math::Vector3( extent, extent, extent ), EAE_Engine::Math::Vector3( extent, extent, extent - 1.0f ),
+			EAE_Engine::Math::Vector3( extent - 1.0f, extent, extent ) );
+		o_mesh.ComputeBounds();
+	}
+
+	// Far from the origin the rounding of the coordinates is much larger, which the margin of the inner nodes must cover.
+	void CreateFarSoup( const sMesh& i_soup, sMesh& o_mesh )
+	{
+		o_mesh = i_soup;
+		o_mesh.name = "soup far and scaled";
+		const EAE_Engine::Math::Vector3 offset( 12345.0f, -54321.0f, 777.0f );
+		for ( size_t index = 0; index < o_mesh.positions.size(); ++index )
+			o_mesh.positions[index] = o_mesh.positions[index] * 3.0f + offset;
+		o_mesh.ComputeBounds();
+	}
+
+	// The old exporter: every triangle against the box of every leaf of the CompleteOctree.
+	void BuildLeafTrianglesByEveryLeaf( uint32_t i_level, const sMesh& i_mesh, LeafTriangles& o_leafTriangles )
+	{
+		EAE_Engine::Core::CompleteOctree completeOctree;
+		completeOctree.InitFromRange( i_level, i_mesh.min, i_mesh.max );
+		const uint32_t leafLevelIndex = completeOctree.Level() - 1;
+		const uint32_t leafCount = completeOctree.GetCountOfNodesInLevel( leafLevelIndex );
+		EAE_Engine::Core::OctreeNode* pLeaves = completeOctree.GetNodesInLevel( leafLevelIndex );
+		o_leafTriangles.assign( leafCount, std::vector<EAE_Engine::Mesh::TriangleIndex>() );
+		for ( uint32_t leafIndex = 0; leafIndex < leafCount; ++leafIndex )
+		{
+			EAE_Engine::Math::AABBV1 aabb;
+			aabb._min = pLeaves[leafIndex].GetMin();
+			aabb._max = pLeaves[leafIndex].GetMax();
+			for ( size_t triangleIndex = 0; triangleIndex < i_mesh.triangles.size(); ++triangleIndex )
+			{
+				const EAE_Engine::Mesh::TriangleIndex& triangle = i_mesh.triangles[triangleIndex];
+				if ( EAE_Engine::Collision::TestTriangleAABB( i_mesh.positions[triangle._index0], i_mesh.positions[triangle._index1],
+					i_mesh.positions[triangle._index2], aabb ) )
+					o_leafTriangles[leafIndex].push_back( triangle );
+			}
+		}
+	}
+
+	// The same triangles in the same order in each leaf.
+	bool IsSameLeaves( const LeafTriangles& i_lhs, const LeafTriangles& i_rhs )
+	{
+		if ( i_lhs.size() != i_rhs.size() )
+			return false;
+		for ( size_t leafIndex = 0; leafIndex < i_lhs.size(); ++leafIndex )
+		{
+			if ( i_lhs[leafIndex].size() != i_rhs[leafIndex].size() )
+				return false;
+			for ( size_t index = 0; index < i_lhs[leafIndex].size(); ++index )
+			{
+				const EAE_Engine::Mesh::TriangleIndex& lhs = i_lhs[leafIndex][index];
+				const EAE_Engine::Mesh::TriangleIndex& rhs = i_rhs[leafIndex][index];
+				if ( lhs._index0 != rhs._index0 || lhs._index1 != rhs._index1 || lhs._index2 != rhs._index2 )
+					return false;
+			}
+		}
+		return true;
+	}
+
+	size_t GetReferenceCount( const LeafTriangles& i_leafTriangles )
+	{
+		size_t count = 0;
+		for ( size_t leafIndex = 0; leafIndex < i_leafTriangles.size(); ++leafIndex )
+			count += i_leafTriangles[leafIndex].size();
+		return count;
+	}
+}
+
+// Interface
+//==========
+
+int EngineTests::RunOctreeLeafBuilderTests()
+{
+	const int failureCountBefore = GetFailureCount();
+	sMesh meshes[3];
+	CreateHeightField( meshes[0] );
+	CreateSoup( meshes[1] );
+	CreateFarSoup( meshes[1], meshes[2] );
+	const uint32_t workerCounts[] = { 2, 3, 8, 0 };
+
+	printf( "%-22s %-6s %-10s %-12s %-12s %-12s\n", "mesh", "level", "refs", "old loop ms", "serial ms", "4 workers ms" );
+	for ( size_t meshIndex = 0; meshIndex < sizeof( meshes ) / sizeof( meshes[0] ); ++meshIndex )
+	{
+		const sMesh& mesh = meshes[meshIndex];
+		uint32_t referenceMismatchCount = 0;
+		uint32_t parallelMismatchCount = 0;
+		for ( uint32_t level = 1; level <= s_maxLevel; ++level )
+		{
+			LeafTriangles serial;
+			std::chrono::high_resolution_clock::time_point timer = std::chrono::high_resolution_clock::now();
+			EAE_Engine::Core::BuildLeafTriangles( level, mesh.min, mesh.max, mesh.positions, mesh.triangles, 1, serial );
+			const double serialMilliseconds = GetMilliseconds( timer );
+			ENGINE_TEST_CHECK( serial.size() == EAE_Engine::Core::CompleteOctree().GetCountOfNodesInLevel( level - 1 ) );
+			// Every triangle is inside the bounds, so it is in at least one leaf.
+			ENGINE_TEST_CHECK( GetReferenceCount( serial ) >= mesh.triangles.size() );
+
+			// The soup is also the benchmark of the old loop one level further.
+			double referenceMilliseconds = -1.0;
+			if ( level <= s_maxReferenceLevel || ( meshIndex == 1 && level == s_maxReferenceLevel + 1 ) )
+			{
+				LeafTriangles reference;
+				timer = std::chrono::high_resolution_clock::now();
+				BuildLeafTrianglesByEveryLeaf( level, mesh, reference );
+				referenceMilliseconds = GetMilliseconds( timer );
+				referenceMismatchCount += IsSameLeaves( serial, reference ) ? 0 : 1;
+			}
+
+			for ( size_t workerIndex = 0; workerIndex < sizeof( workerCounts ) / sizeof( workerCounts[0] ); ++workerIndex )
+			{
+				LeafTriangles parallel;
+				// Left over leaves must be cleared.
+				parallel.resize( 3 );
+				EAE_Engine::Core::BuildLeafTriangles( level, mesh.min, mesh.max, mesh.positions, mesh.triangles, workerCounts[workerIndex], parallel );
+				parallelMismatchCount += IsSameLeaves( serial, parallel ) ? 0 : 1;
+			}
+			// The 4 workers are timed on their own.
+			double parallelMilliseconds = 0.0;
+			{
+				LeafTriangles parallel;
+				timer = std::chrono::high_resolution_clock::now();
+				EAE_Engine::Core::BuildLeafTriangles( level, mesh.min, mesh.max, mesh.positions, mesh.triangles, 4, parallel );
+				parallelMilliseconds = GetMilliseconds( timer );
+				parallelMismatchCount += IsSameLeaves( serial, parallel ) ? 0 : 1;
+			}
+
+			if ( level < s_maxReferenceLevel )
+				continue;
+			char referenceText[32];
+			if ( referenceMilliseconds < 0.0 )
+				sprintf( referenceText, "-" );
+			else
+				sprintf( referenceText, "%.1f", referenceMilliseconds );
+			printf( "%-22s %-6u %-10u %-12s %-12.1f %-12.1f\n", mesh.name, level, (uint32_t)GetReferenceCount( serial ),
+				referenceText, serialMilliseconds, parallelMilliseconds );
+		}
+		ENGINE_TEST_CHECK( referenceMismatchCount == 0 );
+		ENGINE_TEST_CHECK( parallelMismatchCount == 0 );
+	}
+	// Level 0 has no leaves.
+	{
+		LeafTriangles empty( 2 );
+		EAE_Engine::Core::BuildLeafTriangles( 0, meshes[0].min, meshes[0].max, meshes[0].positions, meshes[0].triangles, 4, empty );
+		ENGINE_TEST_CHECK( empty.empty() );
+	}
+	printf( "%u hardware threads\n", std::thread::hardware_concurrency() );
+	return GetFailureCount() - failureCountBefore;
+}
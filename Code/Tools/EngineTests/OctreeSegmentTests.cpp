@@ -0,0 +1,299 @@
+/*
+	The stackless segment traversal of the CompleteOctree against the breadth first one it replaced:
+	the 3D DDA must visit the leaves crossed by the segment from near to far without a gap,
+	the same leaves GetLeavesCollideWithSegment finds apart from the ones only touched on a face,
+	and on 3 stacked height fields the hits of all of the leaves must be the ones of GetTrianlgesCollideWithSegment
+	in the same front to back order, and the first hit mode must stop at the closest of them.
+	It prints the queries per second of the first hit and all hits modes next to the breadth first path.
+*/
+
+// Header Files
+//=============
+
+#include "EngineTests.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+#include "Engine/CollisionDetection/CollisionDetectionFunctions.h"
+#include "Engine/SpatialPartition/Octree.h"
+
+// Helper Definitions
+//===================
+
+namespace
+{
+	const uint32_t s_gridSize = 48;
+	const float s_cellSize = 2.0f;
+	const uint32_t s_layerCount = 3;
+	const float s_layerSpacing = 4.0f;
+	const uint32_t s_octreeLevel = 5;
+	const uint32_t s_queryCount = 10000;
+	// More than the 3 layers a segment can cross, so the all hits mode never drops one.
+	const uint32_t s_maxHits = 16;
+	const float s_tolerance = 1.0e-5f;
+	const char* const s_meshKey = "OctreeSegmentLayers";
+
+	double GetMilliseconds( std::chrono::high_resolution_clock::time_point i_start )
+	{
+		return std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - i_start ).count();
+	}
+
+	// The rolling hills repeated at each layer, the triangles face +y.
+	void CreateLayers( std::vector<EAE_Engine::Math::Vector3>& o_positions, std::vector<uint32_t>& o_indices )
+	{
+		const float half = s_gridSize * s_cellSize * 0.5f;
+		for ( uint32_t layer = 0; layer < s_layerCount; ++layer )
+		{
+			const uint32_t first = (uint32_t)o_positions.size();
+			for ( uint32_t z = 0; z <= s_gridSize; ++z )
+			{
+				for ( uint32_t x = 0; x <= s_gridSize; ++x )
+				{
+					const float posX = x * s_cellSize - half;
+					const float posZ = z * s_cellSize - half;
+					const float posY = layer * s_layerSpacing + 1.5f * std::sin( posX * 0.2f + layer ) * std::cos( posZ * 0.15f );
+					o_positions.push_back( EAE_Engine::Math::Vector3( posX, posY, posZ ) );
+				}
+			}
+			for ( uint32_t z = 0; z < s_gridSize; ++z )
+			{
+				for ( uint32_t x = 0; x < s_gridSize; ++x )
+				{
+					const uint32_t v00 = first + z * ( s_gridSize + 1 ) + x;
+					const uint32_t v10 = v00 + 1;
+					const uint32_t v01 = v00 + s_gridSize + 1;
+					const uint32_t v11 = v01 + 1;
+					const uint32_t quad[] = { v00, v01, v11, v00, v11, v10 };
+					o_indices.insert( o_indices.end(), quad, quad + 6 );
+				}
+			}
+		}
+	}
+
+	float GetSegmentT( const std::vector<EAE_Engine::Math::Vector3>& i_positions, const EAE_Engine::Mesh::TriangleIndex& i_triangle,
+		const EAE_Engine::Math::Vector3& i_start, const EAE_Engine::Math::Vector3& i_end )
+	{
+		float u = 0.0f, v = 0.0f, w = 0.0f, t = -1.0f;
+		EAE_Engine::Collision::IntersectSegmentTriangle( i_start, i_end,
+			i_positions[i_triangle._index0], i_positions[i_triangle._index1], i_positions[i_triangle._index2], u, v, w, t );
+		return t;
+	}
+
+	bool IsBefore( const EAE_Engine::Core::SegmentHit& i_lhs, const EAE_Engine::Core::SegmentHit& i_rhs )
+	{
+		if ( i_lhs._t != i_rhs._t )
+			return i_lhs._t < i_rhs._t;
+		if ( i_lhs._triangle._index0 != i_rhs._triangle._index0 )
+			return i_lhs._triangle._index0 < i_rhs._triangle._index0;
+		if ( i_lhs._triangle._index1 != i_rhs._triangle._index1 )
+			return i_lhs._triangle._index1 < i_rhs._triangle._index1;
+		return i_lhs._triangle._index2 < i_rhs._triangle._index2;
+	}
+
+	// The hits of the breadth first path, each triangle once, with the t of each of them.
+	void GetBreadthFirstHits( EAE_Engine::Core::CompleteOctree& i_octree, const std::vector<EAE_Engine::Math::Vector3>& i_positions,
+		const EAE_Engine::Math::Vector3& i_start, const EAE_Engine::Math::Vector3& i_end, std::vector<EAE_Engine::Core::SegmentHit>& o_hits )
+	{
+		std::vector<EAE_Engine::Mesh::TriangleIndex> triangles;
+		i_octree.GetTrianlgesCollideWithSegment( i_start, i_end, triangles );
+		o_hits.clear();
+		for ( size_t index = 0; index < triangles.size(); ++index )
+		{
+			bool found = false;
+			for ( size_t hitIndex = 0; hitIndex < o_hits.size() && !found; ++hitIndex )
+				found = o_hits[hitIndex]._triangle == triangles[index];
+			if ( found )
+				continue;
+			EAE_Engine::Core::SegmentHit hit = { GetSegmentT( i_positions, triangles[index], i_start, i_end ), triangles[index] };
+			o_hits.push_back( hit );
+		}
+	}
+
+	// The length of the segment inside the node.
+	float GetClippedLength( const EAE_Engine::Core::OctreeNode& i_node, const EAE_Engine::Math::Vector3& i_start, const EAE_Engine::Math::Vector3& i_end )
+	{
+		const EAE_Engine::Math::Vector3 delta = i_end - i_start;
+		float tEnter = 0.0f;
+		float tExit = 1.0f;
+		for ( size_t axis = 0; axis < 3; ++axis )
+		{
+			const float minPos = i_node._pos._u[axis] - i_node._extent._u[axis];
+			const float maxPos = i_node._pos._u[axis] + i_node._extent._u[axis];
+			if ( delta._u[axis] == 0.0f )
+			{
+				if ( i_start._u[axis] < minPos || i_start._u[axis] > maxPos )
+					return 0.0f;
+				continue;
+			}
+			float t0 = ( minPos - i_start._u[axis] ) / delta._u[axis];
+			float t1 = ( maxPos - i_start._u[axis] ) / delta._u[axis];
+			if ( t0 > t1 )
+				std::swap( t0, t1 );
+			tEnter = std::max( tEnter, t0 );
+			tExit = std::min( tExit, t1 );
+		}
+		return tExit > tEnter ? ( tExit - tEnter ) * delta.Magnitude() : 0.0f;
+	}
+
+	// The leaves visited by the DDA must follow each other without a gap, and be the leaves of the breadth first path
+	// apart from the ones the segment only touches.
+	bool IsSameLeafWalk( EAE_Engine::Core::CompleteOctree& i_octree, const EAE_Engine::Math::Vector3& i_start, const EAE_Engine::Math::Vector3& i_end )
+	{
+		std::vector<const EAE_Engine::Core::OctreeNode*> visited;
+		float lastExit = -1.0f;
+		bool contiguous = true;
+		i_octree.VisitNodesAlongSegment( i_start, i_end, i_octree.Level() - 1,
+			[&visited, &lastExit, &contiguous]( const EAE_Engine::Core::OctreeNode& i_leaf, float i_tEnter, float i_tExit )
+		{
+			contiguous = contiguous && i_tEnter <= i_tExit && ( lastExit < 0.0f || std::fabs( i_tEnter - lastExit ) <= s_tolerance );
+			lastExit = i_tExit;
+			visited.push_back( &i_leaf );
+			return true;
+		} );
+		if ( !contiguous )
+			return false;
+		std::vector<EAE_Engine::Core::OctreeNode*> leaves = i_octree.GetLeavesCollideWithSegment( i_start, i_end );
+		for ( size_t index = 0; index < visited.size(); ++index )
+		{
+			if ( std::find( leaves.begin(), leaves.end(), visited[index] ) == leaves.end() &&
+				GetClippedLength( *visited[index], i_start, i_end ) > s_tolerance )
+				return false;
+		}
+		for ( size_t index = 0; index < leaves.size(); ++index )
+		{
+			if ( std::find( visited.begin(), visited.end(), leaves[index] ) == visited.end() &&
+				GetClippedLength( *leaves[index], i_start, i_end ) > s_tolerance )
+				return false;
+		}
+		return true;
+	}
+}
+
+// Interface
+//==========
+
+int EngineTests::RunOctreeSegmentTests()
+{
+	const int failureCountBefore = GetFailureCount();
+	std::vector<EAE_Engine::Math::Vector3> positions;
+	std::vector<uint32_t> indices;
+	CreateLayers( positions, indices );
+	CreateCollisionMesh( s_meshKey, positions, indices, s_octreeLevel );
+	EAE_Engine::Core::CompleteOctree& octree = *EAE_Engine::Core::OctreeManager::GetInstance()->GetOctree( s_meshKey );
+
+	// Falling segments through the layers, oblique ones across them, and a few along the axes,
+	// which the DDA steps with 0 on the other axes.
+	std::mt19937 generator( 42 );
+	const float half = s_gridSize * s_cellSize * 0.5f;
+	std::uniform_real_distribution<float> across( -half, half );
+	std::uniform_real_distribution<float> height( -4.0f, s_layerCount * s_layerSpacing + 2.0f );
+	std::vector<EAE_Engine::Math::Vector3> starts( s_queryCount );
+	std::vector<EAE_Engine::Math::Vector3> ends( s_queryCount );
+	for ( uint32_t queryIndex = 0; queryIndex < s_queryCount; ++queryIndex )
+	{
+		const EAE_Engine::Math::Vector3 start( across( generator ), s_layerCount * s_layerSpacing + 2.0f, across( generator ) );
+		switch ( queryIndex % 4 )
+		{
+		case 0:
+		case 1:
+			starts[queryIndex] = start;
+			ends[queryIndex] = start + EAE_Engine::Math::Vector3( across( generator ) * 0.2f, height( generator ) - start._y, across( generator ) * 0.2f );
+			break;
+		case 2:
+			starts[queryIndex] = EAE_Engine::Math::Vector3( start._x, height( generator ), start._z );
+			ends[queryIndex] = EAE_Engine::Math::Vector3( across( generator ), height( generator ), across( generator ) );
+			break;
+		default:
+			starts[queryIndex] = start;
+			ends[queryIndex] = EAE_Engine::Math::Vector3( start._x, -4.0f, start._z );
+			break;
+		}
+	}
+
+	uint32_t walkMismatchCount = 0;
+	uint32_t allHitsMismatchCount = 0;
+	uint32_t orderMismatchCount = 0;
+	uint32_t firstHitMismatchCount = 0;
+	uint32_t totalHitCount = 0;
+	uint32_t multiHitQueryCount = 0;
+	std::vector<EAE_Engine::Core::SegmentHit> expected;
+	EAE_Engine::Core::SegmentHit hits[s_maxHits];
+	for ( uint32_t queryIndex = 0; queryIndex < s_queryCount; ++queryIndex )
+	{
+		const EAE_Engine::Math::Vector3& start = starts[queryIndex];
+		const EAE_Engine::Math::Vector3& end = ends[queryIndex];
+		walkMismatchCount += IsSameLeafWalk( octree, start, end ) ? 0 : 1;
+
+		GetBreadthFirstHits( octree, positions, start, end, expected );
+		const uint32_t hitCount = octree.GetTrianlgesCollideWithSegment( start, end, hits, s_maxHits );
+		totalHitCount += hitCount;
+		multiHitQueryCount += hitCount > 1 ? 1 : 0;
+		for ( uint32_t hitIndex = 1; hitIndex < hitCount; ++hitIndex )
+			orderMismatchCount += hits[hitIndex - 1]._t <= hits[hitIndex]._t ? 0 : 1;
+		// The triangles hit at the same t may come in either order, so both lists are compared by t and then triangle.
+		std::vector<EAE_Engine::Core::SegmentHit> found( hits, hits + hitCount );
+		std::sort( found.begin(), found.end(), IsBefore );
+		std::sort( expected.begin(), expected.end(), IsBefore );
+		bool same = found.size() == expected.size();
+		for ( size_t hitIndex = 0; same && hitIndex < found.size(); ++hitIndex )
+			same = found[hitIndex]._triangle == expected[hitIndex]._triangle && found[hitIndex]._t == expected[hitIndex]._t;
+		allHitsMismatchCount += same ? 0 : 1;
+
+		EAE_Engine::Core::SegmentHit firstHit;
+		const uint32_t firstCount = octree.GetTrianlgesCollideWithSegment( start, end, &firstHit, 1 );
+		if ( firstCount != ( expected.empty() ? 0u : 1u ) || ( firstCount == 1 && firstHit._t != expected[0]._t ) )
+			++firstHitMismatchCount;
+	}
+	ENGINE_TEST_CHECK( walkMismatchCount == 0 );
+	ENGINE_TEST_CHECK( allHitsMismatchCount == 0 );
+	ENGINE_TEST_CHECK( orderMismatchCount == 0 );
+	ENGINE_TEST_CHECK( firstHitMismatchCount == 0 );
+	// The falling segments cross more than one layer.
+	ENGINE_TEST_CHECK( multiHitQueryCount > s_queryCount / 4 );
+
+	// The closest hit of a segment outside of the octree, and of one starting inside of it.
+	{
+		EAE_Engine::Core::SegmentHit firstHit;
+		ENGINE_TEST_CHECK( octree.GetTrianlgesCollideWithSegment( EAE_Engine::Math::Vector3( 2.0f * half, 50.0f, 0.0f ),
+			EAE_Engine::Math::Vector3( 2.0f * half, -50.0f, 0.0f ), &firstHit, 1 ) == 0 );
+		const EAE_Engine::Math::Vector3 start( 1.3f, s_layerSpacing - 2.0f, 0.7f );
+		const EAE_Engine::Math::Vector3 end( 1.3f, -4.0f, 0.7f );
+		GetBreadthFirstHits( octree, positions, start, end, expected );
+		ENGINE_TEST_CHECK( octree.GetTrianlgesCollideWithSegment( start, end, &firstHit, 1 ) == 1 && expected.size() == 1 &&
+			firstHit._triangle == expected[0]._triangle );
+	}
+
+	uint32_t firstFoundCount = 0;
+	std::chrono::high_resolution_clock::time_point timer = std::chrono::high_resolution_clock::now();
+	for ( uint32_t queryIndex = 0; queryIndex < s_queryCount; ++queryIndex )
+		firstFoundCount += octree.GetTrianlgesCollideWithSegment( starts[queryIndex], ends[queryIndex], hits, 1 );
+	const double firstMilliseconds = GetMilliseconds( timer );
+	uint32_t allFoundCount = 0;
+	timer = std::chrono::high_resolution_clock::now();
+	for ( uint32_t queryIndex = 0; queryIndex < s_queryCount; ++queryIndex )
+		allFoundCount += octree.GetTrianlgesCollideWithSegment( starts[queryIndex], ends[queryIndex], hits, s_maxHits );
+	const double allMilliseconds = GetMilliseconds( timer );
+	uint32_t breadthFirstFoundCount = 0;
+	timer = std::chrono::high_resolution_clock::now();
+	for ( uint32_t queryIndex = 0; queryIndex < s_queryCount; ++queryIndex )
+	{
+		std::vector<EAE_Engine::Mesh::TriangleIndex> triangles;
+		octree.GetTrianlgesCollideWithSegment( starts[queryIndex], ends[queryIndex], triangles );
+		breadthFirstFoundCount += triangles.empty() ? 0 : 1;
+	}
+	const double breadthFirstMilliseconds = GetMilliseconds( timer );
+	ENGINE_TEST_CHECK( allFoundCount == totalHitCount && breadthFirstFoundCount == firstFoundCount );
+
+	printf( "%u triangles in %u layers, octree level %u, %u segments, %u hits\n",
+		(uint32_t)indices.size() / 3, s_layerCount, s_octreeLevel, s_queryCount, totalHitCount );
+	printf( "%-34s %-14s %-10s\n", "path", "queries/s", "hits" );
+	printf( "%-34s %-14.0f %u\n", "DDA, first hit", s_queryCount * 1000.0 / firstMilliseconds, firstFoundCount );
+	printf( "%-34s %-14.0f %u\n", "DDA, all hits", s_queryCount * 1000.0 / allMilliseconds, allFoundCount );
+	printf( "%-34s %-14.0f %u\n", "breadth first, gather and sort", s_queryCount * 1000.0 / breadthFirstMilliseconds, breadthFirstFoundCount );
+	CleanScene();
+	return GetFailureCount() - failureCountBefore;
+}
@@ -0,0 +1,312 @@
+/*
+	The round trips of Quantization against their documented error bounds:
+	every half goes back to itself, every midpoint between two halves rounds to the even one,
+	the denormals, the infinities and the NaNs keep their kind, and the batch versions give the same bits.
+	The smallest three quaternions, the octahedral normals and the fixed point values stay inside of their bounds.
+	It also prints how many values each encoding converts in a microsecond.
+*/
+
+// Header Files
+//=============
+
+#include "EngineTests.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+
+#include "Engine/Math/Quantization.h"
+
+// Helper Definitions
+//===================
+
+namespace
+{
+	const uint32_t s_randomCount = 100000;
+	const uint32_t s_benchmarkCount = 1 << 16;
+	const uint32_t s_benchmarkRepeatCount = 50;
+
+	uint32_t FloatAsUInt( float i_value )
+	{
+		uint32_t result;
+		memcpy( &result, &i_value, sizeof( float ) );
+		return result;
+	}
+
+	float UIntAsFloat( uint32_t i_value )
+	{
+		float result;
+		memcpy( &result, &i_value, sizeof( float ) );
+		return result;
+	}
+
+	bool IsHalfNaN( uint16_t i_half )
+	{
+		return ( i_half & 0x7c00u ) == 0x7c00u && ( i_half & 0x03ffu ) != 0;
+	}
+
+	// A random unit quaternion, the 4 components from a normal distribution give a uniform rotation.
+	EAE_Engine::Math::Quaternion GetRandomRotation( std::mt19937& io_random )
+	{
+		std::normal_distribution<float> normal( 0.0f, 1.0f );
+		EAE_Engine::Math::Quaternion rotation( normal( io_random ), normal( io_random ), normal( io_random ), normal( io_random ) );
+		return rotation.CreateNormalized();
+	}
+
+	double GetValuesPerMicrosecond( std::chrono::high_resolution_clock::time_point i_start, uint32_t i_valueCount )
+	{
+		return i_valueCount / std::chrono::duration<double, std::micro>( std::chrono::high_resolution_clock::now() - i_start ).count();
+	}
+
+	void TestHalves()
+	{
+		// Each half goes back to the same bits, the NaNs only stay NaN with the same sign.
+		uint32_t roundTripMismatchCount = 0;
+		for ( uint32_t half = 0; half <= 0xffff; ++half )
+		{
+			const uint16_t roundTrip = EAE_Engine::Math::FloatToHalf( EAE_Engine::Math::HalfToFloat( (uint16_t)half ) );
+			if ( IsHalfNaN( (uint16_t)half ) ? !IsHalfNaN( roundTrip ) || ( roundTrip & 0x8000u ) != ( half & 0x8000u ) : roundTrip != half )
+				++roundTripMismatchCount;
+		}
+		ENGINE_TEST_CHECK( roundTripMismatchCount == 0 );
+
+		// The float exactly between two halves goes to the even one, the floats next to it to the nearer one.
+		// This covers all of the denormals, all of the normals and the overflow after 65504.
+		uint32_t roundingMismatchCount = 0;
+		for ( uint32_t half = 0; half < 0x7c00u; ++half )
+		{
+			const float low = EAE_Engine::Math::HalfToFloat( (uint16_t)half );
+			const float high = half + 1 == 0x7c00u ? 65536.0f : EAE_Engine::Math::HalfToFloat( (uint16_t)( half + 1 ) );
+			const float middle = ( low + high ) * 0.5f;
+			const uint16_t even = (uint16_t)( ( half & 1 ) == 0 ? half : half + 1 );
+			roundingMismatchCount += EAE_Engine::Math::FloatToHalf( middle ) != even ? 1 : 0;
+			roundingMismatchCount += EAE_Engine::Math::FloatToHalf( UIntAsFloat( FloatAsUInt( middle ) - 1 ) ) != half ? 1 : 0;
+			roundingMismatchCount += EAE_Engine::Math::FloatToHalf( UIntAsFloat( FloatAsUInt( middle ) + 1 ) ) != half + 1 ? 1 : 0;
+			// The negative ones only add the sign.
+			roundingMismatchCount += EAE_Engine::Math::FloatToHalf( -middle ) != ( even | 0x8000u ) ? 1 : 0;
+		}
+		ENGINE_TEST_CHECK( roundingMismatchCount == 0 );
+
+		// The edges.
+		const float infinity = std::numeric_limits<float>::infinity();
+		ENGINE_TEST_CHECK( EAE_Engine::Math::FloatToHalf( 65504.0f ) == 0x7bffu );
+		ENGINE_TEST_CHECK( EAE_Engine::Math::FloatToHalf( 1.0e6f ) == 0x7c00u );
+		ENGINE_TEST_CHECK( EAE_Engine::Math::FloatToHalf( infinity ) == 0x7c00u );
+		ENGINE_TEST_CHECK( EAE_Engine::Math::FloatToHalf( -infinity ) == 0xfc00u );
+		ENGINE_TEST_CHECK( IsHalfNaN( EAE_Engine::Math::FloatToHalf( std::numeric_limits<float>::quiet_NaN() ) ) );
+		ENGINE_TEST_CHECK( IsHalfNaN( EAE_Engine::Math::FloatToHalf( -std::numeric_limits<float>::quiet_NaN() ) ) );
+		ENGINE_TEST_CHECK( std::isnan( EAE_Engine::Math::HalfToFloat( 0x7e00u ) ) );
+		ENGINE_TEST_CHECK( EAE_Engine::Math::HalfToFloat( 0x7c00u ) == infinity );
+		ENGINE_TEST_CHECK( EAE_Engine::Math::FloatToHalf( -0.0f ) == 0x8000u );
+		ENGINE_TEST_CHECK( FloatAsUInt( EAE_Engine::Math::HalfToFloat( 0x8000u ) ) == 0x80000000u );
+		// The smallest denormal is 2^-24, half of it rounds to the even 0 and the float denormals become 0.
+		ENGINE_TEST_CHECK( EAE_Engine::Math::HalfToFloat( 0x0001u ) == std::ldexp( 1.0f, -24 ) );
+		ENGINE_TEST_CHECK( EAE_Engine::Math::FloatToHalf( std::ldexp( 1.0f, -25 ) ) == 0 );
+		ENGINE_TEST_CHECK( EAE_Engine::Math::FloatToHalf( std::numeric_limits<float>::denorm_min() ) == 0 );
+		ENGINE_TEST_CHECK( EAE_Engine::Math::FloatToHalf( std::ldexp( 1.0f, -14 ) ) == 0x0400u );
+
+		// The relative error of the normals is at most 2^-11.
+		std::mt19937 random( 27 );
+		std::uniform_real_distribution<float> exponent( -14.0f, 15.9f );
+		std::uniform_real_distribution<float> unit( -1.0f, 1.0f );
+		float maxRelativeError = 0.0f;
+		std::vector<float> floats( s_randomCount );
+		for ( uint32_t valueIndex = 0; valueIndex < s_randomCount; ++valueIndex )
+		{
+			const float value = std::pow( 2.0f, exponent( random ) ) * ( unit( random ) < 0.0f ? -1.0f : 1.0f );
+			floats[valueIndex] = value;
+			const float relativeError = std::fabs( EAE_Engine::Math::HalfToFloat( EAE_Engine::Math::FloatToHalf( value ) ) - value ) / std::fabs( value );
+			maxRelativeError = relativeError > maxRelativeError ? relativeError : maxRelativeError;
+		}
+		ENGINE_TEST_CHECK( maxRelativeError <= std::ldexp( 1.0f, -11 ) );
+
+		// The batch versions give the same bits as the single ones, an odd count also runs the tail.
+		const float specials[] = { 0.0f, -0.0f, infinity, -infinity, std::numeric_limits<float>::quiet_NaN(), 65504.0f, 65520.0f,
+			std::ldexp( 1.0f, -24 ), std::ldexp( 1.5f, -24 ), std::ldexp( 1.0f, -25 ), std::numeric_limits<float>::denorm_min(), 1.0e-20f };
+		for ( size_t specialIndex = 0; specialIndex < sizeof( specials ) / sizeof( specials[0] ); ++specialIndex )
+			floats[specialIndex * 7] = specials[specialIndex];
+		const size_t batchCount = s_randomCount - 3;
+		std::vector<uint16_t> halves( batchCount );
+		EAE_Engine::Math::FloatsToHalves( &floats[0], &halves[0], batchCount );
+		uint32_t batchMismatchCount = 0;
+		for ( size_t valueIndex = 0; valueIndex < batchCount; ++valueIndex )
+			batchMismatchCount += halves[valueIndex] != EAE_Engine::Math::FloatToHalf( floats[valueIndex] ) ? 1 : 0;
+		std::vector<uint16_t> allHalves( 0x10000 );
+		for ( uint32_t half = 0; half <= 0xffff; ++half )
+			allHalves[half] = (uint16_t)half;
+		std::vector<float> allFloats( 0x10000 );
+		EAE_Engine::Math::HalvesToFloats( &allHalves[0], &allFloats[0], allHalves.size() );
+		for ( uint32_t half = 0; half <= 0xffff; ++half )
+			batchMismatchCount += FloatAsUInt( allFloats[half] ) != FloatAsUInt( EAE_Engine::Math::HalfToFloat( (uint16_t)half ) ) ? 1 : 0;
+		ENGINE_TEST_CHECK( batchMismatchCount == 0 );
+	}
+
+	void TestQuaternions()
+	{
+		std::mt19937 random( 270 );
+		float maxComponentError = 0.0f;
+		float maxVectorError = 0.0f;
+		uint32_t negativeWCount = 0;
+		uint32_t signMismatchCount = 0;
+		const EAE_Engine::Math::Vector3 axis( 0.3f, 0.5f, 0.81f );
+		for ( uint32_t rotationIndex = 0; rotationIndex < s_randomCount; ++rotationIndex )
+		{
+			const EAE_Engine::Math::Quaternion rotation = GetRandomRotation( random );
+			const uint32_t quantized = EAE_Engine::Math::QuantizeQuaternion( rotation );
+			const EAE_Engine::Math::Quaternion decoded = EAE_Engine::Math::DequantizeQuaternion( quantized );
+			// The decoded one is q or -q, the largest component comes back positive.
+			const float sign = EAE_Engine::Math::Dot( rotation, decoded ) < 0.0f ? -1.0f : 1.0f;
+			const float componentErrors[] = { std::fabs( decoded.w() - sign * rotation.w() ), std::fabs( decoded.x() - sign * rotation.x() ),
+				std::fabs( decoded.y() - sign * rotation.y() ), std::fabs( decoded.z() - sign * rotation.z() ) };
+			for ( uint32_t component = 0; component < 4; ++component )
+				maxComponentError = componentErrors[component] > maxComponentError ? componentErrors[component] : maxComponentError;
+			const float vectorError = ( EAE_Engine::Math::Quaternion::MultiVector( decoded, axis ) - EAE_Engine::Math::Quaternion::MultiVector( rotation, axis ) ).Magnitude();
+			maxVectorError = vectorError > maxVectorError ? vectorError : maxVectorError;
+			// -q drops the same component and stores the same three, so it has the same bits.
+			const EAE_Engine::Math::Quaternion negated( -rotation.w(), -rotation.x(), -rotation.y(), -rotation.z() );
+			signMismatchCount += EAE_Engine::Math::QuantizeQuaternion( negated ) != quantized ? 1 : 0;
+			if ( rotation.w() < 0.0f )
+			{
+				++negativeWCount;
+				// A dropped w always comes back positive, so a negative w is flipped with the rest of q.
+				if ( ( quantized & 0x3 ) == 0 && ( decoded.w() < 0.0f || sign > 0.0f ) )
+					++signMismatchCount;
+			}
+		}
+		ENGINE_TEST_CHECK( maxComponentError <= EAE_Engine::Math::s_quaternionMaxError );
+		ENGINE_TEST_CHECK( maxVectorError < 4.0f * EAE_Engine::Math::s_quaternionMaxError );
+		ENGINE_TEST_CHECK( signMismatchCount == 0 );
+		ENGINE_TEST_CHECK( negativeWCount > s_randomCount / 4 );
+		printf( "smallest three: largest component error %.6f (bound %.6f), largest error of a turned vector %.6f\n",
+			maxComponentError, EAE_Engine::Math::s_quaternionMaxError, maxVectorError );
+	}
+
+	void TestNormalsAndFixedPoint()
+	{
+		std::mt19937 random( 2700 );
+		std::normal_distribution<float> normal( 0.0f, 1.0f );
+		float maxAngle = 0.0f;
+		for ( uint32_t normalIndex = 0; normalIndex < s_randomCount; ++normalIndex )
+		{
+			EAE_Engine::Math::Vector3 direction( normal( random ), normal( random ), normal( random ) );
+			// The axes and the diagonals are the corners and the folds of the octahedron.
+			if ( normalIndex < 6 )
+				direction = EAE_Engine::Math::Vector3( normalIndex % 3 == 0 ? 1.0f : 0.0f, normalIndex % 3 == 1 ? 1.0f : 0.0f, normalIndex % 3 == 2 ? 1.0f : 0.0f ) * ( normalIndex < 3 ? 1.0f : -1.0f );
+			else if ( normalIndex < 14 )
+				direction = EAE_Engine::Math::Vector3( normalIndex & 1 ? 1.0f : -1.0f, normalIndex & 2 ? 1.0f : -1.0f, normalIndex & 4 ? 1.0f : -1.0f );
+			direction = direction.GetNormalize();
+			const EAE_Engine::Math::Vector3 decoded = EAE_Engine::Math::DequantizeNormal( EAE_Engine::Math::QuantizeNormal( direction ) );
+			const float cosine = decoded.Dot( direction );
+			// acos loses the small angles, the cross product keeps them.
+			const float angle = std::atan2( EAE_Engine::Math::Vector3::Cross( decoded, direction ).Magnitude(), cosine );
+			maxAngle = angle > maxAngle ? angle : maxAngle;
+		}
+		ENGINE_TEST_CHECK( maxAngle < 1.0e-4f );
+		printf( "octahedral normals: largest angle %.7f radian\n", maxAngle );
+
+		// The fixed point values are off by half of a step at most, and the ones outside of the range are clamped.
+		const uint32_t bitCounts[] = { 1, 8, 12, 16, 21, 24 };
+		std::uniform_real_distribution<float> inside( -50.0f, 150.0f );
+		uint32_t fixedPointMismatchCount = 0;
+		for ( size_t bitCountIndex = 0; bitCountIndex < sizeof( bitCounts ) / sizeof( bitCounts[0] ); ++bitCountIndex )
+		{
+			const EAE_Engine::Math::FixedPointRange range( -50.0f, 150.0f, bitCounts[bitCountIndex] );
+			// The float rounding of the step adds a few ulps of 150 to the half step.
+			const float bound = range.GetMaxError() + 4.0f * 150.0f * std::numeric_limits<float>::epsilon();
+			for ( uint32_t valueIndex = 0; valueIndex < s_randomCount / 10; ++valueIndex )
+			{
+				const float value = inside( random );
+				const uint32_t quantized = range.Quantize( value );
+				if ( quantized >> bitCounts[bitCountIndex] != 0 || std::fabs( range.Dequantize( quantized ) - value ) > bound )
+					++fixedPointMismatchCount;
+			}
+			fixedPointMismatchCount += range.Dequantize( range.Quantize( -50.0f ) ) != -50.0f ? 1 : 0;
+			fixedPointMismatchCount += range.Dequantize( range.Quantize( 150.0f ) ) != 150.0f ? 1 : 0;
+			fixedPointMismatchCount += range.Dequantize( range.Quantize( -1.0e6f ) ) != -50.0f ? 1 : 0;
+			fixedPointMismatchCount += range.Dequantize( range.Quantize( 1.0e6f ) ) != 150.0f ? 1 : 0;
+		}
+		// The packed vector holds the same three values as the unpacked one.
+		const EAE_Engine::Math::FixedPointVector3 vectorRange( EAE_Engine::Math::Vector3( -50.0f, 0.0f, -50.0f ), EAE_Engine::Math::Vector3( 150.0f, 20.0f, 50.0f ), 21 );
+		for ( uint32_t valueIndex = 0; valueIndex < s_randomCount / 10; ++valueIndex )
+		{
+			const EAE_Engine::Math::Vector3 value( inside( random ), inside( random ) * 0.1f + 5.0f, inside( random ) - 50.0f );
+			const EAE_Engine::Math::Vector3 unpacked = vectorRange.Dequantize( vectorRange.Quantize( value ) );
+			const EAE_Engine::Math::Vector3 packed = vectorRange.DequantizePacked( vectorRange.QuantizePacked( value ) );
+			if ( ( unpacked - packed ).SqMagnitude() != 0.0f )
+				++fixedPointMismatchCount;
+		}
+		ENGINE_TEST_CHECK( fixedPointMismatchCount == 0 );
+	}
+
+	void PrintThroughput()
+	{
+		std::mt19937 random( 27000 );
+		std::uniform_real_distribution<float> unit( -100.0f, 100.0f );
+		std::vector<float> floats( s_benchmarkCount );
+		for ( uint32_t valueIndex = 0; valueIndex < s_benchmarkCount; ++valueIndex )
+			floats[valueIndex] = unit( random );
+		std::vector<uint16_t> halves( s_benchmarkCount );
+		std::vector<float> decodedFloats( s_benchmarkCount );
+		const uint32_t valueCount = s_benchmarkCount * s_benchmarkRepeatCount;
+
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		for ( uint32_t repeat = 0; repeat < s_benchmarkRepeatCount; ++repeat )
+		{
+			for ( uint32_t valueIndex = 0; valueIndex < s_benchmarkCount; ++valueIndex )
+				halves[valueIndex] = EAE_Engine::Math::FloatToHalf( floats[valueIndex] );
+		}
+		const double floatToHalfRate = GetValuesPerMicrosecond( start, valueCount );
+		start = std::chrono::high_resolution_clock::now();
+		for ( uint32_t repeat = 0; repeat < s_benchmarkRepeatCount; ++repeat )
+			EAE_Engine::Math::FloatsToHalves( &floats[0], &halves[0], s_benchmarkCount );
+		const double floatsToHalvesRate = GetValuesPerMicrosecond( start, valueCount );
+		start = std::chrono::high_resolution_clock::now();
+		for ( uint32_t repeat = 0; repeat < s_benchmarkRepeatCount; ++repeat )
+		{
+			for ( uint32_t valueIndex = 0; valueIndex < s_benchmarkCount; ++valueIndex )
+				decodedFloats[valueIndex] = EAE_Engine::Math::HalfToFloat( halves[valueIndex] );
+		}
+		const double halfToFloatRate = GetValuesPerMicrosecond( start, valueCount );
+		start = std::chrono::high_resolution_clock::now();
+		for ( uint32_t repeat = 0; repeat < s_benchmarkRepeatCount; ++repeat )
+			EAE_Engine::Math::HalvesToFloats( &halves[0], &decodedFloats[0], s_benchmarkCount );
+		const double halvesToFloatsRate = GetValuesPerMicrosecond( start, valueCount );
+		printf( "halves per us: FloatToHalf %.0f, FloatsToHalves %.0f, HalfToFloat %.0f, HalvesToFloats %.0f\n",
+			floatToHalfRate, floatsToHalvesRate, halfToFloatRate, halvesToFloatsRate );
+
+		std::vector<EAE_Engine::Math::Quaternion> rotations( s_benchmarkCount );
+		std::vector<uint32_t> quantized( s_benchmarkCount );
+		for ( uint32_t valueIndex = 0; valueIndex < s_benchmarkCount; ++valueIndex )
+			rotations[valueIndex] = GetRandomRotation( random );
+		start = std::chrono::high_resolution_clock::now();
+		for ( uint32_t valueIndex = 0; valueIndex < s_benchmarkCount; ++valueIndex )
+			quantized[valueIndex] = EAE_Engine::Math::QuantizeQuaternion( rotations[valueIndex] );
+		const double quantizeRate = GetValuesPerMicrosecond( start, s_benchmarkCount );
+		start = std::chrono::high_resolution_clock::now();
+		for ( uint32_t valueIndex = 0; valueIndex < s_benchmarkCount; ++valueIndex )
+			rotations[valueIndex] = EAE_Engine::Math::DequantizeQuaternion( quantized[valueIndex] );
+		const double dequantizeRate = GetValuesPerMicrosecond( start, s_benchmarkCount );
+		start = std::chrono::high_resolution_clock::now();
+		for ( uint32_t valueIndex = 0; valueIndex < s_benchmarkCount; ++valueIndex )
+			quantized[valueIndex] = EAE_Engine::Math::QuantizeNormal( EAE_Engine::Math::Quaternion::MultiVector( rotations[valueIndex], EAE_Engine::Math::Vector3( 0.0f, 1.0f, 0.0f ) ) );
+		const double normalRate = GetValuesPerMicrosecond( start, s_benchmarkCount );
+		printf( "values per us: QuantizeQuaternion %.0f, DequantizeQuaternion %.0f, QuantizeNormal with the turn %.0f (checksum %u)\n",
+			quantizeRate, dequantizeRate, normalRate, quantized[s_benchmarkCount / 2] ^ halves[s_benchmarkCount / 3] );
+	}
+}
+
+// Interface
+//==========
+
+int EngineTests::RunQuantizationTests()
+{
+	const int failureCountBefore = GetFailureCount();
+	TestHalves();
+	TestQuaternions();
+	TestNormalsAndFixedPoint();
+	PrintThroughput();
+	return GetFailureCount() - failureCountBefore;
+}
@@ -0,0 +1,321 @@
+/*
+	The SATPairCache of the OBBColliders:
+	SwapAxis must map each of the 15 axes to the same axis with the boxes swapped, so the pair tested as (B, A) still starts on its separating axis,
+	RemoveCollider must forget exactly the pairs of the Collider, and DetectCollision must give the same result as the SAT test on all of the 15 axes
+	which rejects the pair only at the end, like before the cache, for the boxes meeting, staying apart, leaving and meeting after the step,
+	and for the 300 rotated boxes moving in a small room for 120 steps.
+	It prints how many tests exit after the cached axis, and the ns per pair with the cache against the test of all of the axes.
+*/
+
+// Header Files
+//=============
+
+#include "EngineTests.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <unordered_map>
+
+#include "Engine/CollisionDetection/ColliderBase.h"
+#include "Engine/CollisionDetection/OBBCollider.h"
+#include "Engine/CollisionDetection/RigidBody.h"
+#include "Engine/CollisionDetection/SweepAndPrune.h"
+#include "Engine/Math/ColMatrix.h"
+
+// Helper Definitions
+//===================
+
+namespace
+{
+	const uint32_t s_boxCount = 300;
+	const uint32_t s_stepCount = 120;
+	const float s_timeStep = 1.0f / 60.0f;
+	const float s_roomExtent = 20.0f;
+	const float s_maxSpeed = 6.0f;
+
+	double GetMilliseconds( std::chrono::high_resolution_clock::time_point i_start )
+	{
+		return std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - i_start ).count();
+	}
+
+	// A box with a RigidBody, so DetectCollision moves it by its velocity.
+	struct sBox
+	{
+		EngineTests::TestTransform transform;
+		EAE_Engine::Physics::RigidBody* pRigidBody;
+		EAE_Engine::Collider::OBBCollider collider;
+
+		sBox( EAE_Engine::Physics::RigidBodyManager& io_rigidBodyManager, const EAE_Engine::Math::Vector3& i_pos, const EAE_Engine::Math::Vector3& i_size )
+		{
+			transform.SetPos( i_pos );
+			pRigidBody = io_rigidBodyManager.AddRigidBody( &transform );
+			transform.AddComponent( { pRigidBody, pRigidBody->GetTypeID() } );
+			pRigidBody->SetPos( i_pos );
+			collider.InitOBBCollider( &transform, i_size );
+		}
+	};
+
+	struct sResult
+	{
+		bool collided;
+		float time;
+		EAE_Engine::Math::Vector3 axis;
+	};
+
+	sResult DetectCollision( sBox& i_a, sBox& i_b )
+	{
+		sResult result;
+		result.collided = i_a.collider.DetectCollision( &i_b.collider, s_timeStep, result.time, result.axis );
+		return result;
+	}
+
+	// The overlapping range of the 2 boxes on one axis during the step, the same math as OBBCollider::CalculateOverlapSepTimeForSAT.
+	bool GetOverlapOnAxis( sBox& i_a, const EAE_Engine::Math::Vector3* i_uofA, sBox& i_b, const EAE_Engine::Math::Vector3* i_uofB,
+		const EAE_Engine::Math::Vector3& i_movement, const EAE_Engine::Math::Vector3& i_axis, EAE_Engine::Collider::OverlapAndSepTime& o_result )
+	{
+		const EAE_Engine::Math::Vector3& sizeA = i_a.collider.GetSize();
+		const EAE_Engine::Math::Vector3& sizeB = i_b.collider.GetSize();
+		const float rangeA = 0.5f * ( std::fabs( sizeA._x * i_uofA[0].Dot( i_axis ) ) + std::fabs( sizeA._y * i_uofA[1].Dot( i_axis ) ) + std::fabs( sizeA._z * i_uofA[2].Dot( i_axis ) ) );
+		const float rangeB = 0.5f * ( std::fabs( sizeB._x * i_uofB[0].Dot( i_axis ) ) + std::fabs( sizeB._y * i_uofB[1].Dot( i_axis ) ) + std::fabs( sizeB._z * i_uofB[2].Dot( i_axis ) ) );
+		const float projA = ( i_a.transform.GetPos() + i_a.collider.GetOffset() ).Dot( i_axis );
+		const float projB = ( i_b.transform.GetPos() + i_b.collider.GetOffset() ).Dot( i_axis );
+		const float speed = i_movement.Dot( i_axis );
+		o_result._collisionAxle = i_axis;
+		if ( std::fabs( speed ) < FLT_EPSILON )
+		{
+			const bool overlapping = std::fabs( projB - projA ) <= rangeA + rangeB;
+			o_result._overlapTime = overlapping ? -FLT_MAX : FLT_MAX;
+			o_result._sepTime = FLT_MAX;
+			return overlapping;
+		}
+		const float near = speed < 0.0f ? projA + rangeA + rangeB - projB : projA - rangeA - rangeB - projB;
+		const float far = speed < 0.0f ? projA - rangeA - rangeB - projB : projA + rangeA + rangeB - projB;
+		o_result._overlapTime = near / speed;
+		o_result._sepTime = far / speed;
+		return o_result._overlapTime <= o_result._sepTime;
+	}
+
+	// The SAT test before the cache: all of the 15 axes, a pair overlapping on each of them is only rejected by the times at the end.
+	sResult DetectCollisionOnAllAxes( sBox& i_a, sBox& i_b )
+	{
+		sResult result = { false, FLT_MAX, EAE_Engine::Math::Vector3::Zero };
+		const EAE_Engine::Math::ColMatrix44 rotationA = EAE_Engine::Math::Quaternion::CreateColMatrix( i_a.transform.GetRotation() );
+		const EAE_Engine::Math::ColMatrix44 rotationB = EAE_Engine::Math::Quaternion::CreateColMatrix( i_b.transform.GetRotation() );
+		const EAE_Engine::Math::Vector3 uofA[3] = { rotationA.GetCol( 0 ), rotationA.GetCol( 1 ), rotationA.GetCol( 2 ) };
+		const EAE_Engine::Math::Vector3 uofB[3] = { rotationB.GetCol( 0 ), rotationB.GetCol( 1 ), rotationB.GetCol( 2 ) };
+		const EAE_Engine::Math::Vector4 movementA = i_a.pRigidBody->GetVelocity() * s_timeStep;
+		const EAE_Engine::Math::Vector4 movementB = i_b.pRigidBody->GetVelocity() * s_timeStep;
+		const EAE_Engine::Math::Vector3 movement = movementB - movementA;
+		EAE_Engine::Collider::OverlapAndSepTime total;
+		total._overlapTime = -FLT_MAX;
+		total._sepTime = FLT_MAX;
+		total._collisionAxle = EAE_Engine::Math::Vector3::Zero;
+		for ( uint32_t axisIndex = 0; axisIndex < 15; ++axisIndex )
+		{
+			const EAE_Engine::Math::Vector3 axis = axisIndex < 3 ? uofA[axisIndex] : axisIndex < 6 ? uofB[axisIndex - 3] :
+				uofA[( axisIndex - 6 ) / 3].Cross( uofB[( axisIndex - 6 ) % 3] );
+			EAE_Engine::Collider::OverlapAndSepTime onAxis;
+			if ( !GetOverlapOnAxis( i_a, uofA, i_b, uofB, movement, axis, onAxis ) )
+				return result;
+			if ( onAxis._overlapTime > total._overlapTime )
+			{
+				total._overlapTime = onAxis._overlapTime;
+				total._collisionAxle = onAxis._collisionAxle;
+			}
+			if ( onAxis._sepTime < total._sepTime )
+				total._sepTime = onAxis._sepTime;
+		}
+		// CheckContacting
+		result.collided = total._sepTime > 0.0f && ( total._overlapTime < 0.0f || ( total._overlapTime <= 1.0f && total._overlapTime <= total._sepTime ) );
+		if ( result.collided )
+		{
+			result.time = std::fmax( total._overlapTime, 0.0f );
+			result.axis = total._collisionAxle;
+		}
+		return result;
+	}
+
+	bool IsSameResult( const sResult& i_lhs, const sResult& i_rhs )
+	{
+		if ( i_lhs.collided != i_rhs.collided )
+			return false;
+		return !i_lhs.collided || ( i_lhs.time == i_rhs.time && i_lhs.axis._x == i_rhs.axis._x && i_lhs.axis._y == i_rhs.axis._y && i_lhs.axis._z == i_rhs.axis._z );
+	}
+}
+
+// Interface
+//==========
+
+int EngineTests::RunSATPairCacheTests()
+{
+	const int failureCountBefore = GetFailureCount();
+	EAE_Engine::Collider::SATPairCache& pairCache = EAE_Engine::Collider::OBBCollider::GetPairCache();
+	pairCache.Clear();
+
+	// The axes of A and B trade places, and A[i] x B[j] is B[j] x A[i], only flipped.
+	for ( uint32_t axis = 0; axis < 15; ++axis )
+	{
+		const uint32_t swapped = EAE_Engine::Collider::SATPairCache::SwapAxis( axis );
+		ENGINE_TEST_CHECK( swapped < 15 );
+		ENGINE_TEST_CHECK( EAE_Engine::Collider::SATPairCache::SwapAxis( swapped ) == axis );
+		if ( axis < 6 )
+			ENGINE_TEST_CHECK( swapped == ( axis + 3 ) % 6 );
+		else
+			ENGINE_TEST_CHECK( swapped == 6 + ( axis - 6 ) % 3 * 3 + ( axis - 6 ) / 3 );
+	}
+	ENGINE_TEST_CHECK( EAE_Engine::Collider::SATPairCache::SwapAxis( EAE_Engine::Collider::SATPairCache::s_noSeparatingAxis ) == EAE_Engine::Collider::SATPairCache::s_noSeparatingAxis );
+
+	EAE_Engine::Physics::RigidBodyManager rigidBodyManager;
+	const EAE_Engine::Math::Vector3 unitSize( 1.0f, 1.0f, 1.0f );
+	// The cases of one axis, B moves along x at 1 m per step, A is at 0.
+	{
+		struct sCase
+		{
+			const char* name;
+			float startX;
+			float speed;
+			bool collided;
+			float time;
+		};
+		const sCase cases[] =
+		{
+			{ "meeting at half of the step", 1.5f, -60.0f, true, 0.5f },
+			{ "meeting after the step", 3.0f, -60.0f, false, FLT_MAX },
+			{ "overlapping and leaving", 0.5f, 120.0f, true, 0.0f },
+			{ "apart and leaving", 1.5f, 60.0f, false, FLT_MAX },
+			{ "touching and still", 1.0f, 0.0f, true, 0.0f },
+		};
+		for ( size_t caseIndex = 0; caseIndex < sizeof( cases ) / sizeof( cases[0] ); ++caseIndex )
+		{
+			const sCase& testCase = cases[caseIndex];
+			sBox boxA( rigidBodyManager, EAE_Engine::Math::Vector3::Zero, unitSize );
+			sBox boxB( rigidBodyManager, EAE_Engine::Math::Vector3( testCase.startX, 0.0f, 0.0f ), unitSize );
+			boxB.pRigidBody->SetVelocity( EAE_Engine::Math::Vector3( testCase.speed, 0.0f, 0.0f ) );
+			const sResult expected = DetectCollisionOnAllAxes( boxA, boxB );
+			// The second test starts on the cached axis, and the third one with the boxes swapped.
+			for ( uint32_t repeat = 0; repeat < 3; ++repeat )
+			{
+				const sResult result = repeat < 2 ? DetectCollision( boxA, boxB ) : DetectCollision( boxB, boxA );
+				ENGINE_TEST_CHECK( result.collided == testCase.collided );
+				ENGINE_TEST_CHECK( result.collided == expected.collided );
+				ENGINE_TEST_CHECK( std::fabs( result.time - testCase.time ) <= 1.0e-5f || result.time == testCase.time );
+				if ( repeat < 2 )
+					ENGINE_TEST_CHECK( IsSameResult( result, expected ) );
+			}
+		}
+	}
+	// The separated pairs exit on their cached axis, in either order.
+	pairCache.Clear();
+	{
+		sBox boxA( rigidBodyManager, EAE_Engine::Math::Vector3::Zero, unitSize );
+		sBox boxB( rigidBodyManager, EAE_Engine::Math::Vector3( 0.0f, 0.0f, 3.0f ), unitSize );
+		sBox boxC( rigidBodyManager, EAE_Engine::Math::Vector3( 0.0f, 3.0f, 0.0f ), unitSize );
+		boxB.transform.SetRotation( EAE_Engine::Math::Quaternion( 0.5f, EAE_Engine::Math::Vector3( 0.0f, 1.0f, 0.0f ) ) );
+		ENGINE_TEST_CHECK( !DetectCollision( boxA, boxB ).collided );
+		ENGINE_TEST_CHECK( !DetectCollision( boxA, boxC ).collided );
+		ENGINE_TEST_CHECK( !DetectCollision( boxB, boxC ).collided );
+		ENGINE_TEST_CHECK( pairCache.GetPairCount() == 3 );
+		ENGINE_TEST_CHECK( pairCache.GetTestCount() == 3 && pairCache.GetEarlyOutCount() == 0 );
+		DetectCollision( boxB, boxA );
+		DetectCollision( boxC, boxB );
+		ENGINE_TEST_CHECK( pairCache.GetEarlyOutCount() == 2 );
+
+		// Only the pairs of A are forgotten, and forgetting them again changes nothing.
+		pairCache.RemoveCollider( &boxA.collider );
+		ENGINE_TEST_CHECK( pairCache.GetPairCount() == 1 );
+		pairCache.RemoveCollider( &boxA.collider );
+		ENGINE_TEST_CHECK( pairCache.GetPairCount() == 1 );
+		DetectCollision( boxB, boxC );
+		ENGINE_TEST_CHECK( pairCache.GetEarlyOutCount() == 3 );
+		// The pair of A starts again without an axis.
+		DetectCollision( boxA, boxB );
+		ENGINE_TEST_CHECK( pairCache.GetPairCount() == 2 );
+		ENGINE_TEST_CHECK( pairCache.GetEarlyOutCount() == 3 );
+	}
+	// The destructors of the boxes forgot all of their pairs.
+	ENGINE_TEST_CHECK( pairCache.GetPairCount() == 0 );
+
+	// The rotated boxes in a small room, each candidate pair of the broad phase against the test on all of the axes.
+	pairCache.Clear();
+	std::mt19937 generator( 34 );
+	std::uniform_real_distribution<float> unit( -1.0f, 1.0f );
+	std::vector<sBox*> boxes;
+	std::unordered_map<EAE_Engine::Collider::Collider*, sBox*> boxOfCollider;
+	EAE_Engine::Collider::SweepAndPrune broadPhase;
+	for ( uint32_t boxIndex = 0; boxIndex < s_boxCount; ++boxIndex )
+	{
+		const EAE_Engine::Math::Vector3 pos( unit( generator ) * s_roomExtent, unit( generator ) * s_roomExtent, unit( generator ) * s_roomExtent );
+		const EAE_Engine::Math::Vector3 size( 1.0f + 0.5f * unit( generator ), 1.0f + 0.5f * unit( generator ), 1.0f + 0.5f * unit( generator ) );
+		sBox* pBox = new sBox( rigidBodyManager, pos, size );
+		EAE_Engine::Math::Vector3 axis( unit( generator ), unit( generator ), unit( generator ) );
+		if ( axis.SqMagnitude() < 1.0e-4f )
+			axis = EAE_Engine::Math::Vector3( 0.0f, 1.0f, 0.0f );
+		pBox->transform.SetRotation( EAE_Engine::Math::Quaternion( unit( generator ) * 3.14159265f, axis.GetNormalize() ) );
+		pBox->pRigidBody->SetVelocity( EAE_Engine::Math::Vector3( unit( generator ), unit( generator ), unit( generator ) ) * s_maxSpeed );
+		boxes.push_back( pBox );
+		boxOfCollider[&pBox->collider] = pBox;
+		broadPhase.Add( &pBox->collider );
+	}
+	std::vector<std::pair<sBox*, sBox*>> candidates;
+	uint32_t mismatchCount = 0;
+	size_t collisionCount = 0;
+	double cachedMilliseconds = 0.0;
+	double allAxesMilliseconds = 0.0;
+	for ( uint32_t step = 0; step < s_stepCount; ++step )
+	{
+		for ( size_t boxIndex = 0; boxIndex < boxes.size(); ++boxIndex )
+		{
+			sBox& box = *boxes[boxIndex];
+			EAE_Engine::Math::Vector3 velocity = box.pRigidBody->GetVelocity();
+			const EAE_Engine::Math::Vector3 pos = box.transform.GetPos() + velocity * s_timeStep;
+			for ( size_t axis = 0; axis < 3; ++axis )
+			{
+				if ( std::fabs( pos._u[axis] ) > s_roomExtent )
+					velocity._u[axis] = pos._u[axis] > 0.0f ? -std::fabs( velocity._u[axis] ) : std::fabs( velocity._u[axis] );
+			}
+			box.transform.SetPos( pos );
+			box.pRigidBody->SetPos( pos );
+			box.pRigidBody->SetVelocity( velocity );
+		}
+		broadPhase.Update( s_timeStep );
+		const std::vector<EAE_Engine::Collider::ColliderPair>& pairs = broadPhase.GetPairs();
+		candidates.clear();
+		for ( size_t pairIndex = 0; pairIndex < pairs.size(); ++pairIndex )
+		{
+			candidates.push_back( std::make_pair( boxOfCollider[pairs[pairIndex]._pColliderA], boxOfCollider[pairs[pairIndex]._pColliderB] ) );
+		}
+		std::vector<sResult> results( candidates.size() );
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		for ( size_t pairIndex = 0; pairIndex < candidates.size(); ++pairIndex )
+			results[pairIndex] = DetectCollision( *candidates[pairIndex].first, *candidates[pairIndex].second );
+		cachedMilliseconds += GetMilliseconds( start );
+		std::vector<sResult> expected( candidates.size() );
+		start = std::chrono::high_resolution_clock::now();
+		for ( size_t pairIndex = 0; pairIndex < candidates.size(); ++pairIndex )
+			expected[pairIndex] = DetectCollisionOnAllAxes( *candidates[pairIndex].first, *candidates[pairIndex].second );
+		allAxesMilliseconds += GetMilliseconds( start );
+		for ( size_t pairIndex = 0; pairIndex < candidates.size(); ++pairIndex )
+		{
+			mismatchCount += IsSameResult( results[pairIndex], expected[pairIndex] ) ? 0 : 1;
+			collisionCount += results[pairIndex].collided ? 1 : 0;
+		}
+	}
+	ENGINE_TEST_CHECK( mismatchCount == 0 );
+	ENGINE_TEST_CHECK( collisionCount > 0 );
+	const uint32_t testCount = pairCache.GetTestCount();
+	const uint32_t earlyOutCount = pairCache.GetEarlyOutCount();
+	// The broad phase already dropped most of the pairs which are far apart, but most of the separated candidates are still apart on the axis of the last step.
+	const uint32_t separatedCount = testCount - (uint32_t)collisionCount;
+	ENGINE_TEST_CHECK( earlyOutCount * 2 > separatedCount );
+	printf( "%u boxes, %u steps: %u pair tests, %u collisions, %u exit after the cached axis (%.1f%% of the tests, %.1f%% of the separated pairs)\n",
+		s_boxCount, s_stepCount, testCount, (uint32_t)collisionCount, earlyOutCount, testCount > 0 ? 100.0 * earlyOutCount / testCount : 0.0,
+		separatedCount > 0 ? 100.0 * earlyOutCount / separatedCount : 0.0 );
+	printf( "ns per pair: %.1f with the cache, %.1f on all of the axes\n", cachedMilliseconds * 1.0e6 / testCount, allAxesMilliseconds * 1.0e6 / testCount );
+	for ( size_t boxIndex = 0; boxIndex < boxes.size(); ++boxIndex )
+		delete boxes[boxIndex];
+	ENGINE_TEST_CHECK( pairCache.GetPairCount() == 0 );
+	pairCache.Clear();
+	return GetFailureCount() - failureCountBefore;
+}
@@ -0,0 +1,520 @@
+/*
+	The packed AABB, AABB4, OBB and Rectangle of SIMDGeometry against the scalar tests on the Geometry structs:
+	random boxes on a coarse grid, so many of them touch on a face or an edge, rotated boxes and rectangles with a negative size
+	must give the same overlaps, containments and unions, and the transformed boxes the same bounds as their corners.
+	It also prints the time of the overlap test of one box against 4096 boxes with the scalar AABBV1,
+	the PackedAABB and the AABB4, and of the OBB SAT with the scalar OBB and the PackedOBB.
+*/
+
+// Header Files
+//=============
+
+#include "EngineTests.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+#include "Engine/Math/Rectangle.h"
+#include "Engine/Math/SIMDGeometry.h"
+
+// Helper Definitions
+//===================
+
+namespace
+{
+	const uint32_t s_iterationCount = 100000;
+	const uint32_t s_benchmarkBoxCount = 4096;
+	const uint32_t s_benchmarkQueryCount = 256;
+	const uint32_t s_benchmarkOBBCount = 1024;
+	const uint32_t s_benchmarkRepeatCount = 20;
+	const float s_tolerance = 1.0e-4f;
+
+	struct sRandom
+	{
+		std::mt19937 generator;
+
+		explicit sRandom( uint32_t i_seed ) : generator( i_seed ) {}
+
+		// Multiples of 0.5 in [-4, 4], so the faces of the boxes often meet exactly.
+		float GetGridFloat()
+		{
+			return std::uniform_int_distribution<int>( -8, 8 )( generator ) * 0.5f;
+		}
+
+		float GetFloat( float i_min, float i_max )
+		{
+			return std::uniform_real_distribution<float>( i_min, i_max )( generator );
+		}
+
+		EAE_Engine::Math::Vector3 GetGridVector()
+		{
+			return EAE_Engine::Math::Vector3( GetGridFloat(), GetGridFloat(), GetGridFloat() );
+		}
+
+		EAE_Engine::Math::Vector3 GetVector( float i_min, float i_max )
+		{
+			return EAE_Engine::Math::Vector3( GetFloat( i_min, i_max ), GetFloat( i_min, i_max ), GetFloat( i_min, i_max ) );
+		}
+
+		// Some boxes are flat on one axis.
+		EAE_Engine::Math::AABBV1 GetAABB()
+		{
+			const EAE_Engine::Math::Vector3 a = GetGridVector();
+			const EAE_Engine::Math::Vector3 b = GetGridVector();
+			EAE_Engine::Math::AABBV1 result;
+			result._min = EAE_Engine::Math::Vector3( std::min( a._x, b._x ), std::min( a._y, b._y ), std::min( a._z, b._z ) );
+			result._max = EAE_Engine::Math::Vector3( std::max( a._x, b._x ), std::max( a._y, b._y ), std::max( a._z, b._z ) );
+			return result;
+		}
+
+		// A quarter of the rotations are the identity, so the axes of 2 boxes are often parallel.
+		EAE_Engine::Math::Quaternion GetRotation()
+		{
+			if ( std::uniform_int_distribution<int>( 0, 3 )( generator ) == 0 )
+				return EAE_Engine::Math::Quaternion::Identity;
+			EAE_Engine::Math::Vector3 axis = GetVector( -1.0f, 1.0f );
+			if ( axis.SqMagnitude() < 1.0e-4f )
+				axis = EAE_Engine::Math::Vector3( 0.0f, 1.0f, 0.0f );
+			return EAE_Engine::Math::Quaternion( GetFloat( -3.14159265f, 3.14159265f ), axis.GetNormalize() );
+		}
+
+		EAE_Engine::Math::OBB GetOBB()
+		{
+			const EAE_Engine::Math::Quaternion rotation = GetRotation();
+			EAE_Engine::Math::OBB result;
+			result._pos = GetVector( -3.0f, 3.0f );
+			result._extent = GetVector( 0.1f, 2.0f );
+			result._axis[0] = EAE_Engine::Math::Quaternion::MultiVector( rotation, EAE_Engine::Math::Vector3( 1.0f, 0.0f, 0.0f ) );
+			result._axis[1] = EAE_Engine::Math::Quaternion::MultiVector( rotation, EAE_Engine::Math::Vector3( 0.0f, 1.0f, 0.0f ) );
+			result._axis[2] = EAE_Engine::Math::Quaternion::MultiVector( rotation, EAE_Engine::Math::Vector3( 0.0f, 0.0f, 1.0f ) );
+			return result;
+		}
+	};
+
+	///////////////////////////////////////Scalar references//////////////////////////////////////////
+
+	bool TestAABBAABBScalar( const EAE_Engine::Math::AABBV1& i_a, const EAE_Engine::Math::AABBV1& i_b )
+	{
+		return i_a._min._x <= i_b._max._x && i_b._min._x <= i_a._max._x &&
+			i_a._min._y <= i_b._max._y && i_b._min._y <= i_a._max._y &&
+			i_a._min._z <= i_b._max._z && i_b._min._z <= i_a._max._z;
+	}
+
+	// The points on the faces are inside, unlike TestPointInAABB of CollisionDetectionFunctions.
+	bool ContainsPointScalar( const EAE_Engine::Math::AABBV1& i_aabb, const EAE_Engine::Math::Vector3& i_point )
+	{
+		return i_aabb._min._x <= i_point._x && i_point._x <= i_aabb._max._x &&
+			i_aabb._min._y <= i_point._y && i_point._y <= i_aabb._max._y &&
+			i_aabb._min._z <= i_point._z && i_point._z <= i_aabb._max._z;
+	}
+
+	bool ContainsAABBScalar( const EAE_Engine::Math::AABBV1& i_outer, const EAE_Engine::Math::AABBV1& i_inner )
+	{
+		return ContainsPointScalar( i_outer, i_inner._min ) && ContainsPointScalar( i_outer, i_inner._max );
+	}
+
+	bool TestAABBSphereScalar( const EAE_Engine::Math::AABBV1& i_aabb, const EAE_Engine::Math::Vector3& i_center, float i_radius )
+	{
+		const EAE_Engine::Math::Vector3 closest( std::min( std::max( i_center._x, i_aabb._min._x ), i_aabb._max._x ),
+			std::min( std::max( i_center._y, i_aabb._min._y ), i_aabb._max._y ),
+			std::min( std::max( i_center._z, i_aabb._min._z ), i_aabb._max._z ) );
+		const EAE_Engine::Math::Vector3 offset = i_center - closest;
+		return offset._x * offset._x + offset._y * offset._y + offset._z * offset._z <= i_radius * i_radius;
+	}
+
+	bool IsSameAABB( const EAE_Engine::Math::PackedAABB& i_packed, const EAE_Engine::Math::AABBV1& i_aabb, float i_tolerance )
+	{
+		const float expected[6] = { i_aabb._min._x, i_aabb._min._y, i_aabb._min._z, i_aabb._max._x, i_aabb._max._y, i_aabb._max._z };
+		const float result[6] = { i_packed._min[0], i_packed._min[1], i_packed._min[2], i_packed._max[0], i_packed._max[1], i_packed._max[2] };
+		for ( size_t i = 0; i < 6; ++i )
+		{
+			if ( std::fabs( result[i] - expected[i] ) > i_tolerance * ( 1.0f + std::fabs( expected[i] ) ) )
+				return false;
+		}
+		return true;
+	}
+
+	EAE_Engine::Math::AABBV1 BoundPoints( const EAE_Engine::Math::Vector3* i_pPoints, size_t i_count )
+	{
+		EAE_Engine::Math::AABBV1 result;
+		result._min = result._max = i_pPoints[0];
+		for ( size_t i = 1; i < i_count; ++i )
+		{
+			result._min = EAE_Engine::Math::Vector3( std::min( result._min._x, i_pPoints[i]._x ), std::min( result._min._y, i_pPoints[i]._y ), std::min( result._min._z, i_pPoints[i]._z ) );
+			result._max = EAE_Engine::Math::Vector3( std::max( result._max._x, i_pPoints[i]._x ), std::max( result._max._y, i_pPoints[i]._y ), std::max( result._max._z, i_pPoints[i]._z ) );
+		}
+		return result;
+	}
+
+	void GetCorners( const EAE_Engine::Math::OBB& i_obb, EAE_Engine::Math::Vector3* o_pCorners )
+	{
+		for ( uint32_t corner = 0; corner < 8; ++corner )
+		{
+			o_pCorners[corner] = i_obb._pos +
+				i_obb._axis[0] * ( ( corner & 1 ) ? i_obb._extent._x : -i_obb._extent._x ) +
+				i_obb._axis[1] * ( ( corner & 2 ) ? i_obb._extent._y : -i_obb._extent._y ) +
+				i_obb._axis[2] * ( ( corner & 4 ) ? i_obb._extent._z : -i_obb._extent._z );
+		}
+	}
+
+	float Dot( const EAE_Engine::Math::Vector3& i_a, const EAE_Engine::Math::Vector3& i_b )
+	{
+		return i_a._x * i_b._x + i_a._y * i_b._y + i_a._z * i_b._z;
+	}
+
+	bool ContainsPointScalar( const EAE_Engine::Math::OBB& i_obb, const EAE_Engine::Math::Vector3& i_point )
+	{
+		const EAE_Engine::Math::Vector3 offset = i_point - i_obb._pos;
+		return std::fabs( Dot( offset, i_obb._axis[0] ) ) <= i_obb._extent._x &&
+			std::fabs( Dot( offset, i_obb._axis[1] ) ) <= i_obb._extent._y &&
+			std::fabs( Dot( offset, i_obb._axis[2] ) ) <= i_obb._extent._z;
+	}
+
+	// Real Time Collision Detection 4.4.1 on the scalar OBB, the same operations in the same order as TestOBBOBB.
+	bool TestOBBOBBScalar( const EAE_Engine::Math::OBB& i_a, const EAE_Engine::Math::OBB& i_b )
+	{
+		const float ea[3] = { i_a._extent._x, i_a._extent._y, i_a._extent._z };
+		const float eb[3] = { i_b._extent._x, i_b._extent._y, i_b._extent._z };
+		float R[3][3], AbsR[3][3];
+		for ( int i = 0; i < 3; ++i )
+		{
+			for ( int j = 0; j < 3; ++j )
+			{
+				R[i][j] = Dot( i_a._axis[i], i_b._axis[j] );
+				AbsR[i][j] = std::fabs( R[i][j] ) + FLT_EPSILON;
+			}
+		}
+		const EAE_Engine::Math::Vector3 offset = i_b._pos - i_a._pos;
+		const float t[3] = { Dot( offset, i_a._axis[0] ), Dot( offset, i_a._axis[1] ), Dot( offset, i_a._axis[2] ) };
+		for ( int i = 0; i < 3; ++i )
+		{
+			if ( std::fabs( t[i] ) > ea[i] + ( eb[0] * AbsR[i][0] + eb[1] * AbsR[i][1] + eb[2] * AbsR[i][2] ) )
+				return false;
+		}
+		for ( int i = 0; i < 3; ++i )
+		{
+			if ( std::fabs( t[0] * R[0][i] + t[1] * R[1][i] + t[2] * R[2][i] ) > ( ea[0] * AbsR[0][i] + ea[1] * AbsR[1][i] + ea[2] * AbsR[2][i] ) + eb[i] )
+				return false;
+		}
+		for ( int i = 0; i < 3; ++i )
+		{
+			const int i1 = ( i + 1 ) % 3;
+			const int i2 = ( i + 2 ) % 3;
+			for ( int j = 0; j < 3; ++j )
+			{
+				const int j1 = ( j + 1 ) % 3;
+				const int j2 = ( j + 2 ) % 3;
+				const float ra = ea[i1] * AbsR[i2][j] + ea[i2] * AbsR[i1][j];
+				const float rb = eb[j1] * AbsR[i][j2] + eb[j2] * AbsR[i][j1];
+				if ( std::fabs( t[i2] * R[i1][j] - t[i1] * R[i2][j] ) > ra + rb )
+					return false;
+			}
+		}
+		return true;
+	}
+
+	// The rectangle as (minX, minY, maxX, maxY) from its corners, the size may be negative.
+	void GetRectBounds( const EAE_Engine::Math::Rectangle& i_rect, float* o_pBounds )
+	{
+		const EAE_Engine::Math::Vector3 leftTop = i_rect.GetLeftTop();
+		const EAE_Engine::Math::Vector3 rightBottom = i_rect.GetRightBottom();
+		o_pBounds[0] = std::min( leftTop._x, rightBottom._x );
+		o_pBounds[1] = std::min( leftTop._y, rightBottom._y );
+		o_pBounds[2] = std::max( leftTop._x, rightBottom._x );
+		o_pBounds[3] = std::max( leftTop._y, rightBottom._y );
+	}
+
+	///////////////////////////////////////Tests//////////////////////////////////////////
+
+	void TestAABBs()
+	{
+		sRandom random( 30 );
+		uint32_t overlapCount = 0;
+		uint32_t mismatchCount = 0;
+		for ( uint32_t iteration = 0; iteration < s_iterationCount; ++iteration )
+		{
+			const EAE_Engine::Math::AABBV1 a = random.GetAABB();
+			const EAE_Engine::Math::AABBV1 b = random.GetAABB();
+			const EAE_Engine::Math::PackedAABB packedA( a );
+			const EAE_Engine::Math::PackedAABB packedB( b );
+			const bool overlap = TestAABBAABBScalar( a, b );
+			overlapCount += overlap ? 1 : 0;
+			mismatchCount += EAE_Engine::Math::TestAABBAABB( packedA, packedB ) != overlap ? 1 : 0;
+
+			EAE_Engine::Math::PackedAABB intersection;
+			mismatchCount += EAE_Engine::Math::Intersection( packedA, packedB, intersection ) != overlap ? 1 : 0;
+			if ( overlap )
+			{
+				EAE_Engine::Math::AABBV1 expected;
+				expected._min = EAE_Engine::Math::Vector3( std::max( a._min._x, b._min._x ), std::max( a._min._y, b._min._y ), std::max( a._min._z, b._min._z ) );
+				expected._max = EAE_Engine::Math::Vector3( std::min( a._max._x, b._max._x ), std::min( a._max._y, b._max._y ), std::min( a._max._z, b._max._z ) );
+				mismatchCount += IsSameAABB( intersection, expected, 0.0f ) ? 0 : 1;
+			}
+
+			EAE_Engine::Math::AABBV1 expectedUnion;
+			expectedUnion._min = EAE_Engine::Math::Vector3( std::min( a._min._x, b._min._x ), std::min( a._min._y, b._min._y ), std::min( a._min._z, b._min._z ) );
+			expectedUnion._max = EAE_Engine::Math::Vector3( std::max( a._max._x, b._max._x ), std::max( a._max._y, b._max._y ), std::max( a._max._z, b._max._z ) );
+			mismatchCount += IsSameAABB( EAE_Engine::Math::Union( packedA, packedB ), expectedUnion, 0.0f ) ? 0 : 1;
+			mismatchCount += EAE_Engine::Math::ContainsAABB( packedA, packedB ) != ContainsAABBScalar( a, b ) ? 1 : 0;
+
+			const EAE_Engine::Math::Vector3 point = random.GetGridVector();
+			mismatchCount += EAE_Engine::Math::ContainsPoint( packedA, point ) != ContainsPointScalar( a, point ) ? 1 : 0;
+			const float radius = random.GetGridFloat() + 4.0f;
+			mismatchCount += EAE_Engine::Math::TestAABBSphere( packedA, point, radius ) != TestAABBSphereScalar( a, point, radius ) ? 1 : 0;
+
+			const EAE_Engine::Math::Vector3 size = a._max - a._min;
+			const float surfaceArea = 2.0f * ( size._x * size._y + size._y * size._z + size._z * size._x );
+			mismatchCount += EAE_Engine::Math::SurfaceArea( packedA ) != surfaceArea ? 1 : 0;
+
+			// The centered box converts exactly, the grid floats are exact in both forms.
+			const EAE_Engine::Math::AABBV2 centered = packedA.ToAABBV2();
+			mismatchCount += IsSameAABB( EAE_Engine::Math::PackedAABB( centered ), a, 0.0f ) ? 0 : 1;
+		}
+		ENGINE_TEST_CHECK( mismatchCount == 0 );
+		// Both of the answers must be tested often.
+		ENGINE_TEST_CHECK( overlapCount > s_iterationCount / 10 && overlapCount < s_iterationCount * 9 / 10 );
+	}
+
+	void TestAABB4s()
+	{
+		sRandom random( 31 );
+		uint32_t mismatchCount = 0;
+		for ( uint32_t iteration = 0; iteration < s_iterationCount / 4; ++iteration )
+		{
+			const EAE_Engine::Math::AABBV1 query = random.GetAABB();
+			EAE_Engine::Math::AABB4 boxes;
+			uint32_t expectedMask = 0;
+			for ( uint32_t slot = 0; slot < 4; ++slot )
+			{
+				// Some slots are empty, like the last group of a node.
+				if ( std::uniform_int_distribution<int>( 0, 4 )( random.generator ) == 0 )
+				{
+					boxes.SetEmpty( slot );
+					continue;
+				}
+				const EAE_Engine::Math::AABBV1 box = random.GetAABB();
+				boxes.Set( slot, EAE_Engine::Math::PackedAABB( box ) );
+				expectedMask |= TestAABBAABBScalar( query, box ) ? 1u << slot : 0u;
+			}
+			mismatchCount += EAE_Engine::Math::TestAABBAABB4( EAE_Engine::Math::PackedAABB( query ), boxes ) != expectedMask ? 1 : 0;
+		}
+		ENGINE_TEST_CHECK( mismatchCount == 0 );
+		// An empty slot never overlaps, even a box which covers nearly all of the floats.
+		EAE_Engine::Math::AABB4 emptyBoxes;
+		for ( uint32_t slot = 0; slot < 4; ++slot )
+			emptyBoxes.SetEmpty( slot );
+		const float nearlyMax = std::nextafter( FLT_MAX, 0.0f );
+		const EAE_Engine::Math::PackedAABB everything( EAE_Engine::Math::Vector3( -nearlyMax, -nearlyMax, -nearlyMax ), EAE_Engine::Math::Vector3( nearlyMax, nearlyMax, nearlyMax ) );
+		ENGINE_TEST_CHECK( EAE_Engine::Math::TestAABBAABB4( everything, emptyBoxes ) == 0 );
+	}
+
+	void TestOBBs()
+	{
+		sRandom random( 32 );
+		uint32_t overlapCount = 0;
+		uint32_t mismatchCount = 0;
+		uint32_t boundMismatchCount = 0;
+		for ( uint32_t iteration = 0; iteration < s_iterationCount; ++iteration )
+		{
+			const EAE_Engine::Math::OBB a = random.GetOBB();
+			const EAE_Engine::Math::OBB b = random.GetOBB();
+			const EAE_Engine::Math::PackedOBB packedA( a );
+			const EAE_Engine::Math::PackedOBB packedB( b );
+			const bool overlap = TestOBBOBBScalar( a, b );
+			overlapCount += overlap ? 1 : 0;
+			mismatchCount += EAE_Engine::Math::TestOBBOBB( packedA, packedB ) != overlap ? 1 : 0;
+
+			const EAE_Engine::Math::Vector3 point = random.GetVector( -4.0f, 4.0f );
+			mismatchCount += EAE_Engine::Math::ContainsPoint( packedA, point ) != ContainsPointScalar( a, point ) ? 1 : 0;
+
+			// The bound of the 8 corners.
+			EAE_Engine::Math::Vector3 corners[8];
+			GetCorners( a, corners );
+			boundMismatchCount += IsSameAABB( EAE_Engine::Math::ComputeAABB( packedA ), BoundPoints( corners, 8 ), s_tolerance ) ? 0 : 1;
+
+			// Moving the box moves its corners.
+			const EAE_Engine::Math::Quaternion rotation = random.GetRotation();
+			const EAE_Engine::Math::Vector3 translation = random.GetVector( -10.0f, 10.0f );
+			const EAE_Engine::Math::ColMatrix44 matrix( rotation, translation );
+			EAE_Engine::Math::Vector3 movedCorners[8];
+			for ( uint32_t corner = 0; corner < 8; ++corner )
+				movedCorners[corner] = EAE_Engine::Math::Quaternion::MultiVector( rotation, corners[corner] ) + translation;
+			const EAE_Engine::Math::PackedOBB movedOBB = EAE_Engine::Math::TransformOBB( packedA, matrix );
+			boundMismatchCount += IsSameAABB( EAE_Engine::Math::ComputeAABB( movedOBB ), BoundPoints( movedCorners, 8 ), s_tolerance ) ? 0 : 1;
+			const EAE_Engine::Math::PackedAABB bound = EAE_Engine::Math::ComputeAABB( packedA );
+			const EAE_Engine::Math::AABBV1 boundV1 = bound.ToAABBV1();
+			EAE_Engine::Math::Vector3 boundCorners[8];
+			for ( uint32_t corner = 0; corner < 8; ++corner )
+			{
+				boundCorners[corner] = EAE_Engine::Math::Quaternion::MultiVector( rotation, EAE_Engine::Math::Vector3(
+					( corner & 1 ) ? boundV1._max._x : boundV1._min._x, ( corner & 2 ) ? boundV1._max._y : boundV1._min._y,
+					( corner & 4 ) ? boundV1._max._z : boundV1._min._z ) ) + translation;
+			}
+			boundMismatchCount += IsSameAABB( EAE_Engine::Math::TransformAABB( bound, matrix ), BoundPoints( boundCorners, 8 ), s_tolerance ) ? 0 : 1;
+		}
+		ENGINE_TEST_CHECK( mismatchCount == 0 );
+		ENGINE_TEST_CHECK( boundMismatchCount == 0 );
+		ENGINE_TEST_CHECK( overlapCount > s_iterationCount / 10 && overlapCount < s_iterationCount * 9 / 10 );
+		// The round trip keeps every float.
+		const EAE_Engine::Math::OBB obb = random.GetOBB();
+		const EAE_Engine::Math::OBB roundTrip = EAE_Engine::Math::PackedOBB( obb ).ToOBB();
+		ENGINE_TEST_CHECK( memcmp( &roundTrip, &obb, sizeof( EAE_Engine::Math::OBB ) ) == 0 );
+	}
+
+	void TestRects()
+	{
+		sRandom random( 33 );
+		uint32_t overlapCount = 0;
+		uint32_t mismatchCount = 0;
+		for ( uint32_t iteration = 0; iteration < s_iterationCount; ++iteration )
+		{
+			// The width and the height may be negative, the left top is then on the right or the bottom.
+			const EAE_Engine::Math::Rectangle a( random.GetGridFloat(), random.GetGridFloat(), random.GetGridFloat(), random.GetGridFloat() );
+			const EAE_Engine::Math::Rectangle b( random.GetGridFloat(), random.GetGridFloat(), random.GetGridFloat(), random.GetGridFloat() );
+			const EAE_Engine::Math::PackedRect packedA( a );
+			const EAE_Engine::Math::PackedRect packedB( b );
+			float boundsA[4], boundsB[4];
+			GetRectBounds( a, boundsA );
+			GetRectBounds( b, boundsB );
+			for ( size_t i = 0; i < 4; ++i )
+				mismatchCount += packedA._bounds[i] != boundsA[i] ? 1 : 0;
+
+			const bool overlap = boundsA[0] <= boundsB[2] && boundsB[0] <= boundsA[2] && boundsA[1] <= boundsB[3] && boundsB[1] <= boundsA[3];
+			overlapCount += overlap ? 1 : 0;
+			mismatchCount += EAE_Engine::Math::TestRectRect( packedA, packedB ) != overlap ? 1 : 0;
+
+			const float x = random.GetGridFloat();
+			const float y = random.GetGridFloat();
+			const bool contains = boundsA[0] <= x && x <= boundsA[2] && boundsA[1] <= y && y <= boundsA[3];
+			mismatchCount += EAE_Engine::Math::ContainsPoint( packedA, x, y ) != contains ? 1 : 0;
+
+			const EAE_Engine::Math::PackedRect rectUnion = EAE_Engine::Math::Union( packedA, packedB );
+			const float expectedUnion[4] = { std::min( boundsA[0], boundsB[0] ), std::min( boundsA[1], boundsB[1] ),
+				std::max( boundsA[2], boundsB[2] ), std::max( boundsA[3], boundsB[3] ) };
+			for ( size_t i = 0; i < 4; ++i )
+				mismatchCount += rectUnion._bounds[i] != expectedUnion[i] ? 1 : 0;
+		}
+		ENGINE_TEST_CHECK( mismatchCount == 0 );
+		ENGINE_TEST_CHECK( overlapCount > s_iterationCount / 10 && overlapCount < s_iterationCount * 9 / 10 );
+	}
+
+	///////////////////////////////////////Benchmark//////////////////////////////////////////
+
+	double GetNanoseconds( std::chrono::high_resolution_clock::time_point i_start, uint32_t i_testCount )
+	{
+		return std::chrono::duration<double, std::nano>( std::chrono::high_resolution_clock::now() - i_start ).count() / i_testCount;
+	}
+
+	void Benchmark()
+	{
+		sRandom random( 34 );
+		std::vector<EAE_Engine::Math::AABBV1> boxes( s_benchmarkBoxCount );
+		std::vector<EAE_Engine::Math::PackedAABB> packedBoxes( s_benchmarkBoxCount );
+		std::vector<EAE_Engine::Math::AABB4> boxGroups( s_benchmarkBoxCount / 4 );
+		for ( uint32_t boxIndex = 0; boxIndex < s_benchmarkBoxCount; ++boxIndex )
+		{
+			// Small boxes spread over a wider space, so about 1 in 20 of the tests overlap like in a broad phase.
+			const EAE_Engine::Math::Vector3 center = random.GetVector( -20.0f, 20.0f );
+			const EAE_Engine::Math::Vector3 extents = random.GetVector( 0.5f, 3.0f );
+			boxes[boxIndex]._min = center - extents;
+			boxes[boxIndex]._max = center + extents;
+			packedBoxes[boxIndex] = EAE_Engine::Math::PackedAABB( boxes[boxIndex] );
+			boxGroups[boxIndex / 4].Set( boxIndex % 4, packedBoxes[boxIndex] );
+		}
+		const uint32_t testCount = s_benchmarkQueryCount * s_benchmarkBoxCount * s_benchmarkRepeatCount;
+
+		uint32_t scalarCount = 0;
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		for ( uint32_t repeat = 0; repeat < s_benchmarkRepeatCount; ++repeat )
+		{
+			for ( uint32_t queryIndex = 0; queryIndex < s_benchmarkQueryCount; ++queryIndex )
+			{
+				for ( uint32_t boxIndex = 0; boxIndex < s_benchmarkBoxCount; ++boxIndex )
+					scalarCount += TestAABBAABBScalar( boxes[queryIndex], boxes[boxIndex] ) ? 1 : 0;
+			}
+		}
+		const double scalarNanoseconds = GetNanoseconds( start, testCount );
+
+		uint32_t packedCount = 0;
+		start = std::chrono::high_resolution_clock::now();
+		for ( uint32_t repeat = 0; repeat < s_benchmarkRepeatCount; ++repeat )
+		{
+			for ( uint32_t queryIndex = 0; queryIndex < s_benchmarkQueryCount; ++queryIndex )
+			{
+				for ( uint32_t boxIndex = 0; boxIndex < s_benchmarkBoxCount; ++boxIndex )
+					packedCount += EAE_Engine::Math::TestAABBAABB( packedBoxes[queryIndex], packedBoxes[boxIndex] ) ? 1 : 0;
+			}
+		}
+		const double packedNanoseconds = GetNanoseconds( start, testCount );
+
+		uint32_t groupCount = 0;
+		start = std::chrono::high_resolution_clock::now();
+		for ( uint32_t repeat = 0; repeat < s_benchmarkRepeatCount; ++repeat )
+		{
+			for ( uint32_t queryIndex = 0; queryIndex < s_benchmarkQueryCount; ++queryIndex )
+			{
+				for ( size_t groupIndex = 0; groupIndex < boxGroups.size(); ++groupIndex )
+				{
+					const uint32_t mask = EAE_Engine::Math::TestAABBAABB4( packedBoxes[queryIndex], boxGroups[groupIndex] );
+					groupCount += ( mask & 1 ) + ( ( mask >> 1 ) & 1 ) + ( ( mask >> 2 ) & 1 ) + ( mask >> 3 );
+				}
+			}
+		}
+		const double groupNanoseconds = GetNanoseconds( start, testCount );
+		ENGINE_TEST_CHECK( packedCount == scalarCount );
+		ENGINE_TEST_CHECK( groupCount == scalarCount );
+		printf( "AABB overlaps of %u boxes against %u boxes, %u overlapping\n", s_benchmarkQueryCount, s_benchmarkBoxCount, scalarCount / s_benchmarkRepeatCount );
+		printf( "%-12s %s\n", "version", "ns per test" );
+		printf( "%-12s %.3f\n", "AABBV1", scalarNanoseconds );
+		printf( "%-12s %.3f\n", "PackedAABB", packedNanoseconds );
+		printf( "%-12s %.3f\n", "AABB4", groupNanoseconds );
+
+		std::vector<EAE_Engine::Math::OBB> obbs( s_benchmarkOBBCount );
+		std::vector<EAE_Engine::Math::PackedOBB> packedOBBs( s_benchmarkOBBCount );
+		for ( uint32_t obbIndex = 0; obbIndex < s_benchmarkOBBCount; ++obbIndex )
+		{
+			obbs[obbIndex] = random.GetOBB();
+			packedOBBs[obbIndex] = EAE_Engine::Math::PackedOBB( obbs[obbIndex] );
+		}
+		const uint32_t pairCount = s_benchmarkOBBCount * s_benchmarkOBBCount;
+		uint32_t scalarOBBCount = 0;
+		start = std::chrono::high_resolution_clock::now();
+		for ( uint32_t a = 0; a < s_benchmarkOBBCount; ++a )
+		{
+			for ( uint32_t b = 0; b < s_benchmarkOBBCount; ++b )
+				scalarOBBCount += TestOBBOBBScalar( obbs[a], obbs[b] ) ? 1 : 0;
+		}
+		const double scalarOBBNanoseconds = GetNanoseconds( start, pairCount );
+		uint32_t packedOBBCount = 0;
+		start = std::chrono::high_resolution_clock::now();
+		for ( uint32_t a = 0; a < s_benchmarkOBBCount; ++a )
+		{
+			for ( uint32_t b = 0; b < s_benchmarkOBBCount; ++b )
+				packedOBBCount += EAE_Engine::Math::TestOBBOBB( packedOBBs[a], packedOBBs[b] ) ? 1 : 0;
+		}
+		const double packedOBBNanoseconds = GetNanoseconds( start, pairCount );
+		ENGINE_TEST_CHECK( packedOBBCount == scalarOBBCount );
+		printf( "OBB SAT of %u pairs, %u overlapping\n", pairCount, scalarOBBCount );
+		printf( "%-12s %.3f\n", "OBB", scalarOBBNanoseconds );
+		printf( "%-12s %.3f\n", "PackedOBB", packedOBBNanoseconds );
+	}
+}
+
+// Interface
+//==========
+
+int EngineTests::RunSIMDGeometryTests()
+{
+	const int failureCountBefore = GetFailureCount();
+	TestAABBs();
+	TestAABB4s();
+	TestOBBs();
+	TestRects();
+	Benchmark();
+	return GetFailureCount() - failureCountBefore;
+}
@@ -0,0 +1,308 @@
+/*
+	The 4 and 8 wide tests of SIMDCollisionFunctions against the scalar TestSegmentAABB and IntersectSegmentTriangle:
+	random segments, boxes and triangles, some of them flat, parallel to an axis or degenerated,
+	must give the same masks, and the hit lanes the same t, u, v and w bit for bit.
+	It also prints the time of a test of one segment against a box and a triangle with each width.
+*/
+
+// Header Files
+//=============
+
+#include "EngineTests.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+#include "Engine/CollisionDetection/SIMDCollisionFunctions.h"
+
+// Helper Definitions
+//===================
+
+namespace
+{
+	const uint32_t s_iterationCount = 100000;
+	const uint32_t s_benchmarkCount = 2048;
+	const uint32_t s_benchmarkRepeatCount = 200;
+
+	struct sRandom
+	{
+		std::mt19937 engine;
+		std::uniform_real_distribution<float> unit;
+
+		sRandom() : engine( 48 ), unit( 0.0f, 1.0f ) {}
+
+		float Range( float i_min, float i_max ) { return i_min + ( i_max - i_min ) * unit( engine ); }
+		EAE_Engine::Math::Vector3 Point( float i_extent ) { return EAE_Engine::Math::Vector3( Range( -i_extent, i_extent ), Range( -i_extent, i_extent ), Range( -i_extent, i_extent ) ); }
+		uint32_t Index( uint32_t i_count ) { return (uint32_t)( unit( engine ) * i_count ) % i_count; }
+
+		// The segments end among the boxes so about a quarter of the tests hit.
+		// One in eight of them is parallel to an axis and one in sixteen is a point,
+		// those are the cases the epsilon of TestSegmentAABB is for.
+		void Segment( EAE_Engine::Math::Vector3& o_start, EAE_Engine::Math::Vector3& o_end )
+		{
+			o_start = Point( 15.0f );
+			o_end = Point( 3.0f );
+			const uint32_t kind = Index( 16 );
+			if ( kind < 2 )
+			{
+				const uint32_t axis = Index( 3 );
+				for ( uint32_t other = 0; other < 3; ++other )
+				{
+					if ( other != axis )
+						o_end._u[other] = o_start._u[other];
+				}
+			}
+			else if ( kind == 2 )
+			{
+				o_end = o_start;
+			}
+		}
+
+		// One in eight of the boxes is flat on an axis, like the bounds of a flat floor.
+		EAE_Engine::Math::AABBV1 Box()
+		{
+			const EAE_Engine::Math::Vector3 center = Point( 5.0f );
+			EAE_Engine::Math::Vector3 extents( Range( 0.0f, 6.0f ), Range( 0.0f, 6.0f ), Range( 0.0f, 6.0f ) );
+			if ( Index( 8 ) == 0 )
+				extents._u[Index( 3 )] = 0.0f;
+			EAE_Engine::Math::AABBV1 box;
+			box._min = center - extents;
+			box._max = center + extents;
+			return box;
+		}
+
+		// The triangles lie about flat, so the segments going down hit the ones facing up.
+		// One in eight of them is degenerated, two of its corners are the same or on a line.
+		void Triangle( EAE_Engine::Math::Vector3 o_corners[3] )
+		{
+			for ( uint32_t corner = 0; corner < 3; ++corner )
+				o_corners[corner] = EAE_Engine::Math::Vector3( Range( -5.0f, 5.0f ), Range( -2.0f, 2.0f ), Range( -5.0f, 5.0f ) );
+			const uint32_t kind = Index( 16 );
+			if ( kind == 0 )
+				o_corners[2] = o_corners[1];
+			else if ( kind == 1 )
+				o_corners[2] = o_corners[0] + ( o_corners[1] - o_corners[0] ) * 2.0f;
+		}
+	};
+
+	struct sTriangleHit
+	{
+		bool hit;
+		float t, u, v, w;
+	};
+
+	sTriangleHit IntersectScalar( const EAE_Engine::Math::Vector3& i_p, const EAE_Engine::Math::Vector3& i_q, const EAE_Engine::Math::Vector3 i_corners[3] )
+	{
+		sTriangleHit result;
+		result.t = result.u = result.v = result.w = 0.0f;
+		result.hit = EAE_Engine::Collision::IntersectSegmentTriangle( i_p, i_q, i_corners[0], i_corners[1], i_corners[2], result.u, result.v, result.w, result.t ) != 0;
+		return result;
+	}
+
+	bool IsSameBits( float i_lhs, float i_rhs )
+	{
+		return memcmp( &i_lhs, &i_rhs, sizeof( float ) ) == 0;
+	}
+
+	// The lane must match the scalar result, and the t, u, v, w of a hit must be the same floats.
+	bool IsSameHit( const sTriangleHit& i_scalar, uint32_t i_mask, uint32_t i_lane, const float* i_t, const float* i_u, const float* i_v, const float* i_w )
+	{
+		const bool hit = ( ( i_mask >> i_lane ) & 1 ) != 0;
+		if ( hit != i_scalar.hit )
+			return false;
+		return !hit || ( IsSameBits( i_t[i_lane], i_scalar.t ) && IsSameBits( i_u[i_lane], i_scalar.u ) &&
+			IsSameBits( i_v[i_lane], i_scalar.v ) && IsSameBits( i_w[i_lane], i_scalar.w ) );
+	}
+
+	uint32_t CountBits( uint32_t i_mask )
+	{
+		uint32_t count = 0;
+		for ( ; i_mask != 0; i_mask &= i_mask - 1 )
+			++count;
+		return count;
+	}
+
+	double GetNanoseconds( std::chrono::high_resolution_clock::time_point i_start, uint32_t i_testCount )
+	{
+		return std::chrono::duration<double, std::nano>( std::chrono::high_resolution_clock::now() - i_start ).count() / i_testCount;
+	}
+}
+
+// Interface
+//==========
+
+int EngineTests::RunSIMDTests()
+{
+	const int failureCountBefore = GetFailureCount();
+	sRandom random;
+
+	// One segment against the boxes, and the segments against one box.
+	uint32_t boxTestCount = 0;
+	uint32_t boxHitCount = 0;
+	uint32_t boxMismatchCount = 0;
+	uint32_t emptyBoxHitCount = 0;
+	for ( uint32_t iteration = 0; iteration < s_iterationCount; ++iteration )
+	{
+		EAE_Engine::Math::Vector3 start, end;
+		random.Segment( start, end );
+		EAE_Engine::Math::AABBV1 boxes[8];
+		EAE_Engine::Math::AABB4 boxes4;
+		EAE_Engine::Math::AABB8 boxes8;
+		uint32_t scalarMask = 0;
+		for ( uint32_t lane = 0; lane < 8; ++lane )
+		{
+			boxes[lane] = random.Box();
+			boxes8.Set( lane, EAE_Engine::Math::PackedAABB( boxes[lane] ) );
+			if ( lane < 4 )
+				boxes4.Set( lane, EAE_Engine::Math::PackedAABB( boxes[lane] ) );
+			scalarMask |= ( EAE_Engine::Collision::TestSegmentAABB( start, end, boxes[lane] ) ? 1u : 0u ) << lane;
+		}
+		boxMismatchCount += EAE_Engine::Collision::TestSegmentAABB4( start, end, boxes4 ) != ( scalarMask & 0xf ) ? 1 : 0;
+		boxMismatchCount += EAE_Engine::Collision::TestSegmentAABB8( start, end, boxes8 ) != scalarMask ? 1 : 0;
+
+		EAE_Engine::Math::Vector3 starts[8], ends[8];
+		EAE_Engine::Collision::Segment4 segments4;
+		EAE_Engine::Collision::Segment8 segments8;
+		uint32_t scalarSegmentMask = 0;
+		for ( uint32_t lane = 0; lane < 8; ++lane )
+		{
+			random.Segment( starts[lane], ends[lane] );
+			segments8.Set( lane, starts[lane], ends[lane] );
+			if ( lane < 4 )
+				segments4.Set( lane, starts[lane], ends[lane] );
+			scalarSegmentMask |= ( EAE_Engine::Collision::TestSegmentAABB( starts[lane], ends[lane], boxes[0] ) ? 1u : 0u ) << lane;
+		}
+		boxMismatchCount += EAE_Engine::Collision::TestSegment4AABB( segments4, boxes[0] ) != ( scalarSegmentMask & 0xf ) ? 1 : 0;
+		boxMismatchCount += EAE_Engine::Collision::TestSegment8AABB( segments8, boxes[0] ) != scalarSegmentMask ? 1 : 0;
+		boxTestCount += 16;
+		for ( uint32_t lane = 0; lane < 8; ++lane )
+			boxHitCount += ( ( scalarMask >> lane ) & 1 ) + ( ( scalarSegmentMask >> lane ) & 1 );
+
+		// The empty slots never overlap anything.
+		const uint32_t emptyLane = random.Index( 8 );
+		boxes8.SetEmpty( emptyLane );
+		segments8.SetEmpty( emptyLane );
+		emptyBoxHitCount += ( EAE_Engine::Collision::TestSegmentAABB8( start, end, boxes8 ) >> emptyLane ) & 1;
+		emptyBoxHitCount += ( EAE_Engine::Collision::TestSegment8AABB( segments8, boxes[0] ) >> emptyLane ) & 1;
+	}
+	ENGINE_TEST_CHECK( boxMismatchCount == 0 );
+	ENGINE_TEST_CHECK( emptyBoxHitCount == 0 );
+	// Both of the results must have been tested often.
+	ENGINE_TEST_CHECK( boxHitCount > boxTestCount / 10 && boxHitCount < boxTestCount - boxTestCount / 10 );
+
+	// One segment against the triangles, the segments go down through the triangles so many of them hit.
+	uint32_t triangleTestCount = 0;
+	uint32_t triangleHitCount = 0;
+	uint32_t triangleMismatchCount = 0;
+	uint32_t emptyTriangleHitCount = 0;
+	for ( uint32_t iteration = 0; iteration < s_iterationCount; ++iteration )
+	{
+		const EAE_Engine::Math::Vector3 p( random.Range( -2.0f, 2.0f ), random.Range( 2.0f, 10.0f ), random.Range( -2.0f, 2.0f ) );
+		const EAE_Engine::Math::Vector3 q( random.Range( -2.0f, 2.0f ), random.Range( -10.0f, -2.0f ), random.Range( -2.0f, 2.0f ) );
+		EAE_Engine::Collision::Triangle4 triangles4;
+		EAE_Engine::Collision::Triangle8 triangles8;
+		sTriangleHit scalarHits[8];
+		for ( uint32_t lane = 0; lane < 8; ++lane )
+		{
+			EAE_Engine::Math::Vector3 corners[3];
+			random.Triangle( corners );
+			triangles8.Set( lane, corners[0], corners[1], corners[2] );
+			if ( lane < 4 )
+				triangles4.Set( lane, corners[0], corners[1], corners[2] );
+			scalarHits[lane] = IntersectScalar( p, q, corners );
+			triangleHitCount += scalarHits[lane].hit ? 1 : 0;
+		}
+		float t[8], u[8], v[8], w[8];
+		const uint32_t mask4 = EAE_Engine::Collision::IntersectSegmentTriangle4( p, q, triangles4, t, u, v, w );
+		for ( uint32_t lane = 0; lane < 4; ++lane )
+			triangleMismatchCount += IsSameHit( scalarHits[lane], mask4, lane, t, u, v, w ) ? 0 : 1;
+		const uint32_t mask8 = EAE_Engine::Collision::IntersectSegmentTriangle8( p, q, triangles8, t, u, v, w );
+		for ( uint32_t lane = 0; lane < 8; ++lane )
+			triangleMismatchCount += IsSameHit( scalarHits[lane], mask8, lane, t, u, v, w ) ? 0 : 1;
+		triangleTestCount += 8;
+
+		const uint32_t emptyLane = random.Index( 8 );
+		triangles8.SetEmpty( emptyLane );
+		emptyTriangleHitCount += ( EAE_Engine::Collision::IntersectSegmentTriangle8( p, q, triangles8, t, u, v, w ) >> emptyLane ) & 1;
+	}
+	ENGINE_TEST_CHECK( triangleMismatchCount == 0 );
+	ENGINE_TEST_CHECK( emptyTriangleHitCount == 0 );
+	ENGINE_TEST_CHECK( triangleHitCount > triangleTestCount / 20 );
+	// Each scalar test is compared with the 4 wide and the 8 wide ones.
+	printf( "%u segment/box tests, %u hits: %u mismatches\n", boxTestCount, boxHitCount, boxMismatchCount );
+	printf( "%u segment/triangle tests, %u hits: %u mismatches\n", triangleTestCount, triangleHitCount, triangleMismatchCount );
+
+	// The throughput of one long segment against many boxes and triangles, like a query against the nodes and a leaf.
+	std::vector<EAE_Engine::Math::AABBV1> boxes( s_benchmarkCount );
+	std::vector<EAE_Engine::Math::AABB4> boxes4( s_benchmarkCount / 4 );
+	std::vector<EAE_Engine::Math::AABB8> boxes8( s_benchmarkCount / 8 );
+	std::vector<EAE_Engine::Math::Vector3> corners( s_benchmarkCount * 3 );
+	std::vector<EAE_Engine::Collision::Triangle4> triangles4( s_benchmarkCount / 4 );
+	std::vector<EAE_Engine::Collision::Triangle8> triangles8( s_benchmarkCount / 8 );
+	for ( uint32_t index = 0; index < s_benchmarkCount; ++index )
+	{
+		boxes[index] = random.Box();
+		boxes4[index / 4].Set( index % 4, EAE_Engine::Math::PackedAABB( boxes[index] ) );
+		boxes8[index / 8].Set( index % 8, EAE_Engine::Math::PackedAABB( boxes[index] ) );
+		random.Triangle( &corners[index * 3] );
+		triangles4[index / 4].Set( index % 4, corners[index * 3], corners[index * 3 + 1], corners[index * 3 + 2] );
+		triangles8[index / 8].Set( index % 8, corners[index * 3], corners[index * 3 + 1], corners[index * 3 + 2] );
+	}
+	const EAE_Engine::Math::Vector3 start( -12.0f, 8.0f, -9.0f );
+	const EAE_Engine::Math::Vector3 end( 11.0f, -7.0f, 10.0f );
+	const uint32_t testCount = s_benchmarkCount * s_benchmarkRepeatCount;
+	// The counts of the hits are printed, so the tests can't be left out by the compiler.
+	uint32_t hitCounts[6] = { 0, 0, 0, 0, 0, 0 };
+	double nanoseconds[6];
+	std::chrono::high_resolution_clock::time_point timeStart = std::chrono::high_resolution_clock::now();
+	for ( uint32_t repeat = 0; repeat < s_benchmarkRepeatCount; ++repeat )
+	{
+		for ( uint32_t index = 0; index < s_benchmarkCount; ++index )
+			hitCounts[0] += EAE_Engine::Collision::TestSegmentAABB( start, end, boxes[index] ) ? 1 : 0;
+	}
+	nanoseconds[0] = GetNanoseconds( timeStart, testCount );
+	timeStart = std::chrono::high_resolution_clock::now();
+	for ( uint32_t repeat = 0; repeat < s_benchmarkRepeatCount; ++repeat )
+	{
+		for ( uint32_t index = 0; index < s_benchmarkCount / 4; ++index )
+			hitCounts[1] += CountBits( EAE_Engine::Collision::TestSegmentAABB4( start, end, boxes4[index] ) );
+	}
+	nanoseconds[1] = GetNanoseconds( timeStart, testCount );
+	timeStart = std::chrono::high_resolution_clock::now();
+	for ( uint32_t repeat = 0; repeat < s_benchmarkRepeatCount; ++repeat )
+	{
+		for ( uint32_t index = 0; index < s_benchmarkCount / 8; ++index )
+			hitCounts[2] += CountBits( EAE_Engine::Collision::TestSegmentAABB8( start, end, boxes8[index] ) );
+	}
+	nanoseconds[2] = GetNanoseconds( timeStart, testCount );
+	timeStart = std::chrono::high_resolution_clock::now();
+	for ( uint32_t repeat = 0; repeat < s_benchmarkRepeatCount; ++repeat )
+	{
+		for ( uint32_t index = 0; index < s_benchmarkCount; ++index )
+			hitCounts[3] += IntersectScalar( start, end, &corners[index * 3] ).hit ? 1 : 0;
+	}
+	nanoseconds[3] = GetNanoseconds( timeStart, testCount );
+	float t[8], u[8], v[8], w[8];
+	timeStart = std::chrono::high_resolution_clock::now();
+	for ( uint32_t repeat = 0; repeat < s_benchmarkRepeatCount; ++repeat )
+	{
+		for ( uint32_t index = 0; index < s_benchmarkCount / 4; ++index )
+			hitCounts[4] += CountBits( EAE_Engine::Collision::IntersectSegmentTriangle4( start, end, triangles4[index], t, u, v, w ) );
+	}
+	nanoseconds[4] = GetNanoseconds( timeStart, testCount );
+	timeStart = std::chrono::high_resolution_clock::now();
+	for ( uint32_t repeat = 0; repeat < s_benchmarkRepeatCount; ++repeat )
+	{
+		for ( uint32_t index = 0; index < s_benchmarkCount / 8; ++index )
+			hitCounts[5] += CountBits( EAE_Engine::Collision::IntersectSegmentTriangle8( start, end, triangles8[index], t, u, v, w ) );
+	}
+	nanoseconds[5] = GetNanoseconds( timeStart, testCount );
+	printf( "ns per test of one segment (hits): boxes scalar %.2f (%u), 4 wide %.2f (%u), 8 wide %.2f (%u)\n",
+		nanoseconds[0], hitCounts[0], nanoseconds[1], hitCounts[1], nanoseconds[2], hitCounts[2] );
+	printf( "ns per test of one segment (hits): triangles scalar %.2f (%u), 4 wide %.2f (%u), 8 wide %.2f (%u)\n",
+		nanoseconds[3], hitCounts[3], nanoseconds[4], hitCounts[4], nanoseconds[5], hitCounts[5] );
+
+	return GetFailureCount() - failureCountBefore;
+}
@@ -0,0 +1,200 @@
+/*
+	The sleeping RigidBodys: 10k RigidBodys of which 90% rest on the ground.
+	The resting ones must fall asleep and stay where they are, and wake up on a force, a velocity, a Transform write they are told about or a touch.
+	It also prints the time of a step of the 10k RigidBodys next to the one of the moving 1k alone.
+*/
+
+// Header Files
+//=============
+
+#include "EngineTests.h"
+
+#include <chrono>
+#include <cstdio>
+
+#include "Engine/CollisionDetection/ColliderBase.h"
+#include "Engine/CollisionDetection/MeshCollider.h"
+#include "Engine/CollisionDetection/RigidBody.h"
+
+// Helper Definitions
+//===================
+
+namespace
+{
+	const uint32_t s_restingCount = 9000;
+	const uint32_t s_movingCount = 1000;
+	const uint32_t s_settleStepCount = 60;
+	const uint32_t s_timedStepCount = 60;
+	const float s_groundSize = 200.0f;
+
+	// The resting RigidBodys stand 1 m apart on a grid on the ground.
+	EAE_Engine::Math::Vector3 GetRestingPos( uint32_t i_index )
+	{
+		return EAE_Engine::Math::Vector3( -90.0f + ( i_index % 100 ) * 1.0f, 0.01f, -90.0f + ( i_index / 100 ) * 1.0f );
+	}
+
+	// The moving RigidBodys fly without gravity high above the resting ones, so they never touch them.
+	EAE_Engine::Math::Vector3 GetMovingPos( uint32_t i_index )
+	{
+		return EAE_Engine::Math::Vector3( -90.0f + ( i_index % 40 ) * 4.0f, 50.0f + ( i_index / 40 ) * 2.0f, 0.0f );
+	}
+
+	struct sWorld
+	{
+		std::vector<EngineTests::TestTransform> transforms;
+		EAE_Engine::Physics::RigidBodyManager rigidBodyManager;
+		std::vector<EAE_Engine::Physics::RigidBody*> rigidBodies;
+
+		void AddRigidBody( const EAE_Engine::Math::Vector3& i_pos, const EAE_Engine::Math::Vector3& i_velocity, bool i_useGravity )
+		{
+			// The capacity is reserved, so the RigidBodys keep the addresses of their Transforms.
+			transforms.push_back( EngineTests::TestTransform( i_pos ) );
+			EngineTests::TestTransform& transform = transforms.back();
+			EAE_Engine::Physics::RigidBody* pRigidBody = rigidBodyManager.AddRigidBody( &transform );
+			transform.AddComponent( { pRigidBody, pRigidBody->GetTypeID() } );
+			pRigidBody->SetPos( i_pos );
+			pRigidBody->SetVelocity( i_velocity );
+			pRigidBody->SetUseGravity( i_useGravity );
+			rigidBodies.push_back( pRigidBody );
+		}
+
+		void Step()
+		{
+			rigidBodyManager.FixedUpdateBegin();
+			rigidBodyManager.FixedUpdate();
+			rigidBodyManager.FixedUpdateEnd();
+		}
+
+		// The milliseconds of FixedUpdate and of the whole step, for one step.
+		void TimeSteps( uint32_t i_stepCount, double& o_fixedUpdateMilliseconds, double& o_stepMilliseconds )
+		{
+			o_fixedUpdateMilliseconds = 0.0;
+			o_stepMilliseconds = 0.0;
+			for ( uint32_t step = 0; step < i_stepCount; ++step )
+			{
+				const std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+				rigidBodyManager.FixedUpdateBegin();
+				const std::chrono::high_resolution_clock::time_point fixedUpdateStart = std::chrono::high_resolution_clock::now();
+				rigidBodyManager.FixedUpdate();
+				const std::chrono::high_resolution_clock::time_point fixedUpdateEnd = std::chrono::high_resolution_clock::now();
+				rigidBodyManager.FixedUpdateEnd();
+				o_fixedUpdateMilliseconds += std::chrono::duration<double, std::milli>( fixedUpdateEnd - fixedUpdateStart ).count();
+				o_stepMilliseconds += std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - start ).count();
+			}
+			o_fixedUpdateMilliseconds /= i_stepCount;
+			o_stepMilliseconds /= i_stepCount;
+		}
+	};
+
+	void AddMovingRigidBodies( sWorld& io_world )
+	{
+		for ( uint32_t movingIndex = 0; movingIndex < s_movingCount; ++movingIndex )
+		{
+			// Back and forth along z, fast enough to never fall asleep.
+			const float speed = movingIndex % 2 == 0 ? 5.0f : -5.0f;
+			io_world.AddRigidBody( GetMovingPos( movingIndex ), EAE_Engine::Math::Vector3( 0.0f, 0.0f, speed ), false );
+		}
+	}
+}
+
+// Interface
+//==========
+
+int EngineTests::RunSleepTests()
+{
+	const int failureCountBefore = GetFailureCount();
+	std::vector<EAE_Engine::Math::Vector3> positions;
+	positions.push_back( EAE_Engine::Math::Vector3( -s_groundSize, 0.0f, -s_groundSize ) );
+	positions.push_back( EAE_Engine::Math::Vector3( -s_groundSize, 0.0f, s_groundSize ) );
+	positions.push_back( EAE_Engine::Math::Vector3( s_groundSize, 0.0f, s_groundSize ) );
+	positions.push_back( EAE_Engine::Math::Vector3( s_groundSize, 0.0f, -s_groundSize ) );
+	const uint32_t indices[] = { 0, 1, 2, 0, 2, 3 };
+	CreateCollisionMesh( "SleepGround", positions, std::vector<uint32_t>( indices, indices + sizeof( indices ) / sizeof( indices[0] ) ), 3 );
+	TestTransform groundTransform;
+	EAE_Engine::Collider::MeshCollider* pGroundCollider = new EAE_Engine::Collider::MeshCollider( &groundTransform );
+	pGroundCollider->Init( "SleepGround" );
+	EAE_Engine::Collider::ColliderManager::GetInstance()->AddToColliderList( pGroundCollider );
+
+	{
+		sWorld world;
+		world.transforms.reserve( s_restingCount + s_movingCount + 1 );
+		for ( uint32_t restingIndex = 0; restingIndex < s_restingCount; ++restingIndex )
+			world.AddRigidBody( GetRestingPos( restingIndex ), EAE_Engine::Math::Vector3::Zero, true );
+		AddMovingRigidBodies( world );
+		for ( uint32_t step = 0; step < s_settleStepCount; ++step )
+			world.Step();
+		ENGINE_TEST_CHECK( world.rigidBodyManager.GetAwakeCount() == s_movingCount );
+		uint32_t awakeRestingCount = 0;
+		for ( uint32_t restingIndex = 0; restingIndex < s_restingCount; ++restingIndex )
+			awakeRestingCount += world.rigidBodies[restingIndex]->IsSleeping() ? 0 : 1;
+		ENGINE_TEST_CHECK( awakeRestingCount == 0 );
+
+		const EAE_Engine::Math::Vector3 sleepingPos = world.rigidBodies[0]->GetPos();
+		double allFixedUpdateMilliseconds, allStepMilliseconds;
+		world.TimeSteps( s_timedStepCount, allFixedUpdateMilliseconds, allStepMilliseconds );
+		// The sleepers stay where they fell asleep.
+		ENGINE_TEST_CHECK( ( world.rigidBodies[0]->GetPos() - sleepingPos ).SqMagnitude() == 0.0f );
+		ENGINE_TEST_CHECK( world.rigidBodyManager.GetAwakeCount() == s_movingCount );
+
+		sWorld movingWorld;
+		movingWorld.transforms.reserve( s_movingCount );
+		AddMovingRigidBodies( movingWorld );
+		for ( uint32_t step = 0; step < s_settleStepCount; ++step )
+			movingWorld.Step();
+		double movingFixedUpdateMilliseconds, movingStepMilliseconds;
+		movingWorld.TimeSteps( s_timedStepCount, movingFixedUpdateMilliseconds, movingStepMilliseconds );
+		// FixedUpdateBegin only looks at the awake RigidBodys and the sleepers told that their Transforms have moved.
+		printf( "%u sleeping and %u moving RigidBodys: FixedUpdate %.3f ms, whole step %.3f ms\n",
+			s_restingCount, s_movingCount, allFixedUpdateMilliseconds, allStepMilliseconds );
+		printf( "the %u moving RigidBodys alone: FixedUpdate %.3f ms, whole step %.3f ms\n",
+			s_movingCount, movingFixedUpdateMilliseconds, movingStepMilliseconds );
+
+		// A force wakes up a sleeper, and it falls asleep again after it lands.
+		EAE_Engine::Physics::RigidBody* pPushed = world.rigidBodies[10];
+		EAE_Engine::Math::Vector3 push( 0.0f, 300.0f, 0.0f );
+		pPushed->AddForce( push );
+		ENGINE_TEST_CHECK( !pPushed->IsSleeping() );
+		world.Step();
+		ENGINE_TEST_CHECK( !pPushed->IsSleeping() && pPushed->GetPos()._y > GetRestingPos( 10 )._y );
+		for ( uint32_t step = 0; step < 3 * s_settleStepCount && !pPushed->IsSleeping(); ++step )
+			world.Step();
+		ENGINE_TEST_CHECK( pPushed->IsSleeping() );
+
+		// So does a velocity.
+		EAE_Engine::Physics::RigidBody* pThrown = world.rigidBodies[20];
+		pThrown->SetVelocity( EAE_Engine::Math::Vector3( 0.0f, 3.0f, 0.0f ) );
+		world.Step();
+		ENGINE_TEST_CHECK( !pThrown->IsSleeping() && pThrown->GetPos()._y > GetRestingPos( 20 )._y );
+
+		// A Transform moved by someone else moves the sleeper with it at the next step,
+		// once the sleeper is told, like the Engine does for the transforms moved in the TransformHierarchy.
+		// The sleepers aren't polled, so the one which isn't told stays where it fell asleep.
+		EAE_Engine::Physics::RigidBody* pMoved = world.rigidBodies[30];
+		EAE_Engine::Physics::RigidBody* pNotTold = world.rigidBodies[31];
+		const EAE_Engine::Math::Vector3 movedPos = GetRestingPos( 30 ) + EAE_Engine::Math::Vector3( 0.0f, 2.0f, 0.0f );
+		const EAE_Engine::Math::Vector3 notToldPos = pNotTold->GetPos();
+		world.transforms[30].SetPos( movedPos );
+		world.transforms[31].SetPos( notToldPos + EAE_Engine::Math::Vector3( 0.0f, 2.0f, 0.0f ) );
+		pMoved->OnTransformMoved();
+		// Telling it twice only lists it once.
+		pMoved->OnTransformMoved();
+		world.Step();
+		ENGINE_TEST_CHECK( !pMoved->IsSleeping() && ( pMoved->GetPos() - movedPos ).Magnitude() < 0.5f );
+		ENGINE_TEST_CHECK( pNotTold->IsSleeping() && ( pNotTold->GetPos() - notToldPos ).SqMagnitude() == 0.0f );
+		world.transforms[31].SetPos( notToldPos );
+
+		// A RigidBody rolling through a sleeper wakes it up, the sleeper next to it doesn't wake up.
+		EAE_Engine::Physics::RigidBody* pTouched = world.rigidBodies[40 + 100 * 40];
+		EAE_Engine::Physics::RigidBody* pUntouched = world.rigidBodies[40 + 100 * 42];
+		const EAE_Engine::Math::Vector3 touchedPos = GetRestingPos( 40 + 100 * 40 );
+		world.AddRigidBody( touchedPos + EAE_Engine::Math::Vector3( 0.45f, 0.2f, 0.0f ), EAE_Engine::Math::Vector3( -6.0f, 0.0f, 0.0f ), true );
+		world.rigidBodies.back()->SetRadius( 0.2f );
+		for ( uint32_t step = 0; step < 10; ++step )
+			world.Step();
+		ENGINE_TEST_CHECK( !pTouched->IsSleeping() );
+		ENGINE_TEST_CHECK( pUntouched->IsSleeping() );
+	}
+
+	CleanScene();
+	return GetFailureCount() - failureCountBefore;
+}
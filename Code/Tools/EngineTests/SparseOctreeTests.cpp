@@ -0,0 +1,292 @@
+/*
+	The SparseOctree against the CompleteOctree of the same mesh: on 3 stacked height fields,
+	at levels 5 to 7 and with 1, 8 and a huge count of triangles per leaf, the segment queries
+	must find the same hits with the same t in the same order for all hits, the first hit and the closest 2 hits,
+	the leaves must be visited from near to far, and only the leaves of the last level may have more triangles than the limit.
+	It prints the nodes, the memory and the time of a first hit query of both trees, for short segments and for segments across the mesh.
+*/
+
+// Header Files
+//=============
+
+#include "EngineTests.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+#include "Engine/Mesh/AOSMeshData.h"
+#include "Engine/SpatialPartition/Octree.h"
+#include "Engine/SpatialPartition/SparseOctree.h"
+
+// Helper Definitions
+//===================
+
+namespace
+{
+	const uint32_t s_gridSize = 48;
+	const float s_cellSize = 2.0f;
+	const uint32_t s_layerCount = 3;
+	const float s_layerSpacing = 4.0f;
+	const uint32_t s_minLevel = 5;
+	const uint32_t s_maxLevel = 7;
+	const uint32_t s_compareCount = 2000;
+	const uint32_t s_benchmarkCount = 20000;
+	const float s_shortLength = 30.0f;
+	// More than the 3 layers a segment can cross, so the all hits mode never drops one.
+	const uint32_t s_maxHits = 16;
+
+	double GetMilliseconds( std::chrono::high_resolution_clock::time_point i_start )
+	{
+		return std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - i_start ).count();
+	}
+
+	// The rolling hills repeated at each layer, the triangles face +y.
+	void CreateLayers( std::vector<EAE_Engine::Math::Vector3>& o_positions, std::vector<uint32_t>& o_indices )
+	{
+		const float half = s_gridSize * s_cellSize * 0.5f;
+		for ( uint32_t layer = 0; layer < s_layerCount; ++layer )
+		{
+			const uint32_t first = (uint32_t)o_positions.size();
+			for ( uint32_t z = 0; z <= s_gridSize; ++z )
+			{
+				for ( uint32_t x = 0; x <= s_gridSize; ++x )
+				{
+					const float posX = x * s_cellSize - half;
+					const float posZ = z * s_cellSize - half;
+					const float posY = layer * s_layerSpacing + 1.5f * std::sin( posX * 0.2f + layer ) * std::cos( posZ * 0.15f );
+					o_positions.push_back( EAE_Engine::Math::Vector3( posX, posY, posZ ) );
+				}
+			}
+			for ( uint32_t z = 0; z < s_gridSize; ++z )
+			{
+				for ( uint32_t x = 0; x < s_gridSize; ++x )
+				{
+					const uint32_t v00 = first + z * ( s_gridSize + 1 ) + x;
+					const uint32_t v10 = v00 + 1;
+					const uint32_t v01 = v00 + s_gridSize + 1;
+					const uint32_t v11 = v01 + 1;
+					const uint32_t quad[] = { v00, v01, v11, v00, v11, v10 };
+					o_indices.insert( o_indices.end(), quad, quad + 6 );
+				}
+			}
+		}
+	}
+
+	bool IsBefore( const EAE_Engine::Core::SegmentHit& i_lhs, const EAE_Engine::Core::SegmentHit& i_rhs )
+	{
+		if ( i_lhs._t != i_rhs._t )
+			return i_lhs._t < i_rhs._t;
+		if ( i_lhs._triangle._index0 != i_rhs._triangle._index0 )
+			return i_lhs._triangle._index0 < i_rhs._triangle._index0;
+		if ( i_lhs._triangle._index1 != i_rhs._triangle._index1 )
+			return i_lhs._triangle._index1 < i_rhs._triangle._index1;
+		return i_lhs._triangle._index2 < i_rhs._triangle._index2;
+	}
+
+	struct sSegment
+	{
+		EAE_Engine::Math::Vector3 start;
+		EAE_Engine::Math::Vector3 end;
+	};
+
+	// Short segments anywhere around the mesh, segments across all of it, and vertical ones down through the layers.
+	void CreateSegments( const EAE_Engine::Math::Vector3& i_min, const EAE_Engine::Math::Vector3& i_max, uint32_t i_count,
+		bool i_isShort, uint32_t i_seed, std::vector<sSegment>& o_segments )
+	{
+		std::mt19937 generator( i_seed );
+		std::uniform_real_distribution<float> unit( 0.0f, 1.0f );
+		const EAE_Engine::Math::Vector3 size = i_max - i_min;
+		o_segments.resize( i_count );
+		for ( uint32_t segmentIndex = 0; segmentIndex < i_count; ++segmentIndex )
+		{
+			sSegment& segment = o_segments[segmentIndex];
+			const EAE_Engine::Math::Vector3 start( i_min._x + size._x * unit( generator ), i_min._y - 2.0f + ( size._y + 4.0f ) * unit( generator ),
+				i_min._z + size._z * unit( generator ) );
+			if ( segmentIndex % 4 == 3 )
+			{
+				segment.start = EAE_Engine::Math::Vector3( start._x, i_max._y + 2.0f, start._z );
+				segment.end = EAE_Engine::Math::Vector3( start._x, i_min._y - 2.0f, start._z );
+				continue;
+			}
+			const EAE_Engine::Math::Vector3 direction( unit( generator ) - 0.5f, unit( generator ) - 0.5f, unit( generator ) - 0.5f );
+			segment.start = start;
+			if ( i_isShort )
+				segment.end = start + direction.GetNormalize() * s_shortLength;
+			else
+				segment.end = EAE_Engine::Math::Vector3( i_min._x + size._x * unit( generator ), i_min._y + size._y * unit( generator ),
+					i_min._z + size._z * unit( generator ) );
+		}
+	}
+
+	// The segment queries of both trees, returns the count of the segments whose hits differ.
+	uint32_t CompareSegments( const EAE_Engine::Core::CompleteOctree& i_complete, const EAE_Engine::Core::SparseOctree& i_sparse,
+		const std::vector<sSegment>& i_segments, uint32_t& io_hitCount, uint32_t& io_unorderedCount )
+	{
+		uint32_t mismatchCount = 0;
+		EAE_Engine::Core::SegmentHit completeHits[s_maxHits];
+		EAE_Engine::Core::SegmentHit sparseHits[s_maxHits];
+		for ( size_t segmentIndex = 0; segmentIndex < i_segments.size(); ++segmentIndex )
+		{
+			const sSegment& segment = i_segments[segmentIndex];
+			// All of the hits, the triangles with the same t may be in either order.
+			const uint32_t completeCount = i_complete.GetTrianlgesCollideWithSegment( segment.start, segment.end, completeHits, s_maxHits );
+			const uint32_t sparseCount = i_sparse.GetTrianlgesCollideWithSegment( segment.start, segment.end, sparseHits, s_maxHits );
+			bool isSame = completeCount == sparseCount;
+			for ( uint32_t hitIndex = 0; isSame && hitIndex < sparseCount; ++hitIndex )
+				isSame = completeHits[hitIndex]._t == sparseHits[hitIndex]._t;
+			std::sort( completeHits, completeHits + completeCount, IsBefore );
+			std::sort( sparseHits, sparseHits + sparseCount, IsBefore );
+			for ( uint32_t hitIndex = 0; isSame && hitIndex < sparseCount; ++hitIndex )
+				isSame = completeHits[hitIndex]._triangle == sparseHits[hitIndex]._triangle;
+			io_hitCount += sparseCount;
+			// The first hit and the closest 2 hits stop early, they must still have the closest t.
+			EAE_Engine::Core::SegmentHit closest[2];
+			const uint32_t hitLimits[] = { 1, 2 };
+			for ( size_t limitIndex = 0; isSame && limitIndex < 2; ++limitIndex )
+			{
+				const uint32_t limit = hitLimits[limitIndex];
+				const uint32_t count = i_sparse.GetTrianlgesCollideWithSegment( segment.start, segment.end, closest, limit );
+				isSame = count == std::min( limit, completeCount );
+				for ( uint32_t hitIndex = 0; isSame && hitIndex < count; ++hitIndex )
+					isSame = closest[hitIndex]._t == completeHits[hitIndex]._t;
+				EAE_Engine::Core::SegmentHit completeClosest[2];
+				isSame = isSame && i_complete.GetTrianlgesCollideWithSegment( segment.start, segment.end, completeClosest, limit ) == count;
+			}
+			mismatchCount += isSame ? 0 : 1;
+
+			// The leaves come from near to far without overlapping.
+			float previousExit = 0.0f;
+			i_sparse.VisitLeavesAlongSegment( segment.start, segment.end,
+				[&previousExit, &io_unorderedCount]( const EAE_Engine::Core::OctreeNode&, float i_tEnter, float i_tExit )
+			{
+				io_unorderedCount += i_tEnter >= previousExit - 1.0e-6f && i_tEnter <= i_tExit ? 0 : 1;
+				previousExit = i_tExit;
+				return true;
+			} );
+		}
+		return mismatchCount;
+	}
+
+	// The leaves above the last level have at most maxTrianglesPerLeaf triangles, returns the count of the ones with more.
+	uint32_t CountOverfullLeaves( EAE_Engine::Core::SparseOctree& i_sparse, uint32_t i_maxTrianglesPerLeaf, const EAE_Engine::Math::Vector3& i_leafExtent )
+	{
+		uint32_t overfullCount = 0;
+		EAE_Engine::Core::OctreeNode* pNodes = i_sparse.GetNodes();
+		for ( uint32_t nodeIndex = 0; nodeIndex < i_sparse.GetNodeCount(); ++nodeIndex )
+		{
+			EAE_Engine::Core::OctreeNode& node = pNodes[nodeIndex];
+			if ( !i_sparse.IsLeaf( &node ) || node._triangleCount <= i_maxTrianglesPerLeaf )
+				continue;
+			overfullCount += node._extent == i_leafExtent ? 0 : 1;
+		}
+		return overfullCount;
+	}
+
+	double TimeFirstHits( const EAE_Engine::Core::CompleteOctree* i_pComplete, const EAE_Engine::Core::SparseOctree* i_pSparse,
+		const std::vector<sSegment>& i_segments, uint32_t& io_hitCount )
+	{
+		EAE_Engine::Core::SegmentHit hit;
+		std::chrono::high_resolution_clock::time_point timer = std::chrono::high_resolution_clock::now();
+		for ( size_t segmentIndex = 0; segmentIndex < i_segments.size(); ++segmentIndex )
+		{
+			const sSegment& segment = i_segments[segmentIndex];
+			io_hitCount += i_pComplete ? i_pComplete->GetTrianlgesCollideWithSegment( segment.start, segment.end, &hit, 1 ) :
+				i_pSparse->GetTrianlgesCollideWithSegment( segment.start, segment.end, &hit, 1 );
+		}
+		return GetMilliseconds( timer ) * 1000.0 / i_segments.size();
+	}
+}
+
+// Interface
+//==========
+
+int EngineTests::RunSparseOctreeTests()
+{
+	const int failureCountBefore = GetFailureCount();
+	std::vector<EAE_Engine::Math::Vector3> positions;
+	std::vector<uint32_t> indices;
+	CreateLayers( positions, indices );
+	std::vector<EAE_Engine::Mesh::TriangleIndex> triangles( indices.size() / 3 );
+	for ( size_t triangleIndex = 0; triangleIndex < triangles.size(); ++triangleIndex )
+	{
+		triangles[triangleIndex]._index0 = indices[triangleIndex * 3 + 0];
+		triangles[triangleIndex]._index1 = indices[triangleIndex * 3 + 1];
+		triangles[triangleIndex]._index2 = indices[triangleIndex * 3 + 2];
+	}
+	const uint32_t maxTrianglesPerLeafs[] = { 1, 8, 0xffffffff };
+
+	printf( "%-6s %-14s %-10s %-12s %-10s %-10s\n", "level", "tree", "nodes", "memory B", "short us", "long us" );
+	for ( uint32_t level = s_minLevel; level <= s_maxLevel; ++level )
+	{
+		char meshKey[32];
+		sprintf( meshKey, "SparseOctreeLayers%u", level );
+		EngineTests::CreateCollisionMesh( meshKey, positions, indices, level );
+		EAE_Engine::Core::CompleteOctree* pComplete = EAE_Engine::Core::OctreeManager::GetInstance()->GetOctree( meshKey );
+		EAE_Engine::Mesh::AOSMeshData* pMeshData = EAE_Engine::Mesh::AOSMeshDataManager::GetInstance()->GetAOSMeshData( meshKey );
+		const EAE_Engine::Math::Vector3 min = pComplete->GetMin();
+		const EAE_Engine::Math::Vector3 max = pComplete->GetMax();
+		const EAE_Engine::Math::Vector3 leafExtent = pComplete->GetNodesInLevel( level - 1 )[0]._extent;
+		std::vector<sSegment> segments;
+		CreateSegments( min, max, s_compareCount, level % 2 == 0, 47 + level, segments );
+		std::vector<sSegment> shortSegments;
+		std::vector<sSegment> longSegments;
+		CreateSegments( min, max, s_benchmarkCount, true, 147, shortSegments );
+		CreateSegments( min, max, s_benchmarkCount, false, 247, longSegments );
+
+		uint32_t completeShortHits = 0;
+		uint32_t completeLongHits = 0;
+		const double completeShortMicroseconds = TimeFirstHits( pComplete, nullptr, shortSegments, completeShortHits );
+		const double completeLongMicroseconds = TimeFirstHits( pComplete, nullptr, longSegments, completeLongHits );
+		printf( "%-6u %-14s %-10u %-12u %-10.2f %-10.2f\n", level, "complete", pComplete->GetNodeCount(), (uint32_t)pComplete->GetMemorySize(),
+			completeShortMicroseconds, completeLongMicroseconds );
+
+		for ( size_t limitIndex = 0; limitIndex < sizeof( maxTrianglesPerLeafs ) / sizeof( maxTrianglesPerLeafs[0] ); ++limitIndex )
+		{
+			const uint32_t maxTrianglesPerLeaf = maxTrianglesPerLeafs[limitIndex];
+			EAE_Engine::Core::SparseOctree sparse;
+			sparse.InitFromTriangles( level, maxTrianglesPerLeaf, min, max, positions, triangles );
+			sparse.SetCollisionMesh( pMeshData );
+			ENGINE_TEST_CHECK( sparse.Level() == level );
+			ENGINE_TEST_CHECK( CountOverfullLeaves( sparse, maxTrianglesPerLeaf, leafExtent ) == 0 );
+			// A tree which never splits is only its root.
+			ENGINE_TEST_CHECK( maxTrianglesPerLeaf != 0xffffffff || sparse.GetNodeCount() == 1 );
+			ENGINE_TEST_CHECK( sparse.GetNodeCount() < pComplete->GetNodeCount() );
+
+			uint32_t hitCount = 0;
+			uint32_t unorderedCount = 0;
+			ENGINE_TEST_CHECK( CompareSegments( *pComplete, sparse, segments, hitCount, unorderedCount ) == 0 );
+			ENGINE_TEST_CHECK( unorderedCount == 0 );
+			ENGINE_TEST_CHECK( hitCount > s_compareCount / 4 );
+
+			if ( maxTrianglesPerLeaf == 0xffffffff )
+				continue;
+			uint32_t sparseShortHits = 0;
+			uint32_t sparseLongHits = 0;
+			const double sparseShortMicroseconds = TimeFirstHits( nullptr, &sparse, shortSegments, sparseShortHits );
+			const double sparseLongMicroseconds = TimeFirstHits( nullptr, &sparse, longSegments, sparseLongHits );
+			ENGINE_TEST_CHECK( sparseShortHits == completeShortHits && sparseLongHits == completeLongHits );
+			// The sparse tree only keeps the nodes with triangles below them.
+			ENGINE_TEST_CHECK( sparse.GetMemorySize() < pComplete->GetMemorySize() );
+			char name[32];
+			sprintf( name, "sparse N = %u", maxTrianglesPerLeaf );
+			printf( "%-6s %-14s %-10u %-12u %-10.2f %-10.2f\n", "", name, sparse.GetNodeCount(), (uint32_t)sparse.GetMemorySize(),
+				sparseShortMicroseconds, sparseLongMicroseconds );
+		}
+	}
+	// A segment missing the bounds hits nothing.
+	{
+		EAE_Engine::Core::SparseOctree sparse;
+		sparse.InitFromTriangles( s_minLevel, 8, EAE_Engine::Math::Vector3( -50.0f, -3.0f, -50.0f ), EAE_Engine::Math::Vector3( 50.0f, 12.0f, 50.0f ), positions, triangles );
+		sparse.SetCollisionMesh( EAE_Engine::Mesh::AOSMeshDataManager::GetInstance()->GetAOSMeshData( "SparseOctreeLayers5" ) );
+		EAE_Engine::Core::SegmentHit hit;
+		ENGINE_TEST_CHECK( sparse.GetTrianlgesCollideWithSegment( EAE_Engine::Math::Vector3( -60.0f, 20.0f, 0.0f ),
+			EAE_Engine::Math::Vector3( 60.0f, 20.0f, 0.0f ), &hit, 1 ) == 0 );
+		ENGINE_TEST_CHECK( sparse.GetLeavesCollideWithSegment( EAE_Engine::Math::Vector3( -60.0f, 20.0f, 0.0f ),
+			EAE_Engine::Math::Vector3( 60.0f, 20.0f, 0.0f ) ).empty() );
+	}
+	EngineTests::CleanScene();
+	return GetFailureCount() - failureCountBefore;
+}
@@ -0,0 +1,400 @@
+/*
+	The SpatialHashGrid and the proximity grid of the World:
+	10k spheres of many sizes cross the cells, teleport far away, and some of them are removed and inserted again,
+	and after every round the sphere and box queries must find the same items as testing every item,
+	including the queries large enough to scan all of the items and the ones cut off by maxCount.
+	The GameObjs of the World, children included, move through the TransformHierarchy,
+	and after each UpdateProximityGrid GetGameObjsInRadius must find the same GameObjs as testing all of them.
+	It prints the time to move all of the items in a frame and of each query, next to testing every item.
+*/
+
+// Header Files
+//=============
+
+#include "EngineTests.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+#include "Engine/Core/Components/TransformHierarchy.h"
+#include "Engine/Core/Entirety/World.h"
+#include "Engine/Core/Individual/GameObj.h"
+#include "Engine/Math/SIMDGeometry.h"
+#include "Engine/SpatialPartition/SpatialHashGrid.h"
+
+// Helper Definitions
+//===================
+
+namespace
+{
+	const uint32_t s_itemCount = 10000;
+	const float s_worldExtent = 200.0f;
+	const float s_cellSize = 8.0f;
+	const uint32_t s_roundCount = 30;
+	const uint32_t s_churnCount = 50;
+	const uint32_t s_queryCount = 1000;
+	const uint32_t s_gameObjCount = 2000;
+	const uint32_t s_frameCount = 20;
+
+	double GetMilliseconds( std::chrono::high_resolution_clock::time_point i_start )
+	{
+		return std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - i_start ).count();
+	}
+
+	struct sItem
+	{
+		EAE_Engine::Math::Vector3 center;
+		EAE_Engine::Math::Vector3 velocity;
+		float radius;
+		// SpatialHashGrid::s_invalid when the item has been removed.
+		uint32_t id;
+	};
+
+	class cItems
+	{
+	public:
+		explicit cItems( EAE_Engine::Core::SpatialHashGrid& io_grid ) : _grid( io_grid ), _generator( 45 ) {}
+
+		EAE_Engine::Math::Vector3 GetRandomPosition( float i_extent )
+		{
+			std::uniform_real_distribution<float> across( -i_extent, i_extent );
+			return EAE_Engine::Math::Vector3( across( _generator ), across( _generator ), across( _generator ) );
+		}
+
+		// Most of the items are points or small, a few are larger than half of a cell and go to the large list.
+		float GetRandomRadius()
+		{
+			std::uniform_real_distribution<float> unit( 0.0f, 1.0f );
+			const float kind = unit( _generator );
+			if ( kind < 0.3f )
+				return 0.0f;
+			return kind < 0.97f ? unit( _generator ) * 2.0f : s_cellSize * ( 0.5f + unit( _generator ) * 2.0f );
+		}
+
+		void AddItems( uint32_t i_count )
+		{
+			items.resize( i_count );
+			for ( uint32_t index = 0; index < i_count; ++index )
+			{
+				sItem& item = items[index];
+				item.center = GetRandomPosition( s_worldExtent );
+				item.velocity = GetRandomPosition( 1.0f );
+				item.radius = GetRandomRadius();
+				item.id = _grid.Insert( item.center, item.radius, &item );
+			}
+		}
+
+		// Returns the count of the items which have moved to another cell.
+		uint32_t Move()
+		{
+			uint32_t relinkCount = 0;
+			for ( size_t index = 0; index < items.size(); ++index )
+			{
+				sItem& item = items[index];
+				if ( item.id == EAE_Engine::Core::SpatialHashGrid::s_invalid )
+					continue;
+				item.center = item.center + item.velocity;
+				for ( size_t axis = 0; axis < 3; ++axis )
+				{
+					if ( std::fabs( item.center._u[axis] ) > s_worldExtent )
+						item.velocity._u[axis] = -item.velocity._u[axis];
+				}
+				relinkCount += _grid.Update( item.id, item.center, item.radius ) ? 1 : 0;
+			}
+			return relinkCount;
+		}
+
+		// Teleport, resize, remove and insert a few of them, some of them far out where the cells are clamped.
+		void Churn()
+		{
+			std::uniform_int_distribution<size_t> pick( 0, items.size() - 1 );
+			for ( uint32_t count = 0; count < s_churnCount; ++count )
+			{
+				sItem& item = items[pick( _generator )];
+				if ( item.id == EAE_Engine::Core::SpatialHashGrid::s_invalid )
+					continue;
+				item.center = count % 10 == 0 ? GetRandomPosition( 1.0e10f ) : GetRandomPosition( s_worldExtent );
+				item.radius = GetRandomRadius();
+				_grid.Update( item.id, item.center, item.radius );
+			}
+			std::vector<size_t> removed;
+			for ( uint32_t count = 0; count < s_churnCount; ++count )
+			{
+				const size_t index = pick( _generator );
+				if ( items[index].id == EAE_Engine::Core::SpatialHashGrid::s_invalid )
+					continue;
+				_grid.Remove( items[index].id );
+				items[index].id = EAE_Engine::Core::SpatialHashGrid::s_invalid;
+				removed.push_back( index );
+			}
+			for ( size_t removedIndex = 0; removedIndex < removed.size(); removedIndex += 2 )
+			{
+				sItem& item = items[removed[removedIndex]];
+				item.center = GetRandomPosition( s_worldExtent );
+				item.radius = GetRandomRadius();
+				item.id = _grid.Insert( item.center, item.radius, &item );
+			}
+		}
+
+		uint32_t GetLiveCount() const
+		{
+			uint32_t count = 0;
+			for ( size_t index = 0; index < items.size(); ++index )
+				count += items[index].id == EAE_Engine::Core::SpatialHashGrid::s_invalid ? 0 : 1;
+			return count;
+		}
+
+		// The ids of the items which pass i_test, testing every one of them.
+		template<typename Test>
+		void BruteForce( Test i_test, std::vector<uint32_t>& o_ids ) const
+		{
+			o_ids.clear();
+			for ( size_t index = 0; index < items.size(); ++index )
+			{
+				const sItem& item = items[index];
+				if ( item.id != EAE_Engine::Core::SpatialHashGrid::s_invalid && i_test( item ) )
+					o_ids.push_back( item.id );
+			}
+		}
+
+		std::vector<sItem> items;
+
+	private:
+		EAE_Engine::Core::SpatialHashGrid& _grid;
+		std::mt19937 _generator;
+	};
+
+	bool IsSameIds( std::vector<uint32_t>& io_found, std::vector<uint32_t>& io_expected )
+	{
+		std::sort( io_found.begin(), io_found.end() );
+		std::sort( io_expected.begin(), io_expected.end() );
+		return io_found == io_expected;
+	}
+
+	bool IsInSphere( const sItem& i_item, const EAE_Engine::Math::Vector3& i_center, float i_radius )
+	{
+		const float distance = i_radius + i_item.radius;
+		return ( i_item.center - i_center ).SqMagnitude() <= distance * distance;
+	}
+
+	// The sphere and box queries against testing every item, returns the count of the queries which differ.
+	uint32_t CompareQueries( const EAE_Engine::Core::SpatialHashGrid& i_grid, cItems& io_items, std::mt19937& io_generator,
+		uint32_t i_queryCount, uint32_t& io_foundCount )
+	{
+		std::uniform_real_distribution<float> across( -s_worldExtent * 1.1f, s_worldExtent * 1.1f );
+		std::uniform_real_distribution<float> unit( 0.0f, 1.0f );
+		uint32_t mismatchCount = 0;
+		std::vector<uint32_t> found( s_itemCount );
+		std::vector<uint32_t> expected;
+		for ( uint32_t queryIndex = 0; queryIndex < i_queryCount; ++queryIndex )
+		{
+			const EAE_Engine::Math::Vector3 center( across( io_generator ), across( io_generator ), across( io_generator ) );
+			// Every 8th query covers so many cells that it scans all of the items instead.
+			const float size = queryIndex % 8 == 0 ? 150.0f + unit( io_generator ) * 100.0f : unit( io_generator ) * 20.0f;
+			found.resize( s_itemCount );
+			found.resize( i_grid.QuerySphere( center, size, &found[0], (uint32_t)found.size() ) );
+			io_items.BruteForce( [&center, size]( const sItem& i_item ) { return IsInSphere( i_item, center, size ); }, expected );
+			io_foundCount += (uint32_t)found.size();
+			mismatchCount += IsSameIds( found, expected ) ? 0 : 1;
+
+			const EAE_Engine::Math::Vector3 extents( size, size * unit( io_generator ), size * unit( io_generator ) );
+			const EAE_Engine::Math::PackedAABB box( center - extents, center + extents );
+			found.resize( s_itemCount );
+			found.resize( i_grid.QueryAABB( box, &found[0], (uint32_t)found.size() ) );
+			io_items.BruteForce( [&box]( const sItem& i_item ) { return EAE_Engine::Math::TestAABBSphere( box, i_item.center, i_item.radius ); }, expected );
+			io_foundCount += (uint32_t)found.size();
+			mismatchCount += IsSameIds( found, expected ) ? 0 : 1;
+
+			// A full output stops the query, every item written is still one of the expected ones.
+			const uint32_t maxCount = 3;
+			found.resize( maxCount );
+			found.resize( i_grid.QueryAABB( box, &found[0], maxCount ) );
+			bool isCutOff = found.size() == std::min<size_t>( maxCount, expected.size() );
+			for ( size_t index = 0; index < found.size(); ++index )
+				isCutOff = isCutOff && std::binary_search( expected.begin(), expected.end(), found[index] );
+			mismatchCount += isCutOff ? 0 : 1;
+		}
+		return mismatchCount;
+	}
+
+	// GameObjs in rows of a root and its children, the roots walk, and the children follow them through the TransformHierarchy.
+	void TestWorldProximityGrid()
+	{
+		EAE_Engine::Core::World& world = EAE_Engine::Core::World::GetInstance();
+		EAE_Engine::Core::TransformHierarchy* pHierarchy = EAE_Engine::Core::TransformHierarchy::GetInstance();
+		std::mt19937 generator( 145 );
+		std::uniform_real_distribution<float> across( -50.0f, 50.0f );
+		std::vector<EAE_Engine::Common::IGameObj*> roots;
+		std::vector<EAE_Engine::Math::Vector3> velocities;
+		std::vector<EAE_Engine::Common::IGameObj*> children;
+		for ( uint32_t index = 0; index < s_gameObjCount; ++index )
+		{
+			EAE_Engine::Math::Vector3 pos( across( generator ), across( generator ), across( generator ) );
+			char name[32];
+			sprintf( name, "ProximityObj%u", index );
+			EAE_Engine::Common::IGameObj* pObj = world.AddGameObj( name, pos );
+			if ( index % 4 == 0 )
+			{
+				roots.push_back( pObj );
+				velocities.push_back( EAE_Engine::Math::Vector3( across( generator ), 0.0f, across( generator ) ) * 0.05f );
+				continue;
+			}
+			pObj->GetTransform()->SetParent( roots.back()->GetTransform() );
+			pObj->GetTransform()->SetLocalPos( EAE_Engine::Math::Vector3( 0.5f * ( index % 4 ), 0.0f, 0.0f ) );
+			children.push_back( pObj );
+		}
+		// A transform which isn't a GameObj of the World moves too, the World skips it.
+		const uint32_t strayHandle = pHierarchy->AddTransform( nullptr );
+
+		uint32_t mismatchCount = 0;
+		uint32_t foundCount = 0;
+		uint32_t wrongCount = 0;
+		std::vector<EAE_Engine::Common::IGameObj*> found( s_gameObjCount );
+		std::vector<EAE_Engine::Common::IGameObj*> expected;
+		for ( uint32_t frame = 0; frame < s_frameCount; ++frame )
+		{
+			for ( size_t rootIndex = 0; rootIndex < roots.size(); ++rootIndex )
+			{
+				EAE_Engine::Common::ITransform* pTransform = roots[rootIndex]->GetTransform();
+				pTransform->SetLocalPos( pTransform->GetLocalPos() + velocities[rootIndex] );
+			}
+			pHierarchy->SetLocalPos( strayHandle, EAE_Engine::Math::Vector3( (float)frame, 0.0f, 0.0f ) );
+			// Remove a few children on the way.
+			if ( frame % 5 == 4 )
+			{
+				world.Remove( children.back()->GetTransform() );
+				children.pop_back();
+			}
+			pHierarchy->UpdateWorldTransforms();
+			world.UpdateProximityGrid();
+
+			for ( uint32_t queryIndex = 0; queryIndex < 50; ++queryIndex )
+			{
+				const EAE_Engine::Math::Vector3 center( across( generator ), across( generator ), across( generator ) );
+				const float radius = queryIndex % 10 == 0 ? 80.0f : 10.0f;
+				found.resize( s_gameObjCount );
+				found.resize( world.GetGameObjsInRadius( center, radius, &found[0], (uint32_t)found.size() ) );
+				expected.clear();
+				for ( size_t index = 0; index < world._gameObjList.size(); ++index )
+				{
+					EAE_Engine::Common::IGameObj* pObj = world._gameObjList[index];
+					if ( ( pObj->GetTransform()->GetPos() - center ).SqMagnitude() <= radius * radius )
+						expected.push_back( pObj );
+				}
+				std::sort( found.begin(), found.end() );
+				std::sort( expected.begin(), expected.end() );
+				mismatchCount += found == expected ? 0 : 1;
+				foundCount += (uint32_t)found.size();
+			}
+		}
+		// Only the GameObjs of the World are in the grid.
+		found.resize( s_gameObjCount );
+		found.resize( world.GetGameObjsInRadius( EAE_Engine::Math::Vector3::Zero, 1.0e6f, &found[0], (uint32_t)found.size() ) );
+		wrongCount += found.size() == world._gameObjList.size() ? 0 : 1;
+		ENGINE_TEST_CHECK( world.GetMovedHandles().size() > roots.size() );
+		ENGINE_TEST_CHECK( world._gameObjList.size() == s_gameObjCount - s_frameCount / 5 );
+		ENGINE_TEST_CHECK( mismatchCount == 0 );
+		ENGINE_TEST_CHECK( wrongCount == 0 );
+		ENGINE_TEST_CHECK( foundCount > 0 );
+		pHierarchy->RemoveTransform( strayHandle );
+		EAE_Engine::Core::World::CleanInstance();
+	}
+}
+
+// Interface
+//==========
+
+int EngineTests::RunSpatialHashGridTests()
+{
+	const int failureCountBefore = GetFailureCount();
+	EAE_Engine::Core::SpatialHashGrid grid( s_cellSize, 64 );
+	cItems items( grid );
+
+	std::chrono::high_resolution_clock::time_point timer = std::chrono::high_resolution_clock::now();
+	items.AddItems( s_itemCount );
+	const double insertMilliseconds = GetMilliseconds( timer );
+	ENGINE_TEST_CHECK( grid.GetItemCount() == s_itemCount );
+	// The table grows with the items.
+	ENGINE_TEST_CHECK( grid.GetBucketCount() >= s_itemCount );
+
+	std::mt19937 generator( 245 );
+	uint32_t mismatchCount = 0;
+	uint32_t countMismatchCount = 0;
+	uint32_t itemMismatchCount = 0;
+	uint32_t foundCount = 0;
+	uint32_t relinkCount = 0;
+	uint32_t moveCount = 0;
+	double moveMilliseconds = 0.0;
+	for ( uint32_t round = 0; round < s_roundCount; ++round )
+	{
+		timer = std::chrono::high_resolution_clock::now();
+		relinkCount += items.Move();
+		moveMilliseconds += GetMilliseconds( timer );
+		moveCount += items.GetLiveCount();
+		items.Churn();
+		countMismatchCount += grid.GetItemCount() == items.GetLiveCount() ? 0 : 1;
+		for ( size_t index = 0; index < items.items.size(); ++index )
+		{
+			const sItem& item = items.items[index];
+			if ( item.id != EAE_Engine::Core::SpatialHashGrid::s_invalid )
+				itemMismatchCount += grid.GetUserData( item.id ) == &item && grid.GetCenter( item.id ) == item.center ? 0 : 1;
+		}
+		if ( round % 3 == 0 )
+			mismatchCount += CompareQueries( grid, items, generator, 60, foundCount );
+	}
+	ENGINE_TEST_CHECK( countMismatchCount == 0 );
+	ENGINE_TEST_CHECK( itemMismatchCount == 0 );
+	ENGINE_TEST_CHECK( mismatchCount == 0 );
+	ENGINE_TEST_CHECK( foundCount > 0 );
+	// The items cross the cells, but most of the moves stay in the cell.
+	ENGINE_TEST_CHECK( relinkCount > 0 && relinkCount < moveCount / 2 );
+
+	// The time of each query against testing all of the items.
+	std::vector<EAE_Engine::Math::Vector3> centers( s_queryCount );
+	for ( uint32_t queryIndex = 0; queryIndex < s_queryCount; ++queryIndex )
+		centers[queryIndex] = items.GetRandomPosition( s_worldExtent );
+	std::vector<uint32_t> found( s_itemCount );
+	const float radii[] = { 8.0f, 32.0f };
+	double gridMilliseconds[2];
+	double bruteMilliseconds[2];
+	uint32_t gridCounts[2] = { 0, 0 };
+	uint32_t bruteCounts[2] = { 0, 0 };
+	for ( size_t radiusIndex = 0; radiusIndex < 2; ++radiusIndex )
+	{
+		const float radius = radii[radiusIndex];
+		timer = std::chrono::high_resolution_clock::now();
+		for ( uint32_t queryIndex = 0; queryIndex < s_queryCount; ++queryIndex )
+			gridCounts[radiusIndex] += grid.QuerySphere( centers[queryIndex], radius, &found[0], (uint32_t)found.size() );
+		gridMilliseconds[radiusIndex] = GetMilliseconds( timer );
+		timer = std::chrono::high_resolution_clock::now();
+		for ( uint32_t queryIndex = 0; queryIndex < s_queryCount; ++queryIndex )
+		{
+			for ( size_t index = 0; index < items.items.size(); ++index )
+			{
+				const sItem& item = items.items[index];
+				if ( item.id != EAE_Engine::Core::SpatialHashGrid::s_invalid && IsInSphere( item, centers[queryIndex], radius ) )
+					++bruteCounts[radiusIndex];
+			}
+		}
+		bruteMilliseconds[radiusIndex] = GetMilliseconds( timer );
+		ENGINE_TEST_CHECK( gridCounts[radiusIndex] == bruteCounts[radiusIndex] );
+	}
+
+	TestWorldProximityGrid();
+
+	printf( "%u items, cell %.0f, %u buckets, %.1f%% of the moves change the cell\n",
+		s_itemCount, s_cellSize, grid.GetBucketCount(), 100.0 * relinkCount / moveCount );
+	printf( "insert all %.3f ms, move all %.3f ms per frame\n", insertMilliseconds, moveMilliseconds / s_roundCount );
+	printf( "%-24s %-14s %-14s %-10s\n", "query", "grid us", "all items us", "found" );
+	for ( size_t radiusIndex = 0; radiusIndex < 2; ++radiusIndex )
+	{
+		char name[32];
+		sprintf( name, "sphere r = %.0f", radii[radiusIndex] );
+		printf( "%-24s %-14.2f %-14.2f %.1f\n", name, gridMilliseconds[radiusIndex] * 1000.0 / s_queryCount,
+			bruteMilliseconds[radiusIndex] * 1000.0 / s_queryCount, (double)gridCounts[radiusIndex] / s_queryCount );
+	}
+	return GetFailureCount() - failureCountBefore;
+}
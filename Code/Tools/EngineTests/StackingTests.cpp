@@ -0,0 +1,213 @@
+/*
+	The stacks of boxes on the ground, solved by the ContactSolver:
+		the tower of 10 boxes, the pyramid of 55 boxes and the wall of 195 boxes.
+	Each scene settles for 5 seconds with 4, 10 and 20 iterations, the stacks must stand and fall asleep
+	with little penetration left. It prints the time of a step and the deepest penetration left by a step.
+*/
+
+// Header Files
+//=============
+
+#include "EngineTests.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+#include "Engine/CollisionDetection/ColliderBase.h"
+#include "Engine/CollisionDetection/ContactSolver.h"
+#include "Engine/CollisionDetection/MeshCollider.h"
+#include "Engine/CollisionDetection/OBBCollider.h"
+#include "Engine/CollisionDetection/RigidBody.h"
+#include "Engine/Time/Time.h"
+
+// Helper Definitions
+//===================
+
+namespace
+{
+	const float s_boxSize = 1.0f;
+	const float s_settleDuration = 5.0f;
+	// The stack stands when no box moved further than this from where it started.
+	const float s_maxDrift = 0.1f;
+	// ContactSolver::s_allowedPenetration is left on purpose, the Baumgarte term only pushes out the rest.
+	const float s_maxPenetration = 0.02f;
+
+	const uint32_t s_iterationCounts[] = { 4, 10, 20 };
+	const size_t s_iterationCountCount = sizeof( s_iterationCounts ) / sizeof( s_iterationCounts[0] );
+
+	struct sStack
+	{
+		std::vector<EngineTests::TestTransform> transforms;
+		EAE_Engine::Physics::RigidBodyManager rigidBodyManager;
+		std::vector<EAE_Engine::Physics::RigidBody*> rigidBodies;
+		std::vector<EAE_Engine::Math::Vector3> startPositions;
+
+		explicit sStack( const std::vector<EAE_Engine::Math::Vector3>& i_positions ) :
+			startPositions( i_positions )
+		{
+			// The RigidBodys and the OBBColliders keep the addresses of their Transforms.
+			transforms.reserve( i_positions.size() );
+			const EAE_Engine::Math::Vector3 size( s_boxSize, s_boxSize, s_boxSize );
+			for ( size_t boxIndex = 0; boxIndex < i_positions.size(); ++boxIndex )
+			{
+				transforms.push_back( EngineTests::TestTransform( i_positions[boxIndex] ) );
+				EngineTests::TestTransform& transform = transforms.back();
+				EAE_Engine::Physics::RigidBody* pRigidBody = rigidBodyManager.AddRigidBody( &transform );
+				transform.AddComponent( { pRigidBody, pRigidBody->GetTypeID() } );
+				pRigidBody->SetPos( i_positions[boxIndex] );
+				EAE_Engine::Collider::OBBCollider* pCollider =
+					static_cast<EAE_Engine::Collider::OBBCollider*>( EAE_Engine::Collider::CreateOBBCollider( &transform, size ) );
+				pRigidBody->SetBoxCollider( pCollider );
+				rigidBodies.push_back( pRigidBody );
+			}
+		}
+
+		~sStack()
+		{
+			// The next scene starts without these boxes.
+			EAE_Engine::Collider::ColliderManager* pColliderManager = EAE_Engine::Collider::ColliderManager::GetInstance();
+			for ( size_t boxIndex = 0; boxIndex < transforms.size(); ++boxIndex )
+				pColliderManager->Remove( &transforms[boxIndex] );
+		}
+
+		void Step()
+		{
+			rigidBodyManager.FixedUpdateBegin();
+			rigidBodyManager.FixedUpdate();
+			rigidBodyManager.FixedUpdateEnd();
+		}
+
+		float GetMaxDrift() const
+		{
+			float maxDrift = 0.0f;
+			for ( size_t boxIndex = 0; boxIndex < rigidBodies.size(); ++boxIndex )
+			{
+				const float drift = std::sqrt( ( rigidBodies[boxIndex]->GetPos() - startPositions[boxIndex] ).SqMagnitude() );
+				maxDrift = drift > maxDrift ? drift : maxDrift;
+			}
+			return maxDrift;
+		}
+	};
+
+	// The boxes rest 1 mm above the ground and each other, so they start without penetration.
+	const float s_gap = 0.001f;
+
+	void CreateTower( std::vector<EAE_Engine::Math::Vector3>& o_positions )
+	{
+		for ( uint32_t level = 0; level < 10; ++level )
+			o_positions.push_back( EAE_Engine::Math::Vector3( 0.0f, ( s_boxSize + s_gap ) * ( level + 0.5f ), 0.0f ) );
+	}
+
+	void CreatePyramid( std::vector<EAE_Engine::Math::Vector3>& o_positions )
+	{
+		const uint32_t baseCount = 10;
+		for ( uint32_t level = 0; level < baseCount; ++level )
+		{
+			const uint32_t count = baseCount - level;
+			for ( uint32_t boxIndex = 0; boxIndex < count; ++boxIndex )
+			{
+				const float x = ( s_boxSize + s_gap ) * ( boxIndex - ( count - 1 ) * 0.5f );
+				o_positions.push_back( EAE_Engine::Math::Vector3( x, ( s_boxSize + s_gap ) * ( level + 0.5f ), 0.0f ) );
+			}
+		}
+	}
+
+	// 10 rows of bricks, 20 boxes wide, every other row shifted by half a box and one box shorter.
+	void CreateWall( std::vector<EAE_Engine::Math::Vector3>& o_positions )
+	{
+		for ( uint32_t level = 0; level < 10; ++level )
+		{
+			const float shift = level % 2 == 0 ? 0.0f : 0.5f * s_boxSize;
+			const uint32_t count = level % 2 == 0 ? 20 : 19;
+			for ( uint32_t boxIndex = 0; boxIndex < count; ++boxIndex )
+			{
+				const float x = ( s_boxSize + s_gap ) * boxIndex + shift - 10.0f;
+				o_positions.push_back( EAE_Engine::Math::Vector3( x, ( s_boxSize + s_gap ) * ( level + 0.5f ), 0.0f ) );
+			}
+		}
+	}
+
+	struct sScene
+	{
+		const char* name;
+		void ( *create )( std::vector<EAE_Engine::Math::Vector3>& o_positions );
+	};
+
+	const sScene s_scenes[] =
+	{
+		{ "tower of 10", CreateTower },
+		{ "pyramid of 55", CreatePyramid },
+		{ "wall of 195", CreateWall },
+	};
+	const size_t s_sceneCount = sizeof( s_scenes ) / sizeof( s_scenes[0] );
+}
+
+// Interface
+//==========
+
+int EngineTests::RunStackingTests()
+{
+	const int failureCountBefore = GetFailureCount();
+	std::vector<EAE_Engine::Math::Vector3> positions;
+	positions.push_back( EAE_Engine::Math::Vector3( -50.0f, 0.0f, -50.0f ) );
+	positions.push_back( EAE_Engine::Math::Vector3( -50.0f, 0.0f, 50.0f ) );
+	positions.push_back( EAE_Engine::Math::Vector3( 50.0f, 0.0f, 50.0f ) );
+	positions.push_back( EAE_Engine::Math::Vector3( 50.0f, 0.0f, -50.0f ) );
+	const uint32_t indices[] = { 0, 1, 2, 0, 2, 3 };
+	CreateCollisionMesh( "StackingGround", positions, std::vector<uint32_t>( indices, indices + sizeof( indices ) / sizeof( indices[0] ) ), 3 );
+	TestTransform groundTransform;
+	EAE_Engine::Collider::MeshCollider* pGroundCollider = new EAE_Engine::Collider::MeshCollider( &groundTransform );
+	pGroundCollider->Init( "StackingGround" );
+	EAE_Engine::Collider::ColliderManager::GetInstance()->AddToColliderList( pGroundCollider );
+
+	const float fixedTimeStep = EAE_Engine::Time::GetFixedTimeStep();
+	const uint32_t stepCount = (uint32_t)( s_settleDuration / fixedTimeStep );
+	printf( "%-16s %-10s %-12s %-14s %-10s %-8s\n", "scene", "iterations", "ms per step", "penetration", "drift", "asleep" );
+	for ( size_t sceneIndex = 0; sceneIndex < s_sceneCount; ++sceneIndex )
+	{
+		const sScene& scene = s_scenes[sceneIndex];
+		std::vector<EAE_Engine::Math::Vector3> boxPositions;
+		scene.create( boxPositions );
+		for ( size_t iterationIndex = 0; iterationIndex < s_iterationCountCount; ++iterationIndex )
+		{
+			const uint32_t iterationCount = s_iterationCounts[iterationIndex];
+			sStack stack( boxPositions );
+			EAE_Engine::Physics::ContactSolver& contactSolver = stack.rigidBodyManager.GetContactSolver();
+			contactSolver.SetIterationCount( iterationCount );
+			double milliseconds = 0.0;
+			uint32_t timedStepCount = 0;
+			float maxPenetration = 0.0f;
+			for ( uint32_t step = 0; step < stepCount; ++step )
+			{
+				const std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+				stack.Step();
+				// The steps after the whole stack sleeps cost nothing, they would hide the cost of the solver.
+				if ( contactSolver.GetStatistics()._bodyCount > 0 )
+				{
+					milliseconds += std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - start ).count();
+					++timedStepCount;
+				}
+				// The penetration found at the start of each step is the one left by the steps before.
+				maxPenetration = std::max( maxPenetration, contactSolver.GetStatistics()._maxPenetration );
+			}
+			uint32_t sleepingCount = 0;
+			for ( size_t boxIndex = 0; boxIndex < stack.rigidBodies.size(); ++boxIndex )
+				sleepingCount += stack.rigidBodies[boxIndex]->IsSleeping() ? 1 : 0;
+			const float drift = stack.GetMaxDrift();
+			printf( "%-16s %-10u %-12.3f %-14g %-10g %u/%u\n", scene.name, iterationCount,
+				timedStepCount > 0 ? milliseconds / timedStepCount : 0.0, maxPenetration, drift, sleepingCount, (uint32_t)stack.rigidBodies.size() );
+			// The default count of iterations must hold all of the stacks.
+			if ( iterationCount >= EAE_Engine::Physics::ContactSolver::s_defaultIterationCount )
+			{
+				ENGINE_TEST_CHECK( drift < s_maxDrift );
+				ENGINE_TEST_CHECK( maxPenetration < s_maxPenetration );
+				ENGINE_TEST_CHECK( sleepingCount == stack.rigidBodies.size() );
+			}
+		}
+	}
+
+	CleanScene();
+	return GetFailureCount() - failureCountBefore;
+}
@@ -0,0 +1,220 @@
+/*
+	The TransformHierarchy with 256 roots of 256 Transforms each, once as deep chains and once as wide fans:
+	the world positions must follow the parents, each worker count must give the same world matrices bit for bit,
+	only the moved subtree must be collected, and removed parents must leave their children where they were.
+	It prints the Transforms updated per ms with 1 to N workers and the time of removing all of them.
+*/
+
+// Header Files
+//=============
+
+#include "EngineTests.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <thread>
+
+#include "Engine/Core/Components/TransformHierarchy.h"
+
+// Helper Definitions
+//===================
+
+namespace
+{
+	const uint32_t s_rootCount = 256;
+	const uint32_t s_transformsPerRoot = 256;
+	const uint32_t s_timedPassCount = 20;
+	const float s_tolerance = 1.0e-3f;
+
+	// The handles of a root and its Transforms, [0] is the root.
+	// In a chain each one is the child of the one before it, in a fan all of them are the children of the root.
+	// Each child is 1 m above its parent, so the chain climbs and the fan stays 1 m above the root.
+	struct sForest
+	{
+		std::vector<std::vector<uint32_t> > trees;
+		bool isChain;
+
+		explicit sForest( bool i_isChain ) : isChain( i_isChain )
+		{
+			EAE_Engine::Core::TransformHierarchy* pHierarchy = EAE_Engine::Core::TransformHierarchy::GetInstance();
+			trees.resize( s_rootCount );
+			for ( uint32_t rootIndex = 0; rootIndex < s_rootCount; ++rootIndex )
+			{
+				std::vector<uint32_t>& tree = trees[rootIndex];
+				tree.push_back( pHierarchy->AddTransform( nullptr ) );
+				pHierarchy->SetLocalPos( tree[0], GetRootPos( rootIndex ) );
+				for ( uint32_t depth = 1; depth < s_transformsPerRoot; ++depth )
+				{
+					const uint32_t handle = pHierarchy->AddTransform( nullptr );
+					pHierarchy->SetParent( handle, isChain ? tree.back() : tree[0] );
+					pHierarchy->SetLocalPos( handle, EAE_Engine::Math::Vector3( 0.0f, 1.0f, 0.0f ) );
+					tree.push_back( handle );
+				}
+			}
+		}
+
+		static EAE_Engine::Math::Vector3 GetRootPos( uint32_t i_rootIndex )
+		{
+			return EAE_Engine::Math::Vector3( ( i_rootIndex % 16 ) * 10.0f, 0.0f, ( i_rootIndex / 16 ) * 10.0f );
+		}
+
+		EAE_Engine::Math::Vector3 GetExpectedPos( uint32_t i_rootIndex, uint32_t i_depth ) const
+		{
+			const float height = i_depth == 0 ? 0.0f : ( isChain ? (float)i_depth : 1.0f );
+			return GetRootPos( i_rootIndex ) + EAE_Engine::Math::Vector3( 0.0f, height, 0.0f );
+		}
+
+		// The yaw of the roots turns all of the world matrices, the children stay above the roots.
+		void TurnRoots( float i_angle )
+		{
+			EAE_Engine::Core::TransformHierarchy* pHierarchy = EAE_Engine::Core::TransformHierarchy::GetInstance();
+			for ( uint32_t rootIndex = 0; rootIndex < s_rootCount; ++rootIndex )
+				pHierarchy->SetLocalRotation( trees[rootIndex][0], EAE_Engine::Math::Quaternion( i_angle + rootIndex * 0.01f, EAE_Engine::Math::Vector3( 0.0f, 1.0f, 0.0f ) ) );
+		}
+
+		uint32_t CountMisplaced() const
+		{
+			EAE_Engine::Core::TransformHierarchy* pHierarchy = EAE_Engine::Core::TransformHierarchy::GetInstance();
+			uint32_t misplacedCount = 0;
+			for ( uint32_t rootIndex = 0; rootIndex < s_rootCount; ++rootIndex )
+			{
+				for ( uint32_t depth = 0; depth < s_transformsPerRoot; ++depth )
+				{
+					if ( ( pHierarchy->GetWorldPos( trees[rootIndex][depth] ) - GetExpectedPos( rootIndex, depth ) ).Magnitude() > s_tolerance )
+						++misplacedCount;
+				}
+			}
+			return misplacedCount;
+		}
+
+		void GetWorldMatrices( std::vector<EAE_Engine::Math::ColMatrix44>& o_matrices ) const
+		{
+			EAE_Engine::Core::TransformHierarchy* pHierarchy = EAE_Engine::Core::TransformHierarchy::GetInstance();
+			o_matrices.clear();
+			for ( uint32_t rootIndex = 0; rootIndex < s_rootCount; ++rootIndex )
+			{
+				for ( uint32_t depth = 0; depth < s_transformsPerRoot; ++depth )
+					o_matrices.push_back( pHierarchy->GetWorldMatrix( trees[rootIndex][depth] ) );
+			}
+		}
+	};
+
+	std::vector<uint32_t> GetWorkerCounts()
+	{
+		// Up to 4 workers at least, so the split is tested on a machine with fewer cores too.
+		const uint32_t hardwareCount = std::max( 1u, std::thread::hardware_concurrency() );
+		std::vector<uint32_t> workerCounts;
+		for ( uint32_t workerCount = 1; workerCount < std::max( 4u, hardwareCount ); workerCount *= 2 )
+			workerCounts.push_back( workerCount );
+		workerCounts.push_back( std::max( 4u, hardwareCount ) );
+		return workerCounts;
+	}
+
+	double GetMilliseconds( std::chrono::high_resolution_clock::time_point i_start )
+	{
+		return std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - i_start ).count();
+	}
+
+	void TestForest( bool i_isChain )
+	{
+		EAE_Engine::Core::TransformHierarchy* pHierarchy = EAE_Engine::Core::TransformHierarchy::GetInstance();
+		const uint32_t transformCount = s_rootCount * s_transformsPerRoot;
+		sForest forest( i_isChain );
+		pHierarchy->SetWorkerCount( 1 );
+		forest.TurnRoots( 0.5f );
+		pHierarchy->UpdateWorldTransforms();
+		ENGINE_TEST_CHECK( pHierarchy->GetUpdatedCountOnLastPass() == transformCount );
+		ENGINE_TEST_CHECK( forest.CountMisplaced() == 0 );
+		std::vector<EAE_Engine::Math::ColMatrix44> serialMatrices;
+		forest.GetWorldMatrices( serialMatrices );
+		std::vector<uint32_t> movedHandles;
+		pHierarchy->CollectMovedHandles( movedHandles );
+		ENGINE_TEST_CHECK( movedHandles.size() == transformCount );
+
+		// Each worker count updates the same Transforms to the same bits, and all of them are timed on the same passes.
+		const std::vector<uint32_t> workerCounts = GetWorkerCounts();
+		printf( "%-6s workers  transforms/ms\n", i_isChain ? "chains" : "fans" );
+		for ( size_t countIndex = 0; countIndex < workerCounts.size(); ++countIndex )
+		{
+			pHierarchy->SetWorkerCount( workerCounts[countIndex] );
+			double milliseconds = 0.0;
+			for ( uint32_t pass = 0; pass < s_timedPassCount; ++pass )
+			{
+				forest.TurnRoots( pass * 0.1f );
+				const std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+				pHierarchy->UpdateWorldTransforms();
+				milliseconds += GetMilliseconds( start );
+			}
+			ENGINE_TEST_CHECK( pHierarchy->GetUpdatedCountOnLastPass() == transformCount );
+			forest.TurnRoots( 0.5f );
+			pHierarchy->UpdateWorldTransforms();
+			std::vector<EAE_Engine::Math::ColMatrix44> matrices;
+			forest.GetWorldMatrices( matrices );
+			ENGINE_TEST_CHECK( memcmp( &matrices[0], &serialMatrices[0], sizeof( EAE_Engine::Math::ColMatrix44 ) * transformCount ) == 0 );
+			printf( "       %-8u %.0f\n", workerCounts[countIndex], transformCount * s_timedPassCount / milliseconds );
+		}
+		movedHandles.clear();
+		pHierarchy->CollectMovedHandles( movedHandles );
+		ENGINE_TEST_CHECK( movedHandles.size() == transformCount );
+
+		// Only the moved root and its Transforms are collected.
+		pHierarchy->SetLocalPos( forest.trees[7][0], sForest::GetRootPos( 7 ) );
+		pHierarchy->UpdateWorldTransforms();
+		ENGINE_TEST_CHECK( pHierarchy->GetUpdatedCountOnLastPass() == s_transformsPerRoot );
+		movedHandles.clear();
+		pHierarchy->CollectMovedHandles( movedHandles );
+		std::sort( movedHandles.begin(), movedHandles.end() );
+		std::vector<uint32_t> tree = forest.trees[7];
+		std::sort( tree.begin(), tree.end() );
+		ENGINE_TEST_CHECK( movedHandles == tree );
+
+		// The children of a removed Transform become roots where they were.
+		const uint32_t removedDepth = s_transformsPerRoot / 2;
+		for ( uint32_t rootIndex = 0; rootIndex < s_rootCount; ++rootIndex )
+		{
+			pHierarchy->RemoveTransform( forest.trees[rootIndex][removedDepth] );
+			forest.trees[rootIndex].erase( forest.trees[rootIndex].begin() + removedDepth );
+		}
+		pHierarchy->UpdateWorldTransforms();
+		uint32_t misplacedCount = 0;
+		for ( uint32_t rootIndex = 0; rootIndex < s_rootCount; ++rootIndex )
+		{
+			for ( uint32_t depth = 0; depth + 1 < s_transformsPerRoot; ++depth )
+			{
+				const uint32_t oldDepth = depth < removedDepth ? depth : depth + 1;
+				if ( ( pHierarchy->GetWorldPos( forest.trees[rootIndex][depth] ) - forest.GetExpectedPos( rootIndex, oldDepth ) ).Magnitude() > s_tolerance )
+					++misplacedCount;
+			}
+		}
+		ENGINE_TEST_CHECK( misplacedCount == 0 );
+		ENGINE_TEST_CHECK( pHierarchy->GetCount() == transformCount - s_rootCount );
+
+		// Tearing the scene down in any order only unlinks each Transform from its parent and its children.
+		std::vector<uint32_t> handles;
+		for ( uint32_t rootIndex = 0; rootIndex < s_rootCount; ++rootIndex )
+			handles.insert( handles.end(), forest.trees[rootIndex].begin(), forest.trees[rootIndex].end() );
+		std::shuffle( handles.begin(), handles.end(), std::mt19937( 26 ) );
+		const std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		for ( size_t handleIndex = 0; handleIndex < handles.size(); ++handleIndex )
+			pHierarchy->RemoveTransform( handles[handleIndex] );
+		const double removeMilliseconds = GetMilliseconds( start );
+		ENGINE_TEST_CHECK( pHierarchy->GetCount() == 0 );
+		printf( "removing the %u %s Transforms in a random order: %.2f ms\n", (uint32_t)handles.size(), i_isChain ? "chained" : "fanned", removeMilliseconds );
+	}
+}
+
+// Interface
+//==========
+
+int EngineTests::RunTransformTests()
+{
+	const int failureCountBefore = GetFailureCount();
+	TestForest( true );
+	TestForest( false );
+	EAE_Engine::Core::TransformHierarchy::Destroy();
+	return GetFailureCount() - failureCountBefore;
+}
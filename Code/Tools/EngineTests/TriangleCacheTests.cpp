@@ -0,0 +1,313 @@
+/*
+	The SoA packets of CollisionTriangleCache against the scalar per triangle path of the CompleteOctree:
+	on 3 stacked height fields with a soup of triangles of both windings between them, at levels 3 and 5,
+	each lane of the packets of the leaves crossed by a segment must hit when IntersectSegmentTriangle hits its triangle,
+	with the same t bit for bit, the empty lanes must never hit, and the hits the cache inserts with InsertSegmentHit
+	must be the ones of CompleteOctree::GetTrianlgesCollideWithSegment in the same order for 1, 2, 4 and 16 hits.
+	It prints the memory of the packets, the time of testing the triangles of the crossed leaves one by one and in packets,
+	and the time of the first hit and all hits queries of both paths.
+*/
+
+// Header Files
+//=============
+
+#include "EngineTests.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+#include "Engine/CollisionDetection/CollisionDetectionFunctions.h"
+#include "Engine/Mesh/AOSMeshData.h"
+#include "Engine/SpatialPartition/CollisionTriangleCache.h"
+#include "Engine/SpatialPartition/Octree.h"
+
+// Helper Definitions
+//===================
+
+namespace
+{
+	const uint32_t s_gridSize = 48;
+	const float s_cellSize = 2.0f;
+	const uint32_t s_layerCount = 3;
+	const float s_layerSpacing = 4.0f;
+	const uint32_t s_soupCount = 2000;
+	const uint32_t s_segmentCount = 10000;
+	const uint32_t s_maxHits = 16;
+
+	double GetMilliseconds( std::chrono::high_resolution_clock::time_point i_start )
+	{
+		return std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - i_start ).count();
+	}
+
+	// The rolling hills repeated at each layer, the triangles face +y,
+	// and small triangles of both windings between the layers.
+	void CreateMesh( std::vector<EAE_Engine::Math::Vector3>& o_positions, std::vector<uint32_t>& o_indices )
+	{
+		const float half = s_gridSize * s_cellSize * 0.5f;
+		for ( uint32_t layer = 0; layer < s_layerCount; ++layer )
+		{
+			const uint32_t first = (uint32_t)o_positions.size();
+			for ( uint32_t z = 0; z <= s_gridSize; ++z )
+			{
+				for ( uint32_t x = 0; x <= s_gridSize; ++x )
+				{
+					const float posX = x * s_cellSize - half;
+					const float posZ = z * s_cellSize - half;
+					const float posY = layer * s_layerSpacing + 1.5f * std::sin( posX * 0.2f + layer ) * std::cos( posZ * 0.15f );
+					o_positions.push_back( EAE_Engine::Math::Vector3( posX, posY, posZ ) );
+				}
+			}
+			for ( uint32_t z = 0; z < s_gridSize; ++z )
+			{
+				for ( uint32_t x = 0; x < s_gridSize; ++x )
+				{
+					const uint32_t v00 = first + z * ( s_gridSize + 1 ) + x;
+					const uint32_t v10 = v00 + 1;
+					const uint32_t v01 = v00 + s_gridSize + 1;
+					const uint32_t v11 = v01 + 1;
+					const uint32_t quad[] = { v00, v01, v11, v00, v11, v10 };
+					o_indices.insert( o_indices.end(), quad, quad + 6 );
+				}
+			}
+		}
+		std::mt19937 generator( 49 );
+		std::uniform_real_distribution<float> unit( 0.0f, 1.0f );
+		for ( uint32_t triangleIndex = 0; triangleIndex < s_soupCount; ++triangleIndex )
+		{
+			const EAE_Engine::Math::Vector3 center( ( unit( generator ) - 0.5f ) * 2.0f * half, unit( generator ) * s_layerSpacing * s_layerCount,
+				( unit( generator ) - 0.5f ) * 2.0f * half );
+			const uint32_t first = (uint32_t)o_positions.size();
+			for ( size_t vertexIndex = 0; vertexIndex < 3; ++vertexIndex )
+				o_positions.push_back( center + EAE_Engine::Math::Vector3( unit( generator ) - 0.5f, unit( generator ) - 0.5f, unit( generator ) - 0.5f ) * 6.0f );
+			o_indices.push_back( first );
+			o_indices.push_back( first + 1 );
+			o_indices.push_back( first + 2 );
+		}
+	}
+
+	struct sSegment
+	{
+		EAE_Engine::Math::Vector3 start;
+		EAE_Engine::Math::Vector3 end;
+	};
+
+	// Segments across the mesh in all directions, and every 4th one straight down through the layers.
+	void CreateSegments( const EAE_Engine::Math::Vector3& i_min, const EAE_Engine::Math::Vector3& i_max, uint32_t i_seed, std::vector<sSegment>& o_segments )
+	{
+		std::mt19937 generator( i_seed );
+		std::uniform_real_distribution<float> unit( 0.0f, 1.0f );
+		const EAE_Engine::Math::Vector3 size = i_max - i_min;
+		o_segments.resize( s_segmentCount );
+		for ( uint32_t segmentIndex = 0; segmentIndex < s_segmentCount; ++segmentIndex )
+		{
+			sSegment& segment = o_segments[segmentIndex];
+			segment.start = EAE_Engine::Math::Vector3( i_min._x + size._x * unit( generator ), i_min._y + size._y * unit( generator ), i_min._z + size._z * unit( generator ) );
+			if ( segmentIndex % 4 == 3 )
+			{
+				segment.start._y = i_max._y;
+				segment.end = EAE_Engine::Math::Vector3( segment.start._x, i_min._y, segment.start._z );
+				continue;
+			}
+			segment.end = EAE_Engine::Math::Vector3( i_min._x + size._x * unit( generator ), i_min._y + size._y * unit( generator ), i_min._z + size._z * unit( generator ) );
+		}
+	}
+
+	bool IsSameBits( float i_lhs, float i_rhs )
+	{
+		return memcmp( &i_lhs, &i_rhs, sizeof( float ) ) == 0;
+	}
+
+	// Every lane of the packets of the leaves crossed by the segment against IntersectSegmentTriangle on its triangle,
+	// returns the count of the lanes which differ.
+	uint32_t CompareLanes( EAE_Engine::Core::CompleteOctree& i_octree, const EAE_Engine::Core::CollisionTriangleCache& i_cache,
+		const std::vector<EAE_Engine::Mesh::sVertex>& i_vertices, const sSegment& i_segment, uint32_t& io_laneCount, uint32_t& io_hitCount )
+	{
+		uint32_t mismatchCount = 0;
+		i_octree.VisitNodesAlongSegment( i_segment.start, i_segment.end, i_octree.Level() - 1, [&]( const EAE_Engine::Core::OctreeNode& i_leaf, float, float )
+		{
+			uint32_t packetCount = 0;
+			const EAE_Engine::Collision::Triangle4* pPackets = i_cache.GetPackets( i_leaf, packetCount );
+			mismatchCount += packetCount == ( i_leaf._triangleCount + 3 ) / 4 ? 0 : 1;
+			for ( uint32_t packetIndex = 0; packetIndex < packetCount; ++packetIndex )
+			{
+				float t[4], u[4], v[4], w[4];
+				const uint32_t hitMask = EAE_Engine::Collision::IntersectSegmentTriangle4( i_segment.start, i_segment.end, pPackets[packetIndex], t, u, v, w );
+				for ( uint32_t lane = 0; lane < 4; ++lane )
+				{
+					const uint32_t triangleIndex = packetIndex * 4 + lane;
+					const bool isPacketHit = ( hitMask & ( 1u << lane ) ) != 0;
+					++io_laneCount;
+					if ( triangleIndex >= i_leaf._triangleCount )
+					{
+						mismatchCount += isPacketHit ? 1 : 0;
+						continue;
+					}
+					const EAE_Engine::Mesh::TriangleIndex triangle = i_octree.GetTriangle( i_leaf, triangleIndex );
+					const EAE_Engine::Mesh::sVertex& vertex0 = i_vertices[triangle._index0];
+					const EAE_Engine::Mesh::sVertex& vertex1 = i_vertices[triangle._index1];
+					const EAE_Engine::Mesh::sVertex& vertex2 = i_vertices[triangle._index2];
+					float scalarU = 0.0f, scalarV = 0.0f, scalarW = 0.0f, scalarT = 0.0f;
+					const bool isScalarHit = EAE_Engine::Collision::IntersectSegmentTriangle( i_segment.start, i_segment.end,
+						EAE_Engine::Math::Vector3( vertex0.x, vertex0.y, vertex0.z ), EAE_Engine::Math::Vector3( vertex1.x, vertex1.y, vertex1.z ),
+						EAE_Engine::Math::Vector3( vertex2.x, vertex2.y, vertex2.z ), scalarU, scalarV, scalarW, scalarT ) != 0;
+					io_hitCount += isScalarHit ? 1 : 0;
+					mismatchCount += isPacketHit == isScalarHit && ( !isScalarHit || IsSameBits( t[lane], scalarT ) ) ? 0 : 1;
+				}
+			}
+			return true;
+		} );
+		return mismatchCount;
+	}
+
+	// The hits of the cache against the ones of the octree, in the same order, returns the count of the queries which differ.
+	uint32_t CompareQueries( const EAE_Engine::Core::CompleteOctree& i_octree, const EAE_Engine::Core::CollisionTriangleCache& i_cache,
+		const sSegment& i_segment )
+	{
+		uint32_t mismatchCount = 0;
+		const uint32_t hitLimits[] = { 1, 2, 4, s_maxHits };
+		for ( size_t limitIndex = 0; limitIndex < sizeof( hitLimits ) / sizeof( hitLimits[0] ); ++limitIndex )
+		{
+			EAE_Engine::Core::SegmentHit octreeHits[s_maxHits];
+			EAE_Engine::Core::SegmentHit cacheHits[s_maxHits];
+			const uint32_t octreeCount = i_octree.GetTrianlgesCollideWithSegment( i_segment.start, i_segment.end, octreeHits, hitLimits[limitIndex] );
+			const uint32_t cacheCount = i_cache.GetTrianlgesCollideWithSegment( i_segment.start, i_segment.end, cacheHits, hitLimits[limitIndex] );
+			bool isSame = octreeCount == cacheCount;
+			for ( uint32_t hitIndex = 0; isSame && hitIndex < cacheCount; ++hitIndex )
+				isSame = IsSameBits( octreeHits[hitIndex]._t, cacheHits[hitIndex]._t ) && octreeHits[hitIndex]._triangle == cacheHits[hitIndex]._triangle;
+			mismatchCount += isSame ? 0 : 1;
+		}
+		return mismatchCount;
+	}
+
+	// The triangles of the leaves crossed by the segments one by one from the sVertex of the mesh, like the octree,
+	// returns the count of the hits.
+	uint32_t TestLeavesScalar( EAE_Engine::Core::CompleteOctree& i_octree, const std::vector<EAE_Engine::Mesh::sVertex>& i_vertices,
+		const std::vector<sSegment>& i_segments )
+	{
+		uint32_t hitCount = 0;
+		for ( size_t segmentIndex = 0; segmentIndex < i_segments.size(); ++segmentIndex )
+		{
+			const sSegment& segment = i_segments[segmentIndex];
+			i_octree.VisitNodesAlongSegment( segment.start, segment.end, i_octree.Level() - 1, [&]( const EAE_Engine::Core::OctreeNode& i_leaf, float, float )
+			{
+				for ( uint32_t triangleIndex = 0; triangleIndex < i_leaf._triangleCount; ++triangleIndex )
+				{
+					const EAE_Engine::Mesh::TriangleIndex triangle = i_octree.GetTriangle( i_leaf, triangleIndex );
+					const EAE_Engine::Mesh::sVertex& vertex0 = i_vertices[triangle._index0];
+					const EAE_Engine::Mesh::sVertex& vertex1 = i_vertices[triangle._index1];
+					const EAE_Engine::Mesh::sVertex& vertex2 = i_vertices[triangle._index2];
+					float u = 0.0f, v = 0.0f, w = 0.0f, t = 0.0f;
+					hitCount += EAE_Engine::Collision::IntersectSegmentTriangle( segment.start, segment.end, EAE_Engine::Math::Vector3( vertex0.x, vertex0.y, vertex0.z ),
+						EAE_Engine::Math::Vector3( vertex1.x, vertex1.y, vertex1.z ), EAE_Engine::Math::Vector3( vertex2.x, vertex2.y, vertex2.z ), u, v, w, t ) ? 1 : 0;
+				}
+				return true;
+			} );
+		}
+		return hitCount;
+	}
+
+	// The same triangles from the packets of the cache, returns the count of the hits.
+	uint32_t TestLeavesPackets( EAE_Engine::Core::CompleteOctree& i_octree, const EAE_Engine::Core::CollisionTriangleCache& i_cache,
+		const std::vector<sSegment>& i_segments )
+	{
+		uint32_t hitCount = 0;
+		for ( size_t segmentIndex = 0; segmentIndex < i_segments.size(); ++segmentIndex )
+		{
+			const sSegment& segment = i_segments[segmentIndex];
+			i_octree.VisitNodesAlongSegment( segment.start, segment.end, i_octree.Level() - 1, [&]( const EAE_Engine::Core::OctreeNode& i_leaf, float, float )
+			{
+				uint32_t packetCount = 0;
+				const EAE_Engine::Collision::Triangle4* pPackets = i_cache.GetPackets( i_leaf, packetCount );
+				for ( uint32_t packetIndex = 0; packetIndex < packetCount; ++packetIndex )
+				{
+					float t[4], u[4], v[4], w[4];
+					uint32_t hitMask = EAE_Engine::Collision::IntersectSegmentTriangle4( segment.start, segment.end, pPackets[packetIndex], t, u, v, w );
+					for ( ; hitMask != 0; hitMask &= hitMask - 1 )
+						++hitCount;
+				}
+				return true;
+			} );
+		}
+		return hitCount;
+	}
+
+	template<typename Octree>
+	double TimeQueries( const Octree& i_octree, const std::vector<sSegment>& i_segments, uint32_t i_maxHits, uint32_t& io_hitCount )
+	{
+		EAE_Engine::Core::SegmentHit hits[s_maxHits];
+		std::chrono::high_resolution_clock::time_point timer = std::chrono::high_resolution_clock::now();
+		for ( size_t segmentIndex = 0; segmentIndex < i_segments.size(); ++segmentIndex )
+			io_hitCount += i_octree.GetTrianlgesCollideWithSegment( i_segments[segmentIndex].start, i_segments[segmentIndex].end, hits, i_maxHits );
+		return GetMilliseconds( timer ) * 1000.0 / i_segments.size();
+	}
+}
+
+// Interface
+//==========
+
+int EngineTests::RunTriangleCacheTests()
+{
+	const int failureCountBefore = GetFailureCount();
+	std::vector<EAE_Engine::Math::Vector3> positions;
+	std::vector<uint32_t> indices;
+	CreateMesh( positions, indices );
+	const uint32_t levels[] = { 3, 5 };
+
+	printf( "%-6s %-12s %-14s %-14s %-16s %-16s\n", "level", "packets KB", "leaves us", "packets us", "first hit us", "all hits us" );
+	for ( size_t levelIndex = 0; levelIndex < sizeof( levels ) / sizeof( levels[0] ); ++levelIndex )
+	{
+		const uint32_t level = levels[levelIndex];
+		char meshKey[32];
+		sprintf( meshKey, "TriangleCacheMesh%u", level );
+		EngineTests::CreateCollisionMesh( meshKey, positions, indices, level );
+		EAE_Engine::Core::CompleteOctree* pOctree = EAE_Engine::Core::OctreeManager::GetInstance()->GetOctree( meshKey );
+		const std::vector<EAE_Engine::Mesh::sVertex>& vertices = pOctree->GetCollisionMesh()->_vertices;
+		EAE_Engine::Core::CollisionTriangleCache cache;
+		cache.Build( pOctree );
+		ENGINE_TEST_CHECK( cache.GetOctree() == pOctree );
+		std::vector<sSegment> segments;
+		CreateSegments( pOctree->GetMin(), pOctree->GetMax(), 149 + level, segments );
+
+		uint32_t laneMismatchCount = 0;
+		uint32_t queryMismatchCount = 0;
+		uint32_t laneCount = 0;
+		uint32_t hitCount = 0;
+		for ( size_t segmentIndex = 0; segmentIndex < segments.size(); ++segmentIndex )
+		{
+			laneMismatchCount += CompareLanes( *pOctree, cache, vertices, segments[segmentIndex], laneCount, hitCount );
+			queryMismatchCount += CompareQueries( *pOctree, cache, segments[segmentIndex] );
+		}
+		ENGINE_TEST_CHECK( laneMismatchCount == 0 );
+		ENGINE_TEST_CHECK( queryMismatchCount == 0 );
+		ENGINE_TEST_CHECK( hitCount > s_segmentCount );
+		ENGINE_TEST_CHECK( laneCount > hitCount );
+
+		std::chrono::high_resolution_clock::time_point timer = std::chrono::high_resolution_clock::now();
+		const uint32_t scalarHitCount = TestLeavesScalar( *pOctree, vertices, segments );
+		const double scalarMicroseconds = GetMilliseconds( timer ) * 1000.0 / s_segmentCount;
+		timer = std::chrono::high_resolution_clock::now();
+		const uint32_t packetHitCount = TestLeavesPackets( *pOctree, cache, segments );
+		const double packetMicroseconds = GetMilliseconds( timer ) * 1000.0 / s_segmentCount;
+		ENGINE_TEST_CHECK( scalarHitCount == packetHitCount );
+		uint32_t octreeHitCounts[2] = { 0, 0 };
+		uint32_t cacheHitCounts[2] = { 0, 0 };
+		const double octreeFirstMicroseconds = TimeQueries( *pOctree, segments, 1, octreeHitCounts[0] );
+		const double cacheFirstMicroseconds = TimeQueries( cache, segments, 1, cacheHitCounts[0] );
+		const double octreeAllMicroseconds = TimeQueries( *pOctree, segments, s_maxHits, octreeHitCounts[1] );
+		const double cacheAllMicroseconds = TimeQueries( cache, segments, s_maxHits, cacheHitCounts[1] );
+		ENGINE_TEST_CHECK( octreeHitCounts[0] == cacheHitCounts[0] && octreeHitCounts[1] == cacheHitCounts[1] );
+
+		char firstText[32];
+		char allText[32];
+		sprintf( firstText, "%.2f / %.2f", octreeFirstMicroseconds, cacheFirstMicroseconds );
+		sprintf( allText, "%.2f / %.2f", octreeAllMicroseconds, cacheAllMicroseconds );
+		printf( "%-6u %-12.1f %-14.2f %-14.2f %-16s %-16s\n", level, cache.GetMemorySize() / 1024.0,
+			scalarMicroseconds, packetMicroseconds, firstText, allText );
+	}
+	printf( "the queries are octree / cache\n" );
+	EngineTests::CleanScene();
+	return GetFailureCount() - failureCountBefore;
+}
@@ -0,0 +1,131 @@
+/*
+	The bullets against the thin walls: a RigidBody in the Continuous mode must never pass a wall without touching it,
+	at any speed, with or without a radius, against the faces of the collision mesh and the thin OBBColliders.
+	The Discrete mode is printed next to it to show which cases tunnel without the continuous collision detection.
+*/
+
+// Header Files
+//=============
+
+#include "EngineTests.h"
+
+#include <cstdio>
+
+#include "Engine/CollisionDetection/ColliderBase.h"
+#include "Engine/CollisionDetection/MeshCollider.h"
+#include "Engine/CollisionDetection/OBBCollider.h"
+#include "Engine/CollisionDetection/RigidBody.h"
+#include "Engine/Time/Time.h"
+
+// Helper Definitions
+//===================
+
+namespace
+{
+	enum ePassedWhen
+	{
+		XBelow,
+		XAbove,
+		YBelow,
+		ZBelow,
+	};
+
+	struct sBullet
+	{
+		const char* name;
+		EAE_Engine::Math::Vector3 start;
+		EAE_Engine::Math::Vector3 velocity;
+		float radius;
+		bool useGravity;
+		// The bullet is behind the wall when its coordinate passes the plane.
+		ePassedWhen passedWhen;
+		float plane;
+		uint32_t stepCount;
+	};
+
+	bool IsBehind( const sBullet& i_bullet, const EAE_Engine::Math::Vector3& i_pos )
+	{
+		switch ( i_bullet.passedWhen )
+		{
+		case XBelow: return i_pos._x < i_bullet.plane;
+		case XAbove: return i_pos._x > i_bullet.plane;
+		case YBelow: return i_pos._y < i_bullet.plane;
+		case ZBelow: return i_pos._z < i_bullet.plane;
+		}
+		return false;
+	}
+
+	// Returns true when the bullet ends behind the wall with the velocity it would have without the wall.
+	bool Tunnels( const sBullet& i_bullet, EAE_Engine::Common::CollisionDetectionMode i_mode, float i_fixedTimeStep )
+	{
+		EngineTests::TestTransform transform( i_bullet.start );
+		EAE_Engine::Physics::RigidBodyManager rigidBodyManager;
+		EAE_Engine::Physics::RigidBody* pRigidBody = rigidBodyManager.AddRigidBody( &transform );
+		transform.AddComponent( { pRigidBody, pRigidBody->GetTypeID() } );
+		pRigidBody->SetPos( i_bullet.start );
+		pRigidBody->SetVelocity( i_bullet.velocity );
+		pRigidBody->SetRadius( i_bullet.radius );
+		pRigidBody->SetUseGravity( i_bullet.useGravity );
+		pRigidBody->SetCollisionDetectionMode( i_mode );
+		for ( uint32_t step = 0; step < i_bullet.stepCount; ++step )
+			rigidBodyManager.FixedUpdate();
+		EAE_Engine::Math::Vector3 freeVelocity = i_bullet.velocity;
+		if ( i_bullet.useGravity )
+			freeVelocity = freeVelocity + EAE_Engine::Physics::Physics::GetInstance()->GetGravity() * ( i_fixedTimeStep * i_bullet.stepCount );
+		const bool untouched = ( pRigidBody->GetVelocity() - freeVelocity ).Magnitude() < 1.0f;
+		return IsBehind( i_bullet, pRigidBody->GetPos() ) && untouched;
+	}
+}
+
+// Interface
+//==========
+
+int EngineTests::RunTunnelingTests()
+{
+	const int failureCountBefore = GetFailureCount();
+	// The collision mesh: the wall x = 0 facing +x, and the half wall x = 20 facing -x below y = 0.
+	std::vector<EAE_Engine::Math::Vector3> positions;
+	positions.push_back( EAE_Engine::Math::Vector3( 0.0f, -5.0f, -5.0f ) );
+	positions.push_back( EAE_Engine::Math::Vector3( 0.0f, 5.0f, -5.0f ) );
+	positions.push_back( EAE_Engine::Math::Vector3( 0.0f, 5.0f, 5.0f ) );
+	positions.push_back( EAE_Engine::Math::Vector3( 0.0f, -5.0f, 5.0f ) );
+	positions.push_back( EAE_Engine::Math::Vector3( 20.0f, -5.0f, -5.0f ) );
+	positions.push_back( EAE_Engine::Math::Vector3( 20.0f, 0.0f, -5.0f ) );
+	positions.push_back( EAE_Engine::Math::Vector3( 20.0f, 0.0f, 5.0f ) );
+	positions.push_back( EAE_Engine::Math::Vector3( 20.0f, -5.0f, 5.0f ) );
+	const uint32_t indices[] = { 0, 1, 2, 0, 2, 3, 4, 6, 5, 4, 7, 6 };
+	CreateCollisionMesh( "TunnelingWalls", positions, std::vector<uint32_t>( indices, indices + sizeof( indices ) / sizeof( indices[0] ) ), 3 );
+	TestTransform meshTransform;
+	EAE_Engine::Collider::MeshCollider* pMeshCollider = new EAE_Engine::Collider::MeshCollider( &meshTransform );
+	pMeshCollider->Init( "TunnelingWalls" );
+	EAE_Engine::Collider::ColliderManager::GetInstance()->AddToColliderList( pMeshCollider );
+	// The static box 5 cm thick around z = -20.
+	TestTransform boxTransform( EAE_Engine::Math::Vector3( 0.0f, 0.0f, -20.0f ) );
+	EAE_Engine::Collider::CreateOBBCollider( &boxTransform, EAE_Engine::Math::Vector3( 10.0f, 10.0f, 0.05f ) );
+
+	const sBullet bullets[] =
+	{
+		{ "front face, 600 m/s", EAE_Engine::Math::Vector3( 10.0f, 0.0f, 0.0f ), EAE_Engine::Math::Vector3( -600.0f, 0.0f, 0.0f ), 0.0f, false, XBelow, 0.0f, 6 },
+		{ "back face, 600 m/s", EAE_Engine::Math::Vector3( -10.0f, 2.0f, 0.0f ), EAE_Engine::Math::Vector3( 600.0f, 0.0f, 0.0f ), 0.0f, false, XAbove, 0.0f, 6 },
+		{ "back face, 60 m/s", EAE_Engine::Math::Vector3( -3.0f, 0.0f, 0.0f ), EAE_Engine::Math::Vector3( 60.0f, 0.0f, 0.0f ), 0.0f, false, XAbove, 0.0f, 6 },
+		{ "front face, 5 m/s", EAE_Engine::Math::Vector3( 0.05f, 0.0f, 0.0f ), EAE_Engine::Math::Vector3( -5.0f, 0.0f, 0.0f ), 0.0f, false, XBelow, 0.0f, 6 },
+		{ "oblique, 850 m/s", EAE_Engine::Math::Vector3( -10.0f, -3.0f, -2.0f ), EAE_Engine::Math::Vector3( 800.0f, 200.0f, 100.0f ), 0.0f, false, XAbove, 0.0f, 6 },
+		{ "sphere 0.5 at the edge", EAE_Engine::Math::Vector3( 10.0f, 5.3f, 0.0f ), EAE_Engine::Math::Vector3( -600.0f, 0.0f, 0.0f ), 0.5f, false, XBelow, 0.0f, 6 },
+		{ "sphere 0.5 on the face", EAE_Engine::Math::Vector3( 10.0f, 1.0f, 1.0f ), EAE_Engine::Math::Vector3( -600.0f, 0.0f, 0.0f ), 0.5f, false, XBelow, 0.5f, 6 },
+		{ "thin box, 300 m/s", EAE_Engine::Math::Vector3( 0.0f, 0.0f, -10.0f ), EAE_Engine::Math::Vector3( 0.0f, 0.0f, -300.0f ), 0.0f, false, ZBelow, -20.0f, 6 },
+		{ "thin box, sphere 0.2, 1000 m/s", EAE_Engine::Math::Vector3( 2.0f, 2.0f, -5.0f ), EAE_Engine::Math::Vector3( 0.0f, 0.0f, -1000.0f ), 0.2f, false, ZBelow, -20.0f, 6 },
+		{ "falling on the thin box", EAE_Engine::Math::Vector3( 3.0f, 40.0f, -20.0f ), EAE_Engine::Math::Vector3( 0.0f, -150.0f, 0.0f ), 0.0f, true, YBelow, -5.1f, 30 },
+	};
+	const float fixedTimeStep = EAE_Engine::Time::GetFixedTimeStep();
+	printf( "%-32s %-10s %-10s\n", "bullet", "Discrete", "Continuous" );
+	for ( size_t bulletIndex = 0; bulletIndex < sizeof( bullets ) / sizeof( bullets[0] ); ++bulletIndex )
+	{
+		const sBullet& bullet = bullets[bulletIndex];
+		const bool discreteTunnels = Tunnels( bullet, EAE_Engine::Common::CollisionDetectionMode::Discrete, fixedTimeStep );
+		const bool continuousTunnels = Tunnels( bullet, EAE_Engine::Common::CollisionDetectionMode::Continuous, fixedTimeStep );
+		printf( "%-32s %-10s %-10s\n", bullet.name, discreteTunnels ? "tunnels" : "stops", continuousTunnels ? "tunnels" : "stops" );
+		ENGINE_TEST_CHECK( !continuousTunnels );
+	}
+	CleanScene();
+	return GetFailureCount() - failureCountBefore;
+}
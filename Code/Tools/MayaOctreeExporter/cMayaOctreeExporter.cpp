@@ -4,6 +4,7 @@
 #include "cMayaOctreeExporter.h"
 
 #include <algorithm>
+#include <cfloat>
 #include <climits>
 #include <cstdint>
 #include <fstream>
@@ -26,8 +27,8 @@
 #include <string>
 #include <vector>
 
-#include "Engine/SpatialPartition/Octree.h"
-#include "Engine/CollisionDetection/CollisionDetectionFunctions.h"
+#include "Engine/SpatialPartition/OctreeLeafBuilder.h"
+#include "Engine/SpatialPartition/OctreeFile.h"
 
 // Vertex Definition
 //==================
@@ -742,89 +743,32 @@ namespace
 				// Init Z
 				if (vertex.z < minPos._z)
 					minPos._z = vertex.z;
-				if (vertex.x > maxPos._z)
+				if (vertex.z > maxPos._z)
 					maxPos._z = vertex.z;
 			}
-			// Open table
-			EAE_Engine::Core::CompleteOctree completeOctree;
-			completeOctree.InitFromRange(4, minPos, maxPos);
-			// Set triangle values for Octree
-			uint32_t leafLevelIndex = completeOctree.Level() - 1;
-			uint32_t coutOfLeaves = completeOctree.GetCountOfNodesInLevel(leafLevelIndex);
-			EAE_Engine::Core::OctreeNode* pLeaveNodes = completeOctree.GetNodesInLevel(leafLevelIndex);
-			uint32_t countOfTrianglesAdded = 0;
-			for (uint32_t leafIndex = 0; leafIndex < coutOfLeaves; ++leafIndex)
+			// Set triangle values for Octree, each subtree only tests the triangles which overlap its root, see OctreeLeafBuilder.h.
+			const uint32_t level = 4;
+			std::vector<EAE_Engine::Math::Vector3> positions;
+			positions.reserve(i_vertexBuffer.size());
+			for (std::vector<sVertex_maya>::const_iterator it = i_vertexBuffer.begin(); it != i_vertexBuffer.end(); ++it)
 			{
-				for (size_t index = 0; index < i_indexBuffer.size(); index += 3)
-				{
-					// get the 3 indices of the trianlge
-					uint32_t index0 = (uint32_t)i_indexBuffer[index + 0];
-					uint32_t index1 = (uint32_t)i_indexBuffer[index + 1];
-					uint32_t index2 = (uint32_t)i_indexBuffer[index + 2];
-					EAE_Engine::Mesh::TriangleIndex triangle = { index0, index1, index2 };
-					// get the 3 vertices of the trianlge
-					sVertex_maya vertex_maya0 = i_vertexBuffer[index0];
-					EAE_Engine::Math::Vector3 vertex0(vertex_maya0.x, vertex_maya0.y, vertex_maya0.z);
-					sVertex_maya vertex_maya1 = i_vertexBuffer[index1];
-					EAE_Engine::Math::Vector3 vertex1(vertex_maya1.x, vertex_maya1.y, vertex_maya1.z);
-					sVertex_maya vertex_maya2 = i_vertexBuffer[index2];
-					EAE_Engine::Math::Vector3 vertex2(vertex_maya2.x, vertex_maya2.y, vertex_maya2.z);
-					// create the AABB for this leaf
-					EAE_Engine::Math::AABBV1 aabb;
-					aabb._min = pLeaveNodes[leafIndex].GetMin();
-					aabb._max = pLeaveNodes[leafIndex].GetMax();
-					// do the test
-					bool contains = EAE_Engine::Collision::TestTriangleAABB(vertex0, vertex1, vertex2, aabb);
-					if(contains)
-					{
-						pLeaveNodes[leafIndex]._triangles.push_back(triangle);
-						++countOfTrianglesAdded;
-					}
-				}
+				positions.push_back(EAE_Engine::Math::Vector3(it->x, it->y, it->z));
 			}
-			// Write Octree information to files
-			uint32_t nodesCount = completeOctree.GetNodeCount();
-			// information we need are _Level, _NodeCount, _min, _max, triangles we added to each leaf.
-			uint32_t sizeOfBuffer = sizeof(uint32_t) + sizeof(uint32_t) + sizeof(EAE_Engine::Math::Vector3) + sizeof(EAE_Engine::Math::Vector3) + 
-				+countOfTrianglesAdded * sizeof(uint32_t) + countOfTrianglesAdded * sizeof(EAE_Engine::Mesh::TriangleIndex) + 1;
-			EAE_Engine::Math::Vector3 min = completeOctree.GetMin();
-			EAE_Engine::Math::Vector3 max = completeOctree.GetMax();
-			EAE_Engine::Core::OctreeNode* pNodes = completeOctree.GetNodes();
-			char* pBuffer = new char[sizeOfBuffer];
-			EAE_Engine::SetMem((uint8_t*)pBuffer, sizeOfBuffer, 0);
+			std::vector<EAE_Engine::Mesh::TriangleIndex> triangles;
+			triangles.reserve(i_indexBuffer.size() / 3);
+			for (size_t index = 0; index < i_indexBuffer.size(); index += 3)
 			{
-				uint32_t offset = 0;
-				uint32_t level = completeOctree.Level();
-				EAE_Engine::CopyMem((uint8_t*)&level, (uint8_t*)(pBuffer)+offset, sizeof(uint32_t));
-				offset += sizeof(uint32_t);
-				EAE_Engine::CopyMem((uint8_t*)&nodesCount, (uint8_t*)(pBuffer)+offset, sizeof(uint32_t));
-				offset += sizeof(uint32_t);
-				EAE_Engine::CopyMem((uint8_t*)&min, (uint8_t*)(pBuffer) + offset, sizeof(EAE_Engine::Math::Vector3));
-				offset += sizeof(EAE_Engine::Math::Vector3);
-				EAE_Engine::CopyMem((uint8_t*)&max, (uint8_t*)(pBuffer)+offset, sizeof(EAE_Engine::Math::Vector3));
-				offset += sizeof(EAE_Engine::Math::Vector3);
-				// Now let's fill in the trianlges information
-				EAE_Engine::Core::OctreeNode* pLeaves = completeOctree.GetNodesInLevel(leafLevelIndex);
-				uint32_t countOfLeaves = completeOctree.GetCountOfNodesInLevel(leafLevelIndex);
-				for (uint32_t leafIndex = 0; leafIndex < countOfLeaves; ++leafIndex)
-				{
-					// record count of trianlges in this node
-					uint32_t countOfTrianlges = (uint32_t)pLeaves[leafIndex]._triangles.size();
-					EAE_Engine::CopyMem((uint8_t*)&countOfTrianlges, (uint8_t*)pBuffer+offset, sizeof(uint32_t));
-					offset += sizeof(uint32_t);
-					if (countOfTrianlges > 0)
-					{
-						// record trianlges in this node
-						uint32_t bufferSizeForTrianlge = sizeof(EAE_Engine::Mesh::TriangleIndex) * countOfTrianlges;
-						EAE_Engine::CopyMem((uint8_t*)&(pLeaves[leafIndex]._triangles[0]), (uint8_t*)pBuffer + offset, bufferSizeForTrianlge);
-						offset += bufferSizeForTrianlge;
-					}
-				}
+				EAE_Engine::Mesh::TriangleIndex triangle = { (uint32_t)i_indexBuffer[index + 0], (uint32_t)i_indexBuffer[index + 1], (uint32_t)i_indexBuffer[index + 2] };
+				triangles.push_back(triangle);
 			}
-			fout.write(pBuffer, sizeOfBuffer);
+			std::vector<std::vector<EAE_Engine::Mesh::TriangleIndex> > leafTriangles;
+			EAE_Engine::Core::BuildLeafTriangles(level, minPos, maxPos, positions, triangles, 0, leafTriangles);
+			// Write Octree information to files in the compact format, see OctreeFile.h.
+			std::vector<uint8_t> buffer;
+			EAE_Engine::Core::WriteCompactOctree(level, minPos, maxPos, leafTriangles, buffer);
+			fout.write(reinterpret_cast<const char*>(&buffer[0]), buffer.size());
 			// Close table
 			fout.close();
-			SAFE_DELETE_ARRAY(pBuffer);
 			return MStatus::kSuccess;
 		}
 		else
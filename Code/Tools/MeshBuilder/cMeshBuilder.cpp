@@ -2,9 +2,12 @@
 //=============
 
 #include "cMeshBuilder.h"
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 #include <cstdint>
+#include "Engine/Mesh/MeshLoader.h"
+#include "Engine/SpatialPartition/BVH.h"
 #include "Engine/Windows/WindowsFunctions.h"
 #include "LoadLua/LuaMeshLoader.h"
 // Interface
@@ -13,8 +16,11 @@
 // Build
 //------
 
-bool EAE_Engine::Tools::cMeshBuilder::Build( const std::vector<std::string>& )
+bool EAE_Engine::Tools::cMeshBuilder::Build( const std::vector<std::string>& i_arguments )
 {
+	// With the "bvh" argument the target is the BVH of the mesh for Physics, instead of the mesh itself.
+	if (std::find(i_arguments.begin(), i_arguments.end(), "bvh") != i_arguments.end())
+		return BuildBVH();
 	/*
 	open may failed on Linux has about 30 conditions, some of them are:
 	If the file exists and you don't have permission to write it.
@@ -70,3 +76,30 @@ bool EAE_Engine::Tools::cMeshBuilder::Build( const std::vector<std::string>& )
 	
 	return !wereThereErrors;
 }
+
+bool EAE_Engine::Tools::cMeshBuilder::BuildBVH()
+{
+	char* pBuffer = nullptr;
+	uint32_t sizeOfBuffer = 0;
+	if (!GenerateBinaryMeshData(_path_source, pBuffer, sizeOfBuffer))
+	{
+		std::stringstream decoratedErrorMessage;
+		decoratedErrorMessage << "Failed to build mesh from\"" << _path_source << "\" for the BVH";
+		OutputErrorMessage(decoratedErrorMessage.str().c_str(), __FILE__);
+		return false;
+	}
+	// The triangles in the same winding order as the mesh loaded by the game, so BVH::InitFromFile accepts the indices.
+	Mesh::AOSMeshData* pMeshData = Mesh::CreateAOSMeshData(reinterpret_cast<const uint8_t*>(pBuffer));
+	delete[] pBuffer;
+	Core::BVH bvh;
+	bvh.Build(pMeshData);
+	const bool saved = bvh.SaveToFile(_path_target);
+	delete pMeshData;
+	if (!saved)
+	{
+		std::stringstream decoratedErrorMessage;
+		decoratedErrorMessage << "Failed to output BVH to: " << _path_target;
+		OutputErrorMessage(decoratedErrorMessage.str().c_str(), __FILE__);
+	}
+	return saved;
+}
@@ -24,6 +24,11 @@ namespace EAE_Engine
 			//------
 
 			virtual bool Build(const std::vector<std::string>& i_arguments);
+
+		private:
+
+			// Build the BVH of the collision mesh, which Physics loads instead of building it at the start.
+			bool BuildBVH();
 		};
 	}
 }
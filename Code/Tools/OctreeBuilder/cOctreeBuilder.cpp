@@ -0,0 +1,57 @@
+// Header Files
+//=============
+
+#include "cOctreeBuilder.h"
+
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include "Engine/SpatialPartition/OctreeFile.h"
+
+// Interface
+//==========
+
+// Build
+//------
+
+bool EAE_Engine::Tools::cOctreeBuilder::Build( const std::vector<std::string>& )
+{
+	// Read the source
+	std::vector<uint8_t> source;
+	{
+		std::ifstream fin( _path_source, std::ifstream::binary );
+		if ( !fin.is_open() )
+		{
+			std::stringstream decoratedErrorMessage;
+			decoratedErrorMessage << "Couldn't open \"" << _path_source << "\" for reading";
+			OutputErrorMessage( decoratedErrorMessage.str().c_str(), __FILE__ );
+			return false;
+		}
+		fin.seekg( 0, fin.end );
+		std::streamoff size = fin.tellg();
+		fin.seekg( 0 );
+		source.resize( size > 0 ? (size_t)size : 0 );
+		if ( !source.empty() )
+			fin.read( reinterpret_cast<char*>( &source[0] ), size );
+	}
+	// Convert it
+	std::vector<uint8_t> target;
+	if ( !EAE_Engine::Core::ConvertToCompactOctree( source.empty() ? nullptr : &source[0], source.size(), target ) )
+	{
+		std::stringstream decoratedErrorMessage;
+		decoratedErrorMessage << "\"" << _path_source << "\" isn't a valid octree file";
+		OutputErrorMessage( decoratedErrorMessage.str().c_str(), __FILE__ );
+		return false;
+	}
+	// Write the target
+	std::ofstream fout( _path_target, std::ofstream::binary );
+	if ( !fout.is_open() )
+	{
+		std::stringstream decoratedErrorMessage;
+		decoratedErrorMessage << "Couldn't open \"" << _path_target << "\" for writing";
+		OutputErrorMessage( decoratedErrorMessage.str().c_str(), __FILE__ );
+		return false;
+	}
+	fout.write( reinterpret_cast<const char*>( &target[0] ), target.size() );
+	return fout.good();
+}
@@ -0,0 +1,37 @@
+/*
+	This builder converts an .octree file to the compact format of Engine/SpatialPartition/OctreeFile.h,
+	so the game can use it in place without converting it when it is loaded.
+	A file which is already in the compact format is copied as it is.
+*/
+
+#ifndef EAE_ENGINE_COCTREEBUILDER_H
+#define EAE_ENGINE_COCTREEBUILDER_H
+
+// Header Files
+//=============
+
+#include "../BuilderHelper/cbBuilder.h"
+
+// Class Declaration
+//==================
+
+namespace EAE_Engine
+{
+	namespace Tools 
+	{
+		class cOctreeBuilder : public cbBuilder
+		{
+			// Interface
+			//==========
+
+		public:
+
+			// Build
+			//------
+
+			virtual bool Build(const std::vector<std::string>& i_arguments);
+		};
+	}
+}
+
+#endif	// EAE_ENGINE_COCTREEBUILDER_H
@@ -0,0 +1,141 @@
+/*
+	The main() function is where the program starts execution
+
+	OctreeCompiler builds the compact .octree file of a binary mesh file without Maya:
+		OctreeCompiler <mesh file> <octree file> [level = 4] [thread count = 0, all of the hardware threads]
+	It only needs the Math, Mesh and SpatialPartition sources, so it also builds on Linux, from Code/:
+		g++ -O2 -std=c++14 -pthread -I. -IEngine -DNDEBUG Tools/OctreeCompiler/EntryPoint.cpp
+			Engine/SpatialPartition/OctreeLeafBuilder.cpp Engine/SpatialPartition/OctreeFile.cpp -o OctreeCompiler
+*/
+
+// Header Files
+//=============
+
+#include <chrono>
+#include <cfloat>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <vector>
+
+// Both of the platforms have the position in the first 12 bytes of the 36 bytes of sVertex.
+#if !defined( EAEENGINE_PLATFORM_D3D9 ) && !defined( EAEENGINE_PLATFORM_GL )
+	#define EAEENGINE_PLATFORM_GL
+#endif
+#include "Engine/SpatialPartition/OctreeLeafBuilder.h"
+#include "Engine/SpatialPartition/OctreeFile.h"
+
+// Helper Function Definitions
+//============================
+
+namespace
+{
+	// Read the positions and the triangles of the binary mesh file, the layout is the one of LoadMeshData.
+	// The triangles keep the order of the indices in the file.
+	bool ReadMeshFile( const char* i_path, std::vector<EAE_Engine::Math::Vector3>& o_positions,
+		std::vector<EAE_Engine::Mesh::TriangleIndex>& o_triangles )
+	{
+		std::ifstream fin( i_path, std::ifstream::binary );
+		if ( !fin.is_open() )
+		{
+			fprintf( stderr, "Couldn't open \"%s\" for reading\n", i_path );
+			return false;
+		}
+		uint32_t vertexElementCount = 0;
+		fin.read( reinterpret_cast<char*>( &vertexElementCount ), sizeof( uint32_t ) );
+		fin.seekg( sizeof( EAE_Engine::Mesh::VertexElement ) * vertexElementCount, fin.cur );
+		uint32_t vertexCount = 0, indexCount = 0, subMeshCount = 0;
+		fin.read( reinterpret_cast<char*>( &vertexCount ), sizeof( uint32_t ) );
+		fin.read( reinterpret_cast<char*>( &indexCount ), sizeof( uint32_t ) );
+		fin.read( reinterpret_cast<char*>( &subMeshCount ), sizeof( uint32_t ) );
+		if ( !fin || indexCount % 3 != 0 )
+		{
+			fprintf( stderr, "\"%s\" isn't a valid mesh file\n", i_path );
+			return false;
+		}
+		std::vector<EAE_Engine::Mesh::sVertex> vertices( vertexCount );
+		std::vector<uint32_t> indices( indexCount );
+		if ( vertexCount > 0 )
+			fin.read( reinterpret_cast<char*>( &vertices[0] ), sizeof( EAE_Engine::Mesh::sVertex ) * vertexCount );
+		if ( indexCount > 0 )
+			fin.read( reinterpret_cast<char*>( &indices[0] ), sizeof( uint32_t ) * indexCount );
+		if ( !fin )
+		{
+			fprintf( stderr, "\"%s\" isn't a valid mesh file\n", i_path );
+			return false;
+		}
+		o_positions.resize( vertexCount );
+		for ( uint32_t vertexIndex = 0; vertexIndex < vertexCount; ++vertexIndex )
+		{
+			const EAE_Engine::Mesh::sVertex& vertex = vertices[vertexIndex];
+			o_positions[vertexIndex] = EAE_Engine::Math::Vector3( vertex.x, vertex.y, vertex.z );
+		}
+		o_triangles.resize( indexCount / 3 );
+		for ( uint32_t triangleIndex = 0; triangleIndex < indexCount / 3; ++triangleIndex )
+		{
+			EAE_Engine::Mesh::TriangleIndex& triangle = o_triangles[triangleIndex];
+			triangle._index0 = indices[triangleIndex * 3 + 0];
+			triangle._index1 = indices[triangleIndex * 3 + 1];
+			triangle._index2 = indices[triangleIndex * 3 + 2];
+			if ( triangle._index0 >= vertexCount || triangle._index1 >= vertexCount || triangle._index2 >= vertexCount )
+			{
+				fprintf( stderr, "\"%s\" has an index out of the vertices\n", i_path );
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+// Entry Point
+//============
+
+int main( int i_argumentCount, char** i_arguments )
+{
+	if ( i_argumentCount < 3 )
+	{
+		fprintf( stderr, "Usage: %s <mesh file> <octree file> [level = 4] [thread count = 0]\n", i_arguments[0] );
+		return EXIT_FAILURE;
+	}
+	const uint32_t level = i_argumentCount > 3 ? (uint32_t)atoi( i_arguments[3] ) : 4;
+	const uint32_t threadCount = i_argumentCount > 4 ? (uint32_t)atoi( i_arguments[4] ) : 0;
+	if ( level < 1 || level > 8 )
+	{
+		fprintf( stderr, "The level must be from 1 to 8\n" );
+		return EXIT_FAILURE;
+	}
+	std::vector<EAE_Engine::Math::Vector3> positions;
+	std::vector<EAE_Engine::Mesh::TriangleIndex> triangles;
+	if ( !ReadMeshFile( i_arguments[1], positions, triangles ) )
+		return EXIT_FAILURE;
+	// The same bounds as the Maya exporter.
+	EAE_Engine::Math::Vector3 minPos( FLT_MAX, FLT_MAX, FLT_MAX );
+	EAE_Engine::Math::Vector3 maxPos( -FLT_MAX, -FLT_MAX, -FLT_MAX );
+	for ( std::vector<EAE_Engine::Math::Vector3>::const_iterator it = positions.begin(); it != positions.end(); ++it )
+	{
+		if ( it->_x < minPos._x ) minPos._x = it->_x;
+		if ( it->_x > maxPos._x ) maxPos._x = it->_x;
+		if ( it->_y < minPos._y ) minPos._y = it->_y;
+		if ( it->_y > maxPos._y ) maxPos._y = it->_y;
+		if ( it->_z < minPos._z ) minPos._z = it->_z;
+		if ( it->_z > maxPos._z ) maxPos._z = it->_z;
+	}
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	std::vector<std::vector<EAE_Engine::Mesh::TriangleIndex> > leafTriangles;
+	EAE_Engine::Core::BuildLeafTriangles( level, minPos, maxPos, positions, triangles, threadCount, leafTriangles );
+	std::vector<uint8_t> buffer;
+	EAE_Engine::Core::WriteCompactOctree( level, minPos, maxPos, leafTriangles, buffer );
+	double milliseconds = std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - start ).count();
+	std::ofstream fout( i_arguments[2], std::ofstream::binary );
+	if ( !fout.is_open() )
+	{
+		fprintf( stderr, "Couldn't open \"%s\" for writing\n", i_arguments[2] );
+		return EXIT_FAILURE;
+	}
+	fout.write( reinterpret_cast<const char*>( &buffer[0] ), buffer.size() );
+	if ( !fout.good() )
+		return EXIT_FAILURE;
+	printf( "%u triangles, level %u, %u bytes in %.2f ms\n", (uint32_t)triangles.size(), level, (uint32_t)buffer.size(), milliseconds );
+	return EXIT_SUCCESS;
+}
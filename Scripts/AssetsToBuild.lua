@@ -28,6 +28,11 @@ return
 				source = "CollisionData.aosmeshtext",
 				target = "collisionData.aosmesh",
 			},
+			{
+				source = "CollisionData.aosmeshtext",
+				target = "collisionData.bvh",
+				extraInfo = { optionalArguments = {"bvh"}, },
+			},
             {
 				source = "Flag.aosmeshtext",
 				target = "flag.aosmesh",
@@ -219,7 +224,7 @@ return
 		 },
 	},
 	{
-         buildTool = "GenericBuilder.exe",
+         buildTool = "OctreeBuilder.exe",
 		 relativePath = "Scene/",		 
          assets =
          {